@@ -97,7 +97,6 @@ static void show_options (AVSElement *element)
 {
         return;
         VisParamEntry *param;
-        VisHashmapChainEntry *mentry;
         VisCollectionIter *iter;
 
         if (element == NULL)
@@ -109,8 +108,7 @@ static void show_options (AVSElement *element)
 
         while (visual_collection_iter_has_more (iter)) {
             printf("Bleh\n");
-                mentry = visual_collection_iter_get_data (iter);
-                param = mentry->data;
+                param = visual_collection_iter_get_data (iter);
 
                 switch (param->type) {
                         case VISUAL_PARAM_ENTRY_TYPE_NULL:
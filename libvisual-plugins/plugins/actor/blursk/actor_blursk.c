@@ -199,14 +199,13 @@ static int act_blursk_init (VisPluginData *plugin) {
 
     priv->pcmbuf = visual_buffer_new_allocate (512 * sizeof (float), visual_buffer_destroyer_free);
 
-    config_default(&config);
+    config_default(&priv->config);
 
     __blursk_init(priv);
     return 0;
 }
 
 static int act_blursk_cleanup (VisPluginData *plugin) {
-    return 0;
     BlurskPrivate *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
 
     __blursk_cleanup (priv);
@@ -255,10 +254,8 @@ static int act_blursk_dimension (VisPluginData *plugin, VisVideo *video, int wid
         priv->width = width;
         priv->height = height;
 
-        video->pitch = width;
-
-        config.height = height;
-        config.width = width;
+        priv->config.height = height;
+        priv->config.width = width;
 
         return 0;
 }
@@ -295,7 +292,7 @@ static int act_blursk_events (VisPluginData *plugin, VisEventQueue *events) {
             case VISUAL_EVENT_NEWSONG:
                 newsong = ev.event.newsong.songinfo;
                 /* pass along the song info to blursk's core */
-                blursk_event_newsong(newsong);
+                blursk_event_newsong(priv, newsong);
                 break;
             default:
                 break;
@@ -312,7 +309,7 @@ static int act_blursk_events (VisPluginData *plugin, VisEventQueue *events) {
 
     /* resize plugin */
     if(size_update)
-        img_resize(priv, config.width, config.height);
+        img_resize(priv, priv->config.width, priv->config.height);
 
 
     return 0;
@@ -327,6 +324,8 @@ static VisPalette *act_blursk_palette (VisPluginData *plugin) {
 static int act_blursk_render (VisPluginData *plugin, VisVideo *video, VisAudio *audio) {
         int16_t tpcm[512];
         float *pcm;
+        uint8_t *dst, *src;
+        int width, height, y;
 
         BlurskPrivate *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
 
@@ -347,7 +346,18 @@ static int act_blursk_render (VisPluginData *plugin, VisVideo *video, VisAudio *
 
         __blursk_render_pcm (priv, tpcm);
 
-        visual_mem_copy (visual_video_get_pixels (video), priv->rgb_buf, visual_video_get_size (video));
+        /* The video can be wider than the image lines, copy line by line */
+        dst = visual_video_get_pixels (video);
+        src = priv->rgb_buf;
+        width = priv->rgb_width < video->width ? priv->rgb_width : video->width;
+        height = priv->rgb_height < video->height ? priv->rgb_height : video->height;
+
+        for (y = 0; y < height; y++) {
+                visual_mem_copy (dst, src, width);
+
+                dst += video->pitch;
+                src += priv->rgb_bpl;
+        }
 
 
     return 0;
@@ -19,25 +19,275 @@
  * along with Blurks-libvisual.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef ACTOR_BLURSK_H_
+#ifndef ACTOR_BLURSK_H
 #define ACTOR_BLURSK_H
 
 #include <libvisual/libvisual.h>
 
-typedef struct {
+#include <time.h>
+
+/* To detect rhythms, blursk tracks the loudness of the signal across multiple
+ * frames.  This is the maximum number of frames, and should correspond to the
+ * slowest rhythm.
+ */
+#define BEAT_MAX    200
+
+/* This is the maximum number of floaters on the screen */
+#define MAXFLOATERS 10
+
+/* These store random numbers that are held constant for all pixels in a
+ * given blur style.  Each blur function can use up to MAXRANDOM random
+ * numbers when generating pixel motion vectors.
+ */
+#define MAXRANDOM   64
+
+/* Some of the plotting functions interpolate to generate extra data points.
+ * The data points are stored here when that happens.
+ */
+#define MAXPOINTS   512
+
+typedef struct _BlurskPrivate BlurskPrivate;
+
+typedef struct
+{
+    /* dimensions */
+    int width;
+    int height;
+
+    /* color options */
+    uint32_t color;
+    char    *color_style;
+    char    *fade_speed;
+    char    *signal_color;
+    int32_t contour_lines;
+    int32_t hue_on_beats;
+    char    *background;
+
+    /* blur/fade options */
+    char    *blur_style;
+    char    *transition_speed;
+    char    *blur_when;
+    char    *blur_stencil;
+    int32_t slow_motion;
+
+    /* other effects */
+    char    *signal_style;
+    char    *plot_style;
+    int32_t thick_on_beats;
+    char    *flash_style;
+    char    *overall_effect;
+    char    *floaters;
+
+    /* miscellany from the Advanced screen */
+    char    *cpu_speed;
+    char    *show_info;
+    int     info_timeout;
+    int     show_timestamp;
+
+    /* beat detector */
+    int32_t beat_sensitivity;
+
+    /* config-string */
+    char *config_string;
+} BlurskConfig;
+
+/* image information, see img.c */
+typedef struct
+{
+    uint8_t      *buf;          /* base of the current image buffer */
+    uint8_t      *tmp;          /* base of another image buffer, for temp operations */
+    uint8_t     **source;       /* an array of pixel pointers, for blur motion */
+    unsigned int  height;       /* height of the current image */
+    unsigned int  width;        /* width of the current image */
+    unsigned int  bpl;          /* bytes per line of the current image */
+    unsigned int  chunks;       /* number of 8-pixel chunks in the image */
+
+    unsigned int  physheight;   /* height of the current window */
+    unsigned int  physwidth;    /* width of the current window */
+    uint8_t       rippleshift;  /* ripple map cycling counter */
+    uint8_t       travelshift;  /* colormap shift of the "Anti-fade effect" */
+
+    /* These are the base addresses of allocated memory, so we can free the old
+     * images when we resize to a new image.
+     */
+    uint8_t      *base_buf;
+    uint8_t      *base_tmp;
+    uint8_t     **base_source;
+
+    /* This stores the state of the "cpu_speed" option when bufs were allocated */
+    char          speed;
+} BlurskImage;
+
+/* beat detector, see detect_beat() in blursk.c */
+typedef struct
+{
+    int32_t history[BEAT_MAX];
+    int     base;
+    int     quiet;      /* force "quiet" situation? */
+    int32_t aged;       /* smoothed out loudness */
+    int32_t lowest;     /* quietest point in current beat */
+    int     elapsed;    /* frames since last beat */
+    int     isquiet;    /* was previous frame quiet */
+    int     prevbeat;   /* period of previous beat */
+} BlurskBeat;
+
+/* floaters, see drawfloaters() in blursk.c */
+typedef struct
+{
+    int x, y, age;
+    uint8_t color;
+} BlurskFloater;
+
+typedef struct
+{
+    int nprev;
+    BlurskFloater floater[MAXFLOATERS];
+    int oddeven;
+} BlurskFloaters;
+
+/* song info text, see show_info() in blursk.c */
+typedef struct
+{
+    int     prevpos;
+    char    buf[1000];
+    time_t  start, then;
+    int     persistent;
+} BlurskInfo;
+
+/* blur motion, see blur.c */
+typedef struct
+{
+    int  randval[MAXRANDOM];
+
+    /* These store the source offsets for the blurloop function. */
+    int  width, height;
+    int  xcenter, ycenter;
+    int  last;
+
+    /* These are used to compute the transition from one blur style to another */
+    char stylename[50];
+    char stencilname[50];
+    char blurname[50];
+    int  isspectrum;    /* boolean: is current signal_style a spectrum? */
+    char blurchar;      /* first letter of blurname, or random */
+    int  (*stylefunc)(BlurskPrivate *priv, int offset);
+    int  styletransition;
+    int  stylekeeprandom;
+    int  stylelower, styleprevlower;
+
+    /* This is used to help hide anomalies from some of the blur styles */
+    int  salt;
+
+    /* the id of the current stencil bitmap, or -1 for no bitmap */
+    int  stencil;
+    int  intostencil;   /* boolean: may motion pull from within the stencil? */
+    int  edgesmooth;    /* boolean: prefer smooth edges over smooth areas? */
+
+    int  wobble, wobbledir;     /* twist of the "Wobble back" style */
+    int  phase, phase2;         /* cycle of the "Reduced blur" loops */
+    int  odd;                   /* alternate blurring, for smooth areas */
+} BlurskBlur;
+
+/* colormap, see color.c */
+typedef struct
+{
+    /* This is where Blursk stores its version of the colors */
+    uint32_t colors[256];
+
+    int32_t (*stylefunc)(BlurskPrivate *priv, int32_t i);
+
+    /* These are the R/G/B components of the base color */
+    int32_t red, green, blue;
+
+    /* This is a random color, which is used for the "Colored background" setting */
+    int32_t tored, togreen, toblue;
+    int     tonew;
+    int32_t fromred, fromgreen, fromblue;
+    int32_t bgred, bggreen, bgblue;
+    char    bgletter;   /* first letter of chosen bkgnd, after "Random" */
+
+    int32_t fallr, fallg, fallb;
+
+    /* lowest cell of the current color style transition */
+    int     transitionbound;
+} BlurskColor;
+
+/* signal plotting, see render.c */
+typedef struct
+{
+    int16_t renderdata[MAXPOINTS];
+
+    int     plotfirst;
+    int     plotthick;
+    unsigned char plotcolor;
+    double  plottheta;
+    double  plotsin, plotcos;
+    double  plotprevsin, plotprevcos;
+    int     plotcount;
+    int     plotmax;
+    int     plotx[MAXPOINTS], ploty[MAXPOINTS];
+    int     plotprevmax;
+    int     plotprevx[MAXPOINTS], plotprevy[MAXPOINTS];
+    int     fromx, fromy;
+
+    int16_t radialprev[MAXPOINTS];
+    int     nradialprev;
+} BlurskRender;
+
+/* bitmap scaling, see bitmap_test() in bitmap.c */
+typedef struct
+{
+    int xnum, xdenom, xtrans;
+    int ynum, ydenom, ytrans;
+    int prevwidth, prevheight;
+    int bindex;
+} BlurskBitmap;
+
+/* text drawing, see text.c */
+typedef struct
+{
+    char **chmap[127];
+    int  textheight;    /* height of the tallest character, plus 1 */
+    int  frame;         /* frame counter, used for color-cycling */
+    int  textbg;        /* background color for text */
+    int  row;
+    int  big;
+} BlurskText;
+
+struct _BlurskPrivate {
         int                      height;
         int                      width;
         /* true if colormap should be regenerated */
         int                      update_colmap;
         VisPalette               pal;
         uint8_t                 *rgb_buf;
+        int                      rgb_width;     /* size of the image in rgb_buf */
+        int                      rgb_height;
+        int                      rgb_bpl;       /* bytes from one line of rgb_buf to the next */
         VisVideo                *video;
         VisBuffer               *pcmbuf;
         VisRandomContext        *rcontext;
         VisColor                color;
         VisPluginData           *plugin;
         int                     update_config_string;
-} BlurskPrivate;
 
-#endif
+        BlurskConfig            config;
+
+        VisSongInfo             *songinfo;
+        int                     blurskinfo;
+        int                     nspectrums;
+        /* This is used for slow motion */
+        int                     oddeven;
 
+        BlurskImage             img;
+        BlurskBeat              beat;
+        BlurskFloaters          floaters;
+        BlurskInfo              info;
+        BlurskBlur              blur;
+        BlurskColor             colormap;
+        BlurskRender            render;
+        BlurskBitmap            bitmap;
+        BlurskText              text;
+};
+
+#endif
@@ -86,7 +86,7 @@ static struct bdx_s {
 /* If str is the name of a bitmap followed by some other word, then return the
  * bitmap's index; else return -1.
  */
-int bitmap_index(char *str)
+int bitmap_index(BlurskPrivate *priv, char *str)
 {
     int bindex;
 
@@ -95,7 +95,7 @@ int bitmap_index(char *str)
      */
     if (!strcmp(str, "Maybe stencil"))
     {
-        bindex = rand_0_to(QTY(bitmaps) * 5);
+        bindex = rand_0_to(priv, QTY(bitmaps) * 5);
         if (bindex >= QTY(bitmaps))
             bindex = -1;
         return bindex;
@@ -107,14 +107,14 @@ int bitmap_index(char *str)
         /* If we're using a random stencil then treat any other "Random"
          * bitmap as a synonym for the stencil bitmap.
          */
-        if ((!strcmp(config.blur_stencil, "Random stencil")
-            || !strcmp(config.blur_stencil, "Maybe stencil"))
-         && blur_stencil != -1
+        if ((!strcmp(priv->config.blur_stencil, "Random stencil")
+            || !strcmp(priv->config.blur_stencil, "Maybe stencil"))
+         && priv->blur.stencil != -1
          && strcmp(str, "Random stencil"))
-            return blur_stencil;
+            return priv->blur.stencil;
 
         /* Otherwise, this can be any bitmap */
-        return rand_0_to(QTY(bitmaps));
+        return rand_0_to(priv, QTY(bitmaps));
     }
 
     /* Scan through bitmaps[] for the name */
@@ -131,24 +131,22 @@ int bitmap_index(char *str)
 
 
 /* Return FALSE for background pixels, TRUE for foreground pixels */
-int bitmap_test(int bindex, int x, int y)
+int bitmap_test(BlurskPrivate *priv, int bindex, int x, int y)
 {
+    BlurskBitmap *b = &priv->bitmap;
+    struct bdx_s *bdx = &bitmaps[bindex];
     int factor;
-    static int xnum, xdenom, xtrans;
-    static int ynum, ydenom, ytrans;
-    static int prevwidth, prevheight;
-    static struct bdx_s *bdx;
 
     /* If first time, then precompute some scaling factors */
-    if (prevwidth != img_width || prevheight != img_height || bdx != &bitmaps[bindex])
+    if (b->prevwidth != priv->img.width || b->prevheight != priv->img.height || b->bindex != bindex)
     {
         /* remember the screen size, so we can skip this next time */
-        prevwidth = img_width;
-        prevheight = img_height;
-        bdx = &bitmaps[bindex];
+        b->prevwidth = priv->img.width;
+        b->prevheight = priv->img.height;
+        b->bindex = bindex;
 
         /* For the "Medium CPU" setting, tweak the aspect ratio. */
-        if (*config.cpu_speed == 'M')
+        if (*priv->config.cpu_speed == 'M')
             factor = 2;
         else
             factor = 1;
@@ -156,31 +154,31 @@ int bitmap_test(int bindex, int x, int y)
         /* Compute the conversion factors, maintaining the same aspect
          * ratio.  (including the above tweak)
          */
-        if (img_width * bdx->height * factor < img_height * bdx->width) 
+        if (priv->img.width * bdx->height * factor < priv->img.height * bdx->width) 
         {
             /* Scale so width matches exactly */
-            xnum = bdx->width;
-            xdenom = img_width;
-            xtrans = 0;
-            ynum = bdx->width;
-            ydenom = img_width * factor;
-            ytrans = ((int)img_height - bdx->height * ydenom / ynum) / 2;
+            b->xnum = bdx->width;
+            b->xdenom = priv->img.width;
+            b->xtrans = 0;
+            b->ynum = bdx->width;
+            b->ydenom = priv->img.width * factor;
+            b->ytrans = ((int)priv->img.height - bdx->height * b->ydenom / b->ynum) / 2;
         }
         else
         {
             /* Scale so height matches exactly */
-            xnum = bdx->height * factor;
-            xdenom = img_height;
-            xtrans = ((int)img_width - bdx->width * xdenom / xnum) / 2;
-            ynum = bdx->height;
-            ydenom = img_height;
-            ytrans = 0;
+            b->xnum = bdx->height * factor;
+            b->xdenom = priv->img.height;
+            b->xtrans = ((int)priv->img.width - bdx->width * b->xdenom / b->xnum) / 2;
+            b->ynum = bdx->height;
+            b->ydenom = priv->img.height;
+            b->ytrans = 0;
         }
     }
 
     /* Scale (x,y) to fit the bitmap into the window. */
-    x = (x - xtrans) * xnum / xdenom;
-    y = (y - ytrans) * ynum / ydenom;
+    x = (x - b->xtrans) * b->xnum / b->xdenom;
+    y = (y - b->ytrans) * b->ynum / b->ydenom;
 
     /* if in bitmap, and the bit is set, then return TRUE.  Else FALSE */
     if (x >= 0 && x < bdx->width && y >= 0 && y < bdx->height
@@ -194,14 +192,14 @@ int bitmap_test(int bindex, int x, int y)
 
 
 /* Perform a flash by drawing a logo on the screen */
-void bitmap_flash(int bindex)
+void bitmap_flash(BlurskPrivate *priv, int bindex)
 {
     int x, y;
     unsigned char   *pixel;
 
-    for (y = 0, pixel = img_buf; y < img_height; y++, pixel += img_bpl - img_width)
-        for (x = 0; x < img_width; x++, pixel++)
-            if (bitmap_test(bindex, x, y))
+    for (y = 0, pixel = priv->img.buf; y < priv->img.height; y++, pixel += priv->img.bpl - priv->img.width)
+        for (x = 0; x < priv->img.width; x++, pixel++)
+            if (bitmap_test(priv, bindex, x, y))
                 *pixel = 160;
 }
 
@@ -55,26 +55,8 @@
 # include <signal.h>
 #endif
 
-/* To detect rhythms, blursk tracks the loudness of the signal across multiple
- * frames.  This is the maximum number of frames, and should correspond to the
- * slowest rhythm.
- */
-#define BEAT_MAX    200
-
 static void blursk_render_pcm(BlurskPrivate *priv, int16_t *data);
 
-/* This is used for slow motion */
-static int oddeven;
-
-int nspectrums;
-
-static int32_t  beathistory[BEAT_MAX];
-static int  beatbase;
-static int  beatquiet;  /* force "quiet" situation? */
-
-int blurskinfo = FALSE;
-VisSongInfo *songinfo;
-
 
 /**
  * Return the name of the i'th floater method
@@ -98,63 +80,58 @@ char *floaters_name(int i)
  * thickness value from 0 to 3, and it detects the start of silence for
  * the "Random quiet" setting.
  */
-static int detect_beat(int32_t loudness, int *thickref, int *quietref)
+static int detect_beat(BlurskPrivate *priv, int32_t loudness, int *thickref, int *quietref)
 {
-    static int32_t  aged;       /* smoothed out loudness */
-    static int32_t  lowest;     /* quietest point in current beat */
-    static int  elapsed;    /* frames since last beat */
-    static int  isquiet;    /* was previous frame quiet */
-    static int  prevbeat;   /* period of previous beat */
     int     beat, i, j;
     int32_t     total;
     int     sensitivity;
 
     /* Incorporate the current loudness into history */
-    aged = (aged * 7 + loudness) >> 3;
-    elapsed++;
+    priv->beat.aged = (priv->beat.aged * 7 + loudness) >> 3;
+    priv->beat.elapsed++;
 
     /* If silent, then clobber the beat */
-    if (aged < 2000 || elapsed > BEAT_MAX)
+    if (priv->beat.aged < 2000 || priv->beat.elapsed > BEAT_MAX)
     {
-        elapsed = 0;
-        lowest = aged;
-        memset(beathistory, 0, sizeof beathistory);
+        priv->beat.elapsed = 0;
+        priv->beat.lowest = priv->beat.aged;
+        memset(priv->beat.history, 0, sizeof priv->beat.history);
     }
-    else if (aged < lowest)
-        lowest = aged;
+    else if (priv->beat.aged < priv->beat.lowest)
+        priv->beat.lowest = priv->beat.aged;
 
     /* Beats are detected by looking for a sudden loudness after a lull.
      * They are also limited to occur no more than once every 15 frames,
      * so the beat flashes don't get too annoying.
      */
-    j = (beatbase + elapsed) % BEAT_MAX;
-    beathistory[j] = loudness - aged;
+    j = (priv->beat.base + priv->beat.elapsed) % BEAT_MAX;
+    priv->beat.history[j] = loudness - priv->beat.aged;
     beat = FALSE;
-    if (elapsed > 15 && aged > 2000 && loudness * 4 > aged * 5)
+    if (priv->beat.elapsed > 15 && priv->beat.aged > 2000 && loudness * 4 > priv->beat.aged * 5)
     {
         /* Compute the average loudness change, assuming this is beat */
-        for (i = BEAT_MAX / elapsed, total = 0;
+        for (i = BEAT_MAX / priv->beat.elapsed, total = 0;
              --i > 0;
-             j = (j + BEAT_MAX - elapsed) % BEAT_MAX)
+             j = (j + BEAT_MAX - priv->beat.elapsed) % BEAT_MAX)
         {
-            total += beathistory[j];
+            total += priv->beat.history[j];
         }
-        total = total * elapsed / BEAT_MAX;
+        total = total * priv->beat.elapsed / BEAT_MAX;
 
         /* Tweak the sensitivity to emphasize a consistent rhythm */
-        sensitivity = config.beat_sensitivity;
-        i = 3 - abs(elapsed - prevbeat)/2;
+        sensitivity = priv->config.beat_sensitivity;
+        i = 3 - abs(priv->beat.elapsed - priv->beat.prevbeat)/2;
         if (i > 0)
             sensitivity += i;
 
         /* If average change is significantly positive, this is a beat.
          */
-        if (total * sensitivity > aged)
+        if (total * sensitivity > priv->beat.aged)
         {
-            prevbeat = elapsed;
-            beatbase = (beatbase + elapsed) % BEAT_MAX;
-            lowest = aged;
-            elapsed = 0;
+            priv->beat.prevbeat = priv->beat.elapsed;
+            priv->beat.base = (priv->beat.base + priv->beat.elapsed) % BEAT_MAX;
+            priv->beat.lowest = priv->beat.aged;
+            priv->beat.elapsed = 0;
             beat = TRUE;
         }
     }
@@ -163,13 +140,13 @@ static int detect_beat(int32_t loudness, int *thickref, int *quietref)
      * loudness and the aged loudness.  Thus, a sudden increase in volume
      * will produce a thick line, regardless of rhythm.
      */
-    if (aged < 1500)
+    if (priv->beat.aged < 1500)
         *thickref = 0;
-    else if (!config.thick_on_beats)
+    else if (!priv->config.thick_on_beats)
         *thickref = 1;
     else
     {
-        *thickref = loudness * 2 / aged;
+        *thickref = loudness * 2 / priv->beat.aged;
         if (*thickref > 3)
             *thickref = 3;
     }
@@ -181,33 +158,31 @@ static int detect_beat(int32_t loudness, int *thickref, int *quietref)
      * periods -- that sort of thing happens during many fade edits, so
      * we have to account for it.
      */
-    if (beatquiet || aged < (isquiet ? 1500 : 500))
+    if (priv->beat.quiet || priv->beat.aged < (priv->beat.isquiet ? 1500 : 500))
     {
         /* Quiet now -- is this the start of quiet? */
-        *quietref = !isquiet;
-        isquiet = TRUE;
-        beatquiet = FALSE;
+        *quietref = !priv->beat.isquiet;
+        priv->beat.isquiet = TRUE;
+        priv->beat.quiet = FALSE;
     }
     else
     {
         *quietref = FALSE;
-        isquiet = FALSE;
+        priv->beat.isquiet = FALSE;
     }
 
     /* return the result */
     return beat;
 }
 
-static void drawfloaters(int beat)
+static void drawfloaters(BlurskPrivate *priv, int beat)
 {
-    static int prevfloaters;
-    static struct {int x, y, age; uint8_t color;} floater[10];
-    static int oddeven;
+    BlurskFloater *floater = priv->floaters.floater;
     int nfloaters;
     int i, j, delta, dx, dy;
 
     /* choose the number of floaters */
-    switch (*config.floaters)
+    switch (*priv->config.floaters)
     {
       case 'N': /* No floaters */
         nfloaters = 0;
@@ -218,25 +193,25 @@ static void drawfloaters(int beat)
         break;
 
       case 'S': /* Slow */
-        oddeven++;
+        priv->floaters.oddeven++;
         /* fall through... */
 
       default: /* Slow/Fast/Retro floaters */
-        nfloaters = 1 + img_width * img_height / 20000;
-        if (nfloaters > 10)
-            nfloaters = 10;
+        nfloaters = 1 + priv->img.width * priv->img.height / 20000;
+        if (nfloaters > MAXFLOATERS)
+            nfloaters = MAXFLOATERS;
     }
 
     /* for each floater... */
     for (i = 0; i < nfloaters; i++)
     {
         /* if Dots, new, old, beat, or off-screen... */
-        if (*config.floaters == 'D'
-         || i >= prevfloaters
+        if (*priv->config.floaters == 'D'
+         || i >= priv->floaters.nprev
          || floater[i].age++ > 80 + i * 13
          || beat
-         || floater[i].x < 0 || floater[i].x >= img_width
-         || floater[i].y < 0 || floater[i].y >= img_height)
+         || floater[i].x < 0 || floater[i].x >= priv->img.width
+         || floater[i].y < 0 || floater[i].y >= priv->img.height)
         {
             /* Pretend motion is 0.  This will cause blursk to
              * choose a new position, later in this function.
@@ -246,22 +221,22 @@ static void drawfloaters(int beat)
         else
         {
             /* find the real motion */
-            j = floater[i].y * img_bpl + floater[i].x;
-            delta = &img_buf[j] - img_source[j];
+            j = floater[i].y * priv->img.bpl + floater[i].x;
+            delta = &priv->img.buf[j] - priv->img.source[j];
         }
 
         /* if motion isn't 0, then move the floater */
         if (delta != 0)
         {
             /* decompose the delta into dx & dy.  Watch signs! */
-            dx = (j + delta) % img_bpl - floater[i].x;
-            dy = (j + delta) / img_bpl - floater[i].y;
+            dx = (j + delta) % priv->img.bpl - floater[i].x;
+            dy = (j + delta) / priv->img.bpl - floater[i].y;
 
             /* move the floater */
-            switch (*config.floaters)
+            switch (*priv->config.floaters)
             {
               case 'S': /* Slow floaters */
-                if ((oddeven ^ i) & 0x1)
+                if ((priv->floaters.oddeven ^ i) & 0x1)
                     dx = dy = 0;
                 break;
 
@@ -283,13 +258,13 @@ static void drawfloaters(int beat)
          * choose a new random position & contrasting color.
          */
         if (delta == 0
-         || floater[i].x < 0 || floater[i].x >= img_width
-         || floater[i].y < 0 || floater[i].y >= img_height)
+         || floater[i].x < 0 || floater[i].x >= priv->img.width
+         || floater[i].y < 0 || floater[i].y >= priv->img.height)
         {
             /* choose a new random position */
-            floater[i].x = rand_0_to(img_width - 9) + 2;
-            floater[i].y = rand_0_to(img_height - 9) + 2;
-            if (IMG_PIXEL(floater[i].x, floater[i].y) > 0x80)
+            floater[i].x = rand_0_to(priv, priv->img.width - 9) + 2;
+            floater[i].y = rand_0_to(priv, priv->img.height - 9) + 2;
+            if (IMG_PIXEL(priv, floater[i].x, floater[i].y) > 0x80)
                 floater[i].color = 0;
             else
                 floater[i].color = 0xfe;
@@ -297,87 +272,83 @@ static void drawfloaters(int beat)
         }
 
         /* draw the floater */
-        render_dot(floater[i].x, floater[i].y, floater[i].color);
+        render_dot(priv, floater[i].x, floater[i].y, floater[i].color);
     }
-    prevfloaters = nfloaters;
+    priv->floaters.nprev = nfloaters;
 }
 
 /* This detects libvisual songinfo events and updates title when appropriate.
  * It should be called once for each frame.
  */
 
-static unsigned char *show_info(unsigned char *img, int height, int bpl)
+static unsigned char *show_info(BlurskPrivate *priv, unsigned char *img, int height, int bpl)
 {
     int pos, length;
     time_t now;
-    static int prevpos;
-    static char buf[1000];
-    static time_t start, then;
-    static int persistent = FALSE;
     char showinfo;
     char posstr[32], lenstr[32];
 
-    if(songinfo == NULL || songinfo->type == VISUAL_SONGINFO_TYPE_NULL)
+    if(priv->songinfo == NULL || priv->songinfo->type == VISUAL_SONGINFO_TYPE_NULL)
         return img;
 
     time(&now);
-    if(now != then)
+    if(now != priv->info.then)
     {
-        then = now;
-        pos = songinfo->elapsed;
+        priv->info.then = now;
+        pos = priv->songinfo->elapsed;
 
         convert_ms_to_timestamp(posstr, pos);
-        length = songinfo->length;
+        length = priv->songinfo->length;
         convert_ms_to_timestamp(lenstr, length);
-        if(pos != prevpos)
+        if(pos != priv->info.prevpos)
         {
-            prevpos = pos;
-            beatquiet = TRUE;
-            switch(songinfo->type)
+            priv->info.prevpos = pos;
+            priv->beat.quiet = TRUE;
+            switch(priv->songinfo->type)
             {
                 case VISUAL_SONGINFO_TYPE_SIMPLE:
-                    if(config.show_timestamp)
+                    if(priv->config.show_timestamp)
                     {
 						if(lenstr != NULL)
-							sprintf(buf, "{%s/%s} %s", posstr, lenstr, songinfo->songname);
+							sprintf(priv->info.buf, "{%s/%s} %s", posstr, lenstr, priv->songinfo->songname);
                         else
-                            sprintf(buf, "(%s) %s", posstr, songinfo->songname);
+                            sprintf(priv->info.buf, "(%s) %s", posstr, priv->songinfo->songname);
                         break;
                     }
                     else
                     {
-                        sprintf(buf, "%s", songinfo->songname);
+                        sprintf(priv->info.buf, "%s", priv->songinfo->songname);
                     }
 
                 case VISUAL_SONGINFO_TYPE_ADVANCED:
-                    if(config.show_timestamp)
+                    if(priv->config.show_timestamp)
                     {
-                        if(strcmp(songinfo->artist, "(null)") == 0)
+                        if(strcmp(priv->songinfo->artist, "(null)") == 0)
                         {
                             if(length >= 0)
-                                sprintf(buf, "{%s/%s} %s", posstr, lenstr, songinfo->song);
+                                sprintf(priv->info.buf, "{%s/%s} %s", posstr, lenstr, priv->songinfo->song);
                             else
-                                sprintf(buf, "(%s) %s", posstr, songinfo->song);
+                                sprintf(priv->info.buf, "(%s) %s", posstr, priv->songinfo->song);
                         }
                         else
                         {
                             if(length >= 0)
-                                sprintf(buf, "{%s/%s} %s by %s", posstr, lenstr,
-                                    songinfo->song, songinfo->artist);
+                                sprintf(priv->info.buf, "{%s/%s} %s by %s", posstr, lenstr,
+                                    priv->songinfo->song, priv->songinfo->artist);
                             else
-                                sprintf(buf, "(%s) %s by %s", posstr, songinfo->song, songinfo->artist);
+                                sprintf(priv->info.buf, "(%s) %s by %s", posstr, priv->songinfo->song, priv->songinfo->artist);
                         }
                     }
                     else
                     {
-                        if(strcmp(songinfo->artist, "(null)") == 0)
+                        if(strcmp(priv->songinfo->artist, "(null)") == 0)
                         {
-                            if(strcmp(songinfo->song, "(null)") != 0)
-                                sprintf(buf, "%s", songinfo->song);
+                            if(strcmp(priv->songinfo->song, "(null)") != 0)
+                                sprintf(priv->info.buf, "%s", priv->songinfo->song);
                         }
                         else
                         {
-                            sprintf(buf, "%s by %s", songinfo->song, songinfo->artist);
+                            sprintf(priv->info.buf, "%s by %s", priv->songinfo->song, priv->songinfo->artist);
                         }
                     }
                     break;
@@ -389,18 +360,18 @@ static unsigned char *show_info(unsigned char *img, int height, int bpl)
         }
     }
 
-    showinfo = *config.show_info;
-    if(blurskinfo || persistent)
+    showinfo = *priv->config.show_info;
+    if(priv->blurskinfo || priv->info.persistent)
     {
         if(showinfo == 'N')
             return img;
 
-        if(blurskinfo)
+        if(priv->blurskinfo)
         {
-            start = now;
-            persistent = TRUE;
+            priv->info.start = now;
+            priv->info.persistent = TRUE;
         }
-        blurskinfo = FALSE;
+        priv->blurskinfo = FALSE;
     }
 
     /* If not supposed to show text, then we're done */
@@ -408,9 +379,9 @@ static unsigned char *show_info(unsigned char *img, int height, int bpl)
         case 'N': /* Never show info */
             return img;
         case 'T': /* 4 second info */
-            if(now - start > config.info_timeout)
+            if(now - priv->info.start > priv->config.info_timeout)
             {
-                persistent = FALSE;
+                priv->info.persistent = FALSE;
                 return img;
             }
         case 'A': /* Always show info */
@@ -424,14 +395,14 @@ static unsigned char *show_info(unsigned char *img, int height, int bpl)
      * (which is very common!) normally leaves the image in the main buffer.
      * We need to detect this, and copy the image before we draw the text.
      */
-    if (img != img_tmp)
+    if (img != priv->img.tmp)
     {
-        memcpy(img_tmp, img, img_chunks * 8);
-        img = img_tmp;
+        memcpy(priv->img.tmp, img, priv->img.chunks * 8);
+        img = priv->img.tmp;
     }
 
     /* draw the text */
-    textdraw(img, height, bpl, "Center", buf);
+    textdraw(priv, img, height, bpl, "Center", priv->info.buf);
     return img;
 }
 
@@ -457,19 +428,19 @@ static void update_image(BlurskPrivate *priv, int32_t loudness, int ndata, int16
 
 
     /* Detect whether this is a beat, and choose a line thickness */
-    beat = detect_beat(loudness, &thick, &quiet);
+    beat = detect_beat(priv, loudness, &thick, &quiet);
 
     /* Perform the blurring.  This also affects whether the center of the
      * signal will be moved lower in the window.
      */
-    center = img_height/2 + blur(priv, beat, quiet);
+    center = priv->img.height/2 + blur(priv, beat, quiet);
 
     /* Perform the fade or solid flash */
-    if (beat && !strcmp(config.flash_style, "Full flash"))
+    if (beat && !strcmp(priv->config.flash_style, "Full flash"))
         i = 60;
     else
     {
-        switch (config.fade_speed[0])
+        switch (priv->config.fade_speed[0])
         {
           case 'S': i = -1; break;  /* Slow */
           case 'M': i = -3; break;  /* Medium */
@@ -479,15 +450,15 @@ static void update_image(BlurskPrivate *priv, int32_t loudness, int ndata, int16
         }
     }
     if (i != 0)
-        loopfade(i);
+        loopfade(priv, i);
 
     /* special processing for "Invert" & bitmap logo flashes */
     if (beat)
     {
-        if (!strcmp(config.flash_style, "Invert flash"))
-            img_invert();
-        else if ((i = bitmap_index(config.flash_style)) >= 0)
-            bitmap_flash(i);
+        if (!strcmp(priv->config.flash_style, "Invert flash"))
+            img_invert(priv);
+        else if ((i = bitmap_index(priv, priv->config.flash_style)) >= 0)
+            bitmap_flash(priv, i);
     }
 
     /* Maybe change hue on beats */
@@ -495,33 +466,36 @@ static void update_image(BlurskPrivate *priv, int32_t loudness, int ndata, int16
         color_beat(priv);
 
     /* Add the signal data to the image */
-    render(thick, center, ndata, data);
+    render(priv, thick, center, ndata, data);
 
     /* Add floaters */
-    drawfloaters(beat);
+    drawfloaters(priv, beat);
 
     /* shift the "ripple effect" from one frame to another */
-    img_rippleshift += 3; /* cyclic, since img_rippleshift is a unsigned char */
+    priv->img.rippleshift += 3; /* cyclic, since img.rippleshift is a unsigned char */
 
     /* Apply the overall effect, if any */
-    if (!strcmp(config.overall_effect, "Bump effect"))
+    if (!strcmp(priv->config.overall_effect, "Bump effect"))
     {
-        priv->rgb_buf = img_bump(&width, &height, &bpl);
+        priv->rgb_buf = img_bump(priv, &width, &height, &bpl);
     }
-    else if (!strcmp(config.overall_effect, "Anti-fade effect"))
+    else if (!strcmp(priv->config.overall_effect, "Anti-fade effect"))
     {
-        priv->rgb_buf = img_travel(&width, &height, &bpl);
+        priv->rgb_buf = img_travel(priv, &width, &height, &bpl);
     }
-    else if (!strcmp(config.overall_effect, "Ripple effect"))
+    else if (!strcmp(priv->config.overall_effect, "Ripple effect"))
     {
-        priv->rgb_buf = img_ripple(&width, &height, &bpl);
+        priv->rgb_buf = img_ripple(priv, &width, &height, &bpl);
     }
     else /* "Normal effect" */
     {
-        priv->rgb_buf = img_expand(&width, &height, &bpl);
+        priv->rgb_buf = img_expand(priv, &width, &height, &bpl);
     }
 
-    priv->rgb_buf = show_info(priv->rgb_buf, height, bpl);
+    priv->rgb_buf = show_info(priv, priv->rgb_buf, height, bpl);
+    priv->rgb_width = width;
+    priv->rgb_height = height;
+    priv->rgb_bpl = bpl;
 
     /* Allow the background color to change */
     color_bg(priv, ndata, data);
@@ -537,8 +511,8 @@ static void blursk_render_pcm(BlurskPrivate *priv, int16_t *data)
     int32_t loudness, delta_sum;
 
     /* If slow motion, then ignore odd-numbered frames */
-    oddeven = !oddeven;
-    if (config.slow_motion && oddeven)
+    priv->oddeven = !priv->oddeven;
+    if (priv->config.slow_motion && priv->oddeven)
         return;
 
     /* Find the maximum and minimum, with the restriction that
@@ -575,11 +549,11 @@ static void blursk_render_pcm(BlurskPrivate *priv, int16_t *data)
 }
 
 
-void blursk_event_newsong(VisSongInfo *newsong)
+void blursk_event_newsong(BlurskPrivate *priv, VisSongInfo *newsong)
 {
     visual_return_if_fail(newsong != NULL);
-    visual_songinfo_copy(songinfo, newsong);
-    blurskinfo = TRUE;
+    visual_songinfo_copy(priv->songinfo, newsong);
+    priv->blurskinfo = TRUE;
 }
 
 void __blursk_render_pcm (BlurskPrivate *priv, int16_t *pcmbuf) {
@@ -587,31 +561,36 @@ void __blursk_render_pcm (BlurskPrivate *priv, int16_t *pcmbuf) {
 }
 
 void __blursk_init (BlurskPrivate *priv) {
+    priv->blur.styletransition = -1;
+    priv->blur.stencil = -1;
+    priv->blur.wobbledir = 1;
+    priv->blur.odd = 1;
     color_genmap(priv, FALSE);
-    img_resize(priv, config.width, config.height);
-    songinfo = visual_songinfo_new(VISUAL_SONGINFO_TYPE_NULL);
+    img_resize(priv, priv->config.width, priv->config.height);
+    priv->songinfo = visual_songinfo_new(VISUAL_SONGINFO_TYPE_NULL);
 }
 
 void __blursk_cleanup (BlurskPrivate *priv) {
-    img_cleanup();
-    visual_mem_free(songinfo);
+    img_cleanup(priv);
+    visual_object_unref(VISUAL_OBJECT(priv->songinfo));
 
     /* cleanup config strings */
-    visual_mem_free(config.color_style);
-    visual_mem_free(config.signal_color);
-    visual_mem_free(config.background);
-    visual_mem_free(config.blur_style);
-    visual_mem_free(config.transition_speed);
-    visual_mem_free(config.blur_when);
-    visual_mem_free(config.blur_stencil);
-    visual_mem_free(config.fade_speed);
-    visual_mem_free(config.signal_style);
-    visual_mem_free(config.plot_style);
-    visual_mem_free(config.flash_style);
-    visual_mem_free(config.overall_effect);
-    visual_mem_free(config.floaters);
-    visual_mem_free(config.cpu_speed);
-    visual_mem_free(config.show_info);
+    visual_mem_free(priv->config.color_style);
+    visual_mem_free(priv->config.signal_color);
+    visual_mem_free(priv->config.background);
+    visual_mem_free(priv->config.blur_style);
+    visual_mem_free(priv->config.transition_speed);
+    visual_mem_free(priv->config.blur_when);
+    visual_mem_free(priv->config.blur_stencil);
+    visual_mem_free(priv->config.fade_speed);
+    visual_mem_free(priv->config.signal_style);
+    visual_mem_free(priv->config.plot_style);
+    visual_mem_free(priv->config.flash_style);
+    visual_mem_free(priv->config.overall_effect);
+    visual_mem_free(priv->config.floaters);
+    visual_mem_free(priv->config.cpu_speed);
+    visual_mem_free(priv->config.show_info);
+    visual_mem_free(priv->config.config_string);
 
 }
 
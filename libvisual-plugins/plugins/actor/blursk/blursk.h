@@ -26,62 +26,21 @@
 
 #include <libvisual/libvisual.h>
 
+#include "actor_blursk.h"
+
 #define VISUAL_PI 3.14159265358979
 
 #define QTY(array)  (sizeof(array) / sizeof(*(array)))
 
-#ifdef RAND_MAX
-# define rand_0_to(n)   (int)((double)rand() * (double)(n) / (RAND_MAX + 1.0))
-#else
-# define rand_0_to(n)   (rand() % (n))
-#endif
+/* Random numbers come from the plugin's own random context, so that each
+ * instance has a separate, reproducible sequence.
+ */
+#define rand_0_to(priv, n)  (int)visual_random_context_int_range((priv)->rcontext, 0, (n) - 1)
+#define blursk_rand(priv)   (int)(visual_random_context_int((priv)->rcontext) >> 1)
 
 #define MAX(a, b) (a > b ? a : b)
 #define MIN(a ,b) (a > b ? b : a)
 
-typedef struct
-{
-    /* dimensions */
-    int width;
-    int height;
-
-    /* color options */
-    uint32_t color;
-    char    *color_style;
-    char    *fade_speed;
-    char    *signal_color;
-    int32_t contour_lines;
-    int32_t hue_on_beats;
-    char    *background;
-
-    /* blur/fade options */
-    char    *blur_style;
-    char    *transition_speed;
-    char    *blur_when;
-    char    *blur_stencil;
-    int32_t slow_motion;
-
-    /* other effects */
-    char    *signal_style;
-    char    *plot_style;
-    int32_t thick_on_beats;
-    char    *flash_style;
-    char    *overall_effect;
-    char    *floaters;
-
-    /* miscellany from the Advanced screen */
-    char    *cpu_speed;
-    char    *show_info;
-    int     info_timeout;
-    int     show_timestamp;
-
-    /* beat detector */
-    int32_t beat_sensitivity;
-    
-    /* config-string */
-    char *config_string;
-} BlurskConfig;
-
 extern char config_default_color_style[];
 extern char config_default_signal_color[];
 extern char config_default_background[];
@@ -100,8 +59,6 @@ extern char config_default_show_info[];
 extern char config_default_fullscreen_method[];
 
 
-BlurskConfig config;
-
 void __blursk_render_pcm (BlurskPrivate *priv, int16_t *pcmbuf);
 void __blursk_init (BlurskPrivate *priv);
 void __blursk_cleanup (BlurskPrivate *priv);
@@ -114,26 +71,20 @@ extern void config_string_genstring(BlurskPrivate *priv);
 
 
 /* in blur.c */
-extern int blur_stencil;
 extern int blur(BlurskPrivate *, int, int);
 extern char *blur_name(int);
 extern char *blur_when_name(int);
 
 
 /* in blursk.c */
-extern int blurskinfo;
-extern int nspectrums;
-extern void blursk_genrender(void);
-extern void blursk_event_newsong(VisSongInfo *newsong);
+extern void blursk_event_newsong(BlurskPrivate *priv, VisSongInfo *newsong);
 extern char *floaters_name(int);
 
 
 /* in color.c */
-extern uint32_t colors[256];
 extern void color_transition(BlurskPrivate *, int, int, int);
 extern void color_genmap(BlurskPrivate *, int);
 extern void color_bg(BlurskPrivate *, int, int16_t*);
-extern void color_cleanup(void);
 extern char *color_name(int);
 extern char *color_background_name(int);
 extern int color_good_for_bump(char *);
@@ -141,61 +92,56 @@ extern void color_beat(BlurskPrivate *);
 
 
 /* in img.c */
-#define IMG_PIXEL(x,y)  (img_buf[(y) * img_bpl + (x)])
-extern unsigned char *img_buf;
-extern unsigned char *img_prev;
-extern unsigned char *img_tmp;
-extern unsigned char **img_source;
-extern unsigned int img_height, img_physheight;
-extern unsigned int img_width, img_physwidth;
-extern unsigned int img_bpl, img_physbpl;
-extern unsigned int img_chunks;
-extern unsigned char img_rippleshift;
+#define IMG_PIXEL(priv,x,y)  ((priv)->img.buf[(y) * (priv)->img.bpl + (x)])
 extern void img_resize(BlurskPrivate *, int, int);
-extern void img_cleanup(void);
-extern void img_copyback(void);
-extern void img_invert(void);
-extern unsigned char *img_expand(int *, int *, int *);
-extern unsigned char *img_bump(int *, int *, int *);
-extern unsigned char *img_travel(int *, int *, int *);
-extern unsigned char *img_ripple(int *, int *, int *);
-
-
-/* in loop.c or loopx86.s */
-extern void loopblur(void);
-extern void loopsmear(void);
-extern void loopmelt(void);
-extern void loopsharp(void);
-extern void loopreduced1(void);
-extern void loopreduced2(void);
-extern void loopreduced3(void);
-extern void loopreduced4(void);
-extern void loopfade(int change);
-extern void loopinterp(void);
+extern void img_cleanup(BlurskPrivate *);
+extern void img_copyback(BlurskPrivate *);
+extern void img_invert(BlurskPrivate *);
+extern unsigned char *img_expand(BlurskPrivate *, int *, int *, int *);
+extern unsigned char *img_bump(BlurskPrivate *, int *, int *, int *);
+extern unsigned char *img_travel(BlurskPrivate *, int *, int *, int *);
+extern unsigned char *img_ripple(BlurskPrivate *, int *, int *, int *);
+
+
+/* in loop.c.  The blur loops fill chunks 8-pixel groups of dest from the
+ * pixels at srcref, orig is the unblurred image at the same position.
+ */
+typedef void (*BlurskLoopFunc)(unsigned char *dest, unsigned char **srcref,
+                               unsigned char *orig, unsigned int chunks, int bpl);
+extern void loopblur(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopsmear(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopmelt(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopsharp(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopreduced1(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopreduced2(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopreduced3(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopreduced4(unsigned char *, unsigned char **, unsigned char *, unsigned int, int);
+extern void loopfade(BlurskPrivate *priv, int change);
+extern void loopinterp(BlurskPrivate *priv);
 
 
 /* in render.c */
-extern void render_dot(int x, int y, unsigned char color);
-extern void render(int thick, int center, int ndata, int16_t *data);
+extern void render_dot(BlurskPrivate *priv, int x, int y, unsigned char color);
+extern void render(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data);
 extern char *render_plotname(int);
 extern char *signal_style_name(int i);
 
 
 /* in bitmap.c */
-extern int bitmap_index(char *str);
-extern int bitmap_test(int bindex, int x, int y);
-extern void bitmap_flash(int bindex);
+extern int bitmap_index(BlurskPrivate *priv, char *str);
+extern int bitmap_test(BlurskPrivate *priv, int bindex, int x, int y);
+extern void bitmap_flash(BlurskPrivate *priv, int bindex);
 extern char *bitmap_flash_name(int i);
 extern char *bitmap_stencil_name(int i);
 
 
 /* in paste.c */
-extern BlurskConfig *paste_parsestring(char *str);
-extern char *paste_genstring(void);
+extern BlurskConfig *paste_parsestring(BlurskConfig *c, char *str);
+extern char *paste_genstring(BlurskConfig *conf, char *buf);
 
 
 /* in text.c */
-extern void textdraw(unsigned char *img, int height, int bpl, char *side, char *text);
+extern void textdraw(BlurskPrivate *priv, unsigned char *img, int height, int bpl, char *side, char *text);
 extern void convert_ms_to_timestamp(char *buf, int ms);
 
 #endif
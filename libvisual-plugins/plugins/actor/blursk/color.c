@@ -72,38 +72,21 @@
 #include "actor_blursk.h"
 #include "blursk.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+
 typedef struct
 {
         double  hue, saturation, value;
 } hsv_t;
 
-/* This is where Blursk stores its version of the colors */
-uint32_t colors[256];
-
-/* This function pointer refers to a function which can be called to compute
- * the value of a given cell in color_map.  It is only called when setting up
- * the color_map; it is *not* called for every frame.
- */
-static int32_t (*stylefunc)(int32_t);
-
-/* These are the R/G/B components of the base color */
-static int32_t red, green, blue;
-
-/* This is a random color, which is used for the "Colored background" setting */
-static int32_t tored, togreen, toblue;
-static int tonew;
-static int32_t fromred, fromgreen, fromblue;
-static int32_t bgred, bggreen, bgblue;
-static char bgletter; /* first letter of chosen bkgnd, after "Random" */
-
-static int  transition_bound;
-
 /*---------------------------------------------------------------------------*/
 
 /* Convert a color from RGB format to HSV format */
-static hsv_t *rgb_to_hsv(int32_t rgb)
+static hsv_t rgb_to_hsv(int32_t rgb)
 {
-    static hsv_t    hsv;    /* HSV value (saved between invocations */
+    hsv_t       hsv;    /* HSV value */
     double      r, g, b;/* the RGB components, in range 0.0 - 1.0 */
     double      max, min;/* extremes from r, g, b */
     double      delta;  /* difference between max and min */
@@ -160,7 +143,7 @@ static hsv_t *rgb_to_hsv(int32_t rgb)
     }
 
     /* return the computed color */
-    return &hsv;
+    return hsv;
 }
 
 
@@ -222,44 +205,44 @@ static int32_t hsv_to_rgb(hsv_t *hsv)
  */
 
 
-static int32_t dimming(int32_t i)
+static int32_t dimming(BlurskPrivate *priv, int32_t i)
 {
-    return (((int32_t)(i * red / 256) << 16)
-        | ((int32_t)(i * green / 256) << 8)
-        | ((int32_t)(i * blue / 256))
+    return (((int32_t)(i * priv->colormap.red / 256) << 16)
+        | ((int32_t)(i * priv->colormap.green / 256) << 8)
+        | ((int32_t)(i * priv->colormap.blue / 256))
         | ((255 - i) << 24));
 }
 
-static int32_t brightening(int32_t i)
+static int32_t brightening(BlurskPrivate *priv, int32_t i)
 {
     i = 255 - i;
 
-    return (((int32_t)(i * red / 256) << 16)
-        | ((int32_t)(i * green / 256) << 8)
-        | ((int32_t)(i * blue / 256))
+    return (((int32_t)(i * priv->colormap.red / 256) << 16)
+        | ((int32_t)(i * priv->colormap.green / 256) << 8)
+        | ((int32_t)(i * priv->colormap.blue / 256))
         | ((255 - i) << 24));
 }
 
-static int32_t milky(int32_t i)
+static int32_t milky(BlurskPrivate *priv, int32_t i)
 {
     int32_t r, g, b, tmp, k;
     if (i < 128)
     {
-        r = i * red / 128;
-        g = i * green / 128;
-        b = i * blue / 128;
+        r = i * priv->colormap.red / 128;
+        g = i * priv->colormap.green / 128;
+        b = i * priv->colormap.blue / 128;
         k = (127 - i) << 25;
     }
     else
     {
         tmp = 255 - i;
-        r = 255 - (255 - red) * tmp / 128;
-        g = 255 - (255 - green) * tmp / 128;
-        b = 255 - (255 - blue) * tmp / 128;
+        r = 255 - (255 - priv->colormap.red) * tmp / 128;
+        g = 255 - (255 - priv->colormap.green) * tmp / 128;
+        b = 255 - (255 - priv->colormap.blue) * tmp / 128;
         k = 0;
     }
     tmp = (r << 16) | (g << 8) | b;
-    if (*config.overall_effect == 'B') /* "Bump effect" */
+    if (*priv->config.overall_effect == 'B') /* "Bump effect" */
     {
 #if 0
         if (i == 128)
@@ -282,38 +265,38 @@ static int32_t milky(int32_t i)
     return tmp | k;
 }
 
-static int32_t cloud(int32_t i)
+static int32_t cloud(BlurskPrivate *priv, int32_t i)
 {
     int32_t faded;  /* r/g/b level of gray version of color */
     int32_t r, g, b, k;
 
     /* Compute the gray version */
-    faded = (red * 4 + green * 5 + blue * 3) / 12;
+    faded = (priv->colormap.red * 4 + priv->colormap.green * 5 + priv->colormap.blue * 3) / 12;
 
     /* handle a few specific colors */
-    if (i == 128 && *config.overall_effect == 'B') /* "Bump effect" */
+    if (i == 128 && *priv->config.overall_effect == 'B') /* "Bump effect" */
     {
         /* Use the given color */
-        r = red;
-        g = green;
-        b = blue;
+        r = priv->colormap.red;
+        g = priv->colormap.green;
+        b = priv->colormap.blue;
         k = 0;
     }
-    else if ((i == 129 || i == 127) && *config.overall_effect == 'B') /* "Bump effect" */
+    else if ((i == 129 || i == 127) && *priv->config.overall_effect == 'B') /* "Bump effect" */
     {
         /* Use a faded version of the color */
-        r = (red + faded) / 2;
-        g = (green + faded) / 2;
-        b = (blue + faded) / 2;
+        r = (priv->colormap.red + faded) / 2;
+        g = (priv->colormap.green + faded) / 2;
+        b = (priv->colormap.blue + faded) / 2;
         k = 0;
     }
     else if (i > 192)
     {
         /* transition between the given color and white */
         i -= 192;
-        r = (red * i + 255 * (63 - i)) / 64;
-        g = (green * i + 255 * (63 - i)) / 64;
-        b = (blue * i + 255 * (63 - i)) / 64;
+        r = (priv->colormap.red * i + 255 * (63 - i)) / 64;
+        g = (priv->colormap.green * i + 255 * (63 - i)) / 64;
+        b = (priv->colormap.blue * i + 255 * (63 - i)) / 64;
         k = 0;
     }
     else if (i > 128)
@@ -334,15 +317,15 @@ static int32_t cloud(int32_t i)
     return (r << 16) | (g << 8) | b | k;
 }
 
-static int32_t metal(int32_t i)
+static int32_t metal(BlurskPrivate *priv, int32_t i)
 {
     int32_t r, g, b, k;
 
     if (i < 128)
     {
-        r = red;
-        g = green;
-        b = blue;
+        r = priv->colormap.red;
+        g = priv->colormap.green;
+        b = priv->colormap.blue;
     }
     else
     {
@@ -360,7 +343,7 @@ static int32_t metal(int32_t i)
     return ((r << 16) | (g << 8) | b | k);
 }
 
-static int32_t layers(int32_t i)
+static int32_t layers(BlurskPrivate *priv, int32_t i)
 {
     int32_t k;
 
@@ -382,20 +365,20 @@ static int32_t layers(int32_t i)
     }
 
     /* set this color */
-    return (((int32_t)(i * red / 256) << 16)
-        | ((int32_t)(i * green / 256) << 8)
-        | ((int32_t)(i * blue / 256))
+    return (((int32_t)(i * priv->colormap.red / 256) << 16)
+        | ((int32_t)(i * priv->colormap.green / 256) << 8)
+        | ((int32_t)(i * priv->colormap.blue / 256))
         | (k << 26));
 }
 
-static int32_t colorlayers(int32_t i)
+static int32_t colorlayers(BlurskPrivate *priv, int32_t i)
 {
     int32_t tmp, r, g, b, k;
 
     /* shift the hue */
-    r = red;
-    g = green;
-    b = blue;
+    r = priv->colormap.red;
+    g = priv->colormap.green;
+    b = priv->colormap.blue;
     switch (i & 0xc0)
     {
       case 0x00:
@@ -437,14 +420,14 @@ static int32_t colorlayers(int32_t i)
         | k << 26);
 }
 
-static int32_t colorstandoff(int32_t i)
+static int32_t colorstandoff(BlurskPrivate *priv, int32_t i)
 {
     int32_t tmp, r, g, b, k;
 
     /* shift the hue */
-    r = red;
-    g = green;
-    b = blue;
+    r = priv->colormap.red;
+    g = priv->colormap.green;
+    b = priv->colormap.blue;
     switch (i & 0xc0)
     {
       case 0x00:
@@ -485,13 +468,13 @@ static int32_t colorstandoff(int32_t i)
         | k << 27);
 }
 
-static int32_t flame(int32_t i)
+static int32_t flame(BlurskPrivate *priv, int32_t i)
 {
     hsv_t   hsv;
     int32_t k;
 
     /* Get the base color */
-    hsv = *rgb_to_hsv(config.color);
+    hsv = rgb_to_hsv(priv->config.color);
 
     /* Change the hue, and maybe brightness, depending on i */
     hsv.hue += (255 - i) / 4;
@@ -510,13 +493,13 @@ static int32_t flame(int32_t i)
     return hsv_to_rgb(&hsv) | (k << 26);
 }
 
-static int32_t rainbow(int32_t i)
+static int32_t rainbow(BlurskPrivate *priv, int32_t i)
 {
     hsv_t   hsv;
     int32_t k;
 
     /* Get the base color */
-    hsv = *rgb_to_hsv(config.color);
+    hsv = rgb_to_hsv(priv->config.color);
 
     /* Change the hue, and maybe brightness, depending on i */
     hsv.hue += 2 * (255 - i);
@@ -534,7 +517,7 @@ static int32_t rainbow(int32_t i)
     return hsv_to_rgb(&hsv) | k;
 }
 
-static int32_t standoff(int32_t i)
+static int32_t standoff(BlurskPrivate *priv, int32_t i)
 {
     int k;
 
@@ -558,22 +541,22 @@ static int32_t standoff(int32_t i)
     }
 
     /* set this color */
-    return (((int32_t)(i * red / 256) << 16)
-        | ((int32_t)(i * green / 256) << 8)
-        | ((int32_t)(i * blue / 256))
+    return (((int32_t)(i * priv->colormap.red / 256) << 16)
+        | ((int32_t)(i * priv->colormap.green / 256) << 8)
+        | ((int32_t)(i * priv->colormap.blue / 256))
         | (k << 24));
 }
 
-static int32_t threshold(int32_t i)
+static int32_t threshold(BlurskPrivate *priv, int32_t i)
 {
     /* always return the base color.  This is only interesting when it
      * is modified via contour lines, or by the standard rule that color
      * 0 is always black.
      */
-    return config.color;
+    return priv->config.color;
 }
 
-static int32_t stripes(int32_t i)
+static int32_t stripes(BlurskPrivate *priv, int32_t i)
 {
     int32_t tmp, k;
 
@@ -599,13 +582,13 @@ static int32_t stripes(int32_t i)
     }
 
     /* set this color */
-    return (((int32_t)(tmp * red / 256) << 16)
-        | ((int32_t)(tmp * green / 256) << 8)
-        | ((int32_t)(tmp * blue / 256))
+    return (((int32_t)(tmp * priv->colormap.red / 256) << 16)
+        | ((int32_t)(tmp * priv->colormap.green / 256) << 8)
+        | ((int32_t)(tmp * priv->colormap.blue / 256))
         | (k << 26));
 }
 
-static int32_t colorstripes(int32_t i)
+static int32_t colorstripes(BlurskPrivate *priv, int32_t i)
 {
     int32_t r, g, b, k, tmp;
     static int32_t brightness[] = {0, 64, 128, 192, 254, 254, 254, 254, 254, 254, 254, 254, 254, 192, 128, 64};
@@ -615,21 +598,21 @@ static int32_t colorstripes(int32_t i)
     switch (i & 0xc0)
     {
       case 0x40:
-        r = (green * tmp + red * (0x3f - tmp)) >> 6;
-        g = (blue * tmp + green * (0x3f - tmp)) >> 6;
-        b = (red * tmp + blue * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
         break;
 
       case 0x80:
-        r = (blue * tmp + green * (0x3f - tmp)) >> 6;
-        g = (red * tmp + blue * (0x3f - tmp)) >> 6;
-        b = (green * tmp + red * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
         break;
 
       default:
-        r = (red * tmp + blue * (0x3f - tmp)) >> 6;
-        g = (green * tmp + red * (0x3f - tmp)) >> 6;
-        b = (blue * tmp + green * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
     }
 
     /* compute the brightness and k */
@@ -655,7 +638,7 @@ static int32_t colorstripes(int32_t i)
         | (k << 26));
 }
 
-static int32_t colorbands(int32_t i)
+static int32_t colorbands(BlurskPrivate *priv, int32_t i)
 {
     int32_t r, g, b, k, tmp;
 
@@ -664,21 +647,21 @@ static int32_t colorbands(int32_t i)
     switch (i & 0xc0)
     {
       case 0x40:
-        r = (green * tmp + red * (0x3f - tmp)) >> 6;
-        g = (blue * tmp + green * (0x3f - tmp)) >> 6;
-        b = (red * tmp + blue * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
         break;
 
       case 0x80:
-        r = (blue * tmp + green * (0x3f - tmp)) >> 6;
-        g = (red * tmp + blue * (0x3f - tmp)) >> 6;
-        b = (green * tmp + red * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
         break;
 
       default:
-        r = (red * tmp + blue * (0x3f - tmp)) >> 6;
-        g = (green * tmp + red * (0x3f - tmp)) >> 6;
-        b = (blue * tmp + green * (0x3f - tmp)) >> 6;
+        r = (priv->colormap.red * tmp + priv->colormap.blue * (0x3f - tmp)) >> 6;
+        g = (priv->colormap.green * tmp + priv->colormap.red * (0x3f - tmp)) >> 6;
+        b = (priv->colormap.blue * tmp + priv->colormap.green * (0x3f - tmp)) >> 6;
     }
 
     /* compute the brightness & k */
@@ -700,7 +683,7 @@ static int32_t colorbands(int32_t i)
         | (k << 26));
 }
 
-static int32_t graying(int32_t i)
+static int32_t graying(BlurskPrivate *priv, int32_t i)
 {
     int32_t faded, tmp;
 
@@ -708,7 +691,7 @@ static int32_t graying(int32_t i)
      * make it slightly dimmer than the base color, because it seems to
      * look better that way.
      */
-    faded = (red * 4 + green * 5 + blue * 3) / 16;
+    faded = (priv->colormap.red * 4 + priv->colormap.green * 5 + priv->colormap.blue * 3) / 16;
 
     /* colormap is divided into two phases: fading and dimming */
     if (i < 64)
@@ -721,16 +704,16 @@ static int32_t graying(int32_t i)
         /* full brightness, but fading to gray */
         i -= 64;
         tmp = 192 - i;
-        return (((i * red + tmp * faded) / 192) << 16)
-            | (((i * green + tmp * faded) / 192) << 8)
-            | ((i * blue + tmp * faded) / 192);
+        return (((i * priv->colormap.red + tmp * faded) / 192) << 16)
+            | (((i * priv->colormap.green + tmp * faded) / 192) << 8)
+            | ((i * priv->colormap.blue + tmp * faded) / 192);
     }
 }
 
-static int32_t noise(int32_t i)
+static int32_t noise(BlurskPrivate *priv, int32_t i)
 {
-    if (rand_0_to(256) < i)
-        return config.color;
+    if (rand_0_to(priv, 256) < i)
+        return priv->config.color;
     else
         return 0xff000000;
 }
@@ -739,7 +722,7 @@ static int32_t noise(int32_t i)
 static struct colorstyles
 {
     char     *name;
-    int32_t (*func)(int32_t);
+    int32_t (*func)(BlurskPrivate *priv, int32_t i);
     int good_for_bump;
 } colorstyles[17] =
 {
@@ -765,12 +748,12 @@ static struct colorstyles
 /* Compute the color of a single cell in the colormap.  This uses (*stylefunc)()
  * and also checks the other relevant options.
  */
-static int32_t cell(int i)
+static int32_t cell(BlurskPrivate *priv, int i)
 {
     int32_t c;
 
     /* The white_signal option forces color 255 to be white */
-    if (i == 255 && *config.signal_color == 'W')
+    if (i == 255 && *priv->config.signal_color == 'W')
         return 0x00ffffff;
 
     /* The last three cells are always the background color */
@@ -781,7 +764,7 @@ static int32_t cell(int i)
      * better if we also have a half-white/half-colored value on
      * either side of it; notice the tricky way we accomplish that.
      */
-    if (config.contour_lines)
+    if (priv->config.contour_lines)
     {
         switch ((i + 8) & 0x1f)
         {
@@ -796,73 +779,73 @@ static int32_t cell(int i)
           case 0x02:
           case 0x1d:
             /* mixed white & computed color*/
-            c = (*stylefunc)(i);
+            c = (*priv->colormap.stylefunc)(priv, i);
             c = (((c & 0xfefefe) + 0xfefefe) / 2);
             break;
 
           default:
             /* Just compute the color */
-            c = (*stylefunc)(i);
+            c = (*priv->colormap.stylefunc)(priv, i);
         }
     }
     else
-        c = (*stylefunc)(i);
+        c = (*priv->colormap.stylefunc)(priv, i);
 
     /* Return the color */
     return c;
 }
 
-static void choosebg(int do_random)
+static void choosebg(BlurskPrivate *priv, int do_random)
 {
     /* "Random", then choose a background */
     if (do_random)
     {
-        if (!strncmp(config.background, "Random", 6))
-            bgletter = "BWDSCF"[rand_0_to(6)];
+        if (!strncmp(priv->config.background, "Random", 6))
+            priv->colormap.bgletter = "BWDSCF"[rand_0_to(priv, 6)];
         else
-            bgletter = *config.background;
+            priv->colormap.bgletter = *priv->config.background;
     }
 
     /* Choose new background color.  Note that we don't handle
      * "Flash bkgnd" here.
      */
-    switch (bgletter)
+    switch (priv->colormap.bgletter)
     {
       case 'W': /* White bkgnd */
-        tored = togreen = toblue = 230;
+        priv->colormap.tored = priv->colormap.togreen = priv->colormap.toblue = 230;
         break;
 
       case 'D': /* Dark bkgnd */
-        tored = red / 2;
-        togreen = green / 2;
-        toblue = blue / 2;
+        priv->colormap.tored = priv->colormap.red / 2;
+        priv->colormap.togreen = priv->colormap.green / 2;
+        priv->colormap.toblue = priv->colormap.blue / 2;
         break;
 
       case 'S': /* Shift bkgnd */
-        tored = blue;
-        togreen = red;
-        toblue = green;
+        priv->colormap.tored = priv->colormap.blue;
+        priv->colormap.togreen = priv->colormap.red;
+        priv->colormap.toblue = priv->colormap.green;
         break;
 
       case 'C': /* Color bkgnd */
         if (do_random)
         {
-            tored = rand_0_to(255);
-            togreen = rand_0_to(255);
-            toblue = rand_0_to(255);
+            priv->colormap.tored = rand_0_to(priv, 255);
+            priv->colormap.togreen = rand_0_to(priv, 255);
+            priv->colormap.toblue = rand_0_to(priv, 255);
         }
         else
         {
-            tored = fromred;
-            togreen = fromgreen;
-            toblue = fromblue;
+            priv->colormap.tored = priv->colormap.fromred;
+            priv->colormap.togreen = priv->colormap.fromgreen;
+            priv->colormap.toblue = priv->colormap.fromblue;
         }
         break;
 
       default: /* Black bkgnd, and also fake Flash bkgnd */
-        tored = togreen = toblue = 0;
+        priv->colormap.tored = priv->colormap.togreen = priv->colormap.toblue = 0;
     }
-    tonew = TRUE;
+    priv->colormap.tonew = TRUE;
 }
 
 
@@ -886,34 +869,34 @@ void color_transition(
     if (from == scale)
     {
         /* Previous transition must be complete, I guess */
-        fromred = tored;
-        fromgreen = togreen;
-        fromblue = toblue;
+        priv->colormap.fromred = priv->colormap.tored;
+        priv->colormap.fromgreen = priv->colormap.togreen;
+        priv->colormap.fromblue = priv->colormap.toblue;
 
-        choosebg(TRUE);
+        choosebg(priv, TRUE);
     }
 
     /* Do the background color transition */
     if (to <= 0)
     {
-        bgred = tored;
-        bggreen = togreen;
-        bgblue = toblue;
+        priv->colormap.bgred = priv->colormap.tored;
+        priv->colormap.bggreen = priv->colormap.togreen;
+        priv->colormap.bgblue = priv->colormap.toblue;
     }
     else
     {
-        bgred = (tored * (scale - to) + fromred * to) / scale;
-        bggreen = (togreen * (scale - to) + fromgreen * to) / scale;
-        bgblue = (toblue * (scale - to) + fromblue * to) / scale;
+        priv->colormap.bgred = (priv->colormap.tored * (scale - to) + priv->colormap.fromred * to) / scale;
+        priv->colormap.bggreen = (priv->colormap.togreen * (scale - to) + priv->colormap.fromgreen * to) / scale;
+        priv->colormap.bgblue = (priv->colormap.toblue * (scale - to) + priv->colormap.fromblue * to) / scale;
     }
 
     /* if colorstyle isn't "random" then do nothing more */
-    if (strcmp(config.color_style, "Random"))
+    if (strcmp(priv->config.color_style, "Random"))
         return;
 
     /* if from==scale then choose a new random color style */
     if (from == scale)
-        stylefunc = colorstyles[rand_0_to(QTY(colorstyles))].func;
+        priv->colormap.stylefunc = colorstyles[rand_0_to(priv, QTY(colorstyles))].func;
 
     /* scale the numbers to match the size of the color table */
     from = from * 255 / scale;
@@ -922,13 +905,13 @@ void color_transition(
     /* recompute ONLY the affected cells */
     for (; from > to; from--)
     {
-        colors[from] = cell(from);
-        if(visual_color_from_uint32(&priv->pal.colors[from], colors[from]) < 0)
+        priv->colormap.colors[from] = cell(priv, from);
+        if(visual_color_from_uint32(&priv->pal.colors[from], priv->colormap.colors[from]) < 0)
             return;
     }
 
     /* Adjust the background, and then activate the new colormap.  */
-    tonew = TRUE;
+    priv->colormap.tonew = TRUE;
     color_bg(priv, 0, NULL);
 
     /* Remember the lower bound of the transition.  Other color changes
@@ -937,7 +920,7 @@ void color_transition(
      * hue or contour change will be effected for the remaining color
      * cells as a natural consequence of the transition.)
      */
-    transition_bound = to;
+    priv->colormap.transitionbound = to;
 }
 
 
@@ -950,53 +933,83 @@ void color_genmap(BlurskPrivate *priv, int do_random)
     int32_t i;
 
     /* Decompose the dominant color into R/G/B components */
-    red = (int32_t)(config.color / 0x10000);
-    green = (int32_t)((config.color % 0x10000)/0x100);
-    blue = (int32_t)(config.color % 0x100);
+    priv->colormap.red = (int32_t)(priv->config.color / 0x10000);
+    priv->colormap.green = (int32_t)((priv->config.color % 0x10000)/0x100);
+    priv->colormap.blue = (int32_t)(priv->config.color % 0x100);
 
     /* Choose a new background, if appropriate */
-    choosebg(do_random);
-    bgred = fromred = tored;
-    bggreen = fromgreen = togreen;
-    bgblue = fromblue = toblue;
-    tonew = TRUE;
+    choosebg(priv, do_random);
+    priv->colormap.bgred = priv->colormap.fromred = priv->colormap.tored;
+    priv->colormap.bggreen = priv->colormap.fromgreen = priv->colormap.togreen;
+    priv->colormap.bgblue = priv->colormap.fromblue = priv->colormap.toblue;
+    priv->colormap.tonew = TRUE;
 
     /* Find the name in the colorstyles[] table */
-    if ((do_random || !stylefunc) && !strcmp(config.color_style, "Random"))
+    if ((do_random || !priv->colormap.stylefunc) && !strcmp(priv->config.color_style, "Random"))
     {
         /* Choose a "Random" colorstyle */
-        stylefunc = colorstyles[rand_0_to(QTY(colorstyles))].func;
+        priv->colormap.stylefunc = colorstyles[rand_0_to(priv, QTY(colorstyles))].func;
     }
-    else if (!stylefunc || strcmp(config.color_style, "Random"))
+    else if (!priv->colormap.stylefunc || strcmp(priv->config.color_style, "Random"))
     {
         /* Use the named colorstyle */
         for (i = 0;
              i < QTY(colorstyles)
-            && strcmp(colorstyles[i].name, config.color_style);
+            && strcmp(colorstyles[i].name, priv->config.color_style);
              i++)
         {
         }
         if (i >= QTY(colorstyles))
             i = 0;
-        stylefunc = colorstyles[i].func;
+        priv->colormap.stylefunc = colorstyles[i].func;
 
         /* Transitions only affect "Random" colorstyle, not this one */
-        transition_bound = 0;
+        priv->colormap.transitionbound = 0;
     }
 
     /* Generate the basic colormap */
-    for (i = 255; i >= transition_bound; i--)
+    for (i = 255; i >= priv->colormap.transitionbound; i--)
     {
-        colors[i] = cell(i);
-        if(visual_color_from_uint32(&priv->pal.colors[i], colors[i]) < 0)
+        priv->colormap.colors[i] = cell(priv, i);
+        if(visual_color_from_uint32(&priv->pal.colors[i], priv->colormap.colors[i]) < 0)
             return;
     }
 
     /* Adjust the background, and then activate the new colormap.  */
-    tonew = TRUE;
+    priv->colormap.tonew = TRUE;
     color_bg(priv, 0, NULL);
 }
 
+#if defined(__x86_64__) && defined(__GNUC__)
+/* The blending loop of color_bg(), four cells at a time.  The background
+ * components must be in 0..255, so that every product with a brightness fits
+ * in 16 bits and pmullw on the 32-bit lanes gives the exact product.
+ */
+static void blend_bg_sse2(uint32_t *dst, uint32_t *src, int32_t bgr, int32_t bgg, int32_t bgb)
+{
+    __m128i r = _mm_set1_epi32(bgr);
+    __m128i g = _mm_set1_epi32(bgg);
+    __m128i b = _mm_set1_epi32(bgb);
+    __m128i rmask = _mm_set1_epi32(0x00ff0000);
+    __m128i gmask = _mm_set1_epi32(0x0000ff00);
+    __m128i bmask = _mm_set1_epi32(0x000000ff);
+    __m128i c, k, bg;
+    int i;
+
+    for (i = 0; i < 256; i += 4)
+    {
+        c = _mm_loadu_si128((__m128i *)&src[i]);
+        k = _mm_srli_epi32(c, 24);
+
+        bg = _mm_and_si128(_mm_slli_epi32(_mm_mullo_epi16(k, r), 8), rmask);
+        bg = _mm_or_si128(bg, _mm_and_si128(_mm_mullo_epi16(k, g), gmask));
+        bg = _mm_or_si128(bg, _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi16(k, b), 8), bmask));
+
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_add_epi32(c, bg));
+    }
+}
+#endif
+
 /* This function is called once for each frame, before the frame's image is
  * output.  It adjusts the colormap's background color in response to the music.
  */
@@ -1006,34 +1019,33 @@ void color_bg(BlurskPrivate *priv, int ndata, int16_t *data)
     int i, j;
     int16_t max, min;
     int32_t totdelta;
-    int32_t newcolors[256];
-    static int32_t fallr, fallg, fallb;
+    uint32_t newcolors[256];
 
     /* if we aren't doing "Flash bkgnd" and we've reached our final color,
      * then do nothing
      */
-    if (bgletter != 'F'
-     && bgred == tored && bggreen == togreen && bgblue == toblue)
+    if (priv->colormap.bgletter != 'F'
+     && priv->colormap.bgred == priv->colormap.tored && priv->colormap.bggreen == priv->colormap.togreen && priv->colormap.bgblue == priv->colormap.toblue)
     {
-        if (!tonew)
+        if (!priv->colormap.tonew)
             return;
-        tonew = FALSE;
+        priv->colormap.tonew = FALSE;
     }
 
     /* force colors[0] to be the background color */
-    colors[0] = 0xff000000;
+    priv->colormap.colors[0] = 0xff000000;
 
     /* compute the RGB background color, based on data */
-    if (bgletter != 'F' || ndata == 0)
+    if (priv->colormap.bgletter != 'F' || ndata == 0)
     {
         /* Use the transition colors */
-        bgr = bgred;
-        bgg = bggreen;
-        bgb = bgblue;
+        bgr = priv->colormap.bgred;
+        bgg = priv->colormap.bggreen;
+        bgb = priv->colormap.bgblue;
     }
     else /* "Flash bkgnd" */
     {
-        if (nspectrums == 0)
+        if (priv->nspectrums == 0)
         {
             /* data is samples */
 
@@ -1066,7 +1078,7 @@ void color_bg(BlurskPrivate *priv, int ndata, int16_t *data)
              * suffers from being backward -- which looks cool
              * in a graph, but would hurt us here.
              */
-            if (nspectrums == 2)
+            if (priv->nspectrums == 2)
                 ndata /= 2, data += ndata;
 
             /* the lower frequencies are used for red, middle
@@ -1095,9 +1107,9 @@ void color_bg(BlurskPrivate *priv, int ndata, int16_t *data)
         /* during transition from colored to flash, we never want to
          * be darker than the old color.
          */
-        if (bgr < bgred) bgr = bgred;
-        if (bgg < bggreen) bgg = bggreen;
-        if (bgb < bgblue) bgb = bgblue;
+        if (bgr < priv->colormap.bgred) bgr = priv->colormap.bgred;
+        if (bgg < priv->colormap.bggreen) bgg = priv->colormap.bggreen;
+        if (bgb < priv->colormap.bgblue) bgb = priv->colormap.bgblue;
 
         /* clamp the background color values to be within 0...255.  Also
          * try to avoid dark gray backgrounds by ignoring values < 30
@@ -1110,26 +1122,31 @@ void color_bg(BlurskPrivate *priv, int ndata, int16_t *data)
         else if (bgb > 255) bgb = 255;
 
         /* limit the fall-off speed */
-        if (bgr < fallr)
-            bgr = fallr;
-        fallr = bgr - ((bgr + 15) >> 4);
-        if (bgg < fallg)
-            bgg = fallg;
-        fallg = bgg - ((bgg + 15) >> 4);
-        if (bgb < fallb)
-            bgb = fallb;
-        fallb = bgb - ((bgb + 15) >> 4);
+        if (bgr < priv->colormap.fallr)
+            bgr = priv->colormap.fallr;
+        priv->colormap.fallr = bgr - ((bgr + 15) >> 4);
+        if (bgg < priv->colormap.fallg)
+            bgg = priv->colormap.fallg;
+        priv->colormap.fallg = bgg - ((bgg + 15) >> 4);
+        if (bgb < priv->colormap.fallb)
+            bgb = priv->colormap.fallb;
+        priv->colormap.fallb = bgb - ((bgb + 15) >> 4);
     }
 
     /* build a new colormap, derived from the black-background one */
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (visual_cpu_get_sse2()
+     && bgr >= 0 && bgr <= 255 && bgg >= 0 && bgg <= 255 && bgb >= 0 && bgb <= 255)
+        blend_bg_sse2(newcolors, priv->colormap.colors, bgr, bgg, bgb);
+    else
+#endif
     for (i = 0; i < 256; i++)
     {
         /* extract the bg brightness.  If 0, then copy unchanged */
-        k = (colors[i] >> 24) & 0xff;
+        k = (priv->colormap.colors[i] >> 24) & 0xff;
         if (k == 0)
         {
-            newcolors[i] = colors[i];
-                    visual_color_from_uint32(&priv->pal.colors[i], newcolors[i]);
+            newcolors[i] = priv->colormap.colors[i];
             continue;
         }
 
@@ -1137,9 +1154,11 @@ void color_bg(BlurskPrivate *priv, int ndata, int16_t *data)
         bg = (((bgr * k) << 8) & 0x00ff0000)
            | ( (bgg * k)       & 0x0000ff00)
            | (((bgb * k) >> 8) & 0x000000ff);
-        newcolors[i] = colors[i] + bg;
-                visual_color_from_uint32(&priv->pal.colors[i], newcolors[i]);
+        newcolors[i] = priv->colormap.colors[i] + bg;
     }
+
+    for (i = 0; i < 256; i++)
+        visual_color_from_uint32(&priv->pal.colors[i], newcolors[i]);
 }
 
 
@@ -1192,15 +1211,15 @@ void color_beat(BlurskPrivate *priv)
     hsv_t   hsv;
 
     /* if hue_on_beats isn't set, then do nothing */
-    if (!config.hue_on_beats)
+    if (!priv->config.hue_on_beats)
         return;
 
     /* Compute a new base color.  Tell the config window about it. */
-    hsv = *rgb_to_hsv(config.color);
+    hsv = rgb_to_hsv(priv->config.color);
     hsv.hue += 60.0;
     if (hsv.hue > 360.0)
         hsv.hue -= 360.0;
-    config.color = hsv_to_rgb(&hsv);
+    priv->config.color = hsv_to_rgb(&hsv);
 
     /* regenerate color map */
     color_genmap(priv, FALSE);
@@ -121,12 +121,14 @@ void config_default(BlurskConfig *conf)
  */
 void config_string_genstring(BlurskPrivate *priv)
 {
-    char *string = paste_genstring();
+    char string[100];
 
     VisParamContainer *paramcontainer = visual_plugin_get_params(priv->plugin);
 
     VisParamEntry *param = visual_param_container_get(paramcontainer, "config_string");
 
+    paste_genstring(&priv->config, string);
+
     /* don't set if it has already been set */
     if(strcmp(string, visual_param_entry_get_string(param)) != 0)
         visual_param_entry_set_string(param, string);
@@ -234,7 +236,7 @@ static void _change_config_string(BlurskPrivate *priv, char **string, VisParamEn
 
     if(!validator || validator(visual_param_entry_get_string(p)))
     {
-        BlurskConfig *c;
+        BlurskConfig c;
 
         /* free previous string? */
         if(*string)
@@ -242,11 +244,12 @@ static void _change_config_string(BlurskPrivate *priv, char **string, VisParamEn
 
         *string = visual_strdup(visual_param_entry_get_string(p));
 
-        /* parse the string */
-        c = paste_parsestring(*string);
+        /* parse the string, starting from the current configuration */
+        c = priv->config;
+        paste_parsestring(&c, *string);
 
         /* use this configuration */
-        _config_load_preset(priv, c);
+        _config_load_preset(priv, &c);
 
     }
     /* reset to previous value */
@@ -259,13 +262,12 @@ static void _change_config_string(BlurskPrivate *priv, char **string, VisParamEn
 /**
  * callback to change a color parameter (called by config_change_param)
  */
-static void _change_color(BlurskPrivate *priv, uint32_t **color, VisParamEntry *p, int *(validator)(void *value))
+static void _change_color(BlurskPrivate *priv, uint32_t *color, VisParamEntry *p, int *(validator)(void *value))
 {
     VisColor *c;
 
     c = visual_param_entry_get_color(p);
-    *color = 0;
-    *color = (uint32_t *) (intptr_t)(((c->r)<<16) + ((c->g)<<8) + c->b);
+    *color = ((c->r)<<16) + ((c->g)<<8) + c->b;
     priv->update_config_string = 1;
 }
 
@@ -296,28 +298,28 @@ static void _change_string(BlurskPrivate *priv, char **string,
 /**
  * callback to change a bool parameter (called by config_change_param)
  */
-static void _change_bool(BlurskPrivate *priv, int **boolean, VisParamEntry *p, int *(validator)(void *value))
+static void _change_bool(BlurskPrivate *priv, int *boolean, VisParamEntry *p, int *(validator)(void *value))
 {
     int t = visual_param_entry_get_integer(p);
 
     /* validate boolean */
     if(t == 0 || t == 1)
     {
-        *boolean = (int *) (intptr_t)t;
+        *boolean = t;
 
         priv->update_config_string = 1;
     }
     /* reset to previous value */
     else
-        visual_param_entry_set_integer(p, **boolean);
+        visual_param_entry_set_integer(p, *boolean);
 }
 
 /**
  * callback to change an integer parameter (called by config_change_param)
  */
-static void _change_int(BlurskPrivate *priv, int **integer, VisParamEntry *p, int *(validator)(void *value))
+static void _change_int(BlurskPrivate *priv, int *integer, VisParamEntry *p, int *(validator)(void *value))
 {
-    *integer = (int *) (intptr_t)visual_param_entry_get_integer(p);
+    *integer = visual_param_entry_get_integer(p);
 
     priv->update_config_string = 1;
 }
@@ -647,30 +649,30 @@ void config_change_param(BlurskPrivate *priv, VisParamEntry *p)
         void (*postchange)(BlurskPrivate *priv);
     } parms[] =
     {
-        {"color", &config.color, NULL, (void *) _change_color, __color_genmap},
-        {"color_style", &config.color_style, (void *) _color_style_validate, (void *) _change_string, __color_genmap},
-        {"signal_color", &config.signal_color, (void *) _color_signal_validate, (void *) _change_string, NULL},
-        {"contour_lines", &config.contour_lines, NULL, (void *) _change_bool, NULL},
-        {"hue_on_beats", &config.hue_on_beats, NULL, (void *) _change_bool, NULL},
-        {"slow_motion", &config.slow_motion, NULL, (void *) _change_bool, NULL},
-        {"thick_on_beats", &config.thick_on_beats, NULL, (void *) _change_bool, NULL},
-        {"background", &config.background, (void *) _color_background_validate, (void *) _change_string, NULL},
-        {"blur_style", &config.blur_style, (void *) _blur_style_validate, (void *) _change_string, NULL},
-        {"transition_speed", &config.transition_speed, (void *) _blur_transition_speed_validate, (void *) _change_string, NULL},
-        {"blur_when", &config.blur_when, (void *) _blur_when_validate, (void *) _change_string, NULL},
-        {"blur_stencil", &config.blur_stencil, NULL, (void *) _change_string, NULL},
-        {"fade_speed", &config.fade_speed, (void *) _fade_speed_validate, (void *) _change_string, NULL},
-        {"signal_style", &config.signal_style, (void *) _signal_style_validate, (void *) _change_string, NULL},
-        {"plot_style", &config.plot_style, (void *) _plot_style_validate, (void *) _change_string, NULL},
-        {"flash_style", &config.flash_style, (void *) _flash_style_validate, (void *) _change_string, NULL},
-        {"overall_effect", &config.overall_effect, (void *) _overall_effect_validate, (void *) _change_string, NULL},
-        {"floaters", &config.floaters, (void *) _floaters_validate, (void *) _change_string, NULL},
-        {"cpu_speed", &config.cpu_speed, (void *) _cpu_speed_validate, (void *) _change_string, NULL},
-        {"beat_sensitivity", &config.beat_sensitivity, NULL, (void *) _change_int, NULL},
-        {"config_string", &config.config_string, NULL, (void *) _change_config_string, NULL},
-        {"show_info", &config.show_info, (void *) _show_info_validate, (void *) _change_string, NULL},
-        {"info_timeout", &config.info_timeout, NULL, (void *) _change_int, NULL},
-        {"show_timestamp", &config.show_timestamp, NULL, (void *) _change_bool, NULL}
+        {"color", &priv->config.color, NULL, (void *) _change_color, __color_genmap},
+        {"color_style", &priv->config.color_style, (void *) _color_style_validate, (void *) _change_string, __color_genmap},
+        {"signal_color", &priv->config.signal_color, (void *) _color_signal_validate, (void *) _change_string, NULL},
+        {"contour_lines", &priv->config.contour_lines, NULL, (void *) _change_bool, NULL},
+        {"hue_on_beats", &priv->config.hue_on_beats, NULL, (void *) _change_bool, NULL},
+        {"slow_motion", &priv->config.slow_motion, NULL, (void *) _change_bool, NULL},
+        {"thick_on_beats", &priv->config.thick_on_beats, NULL, (void *) _change_bool, NULL},
+        {"background", &priv->config.background, (void *) _color_background_validate, (void *) _change_string, NULL},
+        {"blur_style", &priv->config.blur_style, (void *) _blur_style_validate, (void *) _change_string, NULL},
+        {"transition_speed", &priv->config.transition_speed, (void *) _blur_transition_speed_validate, (void *) _change_string, NULL},
+        {"blur_when", &priv->config.blur_when, (void *) _blur_when_validate, (void *) _change_string, NULL},
+        {"blur_stencil", &priv->config.blur_stencil, NULL, (void *) _change_string, NULL},
+        {"fade_speed", &priv->config.fade_speed, (void *) _fade_speed_validate, (void *) _change_string, NULL},
+        {"signal_style", &priv->config.signal_style, (void *) _signal_style_validate, (void *) _change_string, NULL},
+        {"plot_style", &priv->config.plot_style, (void *) _plot_style_validate, (void *) _change_string, NULL},
+        {"flash_style", &priv->config.flash_style, (void *) _flash_style_validate, (void *) _change_string, NULL},
+        {"overall_effect", &priv->config.overall_effect, (void *) _overall_effect_validate, (void *) _change_string, NULL},
+        {"floaters", &priv->config.floaters, (void *) _floaters_validate, (void *) _change_string, NULL},
+        {"cpu_speed", &priv->config.cpu_speed, (void *) _cpu_speed_validate, (void *) _change_string, NULL},
+        {"beat_sensitivity", &priv->config.beat_sensitivity, NULL, (void *) _change_int, NULL},
+        {"config_string", &priv->config.config_string, NULL, (void *) _change_config_string, NULL},
+        {"show_info", &priv->config.show_info, (void *) _show_info_validate, (void *) _change_string, NULL},
+        {"info_timeout", &priv->config.info_timeout, NULL, (void *) _change_int, NULL},
+        {"show_timestamp", &priv->config.show_timestamp, NULL, (void *) _change_bool, NULL}
     };
 
 
@@ -55,15 +55,8 @@
 #define BEAD_THRESHOLD  15000
 
 
-/* Some of the plotting functions interpolate to generate extra data points.
- * The data points are stored here when that happens.
- */
-#define MAXPOINTS   512
-static int16_t  renderdata[MAXPOINTS];
-
-
 /* Draw a line between two points, in a given color */
-static void line(int x, int y, int x2, int y2, unsigned char color)
+static void line(BlurskPrivate *priv, int x, int y, int x2, int y2, unsigned char color)
 {
     int xdiff, ydiff;
     int error;
@@ -84,29 +77,29 @@ static void line(int x, int y, int x2, int y2, unsigned char color)
     xdiff = x2 - x;
 
     /* skip if either endpoint is offscreen */
-    if (x < 0 || x2 >= img_width)
+    if (x < 0 || x2 >= priv->img.width)
         return;
 
     /* Moving upward or downward? */
     if(y < y2)
     {
         /* downward */
-        if (y < 0 || y2 >= img_height - 1)
+        if (y < 0 || y2 >= priv->img.height - 1)
             return;
-        bpl = img_bpl;
+        bpl = priv->img.bpl;
         ydiff = y2 - y;
     }
     else
     {
         /* upward */
-        if (y2 < 0 || y >= img_height - 1)
+        if (y2 < 0 || y >= priv->img.height - 1)
             return;
-        bpl = -img_bpl;
+        bpl = -priv->img.bpl;
         ydiff = y - y2;
     }
 
     /* locate the starting point */
-    point = &IMG_PIXEL(x, y);
+    point = &IMG_PIXEL(priv, x, y);
 
     /* different line strategy, depending on slope */
     if (xdiff == 0)
@@ -156,20 +149,20 @@ static void line(int x, int y, int x2, int y2, unsigned char color)
                 else \
                     *(ptr) = 255;
 
-static void fuzzydot(int x, int y, int add)
+static void fuzzydot(BlurskPrivate *priv, int x, int y, int add)
 {
     int xx, yy;
     int sum;
     unsigned char   *point;
 
     /* if too near the edge, then skip it */
-    if (x < 5 || x >= img_width - 5 || y < 5 || y >= img_height - 5)
+    if (x < 5 || x >= priv->img.width - 5 || y < 5 || y >= priv->img.height - 5)
         return;
 
     /* For each point in the dot... */
     for (yy = -4; yy <= 4; yy++)
     {
-        for (xx = -4, point = &IMG_PIXEL(x + xx, y + yy);
+        for (xx = -4, point = &IMG_PIXEL(priv, x + xx, y + yy);
              xx <= 4;
              xx++, point++)
         {
@@ -183,7 +176,7 @@ static void fuzzydot(int x, int y, int add)
     }
 }
 
-static void plussign(int x, int y, int add)
+static void plussign(BlurskPrivate *priv, int x, int y, int add)
 {
     int extent, i;
     unsigned char   *point;
@@ -192,36 +185,36 @@ static void plussign(int x, int y, int add)
     extent = add / 4;
 
     /* if too close to edge, then skip it */
-    if (x < extent || x >= img_width - extent || y < extent || y >= img_height - extent)
+    if (x < extent || x >= priv->img.width - extent || y < extent || y >= priv->img.height - extent)
         return;
     extent -= 1; /* <-- for safety */
 
     /* Plot the center of the + sign */
-    point = &IMG_PIXEL(x, y);
+    point = &IMG_PIXEL(priv, x, y);
     addclipped(point, add);
     add -= 4;
 
     /* fill in the corners */
-    addclipped(point - img_bpl - 1, add);
-    addclipped(point - img_bpl + 1, add);
-    addclipped(point + img_bpl - 1, add);
-    addclipped(point + img_bpl + 1, add);
+    addclipped(point - priv->img.bpl - 1, add);
+    addclipped(point - priv->img.bpl + 1, add);
+    addclipped(point + priv->img.bpl - 1, add);
+    addclipped(point + priv->img.bpl + 1, add);
     
     /* Plot the surrounding points */
     for (i = 1; i <= extent; i++, add -= 4)
     {
-        point = &IMG_PIXEL(x - i, y);
+        point = &IMG_PIXEL(priv, x - i, y);
         addclipped(point, add);
-        point = &IMG_PIXEL(x + i, y);
+        point = &IMG_PIXEL(priv, x + i, y);
         addclipped(point, add);
-        point = &IMG_PIXEL(x, y - i);
+        point = &IMG_PIXEL(priv, x, y - i);
         addclipped(point, add);
-        point = &IMG_PIXEL(x, y + i);
+        point = &IMG_PIXEL(priv, x, y + i);
         addclipped(point, add);
     }
 }
 
-void render_dot(int x, int y, unsigned char color)
+void render_dot(BlurskPrivate *priv, int x, int y, unsigned char color)
 {
     int x2, y2;
 
@@ -230,7 +223,7 @@ void render_dot(int x, int y, unsigned char color)
     y -= 2;
 
     /* ignore if outside the image */
-    if (x < 0 || y < 0 || x + 5 >= img_width || y + 5 >= img_height)
+    if (x < 0 || y < 0 || x + 5 >= priv->img.width || y + 5 >= priv->img.height)
         return;
 
     /* draw the dot */
@@ -239,31 +232,31 @@ void render_dot(int x, int y, unsigned char color)
         if (x2 == 0 || x2 == 4)
         {
             for (y2 = 1; y2 <= 3; y2++)
-                IMG_PIXEL(x + x2, y + y2) = color;
+                IMG_PIXEL(priv, x + x2, y + y2) = color;
         }
         else
         {
             for (y2 = 0; y2 <= 4; y2++)
-                IMG_PIXEL(x + x2, y + y2) = color;
+                IMG_PIXEL(priv, x + x2, y + y2) = color;
         }
     }
 }
 
 
-static void airbrush(int x, int y, unsigned char color)
+static void airbrush(BlurskPrivate *priv, int x, int y, unsigned char color)
 {
     static unsigned char bits[] = {0x24,0x12,0x29,0x1a,0x54,0x02,0x10};
     int i, j, bit;
     unsigned char   *pixel;
 
     /* ignore if outside the image */
-    if ((x -= 3) < 0 || (y -= 3) < 0 || x + 6 >= img_width || y + 6 >= img_height)
+    if ((x -= 3) < 0 || (y -= 3) < 0 || x + 6 >= priv->img.width || y + 6 >= priv->img.height)
         return;
 
     /* draw a whole collection of points */
     for (i = 0; i <= 6; i++)
     {
-        pixel = &IMG_PIXEL(x, y + i);
+        pixel = &IMG_PIXEL(priv, x, y + i);
         for (j = 0, bit = 1; j <= 6; j++, bit += bit)
         {
             if (bits[i] & bit)
@@ -273,16 +266,16 @@ static void airbrush(int x, int y, unsigned char color)
     }
 }
 
-static void edges(int x, int y, int thick)
+static void edges(BlurskPrivate *priv, int x, int y, int thick)
 {
     double  frac;   /* X, scaled to be between 0.0 and 1.0 */
     int iw, ih; /* image width & height, minus 20 */
     int color;
 
     /* verify that the image size is big enough for us to work with */
-    if (img_width < 30 || img_height < 30
-        || x < 0 || x >= img_width
-        || y < 0 || y >= img_height)
+    if (priv->img.width < 30 || priv->img.height < 30
+        || x < 0 || x >= priv->img.width
+        || y < 0 || y >= priv->img.height)
         return;
 
     /* x is scaled to width, and y is scaled to height.  We want to derive
@@ -291,10 +284,10 @@ static void edges(int x, int y, int thick)
      *
      * We begin by computing a new color size
      */
-    iw = img_width - 20;
-    ih = img_height - 20;
+    iw = priv->img.width - 20;
+    ih = priv->img.height - 20;
 
-    if (config.thick_on_beats)
+    if (priv->config.thick_on_beats)
         color = (ih - y) * (1600 - 200 * thick) / ih;
     else
         color = (ih - y) * 1300 / ih;
@@ -312,7 +305,7 @@ static void edges(int x, int y, int thick)
      * each segment, "frac" is first scaled to be between 0.0 and 1.0,
      * and then x and y are computed from that.
      */
-    frac = (double)x / (double)img_width * 14.0;
+    frac = (double)x / (double)priv->img.width * 14.0;
     if ((frac -= 2.0) < 0.0)
     {
         frac = frac / -4.0;
@@ -345,155 +338,146 @@ static void edges(int x, int y, int thick)
     }
 
     /* Now we can plot! */
-    render_dot(x, y, color);
+    render_dot(priv, x, y, color);
 }
 
 
-static int plotfirst;
-static int plotthick;
-static unsigned char plotcolor;
-static double plottheta = 0.0;
-static double plotsin, plotcos;
-static double plotprevsin, plotprevcos;
-static int plotcount;
-static int plotmax;
-static int plotx[512], ploty[512];
-static int plotprevmax;
-static int plotprevx[512], plotprevy[512];
-
-static void plotbefore(int thick, int max)
+static void plotbefore(BlurskPrivate *priv, int thick, int max)
 {
-    plotthick = thick;
-    plotfirst = TRUE;
-    plotcount = 0;
-    plotmax = max;
-    if (*config.signal_color != 'C')
-        plotcolor = 255;
-    else if (plotcolor == 255)
-        plotcolor = 76;
+    BlurskRender *r = &priv->render;
+
+    r->plotthick = thick;
+    r->plotfirst = TRUE;
+    r->plotcount = 0;
+    r->plotmax = max;
+    if (*priv->config.signal_color != 'C')
+        r->plotcolor = 255;
+    else if (r->plotcolor == 255)
+        r->plotcolor = 76;
     else
-        plotcolor++;
+        r->plotcolor++;
 }
 
-static void plot(int x, int y)
+static void plot(BlurskPrivate *priv, int x, int y)
 {
-    static int fromx, fromy;
+    BlurskRender *r = &priv->render;
     int i;
 
-    switch (*config.plot_style)
+    switch (*priv->config.plot_style)
     {
       case 'D': /* Dots */
-        render_dot(x, y, plotcolor);
+        render_dot(priv, x, y, r->plotcolor);
         break;
 
       case 'F': /* Fuzzy dots */
-        fuzzydot(x, y, plotthick * 5 + 50);
+        fuzzydot(priv, x, y, r->plotthick * 5 + 50);
         break;
 
       case 'P': /* Plus signs */
-        plussign(x, y, (plotthick + 4) * 6);
+        plussign(priv, x, y, (r->plotthick + 4) * 6);
         break;
 
       case 'A': /* Airbrush */
-        airbrush(x, y, plotcolor);
+        airbrush(priv, x, y, r->plotcolor);
         break;
 
       case 'E': /* Edges */
-        edges(x, y, plotthick);
+        edges(priv, x, y, r->plotthick);
         break;
 
       case 'M': /* Mirrored */
-        if (!plotfirst)
+        if (!r->plotfirst)
         {
-            line(img_width - 1 - fromx, img_height - 1 - fromy, img_width - 1 - x, img_height - 1 - y, plotcolor);
-            if (plotthick >= 2)
-                line(img_width - 1 - fromx, img_height - fromy, img_width - 1 - x, img_height - y, plotcolor);
-            if (plotthick >= 3)
-                line(img_width - fromx, img_height - 1 - fromy, img_width - x, img_height - 1 - y, plotcolor);
+            line(priv, priv->img.width - 1 - r->fromx, priv->img.height - 1 - r->fromy, priv->img.width - 1 - x, priv->img.height - 1 - y, r->plotcolor);
+            if (r->plotthick >= 2)
+                line(priv, priv->img.width - 1 - r->fromx, priv->img.height - r->fromy, priv->img.width - 1 - x, priv->img.height - y, r->plotcolor);
+            if (r->plotthick >= 3)
+                line(priv, priv->img.width - r->fromx, priv->img.height - 1 - r->fromy, priv->img.width - x, priv->img.height - 1 - y, r->plotcolor);
         }
         /* fall through... */
 
       case 'L': /* Line */
-        if (plotfirst)
-            plotfirst = FALSE;
+        if (r->plotfirst)
+            r->plotfirst = FALSE;
         else
         {
-            line(fromx, fromy, x, y, plotcolor);
-            if (plotthick >= 2)
-                line(fromx, fromy - 1, x, y - 1, plotcolor);
-            if (plotthick >= 3)
-                line(fromx - 1, fromy, x - 1, y, plotcolor);
+            line(priv, r->fromx, r->fromy, x, y, r->plotcolor);
+            if (r->plotthick >= 2)
+                line(priv, r->fromx, r->fromy - 1, x, y - 1, r->plotcolor);
+            if (r->plotthick >= 3)
+                line(priv, r->fromx - 1, r->fromy, x - 1, y, r->plotcolor);
         }
-        fromx = x;
-        fromy = y;
+        r->fromx = x;
+        r->fromy = y;
         break;
 
       case 'S': /* Starburst */
-        line(img_width / 2, img_height / 2, x, y, plotcolor);
+        line(priv, priv->img.width / 2, priv->img.height / 2, x, y, r->plotcolor);
         break;
 
       case 'R': /* Radar */
-        x = img_width + 10 - x;
-        y = (img_height - 10 - y) * 450 / img_height;
+        x = priv->img.width + 10 - x;
+        y = (priv->img.height - 10 - y) * 450 / priv->img.height;
         if (y > 255)
             y = 255;
         else if (y < 0)
             y = 0;
-        line((int)(x * plotcos) + img_width/2,
-             (int)(x * plotsin) + img_height/2,
-             (int)(x * plotprevcos) + img_width/2,
-             (int)(x * plotprevsin) + img_height/2,
+        line(priv, (int)(x * r->plotcos) + priv->img.width/2,
+             (int)(x * r->plotsin) + priv->img.height/2,
+             (int)(x * r->plotprevcos) + priv->img.width/2,
+             (int)(x * r->plotprevsin) + priv->img.height/2,
              y);
         break;
 
       case 'I': /* Inertia */
-        plotx[plotcount] = x;
-        ploty[plotcount] = y;
-        i = (plotcount * plotprevmax) / plotmax;
-        plotcount++;
-        line(plotprevx[i], plotprevy[i], x, y, plotcolor);
-        if (plotthick >= 2)
-            line(plotprevx[i], plotprevy[i]-1, x, y-1, plotcolor);
-        if (plotthick >= 3)
-            line(plotprevx[i]-1, plotprevy[i], x-1, y, plotcolor);
+        r->plotx[r->plotcount] = x;
+        r->ploty[r->plotcount] = y;
+        i = (r->plotcount * r->plotprevmax) / r->plotmax;
+        r->plotcount++;
+        line(priv, r->plotprevx[i], r->plotprevy[i], x, y, r->plotcolor);
+        if (r->plotthick >= 2)
+            line(priv, r->plotprevx[i], r->plotprevy[i]-1, x, y-1, r->plotcolor);
+        if (r->plotthick >= 3)
+            line(priv, r->plotprevx[i]-1, r->plotprevy[i], x-1, y, r->plotcolor);
         break;
     }
 }
 
-static void plotafter(void)
+static void plotafter(BlurskPrivate *priv)
 {
+    BlurskRender *r = &priv->render;
     int     i, j;
     int x, y;
 
     /* For "Radar", compute the plotsin & plotcos for the next wedge. */
-    if (*config.plot_style == 'R')
+    if (*priv->config.plot_style == 'R')
     {
-        plotprevsin = plotsin;
-        plotprevcos = plotcos;
-        plottheta = plottheta + 0.1;
-        if (plottheta > 2 * VISUAL_MATH_PI)
-            plottheta -= 2 * VISUAL_MATH_PI;
-        plotsin = (sin(plottheta) * (double)img_height) / (2.1 * (double)img_width);
-        plotcos = cos(plottheta) / 2.1;
+        r->plotprevsin = r->plotsin;
+        r->plotprevcos = r->plotcos;
+        r->plottheta = r->plottheta + 0.1;
+        if (r->plottheta > 2 * VISUAL_MATH_PI)
+            r->plottheta -= 2 * VISUAL_MATH_PI;
+        r->plotsin = (sin(r->plottheta) * (double)priv->img.height) / (2.1 * (double)priv->img.width);
+        r->plotcos = cos(r->plottheta) / 2.1;
     }
 
     /* For "Inertia", compute new plotprevx & plotprevy values */
-    if (*config.plot_style == 'I')
+    if (*priv->config.plot_style == 'I')
     {
-        for (i = 0; i < plotmax; i++)
+        for (i = 0; i < r->plotmax; i++)
         {
-            j = (i * plotprevmax) / plotmax;
-            x = (plotx[i] + 7 * plotprevx[j] + 4) >> 3;
-            y = (ploty[i] + 7 * plotprevy[j] + 4) >> 3;
-            if (abs(x - plotx[i]) > 4 || abs(y - ploty[i]) > 4)
+            j = (i * r->plotprevmax) / r->plotmax;
+            x = (r->plotx[i] + 7 * r->plotprevx[j] + 4) >> 3;
+            y = (r->ploty[i] + 7 * r->plotprevy[j] + 4) >> 3;
+            if (abs(x - r->plotx[i]) > 4 || abs(y - r->ploty[i]) > 4)
             {
-                plotx[i] = x;
-                ploty[i] = y;
+                r->plotx[i] = x;
+                r->ploty[i] = y;
             }
         }
-        memcpy(plotprevx, plotx, plotmax * sizeof *plotprevx);
-        memcpy(plotprevy, ploty, plotmax * sizeof *plotprevy);
-        plotprevmax = plotmax;
+        memcpy(r->plotprevx, r->plotx, r->plotmax * sizeof *r->plotprevx);
+        memcpy(r->plotprevy, r->ploty, r->plotmax * sizeof *r->plotprevy);
+        r->plotprevmax = r->plotmax;
 
     }
 }
@@ -504,8 +488,9 @@ static void plotafter(void)
  * the points are copied into renderdata[].  The return value indicates the
  * final number of data points.
  */
-static int condition_data(int max, int ndata, int16_t **dataref)
+static int condition_data(BlurskPrivate *priv, int max, int ndata, int16_t **dataref)
 {
+    BlurskRender *r = &priv->render;
     int i, j, step;
 
     /* if number of data points is already good, just copy it */
@@ -521,9 +506,9 @@ static int condition_data(int max, int ndata, int16_t **dataref)
              j < ndata;
              j += step, i++)
         {
-            renderdata[i] = (*dataref)[j];
+            r->renderdata[i] = (*dataref)[j];
         }
-        *dataref = renderdata;
+        *dataref = r->renderdata;
         return i;
     }
 
@@ -537,55 +522,54 @@ static int condition_data(int max, int ndata, int16_t **dataref)
              j >= 0;
              j--, i -= 2)
         {
-            renderdata[i] = (*dataref)[j];
-            renderdata[i + 1] = (renderdata[i] + renderdata[i + 2]) / 2;
+            r->renderdata[i] = (*dataref)[j];
+            r->renderdata[i + 1] = (r->renderdata[i] + r->renderdata[i + 2]) / 2;
         }
         ndata = ndata * 2 - 1;
-        *dataref = renderdata;
+        *dataref = r->renderdata;
 
         /* smooth */
         for (i = 1; i < ndata - 2; i++)
-            renderdata[i] = (int16_t)((renderdata[i - 1] + renderdata[i + 1]) * 3 + renderdata[i] * 10) >> 4;
+            r->renderdata[i] = (int16_t)((r->renderdata[i - 1] + r->renderdata[i + 1]) * 3 + r->renderdata[i] * 10) >> 4;
     }
     return ndata;
 }
 
 /* Plot a radial spectrum. */
-static void render_radial(int thick, int center, int ndata, int16_t *data)
+static void render_radial(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data)
 {
+    BlurskRender *r = &priv->render;
     double  theta, step, sig;
     int i;
     int x, y, xscale, xcenter, yscale;
-    static int16_t prev[MAXPOINTS];
-    static int nprev;
     int32_t trigger;
 
     /* We'd like to have between 127 and 256 data samples */
-    ndata = condition_data(256, ndata, &data);
+    ndata = condition_data(priv, 256, ndata, &data);
 
 #if 1
     /* If same number of points as last time (which should normally be the
      * case) then merge previous data with current data.
      */
-    if (ndata == nprev)
+    if (ndata == r->nradialprev)
     {
         for (i = 0; i < ndata; i++)
-            prev[i] = ((int32_t)prev[i] + (int32_t)data[i]) >> 1;
-        data = prev;
+            r->radialprev[i] = ((int32_t)r->radialprev[i] + (int32_t)data[i]) >> 1;
+        data = r->radialprev;
     }
     else
     {
-        nprev = ndata;
-        memcpy(prev, data, ndata * sizeof(int16_t));
+        r->nradialprev = ndata;
+        memcpy(r->radialprev, data, ndata * sizeof(int16_t));
     }
 #endif
 
     /* Some image geometry constants */
-    xscale = xcenter = img_width / 2;
-    yscale = img_height / 2;
+    xscale = xcenter = priv->img.width / 2;
+    yscale = priv->img.height / 2;
 
     /* Take samples starting from the center out */
-    plotbefore(thick, ndata);
+    plotbefore(priv, thick, ndata);
     trigger = BEAD_THRESHOLD * 5;
     for (theta = 0.0, step = 2.0 * VISUAL_MATH_PI / ndata, i = 0;
          i < ndata;
@@ -595,46 +579,46 @@ static void render_radial(int thick, int center, int ndata, int16_t *data)
         if (trigger < 0)
         {
             trigger += BEAD_THRESHOLD * 10;
-            if (*config.signal_style == 'F')
+            if (*priv->config.signal_style == 'F')
                 sig = (double)(14000 - data[i]) / 30000.0;
             else
                 sig = (double)(20000 - data[i]) / 20000.0;
             x = xcenter - xscale * sig * sin(theta);
             y = center - yscale * sig * cos(theta);
-            plot(x, y);
+            plot(priv, x, y);
         }
     }
-    plotafter();
+    plotafter(priv);
 }
 
 /* Draw some dots, based on phase-shifted sample points */
-static void render_phase(int thick, int center, int ndata, int16_t *data)
+static void render_phase(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data)
 {
     int npoints, i, sample, x, y;
 
     /* We'd like to have between 256 and 512 data samples */
-    ndata = condition_data(512, ndata, &data);
+    ndata = condition_data(priv, 512, ndata, &data);
 
     /* Choose a number of points to draw, based on thick */
     npoints = 12 + 8 * thick;
 
     /* For each point... */
-    plotbefore(thick, ndata);
+    plotbefore(priv, thick, ndata);
     for (i = 0; i < npoints; i++)
     {
         /* Derive x & y from uniformly-separated samples */
         sample = i * 3 * ndata / (8 * npoints);
-        x = ((int16_t)data[sample] >> 8) + img_width/2;
+        x = ((int16_t)data[sample] >> 8) + priv->img.width/2;
         y = ((int16_t)data[sample + ndata/8 - 1] >> 9) + center;
 
         /* Plot the point */
-        plot(x, y);
+        plot(priv, x, y);
     }
-    plotafter();
+    plotafter(priv);
 }
 
 /* Draw some dots, based on the sample values. */
-static void render_highlow(int thick, int center, int ndata, int16_t *data)
+static void render_highlow(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data)
 {
     int16_t *d1, *d2;
     int32_t trigger;
@@ -663,7 +647,7 @@ static void render_highlow(int thick, int center, int ndata, int16_t *data)
     thick++;
 
     /* Okay, now let's check each pair */
-    plotbefore(thick, ndata);
+    plotbefore(priv, thick, ndata);
     for (i = 0; i < ndata; i++)
     {
         /* Accumulate the amounts that these differ from 20000 */
@@ -681,75 +665,75 @@ static void render_highlow(int thick, int center, int ndata, int16_t *data)
              * The Y value is computed from the difference between
              * the samples.
              */
-            x = img_width / 2 + (((i - ndata/2) * (int32_t)img_width * thick) >> 7);
+            x = priv->img.width / 2 + (((i - ndata/2) * (int32_t)priv->img.width * thick) >> 7);
             y = center + (((int32_t)d1[i] - (int32_t)d2[i]) >> 8);
-            plot(x, y);
+            plot(priv, x, y);
         }
     }
-    plotafter();
+    plotafter(priv);
 }
 
-/* Draw a line graph for the next image.  The input data consists of img_width/2
+/* Draw a line graph for the next image.  The input data consists of img.width/2
  * samples, which may be either PCM data, or spectrum data which has been
  * tweaked to resemble PCM data.
  */
-static void render_curve(int thick, int center, int ndata, int16_t *data)
+static void render_curve(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data)
 {
     int i, x, y;
     int32_t scale;
 
     /* We'd like to have about 256 sample points.  */
-    ndata = condition_data(256, ndata, &data);
+    ndata = condition_data(priv, 256, ndata, &data);
 
-    scale = img_height / 4;
-    plotbefore(thick, ndata);
+    scale = priv->img.height / 4;
+    plotbefore(priv, thick, ndata);
     for(i = 0; i < ndata; i++)
     {
-        x = i * (img_width - 1) / (ndata - 1);
+        x = i * (priv->img.width - 1) / (ndata - 1);
         y = center + (((int32_t)data[i] * scale) >> 14);
         if(y < 0)
             y = 0;
-        if(y >= img_height - 1)
-            y = img_height - 2;
-        plot(x, y);
+        if(y >= priv->img.height - 1)
+            y = priv->img.height - 2;
+        plot(priv, x, y);
     }
-    plotafter();
+    plotafter(priv);
 }
 
 /* Generic data rendering function */
-void render(int thick, int center, int ndata, int16_t *data)
+void render(BlurskPrivate *priv, int thick, int center, int ndata, int16_t *data)
 {
     /* if thick=0, then most plot styles do nothing, but the Radar plot
      * style treats that as though thick=1.
      */
     if (thick == 0)
     {
-        if (*config.plot_style == 'R')
+        if (*priv->config.plot_style == 'R')
             thick = 1;
         else
             return;
     }
 
     /* Plot the signal */
-    switch (*config.signal_style)
+    switch (*priv->config.signal_style)
     {
       case 'R': /* Radial spectrum */
       case 'F': /* Flower */
-        render_radial(thick, center, ndata, data);
+        render_radial(priv, thick, center, ndata, data);
         break;
 
       case 'O': /* Oscilloscope */
       case 'M': /* Mono spectrum */
       case 'S': /* Stereo spectrum */
-        render_curve(thick, center, ndata, data);
+        render_curve(priv, thick, center, ndata, data);
         break;
 
       case 'P': /* Phase shift */
-        render_phase(thick, center, ndata, data);
+        render_phase(priv, thick, center, ndata, data);
         break;
 
       case 'H': /* High/Low spectrum */
-        render_highlow(thick, center, ndata, data);
+        render_highlow(priv, thick, center, ndata, data);
         break;
 
       case 'N': /* None */
@@ -85,12 +85,20 @@ static inline void getPixelRGB_ (Pixel *buffer, Uint x, Color * c)
 /* faire : a / sqrtperte <=> a >> PERTEDEC */
 #define PERTEDEC 4
 
-/* pure c version of the zoom filter */
-static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
+/* pure c version of the zoom filter, for rows [y_begin, y_end) */
+static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB], int y_begin, int y_end);
+
+/* the corners of the source are black, before the rows are zoomed */
+static void zoomClearCorners (Pixel *expix1, unsigned int prevX, unsigned int prevY);
 
 /* simple wrapper to give it the same proto than the others */
 void zoom_filter_c (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]) {
-    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef);
+    zoomClearCorners(src, sizeX, sizeY);
+    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef, 0, sizeY);
+}
+
+void zoom_filter_c_rows (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end) {
+    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef, y_begin, y_end);
 }
 
 static void generatePrecalCoef (int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
@@ -135,8 +143,30 @@ typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA {
     int wave;
     int wavesp;
     
+    /** brutT is generated on this thread when there are threads, see zoomGeneratorStart */
+    VisThread *generator;
+    VisMutex *generatorLock;
+    VisCond *generatorCond;
+    int generating;
+    int generated;
+    int generatorQuit;
+    
 } ZoomFilterFXWrapperData;
 
+/** the rows of a frame, zoomed in bands by zoomBand */
+typedef struct _ZOOM_BANDS {
+    
+    void (*zoom_filter_rows) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
+    
+    ZoomFilterFXWrapperData *data;
+    Pixel *src, *dest;
+    int count;
+    
+} ZoomBands;
+
+/* bands per thread, so uneven bands even out */
+#define ZOOM_BANDS_PER_THREAD 2
+
 
 
 
@@ -231,31 +261,25 @@ static inline v2g zoomVector(ZoomFilterFXWrapperData *data, float X, float Y)
 
 
 /*
- * Makes a stripe of a transform buffer (brutT)
+ * Makes rows [y_begin, y_end) of a transform buffer (brutT)
  *
  * The transform is (in order) :
  * Translation (-data->middleX, -data->middleY)
  * Homothetie (Center : 0,0   Coeff : 2/data->prevX)
  */
-static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_INCR)
+static void makeZoomBufferRows(ZoomFilterFXWrapperData * data, int y_begin, int y_end)
 {
     // Position of the pixel to compute in pixmap coordinates
     Uint x, y;
-    // Where (verticaly) to stop generating the buffer stripe
-    int maxEnd = (data->interlace_start + INTERLACE_INCR);
     // Ratio from pixmap to normalized coordinates
     float ratio = 2.0f/((float)data->prevX);
     // Ratio from normalized to virtual pixmap coordinates
     float inv_ratio = BUFFPOINTNBF/ratio;
     float min = ratio/BUFFPOINTNBF;
     // Y position of the pixel to compute in normalized coordinates
-    float Y = ((float)(data->interlace_start - data->middleY)) * ratio;
+    float Y = ((float)(y_begin - data->middleY)) * ratio;
     
-    maxEnd = data->prevY;
-    if (maxEnd > (data->interlace_start + INTERLACE_INCR))
-        maxEnd = (data->interlace_start + INTERLACE_INCR);
-    
-    for (y = data->interlace_start; (y < data->prevY) && ((signed int)y<maxEnd); y++) {
+    for (y = y_begin; (y < data->prevY) && ((signed int)y<y_end); y++) {
         Uint premul_y_prevX = y * data->prevX * 2;
         float X = - ((float)data->middleX) * ratio;
         for (x = 0; x < data->prevX; x++)
@@ -273,8 +297,158 @@ static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_I
         }
         Y += ratio;
     }
+}
+
+/*
+ * Makes a stripe of a transform buffer (brutT)
+ */
+static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_INCR)
+{
+    // Where (verticaly) to stop generating the buffer stripe
+    int maxEnd = data->prevY;
+    
+    if (maxEnd > (data->interlace_start + INTERLACE_INCR))
+        maxEnd = (data->interlace_start + INTERLACE_INCR);
+    
+    makeZoomBufferRows(data, data->interlace_start, maxEnd);
+    
     data->interlace_start += INTERLACE_INCR;
-    if (y >= data->prevY-1) data->interlace_start = -1;
+    if (maxEnd >= (signed int)data->prevY-1) data->interlace_start = -1;
+}
+
+/*
+ * The whole transform buffer (brutT) is made on a thread, while the frames are
+ * still zoomed with brutS and brutD. The thread only touches brutT, and the
+ * settings it reads do not change until it is done. It lives as long as the
+ * filter, or until threads are switched off, and sleeps between the zoom
+ * configs.
+ */
+static void *zoomGeneratorThread(void *arg)
+{
+    ZoomFilterFXWrapperData *data = (ZoomFilterFXWrapperData*)arg;
+    
+    visual_mutex_lock(data->generatorLock);
+    
+    for (;;) {
+        while (!data->generatorQuit && (!data->generating || data->generated))
+            visual_cond_wait(data->generatorCond, data->generatorLock);
+        
+        if (data->generatorQuit)
+            break;
+        
+        visual_mutex_unlock(data->generatorLock);
+        
+        makeZoomBufferRows(data, 0, data->prevY);
+        
+        visual_mutex_lock(data->generatorLock);
+        data->generated = 1;
+        visual_cond_broadcast(data->generatorCond);
+    }
+    
+    visual_mutex_unlock(data->generatorLock);
+    
+    return NULL;
+}
+
+/* returns 1 when brutT is not being made (anymore), wait makes sure of that */
+static int zoomGeneratorFinish(ZoomFilterFXWrapperData *data, int wait)
+{
+    if (!data->generating)
+        return 1;
+    
+    visual_mutex_lock(data->generatorLock);
+    
+    if (!wait && !data->generated) {
+        visual_mutex_unlock(data->generatorLock);
+        
+        return 0;
+    }
+    
+    while (!data->generated)
+        visual_cond_wait(data->generatorCond, data->generatorLock);
+    
+    data->generating = 0;
+    
+    visual_mutex_unlock(data->generatorLock);
+    
+    return 1;
+}
+
+/* lets the thread finish its work and ends it */
+static void zoomGeneratorStop(ZoomFilterFXWrapperData *data)
+{
+    if (data->generator == NULL)
+        return;
+    
+    zoomGeneratorFinish(data, 1);
+    
+    visual_mutex_lock(data->generatorLock);
+    data->generatorQuit = 1;
+    visual_cond_broadcast(data->generatorCond);
+    visual_mutex_unlock(data->generatorLock);
+    
+    visual_thread_join(data->generator);
+    visual_thread_free(data->generator);
+    data->generator = NULL;
+}
+
+/* hands brutT to the thread, returns 0 when it has to be made in stripes instead */
+static int zoomGeneratorStart(ZoomFilterFXWrapperData *data)
+{
+    if (!visual_thread_is_supported() || !visual_thread_is_enabled()) {
+        /* threads were switched off, do not keep one around */
+        zoomGeneratorStop(data);
+        
+        return 0;
+    }
+    
+    if (data->generator == NULL) {
+        if (data->generatorLock == NULL)
+            data->generatorLock = visual_mutex_new();
+        
+        if (data->generatorCond == NULL)
+            data->generatorCond = visual_cond_new();
+        
+        if (data->generatorLock == NULL || data->generatorCond == NULL)
+            return 0;
+        
+        data->generatorQuit = 0;
+        data->generator = visual_thread_create(zoomGeneratorThread, data, TRUE);
+        
+        if (data->generator == NULL)
+            return 0;
+    }
+    
+    visual_mutex_lock(data->generatorLock);
+    data->generated = 0;
+    data->generating = 1;
+    visual_cond_broadcast(data->generatorCond);
+    visual_mutex_unlock(data->generatorLock);
+    
+    return 1;
+}
+
+/* number of bands a frame is zoomed in, as the VisVideo operations are split */
+static int zoomBandCount(Uint width, Uint height)
+{
+    int threshold = visual_video_get_parallel_threshold();
+    int threads = visual_thread_get_parallelism();
+    int count = threads * ZOOM_BANDS_PER_THREAD;
+    
+    if (threads <= 1 || threshold < 0 || width * height < (Uint)threshold)
+        return 1;
+    
+    return count > (int)height ? (int)height : count;
+}
+
+static void zoomBand(void *arg, int index)
+{
+    ZoomBands *bands = (ZoomBands*)arg;
+    ZoomFilterFXWrapperData *data = bands->data;
+    
+    bands->zoom_filter_rows(data->prevX, data->prevY, bands->src, bands->dest, data->brutS, data->brutD,
+                            data->buffratio, data->precalCoef,
+                            index * data->prevY / bands->count, (index + 1) * data->prevY / bands->count);
 }
 
 
@@ -402,20 +576,23 @@ static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_I
 
 
 
+static void zoomClearCorners (Pixel *expix1, unsigned int prevX, unsigned int prevY)
+{
+    expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
+}
+
 static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD,
-                    int buffratio, int precalCoef[16][16])
+                    int buffratio, int precalCoef[16][16], int y_begin, int y_end)
 {
     int     myPos, myPos2;
     Color   couleur;
     
     unsigned int ax = (prevX - 1) << PERTEDEC, ay = (prevY - 1) << PERTEDEC;
     
-    int     bufsize = prevX * prevY * 2;
+    int     bufend = prevX * y_end * 2;
     int     bufwidth = prevX;
     
-    expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
-    
-    for (myPos = 0; myPos < bufsize; myPos += 2) {
+    for (myPos = prevX * y_begin * 2; myPos < bufend; myPos += 2) {
         Color   col1, col2, col3, col4;
         int     c1, c2, c3, c4, px, py;
         int     pos;
@@ -533,6 +710,9 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
     
     /** changement de taille **/
     if ((data->prevX != resx) || (data->prevY != resy)) {
+        /* the thread still uses the buffers */
+        zoomGeneratorFinish(data, 1);
+        
         data->prevX = resx;
         data->prevY = resy;
         
@@ -550,6 +730,10 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
         data->firedec = 0;
     }
     
+    /* the new destination was made on the thread */
+    if (data->generating && zoomGeneratorFinish(data, 0))
+        data->interlace_start = -1;
+    
     if (data->interlace_start != -2)
         zf = NULL;
     
@@ -623,10 +807,11 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
         data->interlace_start = -2;
     }
     
-    if (data->interlace_start>=0)
+    if (data->interlace_start>=0 && !data->generating)
     {
-        /* creation de la nouvelle destination */
-        makeZoomBufferStripe(data,resy/16);
+        /* creation de la nouvelle destination, on a thread if possible */
+        if (data->interlace_start != 0 || !zoomGeneratorStart(data))
+            makeZoomBufferStripe(data,resy/16);
     }
     
     if (switchIncr != 0) {
@@ -642,8 +827,21 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
     
     data->zoom_width = data->prevX;
     
-    goomInfo->methods.zoom_filter (data->prevX, data->prevY, pix1, pix2,
-                                   data->brutS, data->brutD, data->buffratio, data->precalCoef);
+    if (goomInfo->methods.zoom_filter_rows != NULL) {
+        ZoomBands bands;
+        
+        bands.zoom_filter_rows = goomInfo->methods.zoom_filter_rows;
+        bands.data = data;
+        bands.src = pix1;
+        bands.dest = pix2;
+        bands.count = zoomBandCount(data->prevX, data->prevY);
+        
+        zoomClearCorners(pix1, data->prevX, data->prevY);
+        visual_thread_run_parallel(bands.count, zoomBand, &bands);
+    }
+    else
+        goomInfo->methods.zoom_filter (data->prevX, data->prevY, pix1, pix2,
+                                       data->brutS, data->brutD, data->buffratio, data->precalCoef);
 }
 
 static void generatePrecalCoef (int precalCoef[16][16])
@@ -719,6 +917,13 @@ static void zoomFilterVisualFXWrapper_init (struct _VISUAL_FX *_this, PluginInfo
     
     data->wave = data->wavesp = 0;
     
+    data->generator = NULL;
+    data->generatorLock = NULL;
+    data->generatorCond = NULL;
+    data->generating = 0;
+    data->generated = 0;
+    data->generatorQuit = 0;
+    
     data->enabled_bp = secure_b_param("Enabled", 1);
     
     data->params = plugin_parameters ("Zoom Filter", 1);
@@ -733,6 +938,14 @@ static void zoomFilterVisualFXWrapper_init (struct _VISUAL_FX *_this, PluginInfo
 
 static void zoomFilterVisualFXWrapper_free (struct _VISUAL_FX *_this)
 {
+    ZoomFilterFXWrapperData *data = (ZoomFilterFXWrapperData*)_this->fx_data;
+    
+    zoomGeneratorStop(data);
+    if (data->generatorCond != NULL)
+        visual_cond_free(data->generatorCond);
+    if (data->generatorLock != NULL)
+        visual_mutex_free(data->generatorLock);
+    
     free(_this->fx_data);
 }
 
@@ -0,0 +1,268 @@
+/* filters_simd.c
+ * Rows of the zoom filter with SSE2 and AVX2 on x86-64, and NEON.
+ *
+ * They give exactly the same pixels as c_zoom in filters.c: the position of
+ * every pixel is interpolated between brutS and brutD, the four source pixels
+ * around it are weighted with its precalculated coefficients, and 5 is taken
+ * off every channel before the shift. The alpha of dest is left alone.
+ */
+
+#include <libvisual/libvisual.h>
+
+#include "goom_fx.h"
+#include "goom_graphic.h"
+
+#define BUFFPOINTNB 16
+#define PERTEDEC 4
+#define PERTEMASK 0xf
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/* The low 32 bits of a * b, SSE2 has no pmulld */
+static inline __m128i mullo_epi32 (__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32 (a, b);
+    __m128i odd = _mm_mul_epu32 (_mm_srli_si128 (a, 4), _mm_srli_si128 (b, 4));
+
+    return _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE (0, 0, 2, 0)),
+                               _mm_shuffle_epi32 (odd, _MM_SHUFFLE (0, 0, 2, 0)));
+}
+
+/* The four source pixels of a destination pixel times their coefficients, as
+ * 16 bits lanes holding the top plus bottom sums of both columns */
+static inline __m128i zoom_pixel_sums (const Pixel *src, int pos, int prevX, unsigned int coeffs, __m128i zero)
+{
+    __m128i top = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (src + pos)), zero);
+    __m128i bottom = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (src + pos + prevX)), zero);
+    __m128i w = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (coeffs), zero);
+
+    w = _mm_unpacklo_epi16 (w, w);
+
+    return _mm_add_epi16 (_mm_mullo_epi16 (top, _mm_unpacklo_epi32 (w, w)),
+                          _mm_mullo_epi16 (bottom, _mm_unpackhi_epi32 (w, w)));
+}
+
+/* Blends two destination pixels from their positions and coefficients */
+static inline void zoom_pixel_pair (const Pixel *src, Pixel *dest, int prevX, const int *pos, const unsigned int *coeffs,
+                                    __m128i zero, __m128i five, __m128i alpha)
+{
+    __m128i s0 = zoom_pixel_sums (src, pos[0], prevX, coeffs[0], zero);
+    __m128i s1 = zoom_pixel_sums (src, pos[1], prevX, coeffs[1], zero);
+    __m128i sum = _mm_add_epi16 (_mm_unpacklo_epi64 (s0, s1), _mm_unpackhi_epi64 (s0, s1));
+    __m128i old = _mm_loadl_epi64 ((const __m128i *) dest);
+
+    /* Channels up to 5 end up 0 after the shift either way */
+    sum = _mm_srli_epi16 (_mm_subs_epu16 (sum, five), 8);
+    sum = _mm_packus_epi16 (sum, sum);
+
+    _mm_storel_epi64 ((__m128i *) dest, _mm_or_si128 (_mm_andnot_si128 (alpha, sum), _mm_and_si128 (alpha, old)));
+}
+
+/* One pixel, for the pixels left over at the end */
+static inline void zoom_pixel_one (const Pixel *src, Pixel *dest, int prevX, int pos, unsigned int coeffs,
+                                   __m128i zero, __m128i five)
+{
+    __m128i sum = zoom_pixel_sums (src, pos, prevX, coeffs, zero);
+    Pixel pixel;
+
+    sum = _mm_add_epi16 (sum, _mm_srli_si128 (sum, 8));
+    sum = _mm_srli_epi16 (_mm_subs_epu16 (sum, five), 8);
+    pixel.val = _mm_cvtsi128_si32 (_mm_packus_epi16 (sum, sum));
+
+    dest->val = (pixel.val & ~A_CHANNEL) | (dest->val & A_CHANNEL);
+}
+
+/* Pixels [i, end) of the frame */
+static void zoom_sse2_pixels (int prevX, int prevY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio,
+                              int precalCoef[16][16], int i, int end)
+{
+    const int *coefs = &precalCoef[0][0];
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i five = _mm_set1_epi16 (5);
+    __m128i alpha = _mm_set1_epi32 (A_CHANNEL);
+    __m128i ratio = _mm_set1_epi32 (buffratio);
+    __m128i ax = _mm_set1_epi32 ((prevX - 1) << PERTEDEC);
+    __m128i ay = _mm_set1_epi32 ((prevY - 1) << PERTEDEC);
+    __m128i minus1 = _mm_set1_epi32 (-1);
+    __m128i mask = _mm_set1_epi32 (PERTEMASK);
+    __m128i width = _mm_set1_epi32 (prevX);
+    int pos[4], index[4], inside[4];
+    unsigned int coeffs[4];
+    int k;
+
+    for (; i + 4 <= end; i += 4) {
+        __m128i s01 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) (brutS + i * 2)), _MM_SHUFFLE (3, 1, 2, 0));
+        __m128i s23 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) (brutS + i * 2 + 4)), _MM_SHUFFLE (3, 1, 2, 0));
+        __m128i d01 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) (brutD + i * 2)), _MM_SHUFFLE (3, 1, 2, 0));
+        __m128i d23 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) (brutD + i * 2 + 4)), _MM_SHUFFLE (3, 1, 2, 0));
+        __m128i sx = _mm_unpacklo_epi64 (s01, s23);
+        __m128i sy = _mm_unpackhi_epi64 (s01, s23);
+        __m128i px, py, in;
+
+        px = _mm_add_epi32 (sx, _mm_srai_epi32 (mullo_epi32 (_mm_sub_epi32 (_mm_unpacklo_epi64 (d01, d23), sx), ratio), BUFFPOINTNB));
+        py = _mm_add_epi32 (sy, _mm_srai_epi32 (mullo_epi32 (_mm_sub_epi32 (_mm_unpackhi_epi64 (d01, d23), sy), ratio), BUFFPOINTNB));
+
+        /* Unsigned px < ax and py < ay, ax and ay being positive */
+        in = _mm_and_si128 (_mm_and_si128 (_mm_cmplt_epi32 (px, ax), _mm_cmpgt_epi32 (px, minus1)),
+                            _mm_and_si128 (_mm_cmplt_epi32 (py, ay), _mm_cmpgt_epi32 (py, minus1)));
+
+        _mm_storeu_si128 ((__m128i *) pos, _mm_and_si128 (in,
+                          _mm_add_epi32 (_mm_srai_epi32 (px, PERTEDEC), mullo_epi32 (_mm_srai_epi32 (py, PERTEDEC), width))));
+        _mm_storeu_si128 ((__m128i *) index, _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (px, mask), 4),
+                                                           _mm_and_si128 (py, mask)));
+        _mm_storeu_si128 ((__m128i *) inside, in);
+
+        for (k = 0; k < 4; k++)
+            coeffs[k] = coefs[index[k]] & inside[k];
+
+        zoom_pixel_pair (src, dest + i, prevX, pos, coeffs, zero, five, alpha);
+        zoom_pixel_pair (src, dest + i + 2, prevX, pos + 2, coeffs + 2, zero, five, alpha);
+    }
+
+    for (; i < end; i++) {
+        int px = brutS[i * 2] + (((brutD[i * 2] - brutS[i * 2]) * buffratio) >> BUFFPOINTNB);
+        int py = brutS[i * 2 + 1] + (((brutD[i * 2 + 1] - brutS[i * 2 + 1]) * buffratio) >> BUFFPOINTNB);
+
+        if ((unsigned int) py >= (unsigned int) ((prevY - 1) << PERTEDEC) ||
+            (unsigned int) px >= (unsigned int) ((prevX - 1) << PERTEDEC))
+            zoom_pixel_one (src, dest + i, prevX, 0, 0, zero, five);
+        else
+            zoom_pixel_one (src, dest + i, prevX, (px >> PERTEDEC) + prevX * (py >> PERTEDEC),
+                            precalCoef[px & PERTEMASK][py & PERTEMASK], zero, five);
+    }
+}
+
+void zoom_filter_sse2_rows (int prevX, int prevY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio,
+                            int precalCoef[16][16], int y_begin, int y_end)
+{
+    zoom_sse2_pixels (prevX, prevY, src, dest, brutS, brutD, buffratio, precalCoef, y_begin * prevX, y_end * prevX);
+}
+
+/* The positions and coefficients of eight pixels at once, the blending is
+ * done as with SSE2 */
+__attribute__ ((target ("avx2")))
+void zoom_filter_avx2_rows (int prevX, int prevY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio,
+                            int precalCoef[16][16], int y_begin, int y_end)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i five = _mm_set1_epi16 (5);
+    __m128i alpha = _mm_set1_epi32 (A_CHANNEL);
+    __m256i deinterleave = _mm256_setr_epi32 (0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i ratio = _mm256_set1_epi32 (buffratio);
+    __m256i ax = _mm256_set1_epi32 ((prevX - 1) << PERTEDEC);
+    __m256i ay = _mm256_set1_epi32 ((prevY - 1) << PERTEDEC);
+    __m256i minus1 = _mm256_set1_epi32 (-1);
+    __m256i mask = _mm256_set1_epi32 (PERTEMASK);
+    __m256i width = _mm256_set1_epi32 (prevX);
+    int i = y_begin * prevX;
+    int end = y_end * prevX;
+    int pos[8];
+    unsigned int coeffs[8];
+
+    for (; i + 8 <= end; i += 8) {
+        /* x and y of four pixels in each half */
+        __m256i s0 = _mm256_permutevar8x32_epi32 (_mm256_loadu_si256 ((const __m256i *) (brutS + i * 2)), deinterleave);
+        __m256i s1 = _mm256_permutevar8x32_epi32 (_mm256_loadu_si256 ((const __m256i *) (brutS + i * 2 + 8)), deinterleave);
+        __m256i d0 = _mm256_permutevar8x32_epi32 (_mm256_loadu_si256 ((const __m256i *) (brutD + i * 2)), deinterleave);
+        __m256i d1 = _mm256_permutevar8x32_epi32 (_mm256_loadu_si256 ((const __m256i *) (brutD + i * 2 + 8)), deinterleave);
+        __m256i sx = _mm256_permute2x128_si256 (s0, s1, 0x20);
+        __m256i sy = _mm256_permute2x128_si256 (s0, s1, 0x31);
+        __m256i dx = _mm256_permute2x128_si256 (d0, d1, 0x20);
+        __m256i dy = _mm256_permute2x128_si256 (d0, d1, 0x31);
+        __m256i px, py, in, index;
+        int k;
+
+        px = _mm256_add_epi32 (sx, _mm256_srai_epi32 (_mm256_mullo_epi32 (_mm256_sub_epi32 (dx, sx), ratio), BUFFPOINTNB));
+        py = _mm256_add_epi32 (sy, _mm256_srai_epi32 (_mm256_mullo_epi32 (_mm256_sub_epi32 (dy, sy), ratio), BUFFPOINTNB));
+
+        in = _mm256_and_si256 (_mm256_and_si256 (_mm256_cmpgt_epi32 (ax, px), _mm256_cmpgt_epi32 (px, minus1)),
+                               _mm256_and_si256 (_mm256_cmpgt_epi32 (ay, py), _mm256_cmpgt_epi32 (py, minus1)));
+
+        /* Out of range pixels look up coefficient 0, and mask it */
+        index = _mm256_and_si256 (in, _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (px, mask), 4),
+                                                       _mm256_and_si256 (py, mask)));
+
+        _mm256_storeu_si256 ((__m256i *) pos, _mm256_and_si256 (in,
+                             _mm256_add_epi32 (_mm256_srai_epi32 (px, PERTEDEC),
+                                               _mm256_mullo_epi32 (_mm256_srai_epi32 (py, PERTEDEC), width))));
+        _mm256_storeu_si256 ((__m256i *) coeffs, _mm256_and_si256 (in,
+                             _mm256_i32gather_epi32 (&precalCoef[0][0], index, 4)));
+
+        for (k = 0; k < 8; k += 2)
+            zoom_pixel_pair (src, dest + i + k, prevX, pos + k, coeffs + k, zero, five, alpha);
+    }
+
+    zoom_sse2_pixels (prevX, prevY, src, dest, brutS, brutD, buffratio, precalCoef, i, end);
+}
+
+#endif /* __x86_64__ && __GNUC__ */
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+/* One pixel from its position and coefficients */
+static inline void zoom_pixel_neon (const Pixel *src, Pixel *dest, int prevX, int pos, unsigned int coeffs)
+{
+    uint64_t c1 = (coeffs & 0xff) * 0x01010101ULL;
+    uint64_t c2 = ((coeffs >> 8) & 0xff) * 0x01010101ULL;
+    uint64_t c3 = ((coeffs >> 16) & 0xff) * 0x01010101ULL;
+    uint64_t c4 = (coeffs >> 24) * 0x01010101ULL;
+    uint16x8_t acc = vmull_u8 (vld1_u8 ((const uint8_t *) (src + pos)), vcreate_u8 (c1 | (c2 << 32)));
+    uint16x4_t sum;
+    Pixel pixel;
+
+    acc = vmlal_u8 (acc, vld1_u8 ((const uint8_t *) (src + pos + prevX)), vcreate_u8 (c3 | (c4 << 32)));
+    sum = vqsub_u16 (vadd_u16 (vget_low_u16 (acc), vget_high_u16 (acc)), vdup_n_u16 (5));
+    pixel.val = vget_lane_u32 (vreinterpret_u32_u8 (vshrn_n_u16 (vcombine_u16 (sum, sum), 8)), 0);
+
+    dest->val = (pixel.val & ~A_CHANNEL) | (dest->val & A_CHANNEL);
+}
+
+void zoom_filter_neon_rows (int prevX, int prevY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio,
+                            int precalCoef[16][16], int y_begin, int y_end)
+{
+    const int *coefs = &precalCoef[0][0];
+    int32x4_t ratio = vdupq_n_s32 (buffratio);
+    uint32x4_t ax = vdupq_n_u32 ((prevX - 1) << PERTEDEC);
+    uint32x4_t ay = vdupq_n_u32 ((prevY - 1) << PERTEDEC);
+    int32x4_t mask = vdupq_n_s32 (PERTEMASK);
+    int i = y_begin * prevX;
+    int end = y_end * prevX;
+    int pos[4], index[4];
+    uint32_t inside[4];
+    int k;
+
+    for (; i + 4 <= end; i += 4) {
+        int32x4x2_t s = vld2q_s32 (brutS + i * 2);
+        int32x4x2_t d = vld2q_s32 (brutD + i * 2);
+        int32x4_t px = vaddq_s32 (s.val[0], vshrq_n_s32 (vmulq_s32 (vsubq_s32 (d.val[0], s.val[0]), ratio), BUFFPOINTNB));
+        int32x4_t py = vaddq_s32 (s.val[1], vshrq_n_s32 (vmulq_s32 (vsubq_s32 (d.val[1], s.val[1]), ratio), BUFFPOINTNB));
+        uint32x4_t in = vandq_u32 (vcltq_u32 (vreinterpretq_u32_s32 (px), ax), vcltq_u32 (vreinterpretq_u32_s32 (py), ay));
+
+        vst1q_s32 (pos, vandq_s32 (vreinterpretq_s32_u32 (in),
+                   vmlaq_n_s32 (vshrq_n_s32 (px, PERTEDEC), vshrq_n_s32 (py, PERTEDEC), prevX)));
+        vst1q_s32 (index, vorrq_s32 (vshlq_n_s32 (vandq_s32 (px, mask), 4), vandq_s32 (py, mask)));
+        vst1q_u32 (inside, in);
+
+        for (k = 0; k < 4; k++)
+            zoom_pixel_neon (src, dest + i + k, prevX, pos[k], coefs[index[k]] & inside[k]);
+    }
+
+    for (; i < end; i++) {
+        int px = brutS[i * 2] + (((brutD[i * 2] - brutS[i * 2]) * buffratio) >> BUFFPOINTNB);
+        int py = brutS[i * 2 + 1] + (((brutD[i * 2 + 1] - brutS[i * 2 + 1]) * buffratio) >> BUFFPOINTNB);
+
+        if ((unsigned int) py >= (unsigned int) ((prevY - 1) << PERTEDEC) ||
+            (unsigned int) px >= (unsigned int) ((prevX - 1) << PERTEDEC))
+            zoom_pixel_neon (src, dest + i, prevX, 0, 0);
+        else
+            zoom_pixel_neon (src, dest + i, prevX, (px >> PERTEDEC) + prevX * (py >> PERTEDEC),
+                             precalCoef[px & PERTEMASK][py & PERTEMASK]);
+    }
+}
+
+#endif /* __ARM_NEON */
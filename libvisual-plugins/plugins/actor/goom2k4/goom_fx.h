@@ -9,4 +9,17 @@ VisualFX flying_star_create (void);
 
 void zoom_filter_c(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
 
+/* Rows [y_begin, y_end) of the zoom filter, so the frame can be split in bands.
+ * The SIMD versions are in filters_simd.c. */
+void zoom_filter_c_rows(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+void zoom_filter_sse2_rows(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
+void zoom_filter_avx2_rows(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void zoom_filter_neon_rows(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
+#endif
+
 #endif
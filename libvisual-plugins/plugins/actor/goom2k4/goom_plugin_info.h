@@ -159,6 +159,8 @@ struct _PLUGIN_INFO {
 	struct {
 		void (*draw_line) (Pixel *data, int x1, int y1, int x2, int y2, int col, int screenx, int screeny);
 		void (*zoom_filter) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+		/* Rows of the zoom filter, split over threads. NULL when only zoom_filter does the whole frame. */
+		void (*zoom_filter_rows) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y_begin, int y_end);
 	} methods;
 	
 	GoomRandom *gRandom;
@@ -445,334 +445,591 @@ const char *gsl_instr_validate(Instruction *_this)
   /*************/
  /* EXECUTION */
 /*************/
+
+/* {{{ opcodes of the fast instruction flow */
+/* The validated instructions are compiled into these: arithmetic on three
+ * operands (dest = a op b, every operand being a resolved variable or a
+ * constant), tests which can jump by themselves and jumps to resolved
+ * instructions. OP(name, kind of a, kind of b) */
+#define FAST_OPCODES \
+  OP(MOV_VV,V,N) OP(MOV_VC,C,N) \
+  OP(ADDI_VV,V,V) OP(ADDI_VC,V,C) \
+  OP(SUBI_VV,V,V) OP(SUBI_VC,V,C) OP(SUBI_CV,C,V) \
+  OP(MULI_VV,V,V) OP(MULI_VC,V,C) \
+  OP(DIVI_VV,V,V) OP(DIVI_VC,V,C) OP(DIVI_CV,C,V) \
+  OP(ADDF_VV,V,V) OP(ADDF_VC,V,C) \
+  OP(SUBF_VV,V,V) OP(SUBF_VC,V,C) OP(SUBF_CV,C,V) \
+  OP(MULF_VV,V,V) OP(MULF_VC,V,C) \
+  OP(DIVF_VV,V,V) OP(DIVF_VC,V,C) OP(DIVF_CV,C,V) \
+  OP(EQI_VV,V,V) OP(EQI_VC,V,C) \
+  OP(EQF_VV,V,V) OP(EQF_VC,V,C) \
+  OP(LTI_VV,V,V) OP(LTI_VC,V,C) OP(LTI_CV,C,V) \
+  OP(LTF_VV,V,V) OP(LTF_VC,V,C) OP(LTF_CV,C,V) \
+  OP(JEQI_VV,V,V) OP(JEQI_VC,V,C) \
+  OP(JEQF_VV,V,V) OP(JEQF_VC,V,C) \
+  OP(JLTI_VV,V,V) OP(JLTI_VC,V,C) OP(JLTI_CV,C,V) \
+  OP(JLTF_VV,V,V) OP(JLTF_VC,V,C) OP(JLTF_CV,C,V) \
+  OP(JUMP,N,N) OP(JZERO,N,N) OP(JNZERO,N,N) OP(NOT,N,N) \
+  OP(CALL,N,N) OP(RET,N,N) OP(EXT_CALL,N,N) \
+  OP(SETS,V,N) OP(ADDS,V,N) OP(SUBS,V,N) OP(MULS,V,N) OP(DIVS,V,N) OP(ISEQUALS,V,N)
+
+#define OP(name,a,b) FAST_##name,
+enum { FAST_OPCODES FAST_NB_OPCODES };
+#undef OP
+
+/* kind of the operands */
+#define N 0 /* none */
+#define V 1 /* variable */
+#define C 2 /* constant */
+#define OP(name,a,b) a,
+static const char fast_kind_a[] = { FAST_OPCODES };
+#undef OP
+#define OP(name,a,b) b,
+static const char fast_kind_b[] = { FAST_OPCODES };
+#undef OP
+#undef N
+#undef V
+#undef C
+
+/* flags of the tests that jump */
+#define FAST_FLAG_NOT     1 /* the flag is the opposite of the test */
+#define FAST_JUMP_IF_ZERO 2 /* jumps when the flag is 0 instead of 1 */
+
+/* deepest call stack */
+#define FAST_STACK_MAX 0x10000
+
+#define FAST_IS_TEST(id)      (((id) >= FAST_EQI_VV) && ((id) <= FAST_LTF_CV))
+#define FAST_IS_ARITH(id)     (((id) >= FAST_ADDI_VV) && ((id) <= FAST_DIVF_CV))
+#define FAST_IS_STRUCT_OP(id) (((id) >= FAST_ADDS) && ((id) <= FAST_DIVS))
+/* }}} */
+
 void iflow_execute(FastInstructionFlow *_this, GoomSL *gsl)
 { /* {{{ */
   int flag = 0;
-  int ip = 0;
-  FastInstruction *instr = _this->instr;
-  int stack[0x10000];
-  int stack_pointer = 0;
-
-  stack[stack_pointer++] = -1;
-
-  /* Quelques Macro pour rendre le code plus lisible */
-#define pSRC_VAR        instr[ip].data.usrc.var
-#define SRC_VAR_INT    *instr[ip].data.usrc.var_int
-#define SRC_VAR_FLOAT  *instr[ip].data.usrc.var_float
-#define SRC_VAR_PTR    *instr[ip].data.usrc.var_ptr
-
-#define pDEST_VAR       instr[ip].data.udest.var
-#define DEST_VAR_INT   *instr[ip].data.udest.var_int
-#define DEST_VAR_FLOAT *instr[ip].data.udest.var_float
-#define DEST_VAR_PTR   *instr[ip].data.udest.var_ptr
-
-#define VALUE_INT       instr[ip].data.usrc.value_int
-#define VALUE_FLOAT     instr[ip].data.usrc.value_float
-#define VALUE_PTR       instr[ip].data.usrc.value_ptr
+  int i, j;
+  int sp = 0;
+  FastInstruction *ip;
+
+  /* Direct threading: every instruction knows the address of its code
+   * and jumps straight to the code of the next one. Called without a
+   * GoomSL, this only gives the instructions their address. */
+#ifdef __GNUC__
+#define FAST_THREADED
+  static const void *const handlers[] = {
+#define OP(name,a,b) &&op_##name,
+    FAST_OPCODES
+#undef OP
+  };
+
+  if (gsl == NULL) {
+    for (i = 0; i < _this->number; ++i)
+      _this->instr[i].handler = handlers[_this->instr[i].id];
+    return;
+  }
+#else
+  if (gsl == NULL)
+    return;
+#endif
 
-#define JUMP_OFFSET     instr[ip].data.udest.jump_offset
+#ifdef TRACE_SCRIPT
+#define TRACE() if (ip->proto) { printf("execute "); gsl_instr_display(ip->proto); printf("\n"); }
+#else
+#define TRACE()
+#endif
 
-#define SRC_STRUCT_ID  instr[ip].data.usrc.var_int[-1]
-#define DEST_STRUCT_ID instr[ip].data.udest.var_int[-1]
-#define SRC_STRUCT_IBLOCK(i)  gsl->gsl_struct[SRC_STRUCT_ID]->iBlock[i]
-#define SRC_STRUCT_FBLOCK(i)  gsl->gsl_struct[SRC_STRUCT_ID]->fBlock[i]
-#define DEST_STRUCT_IBLOCK(i) gsl->gsl_struct[DEST_STRUCT_ID]->iBlock[i]
-#define DEST_STRUCT_FBLOCK(i) gsl->gsl_struct[DEST_STRUCT_ID]->fBlock[i]
-#define DEST_STRUCT_IBLOCK_VAR(i,j) \
-  ((int*)((char*)pDEST_VAR   + gsl->gsl_struct[DEST_STRUCT_ID]->iBlock[i].data))[j]
-#define DEST_STRUCT_FBLOCK_VAR(i,j) \
-  ((float*)((char*)pDEST_VAR + gsl->gsl_struct[DEST_STRUCT_ID]->fBlock[i].data))[j]
-#define SRC_STRUCT_IBLOCK_VAR(i,j) \
-  ((int*)((char*)pSRC_VAR    + gsl->gsl_struct[SRC_STRUCT_ID]->iBlock[i].data))[j]
-#define SRC_STRUCT_FBLOCK_VAR(i,j) \
-  ((float*)((char*)pSRC_VAR  + gsl->gsl_struct[SRC_STRUCT_ID]->fBlock[i].data))[j]
-#define DEST_STRUCT_SIZE      gsl->gsl_struct[DEST_STRUCT_ID]->size
+#ifdef FAST_THREADED
+#define CASE(name)  op_##name
+#define DISPATCH()  TRACE(); goto *ip->handler
+#else
+#define CASE(name)  case FAST_##name
+#define DISPATCH()  TRACE(); continue
+#endif
+#define NEXT()      ++ip; DISPATCH()
+#define JUMP(to)    ip = (to); DISPATCH()
 
+  /* Quelques Macro pour rendre le code plus lisible */
+#define DEST_I   *ip->dest.var_int
+#define DEST_F   *(float*)ip->dest.var
+#define A_VAR_I  *ip->a.var_int
+#define A_VAR_F  *ip->a.var_float
+#define A_I      ip->a.value_int
+#define A_F      ip->a.value_float
+#define B_VAR_I  *ip->b.var_int
+#define B_VAR_F  *ip->b.var_float
+#define B_I      ip->b.value_int
+#define B_F      ip->b.value_float
+
+#define ARITH(name, dest, a, b, op) \
+      CASE(name): dest = a op b; NEXT();
+#define ARITH_COMMUTATIVE(name, T, op) \
+      ARITH(name##T##_VV, DEST_##T, A_VAR_##T, B_VAR_##T, op) \
+      ARITH(name##T##_VC, DEST_##T, A_VAR_##T, B_##T, op)
+#define ARITH_ORDERED(name, T, op) \
+      ARITH_COMMUTATIVE(name, T, op) \
+      ARITH(name##T##_CV, DEST_##T, A_##T, B_VAR_##T, op)
+
+  /* a test sets the flag, or sets it and jumps */
+#define TEST(name, test) \
+      CASE(name): flag = (test); NEXT(); \
+      CASE(J##name): \
+        flag = (test) ^ (ip->flags & FAST_FLAG_NOT); \
+        ip = (flag ^ (ip->flags >> 1)) ? ip->u.jump : ip + 1; \
+        DISPATCH();
+
+#define STRUCT_OP(name, op) \
+      CASE(name): \
+        for (i = 0; ip->u.gsl_struct->iBlock[i].size > 0; ++i) { \
+          int *dest = (int*)((char*)ip->dest.var + ip->u.gsl_struct->iBlock[i].data); \
+          int *src  = (int*)((char*)ip->a.var    + ip->u.gsl_struct->iBlock[i].data); \
+          for (j = ip->u.gsl_struct->iBlock[i].size; j--;) \
+            dest[j] op src[j]; \
+        } \
+        for (i = 0; ip->u.gsl_struct->fBlock[i].size > 0; ++i) { \
+          float *dest = (float*)((char*)ip->dest.var + ip->u.gsl_struct->fBlock[i].data); \
+          float *src  = (float*)((char*)ip->a.var    + ip->u.gsl_struct->fBlock[i].data); \
+          for (j = ip->u.gsl_struct->fBlock[i].size; j--;) \
+            dest[j] op src[j]; \
+        } \
+        NEXT();
+
+  ip = _this->instr;
+
+#ifdef FAST_THREADED
+  DISPATCH();
+#else
   while (1)
   {
-    int i;
-#ifdef TRACE_SCRIPT 
-    printf("execute "); gsl_instr_display(instr[ip].proto); printf("\n");
+    switch (ip->id) {
 #endif
-    switch (instr[ip].id) {
-
-      /* SET.I */
-      case INSTR_SETI_VAR_INTEGER:
-        DEST_VAR_INT = VALUE_INT;
-        ++ip; break;
-
-      case INSTR_SETI_VAR_VAR:
-        DEST_VAR_INT = SRC_VAR_INT;
-        ++ip; break;
-
-        /* SET.F */
-      case INSTR_SETF_VAR_FLOAT:
-        DEST_VAR_FLOAT = VALUE_FLOAT;
-        ++ip; break;
-
-      case INSTR_SETF_VAR_VAR:
-        DEST_VAR_FLOAT = SRC_VAR_FLOAT;
-        ++ip; break;
-
-        /* SET.P */
-      case INSTR_SETP_VAR_VAR:
-        DEST_VAR_PTR = SRC_VAR_PTR;
-        ++ip; break;
 
-      case INSTR_SETP_VAR_PTR:
-        DEST_VAR_PTR = VALUE_PTR;
-        ++ip; break;
-
-        /* JUMP */
-      case INSTR_JUMP:
-        ip += JUMP_OFFSET; break;
-
-        /* JZERO */
-      case INSTR_JZERO:
-        ip += (flag ? 1 : JUMP_OFFSET); break;
-
-      case INSTR_NOP:
-        ++ip; break;
-
-        /* ISEQUAL.P */
-      case INSTR_ISEQUALP_VAR_VAR:
-        flag = (DEST_VAR_PTR == SRC_VAR_PTR);
-        ++ip; break;
-
-      case INSTR_ISEQUALP_VAR_PTR:
-        flag = (DEST_VAR_PTR == VALUE_PTR);
-        ++ip; break;
-
-        /* ISEQUAL.I */
-      case INSTR_ISEQUALI_VAR_VAR:
-        flag = (DEST_VAR_INT == SRC_VAR_INT);
-        ++ip; break;
-
-      case INSTR_ISEQUALI_VAR_INTEGER:
-        flag = (DEST_VAR_INT == VALUE_INT);
-        ++ip; break;
-
-        /* ISEQUAL.F */
-      case INSTR_ISEQUALF_VAR_VAR:
-        flag = (DEST_VAR_FLOAT == SRC_VAR_FLOAT);
-        ++ip; break;
-
-      case INSTR_ISEQUALF_VAR_FLOAT:
-        flag = (DEST_VAR_FLOAT ==  VALUE_FLOAT);
-        ++ip; break;
-
-        /* ISLOWER.I */
-      case INSTR_ISLOWERI_VAR_VAR:
-        flag = (DEST_VAR_INT < SRC_VAR_INT);
-        ++ip; break;
-
-      case INSTR_ISLOWERI_VAR_INTEGER:
-        flag = (DEST_VAR_INT <  VALUE_INT);
-        ++ip; break;
-
-        /* ISLOWER.F */
-      case INSTR_ISLOWERF_VAR_VAR:
-        flag = (DEST_VAR_FLOAT < SRC_VAR_FLOAT);
-        ++ip; break;
-
-      case INSTR_ISLOWERF_VAR_FLOAT:
-        flag = (DEST_VAR_FLOAT <  VALUE_FLOAT);
-        ++ip; break;
-
-        /* ADD.I */
-      case INSTR_ADDI_VAR_VAR:
-        DEST_VAR_INT += SRC_VAR_INT;
-        ++ip; break;
-
-      case INSTR_ADDI_VAR_INTEGER:
-        DEST_VAR_INT += VALUE_INT;
-        ++ip; break;
-
-        /* ADD.F */
-      case INSTR_ADDF_VAR_VAR:
-        DEST_VAR_FLOAT += SRC_VAR_FLOAT;
-        ++ip; break;
+      /* SET */
+      CASE(MOV_VV): DEST_I = A_VAR_I; NEXT();
+      CASE(MOV_VC): DEST_I = A_I; NEXT();
+
+      /* ADD, SUB, MUL, DIV */
+      ARITH_COMMUTATIVE(ADD, I, +)
+      ARITH_ORDERED(SUB, I, -)
+      ARITH_COMMUTATIVE(MUL, I, *)
+      ARITH_ORDERED(DIV, I, /)
+      ARITH_COMMUTATIVE(ADD, F, +)
+      ARITH_ORDERED(SUB, F, -)
+      ARITH_COMMUTATIVE(MUL, F, *)
+      ARITH_ORDERED(DIV, F, /)
+
+      /* ISEQUAL, ISLOWER */
+      TEST(EQI_VV, A_VAR_I == B_VAR_I)
+      TEST(EQI_VC, A_VAR_I == B_I)
+      TEST(EQF_VV, A_VAR_F == B_VAR_F)
+      TEST(EQF_VC, A_VAR_F == B_F)
+      TEST(LTI_VV, A_VAR_I < B_VAR_I)
+      TEST(LTI_VC, A_VAR_I < B_I)
+      TEST(LTI_CV, A_I < B_VAR_I)
+      TEST(LTF_VV, A_VAR_F < B_VAR_F)
+      TEST(LTF_VC, A_VAR_F < B_F)
+      TEST(LTF_CV, A_F < B_VAR_F)
+
+      /* JUMP, JZERO, JNZERO, NOT */
+      CASE(JUMP): JUMP(ip->u.jump);
+      CASE(JZERO):
+        ip = flag ? ip + 1 : ip->u.jump;
+        DISPATCH();
+      CASE(JNZERO):
+        ip = flag ? ip->u.jump : ip + 1;
+        DISPATCH();
+      CASE(NOT): flag = !flag; NEXT();
+
+      /* CALL, RET */
+      CASE(CALL):
+        if (sp == _this->stack_size) {
+          FastInstruction **stack;
+          if (sp == FAST_STACK_MAX) {
+            fprintf(stderr, "ERROR: Line %d, Too many nested calls\n", ip->proto->line_number);
+            return;
+          }
+          stack = (FastInstruction**)realloc(_this->stack, _this->stack_size * 2 * sizeof(FastInstruction*));
+          if (stack == NULL) {
+            fprintf(stderr, "ERROR: Line %d, Out of memory for nested calls\n", ip->proto->line_number);
+            return;
+          }
+          _this->stack = stack;
+          _this->stack_size *= 2;
+        }
+        _this->stack[sp++] = ip + 1;
+        JUMP(ip->u.jump);
+      CASE(RET):
+        if (sp == 0) return;
+        JUMP(_this->stack[--sp]);
+
+      /* EXT_CALL */
+      CASE(EXT_CALL):
+        ip->u.external_function->function(gsl, gsl->vars, ip->u.external_function->vars);
+        NEXT();
+
+      /* structs */
+      CASE(SETS):
+        memcpy(ip->dest.var, ip->a.var, ip->u.gsl_struct->size);
+        NEXT();
+      STRUCT_OP(ADDS, +=)
+      STRUCT_OP(SUBS, -=)
+      STRUCT_OP(MULS, *=)
+      STRUCT_OP(DIVS, /=)
+      CASE(ISEQUALS): /* not implemented, the flag is left as it is */
+        NEXT();
+
+#ifndef FAST_THREADED
+    }
+  }
+#endif
+#undef TRACE
+#undef CASE
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef ARITH
+#undef ARITH_COMMUTATIVE
+#undef ARITH_ORDERED
+#undef TEST
+#undef STRUCT_OP
+} /* }}} */
 
-      case INSTR_ADDF_VAR_FLOAT:
-        DEST_VAR_FLOAT += VALUE_FLOAT;
-        ++ip; break;
+  /**************************************/
+ /* COMPILATION OF THE FAST INSTRUCTIONS */
+/**************************************/
 
-        /* MUL.I */
-      case INSTR_MULI_VAR_VAR:
-        DEST_VAR_INT *= SRC_VAR_INT;
-        ++ip; break;
+static int fast_is_temp(const char *name)
+{ /* {{{ */
+  /* temporaries of the expressions, which only the expression reads */
+  return (!strncmp(name,"_i_tmp",6))
+    || (!strncmp(name,"_f_tmp",6))
+    || (!strncmp(name,"_p_tmp",6));
+} /* }}} */
 
-      case INSTR_MULI_VAR_INTEGER:
-        DEST_VAR_INT *= VALUE_INT;
-        ++ip; break;
+static void fast_instr_set(FastInstruction *f, int id, void *dest, void *a, InstructionData *data, int b_is_var)
+{ /* {{{ */
+  f->id = id;
+  f->dest.var = dest;
+  f->a.var = a;
+  if (b_is_var)
+    f->b.var = data->usrc.var;
+  else
+    f->b.value_int = data->usrc.value_int;
+} /* }}} */
 
-        /* MUL.F */
-      case INSTR_MULF_VAR_FLOAT:
-        DEST_VAR_FLOAT *= VALUE_FLOAT;
-        ++ip; break;
+/* Translates a validated instruction, returns the index of the instruction
+ * it jumps to or -1 */
+static int fast_instr_translate(FastInstruction *f, Instruction *instr, GoomSL *gsl)
+{ /* {{{ */
+  InstructionData *data = &instr->data;
+  void *dest = data->udest.var;
+
+  memset(f, 0, sizeof(FastInstruction));
+  f->proto = instr;
+
+  switch (instr->id) {
+    case INSTR_SETI_VAR_INTEGER:
+    case INSTR_SETF_VAR_FLOAT:
+    case INSTR_SETP_VAR_PTR:
+      f->id = FAST_MOV_VC;
+      f->dest.var = dest;
+      f->a.value_int = data->usrc.value_int;
+      break;
+    case INSTR_SETI_VAR_VAR:
+    case INSTR_SETF_VAR_VAR:
+    case INSTR_SETP_VAR_VAR:
+      f->id = FAST_MOV_VV;
+      f->dest.var = dest;
+      f->a.var = data->usrc.var;
+      break;
+
+    /* dest op= src is dest = dest op src */
+    case INSTR_ADDI_VAR_VAR:     fast_instr_set(f, FAST_ADDI_VV, dest, dest, data, 1); break;
+    case INSTR_ADDI_VAR_INTEGER: fast_instr_set(f, FAST_ADDI_VC, dest, dest, data, 0); break;
+    case INSTR_SUBI_VAR_VAR:     fast_instr_set(f, FAST_SUBI_VV, dest, dest, data, 1); break;
+    case INSTR_SUBI_VAR_INTEGER: fast_instr_set(f, FAST_SUBI_VC, dest, dest, data, 0); break;
+    case INSTR_MULI_VAR_VAR:     fast_instr_set(f, FAST_MULI_VV, dest, dest, data, 1); break;
+    case INSTR_MULI_VAR_INTEGER: fast_instr_set(f, FAST_MULI_VC, dest, dest, data, 0); break;
+    case INSTR_DIVI_VAR_VAR:     fast_instr_set(f, FAST_DIVI_VV, dest, dest, data, 1); break;
+    case INSTR_DIVI_VAR_INTEGER: fast_instr_set(f, FAST_DIVI_VC, dest, dest, data, 0); break;
+    case INSTR_ADDF_VAR_VAR:     fast_instr_set(f, FAST_ADDF_VV, dest, dest, data, 1); break;
+    case INSTR_ADDF_VAR_FLOAT:   fast_instr_set(f, FAST_ADDF_VC, dest, dest, data, 0); break;
+    case INSTR_SUBF_VAR_VAR:     fast_instr_set(f, FAST_SUBF_VV, dest, dest, data, 1); break;
+    case INSTR_SUBF_VAR_FLOAT:   fast_instr_set(f, FAST_SUBF_VC, dest, dest, data, 0); break;
+    case INSTR_MULF_VAR_VAR:     fast_instr_set(f, FAST_MULF_VV, dest, dest, data, 1); break;
+    case INSTR_MULF_VAR_FLOAT:   fast_instr_set(f, FAST_MULF_VC, dest, dest, data, 0); break;
+    case INSTR_DIVF_VAR_VAR:     fast_instr_set(f, FAST_DIVF_VV, dest, dest, data, 1); break;
+    case INSTR_DIVF_VAR_FLOAT:   fast_instr_set(f, FAST_DIVF_VC, dest, dest, data, 0); break;
+
+    /* tests compare their dest with their src */
+    case INSTR_ISEQUALP_VAR_VAR:
+    case INSTR_ISEQUALI_VAR_VAR:     fast_instr_set(f, FAST_EQI_VV, NULL, dest, data, 1); break;
+    case INSTR_ISEQUALP_VAR_PTR:
+    case INSTR_ISEQUALI_VAR_INTEGER: fast_instr_set(f, FAST_EQI_VC, NULL, dest, data, 0); break;
+    case INSTR_ISEQUALF_VAR_VAR:     fast_instr_set(f, FAST_EQF_VV, NULL, dest, data, 1); break;
+    case INSTR_ISEQUALF_VAR_FLOAT:   fast_instr_set(f, FAST_EQF_VC, NULL, dest, data, 0); break;
+    case INSTR_ISLOWERI_VAR_VAR:     fast_instr_set(f, FAST_LTI_VV, NULL, dest, data, 1); break;
+    case INSTR_ISLOWERI_VAR_INTEGER: fast_instr_set(f, FAST_LTI_VC, NULL, dest, data, 0); break;
+    case INSTR_ISLOWERF_VAR_VAR:     fast_instr_set(f, FAST_LTF_VV, NULL, dest, data, 1); break;
+    case INSTR_ISLOWERF_VAR_FLOAT:   fast_instr_set(f, FAST_LTF_VC, NULL, dest, data, 0); break;
+
+    case INSTR_JUMP:   f->id = FAST_JUMP;   return instr->address + data->udest.jump_offset;
+    case INSTR_JZERO:  f->id = FAST_JZERO;  return instr->address + data->udest.jump_offset;
+    case INSTR_JNZERO: f->id = FAST_JNZERO; return instr->address + data->udest.jump_offset;
+    case INSTR_CALL:   f->id = FAST_CALL;   return instr->address + data->udest.jump_offset;
+    case INSTR_RET:    f->id = FAST_RET;    break;
+    case INSTR_NOT_VAR: f->id = FAST_NOT;   break;
+    case INSTR_EXT_CALL:
+      f->id = FAST_EXT_CALL;
+      f->u.external_function = data->udest.external_function;
+      break;
+
+    /* the struct id is stored just before the struct */
+    case INSTR_SETS_VAR_VAR:     f->id = FAST_SETS;     goto structop;
+    case INSTR_ADDS_VAR_VAR:     f->id = FAST_ADDS;     goto structop;
+    case INSTR_SUBS_VAR_VAR:     f->id = FAST_SUBS;     goto structop;
+    case INSTR_MULS_VAR_VAR:     f->id = FAST_MULS;     goto structop;
+    case INSTR_DIVS_VAR_VAR:     f->id = FAST_DIVS;     goto structop;
+    case INSTR_ISEQUALS_VAR_VAR: f->id = FAST_ISEQUALS; goto structop;
+    structop:
+      f->dest.var = dest;
+      f->a.var = data->usrc.var;
+      f->u.gsl_struct = gsl->gsl_struct[data->udest.var_int[-1]];
+      break;
 
-      case INSTR_MULF_VAR_VAR:
-        DEST_VAR_FLOAT *= SRC_VAR_FLOAT;
-        ++ip; break;
+    default:
+      fprintf(stderr, "ERROR: Line %d, Could not compile instruction %d\n", instr->line_number, instr->id);
+      exit(1);
+  }
+  return -1;
+} /* }}} */
 
-        /* DIV.I */
-      case INSTR_DIVI_VAR_VAR:
-        DEST_VAR_INT /= SRC_VAR_INT;
-        ++ip; break;
+/* Number of instructions reading a variable, skipping the removed ones */
+static int fast_count_reads(FastInstruction *f, int number, void *var)
+{ /* {{{ */
+  int i, reads = 0;
+  for (i = 0; i < number; ++i) {
+    if (f[i].id < 0)
+      continue;
+    if ((fast_kind_a[f[i].id] == 1) && (f[i].a.var == var)) reads++;
+    if ((fast_kind_b[f[i].id] == 1) && (f[i].b.var == var)) reads++;
+    if (FAST_IS_STRUCT_OP(f[i].id) && (f[i].dest.var == var)) reads++;
+  }
+  return reads;
+} /* }}} */
 
-      case INSTR_DIVI_VAR_INTEGER:
-        DEST_VAR_INT /= VALUE_INT;
-        ++ip; break;
+/* Counts the jumps to every instruction */
+static void fast_count_targets(int number, int *target, int *targeted)
+{ /* {{{ */
+  int i;
+  memset(targeted, 0, (number + 1) * sizeof(int));
+  for (i = 0; i < number; ++i)
+    if (target[i] >= 0)
+      targeted[target[i]]++;
+} /* }}} */
 
-        /* DIV.F */
-      case INSTR_DIVF_VAR_FLOAT:
-        DEST_VAR_FLOAT /= VALUE_FLOAT;
-        ++ip; break;
+/* Removes the instructions whose id is -1, jumps to them go to the next
+ * instruction that is left */
+static int fast_remove_dead(FastInstruction *f, int number, int *target, int *index)
+{ /* {{{ */
+  int i, n = 0;
+  for (i = 0; i < number; ++i) {
+    index[i] = n;
+    if (f[i].id >= 0) n++;
+  }
+  index[number] = n;
+  n = 0;
+  for (i = 0; i < number; ++i) {
+    if (f[i].id >= 0) {
+      f[n] = f[i];
+      target[n] = (target[i] >= 0) ? index[target[i]] : -1;
+      n++;
+    }
+  }
+  return n;
+} /* }}} */
 
-      case INSTR_DIVF_VAR_VAR:
-        DEST_VAR_FLOAT /= SRC_VAR_FLOAT;
-        ++ip; break;
+/* Gives the form of an operation once a variable operand is replaced by what
+ * was set to it: a constant or another variable */
+static int fast_form(int id, int a_const, int b_const)
+{ /* {{{ */
+  int base;
+  if (a_const && b_const)
+    return -1;
+  switch (id) {
+    case FAST_ADDI_VV: case FAST_ADDI_VC: base = FAST_ADDI_VV; break;
+    case FAST_MULI_VV: case FAST_MULI_VC: base = FAST_MULI_VV; break;
+    case FAST_ADDF_VV: case FAST_ADDF_VC: base = FAST_ADDF_VV; break;
+    case FAST_MULF_VV: case FAST_MULF_VC: base = FAST_MULF_VV; break;
+    case FAST_EQI_VV: case FAST_EQI_VC: base = FAST_EQI_VV; break;
+    case FAST_EQF_VV: case FAST_EQF_VC: base = FAST_EQF_VV; break;
+    default:
+      /* SUB, DIV and LT have a _VV, _VC and _CV form */
+      if ((id == FAST_SUBI_VV) || (id == FAST_SUBI_VC) || (id == FAST_DIVI_VV) || (id == FAST_DIVI_VC)
+       || (id == FAST_SUBF_VV) || (id == FAST_SUBF_VC) || (id == FAST_DIVF_VV) || (id == FAST_DIVF_VC)
+       || (id == FAST_LTI_VV)  || (id == FAST_LTI_VC)  || (id == FAST_LTF_VV)  || (id == FAST_LTF_VC)) {
+        base = (fast_kind_b[id] == 2) ? id - 1 : id;
+        return base + (a_const ? 2 : b_const ? 1 : 0);
+      }
+      return -1;
+  }
+  /* commutative: the constant goes second */
+  return base + ((a_const || b_const) ? 1 : 0);
+} /* }}} */
 
-        /* SUB.I */
-      case INSTR_SUBI_VAR_VAR:
-        DEST_VAR_INT -= SRC_VAR_INT;
-        ++ip; break;
+/* set tmp, x + tmp = tmp op y => tmp = x op y, and the same for tests on a
+ * temporary */
+static void fast_fuse_set(FastInstruction *f, int number, int *targeted)
+{ /* {{{ */
+  int i;
+  for (i = 0; i + 1 < number; ++i) {
+    FastInstruction *set = &f[i], *op = &f[i+1];
+    int a_const, b_const, id;
+
+    if (((set->id != FAST_MOV_VV) && (set->id != FAST_MOV_VC)) || targeted[i+1])
+      continue;
+    if (FAST_IS_ARITH(op->id)) {
+      if ((op->dest.var != set->dest.var) || (op->a.var != set->dest.var))
+        continue;
+    }
+    else if (FAST_IS_TEST(op->id)) {
+      /* the test does not write the temporary, so nothing else may read it */
+      if ((op->a.var != set->dest.var) || !fast_is_temp(set->proto->params[1])
+       || (fast_count_reads(f, number, set->dest.var) != 1))
+        continue;
+    }
+    else continue;
+    if ((fast_kind_b[op->id] == 1) && (op->b.var == set->dest.var))
+      continue;
+
+    a_const = (set->id == FAST_MOV_VC);
+    b_const = (fast_kind_b[op->id] == 2);
+    id = fast_form(op->id, a_const, b_const);
+    if (id < 0)
+      continue;
+
+    if (a_const && (fast_kind_a[id] == 1)) {
+      /* commutative with a constant first: swap */
+      op->a = op->b;
+      op->b = set->a;
+    }
+    else op->a = set->a;
+    op->id = id;
+    set->id = -1;
+    i++;
+  }
+} /* }}} */
 
-      case INSTR_SUBI_VAR_INTEGER:
-        DEST_VAR_INT -= VALUE_INT;
-        ++ip; break;
+/* tmp = a op b + set x, tmp => x = a op b */
+static void fast_fuse_store(FastInstruction *f, int number, int *targeted)
+{ /* {{{ */
+  int i;
+  for (i = 0; i + 1 < number; ++i) {
+    FastInstruction *op = &f[i], *set = &f[i+1];
+    if (FAST_IS_ARITH(op->id) && (set->id == FAST_MOV_VV) && !targeted[i+1]
+     && (set->a.var == op->dest.var) && fast_is_temp(set->proto->params[0])
+     && (fast_count_reads(f, number, op->dest.var) == 1)) {
+      op->dest = set->dest;
+      set->id = -1;
+      i++;
+    }
+  }
+} /* }}} */
 
-        /* SUB.F */
-      case INSTR_SUBF_VAR_FLOAT:
-        DEST_VAR_FLOAT -= VALUE_FLOAT;
-        ++ip; break;
+/* test + not... + jzero/jnzero => a test that jumps */
+static void fast_fuse_test(FastInstruction *f, int number, int *target, int *targeted)
+{ /* {{{ */
+  int i, j;
+  for (i = 0; i < number; ++i) {
+    int flags = 0;
+    if (!FAST_IS_TEST(f[i].id))
+      continue;
+    for (j = i + 1; (j < number) && (f[j].id == FAST_NOT) && !targeted[j]; ++j)
+      flags ^= FAST_FLAG_NOT;
+    if ((j == number) || targeted[j] || ((f[j].id != FAST_JZERO) && (f[j].id != FAST_JNZERO)))
+      continue;
+    if (f[j].id == FAST_JZERO)
+      flags |= FAST_JUMP_IF_ZERO;
+    f[i].id += FAST_JEQI_VV - FAST_EQI_VV;
+    f[i].flags = flags;
+    target[i] = target[j];
+    for (++i; i <= j; ++i) {
+      f[i].id = -1;
+      target[i] = -1;
+    }
+    --i;
+  }
+} /* }}} */
 
-      case INSTR_SUBF_VAR_VAR:
-        DEST_VAR_FLOAT -= SRC_VAR_FLOAT;
-        ++ip; break;
+/* Jumps to a jump go straight to where it goes, jumps to the next
+ * instruction are removed */
+static void fast_thread_jumps(FastInstruction *f, int number, int *target)
+{ /* {{{ */
+  int i, hops;
+  for (i = 0; i < number; ++i) {
+    if (target[i] < 0)
+      continue;
+    for (hops = 0; (hops < number) && (target[i] < number) && (f[target[i]].id == FAST_JUMP); ++hops)
+      target[i] = target[target[i]];
+  }
+  for (i = 0; i < number; ++i) {
+    if ((f[i].id == FAST_JUMP) && (target[i] == i + 1)) {
+      f[i].id = -1;
+      target[i] = -1;
+    }
+  }
+} /* }}} */
 
-        /* CALL */
-      case INSTR_CALL:
-        stack[stack_pointer++] = ip + 1;
-        ip += JUMP_OFFSET; break;
+static FastInstructionFlow *fast_iflow_new(GoomSL *gsl, InstructionFlow *iflow)
+{ /* {{{ */
+  FastInstructionFlow *_this = (FastInstructionFlow*)malloc(sizeof(FastInstructionFlow));
+  int number = iflow->number;
+  FastInstruction *f = (FastInstruction*)calloc(number + 1, sizeof(FastInstruction));
+  int *target   = (int*)malloc((number + 1) * sizeof(int));
+  int *targeted = (int*)malloc((number + 1) * sizeof(int));
+  int i;
 
-        /* RET */
-      case INSTR_RET:
-        ip = stack[--stack_pointer];
-        if (ip<0) return;
-        break;
+  for (i = 0; i < number; ++i)
+    target[i] = fast_instr_translate(&f[i], iflow->instr[i], gsl);
 
-        /* EXT_CALL */
-      case INSTR_EXT_CALL:
-        instr[ip].data.udest.external_function->function(gsl, gsl->vars, instr[ip].data.udest.external_function->vars);
-        ++ip; break;
+  fast_count_targets(number, target, targeted);
+  fast_fuse_set(f, number, targeted);
+  number = fast_remove_dead(f, number, target, targeted);
 
-        /* NOT */
-      case INSTR_NOT_VAR:
-        flag = !flag;
-        ++ip; break;
+  fast_count_targets(number, target, targeted);
+  fast_fuse_store(f, number, targeted);
+  number = fast_remove_dead(f, number, target, targeted);
 
-        /* JNZERO */
-      case INSTR_JNZERO:
-        ip += (flag ? JUMP_OFFSET : 1); break;
+  fast_count_targets(number, target, targeted);
+  fast_fuse_test(f, number, target, targeted);
+  number = fast_remove_dead(f, number, target, targeted);
 
-      case INSTR_SETS_VAR_VAR:
-        memcpy(pDEST_VAR, pSRC_VAR, DEST_STRUCT_SIZE);
-        ++ip; break;
+  fast_thread_jumps(f, number, target);
+  number = fast_remove_dead(f, number, target, targeted);
 
-      case INSTR_ISEQUALS_VAR_VAR:
-        break;
+  /* a last ret, for the labels at the very end */
+  memset(&f[number], 0, sizeof(FastInstruction));
+  f[number].id = FAST_RET;
+  target[number] = -1;
 
-      case INSTR_ADDS_VAR_VAR:
-        /* process integers */
-        i=0;
-        while (DEST_STRUCT_IBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_IBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_IBLOCK_VAR(i,j) += SRC_STRUCT_IBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        /* process floats */
-        i=0;
-        while (DEST_STRUCT_FBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_FBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_FBLOCK_VAR(i,j) += SRC_STRUCT_FBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        ++ip; break;
+  for (i = 0; i <= number; ++i)
+    if (target[i] >= 0)
+      f[i].u.jump = &f[target[i]];
 
-      case INSTR_SUBS_VAR_VAR:
-        /* process integers */
-        i=0;
-        while (DEST_STRUCT_IBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_IBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_IBLOCK_VAR(i,j) -= SRC_STRUCT_IBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        /* process floats */
-        i=0;
-        while (DEST_STRUCT_FBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_FBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_FBLOCK_VAR(i,j) -= SRC_STRUCT_FBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        ++ip; break;
+  _this->number = number + 1;
+  _this->instr = f;
+  _this->stack_size = 64;
+  _this->stack = (FastInstruction**)malloc(_this->stack_size * sizeof(FastInstruction*));
+  iflow_execute(_this, NULL);
 
-      case INSTR_MULS_VAR_VAR:
-        /* process integers */
-        i=0;
-        while (DEST_STRUCT_IBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_IBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_IBLOCK_VAR(i,j) *= SRC_STRUCT_IBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        /* process floats */
-        i=0;
-        while (DEST_STRUCT_FBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_FBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_FBLOCK_VAR(i,j) *= SRC_STRUCT_FBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        ++ip; break;
-        
-      case INSTR_DIVS_VAR_VAR:
-        /* process integers */
-        i=0;
-        while (DEST_STRUCT_IBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_IBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_IBLOCK_VAR(i,j) /= SRC_STRUCT_IBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        /* process floats */
-        i=0;
-        while (DEST_STRUCT_FBLOCK(i).size > 0) {
-          int j=DEST_STRUCT_FBLOCK(i).size;
-          while (j--) {
-            DEST_STRUCT_FBLOCK_VAR(i,j) /= SRC_STRUCT_FBLOCK_VAR(i,j);
-          }
-          ++i;
-        }
-        ++ip; break;
+  free(target);
+  free(targeted);
+  return _this;
+} /* }}} */
 
-      default:
-        printf("NOT IMPLEMENTED : %d\n", instr[ip].id);
-        ++ip;
-        exit(1);
-    }
-  }
+static void fast_iflow_free(FastInstructionFlow *_this)
+{ /* {{{ */
+  free(_this->instr);
+  free(_this->stack);
+  free(_this);
 } /* }}} */
 
 int gsl_malloc(GoomSL *_this, int size)
@@ -927,9 +1184,9 @@ static int powerOfTwo(int i)
 /* Cree un flow d'instruction optimise */
 static void gsl_create_fast_iflow(void)
 { /* {{{ */
+#ifdef USE_JITC_X86
   int number = currentGoomSL->iflow->number;
   int i;
-#ifdef USE_JITC_X86
 
   /* pour compatibilite avec les MACROS servant a execution */
   int ip = 0;
@@ -942,7 +1199,8 @@ static void gsl_create_fast_iflow(void)
   jitc = currentGoomSL->jitc = jitc_x86_env_new(0xffff);
   currentGoomSL->jitc_func = jitc_prepare_func(jitc);
 
-#if 0  
+#define pSRC_VAR       instr->data.usrc.var
+#define pDEST_VAR      instr->data.udest.var
 #define SRC_STRUCT_ID  instr[ip].data.usrc.var_int[-1]
 #define DEST_STRUCT_ID instr[ip].data.udest.var_int[-1]
 #define SRC_STRUCT_IBLOCK(i)  gsl->gsl_struct[SRC_STRUCT_ID]->iBlock[i]
@@ -958,7 +1216,6 @@ static void gsl_create_fast_iflow(void)
 #define SRC_STRUCT_FBLOCK_VAR(i,j) \
   ((float*)((char*)pSRC_VAR  + gsl->gsl_struct[SRC_STRUCT_ID]->fBlock[i].data))[j]
 #define DEST_STRUCT_SIZE      gsl->gsl_struct[DEST_STRUCT_ID]->size
-#endif
 
   JITC_JUMP_LABEL(jitc, "__very_end__");
   JITC_ADD_LABEL (jitc, "__very_start__");
@@ -1268,18 +1525,9 @@ static void gsl_create_fast_iflow(void)
   jitc_add(jitc, "mov eax, $d", 0);
   jitc_validate_func(jitc);
 #else
-  InstructionFlow     *iflow     = currentGoomSL->iflow;
-  FastInstructionFlow *fastiflow = (FastInstructionFlow*)malloc(sizeof(FastInstructionFlow));
-  fastiflow->mallocedInstr = calloc(number*16, sizeof(FastInstruction));
-  /* fastiflow->instr = (FastInstruction*)(((int)fastiflow->mallocedInstr) + 16 - (((int)fastiflow->mallocedInstr)%16)); */
-  fastiflow->instr = (FastInstruction*)fastiflow->mallocedInstr;
-  fastiflow->number = number;
-  for(i=0;i<number;++i) {
-    fastiflow->instr[i].id    = iflow->instr[i]->id;
-    fastiflow->instr[i].data  = iflow->instr[i]->data;
-    fastiflow->instr[i].proto = iflow->instr[i];
-  }
-  currentGoomSL->fastiflow = fastiflow;
+  if (currentGoomSL->fastiflow != NULL)
+    fast_iflow_free(currentGoomSL->fastiflow);
+  currentGoomSL->fastiflow = fast_iflow_new(currentGoomSL, currentGoomSL->iflow);
 #endif
 } /* }}} */
 
@@ -1398,6 +1646,7 @@ GoomSL *gsl_new(void)
   gss->nbPtr=0;
   gss->ptrArraySize=256;
   gss->ptrArray = (void**)malloc(gss->ptrArraySize * sizeof(void*));
+  gss->fastiflow = NULL;
 #ifdef USE_JITC_X86
   gss->jitc = NULL;
 #endif
@@ -1422,6 +1671,8 @@ int gsl_is_compiled(GoomSL *gss)
 void gsl_free(GoomSL *gss)
 { /* {{{ */
   iflow_free(gss->iflow);
+  if (gss->fastiflow != NULL)
+    fast_iflow_free(gss->fastiflow);
   free(gss->vars);
   free(gss->functions);
   free(gss);
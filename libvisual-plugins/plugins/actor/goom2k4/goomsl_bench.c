@@ -0,0 +1,126 @@
+#include <libvisual/libvisual.h>
+
+#include "goomsl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RUNS 1000000
+
+/* The state machine of default_script.goom, in GoomSL. The sound inputs are
+ * set by the host before every run, as goom does every frame. */
+static const char *flash_script =
+	"float goom_detection\n"
+	"float sound_speed\n"
+	"float speedvar\n"
+	"float factor\n"
+	"float cur_power\n"
+	"int locked\n"
+	"int flashing_up\n"
+	"int flash_occurs\n"
+	"float max_flash = 200%\n"
+	"float slow_down_coef = 96%\n"
+	"\n"
+	"flash_occurs = 0\n"
+	"(goom_detection > 50%) ? {\n"
+	"  (sound_speed > 14%) ? flash_occurs = 1\n"
+	"}\n"
+	"(locked > 0) ? locked -= 1\n"
+	"(locked = 0) ? {\n"
+	"  (flash_occurs = 1) ? {\n"
+	"    cur_power = goom_detection\n"
+	"    flashing_up = 1\n"
+	"  }\n"
+	"  (flashing_up = 1) ? {\n"
+	"    factor += cur_power * 2.0 * (speedvar / 4.0 + 0.95)\n"
+	"    (factor > max_flash) ? factor = max_flash\n"
+	"    (flash_occurs = 0) ? {\n"
+	"      locked = 200\n"
+	"      flashing_up = 0\n"
+	"    }\n"
+	"  }\n"
+	"}\n"
+	"factor *= slow_down_coef\n";
+
+static void bench_flash (int runs)
+{
+	GoomSL *gsl = gsl_new ();
+	VisTimer timer;
+	float *goom_detection, *sound_speed, *speedvar;
+	int i;
+
+	gsl_compile (gsl, flash_script);
+
+	goom_detection = &GSL_GLOBAL_FLOAT (gsl, "goom_detection");
+	sound_speed = &GSL_GLOBAL_FLOAT (gsl, "sound_speed");
+	speedvar = &GSL_GLOBAL_FLOAT (gsl, "speedvar");
+
+	GSL_GLOBAL_FLOAT (gsl, "factor") = 0.0f;
+	GSL_GLOBAL_FLOAT (gsl, "cur_power") = 0.0f;
+	GSL_GLOBAL_INT (gsl, "locked") = 0;
+	GSL_GLOBAL_INT (gsl, "flashing_up") = 0;
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < runs; i++) {
+		*goom_detection = (i % 100) / 100.0f;
+		*sound_speed = (i % 30) / 100.0f;
+		*speedvar = *sound_speed * 2.0f;
+
+		gsl_execute (gsl);
+	}
+
+	printf ("%-30s %8.1f ns per run, factor %f\n", "flash state machine",
+			visual_timer_elapsed_usecs (&timer) * 1000.0 / runs, GSL_GLOBAL_FLOAT (gsl, "factor"));
+
+	gsl_free (gsl);
+}
+
+static void bench_file (const char *file_name, int runs)
+{
+	GoomSL *gsl = gsl_new ();
+	VisTimer timer;
+	char *buffer;
+	int i;
+
+	buffer = gsl_init_buffer (file_name);
+	gsl_compile (gsl, buffer);
+	free (buffer);
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < runs; i++)
+		gsl_execute (gsl);
+
+	printf ("%-30s %8.1f ns per run\n", file_name, visual_timer_elapsed_usecs (&timer) * 1000.0 / runs);
+
+	gsl_free (gsl);
+}
+
+/* Times the compiled GoomSL scripts, run over and over like goom runs its
+ * scripts every frame. Without scripts, the state machine of
+ * default_script.goom is run.
+ *
+ * usage: goomsl_bench [runs] [script.gsl ...] */
+int main (int argc, char **argv)
+{
+	int runs = RUNS;
+	int i;
+
+	visual_init (&argc, &argv);
+
+	if (argc > 1)
+		runs = atoi (argv[1]);
+
+	if (argc > 2) {
+		for (i = 2; i < argc; i++)
+			bench_file (argv[i], runs);
+	} else
+		bench_flash (runs);
+
+	visual_quit ();
+
+	return 0;
+}
@@ -1,3 +1,5 @@
+#include <libvisual/libvisual.h>
+
 #include "goomsl_hash.h"
 #include <string.h>
 #include <stdlib.h>
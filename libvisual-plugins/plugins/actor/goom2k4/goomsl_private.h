@@ -126,16 +126,34 @@ typedef struct _INSTRUCTION_FLOW { /* {{{ */
     GoomHash *labels;
 } InstructionFlow;
 /* }}} */
+typedef union _FAST_OPERAND { /* {{{ */
+  void  *var;
+  int   *var_int;
+  float *var_float;
+  int    value_int;
+  float  value_float;
+} FastOperand;
+/* }}} */
 typedef struct _FAST_INSTRUCTION { /* {{{ */
+  const void *handler; /* address of the code of the instruction, for direct threading */
   int id;
-  InstructionData data;
+  int flags;           /* how fused tests set the flag and jump */
+  FastOperand dest;
+  FastOperand a;       /* dest = a op b, or the compared operands */
+  FastOperand b;
+  union {
+    struct _FAST_INSTRUCTION *jump;
+    struct _ExternalFunctionStruct *external_function;
+    struct _GSL_Struct *gsl_struct;
+  } u;
   Instruction *proto;
 } FastInstruction;
 /* }}} */
 typedef struct _FastInstructionFlow { /* {{{ */
   int number;
   FastInstruction *instr;
-  void *mallocedInstr;
+  FastInstruction **stack; /* return addresses of calls */
+  int stack_size;
 } FastInstructionFlow;
 /* }}} */
 typedef struct _ExternalFunctionStruct { /* {{{ */
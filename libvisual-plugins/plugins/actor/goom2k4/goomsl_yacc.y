@@ -7,6 +7,7 @@
     #include <stdio.h>
     #include <stdlib.h>
     #include <string.h>
+    #include <limits.h>
     #include "goomsl.h"
     #include "goomsl_private.h"
 
@@ -445,6 +446,66 @@
         commit_node(set->unode.opr.op[1],1);
     } /* }}} */
 
+    /* Computes an operation between two constants of the same type at compile
+     * time, the way the instructions would at run time, and redefines the
+     * expression as the resulting constant. Returns 0 if it can not. */
+    static int fold_const_expr(NodeType *expr, int instr_id)
+    { /* {{{ */
+        NodeType *op1, *op2, *result;
+        char sval[256];
+
+        if (expr->unode.opr.nbOp != 2)
+            return 0;
+        op1 = expr->unode.opr.op[0];
+        op2 = expr->unode.opr.op[1];
+
+        if ((op1->type == CONST_INT_NODE) && (op2->type == CONST_INT_NODE)) {
+            /* parsed as the instructions parse their parameters */
+            int a = strtol(op1->str,NULL,0);
+            int b = strtol(op2->str,NULL,0);
+            int r;
+            switch (instr_id) {
+                case INSTR_ADD: r = (int)((unsigned int)a + (unsigned int)b); break;
+                case INSTR_SUB: r = (int)((unsigned int)a - (unsigned int)b); break;
+                case INSTR_MUL: r = (int)((unsigned int)a * (unsigned int)b); break;
+                case INSTR_DIV:
+                    if ((b == 0) || ((b == -1) && (a == INT_MIN))) return 0;
+                    r = a / b; break;
+                default: return 0;
+            }
+            sprintf(sval, "%d", r);
+            result = new_constInt(sval, expr->line_number);
+        }
+        else if ((op1->type == CONST_FLOAT_NODE) && (op2->type == CONST_FLOAT_NODE)) {
+            float a = atof(op1->str);
+            float b = atof(op2->str);
+            float r;
+            switch (instr_id) {
+                case INSTR_ADD: r = a + b; break;
+                case INSTR_SUB: r = a - b; break;
+                case INSTR_MUL: r = a * b; break;
+                case INSTR_DIV:
+                    if (b == 0.0f) return 0;
+                    r = a / b; break;
+                default: return 0;
+            }
+            /* 9 digits give back the same float */
+            sprintf(sval, "%.9g", r);
+            result = new_constFloat(sval, expr->line_number);
+        }
+        else return 0;
+
+#ifdef VERBOSE
+        printf("folded %s %s %s into %s\n", op1->str, expr->str, op2->str, result->str);
+#endif
+        nodeFree(op1);
+        nodeFree(op2);
+        nodeFreeInternals(expr);
+        *expr = *result;
+        free(result);
+        return 1;
+    } /* }}} */
+
     /* commodity method for add, mult, ... */
 
     static void precommit_expr(NodeType *expr, const char *type, int instr_id)
@@ -460,6 +521,9 @@
           precommit_node(expr->unode.opr.op[0]);
         }
 
+        if (fold_const_expr(expr, instr_id))
+            return;
+
         if (is_tmp_expr(expr->unode.opr.op[0])) {
             tmp = expr->unode.opr.op[0];
             toAdd = 1;
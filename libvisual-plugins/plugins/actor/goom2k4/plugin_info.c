@@ -1,3 +1,5 @@
+#include <libvisual/libvisual.h>
+
 #include "goom_plugin_info.h"
 #include "goom_fx.h"
 #include "cpu_info.h"
@@ -28,6 +30,7 @@ static void setOptimizedMethods(PluginInfo *p) {
     /* set default methods */
     p->methods.draw_line = draw_line;
     p->methods.zoom_filter = zoom_filter_c;
+    p->methods.zoom_filter_rows = zoom_filter_c_rows;
 /*    p->methods.create_output_with_brightness = create_output_with_brightness;*/
 
 #ifdef CPU_X86
@@ -37,6 +40,7 @@ static void setOptimizedMethods(PluginInfo *p) {
 #endif
 		p->methods.draw_line = draw_line_mmx;
 		p->methods.zoom_filter = zoom_filter_xmmx;
+		p->methods.zoom_filter_rows = NULL;
 	}
 	else if (cpuFlavour & CPU_OPTION_MMX) {
 #ifdef VERBOSE
@@ -44,27 +48,48 @@ static void setOptimizedMethods(PluginInfo *p) {
 #endif
 		p->methods.draw_line = draw_line_mmx;
 		p->methods.zoom_filter = zoom_filter_mmx;
+		p->methods.zoom_filter_rows = NULL;
 	}
 #ifdef VERBOSE
         else
             printf ("Too bad ! No SIMD optimization available for your CPU.\n");
 #endif
 #endif /* CPU_X86 */
+
+	/* Supersede the MMX zoom, which does not split the frame */
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (visual_cpu_get_avx2 ()) {
+		p->methods.zoom_filter = zoom_filter_c;
+		p->methods.zoom_filter_rows = zoom_filter_avx2_rows;
+	}
+	else if (visual_cpu_get_sse2 ()) {
+		p->methods.zoom_filter = zoom_filter_c;
+		p->methods.zoom_filter_rows = zoom_filter_sse2_rows;
+	}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	if (visual_cpu_get_neon ())
+		p->methods.zoom_filter_rows = zoom_filter_neon_rows;
+#endif
 	
 #ifdef CPU_POWERPC
 
         if ((cpuFlavour & CPU_OPTION_64_BITS) != 0) {
 /*            p->methods.create_output_with_brightness = ppc_brightness_G5;        */
             p->methods.zoom_filter = ppc_zoom_generic;
+            p->methods.zoom_filter_rows = NULL;
         }
         else if ((cpuFlavour & CPU_OPTION_ALTIVEC) != 0) {
 /*            p->methods.create_output_with_brightness = ppc_brightness_G4;        */
             p->methods.zoom_filter = ppc_zoom_G4;
+            p->methods.zoom_filter_rows = NULL;
         }
         else
         {
 /*            p->methods.create_output_with_brightness = ppc_brightness_generic;*/
             p->methods.zoom_filter = ppc_zoom_generic;
+            p->methods.zoom_filter_rows = NULL;
         }        
 #endif /* CPU_POWERPC */
 
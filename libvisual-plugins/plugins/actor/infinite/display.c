@@ -53,140 +53,6 @@ void _inf_change_color(InfinitePrivate *priv, int t2,int t1,int w)
 	}
 }
 
-static void _inf_compute_surface(InfinitePrivate *priv, t_interpol* vector_field)
-{
-	int i,j;
-	int add_dest=0,add_src;
-	t_interpol *interpol;
-	register uint8_t* ptr_pix;
-	int color = 0;
-	uint8_t* ptr_swap;
-
-	/* FIXME OK we're going to take a different approach:
-	 * have a whole set of interpolate buffers:
-	 * every buffer containing one element, the different weights, the upper and lower part of
-	 * the interpolation coords etc, with this setup it's MUCH easier to vectorize it damn hard.
-	 */
-
-	/* FIXME ok this sucked, is een mislukte actie geweest zie ik, omdat ik mmx regs te kort kwam
-	 * zat ik met restore problemen, waardoor het uiteindelijk even snel werd, moet de hele blur routine
-	 * van deze plugin from scratch doen... */
-	if (0) {
-#if 0
-#if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
-		int add_src2[2];
-		uint8_t *ptr_pix2[2];
-		int plugwidth = priv->plugwidth;
-		uint8_t *ptr_surf = priv->surface1;
-		int aflag = 0xffff;
-
-		/* Prep general used regs, mm6 as empty (un)packer, mm7 to contain plugwidth for packed words
-		 * and we use mm5 to contain 0x0000ffff0000ffff */
-		__asm __volatile
-			("\n\t movd %[plugw], %%mm6"
-			 "\n\t movd %[plugw], %%mm7"
-			 "\n\t movd %[aflag], %%mm5"
-			 "\n\t movd %[aflag], %%mm4"
-
-			 "\n\t psllq $32, %%mm6"
-			 "\n\t por %%mm6, %%mm7"
-
-			 "\n\t psllq $32, %%mm4"
-			 "\n\t por %%mm4, %%mm5"
-
-			 "\n\t pxor %%mm6, %%mm6"
-			 "\n\t pxor %%mm4, %%mm4"
-			 :: [plugw] "m" (plugwidth)
-			 , [aflag] "m" (aflag));
-
-		for (j = 0; j < priv->plugheight; j++) {
-			for (i = 0; i < priv->plugwidth; i += 2) {
-				int coords[2];
-
-				interpol = (vector_field += 2); // load 4 from.
-
-				coords[0] = interpol[0].coord;
-				coords[1] = interpol[1].coord;
-
-//				return;
-//				add_src = (interpol->coord & 0xFFFF) * priv->plugwidth + (interpol->coord >> 16); // pack and do in mmx!
-
-//				ptr_pix = priv->surface1 + add_src; // pack and do in mmx!
-
-				/* Do in two pieces! (first coords 0, 1, then 2, 3) */
-				__asm __volatile (
-						"\n\t movq %[interpol], %%mm0"	/* Start loading in the babies */
-						"\n\t movq %[interpol], %%mm1"
-
-						"\n\t psrld $16, %%mm0" /* the >> 16 coord elems */
-						"\n\t pand %%mm5, %%mm1" /* 0xffff coord elems */
-						"\n\t pmullw %%mm7, %%mm1" /* multiply with plugwidth */
-						"\n\t paddd %%mm0, %%mm1" /* Ading >> 16 coords. mm1 now contains the right addsrc offset */
-
-						"\n\t movd %[surf1], %%mm0"
-						"\n\t movd %[surf1], %%mm4"
-						"\n\t psllq $32, %%mm0"
-						"\n\t por %%mm4, %%mm0" /* Contains the ptr_surf 2 times */
-						"\n\t paddd %%mm1, %%mm0" /* Now contains the right ptr_pix2 value */
-
-						"\n\t movq %%mm0, %[pix]"
-						:: [interpol] "m" (*(coords))
-						, [addsrc2] "m" (add_src2)
-						, [surf1] "m" (ptr_surf)
-						, [pix] "m" (*ptr_pix2));
-				int color1 = 0, color2 = 0;
-/*				int color1 = (*(ptr_pix2[0])
-						+ *(ptr_pix2[0] + 1)
-						+ *(ptr_pix2[0] + priv->plugwidth)
-						+ *(ptr_pix2[0] + priv->plugwidth + 1));
-
-				int color2 = (*(ptr_pix2[1])
-						+ *(ptr_pix2[1] + 1)
-						+ *(ptr_pix2[1] + priv->plugwidth)
-						+ *(ptr_pix2[1] + priv->plugwidth + 1));
-*/
-				priv->surface2[add_dest] = color1;
-				priv->surface2[add_dest + 1] = color2;
-
-				add_dest += 2;
-			}
-		}
-
-		__asm __volatile
-			("emms");
-#endif /* #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64) */
-#endif /* #if 0 */
-	} else {
-		for (j=0;j<priv->plugheight;j++) {
-			for (i=0;i<priv->plugwidth;i++) {
-				interpol = &vector_field[add_dest];
-				add_src = (interpol->coord & 0xffff) * priv->plugwidth + (interpol->coord >> 16);
-				ptr_pix = priv->surface1 + add_src;;
-
-				/* FIXME it does buffer overread here now and then */
-
-				color= (*(ptr_pix) *                       (interpol->weight >> 24)
-					+*(ptr_pix + 1) *                   ((interpol->weight & 0xFFFFFF) >> 16)
-					+*(ptr_pix + priv->plugwidth) *     ((interpol->weight & 0xFFFF) >> 8)
-					+*(ptr_pix + priv->plugwidth + 1) * (interpol->weight & 0xFF)) >> 8;
-/*
-				color= (*(ptr_pix) // *                       (interpol->weight >> 24)
-					+*(ptr_pix + 1) // *                   ((interpol->weight & 0xFFFFFF) >> 16)
-					+*(ptr_pix + priv->plugwidth) // *     ((interpol->weight & 0xFFFF) >> 8)
-					+*(ptr_pix + priv->plugwidth + 1)); // * (interpol->weight & 0xFF)) >> 8;
-
-*/				priv->surface2[add_dest]=color;
-				add_dest++;
-			}
-		}
-	}
-
-
-	ptr_swap=priv->surface1;
-	priv->surface1=priv->surface2;
-	priv->surface2=ptr_swap;
-}
-
 void _inf_display (InfinitePrivate *priv, uint8_t *surf, int pitch)
 {
 	int i;
@@ -199,9 +65,15 @@ void _inf_display (InfinitePrivate *priv, uint8_t *surf, int pitch)
 	}
 }
 
-void _inf_blur(InfinitePrivate *priv, t_interpol* vector_field)
+void _inf_blur(InfinitePrivate *priv, VisWarpField* vector_field)
 {
-	_inf_compute_surface(priv, vector_field);
+	uint8_t* ptr_swap;
+
+	visual_warp_field_apply_8(vector_field, priv->surface2, priv->surface1, priv->plugwidth);
+
+	ptr_swap=priv->surface1;
+	priv->surface1=priv->surface2;
+	priv->surface2=ptr_swap;
 }
 
 static void _inf_plot1(InfinitePrivate *priv, int x,int y,int c)
@@ -427,11 +299,8 @@ void _inf_init_display(InfinitePrivate *priv)
 	priv->plugwidth = priv->plugwidth;
 	priv->plugheight = priv->plugheight;
 
-	/* Yes we alloc a bit more because there is some odd race buffer overrun which i (the porter)
-	 * am to lazy to debug */
-	allocsize = (priv->plugwidth * priv->plugheight) + (priv->plugwidth * 2);
+	allocsize = priv->plugwidth * priv->plugheight;
 
 	priv->surface1 = (uint8_t *) visual_mem_malloc0(allocsize);
 	priv->surface2 = (uint8_t *) visual_mem_malloc0(allocsize);
 }
-
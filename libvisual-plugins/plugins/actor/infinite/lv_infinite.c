@@ -161,16 +161,18 @@ static int act_infinite_dimension (VisPluginData *plugin, VisVideo *video, int w
 	visual_return_val_if_fail (video != NULL, -1);
 
 	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
-	priv->plugwidth = width;
-	priv->plugheight = height;
 
 	visual_video_set_dimension (video, width, height);
 
-	_inf_close_renderer (priv);
-
+	/* Keep the renderer as it is, it draws nothing else than 8 bits */
 	if (video->depth != VISUAL_VIDEO_DEPTH_8BIT)
 		return -1;
 
+	_inf_close_renderer (priv);
+
+	priv->plugwidth = width;
+	priv->plugheight = height;
+
 	_inf_init_renderer (priv);
 
 	return 0;
@@ -4,6 +4,7 @@
 #include <libvisual/libvisual.h>
 
 #define NB_PALETTES 5
+#define NB_FCT 7
 
 struct infinite_col {
 	uint8_t r;
@@ -19,11 +20,6 @@ typedef struct t_complex {
 	float x,y;
 } t_complex;
 
-typedef struct t_interpol {
-	uint32_t coord ;  //coordinates of the top left pixel.
-	uint32_t weight; //32 bits = 4*8= weights of the four corners
-} t_interpol;
-
 typedef struct t_effect {
 	int num_effect;
 	int x_curve;
@@ -58,7 +54,7 @@ typedef struct {
 	int t_last_effect;
 
 	t_effect current_effect;
-	t_interpol *vector_field;
+	VisWarpField *vector_field[NB_FCT];
 } InfinitePrivate;
 
 #endif /* _INF_MAIN_H */
@@ -28,7 +28,9 @@
 #include <libvisual/libvisual.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <errno.h>
 
 
 #include <alsa/version.h>
@@ -40,23 +42,52 @@
 
 #include <libvisual/libvisual.h>
 
-#define PCM_BUF_SIZE 4096
+/* Rate asked for when the device runs at more than one */
+#define ALSA_PREFERRED_RATE	48000
+
+/* Enough buffer that uploads a few frames apart never overrun */
+#define ALSA_BUFFER_TIME	500000
+#define ALSA_PERIOD_TIME	10000
 
 const VisPluginInfo *get_plugin_info (int *count);
 
 typedef struct {
-	snd_pcm_t *chandle;
-	int loaded;
+	snd_pcm_t			*chandle;
+	char				*device;	/* The device that is open */
+
+	int				 mmap;		/* Captured in place, else read into samples */
+	snd_pcm_format_t		 format;
+	VisAudioSampleFormatType	 sampleformat;
+	VisAudioSampleRateType		 samplerate;
+	unsigned int			 rate;
+	unsigned int			 channels;
+	int				 framesize;
+
+	uint8_t				*samples;	/* Read buffer without mmap */
+	snd_pcm_uframes_t		 samples_frames;
 } alsaPrivate;
 
 static int inp_alsa_init (VisPluginData *plugin);
 static int inp_alsa_cleanup (VisPluginData *plugin);
+static int inp_alsa_events (VisPluginData *plugin, VisEventQueue *events);
 static int inp_alsa_upload (VisPluginData *plugin, VisAudio *audio);
 
-static const int  inp_alsa_var_btmul      = sizeof (short);
-static const char *inp_alsa_var_cdevice   = "hw:0,0";
-static const int  inp_alsa_var_samplerate = 44100;
-static const int  inp_alsa_var_channels   = 2;
+static int alsa_open (alsaPrivate *priv, const char *device);
+static void alsa_close (alsaPrivate *priv);
+static int alsa_recover (alsaPrivate *priv, int err);
+static void alsa_input (alsaPrivate *priv, VisAudio *audio, void *data, snd_pcm_uframes_t frames);
+
+static const char *inp_alsa_var_cdevice   = "default";
+
+/* Formats in order of preference, native endian */
+static const struct {
+	snd_pcm_format_t		format;
+	VisAudioSampleFormatType	sampleformat;
+} inp_alsa_formats[] = {
+	{ SND_PCM_FORMAT_FLOAT,	VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT },
+	{ SND_PCM_FORMAT_S32,	VISUAL_AUDIO_SAMPLE_FORMAT_S32 },
+	{ SND_PCM_FORMAT_S16,	VISUAL_AUDIO_SAMPLE_FORMAT_S16 }
+};
 
 VISUAL_PLUGIN_API_VERSION_VALIDATOR
 
@@ -72,13 +103,14 @@ const VisPluginInfo *get_plugin_info (int *count)
 		.plugname = "alsa",
 		.name = "alsa",
 		.author = "Vitaly V. Bursov <vitalyvb@urk.net>",
-		.version = "0.1",
+		.version = "0.2",
 		.about = N_("ALSA capture plugin"),
 		.help = N_("Use this plugin to capture PCM data from the ALSA record device"),
 		.license = VISUAL_PLUGIN_LICENSE_LGPL,
 
 		.init = inp_alsa_init,
 		.cleanup = inp_alsa_cleanup,
+		.events = inp_alsa_events,
 
 		.plugin = VISUAL_OBJECT (&input[0])
 	}};
@@ -90,13 +122,13 @@ const VisPluginInfo *get_plugin_info (int *count)
 
 int inp_alsa_init (VisPluginData *plugin)
 {
-	snd_pcm_hw_params_t *hwparams = NULL;
+	VisParamContainer *paramcontainer = visual_plugin_get_params (plugin);
 	alsaPrivate *priv;
-	unsigned int rate = inp_alsa_var_samplerate;
-	unsigned int exact_rate;
-	unsigned int tmp;
-	int dir;
-	int err;
+
+	static VisParamEntry params[] = {
+		VISUAL_PARAM_LIST_ENTRY_STRING ("device", ""),
+		VISUAL_PARAM_LIST_END
+	};
 
 #if ENABLE_NLS
 	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
@@ -109,166 +141,297 @@ int inp_alsa_init (VisPluginData *plugin)
 
 	visual_object_set_private (VISUAL_OBJECT (plugin), priv);
 
-	if ((err = snd_pcm_open(&priv->chandle, visual_strdup(inp_alsa_var_cdevice),
+	visual_param_container_add_many (paramcontainer, params);
+	visual_param_entry_set_string (visual_param_container_get (paramcontainer, "device"),
+			(char *) inp_alsa_var_cdevice);
+
+	return alsa_open (priv, inp_alsa_var_cdevice);
+}
+
+int inp_alsa_cleanup (VisPluginData *plugin)
+{
+	alsaPrivate *priv = NULL;
+
+	visual_return_val_if_fail(plugin != NULL, -1);
+	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	visual_return_val_if_fail(priv != NULL, -1);
+
+	alsa_close (priv);
+
+	visual_mem_free (priv);
+
+	return 0;
+}
+
+int inp_alsa_events (VisPluginData *plugin, VisEventQueue *events)
+{
+	alsaPrivate *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	VisEvent ev;
+
+	while (visual_event_queue_poll (events, &ev)) {
+		switch (ev.type) {
+			case VISUAL_EVENT_PARAM: {
+				VisParamEntry *param = ev.event.param.param;
+				const char *device;
+
+				if (!visual_param_entry_is (param, "device"))
+					break;
+
+				device = visual_param_entry_get_string (param);
+
+				if (device == NULL || device[0] == '\0')
+					device = inp_alsa_var_cdevice;
+
+				if (priv->device == NULL || strcmp (device, priv->device) != 0)
+					alsa_open (priv, device);
+
+				break;
+			}
+
+			default: /* to avoid warnings */
+				break;
+		}
+	}
+
+	return 0;
+}
+
+/* Never blocks: takes whatever the device captured since the last upload */
+int inp_alsa_upload (VisPluginData *plugin, VisAudio *audio)
+{
+	alsaPrivate *priv = NULL;
+	snd_pcm_sframes_t avail;
+
+	visual_return_val_if_fail(audio != NULL, -1);
+	visual_return_val_if_fail(plugin != NULL, -1);
+	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	visual_return_val_if_fail(priv != NULL, -1);
+
+	if (priv->chandle == NULL)
+		return -1;
+
+	if (!priv->mmap) {
+		snd_pcm_sframes_t rcnt;
+
+		while ((rcnt = snd_pcm_readi (priv->chandle, priv->samples, priv->samples_frames)) != 0) {
+			if (rcnt == -EAGAIN)
+				break;
+
+			if (rcnt < 0) {
+				if (alsa_recover (priv, rcnt) < 0)
+					return -1;
+
+				continue;
+			}
+
+			alsa_input (priv, audio, priv->samples, rcnt);
+		}
+
+		return 0;
+	}
+
+	if ((avail = snd_pcm_avail_update (priv->chandle)) < 0) {
+		if (alsa_recover (priv, avail) < 0)
+			return -1;
+
+		avail = 0;
+	}
+
+	while (avail > 0) {
+		const snd_pcm_channel_area_t *areas;
+		snd_pcm_uframes_t offset;
+		snd_pcm_uframes_t frames = avail;
+		snd_pcm_sframes_t committed;
+		int err;
+
+		if ((err = snd_pcm_mmap_begin (priv->chandle, &areas, &offset, &frames)) < 0) {
+			if (alsa_recover (priv, err) < 0)
+				return -1;
+
+			break;
+		}
+
+		/* The samplepool converts straight out of the device buffer */
+		alsa_input (priv, audio, (uint8_t *) areas[0].addr + (areas[0].first + offset * areas[0].step) / 8,
+				frames);
+
+		committed = snd_pcm_mmap_commit (priv->chandle, offset, frames);
+
+		if (committed < 0 || (snd_pcm_uframes_t) committed != frames) {
+			if (alsa_recover (priv, committed >= 0 ? -EPIPE : committed) < 0)
+				return -1;
+
+			break;
+		}
+
+		avail -= frames;
+	}
+
+	return 0;
+}
+
+static void alsa_input (alsaPrivate *priv, VisAudio *audio, void *data, snd_pcm_uframes_t frames)
+{
+	VisBuffer buffer;
+
+	visual_buffer_init (&buffer, data, frames * priv->framesize, NULL);
+
+	if (priv->channels == 2) {
+		visual_audio_samplepool_input (audio->samplepool, &buffer, priv->samplerate,
+				priv->sampleformat, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
+	} else {
+		visual_audio_samplepool_input_channel (audio->samplepool, &buffer, priv->samplerate,
+				priv->sampleformat, VISUAL_AUDIO_CHANNEL_LEFT);
+		visual_audio_samplepool_input_channel (audio->samplepool, &buffer, priv->samplerate,
+				priv->sampleformat, VISUAL_AUDIO_CHANNEL_RIGHT);
+	}
+}
+
+/* Restarts the capture after an overrun or a suspend */
+static int alsa_recover (alsaPrivate *priv, int err)
+{
+	if (err == -EPIPE)
+		visual_log(VISUAL_LOG_WARNING, _("ALSA: Buffer Overrun"));
+
+	if ((err = snd_pcm_recover (priv->chandle, err, 1)) >= 0 &&
+			snd_pcm_state (priv->chandle) == SND_PCM_STATE_PREPARED)
+		err = snd_pcm_start (priv->chandle);
+
+	if (err < 0) {
+		visual_log(VISUAL_LOG_ERROR, _("Failed to prepare interface: %s"), snd_strerror (err));
+
+		alsa_close (priv);
+
+		return -1;
+	}
+
+	return 0;
+}
+
+static int alsa_open (alsaPrivate *priv, const char *device)
+{
+	snd_pcm_hw_params_t *hwparams = NULL;
+	unsigned int rate = ALSA_PREFERRED_RATE;
+	unsigned int channels = 2;
+	unsigned int tmp;
+	int dir = 0;
+	int err;
+	int i;
+
+	alsa_close (priv);
+
+	if ((err = snd_pcm_open(&priv->chandle, device,
 			SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK)) < 0) {
 		visual_log(VISUAL_LOG_ERROR,
 			    _("Record open error: %s"), snd_strerror(err));
+		priv->chandle = NULL;
 		return -1;
 	}
 
-	snd_pcm_hw_params_malloc(&hwparams);
-	visual_return_val_if_fail(hwparams != NULL, -1);
+	priv->device = visual_strdup (device);
+
+	snd_pcm_hw_params_alloca(&hwparams);
 
 	if (snd_pcm_hw_params_any(priv->chandle, hwparams) < 0) {
 		visual_log(VISUAL_LOG_ERROR,
 			   _("Cannot configure this PCM device"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-	if (snd_pcm_hw_params_set_access(priv->chandle, hwparams,
+	/* Capture in place when the device allows, else read */
+	priv->mmap = snd_pcm_hw_params_set_access(priv->chandle, hwparams,
+					 SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+
+	if (!priv->mmap && snd_pcm_hw_params_set_access(priv->chandle, hwparams,
 					 SND_PCM_ACCESS_RW_INTERLEAVED) < 0) {
 		visual_log(VISUAL_LOG_ERROR, _("Error setting access"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-#ifdef VISUAL_LITTLE_ENDIAN
-	if (snd_pcm_hw_params_set_format(priv->chandle, hwparams,
-					 SND_PCM_FORMAT_S16_LE) < 0) {
-#else
-	if (snd_pcm_hw_params_set_format(priv->chandle, hwparams,
-					 SND_PCM_FORMAT_S16_BE) < 0) {
-#endif
+	for (i = 0; i < VISUAL_TABLESIZE (inp_alsa_formats); i++) {
+		if (snd_pcm_hw_params_set_format(priv->chandle, hwparams, inp_alsa_formats[i].format) == 0)
+			break;
+	}
+
+	if (i == VISUAL_TABLESIZE (inp_alsa_formats)) {
 		visual_log(VISUAL_LOG_ERROR, _("Error setting format"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-	exact_rate = rate;
+	priv->format = inp_alsa_formats[i].format;
+	priv->sampleformat = inp_alsa_formats[i].sampleformat;
+
+	/* Run at the rate of the hardware instead of resampling in alsa-lib */
+	snd_pcm_hw_params_set_rate_resample(priv->chandle, hwparams, 0);
 
 	if (snd_pcm_hw_params_set_rate_near(priv->chandle, hwparams,
-					    &exact_rate, &dir) < 0) {
+					    &rate, &dir) < 0) {
 		visual_log(VISUAL_LOG_ERROR, _("Error setting rate"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
-	}
-	if (exact_rate != rate) {
-		visual_log(VISUAL_LOG_INFO,
-			   _("The rate %d Hz is not supported by your " \
-			   "hardware.\n" \
-			   "==> Using %d Hz instead"), rate, exact_rate);
+		goto error;
 	}
-	rate = exact_rate;
 
-	if (snd_pcm_hw_params_set_channels(priv->chandle, hwparams,
-					   inp_alsa_var_channels) < 0) {
+	if (snd_pcm_hw_params_set_channels_near(priv->chandle, hwparams,
+					   &channels) < 0 || channels > 2) {
 	        visual_log(VISUAL_LOG_ERROR, _("Error setting channels"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-       /* Setup a large buffer */
+	tmp = ALSA_BUFFER_TIME;
+	if (snd_pcm_hw_params_set_buffer_time_near(priv->chandle, hwparams, &tmp, &dir) < 0){
+		visual_log(VISUAL_LOG_ERROR, _("Error setting buffer time"));
+		goto error;
+	}
 
-	tmp = 1000000;
+	tmp = ALSA_PERIOD_TIME;
 	if (snd_pcm_hw_params_set_period_time_near(priv->chandle, hwparams, &tmp, &dir) < 0){
 		visual_log(VISUAL_LOG_ERROR, _("Error setting period time"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-	tmp = 1000000*4;
-	if (snd_pcm_hw_params_set_buffer_time_near(priv->chandle, hwparams, &tmp, &dir) < 0){
-		visual_log(VISUAL_LOG_ERROR, _("Error setting buffer time"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+	if (snd_pcm_hw_params(priv->chandle, hwparams) < 0) {
+		visual_log(VISUAL_LOG_ERROR, _("Error setting HW params"));
+		goto error;
 	}
 
+	priv->rate = rate;
+	priv->channels = channels;
+	priv->framesize = snd_pcm_format_physical_width (priv->format) / 8 * channels;
 
-	if (snd_pcm_hw_params(priv->chandle, hwparams) < 0) {
-		visual_log(VISUAL_LOG_ERROR, _("Error setting HW params"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+	priv->samplerate = visual_audio_sample_rate_from_hz (rate);
+
+	if (!priv->mmap) {
+		snd_pcm_hw_params_get_buffer_size (hwparams, &priv->samples_frames);
+		priv->samples = visual_mem_malloc (priv->samples_frames * priv->framesize);
 	}
 
-	if (snd_pcm_prepare(priv->chandle) < 0) {
+	if (snd_pcm_prepare(priv->chandle) < 0 || snd_pcm_start(priv->chandle) < 0) {
 		visual_log(VISUAL_LOG_ERROR, _("Failed to prepare interface"));
-		snd_pcm_hw_params_free(hwparams);
-		return(-1);
+		goto error;
 	}
 
-	snd_pcm_hw_params_free(hwparams);
-
-	priv->loaded = 1;
+	visual_log(VISUAL_LOG_INFO, _("Capturing from %s: %s, %u Hz, %u channels%s"), device,
+			snd_pcm_format_name (priv->format), rate, channels, priv->mmap ? ", mmap" : "");
 
 	return 0;
-}
-
-int inp_alsa_cleanup (VisPluginData *plugin)
-{
-	alsaPrivate *priv = NULL;
 
-	visual_return_val_if_fail(plugin != NULL, -1);
-	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
-	visual_return_val_if_fail(priv != NULL, -1);
+error:
+	alsa_close (priv);
 
-	if (priv->loaded == 1)
-		snd_pcm_close(priv->chandle);
-
-	visual_mem_free (priv);
-
-	return 0;
+	return -1;
 }
 
-int inp_alsa_upload (VisPluginData *plugin, VisAudio *audio)
+static void alsa_close (alsaPrivate *priv)
 {
-	int16_t data[PCM_BUF_SIZE];
-	alsaPrivate *priv = NULL;
-	int rcnt;
-
-	visual_return_val_if_fail(audio != NULL, -1);
-	visual_return_val_if_fail(plugin != NULL, -1);
-	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
-	visual_return_val_if_fail(priv != NULL, -1);
-
-#if 0
-	{	/* DEBUG STUFF, REMOVE IN RELEASE FIXME FIXME XXX TODO WHATEVER */
-		VisBuffer buffer;
-
-		visual_buffer_init (&buffer, data, 512, NULL);
-
-		for (i = 0; i < 16; i++) {
-			visual_audio_samplepool_input (audio->samplepool, &buffer, VISUAL_AUDIO_SAMPLE_RATE_44100,
-					VISUAL_AUDIO_SAMPLE_FORMAT_S16, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
-		}
-		return 0;
-	}
-#endif
-	do {
-		rcnt = snd_pcm_readi(priv->chandle, data, PCM_BUF_SIZE / 2);
-
-		if (rcnt > 0) {
-			VisBuffer buffer;
+	if (priv->chandle != NULL)
+		snd_pcm_close(priv->chandle);
 
-			visual_buffer_init (&buffer, data, rcnt, NULL);
+	if (priv->device != NULL)
+		visual_mem_free (priv->device);
 
-			visual_audio_samplepool_input (audio->samplepool, &buffer, VISUAL_AUDIO_SAMPLE_RATE_44100,
-					VISUAL_AUDIO_SAMPLE_FORMAT_S16, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
-		}
+	if (priv->samples != NULL)
+		visual_mem_free (priv->samples);
 
-		if (rcnt < 0) {
-			if (rcnt == -EPIPE) {
-				visual_log(VISUAL_LOG_WARNING, _("ALSA: Buffer Overrun"));
-
-				if (snd_pcm_prepare(priv->chandle) < 0) {
-					visual_log(VISUAL_LOG_ERROR,
-							_("Failed to prepare interface"));
-					return(-1);
-				}
-			}
-		}
-	} while (rcnt > 0);
-
-	return 0;
+	priv->chandle = NULL;
+	priv->device = NULL;
+	priv->samples = NULL;
 }
-
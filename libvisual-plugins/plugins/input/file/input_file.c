@@ -0,0 +1,662 @@
+/* Libvisual-plugins - Standard plugins for libvisual
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "config.h"
+#include "gettext.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <libvisual/libvisual.h>
+
+/* Bytes read from the file at once */
+#define READ_CHUNK		(64 * 1024)
+
+/* Bytes the kernel is asked to read in front of the current position */
+#define READ_AHEAD		(1024 * 1024)
+
+#define DEFAULT_RATE		44100
+#define DEFAULT_CHANNELS	2
+
+typedef enum {
+	FILE_SAMPLE_U8,
+	FILE_SAMPLE_S16,
+	FILE_SAMPLE_S24,
+	FILE_SAMPLE_S32,
+	FILE_SAMPLE_F32
+} FileSampleType;
+
+typedef struct {
+	int		 fd;
+
+	FileSampleType	 type;
+	int		 rate;
+	int		 channels;
+	int		 framesize;
+	int		 raw;
+
+	off_t		 data_start;	/* Offset of the first frame */
+	off_t		 data_end;	/* Offset past the last frame */
+	off_t		 offset;	/* Offset of the next read */
+	off_t		 advised;	/* End of the range the kernel was asked to read ahead */
+
+	uint8_t		*chunk;
+	int		 chunk_fill;
+	int		 chunk_pos;
+
+	float		*samples;	/* Interleaved stereo */
+	int		 samples_frames;
+
+	int		 upload_samples;
+	int		 loop;
+	int		 eof;
+
+	VisTime		 start;		/* Pacing when uploading in real time */
+	uint64_t	 uploaded;
+
+	VisParamEntry	*eof_param;
+} FilePriv;
+
+const VisPluginInfo *get_plugin_info (int *count);
+
+static int inp_file_init (VisPluginData *plugin);
+static int inp_file_cleanup (VisPluginData *plugin);
+static int inp_file_events (VisPluginData *plugin, VisEventQueue *events);
+static int inp_file_upload (VisPluginData *plugin, VisAudio *audio);
+
+static int file_open (VisPluginData *plugin);
+static void file_close (FilePriv *priv);
+static int file_seek (FilePriv *priv, float seconds);
+static int file_read_frames (FilePriv *priv, float *dest, int frames);
+static int file_at_end (FilePriv *priv);
+static void file_set_eof (FilePriv *priv, int eof);
+
+VISUAL_PLUGIN_API_VERSION_VALIDATOR
+
+const VisPluginInfo *get_plugin_info (int *count)
+{
+	static VisInputPlugin input[] = {{
+		.upload = inp_file_upload
+	}};
+
+	static VisPluginInfo info[] = {{
+		.type     = VISUAL_PLUGIN_TYPE_INPUT,
+		.plugname = "file",
+		.name     = "file",
+		.author   = "Libvisual team",
+		.version  = "0.1",
+		.about    = N_("file input plugin"),
+		.help     = N_("Reads PCM audio from a WAV file, or a raw s16 or f32 file. "
+				"With \"upload samples\" set, every upload takes exactly that many "
+				"samples from the file, for offline rendering, otherwise the file "
+				"is played in real time."),
+		.license  = VISUAL_PLUGIN_LICENSE_LGPL,
+
+		.init     = inp_file_init,
+		.cleanup  = inp_file_cleanup,
+		.events   = inp_file_events,
+		.plugin   = VISUAL_OBJECT (&input[0])
+	}};
+
+	*count = VISUAL_TABLESIZE (info);
+
+	return info;
+}
+
+static int inp_file_init (VisPluginData *plugin)
+{
+	FilePriv *priv;
+	VisParamEntry *param;
+	VisParamContainer *paramcontainer = visual_plugin_get_params (plugin);
+
+	static VisParamEntry params[] = {
+		VISUAL_PARAM_LIST_ENTRY_STRING  ("filename",       ""),
+		VISUAL_PARAM_LIST_ENTRY_STRING  ("format",         "auto"),
+		VISUAL_PARAM_LIST_ENTRY_INTEGER ("rate",           DEFAULT_RATE),
+		VISUAL_PARAM_LIST_ENTRY_INTEGER ("channels",       DEFAULT_CHANNELS),
+		VISUAL_PARAM_LIST_ENTRY_INTEGER ("upload samples", 0),
+		VISUAL_PARAM_LIST_ENTRY_INTEGER ("loop",           0),
+		VISUAL_PARAM_LIST_ENTRY_FLOAT   ("seek",           0),
+		VISUAL_PARAM_LIST_ENTRY_INTEGER ("end of file",    0),
+		VISUAL_PARAM_LIST_END
+	};
+
+#if ENABLE_NLS
+	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+#endif
+
+	priv = visual_mem_new0 (FilePriv, 1);
+	visual_object_set_private (VISUAL_OBJECT (plugin), priv);
+
+	priv->fd = -1;
+	priv->chunk = visual_mem_malloc (READ_CHUNK);
+
+	visual_param_container_add_many (paramcontainer, params);
+
+	param = visual_param_container_get (paramcontainer, "rate");
+	visual_param_entry_min_set_integer (param, 1);
+	visual_param_entry_max_set_integer (param, 384000);
+
+	param = visual_param_container_get (paramcontainer, "channels");
+	visual_param_entry_min_set_integer (param, 1);
+	visual_param_entry_max_set_integer (param, 32);
+
+	param = visual_param_container_get (paramcontainer, "upload samples");
+	visual_param_entry_min_set_integer (param, 0);
+
+	param = visual_param_container_get (paramcontainer, "seek");
+	visual_param_entry_min_set_float (param, 0);
+
+	priv->eof_param = visual_param_container_get (paramcontainer, "end of file");
+
+	return 0;
+}
+
+static int inp_file_cleanup (VisPluginData *plugin)
+{
+	FilePriv *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+
+	file_close (priv);
+
+	visual_mem_free (priv->chunk);
+
+	if (priv->samples != NULL)
+		visual_mem_free (priv->samples);
+
+	visual_mem_free (priv);
+
+	return 0;
+}
+
+static int inp_file_events (VisPluginData *plugin, VisEventQueue *events)
+{
+	FilePriv *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	VisEvent ev;
+	int reopen = FALSE;
+	int seek = FALSE;
+	float position = 0;
+
+	while (visual_event_queue_poll (events, &ev)) {
+		switch (ev.type) {
+			case VISUAL_EVENT_PARAM: {
+				VisParamEntry *param = ev.event.param.param;
+
+				/* The file is opened once all the parameters describing it are in,
+				 * the rate and channels only describe raw files */
+				if (visual_param_entry_is (param, "filename") ||
+						visual_param_entry_is (param, "format")) {
+					reopen = TRUE;
+				} else if (visual_param_entry_is (param, "rate") ||
+						visual_param_entry_is (param, "channels")) {
+					reopen |= priv->raw;
+				} else if (visual_param_entry_is (param, "upload samples")) {
+					priv->upload_samples = visual_param_entry_get_integer (param);
+				} else if (visual_param_entry_is (param, "loop")) {
+					priv->loop = visual_param_entry_get_integer (param);
+				} else if (visual_param_entry_is (param, "seek")) {
+					position = visual_param_entry_get_float (param);
+					seek = TRUE;
+				}
+
+				break;
+			}
+
+			default: /* to avoid warnings */
+				break;
+		}
+	}
+
+	/* A file that can't be read ends right away */
+	if (reopen && file_open (plugin) < 0)
+		file_set_eof (priv, TRUE);
+
+	if (seek && priv->fd >= 0)
+		file_seek (priv, position);
+
+	return 0;
+}
+
+static int inp_file_upload (VisPluginData *plugin, VisAudio *audio)
+{
+	FilePriv *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	VisBuffer buffer;
+	int frames;
+	int got;
+
+	if (priv->fd < 0)
+		return -1;
+
+	if (priv->upload_samples > 0) {
+		frames = priv->upload_samples;
+	} else {
+		VisTime now;
+		VisTime diff;
+		uint64_t due;
+
+		visual_time_init (&now);
+		visual_time_init (&diff);
+		visual_time_get (&now);
+		visual_time_difference (&diff, &priv->start, &now);
+
+		due = ((uint64_t) diff.sec * VISUAL_USEC_PER_SEC + diff.usec) * priv->rate / VISUAL_USEC_PER_SEC;
+
+		/* Don't try to catch up with more than a quarter second after a stall */
+		if (due - priv->uploaded > (uint64_t) priv->rate / 4)
+			priv->uploaded = due - priv->rate / 4;
+
+		frames = due - priv->uploaded;
+		priv->uploaded = due;
+	}
+
+	if (frames == 0)
+		return 0;
+
+	if (frames > priv->samples_frames) {
+		if (priv->samples != NULL)
+			visual_mem_free (priv->samples);
+
+		priv->samples = visual_mem_malloc (frames * 2 * sizeof (float));
+		priv->samples_frames = frames;
+	}
+
+	got = file_read_frames (priv, priv->samples, frames);
+
+	while (got < frames && priv->loop) {
+		int more;
+
+		if (file_seek (priv, 0) < 0)
+			break;
+
+		more = file_read_frames (priv, priv->samples + got * 2, frames - got);
+
+		/* An empty file */
+		if (more == 0)
+			break;
+
+		got += more;
+	}
+
+	/* The end is flagged with the upload that takes the last samples */
+	if (got < frames || (!priv->loop && file_at_end (priv)))
+		file_set_eof (priv, TRUE);
+
+	if (got == 0)
+		return 0;
+
+	visual_buffer_init (&buffer, priv->samples, got * 2 * sizeof (float), NULL);
+
+	visual_audio_samplepool_input (audio->samplepool, &buffer, visual_audio_sample_rate_from_hz (priv->rate),
+			VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
+
+	return 0;
+}
+
+static uint16_t read_le16 (const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t read_le32 (const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static int read_full (int fd, void *dest, int size)
+{
+	int done = 0;
+
+	while (done < size) {
+		ssize_t got = read (fd, (uint8_t *) dest + done, size - done);
+
+		if (got < 0 && errno == EINTR)
+			continue;
+
+		if (got <= 0)
+			break;
+
+		done += got;
+	}
+
+	return done;
+}
+
+/* Asks the kernel to keep READ_AHEAD bytes in front of the read position in the
+ * page cache, so the reads don't wait for the disk. The window is moved ahead in
+ * steps of half its size to keep the number of calls down. */
+static void file_read_ahead (FilePriv *priv)
+{
+#if defined(POSIX_FADV_WILLNEED)
+	off_t start;
+
+	if (priv->advised - priv->offset >= READ_AHEAD / 2)
+		return;
+
+	start = priv->advised > priv->offset ? priv->advised : priv->offset;
+
+	posix_fadvise (priv->fd, start, priv->offset + READ_AHEAD - start, POSIX_FADV_WILLNEED);
+
+	priv->advised = priv->offset + READ_AHEAD;
+#endif
+}
+
+static int file_parse_wav (FilePriv *priv, off_t filesize)
+{
+	uint8_t header[12];
+	uint8_t chunk[8];
+	uint8_t fmt[40];
+	uint32_t size;
+	off_t pos = 12;
+	int format = 0;
+	int bits = 0;
+
+	if (read_full (priv->fd, header, 12) != 12 ||
+			memcmp (header, "RIFF", 4) != 0 || memcmp (header + 8, "WAVE", 4) != 0)
+		return -1;
+
+	for (;;) {
+		if (read_full (priv->fd, chunk, 8) != 8)
+			return -1;
+
+		size = read_le32 (chunk + 4);
+		pos += 8;
+
+		if (memcmp (chunk, "fmt ", 4) == 0) {
+			int n = size < sizeof (fmt) ? size : sizeof (fmt);
+
+			if (size < 16 || read_full (priv->fd, fmt, n) != n)
+				return -1;
+
+			format = read_le16 (fmt);
+			priv->channels = read_le16 (fmt + 2);
+			priv->rate = read_le32 (fmt + 4);
+			bits = read_le16 (fmt + 14);
+
+			/* WAVE_FORMAT_EXTENSIBLE, the format is in the subformat GUID */
+			if (format == 0xfffe && n >= 26)
+				format = read_le16 (fmt + 24);
+
+		} else if (memcmp (chunk, "data", 4) == 0) {
+			if (format == 0)
+				return -1;
+
+			priv->data_start = pos;
+
+			/* Streamed files leave the size at 0 or -1 */
+			if (size == 0 || size == 0xffffffff || pos + size > filesize)
+				priv->data_end = filesize;
+			else
+				priv->data_end = pos + size;
+
+			break;
+		}
+
+		pos += size + (size & 1);
+
+		if (lseek (priv->fd, pos, SEEK_SET) != pos)
+			return -1;
+	}
+
+	if (format == 1 && bits == 8)
+		priv->type = FILE_SAMPLE_U8;
+	else if (format == 1 && bits == 16)
+		priv->type = FILE_SAMPLE_S16;
+	else if (format == 1 && bits == 24)
+		priv->type = FILE_SAMPLE_S24;
+	else if (format == 1 && bits == 32)
+		priv->type = FILE_SAMPLE_S32;
+	else if (format == 3 && bits == 32)
+		priv->type = FILE_SAMPLE_F32;
+	else {
+		visual_log (VISUAL_LOG_WARNING, _("Unsupported WAV sample format %d with %d bits"), format, bits);
+
+		return -1;
+	}
+
+	if (priv->channels < 1 || priv->rate < 1)
+		return -1;
+
+	priv->framesize = priv->channels * (bits / 8);
+
+	return 0;
+}
+
+static int file_open (VisPluginData *plugin)
+{
+	FilePriv *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	VisParamContainer *paramcontainer = visual_plugin_get_params (plugin);
+	const char *filename;
+	const char *format;
+	struct stat st;
+	uint8_t magic[4];
+
+	file_close (priv);
+
+	filename = visual_param_entry_get_string (visual_param_container_get (paramcontainer, "filename"));
+	format = visual_param_entry_get_string (visual_param_container_get (paramcontainer, "format"));
+
+	if (filename == NULL || filename[0] == '\0')
+		return 0;
+
+	priv->fd = open (filename, O_RDONLY);
+
+	if (priv->fd < 0 || fstat (priv->fd, &st) < 0) {
+		visual_log (VISUAL_LOG_WARNING, _("Could not open file '%s': %s"), filename, strerror (errno));
+
+		file_close (priv);
+
+		return -1;
+	}
+
+	if (format == NULL || strcmp (format, "auto") == 0) {
+		if (read_full (priv->fd, magic, 4) == 4 && memcmp (magic, "RIFF", 4) == 0)
+			format = "wav";
+		else
+			format = "s16";
+
+		lseek (priv->fd, 0, SEEK_SET);
+	}
+
+	if (strcmp (format, "wav") == 0) {
+		if (file_parse_wav (priv, st.st_size) < 0) {
+			visual_log (VISUAL_LOG_WARNING, _("File '%s' is not a WAV file we can read"), filename);
+
+			file_close (priv);
+
+			return -1;
+		}
+
+		/* Let the application know what the file holds */
+		priv->raw = FALSE;
+		visual_param_entry_set_integer (visual_param_container_get (paramcontainer, "rate"), priv->rate);
+		visual_param_entry_set_integer (visual_param_container_get (paramcontainer, "channels"), priv->channels);
+	} else if (strcmp (format, "s16") == 0 || strcmp (format, "f32") == 0) {
+		priv->raw = TRUE;
+		priv->type = format[0] == 's' ? FILE_SAMPLE_S16 : FILE_SAMPLE_F32;
+		priv->rate = visual_param_entry_get_integer (visual_param_container_get (paramcontainer, "rate"));
+		priv->channels = visual_param_entry_get_integer (visual_param_container_get (paramcontainer, "channels"));
+		priv->framesize = priv->channels * (priv->type == FILE_SAMPLE_S16 ? 2 : 4);
+		priv->data_start = 0;
+		priv->data_end = st.st_size;
+	} else {
+		visual_log (VISUAL_LOG_WARNING, _("Unknown file format '%s'"), format);
+
+		file_close (priv);
+
+		return -1;
+	}
+
+	visual_log (VISUAL_LOG_INFO, _("Reading '%s': %d Hz, %d channels, %ld frames"), filename,
+			priv->rate, priv->channels, (long) ((priv->data_end - priv->data_start) / priv->framesize));
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+	posix_fadvise (priv->fd, priv->data_start, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	return file_seek (priv, 0);
+}
+
+static void file_close (FilePriv *priv)
+{
+	if (priv->fd >= 0)
+		close (priv->fd);
+
+	priv->fd = -1;
+	priv->chunk_fill = 0;
+	priv->chunk_pos = 0;
+}
+
+static int file_seek (FilePriv *priv, float seconds)
+{
+	off_t offset = priv->data_start + (off_t) (seconds * priv->rate) * priv->framesize;
+
+	if (offset > priv->data_end)
+		offset = priv->data_end;
+
+	if (lseek (priv->fd, offset, SEEK_SET) != offset)
+		return -1;
+
+	priv->offset = offset;
+	priv->advised = offset;
+	priv->chunk_fill = 0;
+	priv->chunk_pos = 0;
+
+	file_read_ahead (priv);
+
+	visual_time_init (&priv->start);
+	visual_time_get (&priv->start);
+	priv->uploaded = 0;
+
+	file_set_eof (priv, FALSE);
+
+	return 0;
+}
+
+/* Refills the chunk, keeping a partial frame at its end */
+static int file_fill (FilePriv *priv)
+{
+	int left = priv->chunk_fill - priv->chunk_pos;
+	off_t want = READ_CHUNK - left;
+	int got;
+
+	memmove (priv->chunk, priv->chunk + priv->chunk_pos, left);
+	priv->chunk_fill = left;
+	priv->chunk_pos = 0;
+
+	if (want > priv->data_end - priv->offset)
+		want = priv->data_end - priv->offset;
+
+	if (want <= 0)
+		return 0;
+
+	got = read_full (priv->fd, priv->chunk + left, want);
+
+	priv->offset += got;
+	priv->chunk_fill += got;
+
+	file_read_ahead (priv);
+
+	return got;
+}
+
+static inline float file_sample (const uint8_t *p, FileSampleType type)
+{
+	union {
+		uint32_t i;
+		float f;
+	} u;
+
+	switch (type) {
+		case FILE_SAMPLE_U8:
+			return (p[0] - 128) / 128.0f;
+
+		case FILE_SAMPLE_S16:
+			return (int16_t) read_le16 (p) / 32768.0f;
+
+		case FILE_SAMPLE_S24:
+			return (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) /
+				2147483648.0f;
+
+		case FILE_SAMPLE_S32:
+			return (int32_t) read_le32 (p) / 2147483648.0f;
+
+		case FILE_SAMPLE_F32:
+			u.i = read_le32 (p);
+
+			return u.f;
+	}
+
+	return 0;
+}
+
+/* Decodes to interleaved stereo, mono is doubled and of more channels the front
+ * left and right ones, which come first, are taken */
+static int file_read_frames (FilePriv *priv, float *dest, int frames)
+{
+	int samplesize = priv->framesize / priv->channels;
+	int right = priv->channels > 1 ? samplesize : 0;
+	int done = 0;
+
+	while (done < frames) {
+		const uint8_t *p;
+		int avail = (priv->chunk_fill - priv->chunk_pos) / priv->framesize;
+		int n;
+		int i;
+
+		if (avail == 0) {
+			if (file_fill (priv) == 0)
+				break;
+
+			continue;
+		}
+
+		n = frames - done < avail ? frames - done : avail;
+		p = priv->chunk + priv->chunk_pos;
+
+		for (i = 0; i < n; i++) {
+			*dest++ = file_sample (p, priv->type);
+			*dest++ = file_sample (p + right, priv->type);
+
+			p += priv->framesize;
+		}
+
+		priv->chunk_pos += n * priv->framesize;
+		done += n;
+	}
+
+	return done;
+}
+
+static int file_at_end (FilePriv *priv)
+{
+	return priv->offset >= priv->data_end && priv->chunk_fill - priv->chunk_pos < priv->framesize;
+}
+
+static void file_set_eof (FilePriv *priv, int eof)
+{
+	if (priv->eof == eof)
+		return;
+
+	priv->eof = eof;
+
+	visual_param_entry_set_integer (priv->eof_param, eof);
+}
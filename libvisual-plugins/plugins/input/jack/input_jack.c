@@ -31,31 +31,41 @@
 #include <gettext.h>
 
 #include <jack/jack.h>
+#include <jack/ringbuffer.h>
 
 #include <libvisual/libvisual.h>
 
-#define PCM_BUF_SIZE	1024
+/* Frames the ring between the process callback and the upload holds, over a
+ * second at 48 kHz. Frames are interleaved stereo floats */
+#define JACK_RING_FRAMES	65536
+#define JACK_FRAME_SIZE		(2 * sizeof (float))
 
 const VisPluginInfo *get_plugin_info (int *count);
 
 typedef struct {
-	jack_client_t	*client;
-	jack_port_t	*input_port;
+	jack_client_t		*client;
+	jack_port_t		*input_ports[2];
 
-	int		 shutdown;
+	jack_ringbuffer_t	*ring;		/* Written by the process callback, read by the upload */
+	float			*samples;	/* Upload buffer, JACK_RING_FRAMES frames */
 
-	VisBuffer	*buffer;
+	volatile int		 shutdown;
+	volatile int		 rate;		/* Sample rate of the server */
 
-	short		 fakebuf[PCM_BUF_SIZE];
+	volatile unsigned int	 overruns;	/* Process cycles that found the ring full */
+	unsigned int		 overruns_reported;
 } JackPrivate;
 
 static int process_callback (jack_nframes_t nframes, void *arg);
+static int sample_rate_callback (jack_nframes_t nframes, void *arg);
 static void shutdown_callback (void *arg);
 
 static int inp_jack_init (VisPluginData *plugin);
 static int inp_jack_cleanup (VisPluginData *plugin);
 static int inp_jack_upload (VisPluginData *plugin, VisAudio *audio);
 
+static int jack_connect_capture (JackPrivate *priv);
+
 VISUAL_PLUGIN_API_VERSION_VALIDATOR
 
 const VisPluginInfo *get_plugin_info (int *count)
@@ -70,7 +80,7 @@ const VisPluginInfo *get_plugin_info (int *count)
 		.plugname = "jack",
 		.name = "jack",
 		.author = "Dennis Smit <ds@nerds-incorporated.org>",
-		.version = "0.1",
+		.version = "0.2",
 		.about = N_("Jackit capture plugin"),
 		.help = N_("Use this plugin to capture PCM data from the jackd daemon"),
 		.license = VISUAL_PLUGIN_LICENSE_LGPL,
@@ -89,7 +99,7 @@ const VisPluginInfo *get_plugin_info (int *count)
 static int inp_jack_init (VisPluginData *plugin)
 {
 	JackPrivate *priv;
-	const char **ports;
+	jack_status_t status;
 
 #if ENABLE_NLS
 	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
@@ -101,54 +111,66 @@ static int inp_jack_init (VisPluginData *plugin)
 	visual_return_val_if_fail (priv != NULL, -1);
 	visual_object_set_private (VISUAL_OBJECT (plugin), priv);
 
-	if ((priv->client = jack_client_new (_("Libvisual jackit capture"))) == NULL) {
+	if ((priv->client = jack_client_open ("libvisual", JackNoStartServer, &status)) == NULL) {
 		visual_log (VISUAL_LOG_ERROR, _("jack server probably not running"));
 		return -1;
 	}
 
-	jack_set_process_callback (priv->client, process_callback, priv);
-	jack_on_shutdown (priv->client, shutdown_callback, priv);
+	priv->rate = jack_get_sample_rate (priv->client);
 
-	priv->input_port = jack_port_register (priv->client, "input", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+	/* Everything the process callback touches is set up before activating, it
+	 * runs in the realtime thread and must not allocate or block */
+	priv->ring = jack_ringbuffer_create (JACK_RING_FRAMES * JACK_FRAME_SIZE);
+	priv->samples = visual_mem_malloc (JACK_RING_FRAMES * JACK_FRAME_SIZE);
 
-	if (jack_activate (priv->client) == 1) {
-		visual_log (VISUAL_LOG_ERROR, _("Cannot activate the jack client"));
+	if (priv->ring == NULL || priv->samples == NULL) {
+		visual_log (VISUAL_LOG_ERROR, _("Cannot allocate the capture buffer"));
 
 		return -1;
 	}
 
-	if ((ports = jack_get_ports (priv->client, NULL, NULL, JackPortIsPhysical|JackPortIsOutput)) == NULL) {
-		visual_log (VISUAL_LOG_ERROR, _("Cannot find any physical capture ports"));
+	jack_ringbuffer_mlock (priv->ring);
+
+	priv->input_ports[0] = jack_port_register (priv->client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+	priv->input_ports[1] = jack_port_register (priv->client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+
+	if (priv->input_ports[0] == NULL || priv->input_ports[1] == NULL) {
+		visual_log (VISUAL_LOG_ERROR, _("Cannot register the input ports"));
 
 		return -1;
 	}
 
-	if (jack_connect (priv->client, ports[0], jack_port_name (priv->input_port))) {
-		visual_log (VISUAL_LOG_ERROR, _("Cannot connect input ports"));
+	jack_set_process_callback (priv->client, process_callback, priv);
+	jack_set_sample_rate_callback (priv->client, sample_rate_callback, priv);
+	jack_on_shutdown (priv->client, shutdown_callback, priv);
 
-		visual_mem_free (ports);
+	if (jack_activate (priv->client) != 0) {
+		visual_log (VISUAL_LOG_ERROR, _("Cannot activate the jack client"));
 
 		return -1;
 	}
 
-	visual_mem_free (ports);
-
-//	visual_buffer_init_allocate (&priv->buffer, 65536,
-
-	return 0;
+	return jack_connect_capture (priv);
 }
 
 static int inp_jack_cleanup (VisPluginData *plugin)
 {
-	JackPrivate *priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	JackPrivate *priv;
 
 	visual_return_val_if_fail (plugin != NULL, -1);
 	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
 	visual_return_val_if_fail (priv != NULL, -1);
 
+	/* Closing stops the process callback before the ring goes away */
 	if (priv->client != NULL)
 		jack_client_close (priv->client);
 
+	if (priv->ring != NULL)
+		jack_ringbuffer_free (priv->ring);
+
+	if (priv->samples != NULL)
+		visual_mem_free (priv->samples);
+
 	visual_mem_free (priv);
 
 	return 0;
@@ -157,8 +179,9 @@ static int inp_jack_cleanup (VisPluginData *plugin)
 static int inp_jack_upload (VisPluginData *plugin, VisAudio *audio)
 {
 	JackPrivate *priv = NULL;
-/*	VisBuffer buffer; */
-	int i;
+	VisBuffer buffer;
+	unsigned int overruns;
+	size_t frames;
 
 	visual_return_val_if_fail (audio != NULL, -1);
 	visual_return_val_if_fail (plugin != NULL, -1);
@@ -173,33 +196,108 @@ static int inp_jack_upload (VisPluginData *plugin, VisAudio *audio)
 		return -1;
 	}
 
-/*
-	visual_buffer_init (&buffer, data, rcnt, NULL);
+	overruns = priv->overruns;
+	if (overruns != priv->overruns_reported) {
+		visual_log (VISUAL_LOG_WARNING, _("Dropped capture data in %u jack periods, uploads are too far apart"),
+				overruns - priv->overruns_reported);
+
+		priv->overruns_reported = overruns;
+	}
+
+	/* Take everything captured since the last upload, whole frames only */
+	frames = jack_ringbuffer_read_space (priv->ring) / JACK_FRAME_SIZE;
+
+	if (frames == 0)
+		return 0;
 
-	visual_audio_samplepool_input (audio->samplepool, &buffer, VISUAL_AUDIO_SAMPLE_RATE_44100,
+	jack_ringbuffer_read (priv->ring, (char *) priv->samples, frames * JACK_FRAME_SIZE);
+
+	visual_buffer_init (&buffer, priv->samples, frames * JACK_FRAME_SIZE, NULL);
+
+	visual_audio_samplepool_input (audio->samplepool, &buffer, visual_audio_sample_rate_from_hz (priv->rate),
 			VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
-*/
 
-	for (i = 0; i < PCM_BUF_SIZE && i < 1024; i += 2) {
-		audio->plugpcm[0][i >> 1] = priv->fakebuf[i];
-		audio->plugpcm[1][i >> 1] = priv->fakebuf[i + 1];
+	return 0;
+}
+
+/* Connects the first two physical capture ports, a single one feeds both sides */
+static int jack_connect_capture (JackPrivate *priv)
+{
+	const char **ports;
+	int i;
+
+	if ((ports = jack_get_ports (priv->client, NULL, JACK_DEFAULT_AUDIO_TYPE,
+					JackPortIsPhysical | JackPortIsOutput)) == NULL) {
+		visual_log (VISUAL_LOG_ERROR, _("Cannot find any physical capture ports"));
+
+		return -1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		const char *source = i == 1 && ports[1] != NULL ? ports[1] : ports[0];
+
+		if (jack_connect (priv->client, source, jack_port_name (priv->input_ports[i])) != 0) {
+			visual_log (VISUAL_LOG_ERROR, _("Cannot connect input ports"));
+
+			jack_free (ports);
+
+			return -1;
+		}
 	}
 
+	jack_free (ports);
+
 	return 0;
 }
 
+/* Runs in the jack realtime thread: only interleaves into the ring */
 static int process_callback (jack_nframes_t nframes, void *arg)
 {
 	JackPrivate *priv = arg;
-	jack_default_audio_sample_t *in;
-	int i;
+	jack_default_audio_sample_t *left;
+	jack_default_audio_sample_t *right;
+	jack_ringbuffer_data_t vec[2];
+	size_t done = 0;
+	size_t count;
+	size_t i;
+	int v;
+
+	left = jack_port_get_buffer (priv->input_ports[0], nframes);
+	right = jack_port_get_buffer (priv->input_ports[1], nframes);
+
+	jack_ringbuffer_get_write_vector (priv->ring, vec);
+
+	/* The write position only moves in whole frames, so only the last part of
+	 * the free space can hold a partial frame */
+	for (v = 0; v < 2 && done < nframes; v++) {
+		float *dest = (float *) vec[v].buf;
+
+		count = vec[v].len / JACK_FRAME_SIZE;
+		if (count > nframes - done)
+			count = nframes - done;
+
+		for (i = 0; i < count; i++) {
+			dest[i * 2] = left[done + i];
+			dest[i * 2 + 1] = right[done + i];
+		}
+
+		done += count;
+	}
+
+	jack_ringbuffer_write_advance (priv->ring, done * JACK_FRAME_SIZE);
 
-	in = (jack_default_audio_sample_t *) jack_port_get_buffer (priv->input_port, nframes);
+	/* The reader is behind, the rest of this period is lost */
+	if (done < nframes)
+		priv->overruns++;
 
-	visual_mem_set (&priv->fakebuf, 0, sizeof (priv->fakebuf));
+	return 0;
+}
+
+static int sample_rate_callback (jack_nframes_t nframes, void *arg)
+{
+	JackPrivate *priv = arg;
 
-	for (i = 0; i < nframes && i < 1024; i++)
-		priv->fakebuf[i] = in[i] * 32767;
+	priv->rate = nframes;
 
 	return 0;
 }
@@ -210,4 +308,3 @@ static void shutdown_callback (void *arg)
 
 	priv->shutdown = TRUE;
 }
-
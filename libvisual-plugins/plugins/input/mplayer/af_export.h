@@ -0,0 +1,115 @@
+/* Libvisual-plugins - Standard plugins for libvisual
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef _AF_EXPORT_H
+#define _AF_EXPORT_H
+
+#include <stdint.h>
+
+/*
+ * Shared memory audio export, version 2.
+ *
+ * The file starts with an af_export_header_t, followed at header_size by one
+ * ring of 'frames' samples per channel, channel after channel. All fields are
+ * in native byte order, a reader on a machine with another byte order will
+ * not recognise the magic.
+ *
+ * The writer copies new samples into the rings and then publishes them by
+ * storing the new write_index with release semantics. Readers load it with
+ * acquire semantics and read the samples in place. A reader must stay less
+ * than frames - block_frames behind write_index, and checks write_index again
+ * after reading to see whether the writer came around in the meantime.
+ *
+ * The fields from channels up to session are protected by sequence, which is
+ * odd while the writer changes them. A writer that starts on an existing file
+ * picks a new session, so readers can tell it apart from the previous one.
+ * A writer must never shrink a file that may be mapped; to change the size it
+ * writes a new file and renames it over the old one, and readers notice that
+ * the file was replaced.
+ *
+ * A file that does not start with AF_EXPORT_MAGIC is taken to be in the
+ * format of the original 'mplayer -af export' filter: af_export_legacy_t,
+ * followed by one block of 16 bit samples per channel, which is replaced
+ * as a whole every time count goes up.
+ */
+
+#define AF_EXPORT_MAGIC			0x4641564cU	/**< "LVAF" on little endian machines. */
+#define AF_EXPORT_VERSION		2
+
+#define AF_EXPORT_FORMAT_S16		1		/**< Signed 16 bit samples. */
+#define AF_EXPORT_FORMAT_FLOAT		2		/**< 32 bit float samples from -1.0 to 1.0. */
+
+#define AF_EXPORT_MAX_CHANNELS		64
+
+typedef struct {
+	uint32_t		magic;		/**< AF_EXPORT_MAGIC. */
+	uint32_t		version;	/**< AF_EXPORT_VERSION. */
+	uint32_t		header_size;	/**< Offset of the first ring in bytes. */
+	uint32_t		reserved0;
+
+	uint32_t		channels;	/**< Number of rings. */
+	uint32_t		rate;		/**< Sample rate in Hz. */
+	uint32_t		format;		/**< One of the AF_EXPORT_FORMAT_ values. */
+	uint32_t		frames;		/**< Size of every ring in samples, a power of two. */
+	uint32_t		block_frames;	/**< Most frames the writer publishes at once. */
+	uint32_t		session;	/**< Changes whenever a writer starts. */
+
+	volatile uint32_t	sequence;	/**< Odd while the fields above change. */
+	volatile uint32_t	write_index;	/**< Frames written in total, wraps around. */
+
+	uint32_t		reserved[4];
+} af_export_header_t;
+
+typedef struct {
+	int			nch;		/**< Number of channels. */
+	int			bs;		/**< Size of all blocks together in bytes. */
+	unsigned long long	count;		/**< Goes up after every block. */
+} af_export_legacy_t;
+
+static inline uint32_t af_export_load( const volatile uint32_t *p )
+{
+	return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+static inline void af_export_store( volatile uint32_t *p, uint32_t value )
+{
+	__atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+/* Orders the loads before it against the loads after it */
+static inline void af_export_read_fence( void )
+{
+	__atomic_thread_fence( __ATOMIC_ACQUIRE );
+}
+
+/* Orders the stores before it against the stores after it */
+static inline void af_export_write_fence( void )
+{
+	__atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static inline int af_export_format_size( uint32_t format )
+{
+	switch ( format )
+	{
+		case AF_EXPORT_FORMAT_S16:	return 2;
+		case AF_EXPORT_FORMAT_FLOAT:	return 4;
+		default:			return 0;
+	}
+}
+
+#endif /* _AF_EXPORT_H */
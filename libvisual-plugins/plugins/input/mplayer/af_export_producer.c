@@ -0,0 +1,299 @@
+/* Libvisual-plugins - Standard plugins for libvisual
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Writes sine waves in the export format of af_export.h, so the mplayer
+ * input plugin can be tried without mplayer. Every channel gets its own
+ * frequency, 220 Hz times the channel number.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "af_export.h"
+
+typedef struct {
+	const char *path;          /**< the export file */
+	int channels;              /**< number of channels */
+	int rate;                  /**< sample rate in Hz */
+	uint32_t format;           /**< AF_EXPORT_FORMAT_ */
+	int frames;                /**< ring size */
+	int block_frames;          /**< frames per write */
+
+	af_export_header_t *header; /**< the mapping */
+	size_t size;               /**< size of the mapping */
+	uint8_t *rings;            /**< first ring in the mapping */
+} producer_t;
+
+static void usage( const char *name )
+{
+	fprintf( stderr,
+			"Usage: %s [options]\n"
+			"  -o FILE     export file, default $HOME/.mplayer/mplayer-af_export\n"
+			"  -c N        number of channels, default 2\n"
+			"  -r HZ       sample rate, default 44100\n"
+			"  -f FORMAT   s16 or float, default s16\n"
+			"  -n FRAMES   ring size in frames, rounded up to a power of two, default 16384\n"
+			"  -b FRAMES   frames per write, default 512\n"
+			"  -t SECONDS  stop after this long, default never\n"
+			"  -R SECONDS  restart with a new file this often\n"
+			"  -I SECONDS  restart in the same file this often\n",
+			name );
+}
+
+static uint32_t new_session( void )
+{
+	static uint32_t last;
+	uint32_t session;
+
+	do {
+		session = ( (uint32_t) getpid() << 16 ) ^ (uint32_t) time( NULL ) ^ ( last * 2654435761U );
+	} while ( session == 0 || session == last );
+
+	last = session;
+
+	return session;
+}
+
+/* Writes a complete new file next to the old one and renames it over it,
+ * readers that still have the old one mapped keep a valid mapping. */
+static int create_file( producer_t *p )
+{
+	af_export_header_t *header;
+	size_t ringsize = (size_t) p->frames * af_export_format_size( p->format );
+	size_t size = sizeof( af_export_header_t ) + p->channels * ringsize;
+	char *tmp;
+	int fd;
+
+	tmp = malloc( strlen( p->path ) + 8 );
+	sprintf( tmp, "%s.XXXXXX", p->path );
+
+	fd = mkstemp( tmp );
+	if ( fd < 0 )
+	{
+		fprintf( stderr, "Could not create '%s': %s\n", tmp, strerror( errno ) );
+		free( tmp );
+		return -1;
+	}
+
+	fchmod( fd, 0644 );
+
+	if ( ftruncate( fd, size ) != 0 ||
+			( header = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) ) == MAP_FAILED )
+	{
+		fprintf( stderr, "Could not map '%s': %s\n", tmp, strerror( errno ) );
+		close( fd );
+		unlink( tmp );
+		free( tmp );
+		return -1;
+	}
+
+	close( fd );
+
+	header->magic = AF_EXPORT_MAGIC;
+	header->version = AF_EXPORT_VERSION;
+	header->header_size = sizeof( af_export_header_t );
+	header->channels = p->channels;
+	header->rate = p->rate;
+	header->format = p->format;
+	header->frames = p->frames;
+	header->block_frames = p->block_frames;
+	header->session = new_session();
+	header->sequence = 0;
+	header->write_index = 0;
+
+	if ( rename( tmp, p->path ) != 0 )
+	{
+		fprintf( stderr, "Could not rename '%s' to '%s': %s\n", tmp, p->path, strerror( errno ) );
+		munmap( header, size );
+		unlink( tmp );
+		free( tmp );
+		return -1;
+	}
+
+	free( tmp );
+
+	if ( p->header != NULL )
+		munmap( p->header, p->size );
+
+	p->header = header;
+	p->size = size;
+	p->rings = (uint8_t *) header + header->header_size;
+
+	printf( "session %u in new file\n", header->session );
+
+	return 0;
+}
+
+/* Starts over in the mapped file, as a writer that finds an old file would */
+static void restart_in_place( producer_t *p )
+{
+	af_export_header_t *header = p->header;
+	uint32_t sequence = header->sequence;
+
+	af_export_store( &header->sequence, sequence + 1 );
+	af_export_write_fence();
+
+	header->session = new_session();
+	header->write_index = 0;
+
+	af_export_store( &header->sequence, sequence + 2 );
+
+	printf( "session %u in place\n", header->session );
+}
+
+static void write_block( producer_t *p, uint64_t position )
+{
+	size_t ringsize = (size_t) p->frames * af_export_format_size( p->format );
+	uint32_t windex = p->header->write_index;
+	int ch, i;
+
+	for ( ch = 0; ch < p->channels; ch++ )
+	{
+		double step = 2.0 * M_PI * 220.0 * ( ch + 1 ) / p->rate;
+		uint8_t *ring = p->rings + ch * ringsize;
+
+		for ( i = 0; i < p->block_frames; i++ )
+		{
+			double value = 0.5 * sin( step * ( position + i ) );
+			uint32_t slot = ( windex + i ) & ( p->frames - 1 );
+
+			if ( p->format == AF_EXPORT_FORMAT_FLOAT )
+				( (float *) ring )[slot] = value;
+			else
+				( (int16_t *) ring )[slot] = value * 32767;
+		}
+	}
+
+	af_export_store( &p->header->write_index, windex + p->block_frames );
+}
+
+static void add_ns( struct timespec *ts, uint64_t ns )
+{
+	ns += ts->tv_nsec;
+	ts->tv_sec += ns / 1000000000;
+	ts->tv_nsec = ns % 1000000000;
+}
+
+int main( int argc, char **argv )
+{
+	producer_t p;
+	char *path = NULL;
+	double duration = 0, replace = 0, inplace = 0;
+	uint64_t position = 0;
+	uint64_t blocks, nextreplace, nextinplace;
+	struct timespec next;
+	int opt;
+
+	memset( &p, 0, sizeof( p ) );
+	p.channels = 2;
+	p.rate = 44100;
+	p.format = AF_EXPORT_FORMAT_S16;
+	p.frames = 16384;
+	p.block_frames = 512;
+
+	while ( ( opt = getopt( argc, argv, "o:c:r:f:n:b:t:R:I:h" ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'o': p.path = optarg; break;
+			case 'c': p.channels = atoi( optarg ); break;
+			case 'r': p.rate = atoi( optarg ); break;
+			case 'f': p.format = strcmp( optarg, "float" ) == 0 ?
+					  AF_EXPORT_FORMAT_FLOAT : AF_EXPORT_FORMAT_S16; break;
+			case 'n': p.frames = atoi( optarg ); break;
+			case 'b': p.block_frames = atoi( optarg ); break;
+			case 't': duration = atof( optarg ); break;
+			case 'R': replace = atof( optarg ); break;
+			case 'I': inplace = atof( optarg ); break;
+			default: usage( argv[0] ); return 1;
+		}
+	}
+
+	if ( p.channels < 1 || p.channels > AF_EXPORT_MAX_CHANNELS || p.rate <= 0 ||
+			p.frames <= 0 || p.block_frames <= 0 )
+	{
+		usage( argv[0] );
+		return 1;
+	}
+
+	while ( p.frames & ( p.frames - 1 ) )
+		p.frames += p.frames & -p.frames;
+
+	if ( p.block_frames > p.frames / 2 )
+	{
+		fprintf( stderr, "Blocks can be at most half the ring, %d frames\n", p.frames / 2 );
+		return 1;
+	}
+
+	if ( p.path == NULL )
+	{
+		const char *home = getenv( "HOME" );
+
+		path = malloc( strlen( home ? home : "." ) + 32 );
+		sprintf( path, "%s/.mplayer", home ? home : "." );
+		mkdir( path, 0755 );
+		strcat( path, "/mplayer-af_export" );
+
+		p.path = path;
+	}
+
+	if ( create_file( &p ) < 0 )
+		return 1;
+
+	blocks = duration * p.rate / p.block_frames;
+	nextreplace = replace * p.rate / p.block_frames;
+	nextinplace = inplace * p.rate / p.block_frames;
+
+	clock_gettime( CLOCK_MONOTONIC, &next );
+
+	for ( position = 0; duration <= 0 || position < blocks * p.block_frames; position += p.block_frames )
+	{
+		uint64_t block = position / p.block_frames;
+
+		if ( block > 0 && nextreplace > 0 && block % nextreplace == 0 )
+		{
+			if ( create_file( &p ) < 0 )
+				return 1;
+		}
+		else if ( block > 0 && nextinplace > 0 && block % nextinplace == 0 )
+		{
+			restart_in_place( &p );
+		}
+
+		write_block( &p, position );
+
+		add_ns( &next, (uint64_t) p.block_frames * 1000000000 / p.rate );
+		while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL ) == EINTR )
+			;
+	}
+
+	munmap( p.header, p.size );
+	free( path );
+
+	return 0;
+}
@@ -29,16 +29,18 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
+#include <time.h>
 #include <gettext.h>
 
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
-#include <assert.h>
 
 #include <libvisual/libvisual.h>
 
+#include "af_export.h"
+
 #ifndef SHARED_FILE
 #define SHARED_FILE ".mplayer/mplayer-af_export" /**< default file name,
 						   relative to $HOME */
@@ -48,18 +50,31 @@ const VisPluginInfo *get_plugin_info(int *count);
 
 /* Data structures ***********************************************************/
 typedef struct {
-	int nch;                  /**< number of channels */
-	int bs;                   /**< buffer size */
-	unsigned long long count; /**< sample counter */
-} mplayer_data_t;
-
-
-typedef struct {
-	int fd;                    /**< file descriptor to mmaped area */
 	char *sharedfile;          /**< shared file name */
-	mplayer_data_t *mmap_area; /**< mmap()'ed area */
-
-	int loaded;                /**< plugin state */
+	int fd;                    /**< file descriptor to mmaped area */
+	void *mmap_area;           /**< mmap()'ed area */
+	size_t mmap_size;          /**< size of the mmap()'ed area */
+	dev_t dev;                 /**< device of the mapped file */
+	ino_t ino;                 /**< inode of the mapped file */
+	time_t lastcheck;          /**< last time the file was looked for */
+
+	int legacy;                /**< file is in the original mplayer format */
+	int configured;            /**< format of the writer is known */
+	int warned;                /**< format problem has been logged */
+
+	uint32_t sequence;         /**< header sequence the format was read at */
+	uint32_t read_index;       /**< frames read in total */
+	unsigned long long count;  /**< legacy block that was read last */
+	int16_t *block;            /**< copy of a legacy block */
+	uint8_t *copy;             /**< copy of what is read from the rings */
+
+	int channels;              /**< number of channels */
+	int frames;                /**< samples in a ring or legacy block */
+	int block_frames;          /**< most samples the writer publishes at once */
+	size_t offset;             /**< offset of the first channel */
+	int samplesize;            /**< bytes per sample */
+	VisAudioSampleFormatType sampleformat;
+	VisAudioSampleRateType samplerate;
 } mplayer_priv_t;
 
 
@@ -70,6 +85,18 @@ static int inp_mplayer_init( VisPluginData *plugin );
 static int inp_mplayer_cleanup( VisPluginData *plugin );
 static int inp_mplayer_upload( VisPluginData *plugin, VisAudio *audio );
 
+static int mplayer_open( mplayer_priv_t *priv );
+static void mplayer_close( mplayer_priv_t *priv );
+static int mplayer_replaced( mplayer_priv_t *priv );
+static int mplayer_map( mplayer_priv_t *priv, size_t size );
+static int mplayer_map_needed( mplayer_priv_t *priv, size_t size );
+static int mplayer_configure( mplayer_priv_t *priv );
+static int mplayer_configure_legacy( mplayer_priv_t *priv );
+static int mplayer_upload_ring( mplayer_priv_t *priv, VisAudio *audio );
+static int mplayer_upload_legacy( mplayer_priv_t *priv, VisAudio *audio );
+static void mplayer_input( mplayer_priv_t *priv, VisAudio *audio, void *data,
+		int frames, const char *channelid );
+
 VISUAL_PLUGIN_API_VERSION_VALIDATOR
 
 /**
@@ -93,7 +120,8 @@ const VisPluginInfo *get_plugin_info( int *count )
 		.author = "Gustavo Sverzut Barbieri <gsbarbieri@users.sourceforge.net>",
 		.version = "$Revision: 1.19 $",
 		.about = N_("Use data exported from MPlayer"),
-		.help = N_("This plugin uses data exported from 'mplayer -af export'"),
+		.help = N_("This plugin uses data exported from 'mplayer -af export', " \
+				"or any other program that writes the libvisual export format"),
 		.license = VISUAL_PLUGIN_LICENSE_LGPL,
 
 		.init = inp_mplayer_init,
@@ -110,6 +138,9 @@ const VisPluginInfo *get_plugin_info( int *count )
 /**
  * Initialize plugin
  *
+ * The shared file does not have to exist yet, it is looked for again
+ * every second until it shows up.
+ *
  * @param plugin plugin to be initialized.
  *
  * @return 0 on success.
@@ -117,163 +148,545 @@ const VisPluginInfo *get_plugin_info( int *count )
 static int inp_mplayer_init( VisPluginData *plugin )
 {
 	mplayer_priv_t *priv = NULL;
+	const char *home;
 
 #if ENABLE_NLS
 	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
 #endif
 
+	visual_return_val_if_fail( plugin != NULL, -1 );
+
+	home = getenv( "HOME" );
+	visual_return_val_if_fail( home != NULL, -1 );
+
 	priv = visual_mem_new0(mplayer_priv_t, 1);
+	visual_object_set_private (VISUAL_OBJECT (plugin), priv);
 
 	priv->sharedfile = visual_mem_malloc0( sizeof( char ) *
-			( strlen( SHARED_FILE ) +
-			  strlen( getenv( "HOME" ) ) + 2 ) );
+			( strlen( SHARED_FILE ) + strlen( home ) + 2 ) );
 
-	strcpy( priv->sharedfile, getenv( "HOME" ) );
+	strcpy( priv->sharedfile, home );
 	strcat( priv->sharedfile, "/" );
 	strcat( priv->sharedfile, SHARED_FILE );
 
-	visual_object_set_private (VISUAL_OBJECT (plugin), priv);
+	priv->fd = -1;
+	priv->lastcheck = time( NULL );
+
+	if ( mplayer_open( priv ) < 0 )
+	{
+		visual_log( VISUAL_LOG_WARNING,
+				_("Could not open file '%s': %s, waiting for it"),
+				priv->sharedfile, strerror( errno ) );
+	}
+
+	return 0;
+}
+
+/**
+ * cleanup plugin (release resources)
+ *
+ * @param plugin plugin to be cleaned up.
+ *
+ * @return 0 on success.
+ */
+static int inp_mplayer_cleanup( VisPluginData *plugin )
+{
+	mplayer_priv_t *priv = NULL;
 
 	visual_return_val_if_fail( plugin != NULL, -1 );
+	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
+	visual_return_val_if_fail( priv != NULL, -1 );
+
+	mplayer_close( priv );
 
+	visual_mem_free( priv->sharedfile );
+	visual_mem_free( priv );
+
+	return 0;
+}
+
+
+/**
+ * upload data to libvisual
+ *
+ * Reads everything the writer published since the last upload. When
+ * nothing new came in, the file is checked once a second to see whether
+ * a restarted writer replaced it.
+ *
+ * @param plugin plugin that should upload data.
+ * @param where to upload data.
+ *
+ * @return 0 on success.
+ */
+static int inp_mplayer_upload( VisPluginData *plugin, VisAudio *audio )
+{
+	mplayer_priv_t *priv = NULL;
+	int frames = 0;
+	time_t now;
+
+	visual_return_val_if_fail( audio != NULL, -1 );
+	visual_return_val_if_fail( plugin != NULL, -1 );
+	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
 	visual_return_val_if_fail( priv != NULL, -1 );
-	visual_return_val_if_fail( priv->sharedfile != NULL, -1 );
 
-	priv->fd = open( priv->sharedfile, O_RDONLY );
+	if ( priv->fd >= 0 && !priv->configured )
+		mplayer_configure( priv );
 
-	if ( priv->fd < 0 )
+	if ( priv->configured )
 	{
-		/*
-		 * FIXME this will cause the application to abort,
-		 * may be we must print a warning and clean all
-		 * before to return the error value.
-		 */
-		visual_log( VISUAL_LOG_CRITICAL,
-				_("Could not open file '%s': %s"),
-				priv->sharedfile, strerror( errno ) );
-		return -3;
+		if ( priv->legacy )
+			frames = mplayer_upload_legacy( priv, audio );
+		else
+			frames = mplayer_upload_ring( priv, audio );
 	}
 
-	priv->mmap_area = mmap( 0, sizeof( mplayer_data_t ),
-			PROT_READ, MAP_SHARED, priv->fd, 0 );
-	visual_return_val_if_fail( (intptr_t)priv->mmap_area != -1, -1 );
+	if ( frames > 0 )
+		return 0;
+
+	now = time( NULL );
+	if ( now == priv->lastcheck )
+		return 0;
 
-	if ( priv->mmap_area->nch == 0 )
+	priv->lastcheck = now;
+
+	if ( priv->fd < 0 || mplayer_replaced( priv ) )
 	{
-		visual_log( VISUAL_LOG_CRITICAL, _("No audio channel available") );
-		return -5;
+		mplayer_close( priv );
+
+		if ( mplayer_open( priv ) == 0 )
+			visual_log( VISUAL_LOG_INFO, _("Opened '%s'"), priv->sharedfile );
 	}
 
-	if ( ( priv->mmap_area->nch != 2 ) ||
-			( priv->mmap_area->bs  != 2048 ) )
+	return 0;
+}
+
+/**
+ * open and map the shared file
+ *
+ * @param priv plugin data.
+ *
+ * @return 0 on success, -1 with errno set on failure.
+ */
+static int mplayer_open( mplayer_priv_t *priv )
+{
+	struct stat st;
+
+	priv->fd = open( priv->sharedfile, O_RDONLY );
+	if ( priv->fd < 0 )
+		return -1;
+
+	if ( fstat( priv->fd, &st ) != 0 || mplayer_map( priv, st.st_size ) < 0 )
+	{
+		int err = errno;
+
+		mplayer_close( priv );
+		errno = err;
+
+		return -1;
+	}
+
+	priv->dev = st.st_dev;
+	priv->ino = st.st_ino;
+
+	priv->legacy = ((af_export_header_t *)priv->mmap_area)->magic != AF_EXPORT_MAGIC;
+	priv->configured = FALSE;
+	priv->warned = FALSE;
+
+	return 0;
+}
+
+/**
+ * unmap and close the shared file
+ *
+ * @param priv plugin data.
+ */
+static void mplayer_close( mplayer_priv_t *priv )
+{
+	if ( priv->mmap_area != NULL && munmap( priv->mmap_area, priv->mmap_size ) != 0 )
 	{
 		visual_log( VISUAL_LOG_CRITICAL,
-				_("Data in wrong format. It should be 2 channels" \
-					" with 512 16bit samples. There are %d channels %d 16bit " \
-					"samples in it (buffer is %d bytes)"),
-				priv->mmap_area->nch,
-				priv->mmap_area->bs / 2 / priv->mmap_area->nch,
-				priv->mmap_area->bs );
-		return -6;
+				_("Could not munmap() area %p+%" VISUAL_SIZE_T_FORMAT ". %s"),
+				priv->mmap_area, priv->mmap_size, strerror( errno ) );
 	}
 
-	priv->mmap_area = mremap( priv->mmap_area, sizeof( mplayer_data_t ),
-			sizeof( mplayer_data_t ) + priv->mmap_area->bs,
-			0 );
-	if ( (intptr_t)priv->mmap_area == -1 )
+	priv->mmap_area = NULL;
+	priv->mmap_size = 0;
+
+	if ( priv->fd >= 0 && close( priv->fd ) != 0 )
 	{
 		visual_log( VISUAL_LOG_CRITICAL,
-				_("Could not mremap() area from file '%s' " \
-					" (%p from %" VISUAL_SIZE_T_FORMAT " to %" VISUAL_SIZE_T_FORMAT " bytes): %s"),
-				priv->sharedfile,
-				(void *) priv->mmap_area, sizeof( mplayer_data_t ),
-				sizeof( mplayer_data_t ) + priv->mmap_area->bs,
-				strerror( errno ) );
-		return -7;
+				_("Could not close file descriptor %d: %s"),
+				priv->fd, strerror( errno ) );
 	}
 
-	priv->loaded = 1;
-	return 0;
+	priv->fd = -1;
+
+	if ( priv->block != NULL )
+		visual_mem_free( priv->block );
+
+	priv->block = NULL;
+
+	if ( priv->copy != NULL )
+		visual_mem_free( priv->copy );
+
+	priv->copy = NULL;
+	priv->configured = FALSE;
 }
 
 /**
- * cleanup plugin (release resources)
+ * check whether the shared file was replaced by a new one
  *
- * @param plugin plugin to be cleaned up.
+ * @param priv plugin data.
  *
- * @return 0 on success.
+ * @return TRUE when another file is there now.
  */
-static int inp_mplayer_cleanup( VisPluginData *plugin )
+static int mplayer_replaced( mplayer_priv_t *priv )
 {
-	int unclean = 0;
-	mplayer_priv_t *priv = NULL;
+	struct stat st;
 
-	visual_return_val_if_fail( plugin != NULL, -1 );
-	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
-	visual_return_val_if_fail( priv != NULL, -1 );
+	if ( stat( priv->sharedfile, &st ) != 0 )
+		return FALSE;
+
+	return st.st_dev != priv->dev || st.st_ino != priv->ino;
+}
+
+/**
+ * (re)map the shared file
+ *
+ * @param priv plugin data.
+ * @param size number of bytes to map.
+ *
+ * @return 0 on success, -1 with errno set on failure.
+ */
+static int mplayer_map( mplayer_priv_t *priv, size_t size )
+{
+	void *area;
 
-	if ( priv->loaded == 1 )
+	if ( size < sizeof( af_export_legacy_t ) || size < sizeof( af_export_header_t ) )
 	{
-		void *mmap_area  = (void*)priv->mmap_area;
-		int   mmap_count = priv->mmap_area->bs + sizeof( mplayer_data_t );
+		errno = EINVAL;
+		return -1;
+	}
 
-		if ( priv->fd > 0 )
-		{
-			if ( close( priv->fd ) != 0 )
-			{
-				visual_log( VISUAL_LOG_CRITICAL,
-						_("Could not close file descriptor %d: %s"),
-						priv->fd, strerror( errno ) );
-				unclean |= 1;
-			}
-			priv->fd = -1;
-		}
-		else
+	area = mmap( NULL, size, PROT_READ, MAP_SHARED, priv->fd, 0 );
+	if ( area == MAP_FAILED )
+		return -1;
+
+	if ( priv->mmap_area != NULL )
+		munmap( priv->mmap_area, priv->mmap_size );
+
+	priv->mmap_area = area;
+	priv->mmap_size = size;
+
+	return 0;
+}
+
+/**
+ * make sure the file is mapped up to size bytes
+ *
+ * @param priv plugin data.
+ * @param size number of bytes that are needed.
+ *
+ * @return 0 on success, -1 when the file is not that large (yet).
+ */
+static int mplayer_map_needed( mplayer_priv_t *priv, size_t size )
+{
+	struct stat st;
+
+	if ( size <= priv->mmap_size )
+		return 0;
+
+	if ( fstat( priv->fd, &st ) != 0 || (size_t) st.st_size < size )
+		return -1;
+
+	return mplayer_map( priv, st.st_size );
+}
+
+/**
+ * read the format the writer uses
+ *
+ * @param priv plugin data.
+ *
+ * @return 0 on success, -1 when the header is not usable (yet).
+ */
+static int mplayer_configure( mplayer_priv_t *priv )
+{
+	af_export_header_t *header = priv->mmap_area;
+	af_export_header_t copy;
+	uint32_t sequence;
+	int samplesize;
+
+	if ( priv->legacy )
+		return mplayer_configure_legacy( priv );
+
+	/* The writer is changing the header */
+	sequence = af_export_load( &header->sequence );
+	if ( sequence & 1 )
+		return -1;
+
+	memcpy( &copy, header, sizeof( copy ) );
+
+	af_export_read_fence();
+	if ( af_export_load( &header->sequence ) != sequence )
+		return -1;
+
+	samplesize = af_export_format_size( copy.format );
+
+	if ( copy.version != AF_EXPORT_VERSION ||
+			copy.header_size < sizeof( af_export_header_t ) ||
+			copy.channels == 0 || copy.channels > AF_EXPORT_MAX_CHANNELS ||
+			copy.frames == 0 || ( copy.frames & ( copy.frames - 1 ) ) != 0 ||
+			copy.block_frames == 0 || copy.block_frames > copy.frames / 2 ||
+			samplesize == 0 )
+	{
+		if ( !priv->warned )
 		{
-			visual_log( VISUAL_LOG_CRITICAL, _("Wrong file descriptor %d"),
-					priv->fd );
-			unclean |= 2;
+			visual_log( VISUAL_LOG_WARNING,
+					_("Unsupported export: version %u, %u channels, format %u, " \
+						"%u frames in blocks of %u"),
+					copy.version, copy.channels, copy.format,
+					copy.frames, copy.block_frames );
+			priv->warned = TRUE;
 		}
 
-		if ( munmap( mmap_area, mmap_count ) != 0 )
+		return -1;
+	}
+
+	/* The rings are not there yet */
+	if ( mplayer_map_needed( priv, copy.header_size +
+				(size_t) copy.channels * copy.frames * samplesize ) < 0 )
+		return -1;
+
+	/* Half a ring for both channels that are read */
+	if ( priv->copy != NULL )
+		visual_mem_free( priv->copy );
+
+	priv->copy = visual_mem_malloc( (size_t) copy.frames * samplesize );
+
+	priv->channels = copy.channels;
+	priv->frames = copy.frames;
+	priv->block_frames = copy.block_frames;
+	priv->offset = copy.header_size;
+	priv->samplesize = samplesize;
+	priv->sampleformat = copy.format == AF_EXPORT_FORMAT_FLOAT ?
+		VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT : VISUAL_AUDIO_SAMPLE_FORMAT_S16;
+	priv->samplerate = visual_audio_sample_rate_from_hz( copy.rate );
+
+	/* Start at what is written now, not at what is in the rings already */
+	priv->sequence = sequence;
+	priv->read_index = af_export_load( &header->write_index );
+
+	priv->configured = TRUE;
+	priv->warned = FALSE;
+
+	visual_log( VISUAL_LOG_INFO, _("Export session %u: %d channels at %u Hz"),
+			copy.session, priv->channels, copy.rate );
+
+	return 0;
+}
+
+/**
+ * read the format of the original mplayer export filter
+ *
+ * @param priv plugin data.
+ *
+ * @return 0 on success, -1 when the header is not usable (yet).
+ */
+static int mplayer_configure_legacy( mplayer_priv_t *priv )
+{
+	volatile af_export_legacy_t *legacy = priv->mmap_area;
+	int nch = legacy->nch;
+	int bs = legacy->bs;
+
+	if ( nch <= 0 || nch > AF_EXPORT_MAX_CHANNELS || bs <= 0 || bs % ( nch * 2 ) != 0 )
+	{
+		if ( !priv->warned )
 		{
-			visual_log( VISUAL_LOG_CRITICAL,
-					_("Could not munmap() area %p+%d. %s"),
-					mmap_area, mmap_count,
-					strerror( errno ) );
-			unclean |= 4;
+			visual_log( VISUAL_LOG_WARNING,
+					_("Data in wrong format: %d channels in %d bytes"), nch, bs );
+			priv->warned = TRUE;
 		}
+
+		return -1;
 	}
 
-	visual_mem_free( priv->sharedfile );
-	visual_mem_free( priv );
+	if ( mplayer_map_needed( priv, sizeof( af_export_legacy_t ) + bs ) < 0 )
+		return -1;
+
+	if ( priv->block != NULL )
+		visual_mem_free( priv->block );
+
+	priv->block = visual_mem_malloc( bs );
+
+	priv->channels = nch;
+	priv->frames = bs / 2 / nch;
+	priv->offset = sizeof( af_export_legacy_t );
+	priv->samplesize = 2;
+	priv->sampleformat = VISUAL_AUDIO_SAMPLE_FORMAT_S16;
+
+	/* The filter does not export its rate */
+	priv->samplerate = VISUAL_AUDIO_SAMPLE_RATE_44100;
+
+	/* Take the block that is there now */
+	priv->count = legacy->count - 1;
+
+	priv->configured = TRUE;
+	priv->warned = FALSE;
 
-	return - unclean;
+	return 0;
 }
 
+/**
+ * upload what was published to the rings since the last upload
+ *
+ * Reading is limited to the newest half of a ring. The samples are copied
+ * out first and only go to the samplepool when the writer did not come
+ * around to them while copying. When it did, the reader starts over at
+ * what the writer is at.
+ *
+ * @param priv plugin data.
+ * @param audio where to upload data.
+ *
+ * @return number of frames uploaded.
+ */
+static int mplayer_upload_ring( mplayer_priv_t *priv, VisAudio *audio )
+{
+	af_export_header_t *header = priv->mmap_area;
+	uint8_t *rings = (uint8_t *) priv->mmap_area + priv->offset;
+	size_t ringsize = (size_t) priv->frames * priv->samplesize;
+	uint32_t mask = priv->frames - 1;
+	uint32_t windex;
+	uint32_t now;
+	uint32_t avail;
+	uint32_t start;
+	uint32_t first;
+	size_t firstsize;
+	size_t size;
+	int ch;
+
+	/* Format changed or a writer started over on the same file */
+	if ( af_export_load( &header->sequence ) != priv->sequence )
+	{
+		priv->configured = FALSE;
+		return 0;
+	}
+
+	windex = af_export_load( &header->write_index );
+	avail = windex - priv->read_index;
+
+	if ( avail == 0 )
+		return 0;
+
+	/* The index went back, the writer must have restarted without telling */
+	if ( avail > UINT32_MAX / 2 )
+	{
+		priv->read_index = windex;
+		return 0;
+	}
+
+	if ( avail > (uint32_t) priv->frames / 2 )
+		avail = priv->frames / 2;
+
+	start = ( windex - avail ) & mask;
+	first = avail < priv->frames - start ? avail : priv->frames - start;
+
+	firstsize = (size_t) first * priv->samplesize;
+	size = (size_t) avail * priv->samplesize;
+
+	for ( ch = 0; ch < 2; ch++ )
+	{
+		uint8_t *ring = rings + ( ch < priv->channels ? ch : 0 ) * ringsize;
+		uint8_t *dest = priv->copy + ch * size;
+
+		visual_mem_copy( dest, ring + start * priv->samplesize, firstsize );
+
+		if ( first < avail )
+			visual_mem_copy( dest + firstsize, ring, size - firstsize );
+	}
+
+	/* The copy is only good when the writer did not come around to it, nor
+	 * started over, while copying */
+	af_export_read_fence();
+	if ( af_export_load( &header->sequence ) != priv->sequence )
+	{
+		priv->configured = FALSE;
+		return 0;
+	}
+
+	now = af_export_load( &header->write_index );
+	if ( now - ( windex - avail ) > (uint32_t) ( priv->frames - priv->block_frames ) )
+	{
+		visual_log( VISUAL_LOG_WARNING, _("Writer overtook the reader, %u frames dropped"), avail );
+
+		priv->read_index = now;
+		return 0;
+	}
+
+	mplayer_input( priv, audio, priv->copy, avail, VISUAL_AUDIO_CHANNEL_LEFT );
+	mplayer_input( priv, audio, priv->copy + size, avail, VISUAL_AUDIO_CHANNEL_RIGHT );
+
+	priv->read_index = windex;
+
+	return avail;
+}
 
 /**
- * upload data to libvisual
+ * upload the current block of the original mplayer export filter
  *
- * @param plugin plugin that should upload data.
- * @param where to upload data.
+ * The filter overwrites the block in place, so it is copied out and only
+ * used when count did not change while copying.
  *
- * @return 0 on success.
+ * @param priv plugin data.
+ * @param audio where to upload data.
+ *
+ * @return number of frames uploaded.
  */
-static int inp_mplayer_upload( VisPluginData *plugin, VisAudio *audio )
+static int mplayer_upload_legacy( mplayer_priv_t *priv, VisAudio *audio )
 {
-	mplayer_priv_t *priv = NULL;
+	volatile af_export_legacy_t *legacy = priv->mmap_area;
+	unsigned long long count = legacy->count;
 
-	visual_return_val_if_fail( audio != NULL, -1 );
-	visual_return_val_if_fail( plugin != NULL, -1 );
-	priv = visual_object_get_private (VISUAL_OBJECT (plugin));
-	visual_return_val_if_fail( priv != NULL, -1 );
-	visual_return_val_if_fail( priv->mmap_area != NULL, -1 );
+	if ( count == priv->count )
+		return 0;
 
-	visual_mem_copy( audio->plugpcm,
-			((uint8_t *)priv->mmap_area) + sizeof( mplayer_data_t ),
-			2048 );
+	if ( legacy->nch != priv->channels || legacy->bs != priv->frames * priv->channels * 2 )
+	{
+		priv->configured = FALSE;
+		return 0;
+	}
 
-	return 0;
+	visual_mem_copy( priv->block, (uint8_t *) priv->mmap_area + priv->offset,
+			priv->frames * priv->channels * 2 );
+
+	af_export_read_fence();
+	if ( legacy->count != count )
+		return 0;
+
+	priv->count = count;
+
+	mplayer_input( priv, audio, priv->block, priv->frames, VISUAL_AUDIO_CHANNEL_LEFT );
+	mplayer_input( priv, audio, priv->block + ( priv->channels > 1 ? priv->frames : 0 ),
+			priv->frames, VISUAL_AUDIO_CHANNEL_RIGHT );
+
+	return priv->frames;
 }
 
+/**
+ * hand samples of one channel to the samplepool
+ *
+ * @param priv plugin data.
+ * @param audio where to upload data.
+ * @param data the samples.
+ * @param frames number of samples.
+ * @param channelid the channel they are for.
+ */
+static void mplayer_input( mplayer_priv_t *priv, VisAudio *audio, void *data,
+		int frames, const char *channelid )
+{
+	VisBuffer buffer;
+
+	visual_buffer_init( &buffer, data, frames * priv->samplesize, NULL );
+
+	visual_audio_samplepool_input_channel( audio->samplepool, &buffer, priv->samplerate,
+			priv->sampleformat, channelid );
+}
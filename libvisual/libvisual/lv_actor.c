@@ -26,6 +26,7 @@
 #include "lv_common.h"
 #include "lv_list.h"
 #include "gettext.h"
+#include "private/lv_timing_hooks.h"
 
 extern VisList *__lv_plugins_actor;
 
@@ -49,11 +50,15 @@ static int actor_dtor (VisObject *object)
 	if (actor->fitting != NULL)
 		visual_object_unref (VISUAL_OBJECT (actor->fitting));
 
+	if (actor->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (actor->timing));
+
 	visual_object_unref (VISUAL_OBJECT (&actor->songcompare));
 
 	actor->plugin = NULL;
 	actor->transform = NULL;
 	actor->fitting = NULL;
+	actor->timing = NULL;
 
 	return VISUAL_OK;
 }
@@ -265,6 +270,8 @@ int visual_actor_init (VisActor *actor, const char *actorname)
 	actor->transform = NULL;
 	actor->fitting = NULL;
 	actor->ditherpal = NULL;
+	actor->timing = NULL;
+	actor->timingtrack = VISUAL_TIMING_TRACK_ACTOR;
 
 	visual_mem_set (&actor->songcompare, 0, sizeof (VisSongInfo));
 
@@ -513,6 +520,26 @@ int visual_actor_set_video (VisActor *actor, VisVideo *video)
 	return VISUAL_OK;
 }
 
+int visual_actor_set_timing (VisActor *actor, VisTiming *timing, VisTimingTrack track)
+{
+	visual_return_val_if_fail (actor != NULL, -VISUAL_ERROR_ACTOR_NULL);
+
+	actor->timingtrack = track;
+
+	if (actor->timing == timing)
+		return VISUAL_OK;
+
+	if (timing != NULL)
+		visual_object_ref (VISUAL_OBJECT (timing));
+
+	if (actor->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (actor->timing));
+
+	actor->timing = timing;
+
+	return VISUAL_OK;
+}
+
 int visual_actor_run (VisActor *actor, VisAudio *audio)
 {
 	VisActorPlugin *actplugin;
@@ -520,6 +547,7 @@ int visual_actor_run (VisActor *actor, VisAudio *audio)
 	VisVideo *video;
 	VisVideo *transform;
 	VisVideo *fitting;
+	_LV_TIMING_DECLARE (begin);
 
 	/* We don't check for video, because we don't always need a video */
 	/*
@@ -561,7 +589,9 @@ int visual_actor_run (VisActor *actor, VisAudio *audio)
 	 * Also internal vars can be initialized when params have been set in init on the param
 	 * events in the event loop.
 	 */
+	_LV_TIMING_BEGIN (actor->timing, begin);
 	visual_plugin_events_pump (actor->plugin);
+	_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_EVENTS, actor->timingtrack);
 
 	visual_video_set_palette (video, visual_actor_get_palette (actor));
 
@@ -570,8 +600,11 @@ int visual_actor_run (VisActor *actor, VisAudio *audio)
 
 	/* Yeah some transformation magic is going on here when needed */
 	if (transform != NULL && (transform->depth != video->depth)) {
+		_LV_TIMING_BEGIN (actor->timing, begin);
 		actplugin->render (plugin, transform, audio);
+		_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_RENDER, actor->timingtrack);
 
+		_LV_TIMING_BEGIN (actor->timing, begin);
 		if (transform->depth == VISUAL_VIDEO_DEPTH_8BIT) {
 			visual_video_set_palette (transform, visual_actor_get_palette (actor));
 			visual_video_depth_transform (video, transform);
@@ -579,12 +612,20 @@ int visual_actor_run (VisActor *actor, VisAudio *audio)
 			visual_video_set_palette (transform, actor->ditherpal);
 			visual_video_depth_transform (video, transform);
 		}
+		_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_TRANSFORM, actor->timingtrack);
 	} else {
 		if (fitting != NULL && (fitting->width != video->width || fitting->height != video->height)) {
+			_LV_TIMING_BEGIN (actor->timing, begin);
 			actplugin->render (plugin, fitting, audio);
+			_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_RENDER, actor->timingtrack);
+
+			_LV_TIMING_BEGIN (actor->timing, begin);
 			visual_video_blit_overlay (video, fitting, 0, 0, FALSE);
+			_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_TRANSFORM, actor->timingtrack);
 		} else {
+			_LV_TIMING_BEGIN (actor->timing, begin);
 			actplugin->render (plugin, video, audio);
+			_LV_TIMING_END (actor->timing, begin, VISUAL_TIMING_STAGE_RENDER, actor->timingtrack);
 		}
 	}
 
@@ -32,6 +32,7 @@
 #include <libvisual/lv_plugin.h>
 #include <libvisual/lv_songinfo.h>
 #include <libvisual/lv_event.h>
+#include <libvisual/lv_timing.h>
 
 /**
  * @defgroup VisActor VisActor
@@ -127,6 +128,11 @@ struct _VisActor {
 	/* Songinfo management */
 	VisSongInfo	 songcompare;		/**< Private member which is used to compare with new songinfo
 						  * to check if a new song event should be emitted. */
+
+	/* Instrumentation */
+	VisTiming	*timing;		/**< Private member in which the stages of visual_actor_run are recorded.
+						 * @see visual_actor_set_timing */
+	VisTimingTrack	 timingtrack;		/**< Private member, the track the stages are recorded on. */
 };
 
 /**
@@ -378,6 +384,20 @@ VisVideoAttributeOptions *visual_actor_get_video_attribute_options (VisActor *ac
  */
 int visual_actor_set_video (VisActor *actor, VisVideo *video);
 
+/**
+ * Records how long the stages of visual_actor_run take: pumping the plugin events, the
+ * render and the depth transformation or fitting. A VisBin sets this on its actors itself.
+ *
+ * @see visual_bin_set_timing
+ *
+ * @param actor Pointer to a VisActor of which the stages are recorded.
+ * @param timing Pointer to the VisTiming to record in, or NULL to stop recording.
+ * @param track The track the stages are recorded on.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_ACTOR_NULL on failure.
+ */
+int visual_actor_set_timing (VisActor *actor, VisTiming *timing, VisTimingTrack track);
+
 /**
  * This is called to run a VisActor. It also pump it's events when needed, checks for new song events and also does the fitting
  * and depth transformation actions when needed.
@@ -2,6 +2,7 @@
 #include "lv_alpha_blend.h"
 #include "lv_common.h"
 #include "lv_cpu.h"
+#include "private/lv_video_simd.h"
 
 #pragma pack(1)
 
@@ -32,10 +33,40 @@ VisAlphaBlendFunc visual_alpha_blend_32 = alpha_blend_32_c;
 
 void visual_alpha_blend_initialize (void)
 {
+	/* Arranged from slow to fast, so the slower version gets overloaded
+	 * every time */
+#if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 	if (visual_cpu_get_mmx () > 0) {
 		visual_alpha_blend_8  = alpha_blend_8_mmx;
 		visual_alpha_blend_32 = alpha_blend_32_mmx;
 	}
+#endif
+
+#if defined(HAVE_SSE2)
+	if (visual_cpu_get_sse2 () > 0) {
+		visual_alpha_blend_8  = _lv_alpha_blend_bytes_sse2;
+		visual_alpha_blend_16 = _lv_alpha_blend_16_sse2;
+		visual_alpha_blend_24 = _lv_alpha_blend_bytes_sse2;
+		visual_alpha_blend_32 = _lv_alpha_blend_bytes_sse2;
+	}
+#endif
+
+#if defined(HAVE_AVX2)
+	if (visual_cpu_get_avx2 () > 0) {
+		visual_alpha_blend_8  = _lv_alpha_blend_bytes_avx2;
+		visual_alpha_blend_24 = _lv_alpha_blend_bytes_avx2;
+		visual_alpha_blend_32 = _lv_alpha_blend_bytes_avx2;
+	}
+#endif
+
+#if defined(HAVE_NEON)
+	if (visual_cpu_get_neon () > 0) {
+		visual_alpha_blend_8  = _lv_alpha_blend_bytes_neon;
+		visual_alpha_blend_16 = _lv_alpha_blend_16_neon;
+		visual_alpha_blend_24 = _lv_alpha_blend_bytes_neon;
+		visual_alpha_blend_32 = _lv_alpha_blend_bytes_neon;
+	}
+#endif
 }
 
 static void alpha_blend_8_c (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
@@ -27,6 +27,7 @@
 #include "lv_fourier.h"
 #include "lv_math.h"
 #include "lv_util.h"
+#include "private/lv_atomic.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,6 +35,27 @@
 #include <string.h>
 #include <limits.h>
 
+/* Memoized spectra, see visual_audio_get_spectrum_batch(). The buffers never
+ * leave the VisAudio: callers get copies made with the audio lock held, as the
+ * next visual_audio_analyze() may recompute or drop them from another thread. */
+typedef struct {
+	char		*channelid;
+	int		 samplelen;
+	int		 valid;		/* FALSE when the channel is missing */
+	VisBuffer	*sample;
+} AudioSampleCacheEntry;
+
+typedef struct {
+	char		*channelid;
+	int		 size;
+	int		 samplelen;
+	int		 normalised;
+	int		 valid;		/* Computed for the current samplepool generation */
+	int		 requested;	/* Asked for since the last visual_audio_analyze() */
+	VisDFT		 dft;
+	VisBuffer	*spectrum;
+} AudioSpectrumCacheEntry;
+
 static int audio_dtor (VisObject *object);
 static int audio_samplepool_dtor (VisObject *object);
 static int audio_samplepool_channel_dtor (VisObject *object);
@@ -49,10 +71,24 @@ static int transform_format_buffer_from_float (VisBuffer *dest, VisBuffer *src,
 static int transform_format_buffer_to_float (VisBuffer *dest, VisBuffer *src, int size, int sign);
 static int transform_format_buffer (VisBuffer *dest, VisBuffer *src, int dsize, int ssize, int dsigned, int ssigned);
 
-/* Ringbuffer data provider functions */
-static VisBuffer *sample_data_func (VisRingBuffer *ringbuffer, VisRingBufferEntry *entry);
-static void sample_destroy_func (VisRingBufferEntry *entry);
-static int sample_size_func (VisRingBuffer *ringbuffer, VisRingBufferEntry *entry);
+/* Sample ring functions */
+static void convert_to_float (float *dest, const uint8_t *src, int count, int stride, VisAudioSampleFormatType format);
+static void channel_write (VisAudioSamplePoolChannel *channel, const uint8_t *src, int count, int stride,
+		VisAudioSampleFormatType format, VisTime *timestamp);
+static VisAudioSamplePoolChannel *samplepool_get_or_add_channel (VisAudioSamplePool *samplepool, const char *channelid);
+
+/* Spectrum cache functions */
+static int spectrum_sample_destroyer (void *data);
+static int spectrum_destroyer (void *data);
+static void spectrum_cache_sync (VisAudio *audio);
+static AudioSampleCacheEntry *spectrum_cache_get_sample (VisAudio *audio, const char *channelid, int samplelen);
+static AudioSpectrumCacheEntry *spectrum_cache_get (VisAudio *audio, VisAudioSpectrumRequest *request);
+static void spectrum_cache_compute (VisAudio *audio, AudioSpectrumCacheEntry *entry);
+static int spectrum_cache_batch (VisAudio *audio, VisAudioSpectrumRequest *requests, int count);
+
+static void audio_lock (VisAudio *audio);
+static void audio_unlock (VisAudio *audio);
+static int audio_is_beat_with_data (VisAudio *audio, VisBeatAlgorithm algo, unsigned char *visdata, int size);
 
 /*  functions */
 static int input_interleaved_stereo (VisAudioSamplePool *samplepool, VisBuffer *buffer,
@@ -67,7 +103,19 @@ static int audio_dtor (VisObject *object)
 	if (audio->samplepool != NULL)
 		visual_object_unref (VISUAL_OBJECT (audio->samplepool));
 
+	if (audio->spectra != NULL)
+		visual_object_unref (VISUAL_OBJECT (audio->spectra));
+
+	if (audio->spectrum_samples != NULL)
+		visual_object_unref (VISUAL_OBJECT (audio->spectrum_samples));
+
+	if (audio->mutex != NULL)
+		visual_mutex_free (audio->mutex);
+
 	audio->samplepool = NULL;
+	audio->spectra = NULL;
+	audio->spectrum_samples = NULL;
+	audio->mutex = NULL;
 
 	return VISUAL_OK;
 }
@@ -177,13 +225,32 @@ int visual_audio_init (VisAudio *audio)
 	/* Reset the VisAudio data */
 	audio->samplepool = visual_audio_samplepool_new ();
 
+	audio->spectra = visual_list_new (spectrum_destroyer);
+	audio->spectrum_samples = visual_list_new (spectrum_sample_destroyer);
+	audio->spectra_generation = audio->samplepool->generation;
+
+	/* Only needed when actors can run concurrently, see VisBin */
+	if (visual_thread_is_initialized () != FALSE && visual_thread_is_supported () != FALSE &&
+			visual_thread_is_enabled () != FALSE)
+		audio->mutex = visual_mutex_new ();
+
 	return VISUAL_OK;
 }
 
-int visual_audio_analyze (VisAudio *audio)
+static void audio_lock (VisAudio *audio)
 {
-	short pcm[3][1024];
+	if (audio->mutex != NULL)
+		visual_mutex_lock (audio->mutex);
+}
+
+static void audio_unlock (VisAudio *audio)
+{
+	if (audio->mutex != NULL)
+		visual_mutex_unlock (audio->mutex);
+}
 
+int visual_audio_analyze (VisAudio *audio)
+{
 #if 0
 	float temp_out[256];
 	float temp_audio[2][512];
@@ -201,51 +268,39 @@ int visual_audio_analyze (VisAudio *audio)
 		audio->pcm[2][i] = (audio->plugpcm[0][i] + audio->plugpcm[1][i]) >> 1;
 	}
 #endif
-	/* -------------------------------- audio pool testing */
-	{
-/*		VisBuffer *buffer = visual_buffer_new_allocate (sizeof (int16_t) * 512, visual_buffer_destroyer_free);
-		VisTime timestamp;
-		VisAudioSample *sample;
-
-		visual_mem_copy (visual_buffer_get_data (buffer), audio->plugpcm[2], sizeof (int16_t) * 512);
-
-		visual_time_get (&timestamp);
-
-		sample = visual_audio_sample_new (buffer, &timestamp,
-				VISUAL_AUDIO_SAMPLE_RATE_44100,
-				VISUAL_AUDIO_SAMPLE_FORMAT_S8);
+	visual_audio_samplepool_flush_old (audio->samplepool);
 
-		visual_audio_samplepool_add (audio->samplepool, sample, "front");
-*/
-		VisAudioSamplePoolChannel *channel;
-		VisBuffer buffer;
+	/* Recompute the spectra that were used during the last frame, drop the rest */
+	{
+		VisListEntry *le = NULL;
+		AudioSpectrumCacheEntry *entry;
 
-		visual_audio_samplepool_flush_old (audio->samplepool);
+		audio_lock (audio);
 
-		channel = visual_audio_samplepool_get_channel (audio->samplepool, VISUAL_AUDIO_CHANNEL_LEFT);
+		spectrum_cache_sync (audio);
 
-		if (channel != 0) {
-			visual_buffer_init (&buffer, pcm[0], 1024, NULL);
+		entry = visual_list_next (audio->spectra, &le);
 
-//			printf ("--channel debug: %s: %d\n", channel->channelid, visual_ringbuffer_get_size (channel->samples));
-			visual_ringbuffer_get_data (channel->samples, &buffer, 1024);
+		while (entry != NULL) {
+			if (entry->requested == FALSE) {
+				/* Leaves le at the next entry */
+				visual_list_destroy (audio->spectra, &le);
 
-			visual_object_unref (VISUAL_OBJECT (&buffer));
-		}
+				entry = le != NULL ? le->data : NULL;
 
-		channel = visual_audio_samplepool_get_channel (audio->samplepool, VISUAL_AUDIO_CHANNEL_RIGHT);
+				continue;
+			}
 
-		if (channel != 0) {
-			visual_buffer_init (&buffer, pcm[1], 1024, NULL);
+			if (entry->valid == FALSE)
+				spectrum_cache_compute (audio, entry);
 
-//			printf ("--channel debug: %s: %d\n", channel->channelid, visual_ringbuffer_get_size (channel->samples));
-			visual_ringbuffer_get_data (channel->samples, &buffer, 1024);
+			entry->requested = FALSE;
 
-			visual_object_unref (VISUAL_OBJECT (&buffer));
+			entry = visual_list_next (audio->spectra, &le);
 		}
 
+		audio_unlock (audio);
 	}
-	/* /-------------------------------- audio pool testing */
 
 //	for (i = 0; i < 512; i++) {
 //		audio->pcm[2][i] = (audio->pcm[0][i] + audio->pcm[1][i]) >> 1;
@@ -322,6 +377,7 @@ int visual_audio_analyze (VisAudio *audio)
 int visual_audio_get_sample (VisAudio *audio, VisBuffer *buffer, const char *channelid)
 {
 	VisAudioSamplePoolChannel *channel;
+	int ret;
 
 	visual_return_val_if_fail (audio != NULL, -VISUAL_ERROR_AUDIO_NULL);
 	visual_return_val_if_fail (buffer != NULL, -VISUAL_ERROR_BUFFER_NULL);
@@ -335,7 +391,15 @@ int visual_audio_get_sample (VisAudio *audio, VisBuffer *buffer, const char *cha
 		return -VISUAL_ERROR_AUDIO_SAMPLEPOOL_CHANNEL_NULL;
 	}
 
-	visual_ringbuffer_get_data_from_end (channel->samples, buffer, visual_buffer_get_size (buffer));
+	ret = visual_audio_ring_read_last (channel->samples, visual_buffer_get_data (buffer),
+			visual_buffer_get_size (buffer) / sizeof (float));
+
+	/* Rather silence than torn samples */
+	if (ret < 0) {
+		visual_buffer_fill (buffer, 0);
+
+		return ret;
+	}
 
 	return VISUAL_OK;
 }
@@ -511,21 +575,21 @@ int visual_audio_get_sample_mixed_all (VisAudio *audio, VisBuffer *buffer, int d
 
 int visual_audio_get_spectrum (VisAudio *audio, VisBuffer *buffer, int samplelen, const char *channelid, int normalised)
 {
-	VisBuffer sample;
+	VisAudioSpectrumRequest request;
 
 	visual_return_val_if_fail (audio != NULL, -VISUAL_ERROR_AUDIO_NULL);
 	visual_return_val_if_fail (buffer != NULL, -VISUAL_ERROR_BUFFER_NULL);
 	visual_return_val_if_fail (channelid != NULL, -VISUAL_ERROR_BUFFER_NULL);
 
-	visual_buffer_init_allocate (&sample, samplelen, visual_buffer_destroyer_free);
+	request.channelid = channelid;
+	request.size = visual_buffer_get_size (buffer);
+	request.samplelen = samplelen;
+	request.normalised = normalised;
+	request.spectrum = buffer;
 
-	if (visual_audio_get_sample (audio, &sample, channelid) == VISUAL_OK)
-		visual_audio_get_spectrum_for_sample (buffer, &sample, normalised);
-	else
+	if (visual_audio_get_spectrum_batch (audio, &request, 1) != VISUAL_OK)
 		visual_buffer_fill (buffer, 0);
 
-	visual_object_unref (VISUAL_OBJECT (&sample));
-
 	return VISUAL_OK;
 }
 
@@ -589,6 +653,41 @@ int visual_audio_get_spectrum_for_sample_multiplied (VisBuffer *buffer, VisBuffe
 	return ret;
 }
 
+int visual_audio_get_spectrum_batch (VisAudio *audio, VisAudioSpectrumRequest *requests, int count)
+{
+	int ret;
+
+	visual_return_val_if_fail (audio != NULL, -VISUAL_ERROR_AUDIO_NULL);
+	visual_return_val_if_fail (requests != NULL, -VISUAL_ERROR_NULL);
+
+	audio_lock (audio);
+	ret = spectrum_cache_batch (audio, requests, count);
+	audio_unlock (audio);
+
+	return ret;
+}
+
+VisBuffer *visual_audio_get_spectrum_cached (VisAudio *audio, const char *channelid, int size, int samplelen, int normalised)
+{
+	VisAudioSpectrumRequest request;
+
+	visual_return_val_if_fail (size >= (int) sizeof (float), NULL);
+
+	request.channelid = channelid;
+	request.size = size;
+	request.samplelen = samplelen;
+	request.normalised = normalised;
+	request.spectrum = visual_buffer_new_allocate (size, visual_buffer_destroyer_free);
+
+	if (visual_audio_get_spectrum_batch (audio, &request, 1) != VISUAL_OK) {
+		visual_object_unref (VISUAL_OBJECT (request.spectrum));
+
+		return NULL;
+	}
+
+	return request.spectrum;
+}
+
 int visual_audio_normalise_spectrum (VisBuffer *buffer)
 {
 	visual_return_val_if_fail (buffer != NULL, -VISUAL_ERROR_BUFFER_NULL);
@@ -600,6 +699,164 @@ int visual_audio_normalise_spectrum (VisBuffer *buffer)
 	return VISUAL_OK;
 }
 
+static int spectrum_sample_destroyer (void *data)
+{
+	AudioSampleCacheEntry *entry = data;
+
+	visual_object_unref (VISUAL_OBJECT (entry->sample));
+	visual_mem_free (entry->channelid);
+	visual_mem_free (entry);
+
+	return VISUAL_OK;
+}
+
+static int spectrum_destroyer (void *data)
+{
+	AudioSpectrumCacheEntry *entry = data;
+
+	visual_object_unref (VISUAL_OBJECT (entry->spectrum));
+	visual_object_unref (VISUAL_OBJECT (&entry->dft));
+	visual_mem_free (entry->channelid);
+	visual_mem_free (entry);
+
+	return VISUAL_OK;
+}
+
+/* Invalidates the memoized spectra when the samplepool changed since they were computed */
+static void spectrum_cache_sync (VisAudio *audio)
+{
+	VisListEntry *le = NULL;
+	AudioSpectrumCacheEntry *entry;
+
+	if (audio->spectra_generation == audio->samplepool->generation)
+		return;
+
+	while ((entry = visual_list_next (audio->spectra, &le)) != NULL)
+		entry->valid = FALSE;
+
+	le = NULL;
+
+	while (visual_list_next (audio->spectrum_samples, &le) != NULL) {
+		visual_list_destroy (audio->spectrum_samples, &le);
+
+		le = NULL;
+	}
+
+	audio->spectra_generation = audio->samplepool->generation;
+}
+
+static AudioSampleCacheEntry *spectrum_cache_get_sample (VisAudio *audio, const char *channelid, int samplelen)
+{
+	VisListEntry *le = NULL;
+	AudioSampleCacheEntry *entry;
+	int ret;
+
+	while ((entry = visual_list_next (audio->spectrum_samples, &le)) != NULL) {
+		if (entry->samplelen == samplelen && strcmp (entry->channelid, channelid) == 0)
+			return entry;
+	}
+
+	entry = visual_mem_new0 (AudioSampleCacheEntry, 1);
+
+	entry->channelid = visual_strdup (channelid);
+	entry->samplelen = samplelen;
+	entry->sample = visual_buffer_new_allocate (samplelen, visual_buffer_destroyer_free);
+
+	if (strcmp (channelid, VISUAL_AUDIO_CHANNEL_MIXED) == 0) {
+		ret = visual_audio_get_sample_mixed_simple (audio, entry->sample, 2,
+				VISUAL_AUDIO_CHANNEL_LEFT,
+				VISUAL_AUDIO_CHANNEL_RIGHT);
+	} else {
+		ret = visual_audio_get_sample (audio, entry->sample, channelid);
+	}
+
+	entry->valid = ret == VISUAL_OK;
+
+	visual_list_add (audio->spectrum_samples, entry);
+
+	return entry;
+}
+
+static AudioSpectrumCacheEntry *spectrum_cache_get (VisAudio *audio, VisAudioSpectrumRequest *request)
+{
+	VisListEntry *le = NULL;
+	AudioSpectrumCacheEntry *entry;
+
+	while ((entry = visual_list_next (audio->spectra, &le)) != NULL) {
+		if (entry->size == request->size && entry->samplelen == request->samplelen &&
+				entry->normalised == request->normalised &&
+				strcmp (entry->channelid, request->channelid) == 0)
+			return entry;
+	}
+
+	entry = visual_mem_new0 (AudioSpectrumCacheEntry, 1);
+
+	entry->channelid = visual_strdup (request->channelid);
+	entry->size = request->size;
+	entry->samplelen = request->samplelen;
+	entry->normalised = request->normalised;
+	entry->valid = FALSE;
+	entry->spectrum = visual_buffer_new_allocate (request->size, visual_buffer_destroyer_free);
+
+	visual_dft_init (&entry->dft, request->size / sizeof (float), request->samplelen / sizeof (float));
+
+	visual_list_add (audio->spectra, entry);
+
+	return entry;
+}
+
+static void spectrum_cache_compute (VisAudio *audio, AudioSpectrumCacheEntry *entry)
+{
+	AudioSampleCacheEntry *sample;
+
+	sample = spectrum_cache_get_sample (audio, entry->channelid, entry->samplelen);
+
+	if (sample->valid == FALSE) {
+		visual_buffer_fill (entry->spectrum, 0);
+	} else {
+		visual_dft_perform (&entry->dft, visual_buffer_get_data (entry->spectrum),
+				visual_buffer_get_data (sample->sample));
+
+		if (entry->normalised == TRUE)
+			visual_audio_normalise_spectrum (entry->spectrum);
+	}
+
+	entry->valid = TRUE;
+}
+
+/* Called with the audio lock held, copies every spectrum into its request */
+static int spectrum_cache_batch (VisAudio *audio, VisAudioSpectrumRequest *requests, int count)
+{
+	AudioSpectrumCacheEntry *entry;
+	int i;
+
+	spectrum_cache_sync (audio);
+
+	for (i = 0; i < count; i++) {
+		VisAudioSpectrumRequest *request = &requests[i];
+
+		visual_return_val_if_fail (request->channelid != NULL, -VISUAL_ERROR_NULL);
+		visual_return_val_if_fail (request->spectrum != NULL, -VISUAL_ERROR_BUFFER_NULL);
+		visual_return_val_if_fail (request->size >= (int) sizeof (float), -VISUAL_ERROR_BUFFER_OUT_OF_BOUNDS);
+		visual_return_val_if_fail (request->samplelen >= (int) sizeof (float), -VISUAL_ERROR_BUFFER_OUT_OF_BOUNDS);
+		visual_return_val_if_fail (visual_buffer_get_size (request->spectrum) >= (visual_size_t) request->size,
+				-VISUAL_ERROR_BUFFER_OUT_OF_BOUNDS);
+
+		entry = spectrum_cache_get (audio, request);
+
+		if (entry->valid == FALSE)
+			spectrum_cache_compute (audio, entry);
+
+		entry->requested = TRUE;
+
+		visual_mem_copy (visual_buffer_get_data (request->spectrum),
+				visual_buffer_get_data (entry->spectrum), request->size);
+	}
+
+	return VISUAL_OK;
+}
+
+
 VisAudioSamplePool *visual_audio_samplepool_new ()
 {
 	VisAudioSamplePool *samplepool;
@@ -626,6 +883,7 @@ int visual_audio_samplepool_init (VisAudioSamplePool *samplepool)
 
 	/* Reset the VisAudioSamplePool structure */
 	samplepool->channels = visual_list_new (visual_object_collection_destroyer);
+	samplepool->generation = 0;
 
 	return VISUAL_OK;
 }
@@ -638,17 +896,12 @@ int visual_audio_samplepool_add (VisAudioSamplePool *samplepool, VisAudioSample
 	visual_return_val_if_fail (sample != NULL, -VISUAL_ERROR_AUDIO_SAMPLE_NULL);
 	visual_return_val_if_fail (channelid != NULL, -VISUAL_ERROR_NULL);
 
-	channel = visual_audio_samplepool_get_channel (samplepool, channelid);
-
-	/* Channel not there yet, make it */
-	if (channel == NULL) {
-		channel = visual_audio_samplepool_channel_new (channelid);
-
-		visual_audio_samplepool_add_channel (samplepool, channel);
-	}
+	channel = samplepool_get_or_add_channel (samplepool, channelid);
 
 	visual_audio_samplepool_channel_add (channel, sample);
 
+	_lv_atomic_add (&samplepool->generation, 1);
+
 	return VISUAL_OK;
 }
 
@@ -659,6 +912,8 @@ int visual_audio_samplepool_add_channel (VisAudioSamplePool *samplepool, VisAudi
 
 	visual_list_add (samplepool->channels, channel);
 
+	_lv_atomic_add (&samplepool->generation, 1);
+
 	return VISUAL_OK;
 }
 
@@ -686,7 +941,12 @@ int visual_audio_samplepool_flush_old (VisAudioSamplePool *samplepool)
 	visual_return_val_if_fail (samplepool != NULL, -VISUAL_ERROR_AUDIO_SAMPLEPOOL_NULL);
 
 	while ((channel = visual_list_next (samplepool->channels, &le)) != NULL) {
+		int count = visual_audio_ring_get_available (channel->samples);
+
 		visual_audio_samplepool_channel_flush_old (channel);
+
+		if (visual_audio_ring_get_available (channel->samples) != count)
+			_lv_atomic_add (&samplepool->generation, 1);
 	}
 
 	return VISUAL_OK;
@@ -711,26 +971,57 @@ int visual_audio_samplepool_input_channel (VisAudioSamplePool *samplepool, VisBu
 		VisAudioSampleFormatType format,
 		const char *channelid)
 {
-	VisAudioSample *sample;
-	VisBuffer *pcmbuf;
+	VisAudioSamplePoolChannel *channel;
 	VisTime timestamp;
+	int samplesize;
 
 	visual_return_val_if_fail (samplepool != NULL, -VISUAL_ERROR_AUDIO_SAMPLEPOOL_NULL);
 	visual_return_val_if_fail (buffer != NULL, -VISUAL_ERROR_BUFFER_NULL);
+	visual_return_val_if_fail (channelid != NULL, -VISUAL_ERROR_NULL);
+
+	samplesize = visual_audio_sample_format_get_size (format);
 
-	pcmbuf = visual_buffer_new ();
-	visual_buffer_clone (pcmbuf, buffer);
+	visual_return_val_if_fail (samplesize > 0, -VISUAL_ERROR_GENERAL);
 
 	visual_time_get (&timestamp);
 
-	visual_buffer_set_destroyer (pcmbuf, visual_buffer_destroyer_free);
+	channel = samplepool_get_or_add_channel (samplepool, channelid);
 
-	sample = visual_audio_sample_new (pcmbuf, &timestamp, format, rate);
-	visual_audio_samplepool_add (samplepool, sample, channelid);
+	channel_write (channel, visual_buffer_get_data (buffer), visual_buffer_get_size (buffer) / samplesize, 1,
+			format, &timestamp);
+
+	_lv_atomic_add (&samplepool->generation, 1);
 
 	return VISUAL_OK;
 }
 
+static VisAudioSamplePoolChannel *samplepool_get_or_add_channel (VisAudioSamplePool *samplepool, const char *channelid)
+{
+	VisAudioSamplePoolChannel *channel;
+
+	channel = visual_audio_samplepool_get_channel (samplepool, channelid);
+
+	/* Channel not there yet, make it */
+	if (channel == NULL) {
+		VisListEntry *le;
+
+		channel = visual_audio_samplepool_channel_new (channelid);
+
+		/* The render thread can walk the channel list while an input thread adds
+		 * to it, publish the entry only once it's filled in */
+		le = visual_mem_new0 (VisListEntry, 1);
+		le->data = channel;
+
+		_lv_atomic_fence ();
+
+		visual_list_chain (samplepool->channels, le);
+
+		_lv_atomic_add (&samplepool->generation, 1);
+	}
+
+	return channel;
+}
+
 VisAudioSamplePoolChannel *visual_audio_samplepool_channel_new (const char *channelid)
 {
 	VisAudioSamplePoolChannel *channel;
@@ -756,9 +1047,10 @@ int visual_audio_samplepool_channel_init (VisAudioSamplePoolChannel *channel, co
 	visual_object_set_allocated (VISUAL_OBJECT (channel), FALSE);
 
 	/* Reset the VisAudioSamplePoolChannel data */
-	channel->samples = visual_ringbuffer_new ();
+	channel->samples = visual_audio_ring_new (VISUAL_AUDIO_SAMPLEPOOL_CHANNEL_FRAMES);
 
 	visual_time_set (&channel->samples_timeout, 1, 0); /* FIXME not safe against time screws */
+	visual_time_set (&channel->samples_time, 0, 0);
 	channel->channelid = visual_strdup (channelid);
 	channel->factor = 1.0;
 
@@ -767,45 +1059,43 @@ int visual_audio_samplepool_channel_init (VisAudioSamplePoolChannel *channel, co
 
 int visual_audio_samplepool_channel_add (VisAudioSamplePoolChannel *channel, VisAudioSample *sample)
 {
+	int samplesize;
+
 	visual_return_val_if_fail (channel != NULL, -VISUAL_ERROR_AUDIO_SAMPLEPOOL_CHANNEL_NULL);
 	visual_return_val_if_fail (sample != NULL, -VISUAL_ERROR_AUDIO_SAMPLE_NULL);
 
-	visual_ringbuffer_add_function (channel->samples,
-			sample_data_func,
-			sample_destroy_func,
-			sample_size_func, sample);
+	samplesize = visual_audio_sample_format_get_size (sample->format);
+
+	if (sample->buffer != NULL && samplesize > 0) {
+		channel_write (channel, visual_buffer_get_data (sample->buffer),
+				visual_buffer_get_size (sample->buffer) / samplesize, 1,
+				sample->format, &sample->timestamp);
+	}
+
+	/* The channel takes over the reference, like it did when it kept the samples */
+	visual_object_unref (VISUAL_OBJECT (sample));
 
 	return VISUAL_OK;
 }
 
 int visual_audio_samplepool_channel_flush_old (VisAudioSamplePoolChannel *channel)
 {
-	VisList *list;
-	VisListEntry *le = NULL;
-	VisRingBufferEntry *rentry;
-	VisAudioSample *sample;
+	VisTime diff;
+	VisTime curtime;
 
 	visual_return_val_if_fail (channel != NULL, -VISUAL_ERROR_AUDIO_SAMPLEPOOL_CHANNEL_NULL);
 
-	list = visual_ringbuffer_get_list (channel->samples);
-
-	while ((rentry = visual_list_next (list, &le)) != NULL) {
-		VisTime diff;
-		VisTime curtime;
-
-		sample = visual_ringbuffer_entry_get_functiondata (rentry);
+	if (visual_audio_ring_get_available (channel->samples) == 0)
+		return VISUAL_OK;
 
-		visual_time_get (&curtime);
+	visual_time_get (&curtime);
 
-		visual_time_difference (&diff, &sample->timestamp, &curtime);
+	/* The input thread may update samples_time meanwhile, at worst we keep the
+	 * samples for one more frame */
+	visual_time_difference (&diff, &channel->samples_time, &curtime);
 
-		if (visual_time_past (&diff, &channel->samples_timeout) == TRUE) {
-			visual_list_destroy (list, &le);
-
-			if (le == NULL)
-				break;
-		}
-	}
+	if (visual_time_past (&diff, &channel->samples_timeout) == TRUE)
+		visual_audio_ring_flush (channel->samples);
 
 	return VISUAL_OK;
 }
@@ -1016,6 +1306,20 @@ int visual_audio_sample_rate_get_length (VisAudioSampleRateType rate)
 	return ratelengthtable[rate];
 }
 
+/* The samplepool only knows a few rates, this picks the closest one */
+VisAudioSampleRateType visual_audio_sample_rate_from_hz (int hz)
+{
+	VisAudioSampleRateType rate;
+
+	for (rate = VISUAL_AUDIO_SAMPLE_RATE_8000; rate < VISUAL_AUDIO_SAMPLE_RATE_LAST - 1; rate++) {
+		if (hz < (visual_audio_sample_rate_get_length (rate) +
+					visual_audio_sample_rate_get_length (rate + 1)) / 2)
+			break;
+	}
+
+	return rate;
+}
+
 int visual_audio_sample_format_get_size (VisAudioSampleFormatType format)
 {
 	static int formatsizetable[] = {
@@ -1234,115 +1538,105 @@ static int transform_format_buffer (VisBuffer *dest, VisBuffer *src, int dsize,
 	return VISUAL_OK;
 }
 
-static VisBuffer *sample_data_func (VisRingBuffer *ringbuffer, VisRingBufferEntry *entry)
+#define CONVERT_TO_FLOAT(type,bias,multiplier)								\
+	{													\
+		const type *sbuf = (const type *) src;							\
+		for (i = 0; i < count; i++)								\
+			dest[i] = ((float) sbuf[i * stride] - (bias)) * (multiplier);			\
+	}
+
+/* Converts count samples, stride samples apart, to floats in the -1 to 1 range */
+static void convert_to_float (float *dest, const uint8_t *src, int count, int stride, VisAudioSampleFormatType format)
 {
-	VisAudioSample *sample = entry->functiondata;
+	int i;
 
-	/* We have internal format ready */
-	if (sample->processed != NULL) {
-		visual_object_ref (VISUAL_OBJECT (sample->processed));
+	switch (format) {
+		case VISUAL_AUDIO_SAMPLE_FORMAT_U8:
+			CONVERT_TO_FLOAT(uint8_t, 128.0f, 1.0f / 128.0f)
+			break;
 
-		return sample->processed;
-	}
+		case VISUAL_AUDIO_SAMPLE_FORMAT_S8:
+			CONVERT_TO_FLOAT(int8_t, 0.0f, 1.0f / 128.0f)
+			break;
 
-	sample->processed = visual_buffer_new_allocate (
-			(visual_buffer_get_size (sample->buffer) /
-			 visual_audio_sample_format_get_size (sample->format)) * sizeof (float),
-			visual_buffer_destroyer_free);
+		case VISUAL_AUDIO_SAMPLE_FORMAT_U16:
+			CONVERT_TO_FLOAT(uint16_t, 32768.0f, 1.0f / 32768.0f)
+			break;
 
-	transform_format_buffer_to_float (sample->processed, sample->buffer,
-			visual_audio_sample_format_get_size (sample->format),
-			visual_audio_sample_format_is_signed (sample->format));
+		case VISUAL_AUDIO_SAMPLE_FORMAT_S16:
+			CONVERT_TO_FLOAT(int16_t, 0.0f, 1.0f / 32768.0f)
+			break;
 
-	visual_object_ref (VISUAL_OBJECT (sample->processed));
+		case VISUAL_AUDIO_SAMPLE_FORMAT_U32:
+			CONVERT_TO_FLOAT(uint32_t, 2147483648.0f, 1.0f / 2147483648.0f)
+			break;
 
-	return sample->processed;
-}
+		case VISUAL_AUDIO_SAMPLE_FORMAT_S32:
+			CONVERT_TO_FLOAT(int32_t, 0.0f, 1.0f / 2147483648.0f)
+			break;
 
-static void sample_destroy_func (VisRingBufferEntry *entry)
-{
-	VisAudioSample *sample = entry->functiondata;
+		case VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT:
+			CONVERT_TO_FLOAT(float, 0.0f, 1.0f)
+			break;
 
-	visual_object_unref (VISUAL_OBJECT (sample));
+		default:
+			visual_mem_set (dest, 0, count * sizeof (float));
+			break;
+	}
 }
 
-static int sample_size_func (VisRingBuffer *ringbuffer, VisRingBufferEntry *entry)
+/* Converts samples straight into the channel its ring, which never allocates */
+static void channel_write (VisAudioSamplePoolChannel *channel, const uint8_t *src, int count, int stride,
+		VisAudioSampleFormatType format, VisTime *timestamp)
 {
-	VisAudioSample *sample = entry->functiondata;
+	VisAudioRingSpans spans;
+	int samplesize = visual_audio_sample_format_get_size (format);
+	int written;
+
+	written = visual_audio_ring_write_begin (channel->samples, &spans, count);
+
+	/* Only the newest samples fit */
+	src += (count - written) * stride * samplesize;
+
+	convert_to_float (spans.data1, src, spans.size1, stride, format);
 
-	return (visual_buffer_get_size (sample->buffer) /
-		visual_audio_sample_format_get_size (sample->format)) * sizeof (float);
+	if (spans.size2 > 0)
+		convert_to_float (spans.data2, src + spans.size1 * stride * samplesize, spans.size2, stride, format);
+
+	visual_audio_ring_write_commit (channel->samples, &spans);
+
+	visual_time_copy (&channel->samples_time, timestamp);
 }
 
 /*  functions */
-#define STEREO_INTERLEAVED(x)											\
-		{																\
-			/* do we have at least one complete frame? */				\
-			visual_size_t bufsize = visual_buffer_get_size (buffer); 	\
-			visual_return_val_if_fail(bufsize > sizeof(x), -1);		\
-			/* go around troubles with bufsizes <= 1) */				\
-			visual_return_val_if_fail(bufsize > 1, -1);				\
-																		\
-			chan1 = visual_buffer_new_allocate (sizeof (x) * ((visual_buffer_get_size (buffer) / 2)),	\
-				visual_buffer_destroyer_free);							\
-			chan2 = visual_buffer_new_allocate (sizeof (x) * ((visual_buffer_get_size (buffer) / 2)),	\
-					visual_buffer_destroyer_free);						\
-																		\
-			x *pcm = visual_buffer_get_data (buffer);					\
-			x *chan1buf = visual_buffer_get_data (chan1);				\
-			x *chan2buf = visual_buffer_get_data (chan2);				\
-																		\
-			visual_return_val_if_fail (pcm != NULL, -1); 			\
-			visual_return_val_if_fail (chan1buf != NULL, -1); 		\
-			visual_return_val_if_fail (chan2buf != NULL, -1); 		\
-																		\
-			for (i = 0; i < visual_buffer_get_size (buffer); i += 2) 	\
-			{															\
-				chan1buf[i >> 1] = pcm[i];								\
-				chan2buf[i >> 1] = pcm[i + 1];							\
-			}															\
-		}
-
 static int input_interleaved_stereo (VisAudioSamplePool *samplepool, VisBuffer *buffer,
 		VisAudioSampleFormatType format,
 		VisAudioSampleRateType rate)
 {
-	VisBuffer *chan1 = NULL;
-	VisBuffer *chan2 = NULL;
-	VisAudioSample *sample;
+	VisAudioSamplePoolChannel *left;
+	VisAudioSamplePoolChannel *right;
 	VisTime timestamp;
-	int i;
+	uint8_t *pcm = visual_buffer_get_data (buffer);
+	int samplesize = visual_audio_sample_format_get_size (format);
+	int frames;
 
-	visual_time_get (&timestamp);
+	visual_return_val_if_fail (pcm != NULL, -1);
+	visual_return_val_if_fail (samplesize > 0, -1);
 
-	if (format == VISUAL_AUDIO_SAMPLE_FORMAT_U8)
-		STEREO_INTERLEAVED(uint8_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_S8)
-		STEREO_INTERLEAVED(int8_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_U16)
-		STEREO_INTERLEAVED(uint16_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_S16)
-		STEREO_INTERLEAVED(int16_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_U32)
-		STEREO_INTERLEAVED(uint32_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_S32)
-		STEREO_INTERLEAVED(int32_t)
-	else if (format == VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT)
-		STEREO_INTERLEAVED(float)
-	else
-		return -1;
+	/* do we have at least one complete frame? */
+	frames = visual_buffer_get_size (buffer) / (samplesize * 2);
 
-	visual_return_val_if_fail (chan1 != NULL, -1);
-	visual_return_val_if_fail (chan2 != NULL, -1);
+	visual_return_val_if_fail (frames > 0, -1);
 
-	visual_buffer_set_destroyer (chan1, visual_buffer_destroyer_free);
-	visual_buffer_set_destroyer (chan2, visual_buffer_destroyer_free);
+	visual_time_get (&timestamp);
+
+	left = samplepool_get_or_add_channel (samplepool, VISUAL_AUDIO_CHANNEL_LEFT);
+	right = samplepool_get_or_add_channel (samplepool, VISUAL_AUDIO_CHANNEL_RIGHT);
 
-	sample = visual_audio_sample_new (chan1, &timestamp, format, rate);
-	visual_audio_samplepool_add (samplepool, sample, VISUAL_AUDIO_CHANNEL_LEFT);
+	channel_write (left, pcm, frames, 2, format, &timestamp);
+	channel_write (right, pcm + samplesize, frames, 2, format, &timestamp);
 
-	sample = visual_audio_sample_new (chan2, &timestamp, format, rate);
-	visual_audio_samplepool_add (samplepool, sample, VISUAL_AUDIO_CHANNEL_RIGHT);
+	_lv_atomic_add (&samplepool->generation, 1);
 
 	return VISUAL_OK;
 }
@@ -1543,6 +1837,21 @@ int visual_audio_is_beat(VisAudio *audio, VisBeatAlgorithm algo)
 }
 
 int visual_audio_is_beat_with_data(VisAudio *audio, VisBeatAlgorithm algo, unsigned char *visdata, int size)
+{
+    int ret;
+
+    visual_return_val_if_fail(audio != NULL, -VISUAL_ERROR_AUDIO_NULL);
+    visual_return_val_if_fail(visdata != NULL, -VISUAL_ERROR_NULL);
+
+    /* The beat state is shared by all actors */
+    audio_lock(audio);
+    ret = audio_is_beat_with_data(audio, algo, visdata, size);
+    audio_unlock(audio);
+
+    return ret;
+}
+
+static int audio_is_beat_with_data(VisAudio *audio, VisBeatAlgorithm algo, unsigned char *visdata, int size)
 {
     static int outPtr = 0, inPtr = 0;
     unsigned char outBuf[9], inBuf[9];
@@ -27,6 +27,8 @@
 #include <libvisual/lv_beat.h>
 #include <libvisual/lv_time.h>
 #include <libvisual/lv_ringbuffer.h>
+#include <libvisual/lv_audioring.h>
+#include <libvisual/lv_thread.h>
 
 VISUAL_BEGIN_DECLS
 
@@ -43,6 +45,12 @@ VISUAL_BEGIN_DECLS
 #define VISUAL_AUDIO_CHANNEL_LEFT	"front left 1"
 #define VISUAL_AUDIO_CHANNEL_RIGHT	"front right 1"
 
+/* Pseudo channel for the spectrum cache, the average of the front left and right channels */
+#define VISUAL_AUDIO_CHANNEL_MIXED	"front mixed"
+
+/* Capacity of a VisAudioSamplePoolChannel in frames, a bit over a second at 48 kHz */
+#define VISUAL_AUDIO_SAMPLEPOOL_CHANNEL_FRAMES	65536
+
 #define VISUAL_AUDIO_CHANNEL_CATEGORY_FRONT	"front"
 #define VISUAL_AUDIO_CHANNEL_CATEGORY_REAR	"rear"
 #define VISUAL_AUDIO_CHANNEL_CATEGORY_RIGHT	"left"
@@ -82,6 +90,7 @@ typedef struct _VisAudio VisAudio;
 typedef struct _VisAudioSamplePool VisAudioSamplePool;
 typedef struct _VisAudioSamplePoolChannel VisAudioSamplePoolChannel;
 typedef struct _VisAudioSample VisAudioSample;
+typedef struct _VisAudioSpectrumRequest VisAudioSpectrumRequest;
 
 /**
  * The VisAudio structure contains the sample and extra information
@@ -109,19 +118,33 @@ struct _VisAudio {
 //	short int		 bpmenergy[6];			/**< Private member for BPM detection, not implemented right now. */
 	int			 energy;			/**< Audio energy level. */
 	VisBeat			*beat; 				/**< Beat per minute. */
+
+	VisList			*spectra;			/**< Private spectra memoized for the current frame. */
+	VisList			*spectrum_samples;		/**< Private samples the memoized spectra are computed from. */
+	unsigned int		 spectra_generation;		/**< Private samplepool generation of the memoized spectra. */
+	VisMutex		*mutex;				/**< Private, guards the memoized spectra and the beat
+								 * detection against actors running concurrently. */
 };
 
 struct _VisAudioSamplePool {
 	VisObject	 object;
 
 	VisList		*channels;
+
+	volatile unsigned int	 generation;	/**< Bumped whenever samples are added or flushed. */
 };
 
+/**
+ * A channel within the VisAudioSamplePool. The samples are kept as float frames in a
+ * VisAudioRing, so one input thread can add samples while the render thread reads them
+ * without locking or allocating.
+ */
 struct _VisAudioSamplePoolChannel {
 	VisObject	 object;
 
-	VisRingBuffer	*samples;
+	VisAudioRing	*samples;
 	VisTime		 samples_timeout;
+	VisTime		 samples_time;	/**< Timestamp of the latest samples. */
 
 	char		*channelid;
 
@@ -140,6 +163,19 @@ struct _VisAudioSample {
 	VisBuffer			*processed;
 };
 
+/**
+ * Describes one spectrum for visual_audio_get_spectrum_batch().
+ */
+struct _VisAudioSpectrumRequest {
+	const char	*channelid;	/**< The channel to analyze, may be VISUAL_AUDIO_CHANNEL_MIXED. */
+	int		 size;		/**< Size of the spectrum in bytes. */
+	int		 samplelen;	/**< Size of the analyzed sample in bytes. */
+	int		 normalised;	/**< Whether the spectrum gets log scaled. */
+
+	VisBuffer	*spectrum;	/**< Caller-owned buffer of at least size bytes, the spectrum is
+					  *  copied into it. */
+};
+
 /**
  * Creates a new VisAudio structure.
  *
@@ -186,6 +222,39 @@ int visual_audio_get_spectrum_multiplied (VisAudio *audio, VisBuffer *buffer, in
 int visual_audio_get_spectrum_for_sample (VisBuffer *buffer, VisBuffer *sample, int normalised);
 int visual_audio_get_spectrum_for_sample_multiplied (VisBuffer *buffer, VisBuffer *sample, int normalised, float multiplier);
 
+/**
+ * Computes a set of spectra at once, and memoizes them until new samples arrive in the
+ * VisAudioSamplePool. Every spectrum is computed at most once per frame, no matter how
+ * many actors ask for it, and samples shared by several requests are only read once.
+ *
+ * Spectra that were asked for during a frame are recomputed up front by the next
+ * visual_audio_analyze(), spectra that were not are dropped. As that can happen on another
+ * thread, the memoized spectra are never handed out: each is copied into the buffer of its
+ * request while the VisAudio is locked.
+ *
+ * @param audio Pointer to the VisAudio to get the spectra from.
+ * @param requests Array of requests, the spectrum buffer of each is filled in.
+ * @param count Number of requests.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_AUDIO_NULL, -VISUAL_ERROR_NULL or
+ *	-VISUAL_ERROR_BUFFER_OUT_OF_BOUNDS on failure.
+ */
+int visual_audio_get_spectrum_batch (VisAudio *audio, VisAudioSpectrumRequest *requests, int count);
+
+/**
+ * Gets a single memoized spectrum, see visual_audio_get_spectrum_batch().
+ *
+ * @param audio Pointer to the VisAudio to get the spectrum from.
+ * @param channelid The channel to analyze, may be VISUAL_AUDIO_CHANNEL_MIXED.
+ * @param size Size of the spectrum in bytes.
+ * @param samplelen Size of the analyzed sample in bytes.
+ * @param normalised Whether the spectrum gets log scaled.
+ *
+ * @return A newly allocated copy of the spectrum, to be unreferenced by the caller,
+ *	or NULL on failure.
+ */
+VisBuffer *visual_audio_get_spectrum_cached (VisAudio *audio, const char *channelid, int size, int samplelen, int normalised);
+
 int visual_audio_normalise_spectrum (VisBuffer *buffer);
 
 VisAudioSamplePool *visual_audio_samplepool_new (void);
@@ -222,6 +291,7 @@ int visual_audio_sample_has_internal (VisAudioSample *sample);
 int visual_audio_sample_transform_format (VisAudioSample *dest, VisAudioSample *src, VisAudioSampleFormatType format);
 int visual_audio_sample_transform_rate (VisAudioSample *dest, VisAudioSample *src, VisAudioSampleRateType rate);
 int visual_audio_sample_rate_get_length (VisAudioSampleRateType rate);
+VisAudioSampleRateType visual_audio_sample_rate_from_hz (int hz);
 int visual_audio_sample_format_get_size (VisAudioSampleFormatType format);
 int visual_audio_sample_format_is_signed (VisAudioSampleFormatType format);
 
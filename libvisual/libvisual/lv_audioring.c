@@ -0,0 +1,245 @@
+#include "config.h"
+#include "lv_audioring.h"
+#include "lv_common.h"
+#include "private/lv_atomic.h"
+
+#include <string.h>
+
+/* Retries of visual_audio_ring_read_last() when the writer laps the copy */
+#define AUDIO_RING_READ_RETRIES	4
+
+static int audio_ring_dtor (VisObject *object);
+
+static void audio_ring_get_spans (VisAudioRing *ring, VisAudioRingSpans *spans, unsigned int start, unsigned int count);
+
+
+static int audio_ring_dtor (VisObject *object)
+{
+	VisAudioRing *ring = VISUAL_AUDIO_RING (object);
+
+	if (ring->frames != NULL)
+		visual_mem_free (ring->frames);
+
+	ring->frames = NULL;
+
+	return VISUAL_OK;
+}
+
+static void audio_ring_get_spans (VisAudioRing *ring, VisAudioRingSpans *spans, unsigned int start, unsigned int count)
+{
+	unsigned int index = start & ring->mask;
+
+	spans->data1 = ring->frames + index;
+	spans->size1 = count;
+	spans->data2 = NULL;
+	spans->size2 = 0;
+
+	if (index + count > ring->size) {
+		spans->size1 = ring->size - index;
+		spans->data2 = ring->frames;
+		spans->size2 = count - spans->size1;
+	}
+}
+
+VisAudioRing *visual_audio_ring_new (int size)
+{
+	VisAudioRing *ring;
+
+	ring = visual_mem_new0 (VisAudioRing, 1);
+
+	if (visual_audio_ring_init (ring, size) != VISUAL_OK) {
+		visual_mem_free (ring);
+
+		return NULL;
+	}
+
+	/* Do the VisObject initialization */
+	visual_object_set_allocated (VISUAL_OBJECT (ring), TRUE);
+	visual_object_ref (VISUAL_OBJECT (ring));
+
+	return ring;
+}
+
+int visual_audio_ring_init (VisAudioRing *ring, int size)
+{
+	unsigned int capacity = 1;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (size > 0 && size <= (1 << 30), -VISUAL_ERROR_GENERAL);
+
+	/* Do the VisObject initialization */
+	visual_object_clear (VISUAL_OBJECT (ring));
+	visual_object_set_dtor (VISUAL_OBJECT (ring), audio_ring_dtor);
+	visual_object_set_allocated (VISUAL_OBJECT (ring), FALSE);
+
+	while (capacity < (unsigned int) size)
+		capacity <<= 1;
+
+	/* Reset the VisAudioRing data */
+	ring->frames = visual_mem_malloc0 (capacity * sizeof (float));
+	ring->size = capacity;
+	ring->mask = capacity - 1;
+	ring->head = 0;
+	ring->reserved = 0;
+	ring->tail = 0;
+
+	return VISUAL_OK;
+}
+
+int visual_audio_ring_get_size (VisAudioRing *ring)
+{
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+
+	return ring->size;
+}
+
+int visual_audio_ring_get_available (VisAudioRing *ring)
+{
+	unsigned int available;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+
+	available = _lv_atomic_load (&ring->head) - ring->tail;
+
+	return available > ring->size ? ring->size : available;
+}
+
+int visual_audio_ring_write_begin (VisAudioRing *ring, VisAudioRingSpans *spans, int count)
+{
+	unsigned int head;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (spans != NULL, -VISUAL_ERROR_NULL);
+
+	if (count < 0)
+		count = 0;
+	else if ((unsigned int) count > ring->size)
+		count = ring->size;
+
+	head = ring->head;
+
+	/* Announce the frames about to be overwritten before touching them, so the
+	 * reader can tell its region went stale */
+	_lv_atomic_store (&ring->reserved, head + count);
+	_lv_atomic_fence ();
+
+	audio_ring_get_spans (ring, spans, head, count);
+	spans->position = head;
+
+	return count;
+}
+
+int visual_audio_ring_write_commit (VisAudioRing *ring, VisAudioRingSpans *spans)
+{
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (spans != NULL, -VISUAL_ERROR_NULL);
+
+	_lv_atomic_store (&ring->head, spans->position + spans->size1 + spans->size2);
+
+	return VISUAL_OK;
+}
+
+int visual_audio_ring_write (VisAudioRing *ring, const float *frames, int count)
+{
+	VisAudioRingSpans spans;
+	int written;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (frames != NULL, -VISUAL_ERROR_NULL);
+
+	written = visual_audio_ring_write_begin (ring, &spans, count);
+
+	/* Only the newest frames fit */
+	frames += count - written;
+
+	visual_mem_copy (spans.data1, frames, spans.size1 * sizeof (float));
+
+	if (spans.size2 > 0)
+		visual_mem_copy (spans.data2, frames + spans.size1, spans.size2 * sizeof (float));
+
+	return visual_audio_ring_write_commit (ring, &spans);
+}
+
+int visual_audio_ring_peek_last (VisAudioRing *ring, VisAudioRingSpans *spans, int count)
+{
+	unsigned int head;
+	unsigned int available;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (spans != NULL, -VISUAL_ERROR_NULL);
+
+	head = _lv_atomic_load (&ring->head);
+	available = head - ring->tail;
+
+	if (available > ring->size)
+		available = ring->size;
+
+	if (count < 0)
+		count = 0;
+	else if ((unsigned int) count > available)
+		count = available;
+
+	audio_ring_get_spans (ring, spans, head - count, count);
+	spans->position = head;
+
+	return count;
+}
+
+int visual_audio_ring_peek_is_valid (VisAudioRing *ring, VisAudioRingSpans *spans)
+{
+	unsigned int start;
+
+	visual_return_val_if_fail (ring != NULL, FALSE);
+	visual_return_val_if_fail (spans != NULL, FALSE);
+
+	start = spans->position - (spans->size1 + spans->size2);
+
+	/* Make sure all reads of the region happened before looking at the writer */
+	_lv_atomic_fence ();
+
+	return _lv_atomic_load (&ring->reserved) - start <= ring->size;
+}
+
+int visual_audio_ring_read_last (VisAudioRing *ring, float *dest, int count)
+{
+	VisAudioRingSpans spans;
+	int retries = AUDIO_RING_READ_RETRIES;
+	int n;
+
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+	visual_return_val_if_fail (dest != NULL, -VISUAL_ERROR_NULL);
+
+	if (count <= 0)
+		return 0;
+
+	for (;;) {
+		n = visual_audio_ring_peek_last (ring, &spans, count);
+
+		visual_mem_copy (dest + count - n, spans.data1, spans.size1 * sizeof (float));
+
+		if (spans.size2 > 0)
+			visual_mem_copy (dest + count - spans.size2, spans.data2, spans.size2 * sizeof (float));
+
+		if (visual_audio_ring_peek_is_valid (ring, &spans) == TRUE)
+			break;
+
+		/* The writer kept lapping us, what we have may be torn */
+		if (--retries == 0)
+			return -VISUAL_ERROR_GENERAL;
+	}
+
+	/* Not enough history, treat it as silence */
+	if (n < count)
+		visual_mem_set (dest, 0, (count - n) * sizeof (float));
+
+	return n;
+}
+
+int visual_audio_ring_flush (VisAudioRing *ring)
+{
+	visual_return_val_if_fail (ring != NULL, -VISUAL_ERROR_AUDIO_RING_NULL);
+
+	ring->tail = _lv_atomic_load (&ring->head);
+
+	return VISUAL_OK;
+}
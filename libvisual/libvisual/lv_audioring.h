@@ -0,0 +1,177 @@
+#ifndef _LV_AUDIORING_H
+#define _LV_AUDIORING_H
+
+#include <libvisual/lvconfig.h>
+#include <libvisual/lv_defines.h>
+#include <libvisual/lv_object.h>
+
+/**
+ * @defgroup VisAudioRing VisAudioRing
+ * @{
+ */
+
+VISUAL_BEGIN_DECLS
+
+#define VISUAL_AUDIO_RING(obj)				(VISUAL_CHECK_CAST ((obj), VisAudioRing))
+
+typedef struct _VisAudioRing VisAudioRing;
+typedef struct _VisAudioRingSpans VisAudioRingSpans;
+
+/**
+ * A region of the ring, which is at most two contiguous spans because of the wraparound.
+ */
+struct _VisAudioRingSpans {
+	float		*data1;		/**< The first (oldest) span. */
+	int		 size1;		/**< Number of frames in the first span. */
+	float		*data2;		/**< The second span, NULL when the region does not wrap. */
+	int		 size2;		/**< Number of frames in the second span. */
+
+	unsigned int	 position;	/**< Private, write position the region was taken at. */
+};
+
+/**
+ * The VisAudioRing is a contiguous, lock-free ring of float frames for one writer
+ * and one reader thread. The writer never blocks and overwrites the oldest frames,
+ * the reader looks at the most recent frames in place.
+ *
+ * Frames are never allocated after the ring is created.
+ */
+struct _VisAudioRing {
+	VisObject		 object;	/**< The VisObject data. */
+
+	float			*frames;	/**< The frame storage. */
+	unsigned int		 size;		/**< Capacity in frames, a power of two. */
+	unsigned int		 mask;		/**< size - 1. */
+
+	volatile unsigned int	 head;		/**< Frames written in total, owned by the writer. */
+	volatile unsigned int	 reserved;	/**< Frames written in total including the write in progress. */
+	volatile unsigned int	 tail;		/**< Frames discarded in total, owned by the reader. */
+};
+
+/**
+ * Creates a new VisAudioRing.
+ *
+ * @param size The minimal capacity in frames, rounded up to a power of two.
+ *
+ * @return A newly allocated VisAudioRing, or NULL on failure.
+ */
+VisAudioRing *visual_audio_ring_new (int size);
+
+/**
+ * Initializes a VisAudioRing, see visual_audio_ring_new().
+ *
+ * @param ring Pointer to the VisAudioRing which needs to be initialized.
+ * @param size The minimal capacity in frames, rounded up to a power of two.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_AUDIO_RING_NULL or -VISUAL_ERROR_GENERAL on failure.
+ */
+int visual_audio_ring_init (VisAudioRing *ring, int size);
+
+/**
+ * Gets the capacity of the ring in frames.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ *
+ * @return The capacity, or -VISUAL_ERROR_AUDIO_RING_NULL on failure.
+ */
+int visual_audio_ring_get_size (VisAudioRing *ring);
+
+/**
+ * Gets the number of frames that can be read, which is never more than the capacity.
+ * Reader side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ *
+ * @return The number of readable frames, or -VISUAL_ERROR_AUDIO_RING_NULL on failure.
+ */
+int visual_audio_ring_get_available (VisAudioRing *ring);
+
+/**
+ * Starts a write of count frames, to be filled in place through the returned spans and
+ * finished with visual_audio_ring_write_commit(). Writes of more frames than the
+ * capacity are clipped to the capacity. Writer side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param spans Filled in with the region to write to.
+ * @param count Number of frames to write.
+ *
+ * @return The number of frames in the region, or -VISUAL_ERROR_AUDIO_RING_NULL on failure.
+ */
+int visual_audio_ring_write_begin (VisAudioRing *ring, VisAudioRingSpans *spans, int count);
+
+/**
+ * Publishes a write started with visual_audio_ring_write_begin(). Writer side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param spans The region returned by visual_audio_ring_write_begin().
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_AUDIO_RING_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_audio_ring_write_commit (VisAudioRing *ring, VisAudioRingSpans *spans);
+
+/**
+ * Copies frames into the ring. Writer side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param frames The frames to write.
+ * @param count Number of frames to write, only the last capacity frames are kept.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_AUDIO_RING_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_audio_ring_write (VisAudioRing *ring, const float *frames, int count);
+
+/**
+ * Looks at the last count frames in place, without copying. The writer can overwrite
+ * the region while it is being used, so check it with visual_audio_ring_peek_is_valid()
+ * afterwards. Reader side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param spans Filled in with the region holding the frames, oldest first.
+ * @param count Number of frames to look at.
+ *
+ * @return The number of frames in the region, less than count when not enough frames
+ *	are available, or -VISUAL_ERROR_AUDIO_RING_NULL on failure.
+ */
+int visual_audio_ring_peek_last (VisAudioRing *ring, VisAudioRingSpans *spans, int count);
+
+/**
+ * Checks whether a region returned by visual_audio_ring_peek_last() is still intact.
+ * Reader side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param spans The region returned by visual_audio_ring_peek_last().
+ *
+ * @return TRUE when the region was not overwritten, FALSE if it was.
+ */
+int visual_audio_ring_peek_is_valid (VisAudioRing *ring, VisAudioRingSpans *spans);
+
+/**
+ * Copies the last count frames out of the ring. When fewer frames are available the
+ * start of the destination is zero filled. Reader side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ * @param dest Destination for count frames.
+ * @param count Number of frames to copy.
+ *
+ * @return The number of frames copied from the ring, -VISUAL_ERROR_GENERAL when the writer
+ *	kept overwriting the frames while they were copied, leaving dest undefined, or
+ *	-VISUAL_ERROR_AUDIO_RING_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_audio_ring_read_last (VisAudioRing *ring, float *dest, int count);
+
+/**
+ * Discards all frames that are currently in the ring. Reader side.
+ *
+ * @param ring Pointer to the VisAudioRing.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_AUDIO_RING_NULL on failure.
+ */
+int visual_audio_ring_flush (VisAudioRing *ring);
+
+VISUAL_END_DECLS
+
+/**
+ * @}
+ */
+
+#endif /* _LV_AUDIORING_H */
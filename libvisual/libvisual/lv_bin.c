@@ -26,22 +26,54 @@
 #include "lv_common.h"
 #include "lv_list.h"
 #include "gettext.h"
+#include "private/lv_atomic.h"
+#include "private/lv_thread_pool.h"
+#include "private/lv_timing_hooks.h"
+#include <string.h>
 
 /* WARNING: Utterly shit ahead, i've screwed up on this and i need to
  * rewrite it. And i can't say i feel like it at the moment so be
  * patient :)  */
 
+/* Minimal time between two uploads on the input thread, so inputs
+ * that don't block on a device don't spin */
+#define BIN_INPUT_INTERVAL_USEC		5000
+
 static int bin_dtor (VisObject *object);
 
 static void fix_depth_with_bin (VisBin *bin, VisVideo *video, int depth);
 static int bin_get_depth_using_preferred (VisBin *bin, int depthflag);
 
+static int bin_set_morph_by_name (VisBin *bin, char *morphname);
+static int bin_sync (VisBin *bin, int noevent);
+static int bin_set_depth (VisBin *bin, int depth);
+static int bin_switch_actor_by_name (VisBin *bin, char *actname);
+static int bin_switch_actor (VisBin *bin, VisActor *actor);
+static int bin_switch_finalize (VisBin *bin);
+static int bin_render (VisBin *bin);
+static void bin_timing_attach (VisBin *bin);
+static int bin_morph_can_parallel (VisBin *bin);
+static void bin_actors_run (void *data, int index);
+
+static void bin_pause (VisBin *bin);
+static void bin_resume (VisBin *bin);
+static int bin_threads_start (VisBin *bin);
+static void bin_threads_stop (VisBin *bin);
+static void *bin_input_thread (void *data);
+static void *bin_render_thread (void *data);
+static void bin_render_frame (VisBin *bin);
+static void bin_frames_reset (VisBin *bin, int valid);
+static int bin_run_threaded (VisBin *bin);
+
 static int bin_dtor (VisObject *object)
 {
 	VisBin *bin = VISUAL_BIN (object);
+	int i;
 
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_threads_stop (bin);
+
 	if (bin->actor != NULL)
 		visual_object_unref (VISUAL_OBJECT (bin->actor));
 
@@ -62,12 +94,48 @@ static int bin_dtor (VisObject *object)
 	if (bin->privvid != NULL)
 		visual_object_unref (VISUAL_OBJECT (bin->privvid));
 
+	if (bin->rendervideo != NULL)
+		visual_object_unref (VISUAL_OBJECT (bin->rendervideo));
+
+	for (i = 0; i < VISUAL_BIN_FRAME_QUEUE_SIZE; i++) {
+		if (bin->frames[i] != NULL)
+			visual_object_unref (VISUAL_OBJECT (bin->frames[i]));
+
+		if (bin->framepals[i] != NULL)
+			visual_object_unref (VISUAL_OBJECT (bin->framepals[i]));
+	}
+
+	if (bin->outpal != NULL)
+		visual_object_unref (VISUAL_OBJECT (bin->outpal));
+
+	if (bin->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (bin->timing));
+
+	if (bin->inputmutex != NULL)
+		visual_mutex_free (bin->inputmutex);
+
+	if (bin->rendermutex != NULL)
+		visual_mutex_free (bin->rendermutex);
+
+	if (bin->framemutex != NULL)
+		visual_mutex_free (bin->framemutex);
+
+	if (bin->framecond != NULL)
+		visual_cond_free (bin->framecond);
+
 	bin->actor = NULL;
 	bin->input = NULL;
 	bin->morph = NULL;
 	bin->actmorph = NULL;
 	bin->actmorphvideo = NULL;
 	bin->privvid = NULL;
+	bin->rendervideo = NULL;
+	bin->outpal = NULL;
+	bin->timing = NULL;
+	bin->inputmutex = NULL;
+	bin->rendermutex = NULL;
+	bin->framemutex = NULL;
+	bin->framecond = NULL;
 
 	return VISUAL_OK;
 }
@@ -106,6 +174,8 @@ VisBin *visual_bin_new ()
 	bin->morphmode = VISUAL_MORPH_MODE_TIME;
 	visual_time_set (&bin->morphtime, 4, 0);
 
+	bin->morphparallel = TRUE;
+
 	bin->depthpreferred = VISUAL_BIN_DEPTH_HIGHEST;
 
 	return bin;
@@ -115,6 +185,8 @@ int visual_bin_realize (VisBin *bin)
 {
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+
 	if (bin->actor != NULL)
 		visual_actor_realize (bin->actor);
 
@@ -124,6 +196,8 @@ int visual_bin_realize (VisBin *bin)
 	if (bin->morph != NULL)
 		visual_morph_realize (bin->morph);
 
+	bin_resume (bin);
+
 	return 0;
 }
 
@@ -131,10 +205,14 @@ int visual_bin_set_actor (VisBin *bin, VisActor *actor)
 {
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+
 	bin->actor = actor;
 
 	bin->managed = FALSE;
 
+	bin_resume (bin);
+
 	return 0;
 }
 
@@ -149,10 +227,20 @@ int visual_bin_set_input (VisBin *bin, VisInput *input)
 {
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+
+	if (bin->inputmutex != NULL)
+		visual_mutex_lock (bin->inputmutex);
+
 	bin->input = input;
 
 	bin->inputmanaged = FALSE;
 
+	if (bin->inputmutex != NULL)
+		visual_mutex_unlock (bin->inputmutex);
+
+	bin_resume (bin);
+
 	return 0;
 }
 
@@ -167,20 +255,35 @@ int visual_bin_set_morph (VisBin *bin, VisMorph *morph)
 {
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+
 	bin->morph = morph;
 
 	bin->morphmanaged = FALSE;
 
+	bin_resume (bin);
+
 	return 0;
 }
 
 int visual_bin_set_morph_by_name (VisBin *bin, char *morphname)
 {
-	VisMorph *morph;
-	int depthflag;
+	int ret;
 
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+	ret = bin_set_morph_by_name (bin, morphname);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_set_morph_by_name (VisBin *bin, char *morphname)
+{
+	VisMorph *morph;
+	int depthflag;
+
 	if (bin->morph != NULL)
 		visual_object_unref (VISUAL_OBJECT (bin->morph));
 
@@ -231,6 +334,8 @@ int visual_bin_connect (VisBin *bin, VisActor *actor, VisInput *input)
     visual_return_val_if_fail(actor != NULL, -1);
     visual_return_val_if_fail(input != NULL, -1);
 
+    bin_pause (bin);
+
     visual_bin_set_actor (bin, actor);
     visual_bin_set_input (bin, input);
 
@@ -252,6 +357,8 @@ int visual_bin_connect (VisBin *bin, VisActor *actor, VisInput *input)
 
     bin->depthforcedmain = bin->depth;
 
+    bin_resume (bin);
+
     return 0;
 }
 
@@ -283,11 +390,22 @@ int visual_bin_connect_by_names (VisBin *bin, char *actname, char *inname)
 
 int visual_bin_sync (VisBin *bin, int noevent)
 {
-	VisVideo *video;
-	VisVideo *actvideo;
+	int ret;
 
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+	ret = bin_sync (bin, noevent);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_sync (VisBin *bin, int noevent)
+{
+	VisVideo *video;
+	VisVideo *actvideo;
+
 	visual_log (VISUAL_LOG_DEBUG, "starting sync");
 
 	/* Sync the actor regarding morph */
@@ -380,9 +498,38 @@ int visual_bin_sync (VisBin *bin, int noevent)
 
 int visual_bin_set_video (VisBin *bin, VisVideo *video)
 {
+	int valid = FALSE;
+
 	visual_return_val_if_fail (bin != NULL, -1);
 
-	bin->actvideo = video;
+	if (bin->threaded == FALSE) {
+		bin->actvideo = video;
+
+		return 0;
+	}
+
+	bin_pause (bin);
+
+	bin->outvideo = video;
+
+	/* The actors draw into a private video that is handed over through the frame
+	 * queue. GL contexts are bound to the client thread, so those draw directly */
+	if (video != NULL && video->depth != VISUAL_VIDEO_DEPTH_GL) {
+		if (visual_video_get_pixels (bin->rendervideo) != NULL)
+			visual_video_free_buffer (bin->rendervideo);
+
+		visual_video_clone (bin->rendervideo, video);
+		visual_video_allocate_buffer (bin->rendervideo);
+
+		bin->actvideo = bin->rendervideo;
+
+		valid = TRUE;
+	} else
+		bin->actvideo = video;
+
+	bin_frames_reset (bin, valid);
+
+	bin_resume (bin);
 
 	return 0;
 }
@@ -407,8 +554,19 @@ int visual_bin_set_preferred_depth (VisBin *bin, VisBinDepth depthpreferred)
 
 int visual_bin_set_depth (VisBin *bin, int depth)
 {
+	int ret;
+
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+	ret = bin_set_depth (bin, depth);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_set_depth (VisBin *bin, int depth)
+{
 	bin->depthold = bin->depth;
 
 	if (visual_video_depth_is_supported (bin->depthflag, depth) != TRUE)
@@ -427,6 +585,11 @@ int visual_bin_set_depth (VisBin *bin, int depth)
 
 	visual_video_set_depth (bin->actvideo, depth);
 
+	/* Keep the client video in step like the serial mode does. Only when the
+	 * client holds the pause, never from under the render thread */
+	if (bin->pausecount > 0 && bin->outvideo != NULL && bin->outvideo != bin->actvideo)
+		visual_video_set_depth (bin->outvideo, depth);
+
 	return 0;
 }
 
@@ -460,15 +623,26 @@ VisPalette *visual_bin_get_palette (VisBin *bin)
 }
 
 int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
+{
+	int ret;
+
+	visual_return_val_if_fail (bin != NULL, -1);
+	visual_return_val_if_fail (actname != NULL, -1);
+
+	bin_pause (bin);
+	ret = bin_switch_actor_by_name (bin, actname);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_switch_actor_by_name (VisBin *bin, char *actname)
 {
 	VisActor *actor;
 	VisVideo *video;
 	int depthflag;
 	int depth;
 
-	visual_return_val_if_fail (bin != NULL, -1);
-	visual_return_val_if_fail (actname != NULL, -1);
-
 	visual_log (VISUAL_LOG_DEBUG, "switching to a new actor: %s, old actor: %s", actname, bin->actor->plugin->info->name);
 
 	/* Destroy if there already is a managed one */
@@ -498,7 +672,7 @@ int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
 
 		visual_video_set_depth (video, VISUAL_VIDEO_DEPTH_GL);
 
-		visual_bin_set_depth (bin, VISUAL_VIDEO_DEPTH_GL);
+		bin_set_depth (bin, VISUAL_VIDEO_DEPTH_GL);
 		bin->depthchanged = TRUE;
 
 	} else {
@@ -537,7 +711,7 @@ int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
 			bin->depthforced = depth;
 			bin->depthforcedmain = bin->depth;
 
-			visual_bin_set_depth (bin, bin->actvideo->depth);
+			bin_set_depth (bin, bin->actvideo->depth);
 
 			visual_video_set_depth (video, bin->actvideo->depth);
 
@@ -554,7 +728,7 @@ int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
 
 			visual_log (VISUAL_LOG_DEBUG, "depthforcedmain in switch by name: %d", bin->depthforcedmain);
 			visual_log (VISUAL_LOG_DEBUG, "visual_bin_set_depth %d", video->depth);
-			visual_bin_set_depth (bin, video->depth);
+			bin_set_depth (bin, video->depth);
 
 		} else {
 			/* Don't force ourself into a GL depth, seen we do a direct
@@ -584,7 +758,7 @@ int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
 	bin->actmorphmanaged = TRUE;
 
 	visual_log (VISUAL_LOG_INFO, _("switching... ******************************************"));
-	visual_bin_switch_actor (bin, actor);
+	bin_switch_actor (bin, actor);
 
 	visual_log (VISUAL_LOG_INFO, _("end switch actor by name function ******************"));
 	return 0;
@@ -592,11 +766,22 @@ int visual_bin_switch_actor_by_name (VisBin *bin, char *actname)
 
 int visual_bin_switch_actor (VisBin *bin, VisActor *actor)
 {
-	VisVideo *privvid;
+	int ret;
 
 	visual_return_val_if_fail (bin != NULL, -1);
 	visual_return_val_if_fail (actor != NULL, -1);
 
+	bin_pause (bin);
+	ret = bin_switch_actor (bin, actor);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_switch_actor (VisBin *bin, VisActor *actor)
+{
+	VisVideo *privvid;
+
 	/* Set the new actor */
 	bin->actmorph = actor;
 
@@ -680,10 +865,21 @@ int visual_bin_switch_actor (VisBin *bin, VisActor *actor)
 
 int visual_bin_switch_finalize (VisBin *bin)
 {
-	int depthflag;
+	int ret;
 
 	visual_return_val_if_fail (bin != NULL, -1);
 
+	bin_pause (bin);
+	ret = bin_switch_finalize (bin);
+	bin_resume (bin);
+
+	return ret;
+}
+
+static int bin_switch_finalize (VisBin *bin)
+{
+	int depthflag;
+
 	visual_log (VISUAL_LOG_DEBUG, "Entering...");
 	if (bin->managed == TRUE)
 		visual_object_unref (VISUAL_OBJECT (bin->actor));
@@ -723,7 +919,7 @@ int visual_bin_switch_finalize (VisBin *bin)
 
 	depthflag = visual_actor_get_supported_depth (bin->actor);
 	fix_depth_with_bin (bin, bin->actvideo, bin_get_depth_using_preferred (bin, depthflag));
-	visual_bin_set_depth (bin, bin->actvideo->depth);
+	bin_set_depth (bin, bin->actvideo->depth);
 
 	bin->depthforcedmain = bin->actvideo->depth;
 	visual_log (VISUAL_LOG_DEBUG, "bin->depthforcedmain in finalize %d", bin->depthforcedmain);
@@ -786,6 +982,15 @@ int visual_bin_switch_set_mode (VisBin *bin, VisMorphMode mode)
 	return 0;
 }
 
+int visual_bin_switch_set_parallel (VisBin *bin, int parallel)
+{
+	visual_return_val_if_fail (bin != NULL, -1);
+
+	bin->morphparallel = parallel;
+
+	return 0;
+}
+
 int visual_bin_switch_set_time (VisBin *bin, long sec, long usec)
 {
 	visual_return_val_if_fail (bin != NULL, -1);
@@ -797,11 +1002,93 @@ int visual_bin_switch_set_time (VisBin *bin, long sec, long usec)
 
 int visual_bin_run (VisBin *bin)
 {
+	int ret;
+	_LV_TIMING_DECLARE (frame);
+	_LV_TIMING_DECLARE (begin);
+
 	visual_return_val_if_fail (bin != NULL, -1);
 	visual_return_val_if_fail (bin->actor != NULL, -1);
 	visual_return_val_if_fail (bin->input != NULL, -1);
 
-	visual_input_run (bin->input);
+	_LV_TIMING_BEGIN (bin->timing, frame);
+
+	if (bin->threaded == TRUE) {
+		ret = bin_run_threaded (bin);
+	} else {
+		_LV_TIMING_NEXT_FRAME (bin->timing);
+
+		_LV_TIMING_BEGIN (bin->timing, begin);
+		visual_input_run (bin->input);
+		_LV_TIMING_END (bin->timing, begin, VISUAL_TIMING_STAGE_INPUT, VISUAL_TIMING_TRACK_INPUT);
+
+		ret = bin_render (bin);
+	}
+
+	_LV_TIMING_END (bin->timing, frame, VISUAL_TIMING_STAGE_FRAME, VISUAL_TIMING_TRACK_BIN);
+
+	return ret;
+}
+
+/* Hands the VisTiming of the bin to whatever runs this frame, the actors
+ * change places on every switch */
+static void bin_timing_attach (VisBin *bin)
+{
+#ifdef VISUAL_HAVE_TIMING
+	visual_actor_set_timing (bin->actor, bin->timing, VISUAL_TIMING_TRACK_ACTOR);
+
+	if (bin->actmorph != NULL)
+		visual_actor_set_timing (bin->actmorph, bin->timing, VISUAL_TIMING_TRACK_ACTMORPH);
+
+	if (bin->morph != NULL)
+		visual_morph_set_timing (bin->morph, bin->timing);
+#endif
+}
+
+/* Whether bin_render() will morph this frame, with both actors on the thread pool */
+static int bin_morph_can_parallel (VisBin *bin)
+{
+	VisPluginData *actplugin;
+	VisPluginData *morphplugin;
+
+	if (bin->morphparallel == FALSE || bin->morphing == FALSE ||
+			bin->morphstyle != VISUAL_SWITCH_STYLE_MORPH)
+		return FALSE;
+
+	if (bin->actmorph == NULL || bin->actmorph->video == NULL || bin->actor->video == NULL)
+		return FALSE;
+
+	if (bin->actmorph->video->depth == VISUAL_VIDEO_DEPTH_GL ||
+			bin->actor->video->depth == VISUAL_VIDEO_DEPTH_GL)
+		return FALSE;
+
+	if (visual_thread_is_initialized () == FALSE || visual_thread_is_supported () == FALSE ||
+			visual_thread_is_enabled () == FALSE)
+		return FALSE;
+
+	actplugin = visual_actor_get_plugin (bin->actor);
+	morphplugin = visual_actor_get_plugin (bin->actmorph);
+
+	/* Two instances of one plugin share its globals */
+	if (actplugin == NULL || morphplugin == NULL ||
+			strcmp (actplugin->info->plugname, morphplugin->info->plugname) == 0)
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Item 0 is the main actor, item 1 the actmorph */
+static void bin_actors_run (void *data, int index)
+{
+	VisBin *bin = data;
+
+	visual_actor_run (index == 0 ? bin->actor : bin->actmorph, bin->input->audio);
+}
+
+static int bin_render (VisBin *bin)
+{
+	int actmorphdone = FALSE;
+
+	bin_timing_attach (bin);
 
 	/* If we have a direct switch, do this BEFORE we run the actor,
 	 * else we can get into trouble especially with GL, also when
@@ -843,7 +1130,7 @@ int visual_bin_run (VisBin *bin)
 		if (bin->morphstyle == VISUAL_SWITCH_STYLE_DIRECT ||
 			bin->actor->video->depth == VISUAL_VIDEO_DEPTH_GL) {
 
-			visual_bin_switch_finalize (bin);
+			bin_switch_finalize (bin);
 
 			/* We can't start drawing yet, the client needs to catch up with
 			 * the depth change */
@@ -855,7 +1142,14 @@ int visual_bin_run (VisBin *bin)
 	 * requested after the connect, thus we can realize there yet */
 	visual_actor_realize (bin->actor);
 
-	visual_actor_run (bin->actor, bin->input->audio);
+	/* Both actors draw into their own video, so they can render at the
+	 * same time */
+	if (bin_morph_can_parallel (bin) == TRUE) {
+		_lv_thread_pool_run (2, bin_actors_run, bin);
+
+		actmorphdone = TRUE;
+	} else
+		visual_actor_run (bin->actor, bin->input->audio);
 
 	if (bin->morphing == TRUE) {
 		visual_return_val_if_fail (bin->actmorph != NULL, -1);
@@ -866,10 +1160,11 @@ int visual_bin_run (VisBin *bin)
 			bin->actmorph->video->depth != VISUAL_VIDEO_DEPTH_GL &&
 			bin->actor->video->depth != VISUAL_VIDEO_DEPTH_GL) {
 
-			visual_actor_run (bin->actmorph, bin->input->audio);
+			if (actmorphdone == FALSE)
+				visual_actor_run (bin->actmorph, bin->input->audio);
 
 			if (bin->morph == NULL || bin->morph->plugin == NULL) {
-				visual_bin_switch_finalize (bin);
+				bin_switch_finalize (bin);
 
 				return 0;
 			}
@@ -880,11 +1175,415 @@ int visual_bin_run (VisBin *bin)
 			visual_morph_run (bin->morph, bin->input->audio, bin->actor->video, bin->actmorph->video);
 
 			if (visual_morph_is_done (bin->morph) == TRUE)
-				visual_bin_switch_finalize (bin);
+				bin_switch_finalize (bin);
 		} else {
-/*			visual_bin_switch_finalize (bin); */
+/*			bin_switch_finalize (bin); */
+		}
+	}
+
+	return 0;
+}
+
+int visual_bin_set_threaded (VisBin *bin, int threaded)
+{
+	visual_return_val_if_fail (bin != NULL, -1);
+
+	threaded = threaded != FALSE ? TRUE : FALSE;
+
+	if (bin->threaded == threaded)
+		return VISUAL_OK;
+
+	if (threaded == FALSE) {
+		/* The render thread needs the render mutex to finish its frame, so a
+		 * client inside visual_bin_lock lets go of it while the threads stop */
+		if (bin->pausecount > 0)
+			visual_mutex_unlock (bin->rendermutex);
+
+		bin_threads_stop (bin);
+
+		if (bin->pausecount > 0)
+			visual_mutex_lock (bin->rendermutex);
+
+		bin->threaded = FALSE;
+
+		/* Hand the client video back, a visual_bin_sync is needed after this */
+		if (bin->outvideo != NULL)
+			bin->actvideo = bin->outvideo;
+
+		bin->outvideo = NULL;
+
+		return VISUAL_OK;
+	}
+
+	if (visual_thread_is_supported () == FALSE || visual_thread_is_enabled () == FALSE)
+		return -VISUAL_ERROR_THREAD_NOT_SUPPORTED;
+
+	if (bin->rendermutex == NULL) {
+		bin->inputmutex = visual_mutex_new ();
+		bin->rendermutex = visual_mutex_new ();
+		bin->framemutex = visual_mutex_new ();
+		bin->framecond = visual_cond_new ();
+
+		bin->rendervideo = visual_video_new ();
+	}
+
+	bin->threaded = TRUE;
+
+	/* Move over to the private video, a visual_bin_sync is needed after this */
+	if (bin->actvideo != NULL)
+		visual_bin_set_video (bin, bin->actvideo);
+
+	return VISUAL_OK;
+}
+
+int visual_bin_get_threaded (VisBin *bin)
+{
+	visual_return_val_if_fail (bin != NULL, FALSE);
+
+	return bin->threaded;
+}
+
+int visual_bin_set_timing (VisBin *bin, VisTiming *timing)
+{
+	visual_return_val_if_fail (bin != NULL, -1);
+
+#ifdef VISUAL_HAVE_TIMING
+	if (bin->timing == timing)
+		return VISUAL_OK;
+
+	/* The render thread uses it under the render mutex, the input thread under
+	 * the input mutex */
+	bin_pause (bin);
+
+	if (bin->inputmutex != NULL)
+		visual_mutex_lock (bin->inputmutex);
+
+	if (timing != NULL)
+		visual_object_ref (VISUAL_OBJECT (timing));
+
+	if (bin->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (bin->timing));
+
+	bin->timing = timing;
+
+	if (bin->inputmutex != NULL)
+		visual_mutex_unlock (bin->inputmutex);
+
+	bin_resume (bin);
+
+	return VISUAL_OK;
+#else
+	return -VISUAL_ERROR_TIMING_NOT_SUPPORTED;
+#endif
+}
+
+VisTiming *visual_bin_get_timing (VisBin *bin)
+{
+	visual_return_val_if_fail (bin != NULL, NULL);
+
+	return bin->timing;
+}
+
+int visual_bin_lock (VisBin *bin)
+{
+	visual_return_val_if_fail (bin != NULL, -1);
+
+	bin_pause (bin);
+
+	return VISUAL_OK;
+}
+
+int visual_bin_unlock (VisBin *bin)
+{
+	visual_return_val_if_fail (bin != NULL, -1);
+	visual_return_val_if_fail (bin->pausecount > 0 || bin->rendermutex == NULL, -1);
+
+	bin_resume (bin);
+
+	return VISUAL_OK;
+}
+
+/* The threaded pipeline: an input thread uploads into the samplepool, whose rings
+ * take one writer and one reader without locking. A render thread analyzes the
+ * audio, runs the actors and the morph into the private rendervideo and queues a
+ * copy of every frame, running at most VISUAL_BIN_FRAME_QUEUE_SIZE frames ahead.
+ * visual_bin_run only takes the oldest frame off the queue.
+ *
+ * Everything that touches the actors from the client thread holds the render
+ * mutex through bin_pause, which nests so the public functions can call each other. */
+static void bin_pause (VisBin *bin)
+{
+	if (bin->rendermutex == NULL)
+		return;
+
+	if (bin->pausecount++ == 0)
+		visual_mutex_lock (bin->rendermutex);
+}
+
+static void bin_resume (VisBin *bin)
+{
+	if (bin->rendermutex == NULL)
+		return;
+
+	if (--bin->pausecount == 0)
+		visual_mutex_unlock (bin->rendermutex);
+}
+
+static int bin_threads_start (VisBin *bin)
+{
+	_lv_atomic_store (&bin->threadrunning, TRUE);
+
+	bin->inputthread = visual_thread_create (bin_input_thread, bin, TRUE);
+	bin->renderthread = visual_thread_create (bin_render_thread, bin, TRUE);
+
+	if (bin->inputthread == NULL || bin->renderthread == NULL) {
+		visual_log (VISUAL_LOG_WARNING, _("Could not start the render threads, running serially"));
+
+		bin_threads_stop (bin);
+
+		return -VISUAL_ERROR_THREAD_NULL;
+	}
+
+	return VISUAL_OK;
+}
+
+static void bin_threads_stop (VisBin *bin)
+{
+	if (bin->framemutex == NULL)
+		return;
+
+	visual_mutex_lock (bin->framemutex);
+	_lv_atomic_store (&bin->threadrunning, FALSE);
+	visual_cond_broadcast (bin->framecond);
+	visual_mutex_unlock (bin->framemutex);
+
+	if (bin->inputthread != NULL) {
+		visual_thread_join (bin->inputthread);
+		visual_thread_free (bin->inputthread);
+
+		bin->inputthread = NULL;
+	}
+
+	if (bin->renderthread != NULL) {
+		visual_thread_join (bin->renderthread);
+		visual_thread_free (bin->renderthread);
+
+		bin->renderthread = NULL;
+	}
+}
+
+static void *bin_input_thread (void *data)
+{
+	VisBin *bin = VISUAL_BIN (data);
+	VisTimer timer;
+	int elapsed;
+	_LV_TIMING_DECLARE (begin);
+
+	visual_timer_init (&timer);
+
+	while (_lv_atomic_load (&bin->threadrunning) == TRUE) {
+		visual_timer_start (&timer);
+
+		visual_mutex_lock (bin->inputmutex);
+
+		if (bin->input != NULL) {
+			_LV_TIMING_BEGIN (bin->timing, begin);
+			visual_input_upload (bin->input);
+			_LV_TIMING_END (bin->timing, begin, VISUAL_TIMING_STAGE_INPUT, VISUAL_TIMING_TRACK_INPUT);
 		}
+
+		visual_mutex_unlock (bin->inputmutex);
+
+		elapsed = visual_timer_elapsed_usecs (&timer);
+
+		if (elapsed >= 0 && elapsed < BIN_INPUT_INTERVAL_USEC)
+			visual_time_usleep (BIN_INPUT_INTERVAL_USEC - elapsed);
+	}
+
+	return NULL;
+}
+
+static void *bin_render_thread (void *data)
+{
+	VisBin *bin = VISUAL_BIN (data);
+
+	visual_mutex_lock (bin->framemutex);
+
+	while (bin->threadrunning == TRUE) {
+		if (bin->rendervalid == FALSE || bin->framecount == VISUAL_BIN_FRAME_QUEUE_SIZE) {
+			visual_cond_wait (bin->framecond, bin->framemutex);
+
+			continue;
+		}
+
+		visual_mutex_unlock (bin->framemutex);
+
+		visual_mutex_lock (bin->rendermutex);
+
+		/* Stopped while it waited for a client that held the bin locked */
+		if (_lv_atomic_load (&bin->threadrunning) == TRUE)
+			bin_render_frame (bin);
+
+		visual_mutex_unlock (bin->rendermutex);
+
+		visual_mutex_lock (bin->framemutex);
 	}
 
+	visual_mutex_unlock (bin->framemutex);
+
+	return NULL;
+}
+
+/* Called with the render mutex held */
+static void bin_render_frame (VisBin *bin)
+{
+	VisVideo *frame;
+	int slot;
+
+	/* The depth changed, either through the client or a finished switch. Wait for
+	 * the client to catch up with a new video */
+	if (bin->actor == NULL || bin->input == NULL || bin->actvideo != bin->rendervideo ||
+			visual_video_compare (bin->rendervideo, bin->outvideo) != TRUE) {
+		bin_frames_reset (bin, FALSE);
+
+		return;
+	}
+
+	_LV_TIMING_NEXT_FRAME (bin->timing);
+
+	visual_audio_analyze (bin->input->audio);
+
+	bin_render (bin);
+
+	if (visual_video_compare (bin->rendervideo, bin->outvideo) != TRUE) {
+		bin_frames_reset (bin, FALSE);
+
+		return;
+	}
+
+	/* The tail slot is ours until the frame is counted in */
+	visual_mutex_lock (bin->framemutex);
+	slot = (bin->framehead + bin->framecount) % VISUAL_BIN_FRAME_QUEUE_SIZE;
+	visual_mutex_unlock (bin->framemutex);
+
+	if (bin->frames[slot] == NULL)
+		bin->frames[slot] = visual_video_new ();
+
+	frame = bin->frames[slot];
+
+	if (visual_video_compare (frame, bin->rendervideo) != TRUE) {
+		if (visual_video_get_pixels (frame) != NULL)
+			visual_video_free_buffer (frame);
+
+		visual_video_clone (frame, bin->rendervideo);
+		visual_video_allocate_buffer (frame);
+	}
+
+	visual_mem_copy (visual_video_get_pixels (frame), visual_video_get_pixels (bin->rendervideo),
+			visual_video_get_size (frame));
+
+	visual_video_set_palette (frame, NULL);
+
+	if (bin->rendervideo->depth == VISUAL_VIDEO_DEPTH_8BIT && bin->rendervideo->pal != NULL &&
+			bin->rendervideo->pal->ncolors > 0) {
+		VisPalette *pal = bin->framepals[slot];
+
+		if (pal == NULL || pal->ncolors != bin->rendervideo->pal->ncolors) {
+			if (pal != NULL)
+				visual_object_unref (VISUAL_OBJECT (pal));
+
+			pal = visual_palette_new (bin->rendervideo->pal->ncolors);
+			bin->framepals[slot] = pal;
+		}
+
+		visual_palette_copy (pal, bin->rendervideo->pal);
+
+		visual_video_set_palette (frame, pal);
+	}
+
+	visual_mutex_lock (bin->framemutex);
+	bin->framecount++;
+	visual_cond_broadcast (bin->framecond);
+	visual_mutex_unlock (bin->framemutex);
+}
+
+static void bin_frames_reset (VisBin *bin, int valid)
+{
+	visual_mutex_lock (bin->framemutex);
+
+	bin->framehead = 0;
+	bin->framecount = 0;
+	bin->rendervalid = valid;
+
+	visual_cond_broadcast (bin->framecond);
+	visual_mutex_unlock (bin->framemutex);
+}
+
+static int bin_run_threaded (VisBin *bin)
+{
+	VisVideo *frame;
+	VisVideo *video = bin->outvideo;
+	int ret;
+
+	if (bin->renderthread == NULL && bin_threads_start (bin) != VISUAL_OK) {
+		visual_bin_set_threaded (bin, FALSE);
+		visual_bin_sync (bin, TRUE);
+
+		return visual_bin_run (bin);
+	}
+
+	/* No private video, this is GL. Render on the client thread, the input
+	 * thread keeps uploading */
+	if (bin->actvideo != bin->rendervideo) {
+		bin_pause (bin);
+
+		_LV_TIMING_NEXT_FRAME (bin->timing);
+
+		visual_audio_analyze (bin->input->audio);
+		ret = bin_render (bin);
+
+		bin_resume (bin);
+
+		return ret;
+	}
+
+	visual_mutex_lock (bin->framemutex);
+
+	while (bin->framecount == 0 && bin->rendervalid == TRUE && bin->pausecount == 0)
+		visual_cond_wait (bin->framecond, bin->framemutex);
+
+	if (bin->framecount == 0) {
+		visual_mutex_unlock (bin->framemutex);
+
+		return 0;
+	}
+
+	/* The copy is made under the queue lock, so the render thread can neither
+	 * reset the queue nor refill this slot while it is read */
+	frame = bin->frames[bin->framehead];
+
+	if (video != NULL && visual_video_get_pixels (video) != NULL && visual_video_compare (frame, video) == TRUE) {
+		visual_mem_copy (visual_video_get_pixels (video), visual_video_get_pixels (frame),
+				visual_video_get_size (video));
+
+		if (frame->pal != NULL) {
+			if (bin->outpal == NULL || bin->outpal->ncolors != frame->pal->ncolors) {
+				if (bin->outpal != NULL)
+					visual_object_unref (VISUAL_OBJECT (bin->outpal));
+
+				bin->outpal = visual_palette_new (frame->pal->ncolors);
+			}
+
+			visual_palette_copy (bin->outpal, frame->pal);
+			visual_video_set_palette (video, bin->outpal);
+		}
+	}
+
+	bin->framehead = (bin->framehead + 1) % VISUAL_BIN_FRAME_QUEUE_SIZE;
+	bin->framecount--;
+
+	visual_cond_broadcast (bin->framecond);
+	visual_mutex_unlock (bin->framemutex);
+
 	return 0;
 }
@@ -29,6 +29,8 @@
 #include <libvisual/lv_morph.h>
 #include <libvisual/lv_video.h>
 #include <libvisual/lv_time.h>
+#include <libvisual/lv_thread.h>
+#include <libvisual/lv_timing.h>
 
 /**
  * @defgroup VisBin VisBin
@@ -39,6 +41,9 @@ VISUAL_BEGIN_DECLS
 
 #define VISUAL_BIN(obj)					(VISUAL_CHECK_CAST ((obj), VisBin))
 
+/* Number of finished frames the render thread can run ahead in threaded mode */
+#define VISUAL_BIN_FRAME_QUEUE_SIZE			2
+
 typedef enum {
 	VISUAL_SWITCH_STYLE_DIRECT,
 	VISUAL_SWITCH_STYLE_MORPH
@@ -76,6 +81,7 @@ struct _VisBin {
 	float		 morphrate;
 	VisMorphMode	 morphmode;
 	VisTime		 morphtime;
+	int		 morphparallel;		/* Render both actors on the thread pool while morphing */
 
 	int		 depthpreferred;	/* Prefered depth, highest or lowest */
 	int		 depthflag;		/* Supported depths */
@@ -85,6 +91,26 @@ struct _VisBin {
 	int		 depthfromGL;		/* Set when switching away from openGL */
 	int		 depthforced;		/* Contains forced depth value, for the actmorph so we've got smooth transformations */
 	int		 depthforcedmain;	/* Contains forced depth value, for the main actor */
+
+	int		 threaded;		/* Set when the threaded render pipeline is enabled */
+	VisVideo	*outvideo;		/* Video given by the client when threaded, actvideo is private then */
+	VisVideo	*rendervideo;		/* Private video the render thread draws into */
+	int		 rendervalid;		/* Set while the private video matches the client video */
+	int		 pausecount;		/* Nesting of visual_bin_lock() */
+	volatile unsigned int threadrunning;
+	VisThread	*inputthread;
+	VisThread	*renderthread;
+	VisMutex	*inputmutex;		/* Held by the input thread while uploading */
+	VisMutex	*rendermutex;		/* Held by the render thread while rendering, or by the client */
+	VisMutex	*framemutex;		/* Protects the frame queue */
+	VisCond		*framecond;		/* Signalled when the frame queue or rendervalid changes */
+	VisVideo	*frames[VISUAL_BIN_FRAME_QUEUE_SIZE];
+	VisPalette	*framepals[VISUAL_BIN_FRAME_QUEUE_SIZE];
+	VisPalette	*outpal;		/* Palette of the frame on display, for 8 bits */
+	int		 framehead;
+	int		 framecount;
+
+	VisTiming	*timing;		/* Records the stages of every frame, NULL when not timed */
 };
 
 /* prototypes */
@@ -126,9 +152,18 @@ int visual_bin_switch_set_automatic (VisBin *bin, int automatic);
 int visual_bin_switch_set_rate (VisBin *bin, float rate);
 int visual_bin_switch_set_mode (VisBin *bin, VisMorphMode mode);
 int visual_bin_switch_set_time (VisBin *bin, long sec, long usec);
+int visual_bin_switch_set_parallel (VisBin *bin, int parallel);
 
 int visual_bin_run (VisBin *bin);
 
+int visual_bin_set_threaded (VisBin *bin, int threaded);
+int visual_bin_get_threaded (VisBin *bin);
+int visual_bin_lock (VisBin *bin);
+int visual_bin_unlock (VisBin *bin);
+
+int visual_bin_set_timing (VisBin *bin, VisTiming *timing);
+VisTiming *visual_bin_get_timing (VisBin *bin);
+
 VISUAL_END_DECLS
 
 /**
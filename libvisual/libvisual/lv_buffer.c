@@ -218,7 +218,8 @@ int visual_buffer_clone (VisBuffer *dest, VisBuffer *src)
 				visual_buffer_get_size (src));
 	}
 
-	visual_buffer_set_destroyer (dest, visual_buffer_get_destroyer (src));
+	/* The copy is our own allocation, whatever src came from, a pool for example */
+	visual_buffer_set_destroyer (dest, visual_buffer_destroyer_free);
 
 	return VISUAL_OK;
 }
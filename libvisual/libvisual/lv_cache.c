@@ -27,65 +27,113 @@
 #include "lv_util.h"
 
 static int cache_dtor (VisObject *object);
-static int cache_remove_list_entry (VisCache *cache, VisListEntry **le);
 
-static inline void handle_request_reset (VisCache *cache, VisListEntry *le);
+static void cache_unlink (VisCache *cache, VisCacheEntry *centry);
+static void cache_link_head (VisCache *cache, VisCacheEntry *centry);
+static void cache_remove_entry (VisCache *cache, VisCacheEntry *centry);
+static void cache_evict (VisCache *cache, VisCacheEntry *keep);
+
+static inline void handle_request_reset (VisCache *cache, VisCacheEntry *centry);
 
 static int cache_dtor (VisObject *object)
 {
 	VisCache *cache = VISUAL_CACHE (object);
-	VisListEntry *le = NULL;
 
 	/* Destroy all entries in cache first */
-	while (visual_list_next (cache->list, &le) != NULL)
-		cache_remove_list_entry (cache, &le);
+	while (cache->head != NULL)
+		cache_remove_entry (cache, cache->head);
 
 	/* Destroy the rest */
-	if (cache->list != NULL)
-		visual_object_unref (VISUAL_OBJECT (cache->list));
-
 	if (cache->index != NULL)
 		visual_object_unref (VISUAL_OBJECT (cache->index));
 
-	cache->list = NULL;
 	cache->index = NULL;
 
 	return VISUAL_OK;
 }
 
-static int cache_remove_list_entry (VisCache *cache, VisListEntry **le)
+static void cache_unlink (VisCache *cache, VisCacheEntry *centry)
 {
-	VisCacheEntry *centry;
+	if (centry->prev != NULL)
+		centry->prev->next = centry->next;
+	else
+		cache->head = centry->next;
+
+	if (centry->next != NULL)
+		centry->next->prev = centry->prev;
+	else
+		cache->tail = centry->prev;
+
+	centry->prev = NULL;
+	centry->next = NULL;
+}
+
+static void cache_link_head (VisCache *cache, VisCacheEntry *centry)
+{
+	centry->prev = NULL;
+	centry->next = cache->head;
+
+	if (cache->head != NULL)
+		cache->head->prev = centry;
+	else
+		cache->tail = centry;
+
+	cache->head = centry;
+}
+
+static void cache_remove_entry (VisCache *cache, VisCacheEntry *centry)
+{
+	cache_unlink (cache, centry);
 
-	centry = (*le)->data;
+	visual_hashmap_remove_string (cache->index, centry->key, FALSE);
 
-	if (centry->key != NULL)
-		visual_hashmap_remove_string (cache->index, centry->key, FALSE);
+	cache->stats.entries--;
+	cache->stats.bytes -= centry->cost;
 
 	if (cache->destroyer != NULL)
 		cache->destroyer (centry->data);
 
-	visual_list_destroy (cache->list, le);
+	visual_mem_free (centry->key);
+	visual_mem_free (centry);
+}
 
-	return VISUAL_OK;
+/* Drops the least recently used entries until the cache is within its limits,
+ * keep is never dropped */
+static void cache_evict (VisCache *cache, VisCacheEntry *keep)
+{
+	VisCacheEntry *centry = cache->tail;
+
+	while (centry != NULL) {
+		VisCacheEntry *prev = centry->prev;
+
+		if (cache->stats.entries <= cache->size &&
+				(cache->maxbytes == 0 || cache->stats.bytes <= cache->maxbytes))
+			break;
+
+		/* Step over it, the ones in front of it can still go */
+		if (centry != keep) {
+			cache_remove_entry (cache, centry);
+
+			cache->stats.evictions++;
+		}
+
+		centry = prev;
+	}
 }
 
 
-static inline void handle_request_reset (VisCache *cache, VisListEntry *le)
+static inline void handle_request_reset (VisCache *cache, VisCacheEntry *centry)
 {
-	VisCacheEntry *centry;
-
 	if (cache->reqreset == FALSE)
 		return;
 
-	centry = le->data;
 	visual_timer_start (&centry->timer);
 
-	/* Unchain from the list */
-	visual_list_unchain (cache->list, le);
-
-	/* Rechain at the head */
-	visual_list_chain_at_begin (cache->list, le);
+	/* Move to the head */
+	if (cache->head != centry) {
+		cache_unlink (cache, centry);
+		cache_link_head (cache, centry);
+	}
 }
 
 VisCache *visual_cache_new (VisCollectionDestroyerFunc destroyer, int size, VisTime *maxage, int reqreset)
@@ -113,62 +161,47 @@ int visual_cache_init (VisCache *cache, VisCollectionDestroyerFunc destroyer, in
 	visual_object_set_allocated (VISUAL_OBJECT (cache), FALSE);
 
 	/* Set the VisCache data */
+	cache->head = NULL;
+	cache->tail = NULL;
+	cache->index = NULL;
+	cache->costfunc = NULL;
+	cache->maxbytes = 0;
+
+	visual_mem_set (&cache->stats, 0, sizeof (VisCacheStats));
+
 	visual_cache_set_limits (cache, size, maxage);
 	cache->destroyer = destroyer;
 	cache->reqreset = reqreset;
 
-	cache->list = visual_list_new (NULL);
-
-	cache->index = visual_hashmap_new (NULL); /* FIXME create in set_limits, rehash if not NULL */
-	visual_hashmap_set_table_size (cache->index, size); /* <- also */
+	cache->index = visual_hashmap_new (NULL);
+	visual_hashmap_reserve (cache->index, size);
 
 	return VISUAL_OK;
 }
 
 int visual_cache_clear (VisCache *cache)
 {
-	VisListEntry *le = NULL;
-
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 
-	/* Destroy all entries in cache first */
-	while (visual_list_next (cache->list, &le) != NULL)
-		cache_remove_list_entry (cache, &le);
-
-	if (cache->index != NULL)
-		visual_object_unref (VISUAL_OBJECT (cache->index));
-
-	cache->index = visual_hashmap_new (NULL);
-	visual_hashmap_set_table_size (cache->index, cache->size);
+	/* Destroy all entries in cache */
+	while (cache->head != NULL)
+		cache_remove_entry (cache, cache->head);
 
 	return VISUAL_OK;
 }
 
 int visual_cache_flush_outdated (VisCache *cache)
 {
-	VisCacheEntry *centry;
-	VisListEntry *le;
-
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 
-	if (cache->withmaxage == TRUE) {
-		le = cache->list->tail;
-
-		if (le == NULL)
-			return VISUAL_OK;
-
-		centry = le->data;
-
-		while (visual_timer_elapsed (&centry->timer, &cache->maxage)) {
-			cache_remove_list_entry (cache, &le);
-
-			le = cache->list->tail;
+	if (cache->withmaxage == FALSE)
+		return VISUAL_OK;
 
-			if (le == NULL)
-				return VISUAL_OK;
+	/* The tail holds the entry that was used longest ago */
+	while (cache->tail != NULL && visual_timer_elapsed (&cache->tail->timer, &cache->maxage)) {
+		cache_remove_entry (cache, cache->tail);
 
-			centry = le->data;
-		}
+		cache->stats.evictions++;
 	}
 
 	return VISUAL_OK;
@@ -177,7 +210,6 @@ int visual_cache_flush_outdated (VisCache *cache)
 int visual_cache_put (VisCache *cache, char *key, void *data)
 {
 	VisCacheEntry *centry;
-	VisListEntry *le;
 
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 	visual_return_val_if_fail (key != NULL, -VISUAL_ERROR_NULL);
@@ -187,28 +219,20 @@ int visual_cache_put (VisCache *cache, char *key, void *data)
 	if (cache->size < 1)
 		return VISUAL_OK;
 
-	/* Remove items that are no longer wished in the cache */
-	while (visual_collection_size (VISUAL_COLLECTION (cache->list)) > cache->size - 1) {
-		le = cache->list->tail;
-
-		if (le == NULL)
-			return VISUAL_OK;
-
-		cache_remove_list_entry (cache, &le);
-	}
-
 	/* Remove items that are out dated */
 	visual_cache_flush_outdated (cache);
 
 	/* Add to cache */
-	le = visual_hashmap_get_string (cache->index, key);
-
-	if (le != NULL) {
-		centry = le->data;
+	centry = visual_hashmap_get_string (cache->index, key);
 
+	if (centry != NULL) {
 		centry->data = data;
 
-		handle_request_reset (cache, le);
+		cache->stats.bytes -= centry->cost;
+		centry->cost = cache->costfunc != NULL ? cache->costfunc (data) : 0;
+		cache->stats.bytes += centry->cost;
+
+		handle_request_reset (cache, centry);
 
 	} else {
 		centry = visual_mem_new0 (VisCacheEntry, 1);
@@ -218,28 +242,33 @@ int visual_cache_put (VisCache *cache, char *key, void *data)
 
 		centry->key = visual_strdup (key);
 		centry->data = data;
+		centry->cost = cache->costfunc != NULL ? cache->costfunc (data) : 0;
 
-		visual_list_add (cache->list, centry);
+		cache_link_head (cache, centry);
 
-		le = cache->list->tail;
+		cache->stats.entries++;
+		cache->stats.bytes += centry->cost;
 
-		visual_hashmap_put_string (cache->index, key, le);
+		visual_hashmap_put_string (cache->index, key, centry);
 	}
 
+	/* Remove items that are no longer wished in the cache */
+	cache_evict (cache, centry);
+
 	return VISUAL_OK;
 }
 
 int visual_cache_remove (VisCache *cache, char *key)
 {
-	VisListEntry *le;
+	VisCacheEntry *centry;
 
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 	visual_return_val_if_fail (key != NULL, -VISUAL_ERROR_NULL);
 
-	le = visual_hashmap_get_string (cache->index, key);
+	centry = visual_hashmap_get_string (cache->index, key);
 
-	if (le != NULL)
-		cache_remove_list_entry (cache, &le);
+	if (centry != NULL)
+		cache_remove_entry (cache, centry);
 
 	return VISUAL_OK;
 }
@@ -247,19 +276,21 @@ int visual_cache_remove (VisCache *cache, char *key)
 void *visual_cache_get (VisCache *cache, char *key)
 {
 	VisCacheEntry *centry;
-	VisListEntry *le;
 
 	visual_return_val_if_fail (cache != NULL, NULL);
 	visual_return_val_if_fail (key != NULL, NULL);
 
-	le = visual_hashmap_get_string (cache->index, key);
+	centry = visual_hashmap_get_string (cache->index, key);
+
+	if (centry == NULL) {
+		cache->stats.misses++;
 
-	if (le == NULL)
 		return NULL;
+	}
 
-	centry = le->data;
+	cache->stats.hits++;
 
-	handle_request_reset (cache, le);
+	handle_request_reset (cache, centry);
 
 	return centry->data;
 }
@@ -268,15 +299,13 @@ int visual_cache_get_size (VisCache *cache)
 {
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 
-	return visual_collection_size (VISUAL_COLLECTION (cache->list));
+	return cache->stats.entries;
 }
 
 int visual_cache_set_limits (VisCache *cache, int size, VisTime *maxage)
 {
 	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
 
-	/* FIXME limit size change, rehash the index */
-
 	cache->size = size;
 
 	if (maxage != NULL) {
@@ -286,12 +315,53 @@ int visual_cache_set_limits (VisCache *cache, int size, VisTime *maxage)
 		cache->withmaxage = FALSE;
 	}
 
+	if (cache->index != NULL) {
+		visual_hashmap_reserve (cache->index, size);
+
+		cache_evict (cache, cache->size > 0 ? cache->head : NULL);
+	}
+
 	return VISUAL_OK;
 }
 
-VisList *visual_cache_get_list (VisCache *cache)
+int visual_cache_set_byte_limit (VisCache *cache, visual_size_t maxbytes)
 {
-	visual_return_val_if_fail (cache != NULL, NULL);
+	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
+
+	cache->maxbytes = maxbytes;
+
+	cache_evict (cache, cache->head);
+
+	return VISUAL_OK;
+}
+
+int visual_cache_set_cost_func (VisCache *cache, VisCacheCostFunc costfunc)
+{
+	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
+
+	cache->costfunc = costfunc;
+
+	return VISUAL_OK;
+}
+
+int visual_cache_get_stats (VisCache *cache, VisCacheStats *stats)
+{
+	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
+	visual_return_val_if_fail (stats != NULL, -VISUAL_ERROR_NULL);
+
+	*stats = cache->stats;
 
-	return cache->list;
+	return VISUAL_OK;
 }
+
+int visual_cache_reset_stats (VisCache *cache)
+{
+	visual_return_val_if_fail (cache != NULL, -VISUAL_ERROR_CACHE_NULL);
+
+	cache->stats.hits = 0;
+	cache->stats.misses = 0;
+	cache->stats.evictions = 0;
+
+	return VISUAL_OK;
+}
+
@@ -27,7 +27,6 @@
 #include <libvisual/lvconfig.h>
 #include <libvisual/lv_defines.h>
 #include <libvisual/lv_time.h>
-#include <libvisual/lv_list.h>
 #include <libvisual/lv_hashmap.h>
 
 /**
@@ -42,36 +41,63 @@ VISUAL_BEGIN_DECLS
 
 typedef struct _VisCache VisCache;
 typedef struct _VisCacheEntry VisCacheEntry;
+typedef struct _VisCacheStats VisCacheStats;
 
 /**
- * Using the VisCache structure
+ * Returns the number of bytes that a cached item costs.
+ */
+typedef visual_size_t (*VisCacheCostFunc)(void *data);
+
+/**
+ * Counters of a VisCache.
+ */
+struct _VisCacheStats {
+	uint64_t	 hits;		/**< Lookups that found their key. */
+	uint64_t	 misses;	/**< Lookups that did not. */
+	uint64_t	 evictions;	/**< Entries dropped to stay within the limits. */
+
+	int		 entries;	/**< Entries in the cache. */
+	visual_size_t	 bytes;		/**< Cost of the entries in the cache. */
+};
+
+/**
+ * Using the VisCache structure you can keep a limited number of items around by
+ * name. When the cache is over its entry or byte limit, the least recently used
+ * entries are dropped first. Entries are found through a VisHashmap and linked in
+ * order of use, so lookups, touches and evictions take constant time.
  */
 struct _VisCache {
 	VisObject			 object;
 
 	VisCollectionDestroyerFunc	 destroyer;
+	VisCacheCostFunc		 costfunc;	/**< Cost of an item, NULL counts nothing. */
 
-	int				 size;
+	int				 size;		/**< Maximal number of entries. */
+	visual_size_t			 maxbytes;	/**< Maximal cost of all entries, 0 for no limit. */
 
 	int				 withmaxage;
 	VisTime				 maxage;
 
-	int				 reqreset;
+	int				 reqreset;	/**< Whether lookups count as a use. */
 
-	/* The reason that we index the cache items two times is because we both need
-	 * fast access to a sorted version and fast access by name, access as a sorted list
-	 * is needed so we can quickly identify old cache items that should be disposed when
-	 * the cache reaches it's limit */
-	VisList				*list;
-	VisHashmap			*index;
+	VisCacheEntry			*head;		/**< Most recently used entry. */
+	VisCacheEntry			*tail;		/**< Least recently used entry. */
+	VisHashmap			*index;		/**< The entries by key. */
+
+	VisCacheStats			 stats;		/**< The counters. */
 };
 
 /**
+ * A VisCache entry, linked in order of use.
  */
 struct _VisCacheEntry {
+	VisCacheEntry	*prev;		/**< More recently used entry. */
+	VisCacheEntry	*next;		/**< Less recently used entry. */
+
 	VisTimer	 timer;
 	char		*key;
 	void		*data;
+	visual_size_t	 cost;		/**< Cost of the data, from the cost function. */
 };
 
 /**
@@ -94,7 +120,46 @@ int visual_cache_get_size (VisCache *cache);
 
 int visual_cache_set_limits (VisCache *cache, int size, VisTime *maxage);
 
-VisList *visual_cache_get_list (VisCache *cache);
+/**
+ * Sets the maximal cost of all entries together. Entries over the limit are
+ * dropped right away, except for the most recently used one.
+ *
+ * @param cache Pointer to the VisCache.
+ * @param maxbytes The maximal number of bytes, 0 for no limit.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_CACHE_NULL on failure.
+ */
+int visual_cache_set_byte_limit (VisCache *cache, visual_size_t maxbytes);
+
+/**
+ * Sets the function that tells what an item costs against the byte limit. It is
+ * called once when an item is put.
+ *
+ * @param cache Pointer to the VisCache.
+ * @param costfunc The cost function, NULL to count every item as 0 bytes.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_CACHE_NULL on failure.
+ */
+int visual_cache_set_cost_func (VisCache *cache, VisCacheCostFunc costfunc);
+
+/**
+ * Gets a snapshot of the counters.
+ *
+ * @param cache Pointer to the VisCache.
+ * @param stats Filled in with the counters.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_CACHE_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_cache_get_stats (VisCache *cache, VisCacheStats *stats);
+
+/**
+ * Clears the hit, miss and eviction counters.
+ *
+ * @param cache Pointer to the VisCache.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_CACHE_NULL on failure.
+ */
+int visual_cache_reset_stats (VisCache *cache);
 
 VISUAL_END_DECLS
 
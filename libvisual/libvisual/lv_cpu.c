@@ -56,6 +56,10 @@
 #include <signal.h>
 #endif
 
+#if !defined(VISUAL_OS_WIN32)
+#include <unistd.h>
+#endif
+
 #if defined(VISUAL_OS_WIN32)
 #include <windows.h>
 #endif
@@ -307,14 +311,25 @@ static int has_cpuid (void)
 
 static int cpuid (unsigned int ax, unsigned int *p)
 {
-#if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
+#if defined(VISUAL_ARCH_X86_64)
+	/* Save all of rbx, the 32 bits moves would clear its upper half */
+	__asm __volatile
+		("movq %%rbx, %%rsi\n\t"
+		 "cpuid\n\t"
+		 "xchgq %%rbx, %%rsi"
+		 : "=a" (p[0]), "=S" (p[1]),
+		 "=c" (p[2]), "=d" (p[3])
+		 : "0" (ax), "2" (0));
+
+	return VISUAL_OK;
+#elif defined(VISUAL_ARCH_X86)
 	__asm __volatile
 		("movl %%ebx, %%esi\n\t"
 		 "cpuid\n\t"
 		 "xchgl %%ebx, %%esi"
 		 : "=a" (p[0]), "=S" (p[1]),
 		 "=c" (p[2]), "=d" (p[3])
-		 : "0" (ax));
+		 : "0" (ax), "2" (0));
 
 	return VISUAL_OK;
 #else
@@ -322,6 +337,21 @@ static int cpuid (unsigned int ax, unsigned int *p)
 #endif
 }
 
+#if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
+/* Whether the OS saves the xmm and ymm registers on context switches */
+static int has_os_avx_support (void)
+{
+	unsigned int eax, edx;
+
+	__asm __volatile
+		("xgetbv"
+		 : "=a" (eax), "=d" (edx)
+		 : "c" (0));
+
+	return (eax & 0x6) == 0x6;
+}
+#endif /* VISUAL_ARCH_X86 || VISUAL_ARCH_X86_64 */
+
 void visual_cpu_initialize ()
 {
 	unsigned int regs[4];
@@ -346,7 +376,7 @@ void visual_cpu_initialize ()
 #elif defined(VISUAL_ARCH_POWERPC)
 	__lv_cpu_caps.type = VISUAL_CPU_TYPE_POWERPC;
 #elif defined(VISUAL_ARCH_ARM)
-	__lv_cpu.caps.type = VISUAL_CPU_TYPE_ARM;
+	__lv_cpu_caps.type = VISUAL_CPU_TYPE_ARM;
 #else
 	__lv_cpu_caps.type = VISUAL_CPU_TYPE_OTHER;
 #endif
@@ -371,6 +401,11 @@ void visual_cpu_initialize ()
 	}
 #endif /* VISUAL_OS_ANDROID && VISUAL_ARCH_ARM */
 
+#if defined(VISUAL_ARCH_ARM) && (defined(__aarch64__) || defined(__ARM_NEON__))
+	/* NEON is mandatory on ARMv8, and on ARMv7 we were built for it */
+	__lv_cpu_caps.hasNeon = 1;
+#endif
+
 	/* Count the number of CPUs in system */
 #if !defined(VISUAL_OS_WIN32) && !defined(VISUAL_OS_UNKNOWN) && defined(_SC_NPROCESSORS_ONLN)
 	__lv_cpu_caps.nrcpu = sysconf (_SC_NPROCESSORS_ONLN);
@@ -419,6 +454,13 @@ void visual_cpu_initialize ()
 		cacheline = ((regs2[1] >> 8) & 0xFF) * 8;
 		if (cacheline > 0)
 			__lv_cpu_caps.cacheline = cacheline;
+
+		/* AVX2 needs OSXSAVE and AVX in ecx, and the OS saving the ymm state */
+		if ((regs2[2] & (1 << 27)) && (regs2[2] & (1 << 28)) && has_os_avx_support () && regs[0] >= 0x00000007) {
+			cpuid (0x00000007, regs2);
+
+			__lv_cpu_caps.hasAVX2 = (regs2[1] & (1 << 5 )) >> 5; /* 0x0000020 */
+		}
 	}
 
 	cpuid (0x80000000, regs);
@@ -444,10 +486,10 @@ void visual_cpu_initialize ()
 
 	if (!__lv_cpu_caps.hasSSE)
 		__lv_cpu_caps.hasSSE2 = 0;
-#else
-	__lv_cpu_caps.hasSSE = 0;
-	__lv_cpu_caps.hasSSE2 = 0;
 #endif
+
+	if (!__lv_cpu_caps.hasSSE2)
+		__lv_cpu_caps.hasAVX2 = 0;
 #endif /* VISUAL_ARCH_X86 || VISUAL_ARCH_X86_64 */
 
 #if defined(VISUAL_ARCH_POWERPC)
@@ -460,6 +502,7 @@ void visual_cpu_initialize ()
 	__lv_cpu_caps.enabledMMX2	= __lv_cpu_caps.hasMMX2;
 	__lv_cpu_caps.enabledSSE	= __lv_cpu_caps.hasSSE;
 	__lv_cpu_caps.enabledSSE2	= __lv_cpu_caps.hasSSE2;
+	__lv_cpu_caps.enabledAVX2	= __lv_cpu_caps.hasAVX2;
 	__lv_cpu_caps.enabled3DNow	= __lv_cpu_caps.has3DNow;
 	__lv_cpu_caps.enabled3DNowExt    = __lv_cpu_caps.has3DNowExt;
 	__lv_cpu_caps.enabledAltiVec     = __lv_cpu_caps.hasAltiVec;
@@ -479,6 +522,7 @@ void visual_cpu_initialize ()
 	visual_log (VISUAL_LOG_DEBUG, "CPU: MMX2 %d", __lv_cpu_caps.hasMMX2);
 	visual_log (VISUAL_LOG_DEBUG, "CPU: SSE %d", __lv_cpu_caps.hasSSE);
 	visual_log (VISUAL_LOG_DEBUG, "CPU: SSE2 %d", __lv_cpu_caps.hasSSE2);
+	visual_log (VISUAL_LOG_DEBUG, "CPU: AVX2 %d", __lv_cpu_caps.hasAVX2);
 	visual_log (VISUAL_LOG_DEBUG, "CPU: 3DNow %d", __lv_cpu_caps.has3DNow);
 	visual_log (VISUAL_LOG_DEBUG, "CPU: 3DNowExt %d", __lv_cpu_caps.has3DNowExt);
 #elif defined(VISUAL_ARCH_POWERPC)
@@ -540,6 +584,14 @@ int visual_cpu_get_sse2 ()
 	return __lv_cpu_caps.enabledSSE2;
 }
 
+int visual_cpu_get_avx2 ()
+{
+	if (__lv_cpu_initialized == FALSE)
+		visual_log (VISUAL_LOG_ERROR, _("The VisCPU system is not initialized."));
+
+	return __lv_cpu_caps.enabledAVX2;
+}
+
 int visual_cpu_get_3dnow ()
 {
 	if (__lv_cpu_initialized == FALSE)
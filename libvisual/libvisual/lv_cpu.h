@@ -88,6 +88,10 @@ struct _VisCPU {
 	int		enabledARMv7;	    /**< The ARM v7 feature is enabled. */
 	int		enabledNeon;        /**< The ARM Neon feature is enabled. */
 	int		enabledLDREX_STREX; /**< The ARM LDREX_STREX feature is enabled. */
+
+	/* Appended to keep the offsets of the fields above */
+	int		hasAVX2;		/**< The CPU has the avx2 feature. */
+	int		enabledAVX2;		/**< The avx2 feature is enabled. */
 };
 
 
@@ -145,6 +149,14 @@ int visual_cpu_get_sse (void);
  */
 int visual_cpu_get_sse2 (void);
 
+/**
+ * Function to retrieve if the AVX2 CPU feature is enabled. This is only
+ * set when the operating system also saves the AVX register state.
+ *
+ * @return Whether AVX2 is enabled or not.
+ */
+int visual_cpu_get_avx2 (void);
+
 /**
  * Function to retrieve if the 3dnow CPU feature is enabled.
  *
@@ -47,6 +47,7 @@ static const char *__lv_error_human_readable[] = {
 	[VISUAL_ERROR_AUDIO_SAMPLEPOOL_NULL] =		N_("The VisAudioSamplePool is NULL"),
 	[VISUAL_ERROR_AUDIO_SAMPLEPOOL_CHANNEL_NULL] =	N_("The VisAudioSamplePoolChannel is NULL"),
 	[VISUAL_ERROR_AUDIO_SAMPLE_NULL] =		N_("The VisAudioSample is NULL"),
+	[VISUAL_ERROR_AUDIO_RING_NULL] =		N_("The VisAudioRing is NULL"),
 
 	[VISUAL_ERROR_BMP_NO_BMP] =			N_("Bitmap is not a bitmap file"),
 	[VISUAL_ERROR_BMP_NOT_FOUND] =			N_("Bitmap can not be found"),
@@ -146,6 +147,9 @@ static const char *__lv_error_human_readable[] = {
 	[VISUAL_ERROR_MUTEX_TRYLOCK_FAILURE] =		N_("VisMutex trylock failed"),
 	[VISUAL_ERROR_MUTEX_UNLOCK_FAILURE] =		N_("VisMutex unlock failed"),
 
+	[VISUAL_ERROR_COND_NULL] =			N_("VisCond is NULL"),
+	[VISUAL_ERROR_COND_WAIT_FAILURE] =		N_("VisCond wait failed"),
+
 	[VISUAL_ERROR_TRANSFORM_NULL] =			N_("VisTransform is NULL"),
 	[VISUAL_ERROR_TRANSFORM_NEGOTIATE] =		N_("The VisTransform negotiate with the target VisVideo failed"),
 	[VISUAL_ERROR_TRANSFORM_PLUGIN_NULL] =		N_("The VisTransform it's plugin is NULL"),
@@ -173,7 +177,13 @@ static const char *__lv_error_human_readable[] = {
 	[VISUAL_ERROR_VIDEO_INVALID_ROTATE] =		N_("Invalid rotate degrees given"),
 	[VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS] =		N_("Given coordinates are out of bounds"),
 	[VISUAL_ERROR_VIDEO_NOT_INDENTICAL] =		N_("Given VisVideos are not indentical"),
-	[VISUAL_ERROR_VIDEO_NOT_TRANSFORMED] =		N_("VisVideo is not depth transformed as requested")
+	[VISUAL_ERROR_VIDEO_NOT_TRANSFORMED] =		N_("VisVideo is not depth transformed as requested"),
+	[VISUAL_ERROR_VIDEO_POOL_NULL] =		N_("The VisVideoPool is NULL"),
+
+	[VISUAL_ERROR_WARP_FIELD_NULL] =		N_("The VisWarpField is NULL"),
+
+	[VISUAL_ERROR_TIMING_NULL] =			N_("The VisTiming is NULL"),
+	[VISUAL_ERROR_TIMING_NOT_SUPPORTED] =		N_("Timing instrumentation is not supported")
 };
 
 static int log_and_exit (int error);
@@ -59,6 +59,7 @@ enum {
 	VISUAL_ERROR_AUDIO_SAMPLEPOOL_NULL,		/**< The VisAudioSamplePool is NULL. */
 	VISUAL_ERROR_AUDIO_SAMPLEPOOL_CHANNEL_NULL,	/**< The VisAudioSamplePoolChannel is NULL. */
 	VISUAL_ERROR_AUDIO_SAMPLE_NULL,			/**< The VisAudioSample is NULL. */
+	VISUAL_ERROR_AUDIO_RING_NULL,			/**< The VisAudioRing is NULL. */
 
 	/* Error entries for the VisBMP system */
 	VISUAL_ERROR_BMP_NO_BMP,			/**< Not a bitmap file. */
@@ -183,6 +184,8 @@ enum {
 	VISUAL_ERROR_MUTEX_LOCK_FAILURE,		/**< Failed locking the VisMutex. */
 	VISUAL_ERROR_MUTEX_TRYLOCK_FAILURE,		/**< Failed trylocking the VisMutex. */
 	VISUAL_ERROR_MUTEX_UNLOCK_FAILURE,		/**< Failed unlocking the VisMutex. */
+	VISUAL_ERROR_COND_NULL,				/**< The VisCond is NULL. */
+	VISUAL_ERROR_COND_WAIT_FAILURE,			/**< Failed waiting on the VisCond. */
 
 	/* Error entries for the VisTransform system */
 	VISUAL_ERROR_TRANSFORM_NULL,			/**< The VisTransform is NULL. */
@@ -216,6 +219,12 @@ enum {
 	VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS,		/**< The X or Y value are greater than the VisVideo it's dimension. */
 	VISUAL_ERROR_VIDEO_NOT_INDENTICAL,		/**< The two VisVideo their configuration are not indentical. */
 	VISUAL_ERROR_VIDEO_NOT_TRANSFORMED,		/**< Could not depth transform a VisVideo. */
+	VISUAL_ERROR_VIDEO_POOL_NULL,			/**< The VisVideoPool is NULL. */
+
+	VISUAL_ERROR_WARP_FIELD_NULL,			/**< The VisWarpField is NULL. */
+
+	VISUAL_ERROR_TIMING_NULL,			/**< The VisTiming is NULL. */
+	VISUAL_ERROR_TIMING_NOT_SUPPORTED,		/**< Libvisual was built without timing instrumentation. */
 
 	VISUAL_ERROR_BEAT_NULL,				/**< The VisBeat is NULL */
 	VISUAL_ERROR_BEAT_ADV_NULL,			/**< The VisBeatAdv is NULL */
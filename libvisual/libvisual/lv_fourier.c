@@ -3,7 +3,8 @@
  * Copyright (C) 2004, 2005, 2006 Dennis Smit <ds@nerds-incorporated.org>
  *
  * The FFT implementation found in this file is based upon the NULLSOFT
- * Milkdrop FFT implementation.
+ * Milkdrop FFT implementation. The mixed radix butterflies are based upon
+ * KISS FFT by Mark Borgerding.
  *
  * Authors: Dennis Smit <ds@nerds-incorporated.org>
  *          Chong Kai Xiong <descender@phreaker.net>
@@ -30,6 +31,9 @@
 #include "lv_common.h"
 #include "lv_cache.h"
 #include "lv_math.h"
+#include "lv_cpu.h"
+#include "lv_thread.h"
+#include "private/lv_fourier_simd.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -42,6 +46,16 @@
 #define DFT_CACHE_ENTRY(obj)				(VISUAL_CHECK_CAST ((obj), DFTCacheEntry))
 #define LOG_SCALE_CACHE_ENTRY(obj)			(VISUAL_CHECK_CAST ((obj), LogScaleCacheEntry))
 
+/* VISUAL_MATH_PI is a float, the twiddle tables are computed in double precision */
+#define DFT_PI				3.14159265358979323846
+
+/* Enough for any 32 bits transform size */
+#define DFT_MAX_FACTORS			32
+
+/* Limits of the table caches shared by all VisDFTs */
+#define DFT_CACHE_ENTRIES		50
+#define DFT_CACHE_BYTES			(8 * 1024 * 1024)
+
 typedef struct _DFTCacheEntry DFTCacheEntry;
 typedef struct _LogScaleCacheEntry LogScaleCacheEntry;
 
@@ -50,38 +64,86 @@ struct _DFTCacheEntry {
 
 	int		 spectrum_size;
 
-	float		*bitrevtable;
+	unsigned int	*bitrevtable;
 
+	/* Radix-2 keeps the twiddles of the pass with half size h at [h, 2h) */
 	float		*sintable;
 	float		*costable;
+
+	/* Twiddles used to split a packed real input transform */
+	float		*rsintable;
+	float		*rcostable;
+
+	/* Pairs of (radix, remaining length) for the mixed radix transform */
+	int		 factors[DFT_MAX_FACTORS * 2];
+
+	visual_size_t	 bytes;		/* Size of the tables */
 };
 
 struct _LogScaleCacheEntry {
 	VisObject	 object;
 
 	float		*range;
+	visual_size_t	 bytes;		/* Size of the table */
 };
 
+typedef void (*DFTBitrevRealFunc) (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n);
+typedef void (*DFTRadix2StageFunc) (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi);
+typedef void (*DFTNormScaleFunc) (float *dest, const float *real, const float *imag, unsigned int n, float scaler);
+typedef void (*DFTLogScaleFunc) (float *dest, const float *src, unsigned int n, float threshold, float divisor);
+
 static VisCache __lv_dft_cache;
 static VisCache __lv_log_scale_cache;
+static VisMutex *__lv_dft_cache_mutex = NULL;
 static int __lv_fourier_initialized = FALSE;
 
 
 static int dft_dtor (VisObject *object);
 
+static int fft_factorize (int *factors, unsigned int n);
+
 static void fft_table_bitrev_init (DFTCacheEntry *fcache, VisDFT *fourier);
 static void fft_table_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier);
+static void fft_table_mixed_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier);
+static void fft_table_real_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier);
 static void dft_table_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier);
 static void range_table_init (LogScaleCacheEntry *lcache, int size);
 
 static int dft_cache_destroyer (VisObject *object);
+static visual_size_t dft_cache_cost (void *data);
 static DFTCacheEntry *dft_cache_get (VisDFT *dft);
+static DFTCacheEntry *dft_cache_ref (VisDFT *dft);
+static void dft_cache_unref (DFTCacheEntry *fcache);
 
 static int log_scale_cache_destroyer (VisObject *object);
+static visual_size_t log_scale_cache_cost (void *data);
 static LogScaleCacheEntry *log_scale_cache_get (int size);
 
 static void perform_dft_brute_force (VisDFT *fourier, float *output, float *input);
 static void perform_fft_radix2_dit (VisDFT *fourier, float *output, float *input);
+static void perform_fft_mixed_radix (VisDFT *fourier, float *output, float *input);
+
+static void fft_mixed_radix_work (VisDFT *dft, DFTCacheEntry *fcache, float *input,
+		unsigned int out, unsigned int in, unsigned int fstride, const int *factors);
+static void fft_butterfly_2 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m);
+static void fft_butterfly_3 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m);
+static void fft_butterfly_4 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m);
+static void fft_butterfly_5 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m);
+static void fft_real_split (VisDFT *dft, DFTCacheEntry *fcache);
+
+/* Standard C kernels */
+static void dft_bitrev_real_c (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n);
+static void dft_radix2_stage_c (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi);
+static void dft_norm_scale_c (float *dest, const float *real, const float *imag, unsigned int n, float scaler);
+static void dft_log_scale_c (float *dest, const float *src, unsigned int n, float threshold, float divisor);
+
+/* Optimal kernels set by visual_fourier_initialize(). The radix-2 passes use
+ * the widest stage kernel that fits their half size, down to the C version. */
+static DFTBitrevRealFunc __lv_dft_bitrev_real = dft_bitrev_real_c;
+static DFTRadix2StageFunc __lv_dft_radix2_stage4 = NULL;
+static DFTRadix2StageFunc __lv_dft_radix2_stage8 = NULL;
+static DFTNormScaleFunc __lv_dft_norm_scale = dft_norm_scale_c;
+static DFTLogScaleFunc __lv_dft_log_scale = dft_log_scale_c;
 
 static int dft_dtor (VisObject *object)
 {
@@ -101,24 +163,59 @@ static int dft_dtor (VisObject *object)
 	return VISUAL_OK;
 }
 
+static int fft_factorize (int *factors, unsigned int n)
+{
+	unsigned int p = 4;
+	int count = 0;
+
+	while (n > 1) {
+		while (n % p != 0) {
+			switch (p) {
+				case 4: p = 2; break;
+				case 2: p = 3; break;
+				case 3: p = 5; break;
+
+				default:
+					/* A prime factor we have no butterfly for */
+					return FALSE;
+			}
+		}
+
+		if (count == DFT_MAX_FACTORS)
+			return FALSE;
+
+		n /= p;
+
+		if (factors != NULL) {
+			factors[count * 2] = p;
+			factors[count * 2 + 1] = n;
+		}
+
+		count++;
+	}
+
+	return TRUE;
+}
+
 static void fft_table_bitrev_init (DFTCacheEntry *fcache, VisDFT *fourier)
 {
 	unsigned int i, m, temp;
 	unsigned int j = 0;
 
-	fcache->bitrevtable = visual_mem_malloc0 (sizeof (unsigned int) * fourier->spectrum_size);
+	fcache->bitrevtable = visual_mem_malloc0 (sizeof (unsigned int) * fourier->fft_size);
+	fcache->bytes += sizeof (unsigned int) * fourier->fft_size;
 
-	for (i = 0; i < fourier->spectrum_size; i++)
+	for (i = 0; i < fourier->fft_size; i++)
 		fcache->bitrevtable[i] = i;
 
-	for (i = 0; i < fourier->spectrum_size; i++) {
+	for (i = 0; i < fourier->fft_size; i++) {
 		if (j > i) {
 			temp = fcache->bitrevtable[i];
 			fcache->bitrevtable[i] = fcache->bitrevtable[j];
 			fcache->bitrevtable[j] = temp;
 		}
 
-		m = fourier->spectrum_size >> 1;
+		m = fourier->fft_size >> 1;
 
 		while (m >= 1 && j >= m) {
 			j -= m;
@@ -131,31 +228,60 @@ static void fft_table_bitrev_init (DFTCacheEntry *fcache, VisDFT *fourier)
 
 static void fft_table_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier)
 {
-	unsigned int i, dftsize, tabsize;
-	float theta;
+	unsigned int k, hdftsize;
+	double theta;
 
-	dftsize = 2;
-	tabsize = 0;
-	while (dftsize <= fourier->spectrum_size) {
-		tabsize++;
+	fcache->sintable = visual_mem_malloc0 (sizeof (float) * fourier->fft_size);
+	fcache->costable = visual_mem_malloc0 (sizeof (float) * fourier->fft_size);
+	fcache->bytes += sizeof (float) * fourier->fft_size * 2;
 
-		dftsize <<= 1;
+	/* Every pass gets its own contiguous run of twiddles, so the butterflies
+	 * can load them as vectors */
+	for (hdftsize = 1; hdftsize < fourier->fft_size; hdftsize <<= 1) {
+		for (k = 0; k < hdftsize; k++) {
+			theta = (-DFT_PI * k) / hdftsize;
+
+			fcache->costable[hdftsize + k] = cos (theta);
+			fcache->sintable[hdftsize + k] = sin (theta);
+		}
 	}
+}
 
-	fcache->sintable = visual_mem_malloc0 (sizeof (float) * tabsize);
-	fcache->costable = visual_mem_malloc0 (sizeof (float) * tabsize);
+static void fft_table_mixed_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier)
+{
+	unsigned int i;
+	double theta;
+
+	fcache->sintable = visual_mem_malloc0 (sizeof (float) * fourier->fft_size);
+	fcache->costable = visual_mem_malloc0 (sizeof (float) * fourier->fft_size);
+	fcache->bytes += sizeof (float) * fourier->fft_size * 2;
+
+	/* Full twiddle table, the butterflies stride through it */
+	for (i = 0; i < fourier->fft_size; i++) {
+		theta = (-2.0 * DFT_PI * i) / fourier->fft_size;
+
+		fcache->costable[i] = cos (theta);
+		fcache->sintable[i] = sin (theta);
+	}
 
-	dftsize = 2;
-	i = 0;
-	while (dftsize <= fourier->spectrum_size) {
-		theta = (float) (-2.0f * VISUAL_MATH_PI / (float) dftsize);
+	fft_factorize (fcache->factors, fourier->fft_size);
+}
 
-		fcache->costable[i] = (float) cosf (theta);
-		fcache->sintable[i] = (float) sinf (theta);
+static void fft_table_real_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier)
+{
+	unsigned int i, tabsize;
+	double theta;
 
-		i++;
+	tabsize = fourier->fft_size / 2 + 1;
+	fcache->rsintable = visual_mem_malloc0 (sizeof (float) * tabsize);
+	fcache->rcostable = visual_mem_malloc0 (sizeof (float) * tabsize);
+	fcache->bytes += sizeof (float) * tabsize * 2;
+
+	for (i = 0; i < tabsize; i++) {
+		theta = (-2.0 * DFT_PI * i) / fourier->spectrum_size;
 
-		dftsize <<= 1;
+		fcache->rcostable[i] = cos (theta);
+		fcache->rsintable[i] = sin (theta);
 	}
 }
 
@@ -167,6 +293,7 @@ static void dft_table_cossin_init (DFTCacheEntry *fcache, VisDFT *fourier)
 	tabsize = fourier->spectrum_size / 2 + 1;
 	fcache->sintable = visual_mem_malloc0 (sizeof (float) * tabsize);
 	fcache->costable = visual_mem_malloc0 (sizeof (float) * tabsize);
+	fcache->bytes += sizeof (float) * tabsize * 2;
 
 	for (i = 0; i < tabsize; i++) {
 		theta = (-2.0f * VISUAL_MATH_PI * i) / fourier->spectrum_size;
@@ -184,6 +311,7 @@ static void range_table_init (LogScaleCacheEntry *lcache, int size)
 	tabsize = size;// / 2 + 1;
 
 	lcache->range = visual_mem_malloc0 (sizeof (float) * tabsize);
+	lcache->bytes = sizeof (float) * tabsize;
 
 	factor = 1.0f;
 	factor_scale = 1.0f / FREQ_LOG_SCALE_BASE;
@@ -210,13 +338,28 @@ static int dft_cache_destroyer (VisObject *object)
 	if (fcache->costable != NULL)
 		visual_mem_free (fcache->costable);
 
+	if (fcache->rsintable != NULL)
+		visual_mem_free (fcache->rsintable);
+
+	if (fcache->rcostable != NULL)
+		visual_mem_free (fcache->rcostable);
+
 	fcache->bitrevtable = NULL;
 	fcache->sintable = NULL;
 	fcache->costable = NULL;
+	fcache->rsintable = NULL;
+	fcache->rcostable = NULL;
 
 	return VISUAL_OK;
 }
 
+static visual_size_t dft_cache_cost (void *data)
+{
+	DFTCacheEntry *fcache = DFT_CACHE_ENTRY (data);
+
+	return sizeof (DFTCacheEntry) + fcache->bytes;
+}
+
 static DFTCacheEntry *dft_cache_get (VisDFT *fourier)
 {
 	DFTCacheEntry *fcache;
@@ -234,17 +377,53 @@ static DFTCacheEntry *dft_cache_get (VisDFT *fourier)
 
 		if (fourier->brute_force) {
 			dft_table_cossin_init (fcache, fourier);
+		} else if (fourier->mixed_radix) {
+			fft_table_mixed_cossin_init (fcache, fourier);
 		} else {
 			fft_table_bitrev_init (fcache, fourier);
 			fft_table_cossin_init (fcache, fourier);
 		}
 
+		if (fourier->real_input)
+			fft_table_real_cossin_init (fcache, fourier);
+
 		visual_cache_put (&__lv_dft_cache, key, fcache);
 	}
 
 	return fcache;
 }
 
+/* The cache is shared by every VisDFT, which can be used from several threads
+ * when actors render concurrently */
+static DFTCacheEntry *dft_cache_ref (VisDFT *dft)
+{
+	DFTCacheEntry *fcache;
+
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_lock (__lv_dft_cache_mutex);
+
+	fcache = dft_cache_get (dft);
+
+	if (fcache != NULL)
+		visual_object_ref (VISUAL_OBJECT (fcache));
+
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_unlock (__lv_dft_cache_mutex);
+
+	return fcache;
+}
+
+static void dft_cache_unref (DFTCacheEntry *fcache)
+{
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_lock (__lv_dft_cache_mutex);
+
+	visual_object_unref (VISUAL_OBJECT (fcache));
+
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_unlock (__lv_dft_cache_mutex);
+}
+
 static int log_scale_cache_destroyer (VisObject *object)
 {
 	LogScaleCacheEntry *lcache = LOG_SCALE_CACHE_ENTRY (object);
@@ -257,6 +436,13 @@ static int log_scale_cache_destroyer (VisObject *object)
 	return VISUAL_OK;
 }
 
+static visual_size_t log_scale_cache_cost (void *data)
+{
+	LogScaleCacheEntry *lcache = LOG_SCALE_CACHE_ENTRY (data);
+
+	return sizeof (LogScaleCacheEntry) + lcache->bytes;
+}
+
 static LogScaleCacheEntry *log_scale_cache_get (int size)
 {
 	LogScaleCacheEntry *lcache;
@@ -282,8 +468,51 @@ static LogScaleCacheEntry *log_scale_cache_get (int size)
 
 int visual_fourier_initialize ()
 {
-	visual_cache_init (&__lv_dft_cache, visual_object_collection_destroyer, 50, NULL, TRUE);
-	visual_cache_init (&__lv_log_scale_cache, visual_object_collection_destroyer, 50, NULL, TRUE);
+	/* Arranged from slow to fast, so the slower version gets overloaded
+	 * every time */
+	__lv_dft_bitrev_real = dft_bitrev_real_c;
+	__lv_dft_radix2_stage4 = NULL;
+	__lv_dft_radix2_stage8 = NULL;
+	__lv_dft_norm_scale = dft_norm_scale_c;
+	__lv_dft_log_scale = dft_log_scale_c;
+
+#if defined(HAVE_SSE2)
+	if (visual_cpu_get_sse2 () > 0) {
+		__lv_dft_bitrev_real = _lv_fourier_bitrev_real_sse2;
+		__lv_dft_radix2_stage4 = _lv_fourier_radix2_stage_sse2;
+		__lv_dft_norm_scale = _lv_fourier_norm_scale_sse2;
+		__lv_dft_log_scale = _lv_fourier_log_scale_sse2;
+	}
+#endif
+
+#if defined(HAVE_AVX2)
+	if (visual_cpu_get_avx2 () > 0) {
+		__lv_dft_radix2_stage8 = _lv_fourier_radix2_stage_avx2;
+		__lv_dft_norm_scale = _lv_fourier_norm_scale_avx2;
+		__lv_dft_log_scale = _lv_fourier_log_scale_avx2;
+	}
+#endif
+
+#if defined(HAVE_NEON)
+	if (visual_cpu_get_neon () > 0) {
+		__lv_dft_bitrev_real = _lv_fourier_bitrev_real_neon;
+		__lv_dft_radix2_stage4 = _lv_fourier_radix2_stage_neon;
+		__lv_dft_norm_scale = _lv_fourier_norm_scale_neon;
+		__lv_dft_log_scale = _lv_fourier_log_scale_neon;
+	}
+#endif
+
+	visual_cache_init (&__lv_dft_cache, visual_object_collection_destroyer, DFT_CACHE_ENTRIES, NULL, TRUE);
+	visual_cache_set_cost_func (&__lv_dft_cache, dft_cache_cost);
+	visual_cache_set_byte_limit (&__lv_dft_cache, DFT_CACHE_BYTES);
+
+	visual_cache_init (&__lv_log_scale_cache, visual_object_collection_destroyer, DFT_CACHE_ENTRIES, NULL, TRUE);
+	visual_cache_set_cost_func (&__lv_log_scale_cache, log_scale_cache_cost);
+	visual_cache_set_byte_limit (&__lv_log_scale_cache, DFT_CACHE_BYTES);
+
+	if (visual_thread_is_initialized () != FALSE && visual_thread_is_supported () != FALSE &&
+			visual_thread_is_enabled () != FALSE)
+		__lv_dft_cache_mutex = visual_mutex_new ();
 
 	__lv_fourier_initialized = TRUE;
 
@@ -295,6 +524,24 @@ int visual_fourier_is_initialized ()
 	return __lv_fourier_initialized;
 }
 
+int visual_fourier_get_cache_stats (VisCacheStats *stats)
+{
+	visual_return_val_if_fail (stats != NULL, -VISUAL_ERROR_NULL);
+
+	if (__lv_fourier_initialized == FALSE)
+		return -VISUAL_ERROR_FOURIER_NOT_INITIALIZED;
+
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_lock (__lv_dft_cache_mutex);
+
+	visual_cache_get_stats (&__lv_dft_cache, stats);
+
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_unlock (__lv_dft_cache_mutex);
+
+	return VISUAL_OK;
+}
+
 int visual_fourier_deinitialize ()
 {
 	if (__lv_fourier_initialized == FALSE)
@@ -303,6 +550,11 @@ int visual_fourier_deinitialize ()
 	visual_object_unref (VISUAL_OBJECT (&__lv_dft_cache));
 	visual_object_unref (VISUAL_OBJECT (&__lv_log_scale_cache));
 
+	if (__lv_dft_cache_mutex != NULL)
+		visual_mutex_free (__lv_dft_cache_mutex);
+
+	__lv_dft_cache_mutex = NULL;
+
 	__lv_fourier_initialized = FALSE;
 
 	return VISUAL_OK;
@@ -314,7 +566,7 @@ VisDFT *visual_dft_new (unsigned int samples_out, unsigned int samples_in)
 
 	dft = visual_mem_new0 (VisDFT, 1);
 
-	visual_dft_init (dft, samples_in, samples_out);
+	visual_dft_init (dft, samples_out, samples_in);
 
 	/* Do the VisObject initialization */
 	visual_object_set_allocated (VISUAL_OBJECT (dft), TRUE);
@@ -334,11 +586,30 @@ int visual_dft_init (VisDFT *dft, unsigned int samples_out, unsigned int samples
 
 	/* Set the VisDFT data */
 	dft->samples_in = samples_in;
+	dft->samples_out = samples_out;
 	dft->spectrum_size = samples_in;
-	dft->brute_force = !visual_math_is_power_of_2 (dft->spectrum_size);
+
+	/* Select the engine: an even number of real samples is packed into a
+	 * complex transform of half the size, which is done with radix-2 when
+	 * it's a power of 2, mixed radix 2/3/4/5 when possible, and brute force
+	 * otherwise */
+	dft->real_input = dft->spectrum_size >= 4 && dft->spectrum_size % 2 == 0;
+	dft->fft_size = dft->real_input ? dft->spectrum_size / 2 : dft->spectrum_size;
+	dft->mixed_radix = FALSE;
+	dft->brute_force = FALSE;
+
+	if (!visual_math_is_power_of_2 (dft->fft_size)) {
+		if (fft_factorize (NULL, dft->fft_size)) {
+			dft->mixed_radix = TRUE;
+		} else {
+			dft->brute_force = TRUE;
+			dft->real_input = FALSE;
+			dft->fft_size = dft->spectrum_size;
+		}
+	}
 
 	/* Initialize the VisDFT */
-	dft_cache_get (dft);
+	dft_cache_unref (dft_cache_ref (dft));
 
 	dft->real = visual_mem_malloc0 (sizeof (float) * dft->spectrum_size);
 	dft->imag = visual_mem_malloc0 (sizeof (float) * dft->spectrum_size);
@@ -352,8 +623,7 @@ static void perform_dft_brute_force (VisDFT *dft, float *output, float *input)
 	unsigned int i, j;
 	float xr, xi, wr, wi, wtemp;
 
-	fcache = dft_cache_get (dft);
-	visual_object_ref (VISUAL_OBJECT (fcache));
+	fcache = dft_cache_ref (dft);
 
 	for (i = 0; i < dft->spectrum_size / 2 + 1; i++) {
 		xr = 0.0f;
@@ -375,83 +645,400 @@ static void perform_dft_brute_force (VisDFT *dft, float *output, float *input)
 		dft->imag[i] = xi;
 	}
 
-	visual_object_unref (VISUAL_OBJECT (fcache));
+	dft_cache_unref (fcache);
 }
 
 static void perform_fft_radix2_dit (VisDFT *dft, float *output, float *input)
 {
 	DFTCacheEntry *fcache;
-	unsigned int j, m, i, dftsize, hdftsize, t;
-	float wr, wi, wpi, wpr, wtemp, tempr, tempi;
+	unsigned int i, hdftsize;
 
-	fcache = dft_cache_get (dft);
-	visual_object_ref (VISUAL_OBJECT (fcache));
+	fcache = dft_cache_ref (dft);
 
-	for (i = 0; i < dft->spectrum_size; i++) {
-		unsigned int idx = fcache->bitrevtable[i];
+	if (dft->real_input && dft->fft_size * 2 <= dft->samples_in) {
+		/* Even samples go in the real part, odd samples in the imaginary part */
+		__lv_dft_bitrev_real (dft->real, dft->imag, input, fcache->bitrevtable, dft->fft_size);
+	} else if (dft->real_input) {
+		for (i = 0; i < dft->fft_size; i++) {
+			unsigned int idx = fcache->bitrevtable[i] * 2;
 
-		if (idx < dft->samples_in)
-			dft->real[i] = input[idx];
+			dft->real[i] = idx < dft->samples_in ? input[idx] : 0;
+			dft->imag[i] = idx + 1 < dft->samples_in ? input[idx + 1] : 0;
+		}
+	} else {
+		for (i = 0; i < dft->fft_size; i++) {
+			unsigned int idx = fcache->bitrevtable[i];
+
+			if (idx < dft->samples_in)
+				dft->real[i] = input[idx];
+			else
+				dft->real[i] = 0;
+		}
+
+		visual_mem_set (dft->imag, 0, sizeof (float) * dft->fft_size);
+	}
+
+	for (hdftsize = 1; hdftsize < dft->fft_size; hdftsize <<= 1) {
+		float *wr = fcache->costable + hdftsize;
+		float *wi = fcache->sintable + hdftsize;
+
+		if (hdftsize >= 8 && __lv_dft_radix2_stage8 != NULL)
+			__lv_dft_radix2_stage8 (dft->real, dft->imag, dft->fft_size, hdftsize, wr, wi);
+		else if (hdftsize >= 4 && __lv_dft_radix2_stage4 != NULL)
+			__lv_dft_radix2_stage4 (dft->real, dft->imag, dft->fft_size, hdftsize, wr, wi);
 		else
-			dft->real[i] = 0;
+			dft_radix2_stage_c (dft->real, dft->imag, dft->fft_size, hdftsize, wr, wi);
 	}
 
-	visual_mem_set (dft->imag, 0, sizeof (float) * dft->spectrum_size);
+	if (dft->real_input)
+		fft_real_split (dft, fcache);
 
-	dftsize = 2;
-	t = 0;
-	while (dftsize <= dft->spectrum_size) {
-		wpr = fcache->costable[t];
-		wpi = fcache->sintable[t];
+	dft_cache_unref (fcache);
+}
 
-		wr = 1.0f;
-		wi = 0.0f;
+static void perform_fft_mixed_radix (VisDFT *dft, float *output, float *input)
+{
+	DFTCacheEntry *fcache;
 
-		hdftsize = dftsize >> 1;
+	fcache = dft_cache_ref (dft);
 
-		for (m = 0; m < hdftsize; m += 1) {
-			for (i = m; i < dft->spectrum_size; i+=dftsize) {
-				j = i + hdftsize;
+	fft_mixed_radix_work (dft, fcache, input, 0, 0, 1, fcache->factors);
 
-				tempr = wr * dft->real[j] - wi * dft->imag[j];
-				tempi = wr * dft->imag[j] + wi * dft->real[j];
+	if (dft->real_input)
+		fft_real_split (dft, fcache);
 
-				dft->real[j] = dft->real[i] - tempr;
-				dft->imag[j] = dft->imag[i] - tempi;
+	dft_cache_unref (fcache);
+}
 
-				dft->real[i] += tempr;
-				dft->imag[i] += tempi;
+/* Recursive decimation in time, after KISS FFT by Mark Borgerding. Every
+ * level splits the input in p interleaved sequences of length m, transforms
+ * them into consecutive runs of the output and combines these with a radix p
+ * butterfly. Input indices are complex indices, out and in are offsets. */
+static void fft_mixed_radix_work (VisDFT *dft, DFTCacheEntry *fcache, float *input,
+		unsigned int out, unsigned int in, unsigned int fstride, const int *factors)
+{
+	unsigned int p = factors[0];
+	unsigned int m = factors[1];
+	unsigned int begin = out;
+	unsigned int end = out + p * m;
+
+	if (m == 1) {
+		for (; out < end; out++, in += fstride) {
+			if (dft->real_input) {
+				dft->real[out] = in * 2 < dft->samples_in ? input[in * 2] : 0;
+				dft->imag[out] = in * 2 + 1 < dft->samples_in ? input[in * 2 + 1] : 0;
+			} else {
+				dft->real[out] = in < dft->samples_in ? input[in] : 0;
+				dft->imag[out] = 0;
 			}
-
-			wr = (wtemp = wr) * wpr - wi * wpi;
-			wi = wi * wpr + wtemp * wpi;
 		}
+	} else {
+		for (; out < end; out += m, in += fstride)
+			fft_mixed_radix_work (dft, fcache, input, out, in, fstride * p, factors + 2);
+	}
 
-		dftsize <<= 1;
-		t++;
+	switch (p) {
+		case 2: fft_butterfly_2 (dft, fcache, begin, fstride, m); break;
+		case 3: fft_butterfly_3 (dft, fcache, begin, fstride, m); break;
+		case 4: fft_butterfly_4 (dft, fcache, begin, fstride, m); break;
+		case 5: fft_butterfly_5 (dft, fcache, begin, fstride, m); break;
 	}
+}
 
-	visual_object_unref (VISUAL_OBJECT (fcache));
+static void fft_butterfly_2 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m)
+{
+	float *re = dft->real + out;
+	float *im = dft->imag + out;
+	float wr, wi, tr, ti;
+	unsigned int k;
+
+	for (k = 0; k < m; k++) {
+		wr = fcache->costable[k * fstride];
+		wi = fcache->sintable[k * fstride];
+
+		tr = re[k + m] * wr - im[k + m] * wi;
+		ti = re[k + m] * wi + im[k + m] * wr;
+
+		re[k + m] = re[k] - tr;
+		im[k + m] = im[k] - ti;
+
+		re[k] += tr;
+		im[k] += ti;
+	}
+}
+
+static void fft_butterfly_3 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m)
+{
+	float *re = dft->real + out;
+	float *im = dft->imag + out;
+	float *wr = fcache->costable;
+	float *wi = fcache->sintable;
+	float epi3 = fcache->sintable[fstride * m];
+	float s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i;
+	unsigned int k;
+
+	for (k = 0; k < m; k++) {
+		unsigned int t1 = k * fstride;
+		unsigned int t2 = t1 * 2;
+
+		s1r = re[k + m] * wr[t1] - im[k + m] * wi[t1];
+		s1i = re[k + m] * wi[t1] + im[k + m] * wr[t1];
+		s2r = re[k + 2 * m] * wr[t2] - im[k + 2 * m] * wi[t2];
+		s2i = re[k + 2 * m] * wi[t2] + im[k + 2 * m] * wr[t2];
+
+		s3r = s1r + s2r;
+		s3i = s1i + s2i;
+		s0r = (s1r - s2r) * epi3;
+		s0i = (s1i - s2i) * epi3;
+
+		re[k + m] = re[k] - s3r * 0.5f;
+		im[k + m] = im[k] - s3i * 0.5f;
+
+		re[k] += s3r;
+		im[k] += s3i;
+
+		re[k + 2 * m] = re[k + m] + s0i;
+		im[k + 2 * m] = im[k + m] - s0r;
+
+		re[k + m] -= s0i;
+		im[k + m] += s0r;
+	}
+}
+
+static void fft_butterfly_4 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m)
+{
+	float *re = dft->real + out;
+	float *im = dft->imag + out;
+	float *wr = fcache->costable;
+	float *wi = fcache->sintable;
+	float s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i, s5r, s5i;
+	unsigned int k;
+
+	for (k = 0; k < m; k++) {
+		unsigned int t1 = k * fstride;
+		unsigned int t2 = t1 * 2;
+		unsigned int t3 = t1 * 3;
+
+		s0r = re[k + m] * wr[t1] - im[k + m] * wi[t1];
+		s0i = re[k + m] * wi[t1] + im[k + m] * wr[t1];
+		s1r = re[k + 2 * m] * wr[t2] - im[k + 2 * m] * wi[t2];
+		s1i = re[k + 2 * m] * wi[t2] + im[k + 2 * m] * wr[t2];
+		s2r = re[k + 3 * m] * wr[t3] - im[k + 3 * m] * wi[t3];
+		s2i = re[k + 3 * m] * wi[t3] + im[k + 3 * m] * wr[t3];
+
+		s5r = re[k] - s1r;
+		s5i = im[k] - s1i;
+
+		re[k] += s1r;
+		im[k] += s1i;
+
+		s3r = s0r + s2r;
+		s3i = s0i + s2i;
+		s4r = s0r - s2r;
+		s4i = s0i - s2i;
+
+		re[k + 2 * m] = re[k] - s3r;
+		im[k + 2 * m] = im[k] - s3i;
+
+		re[k] += s3r;
+		im[k] += s3i;
+
+		re[k + m] = s5r + s4i;
+		im[k + m] = s5i - s4r;
+
+		re[k + 3 * m] = s5r - s4i;
+		im[k + 3 * m] = s5i + s4r;
+	}
+}
+
+static void fft_butterfly_5 (VisDFT *dft, DFTCacheEntry *fcache, unsigned int out, unsigned int fstride, unsigned int m)
+{
+	float *re = dft->real + out;
+	float *im = dft->imag + out;
+	float *wr = fcache->costable;
+	float *wi = fcache->sintable;
+	float yar = wr[fstride * m];
+	float yai = wi[fstride * m];
+	float ybr = wr[fstride * 2 * m];
+	float ybi = wi[fstride * 2 * m];
+	float s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i;
+	float s5r, s5i, s6r, s6i, s7r, s7i, s8r, s8i;
+	float s9r, s9i, s10r, s10i, s11r, s11i, s12r, s12i;
+	unsigned int k;
+
+	for (k = 0; k < m; k++) {
+		unsigned int t1 = k * fstride;
+		unsigned int t2 = t1 * 2;
+		unsigned int t3 = t1 * 3;
+		unsigned int t4 = t1 * 4;
+
+		s0r = re[k];
+		s0i = im[k];
+
+		s1r = re[k + m] * wr[t1] - im[k + m] * wi[t1];
+		s1i = re[k + m] * wi[t1] + im[k + m] * wr[t1];
+		s2r = re[k + 2 * m] * wr[t2] - im[k + 2 * m] * wi[t2];
+		s2i = re[k + 2 * m] * wi[t2] + im[k + 2 * m] * wr[t2];
+		s3r = re[k + 3 * m] * wr[t3] - im[k + 3 * m] * wi[t3];
+		s3i = re[k + 3 * m] * wi[t3] + im[k + 3 * m] * wr[t3];
+		s4r = re[k + 4 * m] * wr[t4] - im[k + 4 * m] * wi[t4];
+		s4i = re[k + 4 * m] * wi[t4] + im[k + 4 * m] * wr[t4];
+
+		s7r = s1r + s4r;
+		s7i = s1i + s4i;
+		s10r = s1r - s4r;
+		s10i = s1i - s4i;
+		s8r = s2r + s3r;
+		s8i = s2i + s3i;
+		s9r = s2r - s3r;
+		s9i = s2i - s3i;
+
+		re[k] = s0r + s7r + s8r;
+		im[k] = s0i + s7i + s8i;
+
+		s5r = s0r + s7r * yar + s8r * ybr;
+		s5i = s0i + s7i * yar + s8i * ybr;
+
+		s6r = s10i * yai + s9i * ybi;
+		s6i = -s10r * yai - s9r * ybi;
+
+		re[k + m] = s5r - s6r;
+		im[k + m] = s5i - s6i;
+		re[k + 4 * m] = s5r + s6r;
+		im[k + 4 * m] = s5i + s6i;
+
+		s11r = s0r + s7r * ybr + s8r * yar;
+		s11i = s0i + s7i * ybr + s8i * yar;
+
+		s12r = -s10i * ybi + s9i * yai;
+		s12i = s10r * ybi - s9r * yai;
+
+		re[k + 2 * m] = s11r + s12r;
+		im[k + 2 * m] = s11i + s12i;
+		re[k + 3 * m] = s11r - s12r;
+		im[k + 3 * m] = s11i - s12i;
+	}
+}
+
+/* Turns the N/2 point complex transform Z of the packed real input into the
+ * first N/2 + 1 bins of its N point transform X, in place:
+ *
+ *   X[k] = E[k] + W^k O[k], E[k] = (Z[k] + Z*[M-k]) / 2, O[k] = -i (Z[k] - Z*[M-k]) / 2
+ *
+ * with M = N/2 and W = exp(-2 pi i / N). Bins k and M - k are computed
+ * together since X[M-k] = (E[k] - W^k O[k])*. */
+static void fft_real_split (VisDFT *dft, DFTCacheEntry *fcache)
+{
+	float *re = dft->real;
+	float *im = dft->imag;
+	unsigned int m = dft->fft_size;
+	unsigned int k;
+	float er, ei, odr, odi, tr, ti;
+
+	er = re[0];
+	ei = im[0];
+
+	re[0] = er + ei;
+	im[0] = 0;
+	re[m] = er - ei;
+	im[m] = 0;
+
+	for (k = 1; k < m - k; k++) {
+		er = (re[k] + re[m - k]) * 0.5f;
+		ei = (im[k] - im[m - k]) * 0.5f;
+		odr = (im[k] + im[m - k]) * 0.5f;
+		odi = (re[m - k] - re[k]) * 0.5f;
+
+		tr = fcache->rcostable[k] * odr - fcache->rsintable[k] * odi;
+		ti = fcache->rcostable[k] * odi + fcache->rsintable[k] * odr;
+
+		re[k] = er + tr;
+		im[k] = ei + ti;
+
+		re[m - k] = er - tr;
+		im[m - k] = ti - ei;
+	}
+
+	/* X[M/2] is Z*[M/2] */
+	if (m % 2 == 0)
+		im[m / 2] = -im[m / 2];
 }
 
 int visual_dft_perform (VisDFT *dft, float *output, float *input)
 {
+	unsigned int outsize;
+
 	visual_return_val_if_fail (dft != NULL, -VISUAL_ERROR_FOURIER_NULL);
 	visual_return_val_if_fail (output != NULL, -VISUAL_ERROR_NULL);
 	visual_return_val_if_fail (input != NULL, -VISUAL_ERROR_NULL);
 
 	if (dft->brute_force)
 		perform_dft_brute_force (dft, output, input);
+	else if (dft->mixed_radix)
+		perform_fft_mixed_radix (dft, output, input);
 	else
 		perform_fft_radix2_dit (dft, output, input);
 
-	visual_math_vectorized_complex_to_norm_scale (output, dft->real, dft->imag,
-			dft->spectrum_size / 2,
+	/* Never write past the output the caller gave us */
+	outsize = dft->spectrum_size / 2;
+	if (dft->samples_out < outsize)
+		outsize = dft->samples_out;
+
+	__lv_dft_norm_scale (output, dft->real, dft->imag,
+			outsize,
 			1.0 / dft->spectrum_size);
 
 	return VISUAL_OK;
 }
 
+static void dft_bitrev_real_c (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		real[i] = input[bitrev[i] * 2];
+		imag[i] = input[bitrev[i] * 2 + 1];
+	}
+}
+
+static void dft_radix2_stage_c (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi)
+{
+	unsigned int i, j, k;
+	float tempr, tempi;
+
+	for (i = 0; i < n; i += hsize * 2) {
+		for (k = 0; k < hsize; k++) {
+			j = i + k + hsize;
+
+			tempr = wr[k] * real[j] - wi[k] * imag[j];
+			tempi = wr[k] * imag[j] + wi[k] * real[j];
+
+			real[j] = real[i + k] - tempr;
+			imag[j] = imag[i + k] - tempi;
+
+			real[i + k] += tempr;
+			imag[i + k] += tempi;
+		}
+	}
+}
+
+static void dft_norm_scale_c (float *dest, const float *real, const float *imag, unsigned int n, float scaler)
+{
+	visual_math_vectorized_complex_to_norm_scale (dest, (float *) real, (float *) imag, n, scaler);
+}
+
+static void dft_log_scale_c (float *dest, const float *src, unsigned int n, float threshold, float divisor)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		if (src[i] > threshold)
+			dest[i] = 1.0f + log (src[i]) / divisor;
+		else
+			dest[i] = 0.0f;
+	}
+}
+
 int visual_dft_log_scale (float *output, float *input, int size)
 {
 	LogScaleCacheEntry *lcache;
@@ -497,17 +1084,13 @@ int visual_dft_log_scale_standard (float *output, float *input, int size)
 
 int visual_dft_log_scale_custom (float *output, float *input, int size, float log_scale_divisor)
 {
-	int i;
-
 	visual_return_val_if_fail (output != NULL, -VISUAL_ERROR_NULL);
 	visual_return_val_if_fail (input != NULL, -VISUAL_ERROR_NULL);
 
-	for (i = 0; i < size; i++) {
-		if (input[i] > AMP_LOG_SCALE_THRESHOLD0)
-			output[i] = 1.0f + log (input[i]) / log_scale_divisor;
-		else
-			output[i] = 0.0f;
-	}
+	if (size <= 0)
+		return VISUAL_OK;
+
+	__lv_dft_log_scale (output, input, size, AMP_LOG_SCALE_THRESHOLD0, log_scale_divisor);
 
 	return VISUAL_OK;
 }
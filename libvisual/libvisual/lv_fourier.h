@@ -26,6 +26,7 @@
 #define _LV_FOURIER_H
 
 #include <libvisual/lv_object.h>
+#include <libvisual/lv_cache.h>
 
 VISUAL_BEGIN_DECLS
 
@@ -44,19 +45,24 @@ typedef struct _VisDFT VisDFT;
 struct _VisDFT {
 	VisObject	 object;			/**< The VisObject data. */
 	unsigned int	 samples_in;			/**< The number of input samples. */
-	unsigned int	 spectrum_size;			/**< The size of the spectrum (power of two). */
+	unsigned int	 samples_out;			/**< The number of output samples. */
+	unsigned int	 spectrum_size;			/**< The size of the spectrum. */
+	unsigned int	 fft_size;			/**< Private data that is used by the fourier engine. */
 	float		*real;				/**< Private data that is used by the fourier engine. */
 	float		*imag;				/**< Private data that is used by the fourier engine. */
 	int		 brute_force;			/**< Private data that is used by the fourier engine. */
+	int		 mixed_radix;			/**< Private data that is used by the fourier engine. */
+	int		 real_input;			/**< Private data that is used by the fourier engine. */
 };
 
 /**
  * Function to create a new VisDFT Discrete Fourier Transform context used
  * to calculate amplitude spectrums over audio data.
  *
- * \note For optimal performance, use a power-of-2 spectrum size. The
- * current implementation does not use the Fast Fourier Transform for
- * non powers of 2.
+ * \note For optimal performance, use a spectrum size whose only prime
+ * factors are 2, 3 and 5, powers of 2 being the fastest. Even sizes are
+ * computed as a complex transform of half the size. Sizes with any other
+ * prime factor fall back to a brute force O(n^2) DFT.
  *
  * \note If samples_in is smaller than 2 * samples_out, the input will be padded
  * with zeroes.
@@ -104,6 +110,18 @@ int visual_fourier_initialize (void);
 int visual_fourier_is_initialized (void);
 int visual_fourier_deinitialize (void);
 
+/**
+ * Gets the counters of the cache of twiddle tables that all VisDFTs share.
+ * The cache keeps at most 50 tables and 8 MiB, least recently used tables
+ * are dropped first.
+ *
+ * @param stats Filled in with the counters.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_NULL or
+ *	-VISUAL_ERROR_FOURIER_NOT_INITIALIZED on failure.
+ */
+int visual_fourier_get_cache_stats (VisCacheStats *stats);
+
 VISUAL_END_DECLS
 
 /**
@@ -114,7 +114,7 @@ int visual_hashlist_init (VisHashlist *hashlist, VisCollectionDestroyerFunc dest
 	hashlist->list = visual_list_new (NULL);
 
 	hashlist->index = visual_hashmap_new (NULL); /* FIXME create in set_limits, rehash if not NULL */
-	visual_hashmap_set_table_size (hashlist->index, size); /* <- also */
+	visual_hashmap_reserve (hashlist->index, size); /* <- also */
 
 	return VISUAL_OK;
 }
@@ -133,7 +133,7 @@ int visual_hashlist_clear (VisHashlist *hashlist)
 		visual_object_unref (VISUAL_OBJECT (hashlist->index));
 
 	hashlist->index = visual_hashmap_new (NULL);
-	visual_hashmap_set_table_size (hashlist->index, hashlist->size);
+	visual_hashmap_reserve (hashlist->index, hashlist->size);
 
 	return VISUAL_OK;
 }
@@ -31,22 +31,26 @@
 
 #define HASHMAP_ITERCONTEXT(obj)                           (VISUAL_CHECK_CAST ((obj), HashmapIterContext))
 
+/* The table grows when it is more than 7/8 full */
+#define HASHMAP_LOAD_NUM	7
+#define HASHMAP_LOAD_DEN	8
+
+/* Least number of slots of the old table that are moved by every put and
+ * remove while the table grows, see resize() */
+#define HASHMAP_MIGRATE_STEP	8
+
 
 typedef struct _HashmapIterContext HashmapIterContext;
 
 struct _HashmapIterContext {
 	VisObject	*object;
 
-	int		 index;
-	int		 retrieved;
-	int		 first;
-
-	VisListEntry	*le;
+	int		 index;		/* Slot of table, or of oldtable from tablesize on */
 };
 
 
 static int hashmap_destroy (VisCollection *collection);
-static int hashmap_chain_destroy (VisHashmap *hashmap, VisList *list);
+static void hashmap_table_destroy (VisHashmap *hashmap, VisHashmapEntry *table, int tablesize);
 static int hashmap_size (VisCollection *collection);
 static VisCollectionIter *hashmap_iter (VisCollection *collection);
 
@@ -54,63 +58,68 @@ static void hashmap_iter_assign (VisCollectionIter *iter, VisCollection *collect
 static int hashmap_iter_has_more (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext);
 static void hashmap_iter_next (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext);
 static void *hashmap_iter_get_data (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext);
+static VisHashmapEntry *hashmap_iter_slot (VisHashmap *hashmap, int index);
+static int hashmap_iter_seek (VisHashmap *hashmap, int index);
 
-static int integer_hash (uint32_t key);
-static int string_hash (char *key);
-static int get_hash (VisHashmap *hashmap, void *key, VisHashmapKeyType keytype);
+static uint32_t integer_hash (uint32_t key);
+static uint32_t string_hash (const char *key);
+static uint32_t get_hash (void *key, VisHashmapKeyType keytype);
 
-static int create_table (VisHashmap *hashmap);
+static int key_equal (VisHashmapEntry *entry, uint32_t hash, void *key, VisHashmapKeyType keytype);
+static int table_find (VisHashmapEntry *table, int tablesize, int start, int skip,
+		uint32_t hash, void *key, VisHashmapKeyType keytype);
+static void table_insert (VisHashmapEntry *table, int tablesize, VisHashmapEntry *entry);
+static void table_delete (VisHashmapEntry *table, int tablesize, int index);
+static VisHashmapEntry *find_entry (VisHashmap *hashmap, uint32_t hash, void *key, VisHashmapKeyType keytype,
+		VisHashmapEntry **table, int *tablesize, int *index);
+
+static int table_size_for (int capacity);
+static void migrate (VisHashmap *hashmap, int slots);
+static void resize (VisHashmap *hashmap, int tablesize);
 
 
 static int hashmap_destroy (VisCollection *collection)
 {
 	VisHashmap *hashmap = VISUAL_HASHMAP (collection);
-	int i;
-
-	for (i = 0; i < hashmap->size; i++)
-		hashmap_chain_destroy (hashmap, &hashmap->table[i].list);
 
 	if (hashmap->table != NULL)
-		visual_mem_free (hashmap->table);
+		hashmap_table_destroy (hashmap, hashmap->table, hashmap->tablesize);
+
+	if (hashmap->oldtable != NULL)
+		hashmap_table_destroy (hashmap, hashmap->oldtable, hashmap->oldtablesize);
 
 	hashmap->table = NULL;
+	hashmap->oldtable = NULL;
+	hashmap->oldtablesize = 0;
+	hashmap->oldstart = 0;
+	hashmap->migrated = 0;
+	hashmap->pendingsize = 0;
+	hashmap->size = 0;
 
 	return VISUAL_OK;
 }
 
-/* We can't use collection dtor because we need to chain up (HashChainElem -> DataElem) */
-static int hashmap_chain_destroy (VisHashmap *hashmap, VisList *list)
+static void hashmap_table_destroy (VisHashmap *hashmap, VisHashmapEntry *table, int tablesize)
 {
 	VisCollectionDestroyerFunc destroyer;
-	VisHashmapChainEntry *mentry;
-	VisListEntry *le = NULL;
+	int i;
 
 	destroyer = visual_collection_get_destroyer (VISUAL_COLLECTION (hashmap));
 
-	if (destroyer == NULL) {
-		while ((mentry = visual_list_next (list, &le)) != NULL)
-			visual_list_destroy (list, &le);
-	} else {
-		while ((mentry = visual_list_next (list, &le)) != NULL) {
-			destroyer (mentry->data);
-			visual_list_destroy (list, &le);
-		}
-	}
-	return VISUAL_OK;
-}
+	for (i = 0; i < tablesize; i++) {
+		VisHashmapEntry *entry = &table[i];
 
-static int hashmap_list_entry_destroyer (void *data)
-{
-	VisHashmapChainEntry *mentry = VISUAL_HASHMAPCHAINENTRY (data);
+		if (entry->hash == 0)
+			continue;
 
-	if (mentry == NULL)
-		return -1;
+		if (destroyer != NULL)
+			destroyer (entry->data);
 
-	if (mentry->keytype == VISUAL_HASHMAP_KEY_TYPE_STRING) {
-		visual_mem_free (mentry->key.string);
+		if (entry->keytype == VISUAL_HASHMAP_KEY_TYPE_STRING)
+			visual_mem_free (entry->key.string);
 	}
 
-	return visual_mem_free (mentry);
+	visual_mem_free (table);
 }
 
 static int hashmap_size (VisCollection *collection)
@@ -129,10 +138,7 @@ static VisCollectionIter *hashmap_iter (VisCollection *collection)
 
 	/* Do the VisObject initialization */
 	visual_object_initialize (VISUAL_OBJECT (context), TRUE, NULL);
-	context->index = 0;
-	context->le = NULL;
-	context->retrieved = FALSE;
-	context->first = TRUE;
+	context->index = hashmap_iter_seek (VISUAL_HASHMAP (collection), 0);
 
 	iter = visual_collection_iter_new (hashmap_iter_assign, hashmap_iter_next, hashmap_iter_has_more,
 			hashmap_iter_get_data, collection, VISUAL_OBJECT (context));
@@ -143,14 +149,13 @@ static VisCollectionIter *hashmap_iter (VisCollection *collection)
 static void hashmap_iter_assign (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext, int index)
 {
 	VisHashmap *hashmap = VISUAL_HASHMAP (collection);
+	HashmapIterContext *context = HASHMAP_ITERCONTEXT (itercontext);
 	int i;
 
-	if (index >= hashmap->tablesize)
-		return;
+	context->index = hashmap_iter_seek (hashmap, 0);
 
-	for (i = 0; i < index; i++) {
+	for (i = 0; i < index; i++)
 		hashmap_iter_next (iter, collection, itercontext);
-	}
 }
 
 static int hashmap_iter_has_more (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext)
@@ -158,79 +163,69 @@ static int hashmap_iter_has_more (VisCollectionIter *iter, VisCollection *collec
 	VisHashmap *hashmap = VISUAL_HASHMAP (collection);
 	HashmapIterContext *context = HASHMAP_ITERCONTEXT (itercontext);
 
-	if (context->index >= hashmap->tablesize)
-		return FALSE;
-
-	/* First entry */
-	if (context->first) {
-		context->first = FALSE;
-
-		for (; context->index < hashmap->tablesize; context->index++) {
-			if (visual_collection_size (VISUAL_COLLECTION (&hashmap->table[context->index].list)) > 0) {
-				context->le = hashmap->table[context->index].list.head;
-				context->retrieved = FALSE;
-
-				return TRUE;
-			}
-		}
-	}
-
-	/* Check for next chain entry */
-	if (context->le != NULL && context->le->next != NULL) {
-		context->le = context->le->next;
-
-		return TRUE;
-	}
+	return hashmap_iter_slot (hashmap, context->index) != NULL;
+}
 
-	/* No next in chain, next array entry */
-	context->index++;
-	for (; context->index < hashmap->tablesize; context->index++) {
-		if (visual_collection_size (VISUAL_COLLECTION (&hashmap->table[context->index].list)) > 0) {
-			context->le = hashmap->table[context->index].list.head;
-			context->retrieved = FALSE;
+static void hashmap_iter_next (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext)
+{
+	VisHashmap *hashmap = VISUAL_HASHMAP (collection);
+	HashmapIterContext *context = HASHMAP_ITERCONTEXT (itercontext);
 
-			return TRUE;
-		}
-	}
+	if (hashmap_iter_slot (hashmap, context->index) == NULL)
+		return;
 
-	return FALSE;
+	context->index = hashmap_iter_seek (hashmap, context->index + 1);
 }
 
-static void hashmap_iter_next (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext)
+static void *hashmap_iter_get_data (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext)
 {
+	VisHashmap *hashmap = VISUAL_HASHMAP (collection);
 	HashmapIterContext *context = HASHMAP_ITERCONTEXT (itercontext);
+	VisHashmapEntry *entry;
 
-	if (context->retrieved == FALSE) {
-		if (context->first == TRUE) {
-			hashmap_iter_has_more (iter, collection, itercontext);
+	entry = hashmap_iter_slot (hashmap, context->index);
 
-			context->first = FALSE;
-		}
+	if (entry == NULL)
+		return NULL;
 
-		context->retrieved = TRUE;
+	return entry->data;
+}
 
-		return;
-	}
+/* Slots of the new table come first, followed by the ones of the old table */
+static VisHashmapEntry *hashmap_iter_slot (VisHashmap *hashmap, int index)
+{
+	VisHashmapEntry *entry = NULL;
+
+	if (hashmap->table != NULL && index < hashmap->tablesize)
+		entry = &hashmap->table[index];
+	else if (hashmap->oldtable != NULL && index - hashmap->tablesize < hashmap->oldtablesize)
+		entry = &hashmap->oldtable[index - hashmap->tablesize];
 
-	hashmap_iter_has_more (iter, collection, itercontext);
-	context->retrieved = TRUE;
+	if (entry == NULL || entry->hash == 0)
+		return NULL;
 
-	return;
+	return entry;
 }
 
-static void *hashmap_iter_get_data (VisCollectionIter *iter, VisCollection *collection, VisObject *itercontext)
+/* Returns the first slot from index on that holds an entry */
+static int hashmap_iter_seek (VisHashmap *hashmap, int index)
 {
-	HashmapIterContext *context = HASHMAP_ITERCONTEXT (itercontext);
-	VisHashmapChainEntry *mentry;
+	int end = hashmap->tablesize + hashmap->oldtablesize;
 
-	mentry = context->le->data;
+	if (hashmap->table == NULL)
+		return end;
 
-	return mentry->data;
+	for (; index < end; index++) {
+		if (hashmap_iter_slot (hashmap, index) != NULL)
+			break;
+	}
+
+	return index;
 }
 
 
 /* Thomas Wang's 32 bit Mix Function: http://www.concentric.net/~Ttwang/tech/inthash.htm */
-static int integer_hash (uint32_t key)
+static uint32_t integer_hash (uint32_t key)
 {
 	key += ~(key << 15);
 	key ^=  (key >> 10);
@@ -242,45 +237,256 @@ static int integer_hash (uint32_t key)
 	return key;
 }
 
-/* X31 HASH found in g_str_hash */
-static int string_hash (char *key)
+/* FNV-1a, finished with the integer mix so the low bits, which pick the
+ * slot, depend on every character */
+static uint32_t string_hash (const char *key)
 {
-	char *p;
-	int hash = 0;
+	const unsigned char *p;
+	uint32_t hash = 2166136261U;
 
-	for (p = key; *p != '\0'; p++)
-		hash = (hash << 5) - hash  + *p;
+	for (p = (const unsigned char *) key; *p != '\0'; p++) {
+		hash ^= *p;
+		hash *= 16777619U;
+	}
 
-	return hash;
+	return integer_hash (hash);
 }
 
-static int get_hash (VisHashmap *hashmap, void *key, VisHashmapKeyType keytype)
+/* Hash 0 marks empty slots and is never returned */
+static uint32_t get_hash (void *key, VisHashmapKeyType keytype)
 {
+	uint32_t hash = 0;
+
 	if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER)
-		return (integer_hash (*((uint32_t *) key)) % hashmap->tablesize);
+		hash = integer_hash (*((uint32_t *) key));
 	else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING)
-		return string_hash ((char *) key) % hashmap->tablesize;
+		hash = string_hash ((char *) key);
 
-	return 0;
+	return hash != 0 ? hash : 1;
 }
 
-static int create_table (VisHashmap *hashmap)
+static int key_equal (VisHashmapEntry *entry, uint32_t hash, void *key, VisHashmapKeyType keytype)
 {
-	int i;
+	if (entry->hash != hash || entry->keytype != keytype)
+		return FALSE;
+
+	if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER)
+		return entry->key.integer == *((uint32_t *) key);
+	else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING)
+		return strcmp (entry->key.string, (char *) key) == 0;
+
+	return FALSE;
+}
+
+/* Returns the slot of a key, or -1. The skip slots from start on have been
+ * emptied by migrate(), an entry whose home slot lies among them can only be
+ * found past them. */
+static int table_find (VisHashmapEntry *table, int tablesize, int start, int skip,
+		uint32_t hash, void *key, VisHashmapKeyType keytype)
+{
+	uint32_t mask = tablesize - 1;
+	uint32_t pos = hash & mask;
+	uint32_t dist = 0;
+	uint32_t offset = (pos - start) & mask;
+
+	if (offset < (uint32_t) skip) {
+		dist = skip - offset;
+		pos = (start + skip) & mask;
+	}
+
+	for (;;) {
+		VisHashmapEntry *entry = &table[pos];
 
-	hashmap->table = visual_mem_new0 (VisHashmapEntry, hashmap->tablesize);
+		if (entry->hash == 0)
+			return -1;
 
-	/* Initialize first entry */
-	visual_list_init (&hashmap->table[0].list, hashmap_list_entry_destroyer);
+		/* Robin Hood order: the key would have taken this slot */
+		if (((pos - entry->hash) & mask) < dist)
+			return -1;
 
-	/* Copy the entries to increase speed */
-	for (i = 1; i < hashmap->tablesize; i *= 2) {
-		int n = (i + i) > hashmap->tablesize ? hashmap->tablesize - i : i;
+		if (key_equal (entry, hash, key, keytype))
+			return pos;
 
-		visual_mem_copy (&hashmap->table[i], &hashmap->table[0], sizeof (VisHashmapEntry) * n);
+		pos = (pos + 1) & mask;
+		dist++;
+
+		if (dist > mask)
+			return -1;
 	}
+}
 
-	return VISUAL_OK;
+/* Stores an entry that is not in the table yet. Entries that are closer to
+ * their home slot give way to the one being inserted. */
+static void table_insert (VisHashmapEntry *table, int tablesize, VisHashmapEntry *entry)
+{
+	VisHashmapEntry carry = *entry;
+	uint32_t mask = tablesize - 1;
+	uint32_t pos = carry.hash & mask;
+	uint32_t dist = 0;
+
+	for (;;) {
+		VisHashmapEntry *slot = &table[pos];
+		uint32_t slotdist;
+
+		if (slot->hash == 0) {
+			*slot = carry;
+
+			return;
+		}
+
+		slotdist = (pos - slot->hash) & mask;
+
+		if (slotdist < dist) {
+			VisHashmapEntry tmp = *slot;
+
+			*slot = carry;
+			carry = tmp;
+			dist = slotdist;
+		}
+
+		pos = (pos + 1) & mask;
+		dist++;
+	}
+}
+
+/* Empties a slot and shifts the entries after it back, so no tombstones are needed */
+static void table_delete (VisHashmapEntry *table, int tablesize, int index)
+{
+	uint32_t mask = tablesize - 1;
+	uint32_t pos = index;
+
+	for (;;) {
+		uint32_t next = (pos + 1) & mask;
+		VisHashmapEntry *entry = &table[next];
+
+		if (entry->hash == 0 || ((next - entry->hash) & mask) == 0)
+			break;
+
+		table[pos] = *entry;
+		pos = next;
+	}
+
+	visual_mem_set (&table[pos], 0, sizeof (VisHashmapEntry));
+}
+
+static VisHashmapEntry *find_entry (VisHashmap *hashmap, uint32_t hash, void *key, VisHashmapKeyType keytype,
+		VisHashmapEntry **table, int *tablesize, int *index)
+{
+	int pos;
+
+	if (hashmap->table == NULL)
+		return NULL;
+
+	pos = table_find (hashmap->table, hashmap->tablesize, 0, 0, hash, key, keytype);
+
+	if (pos >= 0) {
+		*table = hashmap->table;
+		*tablesize = hashmap->tablesize;
+		*index = pos;
+
+		return &hashmap->table[pos];
+	}
+
+	if (hashmap->oldtable == NULL)
+		return NULL;
+
+	pos = table_find (hashmap->oldtable, hashmap->oldtablesize, hashmap->oldstart, hashmap->migrated,
+			hash, key, keytype);
+
+	if (pos >= 0) {
+		*table = hashmap->oldtable;
+		*tablesize = hashmap->oldtablesize;
+		*index = pos;
+
+		return &hashmap->oldtable[pos];
+	}
+
+	return NULL;
+}
+
+/* Smallest power of two table that holds capacity entries below the load limit */
+static int table_size_for (int capacity)
+{
+	int tablesize = VISUAL_HASHMAP_START_SIZE;
+
+	while (tablesize / HASHMAP_LOAD_DEN * HASHMAP_LOAD_NUM < capacity)
+		tablesize *= 2;
+
+	return tablesize;
+}
+
+/* Moves entries out of the old table, in slot order from oldstart on. That slot
+ * was empty, so no probe chain runs into it and emptying the slots after it
+ * keeps the entries that are left reachable, see table_find(). */
+static void migrate (VisHashmap *hashmap, int slots)
+{
+	while (hashmap->oldtable != NULL && slots-- > 0) {
+		int index = (hashmap->oldstart + hashmap->migrated) & (hashmap->oldtablesize - 1);
+		VisHashmapEntry *entry = &hashmap->oldtable[index];
+
+		if (entry->hash != 0) {
+			table_insert (hashmap->table, hashmap->tablesize, entry);
+
+			entry->hash = 0;
+		}
+
+		hashmap->migrated++;
+
+		if (hashmap->migrated == hashmap->oldtablesize) {
+			visual_mem_free (hashmap->oldtable);
+
+			hashmap->oldtable = NULL;
+			hashmap->oldtablesize = 0;
+			hashmap->oldstart = 0;
+			hashmap->migrated = 0;
+
+			/* Size set while the move was going on */
+			if (hashmap->pendingsize != 0) {
+				int tablesize = table_size_for (hashmap->size + 1);
+
+				if (tablesize < hashmap->pendingsize)
+					tablesize = hashmap->pendingsize;
+
+				hashmap->pendingsize = 0;
+
+				if (tablesize != hashmap->tablesize)
+					resize (hashmap, tablesize);
+			}
+		}
+	}
+}
+
+/* Starts using a new table, the entries follow through migrate(). Only one
+ * move runs at a time: every put moves enough slots for the old table to be
+ * empty before the new one fills up, and sizes set in the meantime wait for
+ * the move to end. */
+static void resize (VisHashmap *hashmap, int tablesize)
+{
+	if (hashmap->table != NULL && hashmap->size > 0) {
+		int room = tablesize / HASHMAP_LOAD_DEN * HASHMAP_LOAD_NUM - hashmap->size;
+		int start = 0;
+
+		/* The load limit leaves empty slots */
+		while (hashmap->table[start].hash != 0)
+			start++;
+
+		hashmap->oldtable = hashmap->table;
+		hashmap->oldtablesize = hashmap->tablesize;
+		hashmap->oldstart = start;
+		hashmap->migrated = 0;
+
+		if (room < 1)
+			room = 1;
+
+		hashmap->migratestep = (hashmap->oldtablesize + room - 1) / room;
+		if (hashmap->migratestep < HASHMAP_MIGRATE_STEP)
+			hashmap->migratestep = HASHMAP_MIGRATE_STEP;
+	} else if (hashmap->table != NULL) {
+		visual_mem_free (hashmap->table);
+	}
+
+	hashmap->tablesize = tablesize;
+	hashmap->table = visual_mem_new0 (VisHashmapEntry, tablesize);
 }
 
 VisHashmap *visual_hashmap_new (VisCollectionDestroyerFunc destroyer)
@@ -317,59 +523,58 @@ int visual_hashmap_init (VisHashmap *hashmap, VisCollectionDestroyerFunc destroy
 	hashmap->tablesize = VISUAL_HASHMAP_START_SIZE;
 	hashmap->size = 0;
 	hashmap->table = NULL;
+	hashmap->oldtable = NULL;
+	hashmap->oldtablesize = 0;
+	hashmap->oldstart = 0;
+	hashmap->migrated = 0;
+	hashmap->migratestep = HASHMAP_MIGRATE_STEP;
+	hashmap->pendingsize = 0;
 
 	return VISUAL_OK;
 }
 
 int visual_hashmap_put (VisHashmap *hashmap, void *key, VisHashmapKeyType keytype, void *data)
 {
-	VisHashmapChainEntry *mentry;
-	VisListEntry *le = NULL;
-	VisList *chain;
-	int hash;
+	VisHashmapEntry *entry;
+	VisHashmapEntry *table;
+	VisHashmapEntry newentry;
+	int tablesize;
+	int index;
+	uint32_t hash;
 
 	visual_return_val_if_fail (hashmap != NULL, -VISUAL_ERROR_HASHMAP_NULL);
+	visual_return_val_if_fail (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER ||
+			keytype == VISUAL_HASHMAP_KEY_TYPE_STRING, -VISUAL_ERROR_HASHMAP_INVALID_KEY_TYPE);
 
 	/* Create initial hashtable */
 	if (hashmap->table == NULL)
-		create_table (hashmap);
+		hashmap->table = visual_mem_new0 (VisHashmapEntry, hashmap->tablesize);
 
-	hash = get_hash (hashmap, key, keytype);
+	hash = get_hash (key, keytype);
 
-	chain = &hashmap->table[hash].list;
+	/* Key already in the map, replace the data */
+	entry = find_entry (hashmap, hash, key, keytype, &table, &tablesize, &index);
+	if (entry != NULL) {
+		entry->data = data;
 
-	/* Iterate list to check if the key is already in the chain */
-	if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER) {
-		while ((mentry = visual_list_next (chain, &le)) != NULL) {
-			if (mentry->keytype == keytype) {
-
-				if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER &&
-						mentry->key.integer != *((uint32_t *) key))
-					continue;
-				else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING &&
-						strcmp (mentry->key.string, (char *) key) != 0)
-					continue;
-
-				mentry->data = data;
-
-				return VISUAL_OK;
-			}
-		}
+		return VISUAL_OK;
 	}
 
-	/* Key not in chain, append at end */
-	mentry = visual_mem_new0 (VisHashmapChainEntry, 1);
+	if (hashmap->size + 1 > hashmap->tablesize / HASHMAP_LOAD_DEN * HASHMAP_LOAD_NUM)
+		resize (hashmap, hashmap->tablesize * 2);
 
-	mentry->keytype = keytype;
+	migrate (hashmap, hashmap->migratestep);
 
-	if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER)
-		mentry->key.integer = *((uint32_t *) key);
-	else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING)
-		mentry->key.string = visual_strdup ((char *) key);
+	newentry.hash = hash;
+	newentry.keytype = keytype;
+	newentry.data = data;
 
-	mentry->data = data;
+	if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER)
+		newentry.key.integer = *((uint32_t *) key);
+	else
+		newentry.key.string = visual_strdup ((char *) key);
 
-	visual_list_add (chain, mentry);
+	table_insert (hashmap->table, hashmap->tablesize, &newentry);
 
 	hashmap->size++;
 
@@ -389,47 +594,34 @@ int visual_hashmap_put_string (VisHashmap *hashmap, char *key, void *data)
 int visual_hashmap_remove (VisHashmap *hashmap, void *key, VisHashmapKeyType keytype, int destroy)
 {
 	VisCollectionDestroyerFunc destroyer;
-	VisHashmapChainEntry *mentry;
-	VisListEntry *le = NULL;
-	VisList *chain;
-	int hash;
+	VisHashmapEntry *entry;
+	VisHashmapEntry *table;
+	int tablesize;
+	int index;
 
 	visual_return_val_if_fail (hashmap != NULL, -VISUAL_ERROR_HASHMAP_NULL);
 
-	if (hashmap->table == NULL)
+	entry = find_entry (hashmap, get_hash (key, keytype), key, keytype, &table, &tablesize, &index);
+	if (entry == NULL)
 		return -VISUAL_ERROR_HASHMAP_NOT_IN_MAP;
 
-	hash = get_hash (hashmap, key, keytype);
-
-	chain = &hashmap->table[hash].list;
-
-	/* Iterate list to check if the key is in the chain */
-	while ((mentry = visual_list_next (chain, &le)) != NULL) {
-		if (mentry->keytype == keytype) {
+	if (destroy != FALSE) {
+		destroyer = visual_collection_get_destroyer (VISUAL_COLLECTION (hashmap));
 
-			if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER &&
-					mentry->key.integer != *((uint32_t *) key))
-				continue;
-			else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING &&
-					strcmp (mentry->key.string, (char *) key) != 0)
-				continue;
+		if (destroyer != NULL)
+			destroyer (entry->data);
+	}
 
-			if (destroy != FALSE) {
-				destroyer = visual_collection_get_destroyer (VISUAL_COLLECTION (hashmap));
+	if (entry->keytype == VISUAL_HASHMAP_KEY_TYPE_STRING)
+		visual_mem_free (entry->key.string);
 
-				destroyer (mentry->data);
-				visual_list_destroy (chain, &le);
-			} else {
-				visual_list_destroy (chain, &le);
-			}
+	table_delete (table, tablesize, index);
 
-			hashmap->size--;
+	hashmap->size--;
 
-			return VISUAL_OK;
-		}
-	}
+	migrate (hashmap, hashmap->migratestep);
 
-	return -VISUAL_ERROR_HASHMAP_NOT_IN_MAP;
+	return VISUAL_OK;
 }
 
 int visual_hashmap_remove_integer (VisHashmap *hashmap, uint32_t key, int destroy)
@@ -444,36 +636,18 @@ int visual_hashmap_remove_string (VisHashmap *hashmap, char *key, int destroy)
 
 void *visual_hashmap_get (VisHashmap *hashmap, void *key, VisHashmapKeyType keytype)
 {
-	VisHashmapChainEntry *mentry;
-	VisListEntry *le = NULL;
-	VisList *chain;
-	int hash;
+	VisHashmapEntry *entry;
+	VisHashmapEntry *table;
+	int tablesize;
+	int index;
 
 	visual_return_val_if_fail (hashmap != NULL, NULL);
 
-	/* Create initial hashtable */
-	if (hashmap->table == NULL)
+	entry = find_entry (hashmap, get_hash (key, keytype), key, keytype, &table, &tablesize, &index);
+	if (entry == NULL)
 		return NULL;
 
-	hash = get_hash (hashmap, key, keytype);
-
-	chain = &hashmap->table[hash].list;
-
-	/* Iterate list to check if the key is already in the chain */
-	while ((mentry = visual_list_next (chain, &le)) != NULL) {
-		if (mentry->keytype == keytype) {
-			if (keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER &&
-					mentry->key.integer != *((uint32_t *) key))
-				continue;
-			else if (keytype == VISUAL_HASHMAP_KEY_TYPE_STRING &&
-					strcmp (mentry->key.string, (char *) key) != 0)
-				continue;
-
-			return mentry->data;
-		}
-	}
-
-	return NULL;
+	return entry->data;
 }
 
 void *visual_hashmap_get_integer (VisHashmap *hashmap, uint32_t key)
@@ -486,44 +660,27 @@ void *visual_hashmap_get_string (VisHashmap *hashmap, char *key)
 	return visual_hashmap_get (hashmap, key, VISUAL_HASHMAP_KEY_TYPE_STRING);
 }
 
+/* The size is rounded up to a power of two, and to a table that can hold the
+ * entries that are in the map. A map that is not empty moves its entries over
+ * gradually, as it does when it grows by itself, and a size set while such a
+ * move is going on is used once it is done. */
 int visual_hashmap_set_table_size (VisHashmap *hashmap, int tablesize)
 {
-	visual_return_val_if_fail (hashmap != NULL, -VISUAL_ERROR_HASHMAP_NULL);
-
-	/* Table was not empty, rehash */
-	if (hashmap->table != NULL) {
-		VisHashmap tempmap;
-
-		visual_hashmap_init (&tempmap, NULL);
-
-		tempmap.table = hashmap->table;
-		tempmap.tablesize = hashmap->tablesize;
-		tempmap.size = hashmap->size;
-
-		VisCollectionIter *iter = visual_collection_get_iter (VISUAL_COLLECTION (hashmap));
-
-		hashmap->tablesize = tablesize;
-		create_table (hashmap);
-
-		/* Rehash all entries */
-		while (visual_collection_iter_has_more (iter) == TRUE) {
-			VisHashmapChainEntry *mentry = visual_collection_iter_get_data (iter);
-
-			if (mentry->keytype == VISUAL_HASHMAP_KEY_TYPE_INTEGER) {
-				visual_hashmap_put_integer (hashmap, mentry->key.integer, mentry->data);
+	int size;
 
-			} else if (mentry->keytype == VISUAL_HASHMAP_KEY_TYPE_STRING) {
-				visual_hashmap_put_string (hashmap, mentry->key.string, mentry->data);
-
-			}
-		}
-
-		/* Free old table */
-		visual_object_unref (VISUAL_OBJECT (&tempmap));
+	visual_return_val_if_fail (hashmap != NULL, -VISUAL_ERROR_HASHMAP_NULL);
 
-	} else {
-		hashmap->tablesize = tablesize;
-		create_table (hashmap);
+	size = table_size_for (hashmap->size + 1);
+	while (size < tablesize)
+		size *= 2;
+
+	if (hashmap->table == NULL) {
+		hashmap->tablesize = size;
+		hashmap->table = visual_mem_new0 (VisHashmapEntry, size);
+	} else if (hashmap->oldtable != NULL) {
+		hashmap->pendingsize = size;
+	} else if (size != hashmap->tablesize) {
+		resize (hashmap, size);
 	}
 
 	return VISUAL_OK;
@@ -536,4 +693,16 @@ int visual_hashmap_get_table_size (VisHashmap *hashmap)
 	return hashmap->tablesize;
 }
 
+int visual_hashmap_reserve (VisHashmap *hashmap, int capacity)
+{
+	visual_return_val_if_fail (hashmap != NULL, -VISUAL_ERROR_HASHMAP_NULL);
+
+	if (capacity < hashmap->size)
+		capacity = hashmap->size;
+
+	if (hashmap->table != NULL && table_size_for (capacity) <= hashmap->tablesize)
+		return VISUAL_OK;
+
+	return visual_hashmap_set_table_size (hashmap, table_size_for (capacity));
+}
 
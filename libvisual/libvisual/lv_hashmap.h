@@ -36,15 +36,13 @@
 
 VISUAL_BEGIN_DECLS
 
-#define VISUAL_HASHMAP_START_SIZE	1024
+#define VISUAL_HASHMAP_START_SIZE	16
 
 #define VISUAL_HASHMAP(obj)				(VISUAL_CHECK_CAST ((obj), VisHashmap))
 #define VISUAL_HASHMAPENTRY(obj)			(VISUAL_CHECK_CAST ((obj), VisHashmapEntry))
-#define VISUAL_HASHMAPCHAINENTRY(obj)			(VISUAL_CHECK_CAST ((obj), VisHashmapChainEntry))
 
 typedef struct _VisHashmap VisHashmap;
 typedef struct _VisHashmapEntry VisHashmapEntry;
-typedef struct _VisHashmapChainEntry VisHashmapChainEntry;
 
 typedef enum {
 	VISUAL_HASHMAP_KEY_TYPE_NONE		= 0,
@@ -54,27 +52,33 @@ typedef enum {
 
 /**
  * Using the VisHashmap structure you can store a collection of data within a hashmap.
+ *
+ * The entries are stored in the table itself, using Robin Hood linear probing. When the
+ * table fills up a table of twice the size is made, and the entries of the old table are
+ * moved over a few at a time by the following puts and removes, so no single call has to
+ * rehash the whole map.
  */
 struct _VisHashmap {
 	VisCollection		 collection;	/**< The VisCollection data. */
 
-	int			 tablesize;	/**< Size of the table array. */
+	int			 tablesize;	/**< Number of slots in the table, a power of two. */
 	int			 size;		/**< Number of entries stored in the VisHashmap. */
 
 	VisHashmapEntry		*table;		/**< The VisHashmap array. */
+
+	VisHashmapEntry		*oldtable;	/**< Table that is being moved into table, or NULL. */
+	int			 oldtablesize;	/**< Number of slots in oldtable. */
+	int			 oldstart;	/**< Empty slot of oldtable the move started at. */
+	int			 migrated;	/**< Slots of oldtable that have been moved, from oldstart on. */
+	int			 migratestep;	/**< Slots of oldtable moved by every put and remove. */
+	int			 pendingsize;	/**< Table size asked for while oldtable was being moved, or 0. */
 };
 
 /**
  * Private VisHashmap array entry.
  */
 struct _VisHashmapEntry {
-	VisList			 list;
-};
-
-/**
- * Private VisHashmap chain entry.
- */
-struct _VisHashmapChainEntry {
+	uint32_t		 hash;		/**< Hash of the key, 0 for an empty slot. */
 	VisHashmapKeyType	 keytype;
 
 	void			*data;
@@ -108,6 +112,17 @@ void *visual_hashmap_get_string (VisHashmap *hashmap, char *key);
 int visual_hashmap_set_table_size (VisHashmap *hashmap, int tablesize);
 int visual_hashmap_get_table_size (VisHashmap *hashmap);
 
+/**
+ * Makes room for a number of entries, so the VisHashmap does not have to grow
+ * before it holds that many.
+ *
+ * @param hashmap Pointer to the VisHashmap.
+ * @param capacity Number of entries to make room for.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_HASHMAP_NULL on failure.
+ */
+int visual_hashmap_reserve (VisHashmap *hashmap, int capacity);
+
 VISUAL_END_DECLS
 
 /**
@@ -163,7 +163,7 @@ int visual_input_set_callback (VisInput *input, VisInputUploadCallbackFunc callb
 	return VISUAL_OK;
 }
 
-int visual_input_run (VisInput *input)
+int visual_input_upload (VisInput *input)
 {
 	VisInputPlugin *inplugin;
 
@@ -182,6 +182,18 @@ int visual_input_run (VisInput *input)
 	} else
 		input->callback (input, input->audio, visual_object_get_private (VISUAL_OBJECT (input)));
 
+	return VISUAL_OK;
+}
+
+int visual_input_run (VisInput *input)
+{
+	int ret;
+
+	visual_return_val_if_fail (input != NULL, -VISUAL_ERROR_INPUT_NULL);
+
+	if ((ret = visual_input_upload (input)) != VISUAL_OK)
+		return ret;
+
 	visual_audio_analyze (input->audio);
 
 	return VISUAL_OK;
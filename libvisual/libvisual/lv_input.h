@@ -209,6 +209,17 @@ int visual_input_realize (VisInput *input);
  */
 int visual_input_set_callback (VisInput *input, VisInputUploadCallbackFunc callback, void *priv);
 
+/**
+ * Lets the plugin, or the callback, upload it's samples into the VisAudio of the VisInput,
+ * without analyzing them. This can run on an input thread, with visual_audio_analyze being
+ * called from the render thread.
+ *
+ * @param input A pointer to a VisInput that needs to upload samples.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_INPUT_NULL or -VISUAL_ERROR_INPUT_PLUGIN_NULL on failure.
+ */
+int visual_input_upload (VisInput *input);
+
 /**
  * This is called to run a VisInput. This function will call the plugin to upload it's samples and run it
  * through the visual_audio_analyze function. If a callback is set it will use the callback instead of
@@ -33,6 +33,9 @@
 #include "lv_thread.h"
 #include "lv_cpu.h"
 #include "lv_util.h"
+#include "lv_video_pool.h"
+#include "private/lv_thread_pool.h"
+#include "private/lv_video_simd.h"
 
 #include "gettext.h"
 
@@ -143,10 +146,17 @@ int visual_init (int *argc, char ***argv)
 
 	/* Initialize CPU-accelerated graphics functions */
 	visual_alpha_blend_initialize ();
+	_lv_video_simd_initialize ();
 
 	/* Initialize Thread system */
 	visual_thread_initialize ();
 
+	/* Initialize the worker threads used by the VisVideo routines */
+	_lv_thread_pool_initialize ();
+
+	/* Initialize the pool the VisVideo buffers come from */
+	visual_video_pool_initialize ();
+
 	/* Initialize FFT system */
 	visual_fourier_initialize ();
 
@@ -181,6 +191,10 @@ int visual_quit ()
 
 	visual_plugin_registry_deinitialize ();
 
+	_lv_thread_pool_deinitialize ();
+
+	visual_video_pool_deinitialize ();
+
 	ret = visual_object_unref (VISUAL_OBJECT (__lv_paramcontainer));
 	if (ret < 0)
 		visual_log (VISUAL_LOG_WARNING, _("Global param container: destroy failed: %s"), visual_error_to_string (ret));
@@ -28,6 +28,15 @@
 #include "lv_cpu.h"
 #include <math.h>
 
+/* The SSE assembly below keeps values in xmm registers across asm statements
+ * without declaring them, which is only safe on 32 bits x86 where the compiler
+ * doesn't use these registers itself. */
+#if defined(VISUAL_ARCH_X86)
+#define MATH_SSE_ASM_ENABLED()	visual_cpu_get_sse ()
+#else
+#define MATH_SSE_ASM_ENABLED()	FALSE
+#endif
+
 /* This file is getting big and bloated because of the large chunks of simd code. When all is in place we'll take a serious
  * look how we can reduce this. For example by using macros for common blocks. */
 
@@ -67,7 +76,7 @@ int visual_math_vectorized_multiplier_floats_const_float (float *dest, float *sr
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
 	/* FIXME check what is faster on AMD (sse or 3dnow) */
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		float packed_multiplier[4];
 
 		packed_multiplier[0] = multiplier;
@@ -178,7 +187,7 @@ int visual_math_vectorized_add_floats_const_float (float *dest, float *src, visu
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		float packed_adder[4];
 
 		packed_adder[0] = adder;
@@ -289,7 +298,7 @@ int visual_math_vectorized_substract_floats_const_float (float *dest, float *src
 	visual_return_val_if_fail (src != NULL, -VISUAL_ERROR_NULL);
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		float packed_substracter[4];
 
 		packed_substracter[0] = substracter;
@@ -403,7 +412,7 @@ int visual_math_vectorized_multiplier_floats_floats (float *dest, float *src1, f
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		while (!VISUAL_ALIGNED(d, 16)) {
 			(*d) = (*s1) * (*s2);
 
@@ -806,7 +815,7 @@ int visual_math_vectorized_sqrt_floats (float *dest, float *src, visual_size_t n
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		while (!VISUAL_ALIGNED(d, 16)) {
 			*d = sqrtf (*s);
 
@@ -862,7 +871,7 @@ int visual_math_vectorized_complex_to_norm (float *dest, float *real, float *ima
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 
 		while (!VISUAL_ALIGNED(d, 16)) {
 			*d = sqrtf (((*r) * (*r)) + ((*i) * (*i)));
@@ -927,7 +936,7 @@ int visual_math_vectorized_complex_to_norm_scale (float *dest, float *real, floa
 
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
 
-	if (visual_cpu_get_sse () && n >= 16) {
+	if (MATH_SSE_ASM_ENABLED () && n >= 16) {
 		float packed_scaler[4];
 
 		packed_scaler[0] = scaler;
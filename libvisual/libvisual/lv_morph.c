@@ -25,6 +25,7 @@
 #include "lv_morph.h"
 #include "lv_common.h"
 #include "gettext.h"
+#include "private/lv_timing_hooks.h"
 
 extern VisList *__lv_plugins_morph;
 
@@ -41,7 +42,11 @@ static int morph_dtor (VisObject *object)
 
 	visual_palette_free_colors (&morph->morphpal);
 
+	if (morph->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (morph->timing));
+
 	morph->plugin = NULL;
+	morph->timing = NULL;
 
 	return VISUAL_OK;
 }
@@ -126,6 +131,7 @@ int visual_morph_init (VisMorph *morph, const char *morphname)
 	/* Reset the VisMorph data */
 	morph->plugin = NULL;
 	morph->dest = NULL;
+	morph->timing = NULL;
 	visual_palette_init (&morph->morphpal);
 	visual_time_init (&morph->morphtime);
 	visual_timer_init (&morph->timer);
@@ -282,11 +288,30 @@ int visual_morph_requests_audio (VisMorph *morph)
 	return morphplugin->requests_audio;
 }
 
+int visual_morph_set_timing (VisMorph *morph, VisTiming *timing)
+{
+	visual_return_val_if_fail (morph != NULL, -VISUAL_ERROR_MORPH_NULL);
+
+	if (morph->timing == timing)
+		return VISUAL_OK;
+
+	if (timing != NULL)
+		visual_object_ref (VISUAL_OBJECT (timing));
+
+	if (morph->timing != NULL)
+		visual_object_unref (VISUAL_OBJECT (morph->timing));
+
+	morph->timing = timing;
+
+	return VISUAL_OK;
+}
+
 int visual_morph_run (VisMorph *morph, VisAudio *audio, VisVideo *src1, VisVideo *src2)
 {
 	VisMorphPlugin *morphplugin;
 	VisTime elapsed;
 	double usec_elapsed, usec_morph;
+	_LV_TIMING_DECLARE (begin);
 
 	visual_return_val_if_fail (morph != NULL, -VISUAL_ERROR_MORPH_NULL);
 	visual_return_val_if_fail (audio != NULL, -VISUAL_ERROR_AUDIO_NULL);
@@ -302,6 +327,8 @@ int visual_morph_run (VisMorph *morph, VisAudio *audio, VisVideo *src1, VisVideo
 		return -VISUAL_ERROR_MORPH_PLUGIN_NULL;
 	}
 
+	_LV_TIMING_BEGIN (morph->timing, begin);
+
 	/* If we're morphing using the timer, start the timer. */
 	if (visual_timer_is_active (&morph->timer) == FALSE)
 		visual_timer_start (&morph->timer);
@@ -317,6 +344,8 @@ int visual_morph_run (VisMorph *morph, VisAudio *audio, VisVideo *src1, VisVideo
 
 	morph->dest->pal = visual_morph_get_palette (morph);
 
+	_LV_TIMING_END (morph->timing, begin, VISUAL_TIMING_STAGE_MORPH, VISUAL_TIMING_TRACK_MORPH);
+
 	/* On automatic morphing increase the rate. */
 	if (morph->mode == VISUAL_MORPH_MODE_STEPS) {
 		morph->rate += (1.000 / morph->steps);
@@ -29,6 +29,7 @@
 #include <libvisual/lv_list.h>
 #include <libvisual/lv_video.h>
 #include <libvisual/lv_time.h>
+#include <libvisual/lv_timing.h>
 
 /**
  * @defgroup VisMorph VisMorph
@@ -126,6 +127,8 @@ struct _VisMorph {
 	int		 stepsdone;	/**< Private entry that contains the number of steps done. */
 
 	VisMorphMode	 mode;		/**< Private entry that holds the mode of morphing. */
+
+	VisTiming	*timing;	/**< Private entry in which visual_morph_run is recorded. */
 };
 
 /**
@@ -330,6 +333,18 @@ int visual_morph_is_done (VisMorph *morph);
  */
 int visual_morph_requests_audio (VisMorph *morph);
 
+/**
+ * Records how long visual_morph_run takes. A VisBin sets this on its morph itself.
+ *
+ * @see visual_bin_set_timing
+ *
+ * @param morph Pointer to a VisMorph of which the runs are recorded.
+ * @param timing Pointer to the VisTiming to record in, or NULL to stop recording.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_MORPH_NULL on failure.
+ */
+int visual_morph_set_timing (VisMorph *morph, VisTiming *timing);
+
 /**
  * This is called to run the VisMorph. It will put the result in the buffer that is previously
  * set by visual_morph_set_video and also when the morph is being runned in 8 bits mode
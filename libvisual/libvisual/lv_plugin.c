@@ -29,6 +29,8 @@
 #include "lv_libvisual.h"
 #include "lv_util.h"
 #include "gettext.h"
+#include "private/lv_plugin_cache.h"
+#include "private/lv_thread_pool.h"
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
@@ -40,13 +42,34 @@
 #endif
 
 extern VisList *__lv_plugins;
+extern VisMutex *__lv_plugin_fill_lock;
+extern VisMutex *__lv_plugin_info_lock;
+
+/* A plugin file found while building the registry */
+typedef struct {
+	char		 *file;
+	VisPluginRef	**refs;
+	int		  count;
+} PluginScanItem;
+
+typedef struct {
+	PluginScanItem	 *items;
+	int		  count;
+	int		  allocated;
+
+	int		 *pending;	/* Items that were not in the cache */
+} PluginScan;
+
+static int __lv_plugin_lazy_info = FALSE;
 
 static int plugin_info_dtor (VisObject *object);
 static int plugin_ref_dtor (VisObject *object);
 static int plugin_environ_dtor (VisObject *object);
 static int plugin_dtor (VisObject *object);
 
-static int plugin_add_dir_to_list (VisList *list, const char *dir);
+static int plugin_scan_dir (PluginScan *scan, const char *dir);
+static void plugin_scan_add (PluginScan *scan, const char *file);
+static void plugin_scan_item (void *data, int index);
 static char *get_delim_node (const char *str, char delim, int index);
 
 static int plugin_info_dtor (VisObject *object)
@@ -177,6 +200,7 @@ int visual_plugin_info_copy (VisPluginInfo *dest, VisPluginInfo *src)
 	dest->version = visual_strdup (src->version);
 	dest->about = visual_strdup (src->about);
 	dest->help = visual_strdup (src->help);
+	dest->license = src->license != NULL ? visual_strdup (src->license) : NULL;
 
 	return VISUAL_OK;
 }
@@ -246,6 +270,57 @@ VisPluginRef *visual_plugin_ref_new ()
 	return ref;
 }
 
+VisPluginInfo *visual_plugin_ref_get_info (VisPluginRef *ref)
+{
+	VisPluginRef **refs;
+	VisPluginInfo *info;
+	int count = 0;
+	int i;
+
+	visual_return_val_if_fail (ref != NULL, NULL);
+
+	/* Other threads wait for the fill, and see lazy drop only once it is done */
+	if (__lv_plugin_fill_lock != NULL)
+		visual_mutex_lock (__lv_plugin_fill_lock);
+
+	if (ref->lazy == FALSE) {
+		if (__lv_plugin_fill_lock != NULL)
+			visual_mutex_unlock (__lv_plugin_fill_lock);
+
+		return ref->info;
+	}
+
+	refs = visual_plugin_get_references (ref->file, &count);
+
+	if (refs != NULL && ref->index < count) {
+		info = refs[ref->index]->info;
+
+		/* The info destructor does not free the strings, so they can be taken over */
+		ref->info->name = info->name;
+		ref->info->author = info->author;
+		ref->info->version = info->version;
+		ref->info->about = info->about;
+		ref->info->help = info->help;
+		ref->info->license = info->license;
+	}
+
+	/* Only tried once, a plugin that fails now keeps the fields NULL */
+	ref->lazy = FALSE;
+
+	if (__lv_plugin_fill_lock != NULL)
+		visual_mutex_unlock (__lv_plugin_fill_lock);
+
+	if (refs == NULL)
+		return ref->info;
+
+	for (i = 0; i < count; i++)
+		visual_object_unref (VISUAL_OBJECT (refs[i]));
+
+	visual_mem_free (refs);
+
+	return ref->info;
+}
+
 VisPluginData *visual_plugin_new ()
 {
 	VisPluginData *plugin;
@@ -352,13 +427,10 @@ const char *visual_plugin_get_prev_by_name (VisList *list, const char *name)
 	return NULL;
 }
 
-static int plugin_add_dir_to_list (VisList *list, const char *dir)
+static int plugin_scan_dir (PluginScan *scan, const char *dir)
 {
-	VisPluginRef **ref;
 	char temp[FILENAME_MAX];
-	int i;
 	size_t len;
-	int cnt = 0;
 
 #if defined(VISUAL_OS_WIN32)
 	BOOL fFinished;
@@ -380,22 +452,12 @@ static int plugin_add_dir_to_list (VisList *list, const char *dir)
 	fFinished = FALSE;
 
 	while (!fFinished) {
-		ref = NULL;
-
 		if (!(FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
 			snprintf (temp, 1023, "%s/%s", dir, FileData.cFileName);
 			len = strlen (temp);
 
 			if (len > 5 && (strncmp (&temp[len - 4], ".dll", 4) == 0))
-				ref = visual_plugin_get_references (temp, &cnt);
-
-			if (ref != NULL) {
-				for (i = 0; i < cnt; i++)
-					visual_list_add (list, ref[i]);
-
-				/* This is the pointer pointer pointer, not a ref itself */
-				visual_mem_free (ref);
-			}
+				plugin_scan_add (scan, temp);
 		}
 
 		if (!FindNextFile (hList, &FileData)) {
@@ -408,7 +470,7 @@ static int plugin_add_dir_to_list (VisList *list, const char *dir)
 	FindClose (hList);
 #else
 	struct dirent **namelist;
-	int j, n;
+	int i, n;
 
 	n = scandir (dir, &namelist, NULL, alphasort);
 
@@ -422,21 +484,11 @@ static int plugin_add_dir_to_list (VisList *list, const char *dir)
 	visual_mem_set (temp, 0, sizeof (temp));
 
 	for (i = 2; i < n; i++) {
-		ref = NULL;
-
 		snprintf (temp, 1023, "%s/%s", dir, namelist[i]->d_name);
 
 		len = strlen (temp);
 		if (len > 3 && (strncmp (&temp[len - 3], ".so", 3) == 0))
-			ref = visual_plugin_get_references (temp, &cnt);
-
-		if (ref != NULL) {
-			for (j = 0; j < cnt; j++)
-				visual_list_add (list, ref[j]);
-
-			/* This is the pointer pointer pointer, not a ref itself */
-			visual_mem_free (ref);
-		}
+			plugin_scan_add (scan, temp);
 
 		visual_mem_free (namelist[i]);
 	}
@@ -447,6 +499,31 @@ static int plugin_add_dir_to_list (VisList *list, const char *dir)
 	return 0;
 }
 
+static void plugin_scan_add (PluginScan *scan, const char *file)
+{
+	PluginScanItem *item;
+
+	if (scan->count == scan->allocated) {
+		scan->allocated = scan->allocated > 0 ? scan->allocated * 2 : 64;
+		scan->items = visual_mem_realloc (scan->items, scan->allocated * sizeof (PluginScanItem));
+	}
+
+	item = &scan->items[scan->count++];
+
+	item->file = visual_strdup (file);
+	item->refs = NULL;
+	item->count = 0;
+}
+
+/* Runs on the thread pool, items only touch their own slot */
+static void plugin_scan_item (void *data, int index)
+{
+	PluginScan *scan = data;
+	PluginScanItem *item = &scan->items[scan->pending[index]];
+
+	item->refs = visual_plugin_get_references (item->file, &item->count);
+}
+
 int visual_plugin_unload (VisPluginData *plugin)
 {
 	VisPluginRef *ref;
@@ -552,8 +629,14 @@ VisPluginData *visual_plugin_load (VisPluginRef *ref)
 		return NULL;
 	}
 
+	if (__lv_plugin_info_lock != NULL)
+		visual_mutex_lock (__lv_plugin_info_lock);
+
 	pluginfo = VISUAL_PLUGININFO (get_plugin_info (&cnt));
 
+	if (__lv_plugin_info_lock != NULL)
+		visual_mutex_unlock (__lv_plugin_info_lock);
+
 	if (pluginfo == NULL) {
 		visual_log (VISUAL_LOG_ERROR, _("Cannot get plugin info while loading."));
 
@@ -671,9 +754,16 @@ VisPluginRef **visual_plugin_get_references (const char *pluginpath, int *count)
 		return NULL;
 	}
 
+	/* Plugins are opened in parallel, but their info is asked one at a time */
+	if (__lv_plugin_info_lock != NULL)
+		visual_mutex_lock (__lv_plugin_info_lock);
+
 	plug_info = VISUAL_PLUGININFO (get_plugin_info (&cnt));
 
 	if (plug_info == NULL) {
+		if (__lv_plugin_info_lock != NULL)
+			visual_mutex_unlock (__lv_plugin_info_lock);
+
 		visual_log (VISUAL_LOG_ERROR, _("Cannot get plugin info"));
 
 #if defined(VISUAL_OS_WIN32)
@@ -701,6 +791,9 @@ VisPluginRef **visual_plugin_get_references (const char *pluginpath, int *count)
 		visual_object_unref (VISUAL_OBJECT (&plug_info[i]));
 	}
 
+	if (__lv_plugin_info_lock != NULL)
+		visual_mutex_unlock (__lv_plugin_info_lock);
+
 #if defined(VISUAL_OS_WIN32)
 	FreeLibrary (handle);
 #else
@@ -715,22 +808,91 @@ VisPluginRef **visual_plugin_get_references (const char *pluginpath, int *count)
 VisList *visual_plugin_get_list (const char **paths, int ignore_non_existing)
 {
 	VisList *list;
-	int i = 0;
+	LVPluginCache *cache;
+	PluginScan scan;
+	PluginScanItem *item;
+	int npending = 0;
+	int i, j;
 
 	list = visual_list_new (visual_object_collection_destroyer);
 
-	while (paths[i] != NULL) {
-		if (plugin_add_dir_to_list (list, paths[i]) < 0) {
+	visual_mem_set (&scan, 0, sizeof (PluginScan));
+
+	for (i = 0; paths[i] != NULL; i++) {
+		if (plugin_scan_dir (&scan, paths[i]) < 0) {
 			if (ignore_non_existing == FALSE)
 				visual_log (VISUAL_LOG_WARNING, _("Failed to add the %s directory to the plugin registry"), paths[i]);
 		}
+	}
 
-		i++;
+	cache = _lv_plugin_cache_open ();
+
+	/* Opening a plugin mostly waits for the disk, so the ones that are not
+	 * in the cache are opened on the thread pool */
+	scan.pending = visual_mem_new0 (int, scan.count + 1);
+
+	for (i = 0; i < scan.count; i++) {
+		item = &scan.items[i];
+		item->refs = _lv_plugin_cache_lookup (cache, item->file, &item->count, __lv_plugin_lazy_info);
+
+		if (item->refs == NULL)
+			scan.pending[npending++] = i;
+	}
+
+	/* The get_plugin_info calls are only serialized when there is a lock */
+	if (__lv_plugin_info_lock != NULL) {
+		_lv_thread_pool_run (npending, plugin_scan_item, &scan);
+	} else {
+		for (i = 0; i < npending; i++)
+			plugin_scan_item (&scan, i);
+	}
+
+	/* Only the plugins that were opened are new to the cache, and they have
+	 * their full info */
+	for (i = 0; i < npending; i++) {
+		item = &scan.items[scan.pending[i]];
+
+		if (item->refs != NULL)
+			_lv_plugin_cache_store (cache, item->file, item->refs, item->count);
+	}
+
+	/* Add them in the order they were found */
+	for (i = 0; i < scan.count; i++) {
+		item = &scan.items[i];
+
+		if (item->refs != NULL) {
+			for (j = 0; j < item->count; j++)
+				visual_list_add (list, item->refs[j]);
+
+			/* This is the pointer pointer pointer, not a ref itself */
+			visual_mem_free (item->refs);
+		}
+
+		visual_mem_free (item->file);
 	}
 
+	_lv_plugin_cache_close (cache);
+
+	visual_mem_free (scan.pending);
+
+	if (scan.items != NULL)
+		visual_mem_free (scan.items);
+
 	return list;
 }
 
+int visual_plugin_set_lazy_info (int lazy)
+{
+	__lv_plugin_lazy_info = lazy;
+
+	return VISUAL_OK;
+}
+
+int visual_plugin_get_lazy_info ()
+{
+	return __lv_plugin_lazy_info;
+}
+
 VisPluginRef *visual_plugin_find (VisList *list, const char *name)
 {
 	VisListEntry *entry = NULL;
@@ -123,6 +123,9 @@ typedef struct _VisPluginEnviron VisPluginEnviron;
  * 'get_plugin_info' function provides libvisual plugin data and all the detailed information regarding
  * the plugin. This function is compulsory without it libvisual won't load the plugin.
  *
+ * Plugins are opened on several threads while the registry is built, but libvisual never
+ * calls 'get_plugin_info' of two plugins at the same time, so it does not need to be thread safe.
+ *
  * @arg count An int pointer in which the number of VisPluginData entries within the plugin. Plugins can have
  * 	multiple 'features' and thus the count is needed.
  *
@@ -174,6 +177,7 @@ struct _VisPluginRef {
 	int            index;       /**< Contains the index number for the entry in the VisPluginInfo table. */
 	int            usecount;    /**< The use count, this indicates how many instances are loaded. */
 	VisPluginInfo *info;        /**< A copy of the VisPluginInfo structure. */
+	int            lazy;        /**< Only type, plugname and flags are in info yet, see visual_plugin_ref_get_info(). */
 };
 
 /**
@@ -330,6 +334,19 @@ void *visual_plugin_get_specific (VisPluginData *plugin);
  */
 VisPluginRef *visual_plugin_ref_new (void);
 
+/**
+ * Gives the VisPluginInfo of a VisPluginRef. When the reference is lazy, the
+ * fields other than type, plugname and flags are filled in first, which opens
+ * the plugin.
+ *
+ * @see visual_plugin_set_lazy_info
+ *
+ * @param ref Pointer to the VisPluginRef.
+ *
+ * @return The VisPluginInfo of the reference, or NULL on failure.
+ */
+VisPluginInfo *visual_plugin_ref_get_info (VisPluginRef *ref);
+
 /**
  * Creates a new VisPluginData structure.
  *
@@ -429,6 +446,8 @@ VisPluginRef **visual_plugin_get_references (const char *pluginpath, int *count)
 
 /**
  * Private function to create the complete plugin registry from a set of paths.
+ * The plugins that are not in the registry cache are opened concurrently, the
+ * references are in the order of the paths and file names either way.
  *
  * @param paths A pointer list to a set of paths.
  * @param ignore_non_existing A flag that can be set with TRUE or FALSE to ignore non existing dirs.
@@ -437,6 +456,25 @@ VisPluginRef **visual_plugin_get_references (const char *pluginpath, int *count)
  */
 VisList *visual_plugin_get_list (const char **paths, int ignore_non_existing);
 
+/**
+ * Sets whether visual_plugin_get_list() creates lazy references. Lazy references
+ * that come from the plugin registry cache only carry the type, plugname and flags,
+ * the rest of the info is filled in by visual_plugin_ref_get_info() when needed.
+ * Call this before visual_init() for it to affect the registry.
+ *
+ * @param lazy TRUE to create lazy references, FALSE to fill in all of the info.
+ *
+ * @return VISUAL_OK.
+ */
+int visual_plugin_set_lazy_info (int lazy);
+
+/**
+ * Gives whether visual_plugin_get_list() creates lazy references.
+ *
+ * @return TRUE or FALSE.
+ */
+int visual_plugin_get_lazy_info (void);
+
 /**
  * Get the type part from a plugin type string.
  *
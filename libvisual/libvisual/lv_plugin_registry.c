@@ -26,6 +26,12 @@ VisList *__lv_plugins_morph = NULL;
 /* Contains all the transform plugins after initialize. */
 VisList *__lv_plugins_transform = NULL;
 
+/* Serializes the lazy info fills of the plugin references, see lv_plugin.c. */
+VisMutex *__lv_plugin_fill_lock = NULL;
+
+/* Serializes the get_plugin_info calls of the plugins, see lv_plugin.c. */
+VisMutex *__lv_plugin_info_lock = NULL;
+
 /* Contains the number of plugin registry paths. */
 int __lv_plugpath_cnt = 0;
 /* char ** list of all the plugin paths. */
@@ -116,6 +122,12 @@ int visual_plugin_registry_initialize (void)
 	ret = visual_init_path_add (NULL);
 	visual_return_val_if_fail (ret == VISUAL_OK, ret);
 
+	/* Without threads there is nothing to serialize */
+	if (visual_thread_is_supported () == TRUE && visual_thread_is_enabled () == TRUE) {
+		__lv_plugin_fill_lock = visual_mutex_new ();
+		__lv_plugin_info_lock = visual_mutex_new ();
+	}
+
 	__lv_plugins = visual_plugin_get_list ((const char**)__lv_plugpaths, TRUE);
 	visual_return_val_if_fail (__lv_plugins != NULL, -VISUAL_ERROR_LIBVISUAL_NO_REGISTRY);
 
@@ -154,5 +166,14 @@ int visual_plugin_registry_deinitialize (void)
 	if (ret < 0)
 		visual_log (VISUAL_LOG_WARNING, _("Transform plugins list: destroy failed: %s"), visual_error_to_string (ret));
 
+	if (__lv_plugin_fill_lock != NULL)
+		visual_mutex_free (__lv_plugin_fill_lock);
+
+	if (__lv_plugin_info_lock != NULL)
+		visual_mutex_free (__lv_plugin_info_lock);
+
+	__lv_plugin_fill_lock = NULL;
+	__lv_plugin_info_lock = NULL;
+
 	return  VISUAL_OK;
 }
@@ -24,6 +24,7 @@
 #include "config.h"
 #include "lv_thread.h"
 #include "lv_common.h"
+#include "private/lv_thread_pool.h"
 #include "gettext.h"
 
 #if defined(VISUAL_OS_WIN32)
@@ -53,6 +54,12 @@ typedef int (*MutexFuncLock)(VisMutex *mutex);
 typedef int (*MutexFuncTrylock)(VisMutex *mutex);
 typedef int (*MutexFuncUnlock)(VisMutex *mutex);
 
+typedef VisCond *(*CondFuncNew)(void);
+typedef int (*CondFuncFree)(VisCond *cond);
+typedef int (*CondFuncWait)(VisCond *cond, VisMutex *mutex);
+typedef int (*CondFuncSignal)(VisCond *cond);
+typedef int (*CondFuncBroadcast)(VisCond *cond);
+
 struct _ThreadFuncs {
 	ThreadFuncCreate	thread_create;
 	ThreadFuncFree		thread_free;
@@ -66,6 +73,12 @@ struct _ThreadFuncs {
 	MutexFuncLock		mutex_lock;
 	MutexFuncTrylock	mutex_trylock;
 	MutexFuncUnlock		mutex_unlock;
+
+	CondFuncNew		cond_new;
+	CondFuncFree		cond_free;
+	CondFuncWait		cond_wait;
+	CondFuncSignal		cond_signal;
+	CondFuncBroadcast	cond_broadcast;
 };
 
 /* Internal variables */
@@ -88,6 +101,12 @@ static int mutex_init_posix (VisMutex *mutex);
 static int mutex_lock_posix (VisMutex *mutex);
 static int mutex_trylock_posix (VisMutex *mutex);
 static int mutex_unlock_posix (VisMutex *mutex);
+
+static VisCond *cond_new_posix (void);
+static int cond_free_posix (VisCond *cond);
+static int cond_wait_posix (VisCond *cond, VisMutex *mutex);
+static int cond_signal_posix (VisCond *cond);
+static int cond_broadcast_posix (VisCond *cond);
 #endif
 
 /* Windows32 implementation */
@@ -104,6 +123,12 @@ static int mutex_init_win32 (VisMutex *mutex);
 static int mutex_lock_win32 (VisMutex *mutex);
 static int mutex_trylock_win32 (VisMutex *mutex);
 static int mutex_unlock_win32 (VisMutex *mutex);
+
+static VisCond *cond_new_win32 (void);
+static int cond_free_win32 (VisCond *cond);
+static int cond_wait_win32 (VisCond *cond, VisMutex *mutex);
+static int cond_signal_win32 (VisCond *cond);
+static int cond_broadcast_win32 (VisCond *cond);
 #endif
 
 /* GThread implementation */
@@ -120,6 +145,12 @@ static int mutex_init_gthread (VisMutex *mutex);
 static int mutex_lock_gthread (VisMutex *mutex);
 static int mutex_trylock_gthread (VisMutex *mutex);
 static int mutex_unlock_gthread (VisMutex *mutex);
+
+static VisCond *cond_new_gthread (void);
+static int cond_free_gthread (VisCond *cond);
+static int cond_wait_gthread (VisCond *cond, VisMutex *mutex);
+static int cond_signal_gthread (VisCond *cond);
+static int cond_broadcast_gthread (VisCond *cond);
 #endif
 
 int visual_thread_initialize ()
@@ -144,6 +175,12 @@ int visual_thread_initialize ()
 	__lv_thread_funcs.mutex_trylock = mutex_trylock_posix;
 	__lv_thread_funcs.mutex_unlock = mutex_unlock_posix;
 
+	__lv_thread_funcs.cond_new = cond_new_posix;
+	__lv_thread_funcs.cond_free = cond_free_posix;
+	__lv_thread_funcs.cond_wait = cond_wait_posix;
+	__lv_thread_funcs.cond_signal = cond_signal_posix;
+	__lv_thread_funcs.cond_broadcast = cond_broadcast_posix;
+
 	return TRUE;
 #elif defined(VISUAL_THREAD_MODEL_WIN32) /* !VISUAL_THREAD_MODEL_POSIX */
 	__lv_thread_supported = TRUE;
@@ -161,6 +198,12 @@ int visual_thread_initialize ()
 	__lv_thread_funcs.mutex_trylock = mutex_trylock_win32;
 	__lv_thread_funcs.mutex_unlock = mutex_unlock_win32;
 
+	__lv_thread_funcs.cond_new = cond_new_win32;
+	__lv_thread_funcs.cond_free = cond_free_win32;
+	__lv_thread_funcs.cond_wait = cond_wait_win32;
+	__lv_thread_funcs.cond_signal = cond_signal_win32;
+	__lv_thread_funcs.cond_broadcast = cond_broadcast_win32;
+
 	return TRUE;
 #elif defined(VISUAL_THREAD_MODEL_GTHREAD2) /* !VISUAL_THREAD_MODEL_WIN32 */
 	__lv_thread_supported = TRUE;
@@ -178,6 +221,12 @@ int visual_thread_initialize ()
 	__lv_thread_funcs.mutex_trylock = mutex_trylock_gthread;
 	__lv_thread_funcs.mutex_unlock = mutex_unlock_gthread;
 
+	__lv_thread_funcs.cond_new = cond_new_gthread;
+	__lv_thread_funcs.cond_free = cond_free_gthread;
+	__lv_thread_funcs.cond_wait = cond_wait_gthread;
+	__lv_thread_funcs.cond_signal = cond_signal_gthread;
+	__lv_thread_funcs.cond_broadcast = cond_broadcast_gthread;
+
 	return TRUE;
 #else /* !VISUAL_THREAD_MODEL_GTHREAD2 */
 	return FALSE;
@@ -235,7 +284,6 @@ void *visual_thread_join (VisThread *thread)
 
 	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, NULL);
 	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, NULL);
-	visual_return_val_if_fail (visual_thread_is_enabled () != FALSE, NULL);
 
 	return __lv_thread_funcs.thread_join (thread);
 }
@@ -258,6 +306,21 @@ void visual_thread_yield ()
 	__lv_thread_funcs.thread_yield ();
 }
 
+void visual_thread_run_parallel (int count, VisThreadParallelFunc func, void *data)
+{
+	visual_return_if_fail (func != NULL);
+
+	_lv_thread_pool_run (count, func, data);
+}
+
+int visual_thread_get_parallelism ()
+{
+	if (visual_thread_is_enabled () == FALSE)
+		return 1;
+
+	return _lv_thread_pool_get_threads ();
+}
+
 VisMutex *visual_mutex_new ()
 {
 	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, NULL);
@@ -297,7 +360,6 @@ int visual_mutex_lock (VisMutex *mutex)
 
 	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
 	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
-	visual_return_val_if_fail (visual_thread_is_enabled () != FALSE, -VISUAL_ERROR_THREAD_NOT_ENABLED);
 
 	return __lv_thread_funcs.mutex_lock (mutex);
 }
@@ -308,7 +370,6 @@ int visual_mutex_trylock (VisMutex *mutex)
 
 	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
 	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
-	visual_return_val_if_fail (visual_thread_is_enabled () != FALSE, -VISUAL_ERROR_THREAD_NOT_ENABLED);
 
 	return __lv_thread_funcs.mutex_trylock (mutex);
 }
@@ -319,11 +380,63 @@ int visual_mutex_unlock (VisMutex *mutex)
 
 	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
 	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
-	visual_return_val_if_fail (visual_thread_is_enabled () != FALSE, -VISUAL_ERROR_THREAD_NOT_ENABLED);
 
 	return __lv_thread_funcs.mutex_unlock (mutex);
 }
 
+VisCond *visual_cond_new ()
+{
+	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, NULL);
+	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, NULL);
+	visual_return_val_if_fail (visual_thread_is_enabled () != FALSE, NULL);
+
+	return __lv_thread_funcs.cond_new ();
+}
+
+int visual_cond_free (VisCond *cond)
+{
+	visual_return_val_if_fail (cond != NULL, -VISUAL_ERROR_COND_NULL);
+
+	if (visual_thread_is_supported () == FALSE) {
+		visual_log (VISUAL_LOG_WARNING, _("Tried freeing cond memory while threading is not supported, simply freeing mem"));
+
+		return visual_mem_free (cond);
+	}
+
+	return __lv_thread_funcs.cond_free (cond);
+}
+
+int visual_cond_wait (VisCond *cond, VisMutex *mutex)
+{
+	visual_return_val_if_fail (cond != NULL, -VISUAL_ERROR_COND_NULL);
+	visual_return_val_if_fail (mutex != NULL, -VISUAL_ERROR_MUTEX_NULL);
+
+	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
+	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
+
+	return __lv_thread_funcs.cond_wait (cond, mutex);
+}
+
+int visual_cond_signal (VisCond *cond)
+{
+	visual_return_val_if_fail (cond != NULL, -VISUAL_ERROR_COND_NULL);
+
+	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
+	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
+
+	return __lv_thread_funcs.cond_signal (cond);
+}
+
+int visual_cond_broadcast (VisCond *cond)
+{
+	visual_return_val_if_fail (cond != NULL, -VISUAL_ERROR_COND_NULL);
+
+	visual_return_val_if_fail (visual_thread_is_initialized () != FALSE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED);
+	visual_return_val_if_fail (visual_thread_is_supported () != FALSE, -VISUAL_ERROR_THREAD_NOT_SUPPORTED);
+
+	return __lv_thread_funcs.cond_broadcast (cond);
+}
+
 
 /* Native implementations */
 
@@ -425,7 +538,8 @@ static int mutex_lock_posix (VisMutex *mutex)
 
 static int mutex_trylock_posix (VisMutex *mutex)
 {
-	if (pthread_mutex_trylock (&mutex->mutex) < 0)
+	/* Returns EBUSY, not -1, when the mutex is held */
+	if (pthread_mutex_trylock (&mutex->mutex) != 0)
 		return -VISUAL_ERROR_MUTEX_TRYLOCK_FAILURE;
 
 	return VISUAL_OK;
@@ -439,6 +553,47 @@ static int mutex_unlock_posix (VisMutex *mutex)
 	return VISUAL_OK;
 }
 
+
+static VisCond *cond_new_posix ()
+{
+	VisCond *cond;
+
+	cond = visual_mem_new0 (VisCond, 1);
+
+	pthread_cond_init (&cond->cond, NULL);
+
+	return cond;
+}
+
+static int cond_free_posix (VisCond *cond)
+{
+	pthread_cond_destroy (&cond->cond);
+
+	return visual_mem_free (cond);
+}
+
+static int cond_wait_posix (VisCond *cond, VisMutex *mutex)
+{
+	if (pthread_cond_wait (&cond->cond, &mutex->mutex) != 0)
+		return -VISUAL_ERROR_COND_WAIT_FAILURE;
+
+	return VISUAL_OK;
+}
+
+static int cond_signal_posix (VisCond *cond)
+{
+	pthread_cond_signal (&cond->cond);
+
+	return VISUAL_OK;
+}
+
+static int cond_broadcast_posix (VisCond *cond)
+{
+	pthread_cond_broadcast (&cond->cond);
+
+	return VISUAL_OK;
+}
+
 #endif // VISUAL_THREAD_MODEL_POSIX
 
 /* Windows32 implementation */
@@ -534,6 +689,32 @@ static int mutex_unlock_win32 (VisMutex *mutex)
     return 0;
 }
 
+
+static VisCond *cond_new_win32 ()
+{
+    return 0;
+}
+
+static int cond_free_win32 (VisCond *cond)
+{
+    return 0;
+}
+
+static int cond_wait_win32 (VisCond *cond, VisMutex *mutex)
+{
+    return 0;
+}
+
+static int cond_signal_win32 (VisCond *cond)
+{
+    return 0;
+}
+
+static int cond_broadcast_win32 (VisCond *cond)
+{
+    return 0;
+}
+
 #endif /* VISUAL_THREAD_MODEL_WIN32 */
 
 /* GThread implementation */
@@ -628,10 +809,15 @@ static int mutex_lock_gthread (VisMutex *mutex)
 
 static int mutex_trylock_gthread (VisMutex *mutex)
 {
+	gboolean locked;
+
 	if (mutex->static_mutex_used == TRUE)
-		g_static_mutex_trylock (&mutex->static_mutex);
+		locked = g_static_mutex_trylock (&mutex->static_mutex);
 	else
-		g_mutex_trylock (mutex->mutex);
+		locked = g_mutex_trylock (mutex->mutex);
+
+	if (locked == FALSE)
+		return -VISUAL_ERROR_MUTEX_TRYLOCK_FAILURE;
 
 	return VISUAL_OK;
 }
@@ -646,4 +832,49 @@ static int mutex_unlock_gthread (VisMutex *mutex)
 	return VISUAL_OK;
 }
 
+
+static VisCond *cond_new_gthread ()
+{
+	VisCond *cond;
+
+	cond = visual_mem_new0 (VisCond, 1);
+
+	cond->cond = g_cond_new ();
+
+	return cond;
+}
+
+static int cond_free_gthread (VisCond *cond)
+{
+	visual_return_val_if_fail (cond->cond != NULL, -VISUAL_ERROR_COND_NULL);
+
+	g_cond_free (cond->cond);
+
+	return visual_mem_free (cond);
+}
+
+static int cond_wait_gthread (VisCond *cond, VisMutex *mutex)
+{
+	if (mutex->static_mutex_used == TRUE)
+		g_cond_wait (cond->cond, g_static_mutex_get_mutex (&mutex->static_mutex));
+	else
+		g_cond_wait (cond->cond, mutex->mutex);
+
+	return VISUAL_OK;
+}
+
+static int cond_signal_gthread (VisCond *cond)
+{
+	g_cond_signal (cond->cond);
+
+	return VISUAL_OK;
+}
+
+static int cond_broadcast_gthread (VisCond *cond)
+{
+	g_cond_broadcast (cond->cond);
+
+	return VISUAL_OK;
+}
+
 #endif // VISUAL_THREAD_MODEL_GTHREAD2
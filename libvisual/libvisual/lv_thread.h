@@ -27,6 +27,7 @@ VISUAL_BEGIN_DECLS
 
 typedef struct _VisThread VisThread;
 typedef struct _VisMutex VisMutex;
+typedef struct _VisCond VisCond;
 
 /**
  * The function defination for a function that forms the base of a new VisThread when
@@ -40,6 +41,11 @@ typedef struct _VisMutex VisMutex;
  */
 typedef void *(*VisThreadFunc)(void *data);
 
+/**
+ * Function run for every item by visual_thread_run_parallel().
+ */
+typedef void (*VisThreadParallelFunc)(void *data, int index);
+
 /**
  * The VisThread data structure and the VisThread subsystem is a wrapper system for native
  * threading implementations.
@@ -76,6 +82,22 @@ struct _VisMutex {
 #endif /* VISUAL_HAVE_THREADS */
 };
 
+/**
+ * The VisCond data structure and the VisCond subsystem is a wrapper system for native
+ * condition variable implementations. A VisCond is always used together with a VisMutex.
+ */
+struct _VisCond {
+#ifdef VISUAL_HAVE_THREADS
+#ifdef VISUAL_THREAD_MODEL_POSIX
+	pthread_cond_t cond;		/**< Private used for the pthreads implementation. */
+#elif defined(VISUAL_THREAD_MODEL_WIN32) /* !VISUAL_THREAD_MODEL_POSIX */
+
+#elif defined(VISUAL_THREAD_MODEL_GTHREAD) /* !VISUAL_THREAD_MODEL_WIN32 */
+	GCond *cond;
+#endif
+#endif /* VISUAL_HAVE_THREADS */
+};
+
 
 /**
  * Initializes the VisThread subsystem. This function needs to be
@@ -99,6 +121,10 @@ int visual_thread_is_initialized (void);
  * Enable or disable threading support. This can be used to disallow
  * threads, which might be needed in some environments.
  *
+ * Disabling only stops new threads, mutexes and conditions from being
+ * made. The ones that exist keep locking, signalling and joining, so the
+ * code that uses them can still wind down.
+ *
  * @see visual_thread_is_enabled
  *
  * @param enabled TRUE to enable threads, FALSE to disable threads.
@@ -167,6 +193,27 @@ void visual_thread_exit (void *retval);
  */
 void visual_thread_yield (void);
 
+/**
+ * Runs func for every index in [0, count), split over the libvisual worker
+ * threads that the VisVideo operations use as well, and returns when all items
+ * are done. The items need to be independent, they run in no particular order.
+ * When the workers are busy, or threads are disabled, the items run serially
+ * on the calling thread.
+ *
+ * @param count The number of items.
+ * @param func The function that is run for every item.
+ * @param data The private data that is send to func.
+ */
+void visual_thread_run_parallel (int count, VisThreadParallelFunc func, void *data);
+
+/**
+ * Gives the number of threads visual_thread_run_parallel() splits its items over,
+ * including the calling thread. Work is best divided into a small multiple of this.
+ *
+ * @return The number of threads, 1 when items always run serially.
+ */
+int visual_thread_get_parallelism (void);
+
 /**
  * Creates a new VisMutex that is used to do thread locking so data
  * can be synchronized.
@@ -237,6 +284,58 @@ int visual_mutex_trylock (VisMutex *mutex);
  */
 int visual_mutex_unlock (VisMutex *mutex);
 
+/**
+ * Creates a new VisCond that is used to wait for, and signal, a change
+ * of the data that is protected by a VisMutex.
+ *
+ * @return A newly allocated VisCond or NULL on failure.
+ */
+VisCond *visual_cond_new (void);
+
+/**
+ * Frees a VisCond that was allocated using visual_cond_new(). No
+ * thread may be waiting on it.
+ *
+ * @param cond Pointer to the VisCond that needs to be freed.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_COND_NULL on failure.
+ */
+int visual_cond_free (VisCond *cond);
+
+/**
+ * Atomically unlocks the VisMutex and blocks until the VisCond is
+ * signalled, the VisMutex is locked again before returning. Wakeups
+ * can be spurious, so always wait in a loop that checks the predicate.
+ *
+ * @param cond Pointer to the VisCond to wait on.
+ * @param mutex Pointer to the VisMutex, locked by the calling thread.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_COND_NULL, -VISUAL_ERROR_MUTEX_NULL,
+ *	-VISUAL_ERROR_COND_WAIT_FAILURE, -VISUAL_ERROR_THREAD_NOT_INITIALIZED,
+ *	-VISUAL_ERROR_THREAD_NOT_SUPPORTED or -VISUAL_ERROR_THREAD_NOT_ENABLED on failure.
+ */
+int visual_cond_wait (VisCond *cond, VisMutex *mutex);
+
+/**
+ * Wakes up one thread that is waiting on the VisCond.
+ *
+ * @param cond Pointer to the VisCond to signal.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_COND_NULL, -VISUAL_ERROR_THREAD_NOT_INITIALIZED,
+ *	-VISUAL_ERROR_THREAD_NOT_SUPPORTED or -VISUAL_ERROR_THREAD_NOT_ENABLED on failure.
+ */
+int visual_cond_signal (VisCond *cond);
+
+/**
+ * Wakes up all threads that are waiting on the VisCond.
+ *
+ * @param cond Pointer to the VisCond to broadcast.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_COND_NULL, -VISUAL_ERROR_THREAD_NOT_INITIALIZED,
+ *	-VISUAL_ERROR_THREAD_NOT_SUPPORTED or -VISUAL_ERROR_THREAD_NOT_ENABLED on failure.
+ */
+int visual_cond_broadcast (VisCond *cond);
+
 VISUAL_END_DECLS
 
 /**
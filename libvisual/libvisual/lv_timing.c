@@ -0,0 +1,348 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "config.h"
+#include "lv_timing.h"
+#include "lv_common.h"
+#include "lv_time.h"
+#include "gettext.h"
+#include "private/lv_atomic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* A slot of the ring. Every field is written with an atomic store between
+ * clearing and setting seq, seq is the event index + 1 once the slot is complete */
+typedef struct {
+	volatile unsigned int	 seq;
+	volatile unsigned int	 begin_lo;
+	volatile unsigned int	 begin_hi;
+	volatile unsigned int	 duration;
+	volatile unsigned int	 frame;
+	volatile unsigned int	 tag;		/* stage | track << 8 */
+} TimingSlot;
+
+static int timing_dtor (VisObject *object);
+
+static int timing_read_slot (VisTiming *timing, unsigned int index, VisTimingEvent *event);
+static int timing_compare_duration (const void *a, const void *b);
+
+static const char *timing_stage_names[VISUAL_TIMING_STAGE_LAST] = {
+	[VISUAL_TIMING_STAGE_FRAME] =		"frame",
+	[VISUAL_TIMING_STAGE_INPUT] =		"input",
+	[VISUAL_TIMING_STAGE_EVENTS] =		"events",
+	[VISUAL_TIMING_STAGE_RENDER] =		"render",
+	[VISUAL_TIMING_STAGE_TRANSFORM] =	"transform",
+	[VISUAL_TIMING_STAGE_MORPH] =		"morph"
+};
+
+static const char *timing_track_names[VISUAL_TIMING_TRACK_LAST] = {
+	[VISUAL_TIMING_TRACK_BIN] =		"bin",
+	[VISUAL_TIMING_TRACK_INPUT] =		"input",
+	[VISUAL_TIMING_TRACK_ACTOR] =		"actor",
+	[VISUAL_TIMING_TRACK_ACTMORPH] =	"actmorph",
+	[VISUAL_TIMING_TRACK_MORPH] =		"morph"
+};
+
+
+static int timing_dtor (VisObject *object)
+{
+	VisTiming *timing = VISUAL_TIMING (object);
+
+	if (timing->slots != NULL)
+		visual_mem_free (timing->slots);
+
+	timing->slots = NULL;
+
+	return VISUAL_OK;
+}
+
+/* Copies out the event with the given index, FALSE when the slot is being
+ * written or already holds a newer event */
+static int timing_read_slot (VisTiming *timing, unsigned int index, VisTimingEvent *event)
+{
+	TimingSlot *slot = (TimingSlot *) timing->slots + (index & timing->mask);
+	unsigned int tag;
+
+	if (_lv_atomic_load (&slot->seq) != index + 1)
+		return FALSE;
+
+	event->begin = ((uint64_t) _lv_atomic_load (&slot->begin_hi) << 32) | _lv_atomic_load (&slot->begin_lo);
+	event->duration = _lv_atomic_load (&slot->duration);
+	event->frame = _lv_atomic_load (&slot->frame);
+	tag = _lv_atomic_load (&slot->tag);
+
+	if (_lv_atomic_load (&slot->seq) != index + 1)
+		return FALSE;
+
+	event->stage = tag & 0xff;
+	event->track = tag >> 8;
+
+	return TRUE;
+}
+
+static int timing_compare_duration (const void *a, const void *b)
+{
+	uint32_t da = *(const uint32_t *) a;
+	uint32_t db = *(const uint32_t *) b;
+
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+VisTiming *visual_timing_new (int size)
+{
+	VisTiming *timing;
+
+	timing = visual_mem_new0 (VisTiming, 1);
+
+	if (visual_timing_init (timing, size) != VISUAL_OK) {
+		visual_mem_free (timing);
+
+		return NULL;
+	}
+
+	/* Do the VisObject initialization */
+	visual_object_set_allocated (VISUAL_OBJECT (timing), TRUE);
+	visual_object_ref (VISUAL_OBJECT (timing));
+
+	return timing;
+}
+
+int visual_timing_init (VisTiming *timing, int size)
+{
+	unsigned int capacity = 1;
+
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+	visual_return_val_if_fail (size > 0 && size <= (1 << 24), -VISUAL_ERROR_GENERAL);
+
+	/* Do the VisObject initialization */
+	visual_object_clear (VISUAL_OBJECT (timing));
+	visual_object_set_dtor (VISUAL_OBJECT (timing), timing_dtor);
+	visual_object_set_allocated (VISUAL_OBJECT (timing), FALSE);
+
+	while (capacity < (unsigned int) size)
+		capacity <<= 1;
+
+	/* Reset the VisTiming data */
+	timing->slots = visual_mem_malloc0 (capacity * sizeof (TimingSlot));
+	timing->size = capacity;
+	timing->mask = capacity - 1;
+	timing->head = 0;
+	timing->frame = 0;
+	timing->epoch = visual_timing_now ();
+
+	return VISUAL_OK;
+}
+
+uint64_t visual_timing_now (void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec now;
+
+	if (clock_gettime (CLOCK_MONOTONIC, &now) == 0)
+		return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+	{
+		VisTime now;
+
+		visual_time_get (&now);
+
+		return (uint64_t) now.sec * 1000000000 + (uint64_t) now.usec * 1000;
+	}
+}
+
+int visual_timing_record (VisTiming *timing, VisTimingStage stage, VisTimingTrack track, uint64_t begin, uint64_t end)
+{
+	TimingSlot *slot;
+	uint64_t duration;
+	unsigned int index;
+
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+	visual_return_val_if_fail ((unsigned int) stage < VISUAL_TIMING_STAGE_LAST, -VISUAL_ERROR_GENERAL);
+	visual_return_val_if_fail ((unsigned int) track < VISUAL_TIMING_TRACK_LAST, -VISUAL_ERROR_GENERAL);
+
+	/* Clocks taken before the epoch, or not at all */
+	if (begin < timing->epoch || end < begin)
+		return VISUAL_OK;
+
+	duration = end - begin;
+	if (duration > 0xffffffff)
+		duration = 0xffffffff;
+
+	begin -= timing->epoch;
+
+	index = _lv_atomic_add (&timing->head, 1) - 1;
+	slot = (TimingSlot *) timing->slots + (index & timing->mask);
+
+	_lv_atomic_store (&slot->seq, 0);
+	_lv_atomic_store (&slot->begin_lo, (unsigned int) begin);
+	_lv_atomic_store (&slot->begin_hi, (unsigned int) (begin >> 32));
+	_lv_atomic_store (&slot->duration, (unsigned int) duration);
+	_lv_atomic_store (&slot->frame, _lv_atomic_load (&timing->frame));
+	_lv_atomic_store (&slot->tag, stage | (track << 8));
+	_lv_atomic_store (&slot->seq, index + 1);
+
+	return VISUAL_OK;
+}
+
+unsigned int visual_timing_next_frame (VisTiming *timing)
+{
+	visual_return_val_if_fail (timing != NULL, 0);
+
+	return _lv_atomic_add (&timing->frame, 1);
+}
+
+int visual_timing_get_events (VisTiming *timing, VisTimingEvent *events, int count)
+{
+	unsigned int head;
+	unsigned int index;
+	unsigned int available;
+	int copied = 0;
+
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+	visual_return_val_if_fail (events != NULL, -VISUAL_ERROR_NULL);
+	visual_return_val_if_fail (count >= 0, -VISUAL_ERROR_GENERAL);
+
+	head = _lv_atomic_load (&timing->head);
+
+	available = head < timing->size ? head : timing->size;
+	if (available > (unsigned int) count)
+		available = count;
+
+	for (index = head - available; index != head; index++) {
+		if (timing_read_slot (timing, index, &events[copied]) == TRUE)
+			copied++;
+	}
+
+	return copied;
+}
+
+int visual_timing_get_histogram (VisTiming *timing, VisTimingStage stage, VisTimingHistogram *histogram)
+{
+	VisTimingEvent *events;
+	uint32_t *durations;
+	uint64_t total = 0;
+	int nevents;
+	int bucket;
+	int count = 0;
+	int i;
+
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+	visual_return_val_if_fail (histogram != NULL, -VISUAL_ERROR_NULL);
+	visual_return_val_if_fail ((unsigned int) stage < VISUAL_TIMING_STAGE_LAST, -VISUAL_ERROR_GENERAL);
+
+	visual_mem_set (histogram, 0, sizeof (VisTimingHistogram));
+
+	events = visual_mem_malloc (timing->size * sizeof (VisTimingEvent));
+	durations = visual_mem_malloc (timing->size * sizeof (uint32_t));
+
+	nevents = visual_timing_get_events (timing, events, timing->size);
+
+	for (i = 0; i < nevents; i++) {
+		if (events[i].stage != stage)
+			continue;
+
+		durations[count++] = events[i].duration;
+		total += events[i].duration;
+
+		for (bucket = 0; bucket < VISUAL_TIMING_HISTOGRAM_BUCKETS - 1 &&
+				(events[i].duration >> (bucket + 1)) != 0; bucket++)
+			;
+
+		histogram->buckets[bucket]++;
+	}
+
+	if (count > 0) {
+		qsort (durations, count, sizeof (uint32_t), timing_compare_duration);
+
+		histogram->count = count;
+		histogram->min = durations[0];
+		histogram->max = durations[count - 1];
+		histogram->mean = total / count;
+		histogram->p50 = durations[(count - 1) * 50 / 100];
+		histogram->p90 = durations[(count - 1) * 90 / 100];
+		histogram->p99 = durations[(count - 1) * 99 / 100];
+	}
+
+	visual_mem_free (durations);
+	visual_mem_free (events);
+
+	return VISUAL_OK;
+}
+
+int visual_timing_reset (VisTiming *timing)
+{
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+
+	visual_mem_set (timing->slots, 0, timing->size * sizeof (TimingSlot));
+
+	_lv_atomic_store (&timing->head, 0);
+	_lv_atomic_store (&timing->frame, 0);
+
+	return VISUAL_OK;
+}
+
+int visual_timing_dump_trace (VisTiming *timing, const char *filename)
+{
+	VisTimingEvent *events;
+	FILE *fp;
+	int nevents;
+	int ret;
+	int i;
+
+	visual_return_val_if_fail (timing != NULL, -VISUAL_ERROR_TIMING_NULL);
+	visual_return_val_if_fail (filename != NULL, -VISUAL_ERROR_NULL);
+
+	fp = fopen (filename, "w");
+	if (fp == NULL) {
+		visual_log (VISUAL_LOG_WARNING, _("Could not open %s for writing the timing trace"), filename);
+
+		return -VISUAL_ERROR_GENERAL;
+	}
+
+	events = visual_mem_malloc (timing->size * sizeof (VisTimingEvent));
+	nevents = visual_timing_get_events (timing, events, timing->size);
+
+	fprintf (fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	for (i = 0; i < VISUAL_TIMING_TRACK_LAST; i++) {
+		fprintf (fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s\"}}", i > 0 ? ",\n" : "", i, timing_track_names[i]);
+	}
+
+	/* ts and dur are in microseconds */
+	for (i = 0; i < nevents; i++) {
+		fprintf (fp, ",\n{\"name\":\"%s\",\"cat\":\"libvisual\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%llu.%03u,\"dur\":%u.%03u,\"args\":{\"frame\":%u}}",
+				timing_stage_names[events[i].stage], events[i].track,
+				(unsigned long long) (events[i].begin / 1000), (unsigned int) (events[i].begin % 1000),
+				events[i].duration / 1000, events[i].duration % 1000, events[i].frame);
+	}
+
+	fprintf (fp, "\n]}\n");
+
+	visual_mem_free (events);
+
+	ret = ferror (fp) != 0 ? -VISUAL_ERROR_GENERAL : VISUAL_OK;
+
+	if (fclose (fp) != 0)
+		ret = -VISUAL_ERROR_GENERAL;
+
+	return ret;
+}
+
+const char *visual_timing_stage_name (VisTimingStage stage)
+{
+	if ((unsigned int) stage >= VISUAL_TIMING_STAGE_LAST)
+		return NULL;
+
+	return timing_stage_names[stage];
+}
+
+const char *visual_timing_track_name (VisTimingTrack track)
+{
+	if ((unsigned int) track >= VISUAL_TIMING_TRACK_LAST)
+		return NULL;
+
+	return timing_track_names[track];
+}
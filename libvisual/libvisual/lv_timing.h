@@ -0,0 +1,221 @@
+#ifndef _LV_TIMING_H
+#define _LV_TIMING_H
+
+#include <libvisual/lvconfig.h>
+#include <libvisual/lv_defines.h>
+#include <libvisual/lv_object.h>
+
+/**
+ * @defgroup VisTiming VisTiming
+ * @{
+ */
+
+VISUAL_BEGIN_DECLS
+
+#define VISUAL_TIMING(obj)				(VISUAL_CHECK_CAST ((obj), VisTiming))
+
+/** Default number of events a VisTiming keeps. */
+#define VISUAL_TIMING_DEFAULT_SIZE		4096
+
+/** Number of buckets in a VisTimingHistogram, bucket n counts durations from 2^n up to 2^(n+1) ns. */
+#define VISUAL_TIMING_HISTOGRAM_BUCKETS		32
+
+typedef struct _VisTiming VisTiming;
+typedef struct _VisTimingEvent VisTimingEvent;
+typedef struct _VisTimingHistogram VisTimingHistogram;
+
+/**
+ * The stages of a frame that are timed.
+ */
+typedef enum {
+	VISUAL_TIMING_STAGE_FRAME = 0,		/**< All of visual_bin_run(). */
+	VISUAL_TIMING_STAGE_INPUT,		/**< visual_input_run(), or the upload on the input thread. */
+	VISUAL_TIMING_STAGE_EVENTS,		/**< Pumping the events of an actor plugin. */
+	VISUAL_TIMING_STAGE_RENDER,		/**< The render function of an actor plugin. */
+	VISUAL_TIMING_STAGE_TRANSFORM,		/**< Depth transforming or fitting the render of an actor. */
+	VISUAL_TIMING_STAGE_MORPH,		/**< visual_morph_run(). */
+	VISUAL_TIMING_STAGE_LAST
+} VisTimingStage;
+
+/**
+ * Where a timed stage ran, these become the threads of a trace.
+ */
+typedef enum {
+	VISUAL_TIMING_TRACK_BIN = 0,		/**< The VisBin itself. */
+	VISUAL_TIMING_TRACK_INPUT,		/**< The VisInput. */
+	VISUAL_TIMING_TRACK_ACTOR,		/**< The main VisActor. */
+	VISUAL_TIMING_TRACK_ACTMORPH,		/**< The VisActor that is being switched to. */
+	VISUAL_TIMING_TRACK_MORPH,		/**< The VisMorph. */
+	VISUAL_TIMING_TRACK_LAST
+} VisTimingTrack;
+
+/**
+ * One timed stage.
+ */
+struct _VisTimingEvent {
+	uint64_t	 begin;		/**< Start in nanoseconds since the VisTiming was created. */
+	uint32_t	 duration;	/**< Duration in nanoseconds. */
+	unsigned int	 frame;		/**< Frame number the stage belongs to. */
+	VisTimingStage	 stage;		/**< The stage. */
+	VisTimingTrack	 track;		/**< Where it ran. */
+};
+
+/**
+ * Statistics of one stage over the events in the ring.
+ */
+struct _VisTimingHistogram {
+	int		 count;		/**< Number of events. */
+	uint32_t	 min;		/**< Shortest duration in nanoseconds. */
+	uint32_t	 max;		/**< Longest duration in nanoseconds. */
+	uint32_t	 mean;		/**< Average duration in nanoseconds. */
+	uint32_t	 p50;		/**< Median duration in nanoseconds. */
+	uint32_t	 p90;		/**< 90th percentile duration in nanoseconds. */
+	uint32_t	 p99;		/**< 99th percentile duration in nanoseconds. */
+
+	int		 buckets[VISUAL_TIMING_HISTOGRAM_BUCKETS]; /**< Counts per power of two nanoseconds. */
+};
+
+/**
+ * The VisTiming records how long the stages of every frame take, with a monotonic
+ * nanosecond clock. Events go into a ring that keeps the most recent ones, so
+ * statistics are always over a rolling window.
+ *
+ * Any number of threads can record at once without locking. A slot is claimed
+ * with one atomic increment and published with a sequence number, readers copy
+ * the ring and drop the slots that were being written at the time.
+ *
+ * Attach one to a VisBin with visual_bin_set_timing(). The instrumentation in
+ * VisBin, VisActor and VisMorph is only built when VISUAL_HAVE_TIMING is defined,
+ * without it recording costs nothing.
+ */
+struct _VisTiming {
+	VisObject		 object;	/**< The VisObject data. */
+
+	void			*slots;		/**< Private, the ring. */
+	unsigned int		 size;		/**< Capacity in events, a power of two. */
+	unsigned int		 mask;		/**< size - 1. */
+
+	volatile unsigned int	 head;		/**< Events recorded in total. */
+	volatile unsigned int	 frame;		/**< Current frame number. */
+
+	uint64_t		 epoch;		/**< Clock value at creation, events are relative to this. */
+};
+
+/**
+ * Creates a new VisTiming.
+ *
+ * @param size The minimal number of events to keep, rounded up to a power of two.
+ *
+ * @return A newly allocated VisTiming, or NULL on failure.
+ */
+VisTiming *visual_timing_new (int size);
+
+/**
+ * Initializes a VisTiming, see visual_timing_new().
+ *
+ * @param timing Pointer to the VisTiming which needs to be initialized.
+ * @param size The minimal number of events to keep, rounded up to a power of two.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_TIMING_NULL or -VISUAL_ERROR_GENERAL on failure.
+ */
+int visual_timing_init (VisTiming *timing, int size);
+
+/**
+ * Reads the monotonic clock.
+ *
+ * @return The clock in nanoseconds, from an arbitrary starting point.
+ */
+uint64_t visual_timing_now (void);
+
+/**
+ * Records a stage that ran from begin up to end. Can be called from any thread.
+ *
+ * @param timing Pointer to the VisTiming.
+ * @param stage The stage that ran.
+ * @param track Where it ran.
+ * @param begin Clock value at the start, from visual_timing_now().
+ * @param end Clock value at the end, from visual_timing_now().
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_TIMING_NULL or -VISUAL_ERROR_GENERAL on failure.
+ */
+int visual_timing_record (VisTiming *timing, VisTimingStage stage, VisTimingTrack track, uint64_t begin, uint64_t end);
+
+/**
+ * Starts a new frame, events recorded after this carry the new frame number.
+ *
+ * @param timing Pointer to the VisTiming.
+ *
+ * @return The new frame number.
+ */
+unsigned int visual_timing_next_frame (VisTiming *timing);
+
+/**
+ * Copies the most recent events out of the ring, oldest first. Events that are
+ * being written while copying are left out.
+ *
+ * @param timing Pointer to the VisTiming.
+ * @param events Array that is filled in with the events.
+ * @param count Size of the array.
+ *
+ * @return The number of events copied, or -VISUAL_ERROR_TIMING_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_timing_get_events (VisTiming *timing, VisTimingEvent *events, int count);
+
+/**
+ * Gets the statistics of one stage over the events in the ring.
+ *
+ * @param timing Pointer to the VisTiming.
+ * @param stage The stage.
+ * @param histogram Filled in with the statistics, count is 0 when the stage has no events.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_TIMING_NULL, -VISUAL_ERROR_NULL or
+ *	-VISUAL_ERROR_GENERAL on failure.
+ */
+int visual_timing_get_histogram (VisTiming *timing, VisTimingStage stage, VisTimingHistogram *histogram);
+
+/**
+ * Drops all recorded events. Should not be called while other threads are recording.
+ *
+ * @param timing Pointer to the VisTiming.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_TIMING_NULL on failure.
+ */
+int visual_timing_reset (VisTiming *timing);
+
+/**
+ * Writes the events in the ring as Chrome trace event JSON, which can be loaded
+ * in chrome://tracing or Perfetto. Every track becomes a thread.
+ *
+ * @param timing Pointer to the VisTiming.
+ * @param filename The file to write.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_TIMING_NULL, -VISUAL_ERROR_NULL or
+ *	-VISUAL_ERROR_GENERAL on failure.
+ */
+int visual_timing_dump_trace (VisTiming *timing, const char *filename);
+
+/**
+ * Gets the name of a stage.
+ *
+ * @param stage The stage.
+ *
+ * @return The name, or NULL when the stage is not valid.
+ */
+const char *visual_timing_stage_name (VisTimingStage stage);
+
+/**
+ * Gets the name of a track.
+ *
+ * @param track The track.
+ *
+ * @return The name, or NULL when the track is not valid.
+ */
+const char *visual_timing_track_name (VisTimingTrack track);
+
+VISUAL_END_DECLS
+
+/**
+ * @}
+ */
+
+#endif /* _LV_TIMING_H */
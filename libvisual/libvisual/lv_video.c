@@ -30,11 +30,20 @@
 #include "lv_color.h"
 #include "lv_common.h"
 #include "lv_cpu.h"
+#include "lv_video_pool.h"
 #include "private/lv_video_convert.h"
 #include "private/lv_video_fill.h"
 #include "private/lv_video_scale.h"
+#include "private/lv_thread_pool.h"
+#include "private/lv_video_simd.h"
 #include "gettext.h"
 
+/* Default for visual_video_set_parallel_threshold(), about 512x384 */
+#define VIDEO_PARALLEL_THRESHOLD	(512 * 384)
+
+/* Bands per thread, so a thread that got scheduled late still finds work */
+#define VIDEO_BANDS_PER_THREAD		2
+
 #pragma pack(1)
 
 typedef struct {
@@ -47,8 +56,46 @@ typedef struct {
 
 #pragma pack()
 
+/* Splits an operation on two VisVideos into row bands, see video_run_bands() */
+typedef void (*VideoBandFunc) (VisVideo *dest, VisVideo *src, void *priv);
+
+typedef void (*VideoConvertFunc) (VisVideo *dest, VisVideo *src);
+typedef void (*VideoScaleFunc) (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+
+typedef struct {
+	VisVideo	*dest;		/* Band views of the destination */
+	VisVideo	*src;		/* Band views of the source, NULL when there is none */
+	VideoBandFunc	 func;
+	void		*priv;
+} VideoBands;
+
+typedef struct {
+	VisVideo	*dest;
+	VisVideo	*src;
+	VisVideoScalePlan *plan;
+	VideoScaleFunc	 func;
+	int		 bands;
+} VideoScaleBands;
+
+static int __lv_video_parallel_threshold = VIDEO_PARALLEL_THRESHOLD;
+
 /* The VisVideo dtor function */
 static int video_dtor (VisObject *object);
+static int video_scale_plan_dtor (VisObject *object);
+
+/* Row band partitioning */
+static int video_get_bands (int width, int height);
+static void video_bands_func (void *data, int index);
+static void video_run_bands (VisVideo *dest, VisVideo *src, int height, VideoBandFunc func, void *priv);
+static void video_blit_band (VisVideo *dest, VisVideo *src, void *priv);
+static void video_convert_band (VisVideo *dest, VisVideo *src, void *priv);
+static void video_fill_band (VisVideo *dest, VisVideo *src, void *priv);
+static void video_scale_bands_func (void *data, int index);
+static int video_blit_is_banded (VisVideoCustomCompositeFunc compfunc, VisVideo *dest, VisVideo *src);
+static void video_convert (VisVideo *dest, VisVideo *src, VideoConvertFunc convert);
+static void video_fill (VisVideo *video, VisColor *color, void (*fill) (VisVideo *video, VisColor *color));
+static void video_scale (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, VideoScaleFunc scale);
+static void scale_bilinear_32_mmx (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
 
 /* Precomputation functions */
 static void precompute_row_table (VisVideo *video);
@@ -82,13 +129,230 @@ static int video_dtor (VisObject *object)
 	if (video->buffer != NULL)
 		visual_object_unref (VISUAL_OBJECT (video->buffer));
 
+	if (video->scale_plan != NULL)
+		visual_object_unref (VISUAL_OBJECT (video->scale_plan));
+
 	video->pixel_rows = NULL;
 	video->parent = NULL;
 	video->buffer = NULL;
+	video->scale_plan = NULL;
+
+	return VISUAL_OK;
+}
+
+static int video_scale_plan_dtor (VisObject *object)
+{
+	VisVideoScalePlan *plan = VISUAL_VIDEO_SCALE_PLAN (object);
+
+	if (plan->xindex != NULL)
+		visual_mem_free (plan->xindex);
+
+	if (plan->yindex != NULL)
+		visual_mem_free (plan->yindex);
+
+	if (plan->xweight != NULL)
+		visual_mem_free (plan->xweight);
+
+	if (plan->yweight != NULL)
+		visual_mem_free (plan->yweight);
+
+	plan->xindex = NULL;
+	plan->yindex = NULL;
+	plan->xweight = NULL;
+	plan->yweight = NULL;
 
 	return VISUAL_OK;
 }
 
+/* Number of row bands an operation on width x height pixels is split into */
+static int video_get_bands (int width, int height)
+{
+	int bands;
+
+	if (__lv_video_parallel_threshold < 0 || width <= 0 || height < 2)
+		return 1;
+
+	if (width * height < __lv_video_parallel_threshold)
+		return 1;
+
+	bands = _lv_thread_pool_get_threads () * VIDEO_BANDS_PER_THREAD;
+
+	if (bands <= VIDEO_BANDS_PER_THREAD)
+		return 1;
+
+	return bands > height ? height : bands;
+}
+
+static void video_bands_func (void *data, int index)
+{
+	VideoBands *bands = data;
+
+	bands->func (&bands->dest[index], bands->src != NULL ? &bands->src[index] : NULL, bands->priv);
+}
+
+/* Runs func over the first height rows of dest and src, as bands of rows on the
+ * thread pool when the operation is big enough. func may only touch its own rows,
+ * then the result is the same as running it once over the whole VisVideo. */
+static void video_run_bands (VisVideo *dest, VisVideo *src, int height, VideoBandFunc func, void *priv)
+{
+	VideoBands bands;
+	int count = video_get_bands (dest->width, height);
+	int i;
+
+	if (count <= 1) {
+		func (dest, src, priv);
+
+		return;
+	}
+
+	/* The band views are set up here, region subs take references that are not
+	 * safe to take from the workers */
+	bands.dest = visual_mem_new0 (VisVideo, count);
+	bands.src = src != NULL ? visual_mem_new0 (VisVideo, count) : NULL;
+	bands.func = func;
+	bands.priv = priv;
+
+	for (i = 0; i < count; i++) {
+		int y_begin = i * height / count;
+		int y_end = (i + 1) * height / count;
+
+		visual_video_init (&bands.dest[i]);
+		visual_video_region_sub_by_values (&bands.dest[i], dest, 0, y_begin, dest->width, y_end - y_begin);
+
+		if (src != NULL) {
+			visual_video_init (&bands.src[i]);
+			visual_video_region_sub_by_values (&bands.src[i], src, 0, y_begin, src->width, y_end - y_begin);
+		}
+	}
+
+	_lv_thread_pool_run (count, video_bands_func, &bands);
+
+	/* The dtor leaves the palette reference of the region sub alone */
+	for (i = 0; i < count; i++) {
+		if (bands.dest[i].pal != NULL)
+			visual_object_unref (VISUAL_OBJECT (bands.dest[i].pal));
+
+		visual_object_unref (VISUAL_OBJECT (&bands.dest[i]));
+
+		if (src != NULL) {
+			if (bands.src[i].pal != NULL)
+				visual_object_unref (VISUAL_OBJECT (bands.src[i].pal));
+
+			visual_object_unref (VISUAL_OBJECT (&bands.src[i]));
+		}
+	}
+
+	visual_mem_free (bands.dest);
+
+	if (bands.src != NULL)
+		visual_mem_free (bands.src);
+}
+
+static void video_blit_band (VisVideo *dest, VisVideo *src, void *priv)
+{
+	VisVideoCustomCompositeFunc compfunc = *(VisVideoCustomCompositeFunc *) priv;
+
+	compfunc (dest, src);
+}
+
+static void video_convert_band (VisVideo *dest, VisVideo *src, void *priv)
+{
+	VideoConvertFunc convert = *(VideoConvertFunc *) priv;
+
+	convert (dest, src);
+}
+
+static void video_fill_band (VisVideo *dest, VisVideo *src, void *priv)
+{
+	struct {
+		void (*fill) (VisVideo *video, VisColor *color);
+		VisColor *color;
+	} *fill = priv;
+
+	fill->fill (dest, fill->color);
+}
+
+static void video_scale_bands_func (void *data, int index)
+{
+	VideoScaleBands *bands = data;
+
+	bands->func (bands->dest, bands->src, bands->plan,
+			index * bands->dest->height / bands->bands,
+			(index + 1) * bands->dest->height / bands->bands);
+}
+
+/* Only the builtin blitters are known to stay within their rows */
+static int video_blit_is_banded (VisVideoCustomCompositeFunc compfunc, VisVideo *dest, VisVideo *src)
+{
+	if (compfunc == blit_overlay_noalpha || compfunc == blit_overlay_alphasrc ||
+			compfunc == _lv_blit_overlay_alphasrc_mmx || compfunc == blit_overlay_surfacealpha ||
+			compfunc == blit_overlay_surfacealphacolorkey)
+		return TRUE;
+
+	/* Walks the pixels as one run, which only matches the rows without padding */
+	if (compfunc == blit_overlay_colorkey)
+		return dest->pitch == dest->width * dest->bpp && src->pitch == src->width * src->bpp;
+
+	return FALSE;
+}
+
+static void video_convert (VisVideo *dest, VisVideo *src, VideoConvertFunc convert)
+{
+	int width, height;
+
+	/* Conversions to 8 bits build the destination palette as they go, and the
+	 * row skips of the converters are only exact without any padding */
+	if (dest->depth == VISUAL_VIDEO_DEPTH_8BIT || dest->width != src->width ||
+			dest->pitch != dest->width * dest->bpp || src->pitch != src->width * src->bpp) {
+		convert (dest, src);
+
+		return;
+	}
+
+	visual_video_convert_get_smallest (dest, src, &width, &height);
+
+	video_run_bands (dest, src, height, video_convert_band, &convert);
+}
+
+static void video_fill (VisVideo *video, VisColor *color, void (*fill) (VisVideo *video, VisColor *color))
+{
+	struct {
+		void (*fill) (VisVideo *video, VisColor *color);
+		VisColor *color;
+	} priv;
+
+	priv.fill = fill;
+	priv.color = color;
+
+	video_run_bands (video, NULL, video->height, video_fill_band, &priv);
+}
+
+static void video_scale (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, VideoScaleFunc scale)
+{
+	VideoScaleBands bands;
+
+	bands.bands = video_get_bands (dest->width, dest->height);
+
+	/* The scalers step through the rows in whole pixels */
+	if (bands.bands <= 1 || dest->pitch % dest->bpp != 0) {
+		scale (dest, src, plan, 0, dest->height);
+
+		return;
+	}
+
+	bands.dest = dest;
+	bands.src = src;
+	bands.plan = plan;
+	bands.func = scale;
+
+	_lv_thread_pool_run (bands.bands, video_scale_bands_func, &bands);
+}
+
+static void scale_bilinear_32_mmx (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	_lv_scale_bilinear_32_mmx_rows (dest, src, y_begin, y_end);
+}
+
 
 VisVideo *visual_video_new ()
 {
@@ -118,6 +382,7 @@ int visual_video_init (VisVideo *video)
 	video->buffer = visual_buffer_new ();
 
 	video->pixel_rows = NULL;
+	video->scale_plan = NULL;
 
 	visual_video_set_attributes (video, 0, 0, 0, VISUAL_VIDEO_DEPTH_NONE);
 	visual_video_set_buffer (video, NULL);
@@ -177,6 +442,9 @@ int visual_video_free_buffer (VisVideo *video)
 
 int visual_video_allocate_buffer (VisVideo *video)
 {
+	VisVideoPool *pool;
+	void *pixels = NULL;
+
 	visual_return_val_if_fail (video != NULL, -VISUAL_ERROR_VIDEO_NULL);
 	visual_return_val_if_fail (video->buffer != NULL, -VISUAL_ERROR_VIDEO_BUFFER_NULL);
 
@@ -197,9 +465,25 @@ int visual_video_allocate_buffer (VisVideo *video)
 		return VISUAL_OK;
 	}
 
-	visual_buffer_set_destroyer (video->buffer, visual_buffer_destroyer_free);
-	visual_buffer_set_size (video->buffer, visual_video_get_size (video));
-	visual_buffer_allocate_data (video->buffer);
+	/* Lease the pixels from the pool, so that a VisVideo that gets reallocated
+	 * at the same size reuses the memory of the previous buffer */
+	pool = visual_video_pool_get_default ();
+
+	if (pool != NULL)
+		pixels = visual_video_pool_lease (pool, visual_video_get_size (video));
+
+	if (pixels != NULL) {
+		visual_mem_set (pixels, 0, visual_video_get_size (video));
+
+		visual_buffer_set_data_pair (video->buffer, pixels, visual_video_get_size (video));
+		visual_buffer_set_destroyer (video->buffer, visual_video_pool_buffer_destroyer);
+
+		video->buffer->allocated = TRUE;
+	} else {
+		visual_buffer_set_destroyer (video->buffer, visual_buffer_destroyer_free);
+		visual_buffer_set_size (video->buffer, visual_video_get_size (video));
+		visual_buffer_allocate_data (video->buffer);
+	}
 
 	video->pixel_rows = visual_mem_new0 (void *, video->height);
 	precompute_row_table (video);
@@ -719,7 +1003,7 @@ VisVideoCustomCompositeFunc visual_video_composite_get_function (VisVideo *dest,
 		if (alpha == FALSE || src->depth != VISUAL_VIDEO_DEPTH_32BIT)
 			return blit_overlay_noalpha;
 
-		if (visual_cpu_get_mmx () != 0)
+		if (visual_cpu_get_mmx () != 0 && _lv_video_simd.blit_alphasrc_32 == NULL)
 			return _lv_blit_overlay_alphasrc_mmx;
 		else
 			return blit_overlay_alphasrc;
@@ -912,7 +1196,10 @@ int visual_video_blit_overlay_custom (VisVideo *dest, VisVideo *src, int x, int
 		goto out;
 
 	/* Call blitter */
-	compfunc (&dregion, &sregion);
+	if (video_blit_is_banded (compfunc, &dregion, &sregion) == TRUE)
+		video_run_bands (&dregion, &sregion, dregion.height, video_blit_band, &compfunc);
+	else
+		compfunc (&dregion, &sregion);
 
 out:
 	/* If we had a transform buffer, it's time to get rid of it */
@@ -957,6 +1244,17 @@ static int blit_overlay_alphasrc (VisVideo *dest, VisVideo *src)
 	uint8_t *srcbuf = visual_video_get_pixels (src);
 	uint8_t alpha;
 
+	if (_lv_video_simd.blit_alphasrc_32 != NULL && dest->bpp == 4 && src->bpp == 4) {
+		for (y = 0; y < src->height; y++) {
+			_lv_video_simd.blit_alphasrc_32 (destbuf, srcbuf, src->width);
+
+			destbuf += dest->pitch;
+			srcbuf += src->pitch;
+		}
+
+		return VISUAL_OK;
+	}
+
 	for (y = 0; y < src->height; y++) {
 		for (x = 0; x < src->width; x++) {
 			alpha = *(srcbuf + 3);
@@ -994,6 +1292,12 @@ static int blit_overlay_colorkey (VisVideo *dest, VisVideo *src)
 
 		int index = visual_palette_find_color (pal, &src->colorkey);
 
+		if (_lv_video_simd.blit_colorkey_8 != NULL && index >= 0 && index < 256) {
+			_lv_video_simd.blit_colorkey_8 (destbuf, srcbuf, pixel_count, index);
+
+			return VISUAL_OK;
+		}
+
 		for (i = 0; i < pixel_count; i++) {
 			if (*srcbuf != index)
 				*destbuf = *srcbuf;
@@ -1007,6 +1311,12 @@ static int blit_overlay_colorkey (VisVideo *dest, VisVideo *src)
 		uint16_t *srcbuf = visual_video_get_pixels (src);
 		uint16_t color = visual_color_to_uint16 (&src->colorkey);
 
+		if (_lv_video_simd.blit_colorkey_16 != NULL) {
+			_lv_video_simd.blit_colorkey_16 ((uint8_t *) destbuf, (uint8_t *) srcbuf, pixel_count, color);
+
+			return VISUAL_OK;
+		}
+
 		for (i = 0; i < pixel_count; i++) {
 			if (color != *srcbuf)
 				*destbuf = *srcbuf;
@@ -1038,6 +1348,12 @@ static int blit_overlay_colorkey (VisVideo *dest, VisVideo *src)
 		uint32_t *srcbuf = visual_video_get_pixels (src);
 		uint32_t color = visual_color_to_uint32 (&src->colorkey);
 
+		if (_lv_video_simd.blit_colorkey_32 != NULL) {
+			_lv_video_simd.blit_colorkey_32 ((uint8_t *) destbuf, (uint8_t *) srcbuf, pixel_count, color);
+
+			return VISUAL_OK;
+		}
+
 		for (i = 0; i < pixel_count; i++) {
 			if (color != *srcbuf)
 				*destbuf = *srcbuf;
@@ -1056,6 +1372,41 @@ static int blit_overlay_surfacealpha (VisVideo *dest, VisVideo *src)
 	uint8_t *destbuf = visual_video_get_pixels (dest);
 	uint8_t *srcbuf = visual_video_get_pixels (src);
 	uint8_t alpha = src->density;
+	LVBlitAlphaFunc kernel = NULL;
+	int kernel_n = src->width;
+
+	switch (dest->depth) {
+		case VISUAL_VIDEO_DEPTH_8BIT:
+			kernel = _lv_video_simd.blit_surfacealpha_bytes;
+			break;
+
+		case VISUAL_VIDEO_DEPTH_16BIT:
+			kernel = _lv_video_simd.blit_surfacealpha_rgb16;
+			break;
+
+		case VISUAL_VIDEO_DEPTH_24BIT:
+			kernel = _lv_video_simd.blit_surfacealpha_bytes;
+			kernel_n = src->width * 3;
+			break;
+
+		case VISUAL_VIDEO_DEPTH_32BIT:
+			kernel = _lv_video_simd.blit_surfacealpha_32;
+			break;
+
+		default:
+			break;
+	}
+
+	if (kernel != NULL) {
+		for (y = 0; y < src->height; y++) {
+			kernel (destbuf, srcbuf, kernel_n, alpha);
+
+			destbuf += dest->pitch;
+			srcbuf += src->pitch;
+		}
+
+		return VISUAL_OK;
+	}
 
 	if (dest->depth == VISUAL_VIDEO_DEPTH_8BIT) {
 
@@ -1311,19 +1662,19 @@ int visual_video_fill_color (VisVideo *video, VisColor *rcolor)
 
 	switch (video->depth) {
 		case VISUAL_VIDEO_DEPTH_8BIT:
-			visual_video_fill_color_index8 (video, &color);
+			video_fill (video, &color, visual_video_fill_color_index8);
 			return VISUAL_OK;
 
 		case VISUAL_VIDEO_DEPTH_16BIT:
-			visual_video_fill_color_rgb16 (video, &color);
+			video_fill (video, &color, visual_video_fill_color_rgb16);
 			return VISUAL_OK;
 
 		case VISUAL_VIDEO_DEPTH_24BIT:
-			visual_video_fill_color_rgb24 (video, &color);
+			video_fill (video, &color, visual_video_fill_color_rgb24);
 			return VISUAL_OK;
 
 		case VISUAL_VIDEO_DEPTH_32BIT:
-			visual_video_fill_color_argb32 (video, &color);
+			video_fill (video, &color, visual_video_fill_color_argb32);
 			return VISUAL_OK;
 
 
@@ -1641,68 +1992,68 @@ int visual_video_depth_transform (VisVideo *dest, VisVideo *src)
 	if (src->depth == VISUAL_VIDEO_DEPTH_8BIT) {
 
 	    if (dest->depth == VISUAL_VIDEO_DEPTH_16BIT) {
-			visual_video_index8_to_rgb16 (dest, src);
+			video_convert (dest, src, visual_video_index8_to_rgb16);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_24BIT) {
-			visual_video_index8_to_rgb24 (dest, src);
+			video_convert (dest, src, visual_video_index8_to_rgb24);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_32BIT) {
-			visual_video_index8_to_argb32 (dest, src);
+			video_convert (dest, src, visual_video_index8_to_argb32);
 			return VISUAL_OK;
 		}
 
 	} else if (src->depth == VISUAL_VIDEO_DEPTH_16BIT) {
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_8BIT) {
-			visual_video_rgb16_to_index8 (dest, src);
+			video_convert (dest, src, visual_video_rgb16_to_index8);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_24BIT) {
-			visual_video_rgb16_to_rgb24 (dest, src);
+			video_convert (dest, src, visual_video_rgb16_to_rgb24);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_32BIT) {
-			visual_video_rgb16_to_argb32 (dest, src);
+			video_convert (dest, src, visual_video_rgb16_to_argb32);
 			return VISUAL_OK;
 		}
 
 	} else if (src->depth == VISUAL_VIDEO_DEPTH_24BIT) {
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_8BIT) {
-			visual_video_rgb24_to_index8 (dest, src);
+			video_convert (dest, src, visual_video_rgb24_to_index8);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_16BIT) {
-			visual_video_rgb24_to_rgb16 (dest, src);
+			video_convert (dest, src, visual_video_rgb24_to_rgb16);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_32BIT) {
-			visual_video_rgb24_to_argb32 (dest, src);
+			video_convert (dest, src, visual_video_rgb24_to_argb32);
 			return VISUAL_OK;
 		}
 
 	} else if (src->depth == VISUAL_VIDEO_DEPTH_32BIT) {
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_8BIT) {
-			visual_video_argb32_to_index8 (dest, src);
+			video_convert (dest, src, visual_video_argb32_to_index8);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_16BIT) {
-			visual_video_argb32_to_rgb16 (dest, src);
+			video_convert (dest, src, visual_video_argb32_to_rgb16);
 			return VISUAL_OK;
 		}
 
 		if (dest->depth == VISUAL_VIDEO_DEPTH_24BIT) {
-			visual_video_argb32_to_rgb24 (dest, src);
+			video_convert (dest, src, visual_video_argb32_to_rgb24);
 			return VISUAL_OK;
 		}
 	}
@@ -1742,58 +2093,93 @@ int visual_video_zoom_double (VisVideo *dest, VisVideo *src)
 static inline int is_valid_scale_method (VisVideoScaleMethod scale_method)
 {
     return scale_method == VISUAL_VIDEO_SCALE_NEAREST
-	    || scale_method == VISUAL_VIDEO_SCALE_BILINEAR;
+	    || scale_method == VISUAL_VIDEO_SCALE_BILINEAR
+	    || scale_method == VISUAL_VIDEO_SCALE_BICUBIC
+	    || scale_method == VISUAL_VIDEO_SCALE_LANCZOS2;
 }
 
-int visual_video_scale (VisVideo *dest, VisVideo *src, VisVideoScaleMethod method)
+static inline int scale_plan_fits (VisVideoScalePlan *plan, VisVideo *dest, VisVideo *src)
 {
+	return plan->dest_width == dest->width && plan->dest_height == dest->height &&
+		plan->src_width == src->width && plan->src_height == src->height;
+}
+
+VisVideoScalePlan *visual_video_scale_plan_new (int dest_width, int dest_height, int src_width, int src_height,
+		VisVideoScaleMethod scale_method)
+{
+	VisVideoScalePlan *plan;
+
+	visual_return_val_if_fail (dest_width > 0 && dest_height > 0, NULL);
+	visual_return_val_if_fail (src_width > 0 && src_height > 0, NULL);
+	visual_return_val_if_fail (is_valid_scale_method (scale_method), NULL);
+
+	plan = visual_mem_new0 (VisVideoScalePlan, 1);
+
+	/* Do the VisObject initialization */
+	visual_object_initialize (VISUAL_OBJECT (plan), TRUE, video_scale_plan_dtor);
+
+	plan->method = scale_method;
+	plan->dest_width = dest_width;
+	plan->dest_height = dest_height;
+	plan->src_width = src_width;
+	plan->src_height = src_height;
+
+	visual_video_scale_plan_compute (plan);
+
+	return plan;
+}
+
+int visual_video_scale_with_plan (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan)
+{
+	VideoScaleFunc scale = NULL;
+
 	visual_return_val_if_fail (dest != NULL, -VISUAL_ERROR_VIDEO_NULL);
 	visual_return_val_if_fail (src != NULL, -VISUAL_ERROR_VIDEO_NULL);
+	visual_return_val_if_fail (plan != NULL, -VISUAL_ERROR_NULL);
 	visual_return_val_if_fail (dest->depth == src->depth, -VISUAL_ERROR_VIDEO_INVALID_DEPTH);
-	visual_return_val_if_fail (is_valid_scale_method (method), -VISUAL_ERROR_VIDEO_INVALID_SCALE_METHOD);
-
-	/* If the dest and source are equal in dimension and scale_method is nearest, do a
-	 * blit overlay */
-	if (visual_video_compare_ignore_pitch (dest, src) == TRUE && method == VISUAL_VIDEO_SCALE_NEAREST) {
-		visual_video_blit_overlay (dest, src, 0, 0, FALSE);
-
-		return VISUAL_OK;
-	}
+	visual_return_val_if_fail (scale_plan_fits (plan, dest, src), -VISUAL_ERROR_VIDEO_NOT_INDENTICAL);
 
 	switch (dest->depth) {
 		case VISUAL_VIDEO_DEPTH_8BIT:
-			if (method == VISUAL_VIDEO_SCALE_NEAREST)
-				visual_video_scale_nearest_color8 (dest, src);
-			else if (method == VISUAL_VIDEO_SCALE_BILINEAR)
-				visual_video_scale_bilinear_color8 (dest, src);
+			if (plan->method == VISUAL_VIDEO_SCALE_NEAREST)
+				scale = visual_video_scale_nearest_color8;
+			else if (plan->method == VISUAL_VIDEO_SCALE_BILINEAR)
+				scale = visual_video_scale_bilinear_color8;
+			else
+				scale = visual_video_scale_filter_color8;
 
 			break;
 
 		case VISUAL_VIDEO_DEPTH_16BIT:
-			if (method == VISUAL_VIDEO_SCALE_NEAREST)
-				visual_video_scale_nearest_color16 (dest, src);
-			else if (method == VISUAL_VIDEO_SCALE_BILINEAR)
-				visual_video_scale_bilinear_color16 (dest, src);
+			if (plan->method == VISUAL_VIDEO_SCALE_NEAREST)
+				scale = visual_video_scale_nearest_color16;
+			else if (plan->method == VISUAL_VIDEO_SCALE_BILINEAR)
+				scale = visual_video_scale_bilinear_color16;
+			else
+				scale = visual_video_scale_filter_color16;
 
 			break;
 
 		case VISUAL_VIDEO_DEPTH_24BIT:
-			if (method == VISUAL_VIDEO_SCALE_NEAREST)
-				visual_video_scale_nearest_color24 (dest, src);
-			else if (method == VISUAL_VIDEO_SCALE_BILINEAR)
-				visual_video_scale_bilinear_color24 (dest, src);
+			if (plan->method == VISUAL_VIDEO_SCALE_NEAREST)
+				scale = visual_video_scale_nearest_color24;
+			else if (plan->method == VISUAL_VIDEO_SCALE_BILINEAR)
+				scale = visual_video_scale_bilinear_color24;
+			else
+				scale = visual_video_scale_filter_color24;
 
 			break;
 
 		case VISUAL_VIDEO_DEPTH_32BIT:
-			if (method == VISUAL_VIDEO_SCALE_NEAREST)
-				visual_video_scale_nearest_color32 (dest, src);
-			else if (method == VISUAL_VIDEO_SCALE_BILINEAR) {
-				if (visual_cpu_get_mmx ())
-					_lv_scale_bilinear_32_mmx (dest, src);
+			if (plan->method == VISUAL_VIDEO_SCALE_NEAREST)
+				scale = visual_video_scale_nearest_color32;
+			else if (plan->method == VISUAL_VIDEO_SCALE_BILINEAR) {
+				if (visual_cpu_get_mmx () && _lv_video_simd.scale_bilinear_32 == NULL)
+					scale = scale_bilinear_32_mmx;
 				else
-					visual_video_scale_bilinear_color32 (dest, src);
-			}
+					scale = visual_video_scale_bilinear_color32;
+			} else
+				scale = visual_video_scale_filter_color32;
 
 			break;
 
@@ -1805,9 +2191,47 @@ int visual_video_scale (VisVideo *dest, VisVideo *src, VisVideoScaleMethod metho
 			break;
 	}
 
+	video_scale (dest, src, plan, scale);
+
 	return VISUAL_OK;
 }
 
+int visual_video_scale (VisVideo *dest, VisVideo *src, VisVideoScaleMethod method)
+{
+	VisVideoScalePlan *plan;
+
+	visual_return_val_if_fail (dest != NULL, -VISUAL_ERROR_VIDEO_NULL);
+	visual_return_val_if_fail (src != NULL, -VISUAL_ERROR_VIDEO_NULL);
+	visual_return_val_if_fail (dest->depth == src->depth, -VISUAL_ERROR_VIDEO_INVALID_DEPTH);
+	visual_return_val_if_fail (is_valid_scale_method (method), -VISUAL_ERROR_VIDEO_INVALID_SCALE_METHOD);
+
+	/* If the dest and source are equal in dimension and scale_method is nearest, do a
+	 * blit overlay */
+	if (visual_video_compare_ignore_pitch (dest, src) == TRUE && method == VISUAL_VIDEO_SCALE_NEAREST) {
+		visual_video_blit_overlay (dest, src, 0, 0, FALSE);
+
+		return VISUAL_OK;
+	}
+
+	/* The destination keeps the plan of its last scale, which holds as long as the sizes
+	 * and the method stay the same */
+	plan = dest->scale_plan;
+
+	if (plan == NULL || plan->method != method || scale_plan_fits (plan, dest, src) == FALSE) {
+		if (plan != NULL)
+			visual_object_unref (VISUAL_OBJECT (plan));
+
+		plan = visual_video_scale_plan_new (dest->width, dest->height, src->width, src->height, method);
+
+		dest->scale_plan = plan;
+
+		if (plan == NULL)
+			return -VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS;
+	}
+
+	return visual_video_scale_with_plan (dest, src, plan);
+}
+
 VisVideo *visual_video_scale_new (VisVideo *src, int width, int height, VisVideoScaleMethod scale_method)
 {
 	VisVideo *video;
@@ -1862,3 +2286,15 @@ VisVideo *visual_video_scale_depth_new (VisVideo *src, int width, int height, Vi
 
 	return video;
 }
+
+int visual_video_set_parallel_threshold (int pixels)
+{
+	__lv_video_parallel_threshold = pixels < 0 ? -1 : pixels;
+
+	return VISUAL_OK;
+}
+
+int visual_video_get_parallel_threshold ()
+{
+	return __lv_video_parallel_threshold;
+}
@@ -43,6 +43,7 @@ VISUAL_BEGIN_DECLS
 
 #define VISUAL_VIDEO(obj)						(VISUAL_CHECK_CAST ((obj), VisVideo))
 #define VISUAL_VIDEO_ATTRIBUTE_OPTIONS(obj)		(VISUAL_CHECK_CAST ((obj), VisVideoAttributeOptions))
+#define VISUAL_VIDEO_SCALE_PLAN(obj)			(VISUAL_CHECK_CAST ((obj), VisVideoScalePlan))
 
 #define VISUAL_VIDEO_ATTRIBUTE_OPTIONS_GL_ENTRY(options, attr, val)	\
 	options.gl_attributes[attr].attribute = attr;  \
@@ -94,7 +95,9 @@ typedef enum {
  */
 typedef enum {
 	VISUAL_VIDEO_SCALE_NEAREST  = 0,    /**< Nearest neighbour. */
-	VISUAL_VIDEO_SCALE_BILINEAR = 1	    /**< Bilinearly interpolated. */
+	VISUAL_VIDEO_SCALE_BILINEAR = 1,    /**< Bilinearly interpolated. */
+	VISUAL_VIDEO_SCALE_BICUBIC  = 2,    /**< Bicubic (Catmull-Rom) interpolated. */
+	VISUAL_VIDEO_SCALE_LANCZOS2 = 3     /**< Two lobed Lanczos filtered. */
 } VisVideoScaleMethod;
 
 /**
@@ -112,6 +115,7 @@ typedef enum {
 
 typedef struct _VisVideo VisVideo;
 typedef struct _VisVideoAttributeOptions VisVideoAttributeOptions;
+typedef struct _VisVideoScalePlan VisVideoScalePlan;
 
 /* VisVideo custom composite method */
 
@@ -186,6 +190,10 @@ struct _VisVideo {
 	VisVideoCustomCompositeFunc	compfunc;      /**< The surface it's custom composite function. */
 	VisColor             colorkey;  /**< The surface it's alpha colorkey. */
 	uint8_t              density;   /**< The surface it's global alpha density. */
+
+	/* Scaling */
+	VisVideoScalePlan   *scale_plan; /**< Plan cached by visual_video_scale() when this
+	                                   * surface is the destination. */
 };
 
 struct _VisVideoAttributeOptions {
@@ -194,6 +202,34 @@ struct _VisVideoAttributeOptions {
 	VisGLAttributeEntry gl_attributes[VISUAL_GL_ATTRIBUTE_LAST];
 };
 
+/**
+ * Data structure that holds the source positions and filter weights for scaling
+ * between two fixed sizes, so they don't have to be worked out again for every frame.
+ * Both axes are handled alike: every destination column (row) reads xtaps (ytaps)
+ * source columns (rows), clamped to the source, and weighs them.
+ *
+ * The tables don't depend on the depth, so one plan serves all depths.
+ *
+ * Elements within the structure should be considered read only.
+ */
+struct _VisVideoScalePlan {
+	VisObject            object;      /**< The VisObject data. */
+
+	VisVideoScaleMethod  method;      /**< The scale method the plan is made for. */
+	int                  dest_width;  /**< The destination width. */
+	int                  dest_height; /**< The destination height. */
+	int                  src_width;   /**< The source width. */
+	int                  src_height;  /**< The source height. */
+
+	int                  xtaps;       /**< Source columns read for every destination column. */
+	int                  ytaps;       /**< Source rows read for every destination row. */
+	int                 *xindex;      /**< dest_width * xtaps source columns. */
+	int                 *yindex;      /**< dest_height * ytaps source rows. */
+	int16_t             *xweight;     /**< dest_width * xtaps weights, NULL for nearest. */
+	int16_t             *yweight;     /**< dest_height * ytaps weights, NULL for nearest. */
+	uint32_t             du;          /**< Bilinear source step per column, fixed point 16.16. */
+};
+
 /**
  * Creates a new VisVideo structure, without an associated screen buffer.
  *
@@ -661,6 +697,37 @@ int visual_video_zoom_double (VisVideo *dest, VisVideo *src);
  */
 int visual_video_scale (VisVideo *dest, VisVideo *src, VisVideoScaleMethod scale_method);
 
+/**
+ * Creates a new VisVideoScalePlan, that can be used to repeatedly scale VisVideos of
+ * the given source size to the given destination size.
+ *
+ * @see visual_video_scale_with_plan
+ *
+ * @param dest_width The destination width.
+ * @param dest_height The destination height.
+ * @param src_width The source width.
+ * @param src_height The source height.
+ * @param scale_method Scaling method to use.
+ *
+ * @return A newly allocated VisVideoScalePlan, NULL on failure.
+ */
+VisVideoScalePlan *visual_video_scale_plan_new (int dest_width, int dest_height, int src_width, int src_height,
+		VisVideoScaleMethod scale_method);
+
+/**
+ * Scale VisVideo using a precomputed VisVideoScalePlan. The plan must have been made for the
+ * dimensions of both VisVideos. visual_video_scale() keeps a plan with the destination VisVideo
+ * by itself, this is for when one destination is used for several sizes or methods.
+ *
+ * @param dest Pointer to VisVideo object for storing scaled image.
+ * @param src Pointer to VisVideo object whose image is to be scaled.
+ * @param plan Pointer to the VisVideoScalePlan to use.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_NULL, -VISUAL_ERROR_NULL,
+ *	-VISUAL_ERROR_VIDEO_INVALID_DEPTH or -VISUAL_ERROR_VIDEO_NOT_INDENTICAL on failure.
+ */
+int visual_video_scale_with_plan (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan);
+
 /**
  * Scale VisVideo, and return a newly allocated scaled VisVideo.
  *
@@ -706,10 +773,33 @@ int visual_video_scale_depth (VisVideo *dest, VisVideo *src, VisVideoScaleMethod
 VisVideo *visual_video_scale_depth_new (VisVideo *src, int width, int height, VisVideoDepth depth,
 		VisVideoScaleMethod scale_method);
 
+/**
+ * Sets from what size on the VisVideo scalers, blitters, depth transformations and
+ * color fills split their work over multiple threads. The work is split into bands of
+ * rows and gives exactly the same result as doing it on one thread.
+ *
+ * @param pixels Number of destination pixels from which on to use multiple threads,
+ *	-1 to never use multiple threads.
+ *
+ * @return VISUAL_OK on success.
+ */
+int visual_video_set_parallel_threshold (int pixels);
+
+/**
+ * Gets the number of destination pixels from which on VisVideo operations are split over
+ * multiple threads.
+ *
+ * @see visual_video_set_parallel_threshold
+ *
+ * @return The threshold in pixels, -1 when VisVideo operations never use multiple threads.
+ */
+int visual_video_get_parallel_threshold (void);
+
 /* Optimized versions of performance sensitive routines */
 /* mmx from lv_video_simd.c */ /* FIXME can we do this nicer ? */
 int _lv_blit_overlay_alphasrc_mmx (VisVideo *dest, VisVideo *src);
 int _lv_scale_bilinear_32_mmx (VisVideo *dest, VisVideo *src);
+int _lv_scale_bilinear_32_mmx_rows (VisVideo *dest, VisVideo *src, int y_begin, int y_end);
 
 VISUAL_END_DECLS
 
@@ -0,0 +1,489 @@
+/* For MAP_ANONYMOUS and madvise () */
+#define _DEFAULT_SOURCE
+
+#include "config.h"
+#include "lv_video_pool.h"
+#include "lv_common.h"
+
+#if defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+
+/* Smallest size class, the classes grow in quarters of a power of two from here */
+#define VIDEO_POOL_MIN_SHIFT		12
+
+/* Largest size class base, bigger requests are not kept */
+#define VIDEO_POOL_MAX_SHIFT		(VIDEO_POOL_MIN_SHIFT + (VISUAL_VIDEO_POOL_CLASSES - 1) / 4 - 1)
+
+/* Blocks at least this big get huge pages when asked for */
+#define VIDEO_POOL_HUGEPAGE_SIZE	(2 * 1024 * 1024)
+
+typedef struct _VideoPoolBlock VideoPoolBlock;
+
+/* Sits right in front of the leased memory, padded to keep it aligned */
+struct _VideoPoolBlock {
+	VisVideoPool	*pool;
+
+	VideoPoolBlock	*prev;		/* Idle blocks of the same size class */
+	VideoPoolBlock	*next;
+	VideoPoolBlock	*older;		/* Idle blocks in release order */
+	VideoPoolBlock	*newer;
+
+	void		*base;		/* What to give back to the system */
+	visual_size_t	 size;		/* Usable size, the size of the class */
+	visual_size_t	 mapsize;	/* Non zero when mapped instead of allocated */
+	int		 sizeclass;	/* -1 for blocks too big for any class */
+	int		 refcount;
+};
+
+#define VIDEO_POOL_HEADER_SIZE	(((sizeof (VideoPoolBlock) + VISUAL_VIDEO_POOL_ALIGN - 1) / \
+			VISUAL_VIDEO_POOL_ALIGN) * VISUAL_VIDEO_POOL_ALIGN)
+
+#define VIDEO_POOL_BLOCK(data)	((VideoPoolBlock *) ((uint8_t *) (data) - VIDEO_POOL_HEADER_SIZE))
+#define VIDEO_POOL_DATA(block)	((void *) ((uint8_t *) (block) + VIDEO_POOL_HEADER_SIZE))
+
+static VisVideoPool *__lv_video_pool = NULL;
+
+static int video_pool_dtor (VisObject *object);
+
+static int pool_size_class (visual_size_t size, visual_size_t *class_size);
+
+static VideoPoolBlock *pool_block_new (VisVideoPool *pool, visual_size_t size, int sizeclass);
+static void pool_block_free (VideoPoolBlock *block);
+
+static void pool_idle_push (VisVideoPool *pool, VideoPoolBlock *block);
+static void pool_idle_remove (VisVideoPool *pool, VideoPoolBlock *block);
+static void pool_evict (VisVideoPool *pool, visual_size_t idle_limit);
+
+static void pool_lock (VisVideoPool *pool);
+static void pool_unlock (VisVideoPool *pool);
+static void pool_unref_unlock (VisVideoPool *pool);
+
+
+static int video_pool_dtor (VisObject *object)
+{
+	VisVideoPool *pool = VISUAL_VIDEO_POOL (object);
+
+	pool_evict (pool, 0);
+
+	if (pool->lock != NULL)
+		visual_mutex_free (pool->lock);
+
+	pool->lock = NULL;
+
+	return VISUAL_OK;
+}
+
+static int pool_size_class (visual_size_t size, visual_size_t *class_size)
+{
+	visual_size_t base, step;
+	int shift = VIDEO_POOL_MIN_SHIFT;
+	int quarters;
+
+	if (size <= ((visual_size_t) 1 << VIDEO_POOL_MIN_SHIFT)) {
+		*class_size = (visual_size_t) 1 << VIDEO_POOL_MIN_SHIFT;
+
+		return 0;
+	}
+
+	/* Find the power of two with base < size <= base * 2 */
+	while (((size - 1) >> shift) > 1)
+		shift++;
+
+	if (shift > VIDEO_POOL_MAX_SHIFT) {
+		*class_size = size;
+
+		return -1;
+	}
+
+	base = (visual_size_t) 1 << shift;
+	step = base / 4;
+
+	quarters = (size - base + step - 1) / step;
+	*class_size = base + quarters * step;
+
+	return (shift - VIDEO_POOL_MIN_SHIFT) * 4 + quarters;
+}
+
+static VideoPoolBlock *pool_block_new (VisVideoPool *pool, visual_size_t size, int sizeclass)
+{
+	VideoPoolBlock *block = NULL;
+	void *base;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+	if (pool->hugepages == TRUE && size + VIDEO_POOL_HEADER_SIZE >= VIDEO_POOL_HUGEPAGE_SIZE) {
+		visual_size_t mapsize = ((size + VIDEO_POOL_HEADER_SIZE + VIDEO_POOL_HUGEPAGE_SIZE - 1) /
+				VIDEO_POOL_HUGEPAGE_SIZE) * VIDEO_POOL_HUGEPAGE_SIZE;
+
+		base = mmap (NULL, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (base != MAP_FAILED) {
+			/* Only a hint, the block works either way */
+			madvise (base, mapsize, MADV_HUGEPAGE);
+
+			block = base;
+			block->mapsize = mapsize;
+		}
+	}
+#endif
+
+	if (block == NULL) {
+		base = visual_mem_malloc (size + VIDEO_POOL_HEADER_SIZE + VISUAL_VIDEO_POOL_ALIGN - 1);
+
+		if (base == NULL)
+			return NULL;
+
+		block = (VideoPoolBlock *) (((uintptr_t) base + VISUAL_VIDEO_POOL_ALIGN - 1) &
+				~((uintptr_t) VISUAL_VIDEO_POOL_ALIGN - 1));
+		block->mapsize = 0;
+	}
+
+	block->pool = pool;
+	block->prev = NULL;
+	block->next = NULL;
+	block->older = NULL;
+	block->newer = NULL;
+	block->base = base;
+	block->size = size;
+	block->sizeclass = sizeclass;
+	block->refcount = 0;
+
+	return block;
+}
+
+static void pool_block_free (VideoPoolBlock *block)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+	if (block->mapsize > 0) {
+		munmap (block->base, block->mapsize);
+
+		return;
+	}
+#endif
+
+	visual_mem_free (block->base);
+}
+
+static void pool_idle_push (VisVideoPool *pool, VideoPoolBlock *block)
+{
+	VideoPoolBlock *head = pool->classes[block->sizeclass];
+
+	block->prev = NULL;
+	block->next = head;
+
+	if (head != NULL)
+		head->prev = block;
+
+	pool->classes[block->sizeclass] = block;
+
+	block->older = pool->newest;
+	block->newer = NULL;
+
+	if (pool->newest != NULL)
+		((VideoPoolBlock *) pool->newest)->newer = block;
+	else
+		pool->oldest = block;
+
+	pool->newest = block;
+
+	pool->stats.idle++;
+	pool->stats.idle_bytes += block->size;
+}
+
+static void pool_idle_remove (VisVideoPool *pool, VideoPoolBlock *block)
+{
+	if (block->prev != NULL)
+		block->prev->next = block->next;
+	else
+		pool->classes[block->sizeclass] = block->next;
+
+	if (block->next != NULL)
+		block->next->prev = block->prev;
+
+	if (block->older != NULL)
+		block->older->newer = block->newer;
+	else
+		pool->oldest = block->newer;
+
+	if (block->newer != NULL)
+		block->newer->older = block->older;
+	else
+		pool->newest = block->older;
+
+	pool->stats.idle--;
+	pool->stats.idle_bytes -= block->size;
+}
+
+static void pool_evict (VisVideoPool *pool, visual_size_t idle_limit)
+{
+	while (pool->oldest != NULL && pool->stats.idle_bytes > idle_limit) {
+		VideoPoolBlock *block = pool->oldest;
+
+		pool_idle_remove (pool, block);
+		pool_block_free (block);
+
+		pool->stats.evictions++;
+	}
+}
+
+static void pool_lock (VisVideoPool *pool)
+{
+	if (pool->lock != NULL)
+		visual_mutex_lock (pool->lock);
+}
+
+static void pool_unlock (VisVideoPool *pool)
+{
+	if (pool->lock != NULL)
+		visual_mutex_unlock (pool->lock);
+}
+
+/* Leases ref and unref the pool with the lock held, only the last unref has
+ * to happen after unlocking, as it destroys the lock */
+static void pool_unref_unlock (VisVideoPool *pool)
+{
+	if (pool->object.refcount > 1) {
+		visual_object_unref (VISUAL_OBJECT (pool));
+		pool_unlock (pool);
+	} else {
+		pool_unlock (pool);
+		visual_object_unref (VISUAL_OBJECT (pool));
+	}
+}
+
+VisVideoPool *visual_video_pool_new (visual_size_t idle_limit)
+{
+	VisVideoPool *pool;
+
+	pool = visual_mem_new0 (VisVideoPool, 1);
+
+	/* Do the VisObject initialization */
+	visual_object_initialize (VISUAL_OBJECT (pool), TRUE, video_pool_dtor);
+
+	/* Without threads there is nobody to race with */
+	if (visual_thread_is_supported () == TRUE && visual_thread_is_enabled () == TRUE)
+		pool->lock = visual_mutex_new ();
+
+	pool->idle_limit = idle_limit;
+	pool->hugepages = FALSE;
+
+	return pool;
+}
+
+int visual_video_pool_set_idle_limit (VisVideoPool *pool, visual_size_t idle_limit)
+{
+	visual_return_val_if_fail (pool != NULL, -VISUAL_ERROR_VIDEO_POOL_NULL);
+
+	pool_lock (pool);
+
+	pool->idle_limit = idle_limit;
+	pool_evict (pool, idle_limit);
+
+	pool_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+int visual_video_pool_set_hugepages (VisVideoPool *pool, int hugepages)
+{
+	visual_return_val_if_fail (pool != NULL, -VISUAL_ERROR_VIDEO_POOL_NULL);
+
+	pool_lock (pool);
+
+	pool->hugepages = hugepages;
+
+	pool_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+void *visual_video_pool_lease (VisVideoPool *pool, visual_size_t size)
+{
+	VideoPoolBlock *block;
+	visual_size_t class_size;
+	int sizeclass;
+
+	visual_return_val_if_fail (pool != NULL, NULL);
+	visual_return_val_if_fail (size > 0, NULL);
+
+	sizeclass = pool_size_class (size, &class_size);
+
+	pool_lock (pool);
+
+	block = sizeclass >= 0 ? pool->classes[sizeclass] : NULL;
+
+	if (block != NULL) {
+		pool_idle_remove (pool, block);
+
+		pool->stats.hits++;
+	} else {
+		block = pool_block_new (pool, class_size, sizeclass);
+
+		if (block == NULL) {
+			pool_unlock (pool);
+
+			return NULL;
+		}
+
+		pool->stats.misses++;
+	}
+
+	block->refcount = 1;
+
+	pool->stats.leases++;
+	pool->stats.leased_bytes += block->size;
+
+	/* Every lease keeps the pool alive */
+	visual_object_ref (VISUAL_OBJECT (pool));
+
+	pool_unlock (pool);
+
+	return VIDEO_POOL_DATA (block);
+}
+
+int visual_video_pool_lease_ref (void *data)
+{
+	VideoPoolBlock *block;
+
+	visual_return_val_if_fail (data != NULL, -VISUAL_ERROR_NULL);
+
+	block = VIDEO_POOL_BLOCK (data);
+
+	pool_lock (block->pool);
+
+	block->refcount++;
+
+	pool_unlock (block->pool);
+
+	return VISUAL_OK;
+}
+
+int visual_video_pool_lease_unref (void *data)
+{
+	VideoPoolBlock *block;
+	VisVideoPool *pool;
+
+	visual_return_val_if_fail (data != NULL, -VISUAL_ERROR_NULL);
+
+	block = VIDEO_POOL_BLOCK (data);
+	pool = block->pool;
+
+	pool_lock (pool);
+
+	if (--block->refcount > 0) {
+		pool_unlock (pool);
+
+		return VISUAL_OK;
+	}
+
+	pool->stats.leases--;
+	pool->stats.leased_bytes -= block->size;
+
+	if (block->sizeclass >= 0) {
+		pool_idle_push (pool, block);
+		pool_evict (pool, pool->idle_limit);
+	} else {
+		pool_block_free (block);
+
+		pool->stats.evictions++;
+	}
+
+	pool_unref_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+visual_size_t visual_video_pool_lease_get_size (void *data)
+{
+	visual_return_val_if_fail (data != NULL, 0);
+
+	return VIDEO_POOL_BLOCK (data)->size;
+}
+
+void visual_video_pool_buffer_destroyer (VisBuffer *buffer)
+{
+	if (buffer->data != NULL)
+		visual_video_pool_lease_unref (buffer->data);
+
+	buffer->data = NULL;
+}
+
+int visual_video_pool_trim (VisVideoPool *pool)
+{
+	visual_return_val_if_fail (pool != NULL, -VISUAL_ERROR_VIDEO_POOL_NULL);
+
+	pool_lock (pool);
+
+	pool_evict (pool, 0);
+
+	pool_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+int visual_video_pool_get_stats (VisVideoPool *pool, VisVideoPoolStats *stats)
+{
+	visual_return_val_if_fail (pool != NULL, -VISUAL_ERROR_VIDEO_POOL_NULL);
+	visual_return_val_if_fail (stats != NULL, -VISUAL_ERROR_NULL);
+
+	pool_lock (pool);
+
+	*stats = pool->stats;
+
+	pool_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+int visual_video_pool_reset_stats (VisVideoPool *pool)
+{
+	visual_return_val_if_fail (pool != NULL, -VISUAL_ERROR_VIDEO_POOL_NULL);
+
+	pool_lock (pool);
+
+	pool->stats.hits = 0;
+	pool->stats.misses = 0;
+	pool->stats.evictions = 0;
+
+	pool_unlock (pool);
+
+	return VISUAL_OK;
+}
+
+VisVideoPool *visual_video_pool_get_default ()
+{
+	return __lv_video_pool;
+}
+
+int visual_video_pool_initialize ()
+{
+	if (__lv_video_pool != NULL)
+		return VISUAL_OK;
+
+	__lv_video_pool = visual_video_pool_new (VISUAL_VIDEO_POOL_IDLE_LIMIT);
+
+	return __lv_video_pool != NULL ? VISUAL_OK : -VISUAL_ERROR_GENERAL;
+}
+
+int visual_video_pool_is_initialized ()
+{
+	return __lv_video_pool != NULL;
+}
+
+int visual_video_pool_deinitialize ()
+{
+	VisVideoPool *pool = __lv_video_pool;
+
+	if (pool == NULL)
+		return VISUAL_OK;
+
+	__lv_video_pool = NULL;
+
+	/* VisVideos that are still around hold on to the pool through their leases */
+	pool_lock (pool);
+
+	pool_evict (pool, 0);
+	pool_unref_unlock (pool);
+
+	return VISUAL_OK;
+}
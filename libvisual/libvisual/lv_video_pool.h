@@ -0,0 +1,199 @@
+#ifndef _LV_VIDEO_POOL_H
+#define _LV_VIDEO_POOL_H
+
+#include <libvisual/lvconfig.h>
+#include <libvisual/lv_defines.h>
+#include <libvisual/lv_object.h>
+#include <libvisual/lv_buffer.h>
+#include <libvisual/lv_thread.h>
+
+/**
+ * @defgroup VisVideoPool VisVideoPool
+ * @{
+ */
+
+VISUAL_BEGIN_DECLS
+
+#define VISUAL_VIDEO_POOL(obj)				(VISUAL_CHECK_CAST ((obj), VisVideoPool))
+
+/** Alignment of the memory handed out by a VisVideoPool. */
+#define VISUAL_VIDEO_POOL_ALIGN		64
+
+/** Number of size classes, four per power of two starting at 4 KiB. */
+#define VISUAL_VIDEO_POOL_CLASSES	121
+
+/** Default amount of idle memory a VisVideoPool keeps around. */
+#define VISUAL_VIDEO_POOL_IDLE_LIMIT	(64 * 1024 * 1024)
+
+typedef struct _VisVideoPool VisVideoPool;
+typedef struct _VisVideoPoolStats VisVideoPoolStats;
+
+/**
+ * Counters of a VisVideoPool.
+ */
+struct _VisVideoPoolStats {
+	uint64_t	 hits;		/**< Leases served with an idle block. */
+	uint64_t	 misses;	/**< Leases that needed a new block. */
+	uint64_t	 evictions;	/**< Idle blocks given back to the system. */
+
+	int		 leases;	/**< Blocks currently leased out. */
+	int		 idle;		/**< Idle blocks kept for reuse. */
+	visual_size_t	 leased_bytes;	/**< Bytes currently leased out. */
+	visual_size_t	 idle_bytes;	/**< Bytes kept for reuse. */
+};
+
+/**
+ * The VisVideoPool hands out aligned pixel memory and keeps released memory around
+ * for reuse, so the VisVideo buffers that are reallocated on every negotiate and
+ * resize don't go through the allocator each time.
+ *
+ * Requests are rounded up to a size class, four per power of two, and a lease is
+ * served with an idle block of the same class when there is one. Leases are
+ * reference counted and go back to the pool when the last reference is dropped.
+ * When the idle memory grows past the idle limit, the least recently released
+ * blocks are freed. All functions can be used from any thread. Every lease holds
+ * a reference on its pool, so a pool can be unreferenced while its leases are
+ * still in use.
+ *
+ * visual_video_allocate_buffer() leases from the default pool.
+ */
+struct _VisVideoPool {
+	VisObject		 object;	/**< The VisObject data. */
+
+	VisMutex		*lock;		/**< Protects everything below, NULL without thread support. */
+
+	void			*classes[VISUAL_VIDEO_POOL_CLASSES]; /**< Private, idle blocks per size class. */
+	void			*oldest;	/**< Private, least recently released idle block. */
+	void			*newest;	/**< Private, most recently released idle block. */
+
+	visual_size_t		 idle_limit;	/**< Maximal number of idle bytes. */
+	int			 hugepages;	/**< Whether big blocks are backed by huge pages. */
+
+	VisVideoPoolStats	 stats;		/**< The counters. */
+};
+
+/**
+ * Creates a new VisVideoPool.
+ *
+ * @param idle_limit The maximal number of bytes to keep for reuse.
+ *
+ * @return A newly allocated VisVideoPool, or NULL on failure.
+ */
+VisVideoPool *visual_video_pool_new (visual_size_t idle_limit);
+
+/**
+ * Sets the maximal number of bytes to keep for reuse, idle blocks over the
+ * limit are freed right away.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ * @param idle_limit The maximal number of idle bytes, 0 to not keep any.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_POOL_NULL on failure.
+ */
+int visual_video_pool_set_idle_limit (VisVideoPool *pool, visual_size_t idle_limit);
+
+/**
+ * Sets whether new blocks of 2 MiB and more are backed by transparent huge pages,
+ * where the system supports that. Off by default.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ * @param hugepages TRUE to use huge pages, FALSE to not.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_POOL_NULL on failure.
+ */
+int visual_video_pool_set_hugepages (VisVideoPool *pool, int hugepages);
+
+/**
+ * Leases a block of memory from the pool. The block is aligned on
+ * VISUAL_VIDEO_POOL_ALIGN bytes and its content is undefined. The lease holds a
+ * reference on the pool.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ * @param size The number of bytes needed.
+ *
+ * @return The leased memory with one reference, or NULL on failure.
+ */
+void *visual_video_pool_lease (VisVideoPool *pool, visual_size_t size);
+
+/**
+ * Adds a reference to a lease, so that it can be shared without copying.
+ *
+ * @param data Memory returned by visual_video_pool_lease().
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_NULL on failure.
+ */
+int visual_video_pool_lease_ref (void *data);
+
+/**
+ * Drops a reference to a lease, the memory goes back to its pool when this was
+ * the last one.
+ *
+ * @param data Memory returned by visual_video_pool_lease().
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_NULL on failure.
+ */
+int visual_video_pool_lease_unref (void *data);
+
+/**
+ * Gets the usable size of a lease, which is the requested size rounded up to its
+ * size class.
+ *
+ * @param data Memory returned by visual_video_pool_lease().
+ *
+ * @return The size in bytes, 0 on failure.
+ */
+visual_size_t visual_video_pool_lease_get_size (void *data);
+
+/**
+ * VisBuffer destroyer for buffers holding a lease, drops the reference of the buffer.
+ *
+ * @param buffer Pointer to the VisBuffer of which the data is a lease.
+ */
+void visual_video_pool_buffer_destroyer (VisBuffer *buffer);
+
+/**
+ * Frees all idle blocks.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_POOL_NULL on failure.
+ */
+int visual_video_pool_trim (VisVideoPool *pool);
+
+/**
+ * Gets a snapshot of the counters.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ * @param stats Filled in with the counters.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_POOL_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_video_pool_get_stats (VisVideoPool *pool, VisVideoPoolStats *stats);
+
+/**
+ * Clears the hit, miss and eviction counters.
+ *
+ * @param pool Pointer to the VisVideoPool.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_VIDEO_POOL_NULL on failure.
+ */
+int visual_video_pool_reset_stats (VisVideoPool *pool);
+
+/**
+ * Gets the pool that VisVideo buffers are allocated from.
+ *
+ * @return The default VisVideoPool, or NULL when libvisual is not initialized.
+ */
+VisVideoPool *visual_video_pool_get_default (void);
+
+int visual_video_pool_initialize (void);
+int visual_video_pool_is_initialized (void);
+int visual_video_pool_deinitialize (void);
+
+VISUAL_END_DECLS
+
+/**
+ * @}
+ */
+
+#endif /* _LV_VIDEO_POOL_H */
@@ -24,6 +24,82 @@
 
 #include "lv_video.h"
 #include "lv_common.h"
+#include "lv_cpu.h"
+#include "private/lv_video_simd.h"
+
+LVVideoSimd _lv_video_simd;
+
+void _lv_video_simd_initialize ()
+{
+	/* Arranged from slow to fast, so the slower version gets overloaded
+	 * every time */
+	visual_mem_set (&_lv_video_simd, 0, sizeof (LVVideoSimd));
+
+#if defined(HAVE_SSE2)
+	if (visual_cpu_get_sse2 () > 0) {
+		_lv_video_simd.blit_alphasrc_32 = _lv_blit_alphasrc_32_sse2;
+		_lv_video_simd.blit_surfacealpha_bytes = _lv_blit_surfacealpha_bytes_sse2;
+		_lv_video_simd.blit_surfacealpha_32 = _lv_blit_surfacealpha_32_sse2;
+		_lv_video_simd.blit_surfacealpha_rgb16 = _lv_blit_surfacealpha_rgb16_sse2;
+		_lv_video_simd.blit_colorkey_8 = _lv_blit_colorkey_8_sse2;
+		_lv_video_simd.blit_colorkey_16 = _lv_blit_colorkey_16_sse2;
+		_lv_video_simd.blit_colorkey_32 = _lv_blit_colorkey_32_sse2;
+
+		_lv_video_simd.scale_bilinear_16 = _lv_scale_bilinear_16_sse2;
+		_lv_video_simd.scale_bilinear_24 = _lv_scale_bilinear_24_sse2;
+		_lv_video_simd.scale_bilinear_32 = _lv_scale_bilinear_32_sse2;
+
+		_lv_video_simd.rgb16_to_rgb24 = _lv_rgb16_to_rgb24_sse2;
+		_lv_video_simd.rgb16_to_argb32 = _lv_rgb16_to_argb32_sse2;
+		_lv_video_simd.rgb24_to_rgb16 = _lv_rgb24_to_rgb16_sse2;
+		_lv_video_simd.rgb24_to_argb32 = _lv_rgb24_to_argb32_sse2;
+		_lv_video_simd.argb32_to_rgb16 = _lv_argb32_to_rgb16_sse2;
+		_lv_video_simd.argb32_to_rgb24 = _lv_argb32_to_rgb24_sse2;
+
+		_lv_video_simd.warp_8 = _lv_warp_8_sse2;
+		_lv_video_simd.warp_32 = _lv_warp_32_sse2;
+	}
+#endif
+
+#if defined(HAVE_AVX2)
+	if (visual_cpu_get_avx2 () > 0) {
+		_lv_video_simd.blit_alphasrc_32 = _lv_blit_alphasrc_32_avx2;
+		_lv_video_simd.blit_surfacealpha_bytes = _lv_blit_surfacealpha_bytes_avx2;
+		_lv_video_simd.blit_surfacealpha_32 = _lv_blit_surfacealpha_32_avx2;
+		_lv_video_simd.blit_colorkey_32 = _lv_blit_colorkey_32_avx2;
+
+		_lv_video_simd.argb32_to_rgb16 = _lv_argb32_to_rgb16_avx2;
+	}
+#endif
+
+	/* The NEON kernels read whole pixels into registers, which only match the
+	 * byte order of the C versions on little endian hosts */
+#if defined(HAVE_NEON) && defined(VISUAL_LITTLE_ENDIAN)
+	if (visual_cpu_get_neon () > 0) {
+		_lv_video_simd.blit_alphasrc_32 = _lv_blit_alphasrc_32_neon;
+		_lv_video_simd.blit_surfacealpha_bytes = _lv_blit_surfacealpha_bytes_neon;
+		_lv_video_simd.blit_surfacealpha_32 = _lv_blit_surfacealpha_32_neon;
+		_lv_video_simd.blit_surfacealpha_rgb16 = _lv_blit_surfacealpha_rgb16_neon;
+		_lv_video_simd.blit_colorkey_8 = _lv_blit_colorkey_8_neon;
+		_lv_video_simd.blit_colorkey_16 = _lv_blit_colorkey_16_neon;
+		_lv_video_simd.blit_colorkey_32 = _lv_blit_colorkey_32_neon;
+
+		_lv_video_simd.scale_bilinear_16 = _lv_scale_bilinear_16_neon;
+		_lv_video_simd.scale_bilinear_24 = _lv_scale_bilinear_24_neon;
+		_lv_video_simd.scale_bilinear_32 = _lv_scale_bilinear_32_neon;
+
+		_lv_video_simd.rgb16_to_rgb24 = _lv_rgb16_to_rgb24_neon;
+		_lv_video_simd.rgb16_to_argb32 = _lv_rgb16_to_argb32_neon;
+		_lv_video_simd.rgb24_to_rgb16 = _lv_rgb24_to_rgb16_neon;
+		_lv_video_simd.rgb24_to_argb32 = _lv_rgb24_to_argb32_neon;
+		_lv_video_simd.argb32_to_rgb16 = _lv_argb32_to_rgb16_neon;
+		_lv_video_simd.argb32_to_rgb24 = _lv_argb32_to_rgb24_neon;
+
+		_lv_video_simd.warp_8 = _lv_warp_8_neon;
+		_lv_video_simd.warp_32 = _lv_warp_32_neon;
+	}
+#endif
+}
 
 int _lv_blit_overlay_alphasrc_mmx (VisVideo *dest, VisVideo *src)
 {
@@ -35,7 +111,8 @@ int _lv_blit_overlay_alphasrc_mmx (VisVideo *dest, VisVideo *src)
 	for (i = 0; i < src->height; i++) {
 		for (j = 0; j < src->width; j++) {
 			__asm __volatile
-				("\n\t movd %[spix], %%mm0"
+				("\n\t pxor %%mm6, %%mm6"	/* Zero for the unpacks */
+				 "\n\t movd %[spix], %%mm0"
 				 "\n\t movd %[dpix], %%mm1"
 				 "\n\t movq %%mm0, %%mm2"
 				 "\n\t movq %%mm0, %%mm3"
@@ -67,6 +144,8 @@ int _lv_blit_overlay_alphasrc_mmx (VisVideo *dest, VisVideo *src)
 		srcbuf += src->pitch - (src->width * src->bpp);
 	}
 
+	__asm__ __volatile__ ("\n\t emms");
+
 	return VISUAL_OK;
 #else /* !VISUAL_ARCH_X86 */
 	return VISUAL_ERROR_CPU_INVALID_CODE;
@@ -74,19 +153,24 @@ int _lv_blit_overlay_alphasrc_mmx (VisVideo *dest, VisVideo *src)
 }
 
 int _lv_scale_bilinear_32_mmx (VisVideo *dest, VisVideo *src)
+{
+	return _lv_scale_bilinear_32_mmx_rows (dest, src, 0, dest->height);
+}
+
+int _lv_scale_bilinear_32_mmx_rows (VisVideo *dest, VisVideo *src, int y_begin, int y_end)
 {
 #if defined(VISUAL_ARCH_X86) || defined(VISUAL_ARCH_X86_64)
-	uint32_t y;
+	int y;
 	uint32_t u, v, du, dv; /* fixed point 16.16 */
 	uint32_t *dest_pixel, *src_pixel_rowu, *src_pixel_rowl;
 
-	dest_pixel = visual_video_get_pixels (dest);
+	dest_pixel = (uint32_t *) ((uint8_t *) visual_video_get_pixels (dest) + y_begin * dest->pitch);
 
 	du = ((src->width - 1)  << 16) / dest->width;
 	dv = ((src->height - 1) << 16) / dest->height;
-	v = 0;
+	v = y_begin * dv;
 
-	for (y = dest->height; y--; v += dv) {
+	for (y = y_begin; y < y_end; y++, v += dv) {
 		uint32_t x;
 		uint32_t fracU, fracV;     /* fixed point 28.4 [0,1[    */
 
@@ -0,0 +1,290 @@
+#include "config.h"
+#include "lv_warp.h"
+#include "lv_common.h"
+#include "private/lv_video_simd.h"
+#include "private/lv_thread_pool.h"
+
+/* Bands every thread gets, so uneven bands even out */
+#define WARP_BANDS_PER_THREAD		2
+
+typedef struct {
+	VisWarpField	*field;
+	int		 bands;
+
+	/* Building */
+	VisWarpFieldFunc func;
+	void		*priv;
+	int		 transmit;
+
+	/* Applying */
+	LVWarpRowFunc	 row;
+	uint8_t		*dest;
+	const uint8_t	*src;
+	int		 dest_pitch;
+	int		 src_pitch;
+} WarpBands;
+
+static int warp_field_dtor (VisObject *object);
+
+static int warp_get_bands (int width, int height);
+static void warp_run_bands (WarpBands *bands, LVThreadPoolFunc func);
+static void warp_build_band (void *data, int index);
+static void warp_apply_band (void *data, int index);
+static void warp_set_entry (VisWarpField *field, VisWarpFieldEntry *entry, float sx, float sy, int transmit);
+static int warp_apply (VisWarpField *field, uint8_t *dest, int dest_pitch, const uint8_t *src, int src_pitch, int bpp);
+
+static void warp_row_8_c (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+static void warp_row_32_c (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+
+
+static int warp_field_dtor (VisObject *object)
+{
+	VisWarpField *field = VISUAL_WARP_FIELD (object);
+
+	if (field->entries != NULL)
+		visual_mem_free (field->entries);
+
+	field->entries = NULL;
+
+	return VISUAL_OK;
+}
+
+/* Number of row bands, split like the VisVideo operations are */
+static int warp_get_bands (int width, int height)
+{
+	int threshold = visual_video_get_parallel_threshold ();
+	int bands;
+
+	if (threshold < 0 || width * height < threshold)
+		return 1;
+
+	bands = _lv_thread_pool_get_threads () * WARP_BANDS_PER_THREAD;
+
+	if (bands <= WARP_BANDS_PER_THREAD)
+		return 1;
+
+	return bands > height ? height : bands;
+}
+
+static void warp_run_bands (WarpBands *bands, LVThreadPoolFunc func)
+{
+	bands->bands = warp_get_bands (bands->field->width, bands->field->height);
+
+	if (bands->bands <= 1)
+		func (bands, 0);
+	else
+		_lv_thread_pool_run (bands->bands, func, bands);
+}
+
+static void warp_build_band (void *data, int index)
+{
+	WarpBands *bands = data;
+	VisWarpField *field = bands->field;
+	int y_begin = index * field->height / bands->bands;
+	int y_end = (index + 1) * field->height / bands->bands;
+	int x, y;
+
+	for (y = y_begin; y < y_end; y++) {
+		VisWarpFieldEntry *entry = &field->entries[y * field->width];
+
+		for (x = 0; x < field->width; x++, entry++) {
+			float sx, sy;
+
+			if (bands->func (bands->priv, x, y, &sx, &sy) != FALSE)
+				warp_set_entry (field, entry, sx, sy, bands->transmit);
+			else
+				visual_mem_set (entry, 0, sizeof (VisWarpFieldEntry));
+		}
+	}
+}
+
+static void warp_apply_band (void *data, int index)
+{
+	WarpBands *bands = data;
+	VisWarpField *field = bands->field;
+	int y_begin = index * field->height / bands->bands;
+	int y_end = (index + 1) * field->height / bands->bands;
+	int y;
+
+	for (y = y_begin; y < y_end; y++) {
+		bands->row (bands->dest + y * bands->dest_pitch, bands->src, bands->src_pitch,
+				&field->entries[y * field->width], field->width);
+	}
+}
+
+/* The top left source pixel is kept one away from the right and bottom edge,
+ * a position on the edge gets all of its weight on the right or bottom pixels */
+static void warp_set_entry (VisWarpField *field, VisWarpFieldEntry *entry, float sx, float sy, int transmit)
+{
+	float fx, fy;
+	int ix, iy;
+	int wl, wr, tl, tr, bl, br;
+
+	if (!(sx >= 0.0f))
+		sx = 0.0f;
+	else if (sx > field->width - 1)
+		sx = field->width - 1;
+
+	if (!(sy >= 0.0f))
+		sy = 0.0f;
+	else if (sy > field->height - 1)
+		sy = field->height - 1;
+
+	ix = (int) sx;
+	iy = (int) sy;
+
+	if (ix > field->width - 2)
+		ix = field->width - 2;
+
+	if (iy > field->height - 2)
+		iy = field->height - 2;
+
+	fx = sx - ix;
+	fy = sy - iy;
+
+	/* Rounded so the weights add up to transmit exactly */
+	wr = (int) (fx * transmit + 0.5f);
+	wl = transmit - wr;
+	br = (int) (fy * wr + 0.5f);
+	tr = wr - br;
+	bl = (int) (fy * wl + 0.5f);
+	tl = wl - bl;
+
+	entry->x = ix;
+	entry->y = iy;
+	entry->weights = VISUAL_WARP_FIELD_WEIGHTS (tl, tr, bl, br);
+}
+
+static int warp_apply (VisWarpField *field, uint8_t *dest, int dest_pitch, const uint8_t *src, int src_pitch, int bpp)
+{
+	WarpBands bands;
+
+	bands.field = field;
+	bands.dest = dest;
+	bands.dest_pitch = dest_pitch;
+	bands.src = src;
+	bands.src_pitch = src_pitch;
+
+	if (bpp == 1)
+		bands.row = _lv_video_simd.warp_8 != NULL ? _lv_video_simd.warp_8 : warp_row_8_c;
+	else
+		bands.row = _lv_video_simd.warp_32 != NULL ? _lv_video_simd.warp_32 : warp_row_32_c;
+
+	warp_run_bands (&bands, warp_apply_band);
+
+	return VISUAL_OK;
+}
+
+static void warp_row_8_c (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		const uint8_t *p = src + entries[i].y * pitch + entries[i].x;
+		uint32_t w = entries[i].weights;
+
+		dest[i] = (p[0] * (w & 0xff) + p[1] * ((w >> 8) & 0xff) +
+				p[pitch] * ((w >> 16) & 0xff) + p[pitch + 1] * (w >> 24)) >> 8;
+	}
+}
+
+static void warp_row_32_c (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	int i, c;
+
+	for (i = 0; i < n; i++) {
+		const uint8_t *p = src + entries[i].y * pitch + entries[i].x * 4;
+		uint32_t w = entries[i].weights;
+		uint32_t tl = w & 0xff;
+		uint32_t tr = (w >> 8) & 0xff;
+		uint32_t bl = (w >> 16) & 0xff;
+		uint32_t br = w >> 24;
+
+		for (c = 0; c < 4; c++)
+			dest[i * 4 + c] = (p[c] * tl + p[4 + c] * tr + p[pitch + c] * bl + p[pitch + 4 + c] * br) >> 8;
+	}
+}
+
+VisWarpField *visual_warp_field_new (int width, int height)
+{
+	VisWarpField *field;
+
+	visual_return_val_if_fail (width >= 2 && width <= 65536, NULL);
+	visual_return_val_if_fail (height >= 2 && height <= 65536, NULL);
+
+	field = visual_mem_new0 (VisWarpField, 1);
+
+	/* Do the VisObject initialization */
+	visual_object_initialize (VISUAL_OBJECT (field), TRUE, warp_field_dtor);
+
+	field->width = width;
+	field->height = height;
+	field->entries = visual_mem_new0 (VisWarpFieldEntry, width * height);
+
+	return field;
+}
+
+int visual_warp_field_set_entry (VisWarpField *field, int x, int y, float sx, float sy, int transmit)
+{
+	visual_return_val_if_fail (field != NULL, -VISUAL_ERROR_WARP_FIELD_NULL);
+	visual_return_val_if_fail (x >= 0 && x < field->width, -VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS);
+	visual_return_val_if_fail (y >= 0 && y < field->height, -VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS);
+
+	transmit = transmit < 0 ? 0 : transmit > VISUAL_WARP_FIELD_WEIGHT_MAX ? VISUAL_WARP_FIELD_WEIGHT_MAX : transmit;
+
+	warp_set_entry (field, &field->entries[y * field->width + x], sx, sy, transmit);
+
+	return VISUAL_OK;
+}
+
+int visual_warp_field_build (VisWarpField *field, VisWarpFieldFunc func, void *priv, int transmit)
+{
+	WarpBands bands;
+
+	visual_return_val_if_fail (field != NULL, -VISUAL_ERROR_WARP_FIELD_NULL);
+	visual_return_val_if_fail (func != NULL, -VISUAL_ERROR_NULL);
+
+	bands.field = field;
+	bands.func = func;
+	bands.priv = priv;
+	bands.transmit = transmit < 0 ? 0 : transmit > VISUAL_WARP_FIELD_WEIGHT_MAX ? VISUAL_WARP_FIELD_WEIGHT_MAX : transmit;
+
+	warp_run_bands (&bands, warp_build_band);
+
+	return VISUAL_OK;
+}
+
+int visual_warp_field_apply (VisWarpField *field, VisVideo *dest, VisVideo *src)
+{
+	visual_return_val_if_fail (field != NULL, -VISUAL_ERROR_WARP_FIELD_NULL);
+	visual_return_val_if_fail (dest != NULL, -VISUAL_ERROR_VIDEO_NULL);
+	visual_return_val_if_fail (src != NULL, -VISUAL_ERROR_VIDEO_NULL);
+	visual_return_val_if_fail (dest->width == field->width && dest->height == field->height,
+			-VISUAL_ERROR_VIDEO_NOT_INDENTICAL);
+	visual_return_val_if_fail (src->width == field->width && src->height == field->height,
+			-VISUAL_ERROR_VIDEO_NOT_INDENTICAL);
+	visual_return_val_if_fail (dest->depth == src->depth, -VISUAL_ERROR_VIDEO_INVALID_DEPTH);
+	visual_return_val_if_fail (dest->depth == VISUAL_VIDEO_DEPTH_8BIT || dest->depth == VISUAL_VIDEO_DEPTH_32BIT,
+			-VISUAL_ERROR_VIDEO_INVALID_DEPTH);
+	visual_return_val_if_fail (visual_video_get_pixels (dest) != visual_video_get_pixels (src),
+			-VISUAL_ERROR_VIDEO_NOT_INDENTICAL);
+
+	return warp_apply (field, visual_video_get_pixels (dest), dest->pitch,
+			visual_video_get_pixels (src), src->pitch, dest->bpp);
+}
+
+int visual_warp_field_apply_8 (VisWarpField *field, uint8_t *dest, const uint8_t *src, int pitch)
+{
+	visual_return_val_if_fail (field != NULL, -VISUAL_ERROR_WARP_FIELD_NULL);
+	visual_return_val_if_fail (dest != NULL && src != NULL && dest != src, -VISUAL_ERROR_NULL);
+
+	return warp_apply (field, dest, pitch, src, pitch, 1);
+}
+
+int visual_warp_field_apply_32 (VisWarpField *field, uint32_t *dest, const uint32_t *src, int pitch)
+{
+	visual_return_val_if_fail (field != NULL, -VISUAL_ERROR_WARP_FIELD_NULL);
+	visual_return_val_if_fail (dest != NULL && src != NULL && dest != src, -VISUAL_ERROR_NULL);
+
+	return warp_apply (field, (uint8_t *) dest, pitch, (const uint8_t *) src, pitch, 4);
+}
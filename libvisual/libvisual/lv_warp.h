@@ -0,0 +1,165 @@
+#ifndef _LV_WARP_H
+#define _LV_WARP_H
+
+#include <libvisual/lvconfig.h>
+#include <libvisual/lv_defines.h>
+#include <libvisual/lv_object.h>
+#include <libvisual/lv_video.h>
+
+/**
+ * @defgroup VisWarpField VisWarpField
+ * @{
+ */
+
+VISUAL_BEGIN_DECLS
+
+#define VISUAL_WARP_FIELD(obj)				(VISUAL_CHECK_CAST ((obj), VisWarpField))
+
+/** Sum of the four weights of an entry that passes a pixel on unchanged, but for rounding. */
+#define VISUAL_WARP_FIELD_WEIGHT_MAX	255
+
+/**
+ * Packs the four weights of a VisWarpFieldEntry, for the top left, top right,
+ * bottom left and bottom right source pixel.
+ */
+#define VISUAL_WARP_FIELD_WEIGHTS(tl, tr, bl, br) \
+	((uint32_t) (tl) | ((uint32_t) (tr) << 8) | ((uint32_t) (bl) << 16) | ((uint32_t) (br) << 24))
+
+typedef struct _VisWarpField VisWarpField;
+typedef struct _VisWarpFieldEntry VisWarpFieldEntry;
+
+/**
+ * Gives the source position of a destination pixel, for visual_warp_field_build().
+ * Called from several threads at once, for every pixel once.
+ *
+ * @param priv The private data given to visual_warp_field_build().
+ * @param x The column of the destination pixel.
+ * @param y The row of the destination pixel.
+ * @param sx Set to the source column, fractions are interpolated.
+ * @param sy Set to the source row.
+ *
+ * @return TRUE when the pixel has a source, FALSE to make it black.
+ */
+typedef int (*VisWarpFieldFunc)(void *priv, int x, int y, float *sx, float *sy);
+
+/**
+ * The source of one destination pixel: the top left of the 2x2 source pixels
+ * it is interpolated from, and their weights.
+ */
+struct _VisWarpFieldEntry {
+	uint16_t		 x;		/**< Source column, at most width - 2. */
+	uint16_t		 y;		/**< Source row, at most height - 2. */
+	uint32_t		 weights;	/**< Weights of the 2x2 source pixels, see VISUAL_WARP_FIELD_WEIGHTS(). */
+};
+
+/**
+ * A VisWarpField remaps a VisVideo through a table of source positions, the
+ * feedback step of most actors: every frame is the previous one, displaced,
+ * blurred and faded, with new things drawn on top.
+ *
+ * Every destination pixel is the sum of its 2x2 source pixels times their
+ * weights, divided by 256, for every channel alike. The weights of a pixel
+ * add up to at most VISUAL_WARP_FIELD_WEIGHT_MAX, less makes it fade.
+ *
+ * The entries can be filled in by the caller, with visual_warp_field_set_entry()
+ * or visual_warp_field_build(), and are applied to 8 and 32 bits VisVideos. The
+ * field is applied in bands of rows on the thread pool, so a warp field and its
+ * VisVideos may not be changed while it is applied.
+ */
+struct _VisWarpField {
+	VisObject		 object;	/**< The VisObject data. */
+
+	int			 width;		/**< Width of the field, and of the VisVideos. */
+	int			 height;	/**< Height of the field, and of the VisVideos. */
+
+	VisWarpFieldEntry	*entries;	/**< width * height entries, row after row. */
+};
+
+/**
+ * Creates a new VisWarpField. All entries make their pixel black.
+ *
+ * @param width The width of the VisVideos the field is applied to, at least 2.
+ * @param height The height of the VisVideos the field is applied to, at least 2.
+ *
+ * @return A newly allocated VisWarpField, or NULL on failure.
+ */
+VisWarpField *visual_warp_field_new (int width, int height);
+
+/**
+ * Sets one entry from a source position. Positions are clamped to the field,
+ * fractions are turned into bilinear weights.
+ *
+ * @param field Pointer to the VisWarpField.
+ * @param x The column of the destination pixel.
+ * @param y The row of the destination pixel.
+ * @param sx The source column.
+ * @param sy The source row.
+ * @param transmit The sum of the weights, at most VISUAL_WARP_FIELD_WEIGHT_MAX,
+ *	lower values fade the pixel.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_WARP_FIELD_NULL or
+ *	-VISUAL_ERROR_VIDEO_OUT_OF_BOUNDS on failure.
+ */
+int visual_warp_field_set_entry (VisWarpField *field, int x, int y, float sx, float sy, int transmit);
+
+/**
+ * Sets all entries from a function that gives the source position of every
+ * pixel, as visual_warp_field_set_entry() does. The rows are divided over the
+ * thread pool when the field is big enough.
+ *
+ * @param field Pointer to the VisWarpField.
+ * @param func The function giving the source positions.
+ * @param priv Private data passed to func.
+ * @param transmit The sum of the weights of every entry.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_WARP_FIELD_NULL or
+ *	-VISUAL_ERROR_NULL on failure.
+ */
+int visual_warp_field_build (VisWarpField *field, VisWarpFieldFunc func, void *priv, int transmit);
+
+/**
+ * Applies the warp field: every pixel of dest is interpolated from src as its
+ * entry says. Both VisVideos need the size of the field and the same depth,
+ * 8 or 32 bits, and may not be the same.
+ *
+ * @param field Pointer to the VisWarpField.
+ * @param dest Pointer to the destination VisVideo.
+ * @param src Pointer to the source VisVideo.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_WARP_FIELD_NULL, -VISUAL_ERROR_VIDEO_NULL,
+ *	-VISUAL_ERROR_VIDEO_NOT_INDENTICAL or -VISUAL_ERROR_VIDEO_INVALID_DEPTH on failure.
+ */
+int visual_warp_field_apply (VisWarpField *field, VisVideo *dest, VisVideo *src);
+
+/**
+ * Applies the warp field to plain 8 bits buffers, as visual_warp_field_apply()
+ * does, for plugins that keep their frames outside of a VisVideo.
+ *
+ * @param field Pointer to the VisWarpField.
+ * @param dest The destination pixels.
+ * @param src The source pixels.
+ * @param pitch The number of bytes per row, the same for both.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_WARP_FIELD_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_warp_field_apply_8 (VisWarpField *field, uint8_t *dest, const uint8_t *src, int pitch);
+
+/**
+ * Applies the warp field to plain 32 bits buffers, see visual_warp_field_apply_8().
+ *
+ * @param field Pointer to the VisWarpField.
+ * @param dest The destination pixels.
+ * @param src The source pixels.
+ * @param pitch The number of bytes per row, the same for both.
+ *
+ * @return VISUAL_OK on success, -VISUAL_ERROR_WARP_FIELD_NULL or -VISUAL_ERROR_NULL on failure.
+ */
+int visual_warp_field_apply_32 (VisWarpField *field, uint32_t *dest, const uint32_t *src, int pitch);
+
+VISUAL_END_DECLS
+
+/**
+ * @}
+ */
+
+#endif /* _LV_WARP_H */
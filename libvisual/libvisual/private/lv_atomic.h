@@ -0,0 +1,85 @@
+#ifndef _LV_ATOMIC_H
+#define _LV_ATOMIC_H
+
+#include "config.h"
+
+/* Minimal atomics for the lock-free structures. Loads acquire and stores
+ * release, which is all a single producer, single consumer protocol needs.
+ * Counters are free running and compared with unsigned wraparound. */
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+
+static inline unsigned int _lv_atomic_load (volatile unsigned int *ptr)
+{
+	return __atomic_load_n (ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void _lv_atomic_store (volatile unsigned int *ptr, unsigned int value)
+{
+	__atomic_store_n (ptr, value, __ATOMIC_RELEASE);
+}
+
+static inline unsigned int _lv_atomic_add (volatile unsigned int *ptr, unsigned int value)
+{
+	return __atomic_add_fetch (ptr, value, __ATOMIC_ACQ_REL);
+}
+
+static inline void _lv_atomic_fence (void)
+{
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+}
+
+#elif defined(__GNUC__)
+
+static inline unsigned int _lv_atomic_load (volatile unsigned int *ptr)
+{
+	unsigned int value = *ptr;
+
+	__sync_synchronize ();
+
+	return value;
+}
+
+static inline void _lv_atomic_store (volatile unsigned int *ptr, unsigned int value)
+{
+	__sync_synchronize ();
+
+	*ptr = value;
+}
+
+static inline unsigned int _lv_atomic_add (volatile unsigned int *ptr, unsigned int value)
+{
+	return __sync_add_and_fetch (ptr, value);
+}
+
+static inline void _lv_atomic_fence (void)
+{
+	__sync_synchronize ();
+}
+
+#else
+
+/* No known barriers, fall back to volatile access. Good enough on strongly
+ * ordered CPUs with a compiler that does not reorder volatiles. */
+static inline unsigned int _lv_atomic_load (volatile unsigned int *ptr)
+{
+	return *ptr;
+}
+
+static inline void _lv_atomic_store (volatile unsigned int *ptr, unsigned int value)
+{
+	*ptr = value;
+}
+
+static inline unsigned int _lv_atomic_add (volatile unsigned int *ptr, unsigned int value)
+{
+	return *ptr += value;
+}
+
+static inline void _lv_atomic_fence (void)
+{
+}
+
+#endif
+
+#endif /* _LV_ATOMIC_H */
@@ -0,0 +1,127 @@
+#include "lv_fourier_simd.h"
+#include "lv_common.h"
+#include <math.h>
+
+#include <immintrin.h>
+
+void _lv_fourier_radix2_stage_avx2 (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi)
+{
+	unsigned int g, k;
+
+	for (g = 0; g < n; g += hsize * 2) {
+		float *ri = real + g;
+		float *ii = imag + g;
+		float *rj = ri + hsize;
+		float *ij = ii + hsize;
+
+		for (k = 0; k < hsize; k += 8) {
+			__m256 twr = _mm256_loadu_ps (wr + k);
+			__m256 twi = _mm256_loadu_ps (wi + k);
+			__m256 xr = _mm256_loadu_ps (rj + k);
+			__m256 xi = _mm256_loadu_ps (ij + k);
+			__m256 ar = _mm256_loadu_ps (ri + k);
+			__m256 ai = _mm256_loadu_ps (ii + k);
+
+			__m256 tr = _mm256_sub_ps (_mm256_mul_ps (twr, xr), _mm256_mul_ps (twi, xi));
+			__m256 ti = _mm256_add_ps (_mm256_mul_ps (twr, xi), _mm256_mul_ps (twi, xr));
+
+			_mm256_storeu_ps (rj + k, _mm256_sub_ps (ar, tr));
+			_mm256_storeu_ps (ij + k, _mm256_sub_ps (ai, ti));
+			_mm256_storeu_ps (ri + k, _mm256_add_ps (ar, tr));
+			_mm256_storeu_ps (ii + k, _mm256_add_ps (ai, ti));
+		}
+	}
+
+	_mm256_zeroupper ();
+}
+
+void _lv_fourier_norm_scale_avx2 (float *dest, const float *real, const float *imag, unsigned int n, float scaler)
+{
+	__m256 s = _mm256_set1_ps (scaler);
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256 r = _mm256_loadu_ps (real + i);
+		__m256 im = _mm256_loadu_ps (imag + i);
+
+		__m256 norm = _mm256_sqrt_ps (_mm256_add_ps (_mm256_mul_ps (r, r), _mm256_mul_ps (im, im)));
+
+		_mm256_storeu_ps (dest + i, _mm256_mul_ps (norm, s));
+	}
+
+	_mm256_zeroupper ();
+
+	for (; i < n; i++)
+		dest[i] = sqrtf (real[i] * real[i] + imag[i] * imag[i]) * scaler;
+}
+
+/* Eight wide version of log_ps() in lv_fourier_sse2.c */
+static __m256 log256_ps (__m256 x)
+{
+	__m256i e;
+	__m256 one = _mm256_set1_ps (1.0f);
+	__m256 fe, mask, tmp, z, y;
+
+	e = _mm256_srli_epi32 (_mm256_castps_si256 (x), 23);
+	e = _mm256_sub_epi32 (e, _mm256_set1_epi32 (0x7f));
+
+	/* Keep the mantissa, in [0.5, 1) */
+	x = _mm256_and_ps (x, _mm256_castsi256_ps (_mm256_set1_epi32 (~0x7f800000)));
+	x = _mm256_or_ps (x, _mm256_set1_ps (0.5f));
+
+	fe = _mm256_add_ps (_mm256_cvtepi32_ps (e), one);
+
+	mask = _mm256_cmp_ps (x, _mm256_set1_ps (0.707106781186547524f), _CMP_LT_OS);
+	tmp = _mm256_and_ps (x, mask);
+	x = _mm256_sub_ps (x, one);
+	fe = _mm256_sub_ps (fe, _mm256_and_ps (one, mask));
+	x = _mm256_add_ps (x, tmp);
+
+	z = _mm256_mul_ps (x, x);
+
+	y = _mm256_set1_ps (7.0376836292E-2f);
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (-1.1514610310E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (1.1676998740E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (-1.2420140846E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (1.4249322787E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (-1.6668057665E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (2.0000714765E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (-2.4999993993E-1f));
+	y = _mm256_add_ps (_mm256_mul_ps (y, x), _mm256_set1_ps (3.3333331174E-1f));
+	y = _mm256_mul_ps (_mm256_mul_ps (y, x), z);
+
+	y = _mm256_add_ps (y, _mm256_mul_ps (fe, _mm256_set1_ps (-2.12194440e-4f)));
+	y = _mm256_sub_ps (y, _mm256_mul_ps (z, _mm256_set1_ps (0.5f)));
+
+	x = _mm256_add_ps (x, y);
+	x = _mm256_add_ps (x, _mm256_mul_ps (fe, _mm256_set1_ps (0.693359375f)));
+
+	return x;
+}
+
+void _lv_fourier_log_scale_avx2 (float *dest, const float *src, unsigned int n, float threshold, float divisor)
+{
+	__m256 t = _mm256_set1_ps (threshold);
+	__m256 d = _mm256_set1_ps (1.0f / divisor);
+	__m256 one = _mm256_set1_ps (1.0f);
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256 x = _mm256_loadu_ps (src + i);
+		__m256 mask = _mm256_cmp_ps (x, t, _CMP_GT_OS);
+
+		/* Values below the threshold are masked out, keep log() away from them */
+		x = _mm256_max_ps (x, t);
+
+		_mm256_storeu_ps (dest + i, _mm256_and_ps (mask, _mm256_add_ps (one, _mm256_mul_ps (log256_ps (x), d))));
+	}
+
+	_mm256_zeroupper ();
+
+	for (; i < n; i++) {
+		if (src[i] > threshold)
+			dest[i] = 1.0f + log (src[i]) / divisor;
+		else
+			dest[i] = 0.0f;
+	}
+}
@@ -0,0 +1,162 @@
+#include "lv_fourier_simd.h"
+#include "lv_common.h"
+#include <math.h>
+
+#include <arm_neon.h>
+
+void _lv_fourier_bitrev_real_neon (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		float32x4_t a = vcombine_f32 (vld1_f32 (input + bitrev[i] * 2), vld1_f32 (input + bitrev[i + 1] * 2));
+		float32x4_t b = vcombine_f32 (vld1_f32 (input + bitrev[i + 2] * 2), vld1_f32 (input + bitrev[i + 3] * 2));
+
+		/* Deinterleave the (even, odd) pairs */
+		float32x4x2_t v = vuzpq_f32 (a, b);
+
+		vst1q_f32 (real + i, v.val[0]);
+		vst1q_f32 (imag + i, v.val[1]);
+	}
+
+	for (; i < n; i++) {
+		real[i] = input[bitrev[i] * 2];
+		imag[i] = input[bitrev[i] * 2 + 1];
+	}
+}
+
+void _lv_fourier_radix2_stage_neon (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi)
+{
+	unsigned int g, k;
+
+	for (g = 0; g < n; g += hsize * 2) {
+		float *ri = real + g;
+		float *ii = imag + g;
+		float *rj = ri + hsize;
+		float *ij = ii + hsize;
+
+		for (k = 0; k < hsize; k += 4) {
+			float32x4_t twr = vld1q_f32 (wr + k);
+			float32x4_t twi = vld1q_f32 (wi + k);
+			float32x4_t xr = vld1q_f32 (rj + k);
+			float32x4_t xi = vld1q_f32 (ij + k);
+			float32x4_t ar = vld1q_f32 (ri + k);
+			float32x4_t ai = vld1q_f32 (ii + k);
+
+			float32x4_t tr = vsubq_f32 (vmulq_f32 (twr, xr), vmulq_f32 (twi, xi));
+			float32x4_t ti = vaddq_f32 (vmulq_f32 (twr, xi), vmulq_f32 (twi, xr));
+
+			vst1q_f32 (rj + k, vsubq_f32 (ar, tr));
+			vst1q_f32 (ij + k, vsubq_f32 (ai, ti));
+			vst1q_f32 (ri + k, vaddq_f32 (ar, tr));
+			vst1q_f32 (ii + k, vaddq_f32 (ai, ti));
+		}
+	}
+}
+
+static inline float32x4_t sqrt_ps (float32x4_t x)
+{
+#if defined(__aarch64__)
+	return vsqrtq_f32 (x);
+#else
+	/* Two Newton-Raphson steps on the reciprocal square root estimate,
+	 * x * rsqrt (x) is NaN for zero so mask those out */
+	float32x4_t e = vrsqrteq_f32 (x);
+	uint32x4_t nonzero = vcgtq_f32 (x, vdupq_n_f32 (0.0f));
+
+	e = vmulq_f32 (e, vrsqrtsq_f32 (vmulq_f32 (x, e), e));
+	e = vmulq_f32 (e, vrsqrtsq_f32 (vmulq_f32 (x, e), e));
+
+	return vreinterpretq_f32_u32 (vandq_u32 (nonzero, vreinterpretq_u32_f32 (vmulq_f32 (x, e))));
+#endif
+}
+
+void _lv_fourier_norm_scale_neon (float *dest, const float *real, const float *imag, unsigned int n, float scaler)
+{
+	float32x4_t s = vdupq_n_f32 (scaler);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		float32x4_t r = vld1q_f32 (real + i);
+		float32x4_t im = vld1q_f32 (imag + i);
+
+		float32x4_t norm = sqrt_ps (vaddq_f32 (vmulq_f32 (r, r), vmulq_f32 (im, im)));
+
+		vst1q_f32 (dest + i, vmulq_f32 (norm, s));
+	}
+
+	for (; i < n; i++)
+		dest[i] = sqrtf (real[i] * real[i] + imag[i] * imag[i]) * scaler;
+}
+
+/* NEON version of log_ps() in lv_fourier_sse2.c */
+static float32x4_t log_ps (float32x4_t x)
+{
+	int32x4_t e;
+	float32x4_t one = vdupq_n_f32 (1.0f);
+	float32x4_t fe, tmp, z, y;
+	uint32x4_t mask;
+
+	e = vreinterpretq_s32_u32 (vshrq_n_u32 (vreinterpretq_u32_f32 (x), 23));
+	e = vsubq_s32 (e, vdupq_n_s32 (0x7f));
+
+	/* Keep the mantissa, in [0.5, 1) */
+	x = vreinterpretq_f32_u32 (vandq_u32 (vreinterpretq_u32_f32 (x), vdupq_n_u32 (~0x7f800000)));
+	x = vreinterpretq_f32_u32 (vorrq_u32 (vreinterpretq_u32_f32 (x), vreinterpretq_u32_f32 (vdupq_n_f32 (0.5f))));
+
+	fe = vaddq_f32 (vcvtq_f32_s32 (e), one);
+
+	mask = vcltq_f32 (x, vdupq_n_f32 (0.707106781186547524f));
+	tmp = vreinterpretq_f32_u32 (vandq_u32 (vreinterpretq_u32_f32 (x), mask));
+	x = vsubq_f32 (x, one);
+	fe = vsubq_f32 (fe, vreinterpretq_f32_u32 (vandq_u32 (vreinterpretq_u32_f32 (one), mask)));
+	x = vaddq_f32 (x, tmp);
+
+	z = vmulq_f32 (x, x);
+
+	y = vdupq_n_f32 (7.0376836292E-2f);
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (-1.1514610310E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (1.1676998740E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (-1.2420140846E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (1.4249322787E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (-1.6668057665E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (2.0000714765E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (-2.4999993993E-1f));
+	y = vaddq_f32 (vmulq_f32 (y, x), vdupq_n_f32 (3.3333331174E-1f));
+	y = vmulq_f32 (vmulq_f32 (y, x), z);
+
+	y = vaddq_f32 (y, vmulq_f32 (fe, vdupq_n_f32 (-2.12194440e-4f)));
+	y = vsubq_f32 (y, vmulq_f32 (z, vdupq_n_f32 (0.5f)));
+
+	x = vaddq_f32 (x, y);
+	x = vaddq_f32 (x, vmulq_f32 (fe, vdupq_n_f32 (0.693359375f)));
+
+	return x;
+}
+
+void _lv_fourier_log_scale_neon (float *dest, const float *src, unsigned int n, float threshold, float divisor)
+{
+	float32x4_t t = vdupq_n_f32 (threshold);
+	float32x4_t d = vdupq_n_f32 (1.0f / divisor);
+	float32x4_t one = vdupq_n_f32 (1.0f);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		float32x4_t x = vld1q_f32 (src + i);
+		uint32x4_t mask = vcgtq_f32 (x, t);
+		float32x4_t y;
+
+		/* Values below the threshold are masked out, keep log() away from them */
+		x = vmaxq_f32 (x, t);
+		y = vaddq_f32 (one, vmulq_f32 (log_ps (x), d));
+
+		vst1q_f32 (dest + i, vreinterpretq_f32_u32 (vandq_u32 (mask, vreinterpretq_u32_f32 (y))));
+	}
+
+	for (; i < n; i++) {
+		if (src[i] > threshold)
+			dest[i] = 1.0f + log (src[i]) / divisor;
+		else
+			dest[i] = 0.0f;
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef _LV_FOURIER_SIMD_H
+#define _LV_FOURIER_SIMD_H
+
+#include "config.h"
+#include "lv_fourier.h"
+
+/* SIMD kernels for VisDFT, selected at runtime by visual_fourier_initialize().
+ *
+ * bitrev_real:  real[i] = input[2 * bitrev[i]], imag[i] = input[2 * bitrev[i] + 1]
+ * radix2_stage: one radix-2 DIT pass over n points with butterflies of size
+ *               2 * hsize, wr/wi holding the hsize twiddles of that pass.
+ *               hsize must be a multiple of the kernel width (4 or 8).
+ * norm_scale:   dest[i] = sqrt (real[i]^2 + imag[i]^2) * scaler
+ * log_scale:    dest[i] = 1 + log (src[i]) / divisor, or 0 below the threshold
+ */
+
+#if defined(HAVE_SSE2)
+void _lv_fourier_bitrev_real_sse2 (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n);
+void _lv_fourier_radix2_stage_sse2 (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi);
+void _lv_fourier_norm_scale_sse2 (float *dest, const float *real, const float *imag, unsigned int n, float scaler);
+void _lv_fourier_log_scale_sse2 (float *dest, const float *src, unsigned int n, float threshold, float divisor);
+#endif
+
+#if defined(HAVE_AVX2)
+void _lv_fourier_radix2_stage_avx2 (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi);
+void _lv_fourier_norm_scale_avx2 (float *dest, const float *real, const float *imag, unsigned int n, float scaler);
+void _lv_fourier_log_scale_avx2 (float *dest, const float *src, unsigned int n, float threshold, float divisor);
+#endif
+
+#if defined(HAVE_NEON)
+void _lv_fourier_bitrev_real_neon (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n);
+void _lv_fourier_radix2_stage_neon (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi);
+void _lv_fourier_norm_scale_neon (float *dest, const float *real, const float *imag, unsigned int n, float scaler);
+void _lv_fourier_log_scale_neon (float *dest, const float *src, unsigned int n, float threshold, float divisor);
+#endif
+
+#endif /* _LV_FOURIER_SIMD_H */
@@ -0,0 +1,146 @@
+#include "lv_fourier_simd.h"
+#include "lv_common.h"
+#include <math.h>
+
+#include <emmintrin.h>
+
+void _lv_fourier_bitrev_real_sse2 (float *real, float *imag, const float *input, const unsigned int *bitrev, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128 a = _mm_setzero_ps ();
+		__m128 b = _mm_setzero_ps ();
+
+		/* Gather four (even, odd) pairs, then deinterleave them */
+		a = _mm_loadl_pi (a, (const __m64 *) (input + bitrev[i] * 2));
+		a = _mm_loadh_pi (a, (const __m64 *) (input + bitrev[i + 1] * 2));
+		b = _mm_loadl_pi (b, (const __m64 *) (input + bitrev[i + 2] * 2));
+		b = _mm_loadh_pi (b, (const __m64 *) (input + bitrev[i + 3] * 2));
+
+		_mm_storeu_ps (real + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+		_mm_storeu_ps (imag + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+	}
+
+	for (; i < n; i++) {
+		real[i] = input[bitrev[i] * 2];
+		imag[i] = input[bitrev[i] * 2 + 1];
+	}
+}
+
+void _lv_fourier_radix2_stage_sse2 (float *real, float *imag, unsigned int n, unsigned int hsize, const float *wr, const float *wi)
+{
+	unsigned int g, k;
+
+	for (g = 0; g < n; g += hsize * 2) {
+		float *ri = real + g;
+		float *ii = imag + g;
+		float *rj = ri + hsize;
+		float *ij = ii + hsize;
+
+		for (k = 0; k < hsize; k += 4) {
+			__m128 twr = _mm_loadu_ps (wr + k);
+			__m128 twi = _mm_loadu_ps (wi + k);
+			__m128 xr = _mm_loadu_ps (rj + k);
+			__m128 xi = _mm_loadu_ps (ij + k);
+			__m128 ar = _mm_loadu_ps (ri + k);
+			__m128 ai = _mm_loadu_ps (ii + k);
+
+			__m128 tr = _mm_sub_ps (_mm_mul_ps (twr, xr), _mm_mul_ps (twi, xi));
+			__m128 ti = _mm_add_ps (_mm_mul_ps (twr, xi), _mm_mul_ps (twi, xr));
+
+			_mm_storeu_ps (rj + k, _mm_sub_ps (ar, tr));
+			_mm_storeu_ps (ij + k, _mm_sub_ps (ai, ti));
+			_mm_storeu_ps (ri + k, _mm_add_ps (ar, tr));
+			_mm_storeu_ps (ii + k, _mm_add_ps (ai, ti));
+		}
+	}
+}
+
+void _lv_fourier_norm_scale_sse2 (float *dest, const float *real, const float *imag, unsigned int n, float scaler)
+{
+	__m128 s = _mm_set1_ps (scaler);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128 r = _mm_loadu_ps (real + i);
+		__m128 im = _mm_loadu_ps (imag + i);
+
+		__m128 norm = _mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (r, r), _mm_mul_ps (im, im)));
+
+		_mm_storeu_ps (dest + i, _mm_mul_ps (norm, s));
+	}
+
+	for (; i < n; i++)
+		dest[i] = sqrtf (real[i] * real[i] + imag[i] * imag[i]) * scaler;
+}
+
+/* Natural logarithm of four positive normal floats, after the Cephes logf
+ * polynomial (as used by Julien Pommier's sse_mathfun) */
+static __m128 log_ps (__m128 x)
+{
+	__m128i e;
+	__m128 one = _mm_set1_ps (1.0f);
+	__m128 fe, mask, tmp, z, y;
+
+	e = _mm_srli_epi32 (_mm_castps_si128 (x), 23);
+	e = _mm_sub_epi32 (e, _mm_set1_epi32 (0x7f));
+
+	/* Keep the mantissa, in [0.5, 1) */
+	x = _mm_and_ps (x, _mm_castsi128_ps (_mm_set1_epi32 (~0x7f800000)));
+	x = _mm_or_ps (x, _mm_set1_ps (0.5f));
+
+	fe = _mm_add_ps (_mm_cvtepi32_ps (e), one);
+
+	mask = _mm_cmplt_ps (x, _mm_set1_ps (0.707106781186547524f));
+	tmp = _mm_and_ps (x, mask);
+	x = _mm_sub_ps (x, one);
+	fe = _mm_sub_ps (fe, _mm_and_ps (one, mask));
+	x = _mm_add_ps (x, tmp);
+
+	z = _mm_mul_ps (x, x);
+
+	y = _mm_set1_ps (7.0376836292E-2f);
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (-1.1514610310E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (1.1676998740E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (-1.2420140846E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (1.4249322787E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (-1.6668057665E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (2.0000714765E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (-2.4999993993E-1f));
+	y = _mm_add_ps (_mm_mul_ps (y, x), _mm_set1_ps (3.3333331174E-1f));
+	y = _mm_mul_ps (_mm_mul_ps (y, x), z);
+
+	y = _mm_add_ps (y, _mm_mul_ps (fe, _mm_set1_ps (-2.12194440e-4f)));
+	y = _mm_sub_ps (y, _mm_mul_ps (z, _mm_set1_ps (0.5f)));
+
+	x = _mm_add_ps (x, y);
+	x = _mm_add_ps (x, _mm_mul_ps (fe, _mm_set1_ps (0.693359375f)));
+
+	return x;
+}
+
+void _lv_fourier_log_scale_sse2 (float *dest, const float *src, unsigned int n, float threshold, float divisor)
+{
+	__m128 t = _mm_set1_ps (threshold);
+	__m128 d = _mm_set1_ps (1.0f / divisor);
+	__m128 one = _mm_set1_ps (1.0f);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps (src + i);
+		__m128 mask = _mm_cmpgt_ps (x, t);
+
+		/* Values below the threshold are masked out, keep log() away from them */
+		x = _mm_max_ps (x, t);
+
+		_mm_storeu_ps (dest + i, _mm_and_ps (mask, _mm_add_ps (one, _mm_mul_ps (log_ps (x), d))));
+	}
+
+	for (; i < n; i++) {
+		if (src[i] > threshold)
+			dest[i] = 1.0f + log (src[i]) / divisor;
+		else
+			dest[i] = 0.0f;
+	}
+}
@@ -0,0 +1,608 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv_plugin_cache.h"
+#include "lv_common.h"
+#include "lv_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(VISUAL_OS_WIN32)
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#define PLUGIN_CACHE_MAGIC		"libvisual-plugin-cache"
+#define PLUGIN_CACHE_FORMAT		2
+
+/* type, plugname, name, author, version, about, help and license */
+#define PLUGIN_CACHE_STRINGS		8
+
+/* Most fields on a line, a P line */
+#define PLUGIN_CACHE_MAX_FIELDS		(3 + PLUGIN_CACHE_STRINGS)
+
+typedef struct {
+	int			 index;
+	int			 flags;
+	char			*strings[PLUGIN_CACHE_STRINGS];
+} PluginCacheInfo;
+
+typedef struct {
+	char			*file;
+	unsigned long long	 mtime;		/* In nanoseconds */
+	unsigned long long	 size;
+	unsigned long long	 inode;
+
+	PluginCacheInfo		*infos;
+	int			 count;
+	int			 filled;	/* Infos read so far while parsing */
+
+	int			 used;		/* Looked up or stored since the cache was read */
+} PluginCacheEntry;
+
+struct _LVPluginCache {
+	char			*path;
+
+	PluginCacheEntry	*entries;
+	int			 count;
+	int			 allocated;
+
+	int			 changed;
+};
+
+static char *plugin_cache_path (void);
+static int plugin_cache_stat (const char *file, PluginCacheEntry *entry);
+static PluginCacheEntry *plugin_cache_find (LVPluginCache *cache, const char *file);
+static PluginCacheEntry *plugin_cache_add (LVPluginCache *cache, const char *file);
+static void plugin_cache_entry_clear (PluginCacheEntry *entry);
+static void plugin_cache_clear (LVPluginCache *cache);
+static int plugin_cache_read (LVPluginCache *cache);
+static int plugin_cache_parse_line (LVPluginCache *cache, char *line);
+static int plugin_cache_write (LVPluginCache *cache);
+static void plugin_cache_write_string (FILE *fp, const char *str);
+static char *plugin_cache_read_string (char *str);
+static void info_get_strings (VisPluginInfo *info, const char **strings);
+static void info_set_strings (VisPluginInfo *info, char **strings, int lazy);
+
+
+static char *plugin_cache_path (void)
+{
+#if !defined(VISUAL_OS_WIN32)
+	char path[FILENAME_MAX];
+	const char *base;
+
+	base = getenv ("XDG_CACHE_HOME");
+
+	if (base != NULL && base[0] == '/') {
+		snprintf (path, sizeof (path), "%s/libvisual/plugins-%d.cache", base, VISUAL_PLUGIN_API_VERSION);
+	} else {
+		base = getenv ("HOME");
+
+		if (base == NULL)
+			return NULL;
+
+		snprintf (path, sizeof (path), "%s/.cache/libvisual/plugins-%d.cache", base, VISUAL_PLUGIN_API_VERSION);
+	}
+
+	return visual_strdup (path);
+#else
+	return NULL;
+#endif
+}
+
+static int plugin_cache_stat (const char *file, PluginCacheEntry *entry)
+{
+#if !defined(VISUAL_OS_WIN32)
+	struct stat st;
+
+	if (stat (file, &st) != 0)
+		return -1;
+
+	/* Seconds alone miss a plugin that is rebuilt within the same second */
+	entry->mtime = (unsigned long long) st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+	entry->size = st.st_size;
+	entry->inode = st.st_ino;
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/* A few dozen plugins, a linear search will do */
+static PluginCacheEntry *plugin_cache_find (LVPluginCache *cache, const char *file)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		if (strcmp (cache->entries[i].file, file) == 0)
+			return &cache->entries[i];
+	}
+
+	return NULL;
+}
+
+static PluginCacheEntry *plugin_cache_add (LVPluginCache *cache, const char *file)
+{
+	PluginCacheEntry *entry;
+
+	if (cache->count == cache->allocated) {
+		cache->allocated = cache->allocated > 0 ? cache->allocated * 2 : 64;
+		cache->entries = visual_mem_realloc (cache->entries, cache->allocated * sizeof (PluginCacheEntry));
+	}
+
+	entry = &cache->entries[cache->count++];
+	visual_mem_set (entry, 0, sizeof (PluginCacheEntry));
+
+	entry->file = visual_strdup (file);
+
+	return entry;
+}
+
+static void plugin_cache_entry_clear (PluginCacheEntry *entry)
+{
+	int i, j;
+
+	for (i = 0; i < entry->filled; i++) {
+		for (j = 0; j < PLUGIN_CACHE_STRINGS; j++) {
+			if (entry->infos[i].strings[j] != NULL)
+				visual_mem_free (entry->infos[i].strings[j]);
+		}
+	}
+
+	if (entry->infos != NULL)
+		visual_mem_free (entry->infos);
+
+	entry->infos = NULL;
+	entry->count = 0;
+	entry->filled = 0;
+}
+
+static void plugin_cache_clear (LVPluginCache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		plugin_cache_entry_clear (&cache->entries[i]);
+		visual_mem_free (cache->entries[i].file);
+	}
+
+	cache->count = 0;
+}
+
+static int plugin_cache_read (LVPluginCache *cache)
+{
+	FILE *fp;
+	char *data = NULL;
+	char *line;
+	char *next;
+	size_t size = 0;
+	size_t len = 0;
+	size_t n;
+	int i;
+
+	fp = fopen (cache->path, "rb");
+	if (fp == NULL)
+		return -1;
+
+	do {
+		if (len + 1 >= size) {
+			size = size > 0 ? size * 2 : 65536;
+			data = visual_mem_realloc (data, size);
+		}
+
+		n = fread (data + len, 1, size - len - 1, fp);
+		len += n;
+	} while (n > 0);
+
+	fclose (fp);
+
+	data[len] = '\0';
+
+	for (line = data; *line != '\0'; line = next) {
+		next = strchr (line, '\n');
+
+		/* Cut off while being written */
+		if (next == NULL)
+			goto broken;
+
+		*next++ = '\0';
+
+		if (line == data) {
+			char header[64];
+
+			snprintf (header, sizeof (header), "%s\t%d\t%d", PLUGIN_CACHE_MAGIC,
+					PLUGIN_CACHE_FORMAT, VISUAL_PLUGIN_API_VERSION);
+
+			if (strcmp (line, header) != 0)
+				goto broken;
+
+			continue;
+		}
+
+		if (plugin_cache_parse_line (cache, line) < 0)
+			goto broken;
+	}
+
+	for (i = 0; i < cache->count; i++) {
+		if (cache->entries[i].filled != cache->entries[i].count)
+			goto broken;
+	}
+
+	visual_mem_free (data);
+
+	return 0;
+
+broken:
+	visual_log (VISUAL_LOG_DEBUG, "Ignoring the broken plugin cache %s", cache->path);
+
+	plugin_cache_clear (cache);
+	visual_mem_free (data);
+
+	return -1;
+}
+
+/* F <file> <mtime in ns> <size> <inode> <count>, followed by count times
+ * P <index> <flags> <strings> */
+static int plugin_cache_parse_line (LVPluginCache *cache, char *line)
+{
+	PluginCacheEntry *entry;
+	PluginCacheInfo *info;
+	char *fields[PLUGIN_CACHE_MAX_FIELDS];
+	int nfields = 0;
+	int i;
+
+	while (nfields < PLUGIN_CACHE_MAX_FIELDS) {
+		fields[nfields++] = line;
+
+		line = strchr (line, '\t');
+		if (line == NULL)
+			break;
+
+		*line++ = '\0';
+	}
+
+	if (line != NULL)
+		return -1;
+
+	if (strcmp (fields[0], "F") == 0 && nfields == 6) {
+		char *file = plugin_cache_read_string (fields[1]);
+		int count = atoi (fields[5]);
+
+		if (file == NULL || count <= 0 || plugin_cache_find (cache, file) != NULL) {
+			if (file != NULL)
+				visual_mem_free (file);
+
+			return -1;
+		}
+
+		entry = plugin_cache_add (cache, file);
+		visual_mem_free (file);
+
+		entry->mtime = strtoull (fields[2], NULL, 10);
+		entry->size = strtoull (fields[3], NULL, 10);
+		entry->inode = strtoull (fields[4], NULL, 10);
+		entry->count = count;
+		entry->infos = visual_mem_new0 (PluginCacheInfo, count);
+
+		return 0;
+	}
+
+	if (strcmp (fields[0], "P") == 0 && nfields == PLUGIN_CACHE_MAX_FIELDS) {
+		if (cache->count == 0)
+			return -1;
+
+		entry = &cache->entries[cache->count - 1];
+
+		if (entry->filled == entry->count)
+			return -1;
+
+		info = &entry->infos[entry->filled++];
+
+		info->index = atoi (fields[1]);
+		info->flags = atoi (fields[2]);
+
+		for (i = 0; i < PLUGIN_CACHE_STRINGS; i++)
+			info->strings[i] = plugin_cache_read_string (fields[3 + i]);
+
+		return 0;
+	}
+
+	return -1;
+}
+
+static int plugin_cache_write (LVPluginCache *cache)
+{
+#if !defined(VISUAL_OS_WIN32)
+	PluginCacheEntry *entry;
+	PluginCacheInfo *info;
+	FILE *fp;
+	char *tmp;
+	char *sep;
+	int failed;
+	int fd;
+	int i, j, k;
+
+	/* Create the directories up to the cache */
+	for (sep = strchr (cache->path + 1, '/'); sep != NULL; sep = strchr (sep + 1, '/')) {
+		*sep = '\0';
+		mkdir (cache->path, 0755);
+		*sep = '/';
+	}
+
+	/* Write a new file and move it over the old one, so readers never see half of it */
+	tmp = visual_mem_malloc (strlen (cache->path) + 8);
+	sprintf (tmp, "%s.XXXXXX", cache->path);
+
+	fd = mkstemp (tmp);
+	if (fd < 0 || (fp = fdopen (fd, "wb")) == NULL) {
+		if (fd >= 0) {
+			close (fd);
+			unlink (tmp);
+		}
+
+		visual_mem_free (tmp);
+
+		return -1;
+	}
+
+	fprintf (fp, "%s\t%d\t%d\n", PLUGIN_CACHE_MAGIC, PLUGIN_CACHE_FORMAT, VISUAL_PLUGIN_API_VERSION);
+
+	for (i = 0; i < cache->count; i++) {
+		entry = &cache->entries[i];
+
+		if (entry->used == FALSE)
+			continue;
+
+		fputs ("F\t", fp);
+		plugin_cache_write_string (fp, entry->file);
+		fprintf (fp, "\t%llu\t%llu\t%llu\t%d\n", entry->mtime, entry->size, entry->inode, entry->count);
+
+		for (j = 0; j < entry->count; j++) {
+			info = &entry->infos[j];
+
+			fprintf (fp, "P\t%d\t%d", info->index, info->flags);
+
+			for (k = 0; k < PLUGIN_CACHE_STRINGS; k++) {
+				fputc ('\t', fp);
+				plugin_cache_write_string (fp, info->strings[k]);
+			}
+
+			fputc ('\n', fp);
+		}
+	}
+
+	failed = ferror (fp);
+
+	if (fclose (fp) != 0)
+		failed = TRUE;
+
+	if (failed || rename (tmp, cache->path) != 0) {
+		unlink (tmp);
+		visual_mem_free (tmp);
+
+		return -1;
+	}
+
+	visual_mem_free (tmp);
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/* Tabs and newlines separate the fields, so they are escaped. NULL is \N */
+static void plugin_cache_write_string (FILE *fp, const char *str)
+{
+	if (str == NULL) {
+		fputs ("\\N", fp);
+
+		return;
+	}
+
+	for (; *str != '\0'; str++) {
+		switch (*str) {
+			case '\\':	fputs ("\\\\", fp); break;
+			case '\t':	fputs ("\\t", fp); break;
+			case '\n':	fputs ("\\n", fp); break;
+			case '\r':	fputs ("\\r", fp); break;
+			default:	fputc (*str, fp); break;
+		}
+	}
+}
+
+static char *plugin_cache_read_string (char *str)
+{
+	char *src;
+	char *dest;
+
+	if (strcmp (str, "\\N") == 0)
+		return NULL;
+
+	for (src = dest = str; *src != '\0'; src++) {
+		if (*src == '\\' && src[1] != '\0') {
+			src++;
+
+			switch (*src) {
+				case 't':	*dest++ = '\t'; break;
+				case 'n':	*dest++ = '\n'; break;
+				case 'r':	*dest++ = '\r'; break;
+				default:	*dest++ = *src; break;
+			}
+		} else {
+			*dest++ = *src;
+		}
+	}
+
+	*dest = '\0';
+
+	return visual_strdup (str);
+}
+
+static void info_get_strings (VisPluginInfo *info, const char **strings)
+{
+	strings[0] = info->type;
+	strings[1] = info->plugname;
+	strings[2] = info->name;
+	strings[3] = info->author;
+	strings[4] = info->version;
+	strings[5] = info->about;
+	strings[6] = info->help;
+	strings[7] = info->license;
+}
+
+/* Lazy infos only get the type and name, which the registry needs */
+static void info_set_strings (VisPluginInfo *info, char **strings, int lazy)
+{
+	char *dup[PLUGIN_CACHE_STRINGS];
+	int i;
+
+	for (i = 0; i < PLUGIN_CACHE_STRINGS; i++)
+		dup[i] = strings[i] != NULL && (lazy == FALSE || i < 2) ? visual_strdup (strings[i]) : NULL;
+
+	info->type = dup[0];
+	info->plugname = dup[1];
+	info->name = dup[2];
+	info->author = dup[3];
+	info->version = dup[4];
+	info->about = dup[5];
+	info->help = dup[6];
+	info->license = dup[7];
+}
+
+LVPluginCache *_lv_plugin_cache_open (void)
+{
+	LVPluginCache *cache;
+	char *path;
+
+	path = plugin_cache_path ();
+	if (path == NULL)
+		return NULL;
+
+	cache = visual_mem_new0 (LVPluginCache, 1);
+	cache->path = path;
+
+	/* Missing or unusable, start over */
+	if (plugin_cache_read (cache) < 0)
+		cache->changed = TRUE;
+
+	return cache;
+}
+
+void _lv_plugin_cache_close (LVPluginCache *cache)
+{
+	int i;
+
+	if (cache == NULL)
+		return;
+
+	/* Drop the plugins that are gone */
+	for (i = 0; i < cache->count; i++) {
+		if (cache->entries[i].used == FALSE)
+			cache->changed = TRUE;
+	}
+
+	if (cache->changed == TRUE && plugin_cache_write (cache) < 0)
+		visual_log (VISUAL_LOG_DEBUG, "Could not write the plugin cache %s", cache->path);
+
+	plugin_cache_clear (cache);
+
+	if (cache->entries != NULL)
+		visual_mem_free (cache->entries);
+
+	visual_mem_free (cache->path);
+	visual_mem_free (cache);
+}
+
+VisPluginRef **_lv_plugin_cache_lookup (LVPluginCache *cache, const char *file, int *count, int lazy)
+{
+	PluginCacheEntry *entry;
+	PluginCacheEntry current;
+	VisPluginRef **refs;
+	int i;
+
+	if (cache == NULL)
+		return NULL;
+
+	entry = plugin_cache_find (cache, file);
+	if (entry == NULL)
+		return NULL;
+
+	/* Changed since it was cached */
+	if (plugin_cache_stat (file, &current) < 0 ||
+			current.mtime != entry->mtime ||
+			current.size != entry->size ||
+			current.inode != entry->inode)
+		return NULL;
+
+	entry->used = TRUE;
+
+	refs = visual_mem_new0 (VisPluginRef *, entry->count);
+
+	for (i = 0; i < entry->count; i++) {
+		refs[i] = visual_plugin_ref_new ();
+
+		refs[i]->index = entry->infos[i].index;
+		refs[i]->file = visual_strdup (file);
+		refs[i]->info = visual_plugin_info_new ();
+		refs[i]->info->flags = entry->infos[i].flags;
+		refs[i]->lazy = lazy;
+
+		info_set_strings (refs[i]->info, entry->infos[i].strings, lazy);
+	}
+
+	*count = entry->count;
+
+	return refs;
+}
+
+void _lv_plugin_cache_store (LVPluginCache *cache, const char *file, VisPluginRef **refs, int count)
+{
+	PluginCacheEntry *entry;
+	PluginCacheEntry current;
+	const char *strings[PLUGIN_CACHE_STRINGS];
+	int i, j;
+
+	if (cache == NULL || refs == NULL || count <= 0)
+		return;
+
+	/* Lazy references lack most of the info */
+	for (i = 0; i < count; i++) {
+		if (refs[i]->lazy != FALSE)
+			return;
+	}
+
+	if (plugin_cache_stat (file, &current) < 0)
+		return;
+
+	entry = plugin_cache_find (cache, file);
+	if (entry == NULL)
+		entry = plugin_cache_add (cache, file);
+
+	plugin_cache_entry_clear (entry);
+
+	entry->mtime = current.mtime;
+	entry->size = current.size;
+	entry->inode = current.inode;
+
+	entry->infos = visual_mem_new0 (PluginCacheInfo, count);
+	entry->count = count;
+
+	for (i = 0; i < count; i++) {
+		entry->infos[i].index = refs[i]->index;
+		entry->infos[i].flags = refs[i]->info->flags;
+
+		info_get_strings (refs[i]->info, strings);
+
+		for (j = 0; j < PLUGIN_CACHE_STRINGS; j++)
+			entry->infos[i].strings[j] = strings[j] != NULL ? visual_strdup (strings[j]) : NULL;
+
+		entry->filled++;
+	}
+
+	entry->used = TRUE;
+	cache->changed = TRUE;
+}
@@ -0,0 +1,34 @@
+#ifndef _LV_PLUGIN_CACHE_H
+#define _LV_PLUGIN_CACHE_H
+
+#include "config.h"
+#include "lv_plugin.h"
+
+/* An on-disk copy of the plugin registry, so building the registry does not
+ * have to dlopen() every plugin. Entries are keyed by the path of the plugin
+ * and remember its mtime, size and inode; an entry for a file that changed
+ * since is not used. Only plugins that loaded fine are cached, a plugin that
+ * failed is tried again next time.
+ *
+ * The cache lives in $XDG_CACHE_HOME/libvisual, or $HOME/.cache/libvisual,
+ * and is replaced as a whole when anything changed. All functions accept a
+ * NULL cache, which caches nothing. */
+
+typedef struct _LVPluginCache LVPluginCache;
+
+/* Reads the cache, returns NULL when there is no place for it */
+LVPluginCache *_lv_plugin_cache_open (void);
+
+/* Writes the cache back when it changed and frees it. Entries for plugins
+ * that were not looked up are dropped. */
+void _lv_plugin_cache_close (LVPluginCache *cache);
+
+/* Creates the references of a plugin from the cache. Returns NULL when the
+ * plugin is not cached or changed since. Lazy references only get the type,
+ * name and flags, see visual_plugin_ref_get_info(). */
+VisPluginRef **_lv_plugin_cache_lookup (LVPluginCache *cache, const char *file, int *count, int lazy);
+
+/* Remembers the references of a plugin, which must not be lazy */
+void _lv_plugin_cache_store (LVPluginCache *cache, const char *file, VisPluginRef **refs, int count);
+
+#endif /* _LV_PLUGIN_CACHE_H */
@@ -0,0 +1,221 @@
+#include "lv_thread_pool.h"
+#include "lv_common.h"
+#include "lv_cpu.h"
+
+/* Upper bound on the number of threads, including the calling thread */
+#define THREAD_POOL_MAX_THREADS		16
+
+typedef struct {
+	VisMutex		*lock;		/* Protects everything below */
+	VisMutex		*busy;		/* Held while a job runs */
+	VisCond			*wake;		/* Signalled when a job is posted or the pool quits */
+	VisCond			*finished;	/* Signalled when the last item of a job is done */
+
+	VisThread		*workers[THREAD_POOL_MAX_THREADS - 1];
+	int			 nworkers;
+	int			 started;
+	int			 quit;
+	unsigned int		 generation;	/* Bumped for every job */
+
+	LVThreadPoolFunc	 func;
+	void			*data;
+	int			 count;
+	int			 next;		/* Next item to hand out */
+	int			 done;		/* Items finished */
+} ThreadPool;
+
+static ThreadPool __lv_thread_pool;
+static int __lv_thread_pool_initialized = FALSE;
+
+static void thread_pool_start (ThreadPool *pool);
+static void thread_pool_run_items (ThreadPool *pool);
+static void *thread_pool_worker (void *data);
+
+
+static void thread_pool_start (ThreadPool *pool)
+{
+	int threads = visual_cpu_get_caps ()->nrcpu;
+	int i;
+
+	if (threads > THREAD_POOL_MAX_THREADS)
+		threads = THREAD_POOL_MAX_THREADS;
+
+	pool->started = TRUE;
+
+	for (i = 0; i < threads - 1; i++) {
+		pool->workers[pool->nworkers] = visual_thread_create (thread_pool_worker, pool, TRUE);
+
+		if (pool->workers[pool->nworkers] == NULL)
+			break;
+
+		pool->nworkers++;
+	}
+}
+
+/* Runs items of the current job until none are left, with the lock held */
+static void thread_pool_run_items (ThreadPool *pool)
+{
+	while (pool->next < pool->count) {
+		LVThreadPoolFunc func = pool->func;
+		void *data = pool->data;
+		int index = pool->next++;
+
+		visual_mutex_unlock (pool->lock);
+
+		func (data, index);
+
+		visual_mutex_lock (pool->lock);
+
+		if (++pool->done == pool->count)
+			visual_cond_signal (pool->finished);
+	}
+}
+
+static void *thread_pool_worker (void *data)
+{
+	ThreadPool *pool = data;
+	unsigned int generation;
+
+	visual_mutex_lock (pool->lock);
+
+	generation = pool->generation;
+
+	for (;;) {
+		while (pool->quit == FALSE && pool->generation == generation)
+			visual_cond_wait (pool->wake, pool->lock);
+
+		if (pool->quit == TRUE)
+			break;
+
+		generation = pool->generation;
+
+		thread_pool_run_items (pool);
+	}
+
+	visual_mutex_unlock (pool->lock);
+
+	return NULL;
+}
+
+int _lv_thread_pool_initialize ()
+{
+	ThreadPool *pool = &__lv_thread_pool;
+
+	if (__lv_thread_pool_initialized == TRUE)
+		return VISUAL_OK;
+
+	visual_mem_set (pool, 0, sizeof (ThreadPool));
+
+	if (visual_thread_is_supported () == FALSE || visual_thread_is_enabled () == FALSE)
+		return -VISUAL_ERROR_THREAD_NOT_SUPPORTED;
+
+	pool->lock = visual_mutex_new ();
+	pool->busy = visual_mutex_new ();
+	pool->wake = visual_cond_new ();
+	pool->finished = visual_cond_new ();
+
+	if (pool->lock == NULL || pool->busy == NULL || pool->wake == NULL || pool->finished == NULL) {
+		_lv_thread_pool_deinitialize ();
+
+		return -VISUAL_ERROR_THREAD_NOT_SUPPORTED;
+	}
+
+	__lv_thread_pool_initialized = TRUE;
+
+	return VISUAL_OK;
+}
+
+int _lv_thread_pool_deinitialize ()
+{
+	ThreadPool *pool = &__lv_thread_pool;
+	int i;
+
+	if (pool->nworkers > 0) {
+		visual_mutex_lock (pool->lock);
+
+		pool->quit = TRUE;
+		visual_cond_broadcast (pool->wake);
+
+		visual_mutex_unlock (pool->lock);
+
+		for (i = 0; i < pool->nworkers; i++) {
+			visual_thread_join (pool->workers[i]);
+			visual_thread_free (pool->workers[i]);
+		}
+	}
+
+	if (pool->lock != NULL)
+		visual_mutex_free (pool->lock);
+
+	if (pool->busy != NULL)
+		visual_mutex_free (pool->busy);
+
+	if (pool->wake != NULL)
+		visual_cond_free (pool->wake);
+
+	if (pool->finished != NULL)
+		visual_cond_free (pool->finished);
+
+	visual_mem_set (pool, 0, sizeof (ThreadPool));
+
+	__lv_thread_pool_initialized = FALSE;
+
+	return VISUAL_OK;
+}
+
+int _lv_thread_pool_get_threads ()
+{
+	int threads;
+
+	if (__lv_thread_pool_initialized == FALSE)
+		return 1;
+
+	if (__lv_thread_pool.started == TRUE)
+		return __lv_thread_pool.nworkers + 1;
+
+	threads = visual_cpu_get_caps ()->nrcpu;
+
+	return threads > THREAD_POOL_MAX_THREADS ? THREAD_POOL_MAX_THREADS : threads;
+}
+
+void _lv_thread_pool_run (int count, LVThreadPoolFunc func, void *data)
+{
+	ThreadPool *pool = &__lv_thread_pool;
+	int i;
+
+	if (count <= 0)
+		return;
+
+	/* Run serially when there is no pool, or another job is using it */
+	if (__lv_thread_pool_initialized == FALSE || count == 1 || visual_thread_is_enabled () == FALSE ||
+			visual_mutex_trylock (pool->busy) != VISUAL_OK) {
+		for (i = 0; i < count; i++)
+			func (data, i);
+
+		return;
+	}
+
+	if (pool->started == FALSE)
+		thread_pool_start (pool);
+
+	visual_mutex_lock (pool->lock);
+
+	pool->func = func;
+	pool->data = data;
+	pool->count = count;
+	pool->next = 0;
+	pool->done = 0;
+
+	pool->generation++;
+	visual_cond_broadcast (pool->wake);
+
+	/* Lend a hand, then wait for the items the workers picked up */
+	thread_pool_run_items (pool);
+
+	while (pool->done < pool->count)
+		visual_cond_wait (pool->finished, pool->lock);
+
+	visual_mutex_unlock (pool->lock);
+
+	visual_mutex_unlock (pool->busy);
+}
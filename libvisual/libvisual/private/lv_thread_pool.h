@@ -0,0 +1,25 @@
+#ifndef _LV_THREAD_POOL_H
+#define _LV_THREAD_POOL_H
+
+#include "config.h"
+#include "lv_thread.h"
+
+/* A small pool of worker threads for splitting work, such as the VisVideo
+ * kernels, into independent items.
+ *
+ * The workers are started on first use. One job runs at a time, a job that is
+ * submitted while the pool is busy, or from inside a job, runs serially on the
+ * calling thread. Every item runs exactly once, in no particular order. */
+
+typedef void (*LVThreadPoolFunc) (void *data, int index);
+
+int _lv_thread_pool_initialize (void);
+int _lv_thread_pool_deinitialize (void);
+
+/* Number of threads a job is split over, including the calling thread */
+int _lv_thread_pool_get_threads (void);
+
+/* Runs func for every index in [0, count), returns when all of them are done */
+void _lv_thread_pool_run (int count, LVThreadPoolFunc func, void *data);
+
+#endif /* _LV_THREAD_POOL_H */
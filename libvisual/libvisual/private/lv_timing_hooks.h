@@ -0,0 +1,42 @@
+#ifndef _LV_TIMING_HOOKS_H
+#define _LV_TIMING_HOOKS_H
+
+#include "config.h"
+#include "lv_timing.h"
+
+/* Instrumentation points for a VisTiming that may be NULL. Without
+ * VISUAL_HAVE_TIMING they compile to nothing, so put _LV_TIMING_DECLARE last
+ * in the declarations. The clock is only read while a VisTiming is attached. */
+
+#ifdef VISUAL_HAVE_TIMING
+
+#define _LV_TIMING_DECLARE(var)			uint64_t var = 0
+
+#define _LV_TIMING_BEGIN(timing, var)					\
+	do {								\
+		if ((timing) != NULL)					\
+			var = visual_timing_now ();			\
+	} while (0)
+
+#define _LV_TIMING_END(timing, var, stage, track)			\
+	do {								\
+		if ((timing) != NULL)					\
+			visual_timing_record ((timing), (stage), (track), var, visual_timing_now ()); \
+	} while (0)
+
+#define _LV_TIMING_NEXT_FRAME(timing)					\
+	do {								\
+		if ((timing) != NULL)					\
+			visual_timing_next_frame ((timing));		\
+	} while (0)
+
+#else
+
+#define _LV_TIMING_DECLARE(var)
+#define _LV_TIMING_BEGIN(timing, var)			do { } while (0)
+#define _LV_TIMING_END(timing, var, stage, track)	do { } while (0)
+#define _LV_TIMING_NEXT_FRAME(timing)			do { } while (0)
+
+#endif /* VISUAL_HAVE_TIMING */
+
+#endif /* _LV_TIMING_HOOKS_H */
@@ -0,0 +1,145 @@
+#include "lv_video_simd.h"
+#include "lv_common.h"
+
+#include <immintrin.h>
+
+/* The 256 bits versions of the streaming kernels in lv_video_sse2.c, the
+ * unpacks and packs stay within 128 bits lanes so the pixel order holds. The
+ * tails are left to the SSE2 kernels. */
+
+static inline __m256i blend_shift8 (__m256i d, __m256i s, __m256i a)
+{
+	__m256i diff = _mm256_sub_epi16 (s, d);
+	__m256i lo = _mm256_mullo_epi16 (diff, a);
+	__m256i hi = _mm256_mulhi_epi16 (diff, a);
+
+	return _mm256_add_epi16 (d, _mm256_or_si256 (_mm256_srli_epi16 (lo, 8), _mm256_slli_epi16 (hi, 8)));
+}
+
+static inline __m256i blend_div255 (__m256i s1, __m256i s2, __m256i a)
+{
+	__m256i sign = _mm256_cmpgt_epi16 (s1, s2);
+	__m256i diff = _mm256_sub_epi16 (_mm256_xor_si256 (_mm256_sub_epi16 (s2, s1), sign), sign);
+	__m256i p = _mm256_mullo_epi16 (diff, a);
+
+	p = _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_add_epi16 (p, _mm256_set1_epi16 (1)), _mm256_srli_epi16 (p, 8)), 8);
+
+	return _mm256_add_epi16 (s1, _mm256_sub_epi16 (_mm256_xor_si256 (p, sign), sign));
+}
+
+void _lv_alpha_blend_bytes_avx2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
+{
+	__m256i zero = _mm256_setzero_si256 ();
+	__m256i a = _mm256_set1_epi16 (alpha);
+	visual_size_t i;
+
+	for (i = 0; i + 32 <= size; i += 32) {
+		__m256i x = _mm256_loadu_si256 ((const __m256i *) (src1 + i));
+		__m256i y = _mm256_loadu_si256 ((const __m256i *) (src2 + i));
+		__m256i lo = blend_div255 (_mm256_unpacklo_epi8 (x, zero), _mm256_unpacklo_epi8 (y, zero), a);
+		__m256i hi = blend_div255 (_mm256_unpackhi_epi8 (x, zero), _mm256_unpackhi_epi8 (y, zero), a);
+
+		_mm256_storeu_si256 ((__m256i *) (dest + i), _mm256_packus_epi16 (lo, hi));
+	}
+
+	_lv_alpha_blend_bytes_sse2 (dest + i, src1 + i, src2 + i, size - i, alpha);
+}
+
+void _lv_blit_alphasrc_32_avx2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	__m256i zero = _mm256_setzero_si256 ();
+	__m256i mask = _mm256_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i s = _mm256_loadu_si256 ((const __m256i *) (src + i * 4));
+		__m256i d = _mm256_loadu_si256 ((const __m256i *) (dest + i * 4));
+		__m256i slo = _mm256_unpacklo_epi8 (s, zero);
+		__m256i shi = _mm256_unpackhi_epi8 (s, zero);
+		__m256i alo = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (slo, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+		__m256i ahi = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (shi, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+		__m256i lo = blend_shift8 (_mm256_unpacklo_epi8 (d, zero), slo, _mm256_and_si256 (alo, mask));
+		__m256i hi = blend_shift8 (_mm256_unpackhi_epi8 (d, zero), shi, _mm256_and_si256 (ahi, mask));
+
+		_mm256_storeu_si256 ((__m256i *) (dest + i * 4), _mm256_packus_epi16 (lo, hi));
+	}
+
+	_lv_blit_alphasrc_32_sse2 (dest + i * 4, src + i * 4, n - i);
+}
+
+void _lv_blit_surfacealpha_bytes_avx2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	__m256i zero = _mm256_setzero_si256 ();
+	__m256i a = _mm256_set1_epi16 (alpha);
+	int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i s = _mm256_loadu_si256 ((const __m256i *) (src + i));
+		__m256i d = _mm256_loadu_si256 ((const __m256i *) (dest + i));
+		__m256i lo = blend_shift8 (_mm256_unpacklo_epi8 (d, zero), _mm256_unpacklo_epi8 (s, zero), a);
+		__m256i hi = blend_shift8 (_mm256_unpackhi_epi8 (d, zero), _mm256_unpackhi_epi8 (s, zero), a);
+
+		_mm256_storeu_si256 ((__m256i *) (dest + i), _mm256_packus_epi16 (lo, hi));
+	}
+
+	_lv_blit_surfacealpha_bytes_sse2 (dest + i, src + i, n - i, alpha);
+}
+
+void _lv_blit_surfacealpha_32_avx2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	__m256i zero = _mm256_setzero_si256 ();
+	__m256i a = _mm256_set_epi16 (0, alpha, alpha, alpha, 0, alpha, alpha, alpha,
+			0, alpha, alpha, alpha, 0, alpha, alpha, alpha);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i s = _mm256_loadu_si256 ((const __m256i *) (src + i * 4));
+		__m256i d = _mm256_loadu_si256 ((const __m256i *) (dest + i * 4));
+		__m256i lo = blend_shift8 (_mm256_unpacklo_epi8 (d, zero), _mm256_unpacklo_epi8 (s, zero), a);
+		__m256i hi = blend_shift8 (_mm256_unpackhi_epi8 (d, zero), _mm256_unpackhi_epi8 (s, zero), a);
+
+		_mm256_storeu_si256 ((__m256i *) (dest + i * 4), _mm256_packus_epi16 (lo, hi));
+	}
+
+	_lv_blit_surfacealpha_32_sse2 (dest + i * 4, src + i * 4, n - i, alpha);
+}
+
+void _lv_blit_colorkey_32_avx2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	__m256i k = _mm256_set1_epi32 (key);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i s = _mm256_loadu_si256 ((const __m256i *) (src + i * 4));
+		__m256i d = _mm256_loadu_si256 ((const __m256i *) (dest + i * 4));
+
+		_mm256_storeu_si256 ((__m256i *) (dest + i * 4), _mm256_blendv_epi8 (s, d, _mm256_cmpeq_epi32 (s, k)));
+	}
+
+	_lv_blit_colorkey_32_sse2 (dest + i * 4, src + i * 4, n - i, key);
+}
+
+void _lv_argb32_to_rgb16_avx2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i lo = _mm256_loadu_si256 ((const __m256i *) (src + i * 4));
+		__m256i hi = _mm256_loadu_si256 ((const __m256i *) (src + i * 4 + 32));
+
+		lo = _mm256_or_si256 (_mm256_or_si256 (
+					_mm256_and_si256 (_mm256_srli_epi32 (lo, 3), _mm256_set1_epi32 (0x001f)),
+					_mm256_and_si256 (_mm256_srli_epi32 (lo, 5), _mm256_set1_epi32 (0x07e0))),
+				_mm256_and_si256 (_mm256_srli_epi32 (lo, 8), _mm256_set1_epi32 (0xf800)));
+		hi = _mm256_or_si256 (_mm256_or_si256 (
+					_mm256_and_si256 (_mm256_srli_epi32 (hi, 3), _mm256_set1_epi32 (0x001f)),
+					_mm256_and_si256 (_mm256_srli_epi32 (hi, 5), _mm256_set1_epi32 (0x07e0))),
+				_mm256_and_si256 (_mm256_srli_epi32 (hi, 8), _mm256_set1_epi32 (0xf800)));
+
+		/* The pack interleaves the 128 bits lanes, the permute puts them back */
+		_mm256_storeu_si256 ((__m256i *) (dest + i * 2),
+				_mm256_permute4x64_epi64 (_mm256_packus_epi32 (lo, hi), _MM_SHUFFLE (3, 1, 2, 0)));
+	}
+
+	_lv_argb32_to_rgb16_sse2 (dest + i * 2, src + i * 4, n - i);
+}
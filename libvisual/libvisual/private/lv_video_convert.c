@@ -1,4 +1,5 @@
 #include "lv_video_convert.h"
+#include "lv_video_simd.h"
 #include "lv_common.h"
 
 #pragma pack(1)
@@ -13,6 +14,26 @@ typedef struct {
 
 #pragma pack()
 
+static void convert_rows (VisVideo *dest, VisVideo *src, LVConvertRowFunc convert);
+
+static void convert_rows (VisVideo *dest, VisVideo *src, LVConvertRowFunc convert)
+{
+	uint8_t *dbuf = visual_video_get_pixels (dest);
+	uint8_t *sbuf = visual_video_get_pixels (src);
+	int y;
+	int w;
+	int h;
+
+	visual_video_convert_get_smallest (dest, src, &w, &h);
+
+	for (y = 0; y < h; y++) {
+		convert (dbuf, sbuf, w);
+
+		dbuf += dest->pitch;
+		sbuf += src->pitch;
+	}
+}
+
 void visual_video_convert_get_smallest (VisVideo *dest, VisVideo *src, int *width, int *height)
 {
 	*width = dest->width > src->width ? src->width : dest->width;
@@ -179,6 +200,12 @@ void visual_video_rgb16_to_rgb24 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.rgb16_to_rgb24 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.rgb16_to_rgb24);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = dest->pitch - (w * dest->bpp);
@@ -215,6 +242,12 @@ void visual_video_rgb16_to_argb32 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.rgb16_to_argb32 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.rgb16_to_argb32);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = dest->pitch - (w * dest->bpp);
@@ -298,6 +331,12 @@ void visual_video_rgb24_to_rgb16 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.rgb24_to_rgb16 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.rgb24_to_rgb16);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = dest->pitch - (w * dest->bpp);
@@ -334,6 +373,12 @@ void visual_video_rgb24_to_argb32 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.rgb24_to_argb32 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.rgb24_to_argb32);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = dest->pitch - (w * dest->bpp);
@@ -418,6 +463,12 @@ void visual_video_argb32_to_rgb16 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.argb32_to_rgb16 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.argb32_to_rgb16);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = (dest->pitch / dest->bpp) - w;
@@ -457,6 +508,12 @@ void visual_video_argb32_to_rgb24 (VisVideo *dest, VisVideo *src)
 	int ddiff;
 	int sdiff;
 
+	if (_lv_video_simd.argb32_to_rgb24 != NULL) {
+		convert_rows (dest, src, _lv_video_simd.argb32_to_rgb24);
+
+		return;
+	}
+
 	visual_video_convert_get_smallest (dest, src, &w, &h);
 
 	ddiff = dest->pitch - (w * dest->bpp);
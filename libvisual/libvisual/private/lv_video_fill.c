@@ -71,16 +71,20 @@ void visual_video_fill_color_rgb24 (VisVideo *video, VisColor *color)
 	for (y = 0; y < video->height; y++) {
 		buf = (uint32_t *) rbuf;
 
-		for (x = video->width; x >= video->bpp; x -= video->bpp) {
+		/* Every three words hold four pixels */
+		for (x = video->width; x >= 4; x -= 4) {
 			*(buf++) = cola;
 			*(buf++) = colb;
 			*(buf++) = colc;
 		}
 
 		buf8 = (uint8_t *) buf;
-		*(buf8++) = color->b;
-		*(buf8++) = color->g;
-		*(buf8++) = color->r;
+
+		for (; x > 0; x--) {
+			*(buf8++) = color->b;
+			*(buf8++) = color->g;
+			*(buf8++) = color->r;
+		}
 
 
 		rbuf += video->pitch;
@@ -0,0 +1,545 @@
+#include "lv_video_simd.h"
+#include "lv_common.h"
+
+#include <string.h>
+#include <arm_neon.h>
+
+/* d + ((a * (s - d)) >> 8), for a, s and d in [0, 255] */
+static inline uint8x8_t blend_shift8 (uint8x8_t d, uint8x8_t s, int16x8_t a)
+{
+	int16x8_t diff = vreinterpretq_s16_u16 (vsubl_u8 (s, d));
+	int32x4_t lo = vmull_s16 (vget_low_s16 (diff), vget_low_s16 (a));
+	int32x4_t hi = vmull_s16 (vget_high_s16 (diff), vget_high_s16 (a));
+	int16x8_t t = vcombine_s16 (vshrn_n_s32 (lo, 8), vshrn_n_s32 (hi, 8));
+
+	return vqmovun_s16 (vaddq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (d)), t));
+}
+
+/* The same on 16 bit lanes holding rgb16 fields, the products fit in 16 bits */
+static inline uint16x8_t blend_shift8_16 (uint16x8_t d, uint16x8_t s, int16x8_t a)
+{
+	int16x8_t diff = vreinterpretq_s16_u16 (vsubq_u16 (s, d));
+
+	return vreinterpretq_u16_s16 (vaddq_s16 (vreinterpretq_s16_u16 (d), vshrq_n_s16 (vmulq_s16 (diff, a), 8)));
+}
+
+/* s1 + (a * (s2 - s1)) / 255, rounding towards zero like C */
+static inline uint8x8_t blend_div255 (uint8x8_t s1, uint8x8_t s2, uint8x8_t a)
+{
+	uint16x8_t p = vmull_u8 (vabd_u8 (s1, s2), a);
+
+	/* x / 255 == (x + 1 + (x >> 8)) >> 8 for x below 65535 */
+	uint8x8_t q = vshrn_n_u16 (vaddq_u16 (vaddq_u16 (p, vdupq_n_u16 (1)), vshrq_n_u16 (p, 8)), 8);
+
+	return vbsl_u8 (vcgt_u8 (s1, s2), vsub_u8 (s1, q), vadd_u8 (s1, q));
+}
+
+static inline uint16x8_t blend_div255_16 (uint16x8_t s1, uint16x8_t s2, uint16x8_t a)
+{
+	uint16x8_t p = vmulq_u16 (vabdq_u16 (s1, s2), a);
+	uint16x8_t q = vshrq_n_u16 (vaddq_u16 (vaddq_u16 (p, vdupq_n_u16 (1)), vshrq_n_u16 (p, 8)), 8);
+
+	return vbslq_u16 (vcgtq_u16 (s1, s2), vsubq_u16 (s1, q), vaddq_u16 (s1, q));
+}
+
+void _lv_alpha_blend_bytes_neon (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
+{
+	uint8x8_t a = vdup_n_u8 (alpha);
+	visual_size_t i;
+
+	for (i = 0; i + 16 <= size; i += 16) {
+		uint8x16_t x = vld1q_u8 (src1 + i);
+		uint8x16_t y = vld1q_u8 (src2 + i);
+
+		vst1q_u8 (dest + i, vcombine_u8 (blend_div255 (vget_low_u8 (x), vget_low_u8 (y), a),
+					blend_div255 (vget_high_u8 (x), vget_high_u8 (y), a)));
+	}
+
+	for (; i < size; i++)
+		dest[i] = (alpha * (src2[i] - src1[i])) / 255 + src1[i];
+}
+
+void _lv_alpha_blend_16_neon (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
+{
+	uint16_t *destr = (uint16_t *) dest;
+	uint16_t *src1r = (uint16_t *) src1;
+	uint16_t *src2r = (uint16_t *) src2;
+	uint16x8_t a = vdupq_n_u16 (alpha);
+	uint16x8_t mask5 = vdupq_n_u16 (0x1f);
+	uint16x8_t mask6 = vdupq_n_u16 (0x3f);
+	visual_size_t n = size / 2;
+	visual_size_t i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t x = vld1q_u16 (src1r + i);
+		uint16x8_t y = vld1q_u16 (src2r + i);
+		uint16x8_t r = blend_div255_16 (vshrq_n_u16 (x, 11), vshrq_n_u16 (y, 11), a);
+		uint16x8_t g = blend_div255_16 (vandq_u16 (vshrq_n_u16 (x, 5), mask6), vandq_u16 (vshrq_n_u16 (y, 5), mask6), a);
+		uint16x8_t b = blend_div255_16 (vandq_u16 (x, mask5), vandq_u16 (y, mask5), a);
+
+		vst1q_u16 (destr + i, vorrq_u16 (vorrq_u16 (vshlq_n_u16 (r, 11), vshlq_n_u16 (g, 5)), b));
+	}
+
+	for (; i < n; i++) {
+		int x = src1r[i];
+		int y = src2r[i];
+		int r = (alpha * ((y >> 11) - (x >> 11))) / 255 + (x >> 11);
+		int g = (alpha * (((y >> 5) & 0x3f) - ((x >> 5) & 0x3f))) / 255 + ((x >> 5) & 0x3f);
+		int b = (alpha * ((y & 0x1f) - (x & 0x1f))) / 255 + (x & 0x1f);
+
+		destr[i] = (r << 11) | (g << 5) | b;
+	}
+}
+
+void _lv_blit_alphasrc_32_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x4_t s = vld4_u8 (src + i * 4);
+		uint8x8x4_t d = vld4_u8 (dest + i * 4);
+		int16x8_t a = vreinterpretq_s16_u16 (vmovl_u8 (s.val[3]));
+
+		/* The alpha of the destination stays */
+		d.val[0] = blend_shift8 (d.val[0], s.val[0], a);
+		d.val[1] = blend_shift8 (d.val[1], s.val[1], a);
+		d.val[2] = blend_shift8 (d.val[2], s.val[2], a);
+
+		vst4_u8 (dest + i * 4, d);
+	}
+
+	for (; i < n; i++) {
+		uint8_t *d = dest + i * 4;
+		const uint8_t *s = src + i * 4;
+		uint8_t alpha = s[3];
+
+		d[0] = ((alpha * (s[0] - d[0]) >> 8) + d[0]);
+		d[1] = ((alpha * (s[1] - d[1]) >> 8) + d[1]);
+		d[2] = ((alpha * (s[2] - d[2]) >> 8) + d[2]);
+	}
+}
+
+void _lv_blit_surfacealpha_bytes_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	int16x8_t a = vdupq_n_s16 (alpha);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16_t s = vld1q_u8 (src + i);
+		uint8x16_t d = vld1q_u8 (dest + i);
+
+		vst1q_u8 (dest + i, vcombine_u8 (blend_shift8 (vget_low_u8 (d), vget_low_u8 (s), a),
+					blend_shift8 (vget_high_u8 (d), vget_high_u8 (s), a)));
+	}
+
+	for (; i < n; i++)
+		dest[i] = ((alpha * (src[i] - dest[i]) >> 8) + dest[i]);
+}
+
+void _lv_blit_surfacealpha_32_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	int16x8_t a = vdupq_n_s16 (alpha);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x4_t s = vld4_u8 (src + i * 4);
+		uint8x8x4_t d = vld4_u8 (dest + i * 4);
+
+		d.val[0] = blend_shift8 (d.val[0], s.val[0], a);
+		d.val[1] = blend_shift8 (d.val[1], s.val[1], a);
+		d.val[2] = blend_shift8 (d.val[2], s.val[2], a);
+
+		vst4_u8 (dest + i * 4, d);
+	}
+
+	for (; i < n; i++) {
+		uint8_t *d = dest + i * 4;
+		const uint8_t *s = src + i * 4;
+
+		d[0] = ((alpha * (s[0] - d[0]) >> 8) + d[0]);
+		d[1] = ((alpha * (s[1] - d[1]) >> 8) + d[1]);
+		d[2] = ((alpha * (s[2] - d[2]) >> 8) + d[2]);
+	}
+}
+
+void _lv_blit_surfacealpha_rgb16_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	uint16_t *destr = (uint16_t *) dest;
+	const uint16_t *srcr = (const uint16_t *) src;
+	int16x8_t a = vdupq_n_s16 (alpha);
+	uint16x8_t mask5 = vdupq_n_u16 (0x1f);
+	uint16x8_t mask6 = vdupq_n_u16 (0x3f);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t s = vld1q_u16 (srcr + i);
+		uint16x8_t d = vld1q_u16 (destr + i);
+		uint16x8_t r = blend_shift8_16 (vshrq_n_u16 (d, 11), vshrq_n_u16 (s, 11), a);
+		uint16x8_t g = blend_shift8_16 (vandq_u16 (vshrq_n_u16 (d, 5), mask6), vandq_u16 (vshrq_n_u16 (s, 5), mask6), a);
+		uint16x8_t b = blend_shift8_16 (vandq_u16 (d, mask5), vandq_u16 (s, mask5), a);
+
+		vst1q_u16 (destr + i, vorrq_u16 (vorrq_u16 (vshlq_n_u16 (r, 11), vshlq_n_u16 (g, 5)), b));
+	}
+
+	for (; i < n; i++) {
+		int d = destr[i];
+		int s = srcr[i];
+		int r = ((alpha * ((s >> 11) - (d >> 11)) >> 8) + (d >> 11));
+		int g = ((alpha * (((s >> 5) & 0x3f) - ((d >> 5) & 0x3f)) >> 8) + ((d >> 5) & 0x3f));
+		int b = ((alpha * ((s & 0x1f) - (d & 0x1f)) >> 8) + (d & 0x1f));
+
+		destr[i] = (r << 11) | (g << 5) | b;
+	}
+}
+
+void _lv_blit_colorkey_8_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	uint8x16_t k = vdupq_n_u8 (key);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16_t s = vld1q_u8 (src + i);
+		uint8x16_t d = vld1q_u8 (dest + i);
+
+		vst1q_u8 (dest + i, vbslq_u8 (vceqq_u8 (s, k), d, s));
+	}
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dest[i] = src[i];
+	}
+}
+
+void _lv_blit_colorkey_16_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	uint16_t *destbuf = (uint16_t *) dest;
+	const uint16_t *srcbuf = (const uint16_t *) src;
+	uint16x8_t k = vdupq_n_u16 (key);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t s = vld1q_u16 (srcbuf + i);
+		uint16x8_t d = vld1q_u16 (destbuf + i);
+
+		vst1q_u16 (destbuf + i, vbslq_u16 (vceqq_u16 (s, k), d, s));
+	}
+
+	for (; i < n; i++) {
+		if (srcbuf[i] != key)
+			destbuf[i] = srcbuf[i];
+	}
+}
+
+void _lv_blit_colorkey_32_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	uint32_t *destbuf = (uint32_t *) dest;
+	const uint32_t *srcbuf = (const uint32_t *) src;
+	uint32x4_t k = vdupq_n_u32 (key);
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		uint32x4_t s = vld1q_u32 (srcbuf + i);
+		uint32x4_t d = vld1q_u32 (destbuf + i);
+
+		vst1q_u32 (destbuf + i, vbslq_u32 (vceqq_u32 (s, k), d, s));
+	}
+
+	for (; i < n; i++) {
+		if (srcbuf[i] != key)
+			destbuf[i] = srcbuf[i];
+	}
+}
+
+/* One bilinear pixel from the channels of the upper and lower pixel pairs, the
+ * left pixel in the low half, see bilinear_pixel() in lv_video_sse2.c */
+static inline uint16x4_t bilinear_pixel (uint16x8_t cu, uint16x8_t cl, uint16x8_t fv, uint16x8_t fv1, uint32_t fracu)
+{
+	uint16x8_t col = vmlaq_u16 (vmulq_u16 (cu, fv1), cl, fv);
+	uint32x4_t sum = vmull_n_u16 (vget_low_u16 (col), 0x100 - fracu);
+
+	sum = vmlal_n_u16 (sum, vget_high_u16 (col), fracu);
+
+	return vshrn_n_u32 (sum, 16);
+}
+
+static inline uint16x8_t load_pair_16 (const uint16_t *p)
+{
+	uint16_t c[8] = {
+		p[0] & 0x1f, (p[0] >> 5) & 0x3f, p[0] >> 11, 0,
+		p[1] & 0x1f, (p[1] >> 5) & 0x3f, p[1] >> 11, 0
+	};
+
+	return vld1q_u16 (c);
+}
+
+static inline uint16x8_t load_pair_24 (const uint8_t *p)
+{
+	uint8_t c[8] = { p[0], p[1], p[2], 0, p[3], p[4], p[5], 0 };
+
+	return vmovl_u8 (vld1_u8 (c));
+}
+
+void _lv_scale_bilinear_16_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	uint16_t *dest_pixel = (uint16_t *) dest;
+	const uint16_t *su = (const uint16_t *) rowu;
+	const uint16_t *sl = (const uint16_t *) rowl;
+	uint16x8_t fv = vdupq_n_u16 (fracv);
+	uint16x8_t fv1 = vdupq_n_u16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		uint16x4_t c = bilinear_pixel (load_pair_16 (su + (u >> 16)), load_pair_16 (sl + (u >> 16)),
+				fv, fv1, (u & 0xffff) >> 8);
+
+		dest_pixel[x] = vget_lane_u16 (c, 0) | (vget_lane_u16 (c, 1) << 5) | (vget_lane_u16 (c, 2) << 11);
+	}
+}
+
+void _lv_scale_bilinear_24_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	uint16x8_t fv = vdupq_n_u16 (fracv);
+	uint16x8_t fv1 = vdupq_n_u16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		uint16x4_t c = bilinear_pixel (load_pair_24 (rowu + (u >> 16) * 3), load_pair_24 (rowl + (u >> 16) * 3),
+				fv, fv1, (u & 0xffff) >> 8);
+
+		dest[0] = vget_lane_u16 (c, 0);
+		dest[1] = vget_lane_u16 (c, 1);
+		dest[2] = vget_lane_u16 (c, 2);
+		dest += 3;
+	}
+}
+
+void _lv_scale_bilinear_32_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	uint32_t *dest_pixel = (uint32_t *) dest;
+	const uint32_t *su = (const uint32_t *) rowu;
+	const uint32_t *sl = (const uint32_t *) rowl;
+	uint16x8_t fv = vdupq_n_u16 (fracv);
+	uint16x8_t fv1 = vdupq_n_u16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		uint16x8_t cu = vmovl_u8 (vld1_u8 ((const uint8_t *) (su + (u >> 16))));
+		uint16x8_t cl = vmovl_u8 (vld1_u8 ((const uint8_t *) (sl + (u >> 16))));
+		uint16x4_t c = bilinear_pixel (cu, cl, fv, fv1, (u & 0xffff) >> 8);
+
+		vst1_lane_u32 (dest_pixel + x, vreinterpret_u32_u8 (vmovn_u16 (vcombine_u16 (c, c))), 0);
+	}
+}
+
+/* The conversions deinterleave the channels on load, and assume the byte order
+ * of a little endian host like the C versions do there */
+
+static inline uint8x8x3_t rgb16_unpack (uint16x8_t p)
+{
+	uint8x8x3_t c;
+
+	c.val[0] = vmovn_u16 (vshlq_n_u16 (vandq_u16 (p, vdupq_n_u16 (0x1f)), 3));
+	c.val[1] = vmovn_u16 (vshlq_n_u16 (vandq_u16 (vshrq_n_u16 (p, 5), vdupq_n_u16 (0x3f)), 2));
+	c.val[2] = vmovn_u16 (vshlq_n_u16 (vshrq_n_u16 (p, 11), 3));
+
+	return c;
+}
+
+static inline uint16x8_t rgb16_pack (uint8x8_t b, uint8x8_t g, uint8x8_t r)
+{
+	uint16x8_t p = vshlq_n_u16 (vshll_n_u8 (vshr_n_u8 (r, 3), 8), 3);
+
+	p = vorrq_u16 (p, vshll_n_u8 (vshr_n_u8 (g, 2), 5));
+
+	return vorrq_u16 (p, vmovl_u8 (vshr_n_u8 (b, 3)));
+}
+
+void _lv_rgb16_to_rgb24_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	const uint16_t *sbuf = (const uint16_t *) src;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		vst3_u8 (dest + i * 3, rgb16_unpack (vld1q_u16 (sbuf + i)));
+
+	for (; i < n; i++) {
+		dest[i * 3] = (sbuf[i] & 0x1f) << 3;
+		dest[i * 3 + 1] = ((sbuf[i] >> 5) & 0x3f) << 2;
+		dest[i * 3 + 2] = (sbuf[i] >> 11) << 3;
+	}
+}
+
+void _lv_rgb16_to_argb32_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	const uint16_t *sbuf = (const uint16_t *) src;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x3_t c = rgb16_unpack (vld1q_u16 (sbuf + i));
+		uint8x8x4_t d;
+
+		d.val[0] = c.val[0];
+		d.val[1] = c.val[1];
+		d.val[2] = c.val[2];
+		d.val[3] = vdup_n_u8 (255);
+
+		vst4_u8 (dest + i * 4, d);
+	}
+
+	for (; i < n; i++) {
+		dest[i * 4] = (sbuf[i] & 0x1f) << 3;
+		dest[i * 4 + 1] = ((sbuf[i] >> 5) & 0x3f) << 2;
+		dest[i * 4 + 2] = (sbuf[i] >> 11) << 3;
+		dest[i * 4 + 3] = 255;
+	}
+}
+
+void _lv_rgb24_to_rgb16_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	uint16_t *dbuf = (uint16_t *) dest;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x3_t s = vld3_u8 (src + i * 3);
+
+		vst1q_u16 (dbuf + i, rgb16_pack (s.val[0], s.val[1], s.val[2]));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *s = src + i * 3;
+
+		dbuf[i] = ((s[2] >> 3) << 11) | ((s[1] >> 2) << 5) | (s[0] >> 3);
+	}
+}
+
+void _lv_rgb24_to_argb32_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x3_t s = vld3_u8 (src + i * 3);
+		uint8x8x4_t d;
+
+		d.val[0] = s.val[0];
+		d.val[1] = s.val[1];
+		d.val[2] = s.val[2];
+		d.val[3] = vdup_n_u8 (255);
+
+		vst4_u8 (dest + i * 4, d);
+	}
+
+	for (; i < n; i++) {
+		dest[i * 4] = src[i * 3];
+		dest[i * 4 + 1] = src[i * 3 + 1];
+		dest[i * 4 + 2] = src[i * 3 + 2];
+		dest[i * 4 + 3] = 255;
+	}
+}
+
+void _lv_argb32_to_rgb16_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	uint16_t *dbuf = (uint16_t *) dest;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x4_t s = vld4_u8 (src + i * 4);
+
+		vst1q_u16 (dbuf + i, rgb16_pack (s.val[0], s.val[1], s.val[2]));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *s = src + i * 4;
+
+		dbuf[i] = ((s[2] >> 3) << 11) | ((s[1] >> 2) << 5) | (s[0] >> 3);
+	}
+}
+
+void _lv_argb32_to_rgb24_neon (uint8_t *dest, const uint8_t *src, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x4_t s = vld4_u8 (src + i * 4);
+		uint8x8x3_t d;
+
+		d.val[0] = s.val[0];
+		d.val[1] = s.val[1];
+		d.val[2] = s.val[2];
+
+		vst3_u8 (dest + i * 3, d);
+	}
+
+	for (; i < n; i++) {
+		dest[i * 3] = src[i * 4];
+		dest[i * 3 + 1] = src[i * 4 + 1];
+		dest[i * 3 + 2] = src[i * 4 + 2];
+	}
+}
+
+/* One pixel a step, the top and bottom pixel pairs times their weights */
+void _lv_warp_32_neon (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		const uint8_t *p = src + entries[i].y * pitch + entries[i].x * 4;
+		uint32_t w = entries[i].weights;
+		uint64_t tl = (w & 0xff) * 0x01010101ULL;
+		uint64_t tr = ((w >> 8) & 0xff) * 0x01010101ULL;
+		uint64_t bl = ((w >> 16) & 0xff) * 0x01010101ULL;
+		uint64_t br = (w >> 24) * 0x01010101ULL;
+		uint16x8_t acc = vmull_u8 (vld1_u8 (p), vcreate_u8 (tl | (tr << 32)));
+		uint16x4_t sum;
+
+		acc = vmlal_u8 (acc, vld1_u8 (p + pitch), vcreate_u8 (bl | (br << 32)));
+		sum = vadd_u16 (vget_low_u16 (acc), vget_high_u16 (acc));
+
+		vst1_lane_u32 ((uint32_t *) (dest + i * 4),
+				vreinterpret_u32_u8 (vshrn_n_u16 (vcombine_u16 (sum, sum), 8)), 0);
+	}
+}
+
+/* Eight pixels a step, gathered into byte vectors per corner */
+void _lv_warp_8_neon (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	uint8_t pixels[4][8];
+	uint8_t weights[4][8];
+	int i, j;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t acc;
+
+		for (j = 0; j < 8; j++) {
+			const uint8_t *p = src + entries[i + j].y * pitch + entries[i + j].x;
+			uint32_t w = entries[i + j].weights;
+
+			pixels[0][j] = p[0];
+			pixels[1][j] = p[1];
+			pixels[2][j] = p[pitch];
+			pixels[3][j] = p[pitch + 1];
+
+			weights[0][j] = w & 0xff;
+			weights[1][j] = (w >> 8) & 0xff;
+			weights[2][j] = (w >> 16) & 0xff;
+			weights[3][j] = w >> 24;
+		}
+
+		acc = vmull_u8 (vld1_u8 (pixels[0]), vld1_u8 (weights[0]));
+		acc = vmlal_u8 (acc, vld1_u8 (pixels[1]), vld1_u8 (weights[1]));
+		acc = vmlal_u8 (acc, vld1_u8 (pixels[2]), vld1_u8 (weights[2]));
+		acc = vmlal_u8 (acc, vld1_u8 (pixels[3]), vld1_u8 (weights[3]));
+
+		vst1_u8 (dest + i, vshrn_n_u16 (acc, 8));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *p = src + entries[i].y * pitch + entries[i].x;
+		uint32_t w = entries[i].weights;
+
+		dest[i] = (p[0] * (w & 0xff) + p[1] * ((w >> 8) & 0xff) +
+				p[pitch] * ((w >> 16) & 0xff) + p[pitch + 1] * (w >> 24)) >> 8;
+	}
+}
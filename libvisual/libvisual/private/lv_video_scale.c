@@ -1,5 +1,9 @@
 #include "lv_video_scale.h"
+#include "lv_video_simd.h"
 #include "lv_common.h"
+#include "lv_math.h"
+
+#include <math.h>
 
 #pragma pack(1)
 
@@ -17,6 +21,20 @@ typedef struct {
 
 #pragma pack()
 
+/* Fixed point precision of the bicubic and lanczos weights */
+#define SCALE_FILTER_SHIFT	14
+#define SCALE_FILTER_ONE	(1 << SCALE_FILTER_SHIFT)
+
+static int scale_plan_axis_nearest (int dest_size, int src_size, int *index);
+static int scale_plan_axis_bilinear (int dest_size, int src_size, int *index, int16_t *weight);
+static int scale_plan_axis_filter (int dest_size, int src_size, VisVideoScaleMethod method, int **index, int16_t **weight);
+static double scale_filter_bicubic (double x);
+static double scale_filter_lanczos2 (double x);
+
+static inline void scale_filter_row (int32_t *out, const uint8_t *row, VisVideoScalePlan *plan, const int bpp);
+static inline void scale_filter_column (uint8_t *dest, int32_t **rows, const int16_t *weight, int taps, int width, const int bpp);
+static inline void scale_filter (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end, const int bpp);
+
 
 void visual_video_zoom_color8 (VisVideo *dest, VisVideo *src)
 {
@@ -82,397 +100,517 @@ void visual_video_zoom_color32 (VisVideo *dest, VisVideo *src)
 	}
 }
 
-void visual_video_scale_nearest_color8 (VisVideo *dest, VisVideo *src)
+/* Plan tables */
+
+static int scale_plan_axis_nearest (int dest_size, int src_size, int *index)
 {
-	int x, y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	uint8_t *dest_pixel, *src_pixel_row;
+	uint32_t u, du; /* fixed point 16.16 */
+	int i;
 
-	du = (src->width << 16) / dest->width;
-	dv = (src->height << 16) / dest->height;
-	v = 0;
+	du = (src_size << 16) / dest_size;
 
-	dest_pixel = visual_video_get_pixels (dest);
+	for (i = 0, u = 0; i < dest_size; i++, u += du)
+		index[i] = u >> 16;
 
-	for (y = 0; y < dest->height; y++, v += dv) {
-		src_pixel_row = (uint8_t *) src->pixel_rows[v >> 16];
+	return 1;
+}
 
-		if (v >> 16 >= src->height)
-			v -= 0x10000;
+static int scale_plan_axis_bilinear (int dest_size, int src_size, int *index, int16_t *weight)
+{
+	uint32_t u, du; /* fixed point 16.16 */
+	int i;
 
-		u = 0;
-		for (x = 0; x < dest->width; x++, u += du)
-			*dest_pixel++ = src_pixel_row[u >> 16];
+	du = ((src_size - 1) << 16) / dest_size;
 
-		dest_pixel += dest->pitch - dest->width;
+	for (i = 0, u = 0; i < dest_size; i++, u += du) {
+		/* fixed point format convertion: frac(u) >> 8, 0x100 = 1.0 */
+		uint32_t frac = (u & 0xffff) >> 8;
+
+		index[i * 2] = u >> 16;
+		index[i * 2 + 1] = (u >> 16) + 1 < (uint32_t) src_size ? (u >> 16) + 1 : src_size - 1;
+
+		weight[i * 2] = 0x100 - frac;
+		weight[i * 2 + 1] = frac;
 	}
+
+	return 2;
 }
 
-void visual_video_scale_nearest_color16 (VisVideo *dest, VisVideo *src)
+static double scale_filter_bicubic (double x)
 {
-	int x, y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	uint16_t *dest_pixel, *src_pixel_row;
+	/* Keys' cubic convolution with a = -0.5 */
+	x = fabs (x);
 
-	du = (src->width << 16) / dest->width;
-	dv = (src->height << 16) / dest->height;
-	v = 0;
+	if (x < 1.0)
+		return (1.5 * x - 2.5) * x * x + 1.0;
 
-	dest_pixel = visual_video_get_pixels (dest);
+	if (x < 2.0)
+		return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
 
-	for (y = 0; y < dest->height; y++, v += dv) {
-		src_pixel_row = (uint16_t *) src->pixel_rows[v >> 16];
+	return 0.0;
+}
+
+static double scale_filter_lanczos2 (double x)
+{
+	x = fabs (x);
 
-		if (v >> 16 >= src->height)
-			v -= 0x10000;
+	if (x < 1e-8)
+		return 1.0;
 
-		u = 0;
-		for (x = 0; x < dest->width; x++, u += du)
-			*dest_pixel++ = src_pixel_row[u >> 16];
+	if (x >= 2.0)
+		return 0.0;
 
-		dest_pixel += (dest->pitch / dest->bpp) - dest->width;
+	x *= VISUAL_MATH_PI;
+
+	return 2.0 * sin (x) * sin (x / 2.0) / (x * x);
+}
+
+/* Both filters reach two source pixels to either side. When shrinking the filter is
+ * stretched over the source, so every source pixel counts. */
+static int scale_plan_axis_filter (int dest_size, int src_size, VisVideoScaleMethod method, int **index, int16_t **weight)
+{
+	double (*filter)(double) = method == VISUAL_VIDEO_SCALE_BICUBIC ? scale_filter_bicubic : scale_filter_lanczos2;
+	double scale = (double) src_size / dest_size;
+	double stretch = scale > 1.0 ? scale : 1.0;
+	double support = 2.0 * stretch;
+	double *fweight;
+	int taps = (int) ceil (support) * 2;
+	int i, t;
+
+	*index = visual_mem_malloc (dest_size * taps * sizeof (int));
+	*weight = visual_mem_malloc (dest_size * taps * sizeof (int16_t));
+	fweight = visual_mem_malloc (taps * sizeof (double));
+
+	for (i = 0; i < dest_size; i++) {
+		double center = (i + 0.5) * scale - 0.5;
+		int first = (int) floor (center - support) + 1;
+		double sum = 0.0;
+		int total = 0;
+		int peak = 0;
+
+		for (t = 0; t < taps; t++) {
+			fweight[t] = filter ((first + t - center) / stretch);
+			sum += fweight[t];
+		}
+
+		for (t = 0; t < taps; t++) {
+			int pos = first + t;
+			int w = (int) floor (fweight[t] / sum * SCALE_FILTER_ONE + 0.5);
+
+			(*index)[i * taps + t] = pos < 0 ? 0 : pos >= src_size ? src_size - 1 : pos;
+			(*weight)[i * taps + t] = w;
+
+			total += w;
+
+			if (w > (*weight)[i * taps + peak])
+				peak = t;
+		}
+
+		/* Keep flat areas flat, the weights have to add up to one exactly */
+		(*weight)[i * taps + peak] += SCALE_FILTER_ONE - total;
 	}
+
+	visual_mem_free (fweight);
+
+	return taps;
 }
 
-/* FIXME this version is of course butt ugly */
-/* IF color24_t is allowed use it here as well */
-void visual_video_scale_nearest_color24 (VisVideo *dest, VisVideo *src)
+int visual_video_scale_plan_compute (VisVideoScalePlan *plan)
 {
-	int x, y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	color24_t *dest_pixel, *src_pixel_row;
+	int dw = plan->dest_width;
+	int dh = plan->dest_height;
 
-	du = (src->width << 16) / dest->width;
-	dv = (src->height << 16) / dest->height;
-	v = 0;
+	switch (plan->method) {
+		case VISUAL_VIDEO_SCALE_NEAREST:
+			plan->xindex = visual_mem_malloc (dw * sizeof (int));
+			plan->yindex = visual_mem_malloc (dh * sizeof (int));
 
-	dest_pixel = visual_video_get_pixels (dest);
+			plan->xtaps = scale_plan_axis_nearest (dw, plan->src_width, plan->xindex);
+			plan->ytaps = scale_plan_axis_nearest (dh, plan->src_height, plan->yindex);
 
-	for (y = 0; y < dest->height; y++, v += dv) {
-		src_pixel_row = (color24_t *) src->pixel_rows[v >> 16];
+			break;
 
-		if (v >> 16 >= src->height)
-			v -= 0x10000;
+		case VISUAL_VIDEO_SCALE_BILINEAR:
+			plan->xindex = visual_mem_malloc (dw * 2 * sizeof (int));
+			plan->yindex = visual_mem_malloc (dh * 2 * sizeof (int));
+			plan->xweight = visual_mem_malloc (dw * 2 * sizeof (int16_t));
+			plan->yweight = visual_mem_malloc (dh * 2 * sizeof (int16_t));
 
-		u = 0;
-		for (x = 0; x < dest->width; x++, u += du)
-			*dest_pixel++ = src_pixel_row[u >> 16];
+			plan->xtaps = scale_plan_axis_bilinear (dw, plan->src_width, plan->xindex, plan->xweight);
+			plan->ytaps = scale_plan_axis_bilinear (dh, plan->src_height, plan->yindex, plan->yweight);
 
-		dest_pixel += (dest->pitch / dest->bpp) - dest->width;
+			plan->du = ((plan->src_width - 1) << 16) / dw;
+
+			break;
+
+		case VISUAL_VIDEO_SCALE_BICUBIC:
+		case VISUAL_VIDEO_SCALE_LANCZOS2:
+			plan->xtaps = scale_plan_axis_filter (dw, plan->src_width, plan->method, &plan->xindex, &plan->xweight);
+			plan->ytaps = scale_plan_axis_filter (dh, plan->src_height, plan->method, &plan->yindex, &plan->yweight);
+
+			break;
+
+		default:
+			return -VISUAL_ERROR_VIDEO_INVALID_SCALE_METHOD;
 	}
+
+	return VISUAL_OK;
 }
 
-void visual_video_scale_nearest_color32 (VisVideo *dest, VisVideo *src)
+/* Nearest */
+
+void visual_video_scale_nearest_color8 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
 {
 	int x, y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	uint32_t *dest_pixel, *src_pixel_row;
 
-	du = (src->width << 16) / dest->width;
-	dv = (src->height << 16) / dest->height;
-	v = 0;
+	for (y = y_begin; y < y_end; y++) {
+		uint8_t *dest_pixel = dest->pixel_rows[y];
+		uint8_t *src_pixel_row = src->pixel_rows[plan->yindex[y]];
 
-	dest_pixel = visual_video_get_pixels (dest);
-
-	for (y = 0; y < dest->height; y++, v += dv) {
-		src_pixel_row = (uint32_t *) src->pixel_rows[v >> 16];
+		for (x = 0; x < dest->width; x++)
+			dest_pixel[x] = src_pixel_row[plan->xindex[x]];
+	}
+}
 
-		if (v >> 16 >= src->height)
-			v -= 0x10000;
+void visual_video_scale_nearest_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	int x, y;
 
-		u = 0;
-		for (x = 0; x < dest->width; x++, u += du)
-			*dest_pixel++ = src_pixel_row[u >> 16];
+	for (y = y_begin; y < y_end; y++) {
+		uint16_t *dest_pixel = dest->pixel_rows[y];
+		uint16_t *src_pixel_row = src->pixel_rows[plan->yindex[y]];
 
-		dest_pixel += (dest->pitch / dest->bpp) - dest->width;
+		for (x = 0; x < dest->width; x++)
+			dest_pixel[x] = src_pixel_row[plan->xindex[x]];
 	}
 }
 
-void visual_video_scale_bilinear_color8 (VisVideo *dest, VisVideo *src)
+void visual_video_scale_nearest_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
 {
-	uint32_t y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	uint8_t *dest_pixel, *src_pixel_rowu, *src_pixel_rowl;
+	int x, y;
 
-	dest_pixel = visual_video_get_pixels (dest);
+	for (y = y_begin; y < y_end; y++) {
+		color24_t *dest_pixel = dest->pixel_rows[y];
+		color24_t *src_pixel_row = src->pixel_rows[plan->yindex[y]];
 
-	du = ((src->width - 1)  << 16) / dest->width;
-	dv = ((src->height - 1) << 16) / dest->height;
-	v = 0;
+		for (x = 0; x < dest->width; x++)
+			dest_pixel[x] = src_pixel_row[plan->xindex[x]];
+	}
+}
 
-	for (y = dest->height; y--; v += dv) {
-		uint32_t x;
-		uint32_t fracU, fracV;     /* fixed point 24.8 [0,1[    */
+void visual_video_scale_nearest_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	int x, y;
 
-		if (v >> 16 >= src->height - 1)
-			v -= 0x10000;
+	for (y = y_begin; y < y_end; y++) {
+		uint32_t *dest_pixel = dest->pixel_rows[y];
+		uint32_t *src_pixel_row = src->pixel_rows[plan->yindex[y]];
 
-		src_pixel_rowu = (uint8_t *) src->pixel_rows[v >> 16];
-		src_pixel_rowl = (uint8_t *) src->pixel_rows[(v >> 16) + 1];
+		for (x = 0; x < dest->width; x++)
+			dest_pixel[x] = src_pixel_row[plan->xindex[x]];
+	}
+}
 
-		/* fracV = frac(v) = v & 0xffff */
-		/* fixed point format convertion: fracV >>= 8) */
-		fracV = (v & 0xffff) >> 8;
-		u = 0;
+/* Bilinear, the weights are fixed point 24.8 [0,1] and their products 16.16 */
 
-		for (x = dest->width - 1; x--; u += du) {
-			uint8_t cul, cll, cur, clr;
-			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
-			uint32_t b0; /* fixed point 16.16 [0,255[ */
+void visual_video_scale_bilinear_color8 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	int x, y;
 
-			/* fracU = frac(u) = u & 0xffff */
-			/* fixed point format convertion: fracU >>= 8) */
-			fracU  = (u & 0xffff) >> 8;
+	for (y = y_begin; y < y_end; y++) {
+		uint8_t *dest_pixel = dest->pixel_rows[y];
+		uint8_t *src_pixel_rowu = src->pixel_rows[plan->yindex[y * 2]];
+		uint8_t *src_pixel_rowl = src->pixel_rows[plan->yindex[y * 2 + 1]];
+		uint32_t fracV = plan->yweight[y * 2 + 1];
+		const int *xindex = plan->xindex;
+		const int16_t *xweight = plan->xweight;
 
-			/* notice 0x100 = 1.0 (fixed point 24.8) */
-			ul = (0x100 - fracU) * (0x100 - fracV);
-			ll = (0x100 - fracU) * fracV;
-			ur = fracU * (0x100 - fracV);
-			lr = fracU * fracV;
+		for (x = 0; x < dest->width; x++, xindex += 2, xweight += 2) {
+			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
+			uint32_t b0;             /* fixed point 16.16 [0,255[ */
 
-			cul = src_pixel_rowu[u >> 16];
-			cll = src_pixel_rowl[u >> 16];
-			cur = src_pixel_rowu[(u >> 16) + 1];
-			clr = src_pixel_rowl[(u >> 16) + 1];
+			ul = xweight[0] * (0x100 - fracV);
+			ll = xweight[0] * fracV;
+			ur = xweight[1] * (0x100 - fracV);
+			lr = xweight[1] * fracV;
 
-			b0 = ul * cul;
-			b0 += ll * cll;
-			b0 += ur * cur;
-			b0 += lr * clr;
+			b0  = ul * src_pixel_rowu[xindex[0]];
+			b0 += ll * src_pixel_rowl[xindex[0]];
+			b0 += ur * src_pixel_rowu[xindex[1]];
+			b0 += lr * src_pixel_rowl[xindex[1]];
 
-			*dest_pixel++ = b0 >> 16;
+			dest_pixel[x] = b0 >> 16;
 		}
-
-		dest_pixel += dest->pitch - (dest->width - 1);
-
 	}
 }
 
-void visual_video_scale_bilinear_color16 (VisVideo *dest, VisVideo *src)
+void visual_video_scale_bilinear_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
 {
-	uint32_t y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	color16_t *dest_pixel, *src_pixel_rowu, *src_pixel_rowl;
-	dest_pixel = visual_video_get_pixels (dest);
+	int x, y;
 
-	du = ((src->width - 1)  << 16) / dest->width;
-	dv = ((src->height - 1) << 16) / dest->height;
-	v = 0;
+	for (y = y_begin; y < y_end; y++) {
+		color16_t *dest_pixel = dest->pixel_rows[y];
+		color16_t *src_pixel_rowu = src->pixel_rows[plan->yindex[y * 2]];
+		color16_t *src_pixel_rowl = src->pixel_rows[plan->yindex[y * 2 + 1]];
+		uint32_t fracV = plan->yweight[y * 2 + 1];
+		const int *xindex = plan->xindex;
+		const int16_t *xweight = plan->xweight;
 
-	for (y = dest->height; y--; v += dv) {
-		uint32_t x;
-		uint32_t fracU, fracV;     /* fixed point 24.8 [0,1[    */
+		if (_lv_video_simd.scale_bilinear_16 != NULL && plan->src_width > 1) {
+			_lv_video_simd.scale_bilinear_16 ((uint8_t *) dest_pixel, (uint8_t *) src_pixel_rowu,
+					(uint8_t *) src_pixel_rowl, plan->du, fracV, dest->width);
 
-		if (v >> 16 >= src->height - 1)
-			v -= 0x10000;
+			continue;
+		}
 
-		src_pixel_rowu = (color16_t *) src->pixel_rows[v >> 16];
-		src_pixel_rowl = (color16_t *) src->pixel_rows[(v >> 16) + 1];
+		for (x = 0; x < dest->width; x++, xindex += 2, xweight += 2) {
+			color16_t cul, cll, cur, clr, b;
+			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
+			uint32_t b2, b1, b0;     /* fixed point 16.16 [0,255[ */
 
-		/* fracV = frac(v) = v & 0xffff */
-		/* fixed point format convertion: fracV >>= 8) */
-		fracV = (v & 0xffff) >> 8;
-		u = 0.0;
+			ul = xweight[0] * (0x100 - fracV);
+			ll = xweight[0] * fracV;
+			ur = xweight[1] * (0x100 - fracV);
+			lr = xweight[1] * fracV;
 
-		for (x = dest->width - 1; x--; u += du) {
-			color16_t cul, cll, cur, clr, b;
-			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[	  */
-			uint32_t b2, b1, b0;	 /* fixed point 16.16 [0,255[ */
+			cul = src_pixel_rowu[xindex[0]];
+			cll = src_pixel_rowl[xindex[0]];
+			cur = src_pixel_rowu[xindex[1]];
+			clr = src_pixel_rowl[xindex[1]];
 
-			/* fracU = frac(u) = u & 0xffff */
-			/* fixed point format convertion: fracU >>= 8) */
-			fracU  = (u & 0xffff) >> 8;
+			b0 = ul * cul.r + ll * cll.r + ur * cur.r + lr * clr.r;
+			b1 = ul * cul.g + ll * cll.g + ur * cur.g + lr * clr.g;
+			b2 = ul * cul.b + ll * cll.b + ur * cur.b + lr * clr.b;
 
-			/* notice 0x100 = 1.0 (fixed point 24.8) */
-			ul = (0x100 - fracU) * (0x100 - fracV);
-			ll = (0x100 - fracU) * fracV;
-			ur = fracU * (0x100 - fracV);
-			lr = fracU * fracV;
+			b.r = b0 >> 16;
+			b.g = b1 >> 16;
+			b.b = b2 >> 16;
 
-			cul = src_pixel_rowu[u >> 16];
-			cll = src_pixel_rowl[u >> 16];
-			cur = src_pixel_rowu[(u >> 16) + 1];
-			clr = src_pixel_rowl[(u >> 16) + 1];
+			dest_pixel[x] = b;
+		}
+	}
+}
 
-			b0 = ul * cul.r;
-			b1 = ul * cul.g;
-			b2 = ul * cul.b;
+void visual_video_scale_bilinear_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	int x, y;
+
+	for (y = y_begin; y < y_end; y++) {
+		color24_t *dest_pixel = dest->pixel_rows[y];
+		color24_t *src_pixel_rowu = src->pixel_rows[plan->yindex[y * 2]];
+		color24_t *src_pixel_rowl = src->pixel_rows[plan->yindex[y * 2 + 1]];
+		uint32_t fracV = plan->yweight[y * 2 + 1];
+		const int *xindex = plan->xindex;
+		const int16_t *xweight = plan->xweight;
+
+		if (_lv_video_simd.scale_bilinear_24 != NULL && plan->src_width > 1) {
+			_lv_video_simd.scale_bilinear_24 ((uint8_t *) dest_pixel, (uint8_t *) src_pixel_rowu,
+					(uint8_t *) src_pixel_rowl, plan->du, fracV, dest->width);
+
+			continue;
+		}
+
+		for (x = 0; x < dest->width; x++, xindex += 2, xweight += 2) {
+			color24_t cul, cll, cur, clr, b;
+			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
+			uint32_t b2, b1, b0;     /* fixed point 16.16 [0,255[ */
 
-			b0 += ll * cll.r;
-			b1 += ll * cll.g;
-			b2 += ll * cll.b;
+			ul = xweight[0] * (0x100 - fracV);
+			ll = xweight[0] * fracV;
+			ur = xweight[1] * (0x100 - fracV);
+			lr = xweight[1] * fracV;
 
-			b0 += ur * cur.r;
-			b1 += ur * cur.g;
-			b2 += ur * cur.b;
+			cul = src_pixel_rowu[xindex[0]];
+			cll = src_pixel_rowl[xindex[0]];
+			cur = src_pixel_rowu[xindex[1]];
+			clr = src_pixel_rowl[xindex[1]];
 
-			b0 += lr * clr.r;
-			b1 += lr * clr.g;
-			b2 += lr * clr.b;
+			b0 = ul * cul.r + ll * cll.r + ur * cur.r + lr * clr.r;
+			b1 = ul * cul.g + ll * cll.g + ur * cur.g + lr * clr.g;
+			b2 = ul * cul.b + ll * cll.b + ur * cur.b + lr * clr.b;
 
 			b.r = b0 >> 16;
 			b.g = b1 >> 16;
 			b.b = b2 >> 16;
 
-			*dest_pixel++ = b;
+			dest_pixel[x] = b;
 		}
-
-		dest_pixel += (dest->pitch / dest->bpp) - ((dest->width - 1));
 	}
 }
 
-void visual_video_scale_bilinear_color24 (VisVideo *dest, VisVideo *src)
+void visual_video_scale_bilinear_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
 {
-	uint32_t y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	color24_t *dest_pixel, *src_pixel_rowu, *src_pixel_rowl;
-	dest_pixel = visual_video_get_pixels (dest);
+	int x, y;
 
-	du = ((src->width - 1)  << 16) / dest->width;
-	dv = ((src->height - 1) << 16) / dest->height;
-	v = 0;
+	for (y = y_begin; y < y_end; y++) {
+		uint8_t *dest_pixel = dest->pixel_rows[y];
+		uint8_t *src_pixel_rowu = src->pixel_rows[plan->yindex[y * 2]];
+		uint8_t *src_pixel_rowl = src->pixel_rows[plan->yindex[y * 2 + 1]];
+		uint32_t fracV = plan->yweight[y * 2 + 1];
+		const int *xindex = plan->xindex;
+		const int16_t *xweight = plan->xweight;
 
-	for (y = dest->height; y--; v += dv) {
-		uint32_t x;
-		uint32_t fracU, fracV;     /* fixed point 24.8 [0,1[    */
+		if (_lv_video_simd.scale_bilinear_32 != NULL && plan->src_width > 1) {
+			_lv_video_simd.scale_bilinear_32 (dest_pixel, src_pixel_rowu, src_pixel_rowl, plan->du, fracV, dest->width);
 
-		if (v >> 16 >= src->height - 1)
-			v -= 0x10000;
+			continue;
+		}
 
-		src_pixel_rowu = (color24_t *) src->pixel_rows[v >> 16];
-		src_pixel_rowl = (color24_t *) src->pixel_rows[(v >> 16) + 1];
+		for (x = 0; x < dest->width; x++, xindex += 2, xweight += 2) {
+			uint8_t *cul, *cll, *cur, *clr;
+			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
+			int i;
 
-		/* fracV = frac(v) = v & 0xffff */
-		/* fixed point format convertion: fracV >>= 8) */
-		fracV = (v & 0xffff) >> 8;
-		u = 0;
+			ul = xweight[0] * (0x100 - fracV);
+			ll = xweight[0] * fracV;
+			ur = xweight[1] * (0x100 - fracV);
+			lr = xweight[1] * fracV;
 
-		for (x = dest->width - 1; x--; u += du) {
-			color24_t cul, cll, cur, clr, b;
-			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
-			uint32_t b2, b1, b0;	 /* fixed point 16.16 [0,255[ */
+			cul = src_pixel_rowu + xindex[0] * 4;
+			cll = src_pixel_rowl + xindex[0] * 4;
+			cur = src_pixel_rowu + xindex[1] * 4;
+			clr = src_pixel_rowl + xindex[1] * 4;
+
+			for (i = 0; i < 4; i++)
+				*dest_pixel++ = (ul * cul[i] + ll * cll[i] + ur * cur[i] + lr * clr[i]) >> 16;
+		}
+	}
+}
 
-			/* fracU = frac(u) = u & 0xffff */
-			/* fixed point format convertion: fracU >>= 8) */
-			fracU  = (u & 0xffff) >> 8;
+/* Bicubic and lanczos. Every source row is filtered horizontally once into a cache
+ * of ytaps rows, from which the destination rows are filtered vertically. */
 
-			/* notice 0x100 = 1.0 (fixed point 24.8) */
-			ul = (0x100 - fracU) * (0x100 - fracV);
-			ll = (0x100 - fracU) * fracV;
-			ur = fracU * (0x100 - fracV);
-			lr = fracU * fracV;
+static inline void scale_filter_row (int32_t *out, const uint8_t *row, VisVideoScalePlan *plan, const int bpp)
+{
+	const int *xindex = plan->xindex;
+	const int16_t *xweight = plan->xweight;
+	int taps = plan->xtaps;
+	int x, t;
 
-			cul = src_pixel_rowu[u >> 16];
-			cll = src_pixel_rowl[u >> 16];
-			cur = src_pixel_rowu[(u >> 16) + 1];
-			clr = src_pixel_rowl[(u >> 16) + 1];
+	for (x = 0; x < plan->dest_width; x++, xindex += taps, xweight += taps) {
+		int32_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
 
-			b0 = ul * cul.r;
-			b1 = ul * cul.g;
-			b2 = ul * cul.b;
+		for (t = 0; t < taps; t++) {
+			int32_t w = xweight[t];
 
-			b0 += ll * cll.r;
-			b1 += ll * cll.g;
-			b2 += ll * cll.b;
+			if (bpp == 2) {
+				color16_t c = ((const color16_t *) row)[xindex[t]];
 
-			b0 += ur * cur.r;
-			b1 += ur * cur.g;
-			b2 += ur * cur.b;
+				c0 += w * c.r;
+				c1 += w * c.g;
+				c2 += w * c.b;
+			} else {
+				const uint8_t *c = row + xindex[t] * bpp;
 
-			b0 += lr * clr.r;
-			b1 += lr * clr.g;
-			b2 += lr * clr.b;
+				c0 += w * c[0];
 
-			b.r = b0 >> 16;
-			b.g = b1 >> 16;
-			b.b = b2 >> 16;
+				if (bpp >= 3) {
+					c1 += w * c[1];
+					c2 += w * c[2];
+				}
 
-			*dest_pixel++ = b;
+				if (bpp == 4)
+					c3 += w * c[3];
+			}
 		}
 
-		dest_pixel += (dest->pitch / dest->bpp) - ((dest->width - 1));
+		*out++ = (c0 + SCALE_FILTER_ONE / 2) >> SCALE_FILTER_SHIFT;
+
+		if (bpp >= 2) {
+			*out++ = (c1 + SCALE_FILTER_ONE / 2) >> SCALE_FILTER_SHIFT;
+			*out++ = (c2 + SCALE_FILTER_ONE / 2) >> SCALE_FILTER_SHIFT;
+		}
+
+		if (bpp == 4)
+			*out++ = (c3 + SCALE_FILTER_ONE / 2) >> SCALE_FILTER_SHIFT;
 	}
 }
 
-void visual_video_scale_bilinear_color32 (VisVideo *dest, VisVideo *src)
+static inline void scale_filter_column (uint8_t *dest, int32_t **rows, const int16_t *weight, int taps, int width, const int bpp)
 {
-	uint32_t y;
-	uint32_t u, v, du, dv; /* fixed point 16.16 */
-	uint32_t *dest_pixel, *src_pixel_rowu, *src_pixel_rowl;
-
-	dest_pixel = visual_video_get_pixels (dest);
+	const int channels = bpp == 2 ? 3 : bpp;
+	int i, t;
 
-	du = ((src->width - 1)  << 16) / dest->width;
-	dv = ((src->height - 1) << 16) / dest->height;
-	v = 0;
+	for (i = 0; i < width * channels; i++) {
+		int32_t c = 0;
 
-	for (y = dest->height; y--; v += dv) {
-		uint32_t x;
-		uint32_t fracU, fracV;     /* fixed point 24.8 [0,1[    */
+		for (t = 0; t < taps; t++)
+			c += weight[t] * rows[t][i];
 
-		if (v >> 16 >= src->height - 1)
-			v -= 0x10000;
+		c = (c + SCALE_FILTER_ONE / 2) >> SCALE_FILTER_SHIFT;
 
-		src_pixel_rowu = (uint32_t *) src->pixel_rows[v >> 16];
-		src_pixel_rowl = (uint32_t *) src->pixel_rows[(v >> 16) + 1];
+		if (bpp == 2) {
+			/* The 5 bit channels at 0 and 2, the 6 bit one at 1 */
+			int max = i % 3 == 1 ? 63 : 31;
+			color16_t *pixel = (color16_t *) dest + i / 3;
 
-		/* fracV = frac(v) = v & 0xffff */
-		/* fixed point format convertion: fracV >>= 8) */
-		fracV = (v & 0xffff) >> 8;
-		u = 0;
+			c = c < 0 ? 0 : c > max ? max : c;
 
-		for (x = dest->width - 1; x--; u += du) {
-			union {
-				uint8_t  c8[4];
-				uint32_t c32;
-			} cul, cll, cur, clr, b;
-			uint32_t ul, ll, ur, lr; /* fixed point 16.16 [0,1[   */
-			uint32_t b3, b2, b1, b0; /* fixed point 16.16 [0,255[ */
-
-			/* fracU = frac(u) = u & 0xffff */
-			/* fixed point format convertion: fracU >>= 8) */
-			fracU  = (u & 0xffff) >> 8;
-
-			/* notice 0x100 = 1.0 (fixed point 24.8) */
-			ul = (0x100 - fracU) * (0x100 - fracV);
-			ll = (0x100 - fracU) * fracV;
-			ur = fracU * (0x100 - fracV);
-			lr = fracU * fracV;
-
-			cul.c32 = src_pixel_rowu[u >> 16];
-			cll.c32 = src_pixel_rowl[u >> 16];
-			cur.c32 = src_pixel_rowu[(u >> 16) + 1];
-			clr.c32 = src_pixel_rowl[(u >> 16) + 1];
-
-			b0 = ul * cul.c8[0];
-			b1 = ul * cul.c8[1];
-			b2 = ul * cul.c8[2];
-			b3 = ul * cul.c8[3];
-
-			b0 += ll * cll.c8[0];
-			b1 += ll * cll.c8[1];
-			b2 += ll * cll.c8[2];
-			b3 += ll * cll.c8[3];
-
-			b0 += ur * cur.c8[0];
-			b1 += ur * cur.c8[1];
-			b2 += ur * cur.c8[2];
-			b3 += ur * cur.c8[3];
-
-			b0 += lr * clr.c8[0];
-			b1 += lr * clr.c8[1];
-			b2 += lr * clr.c8[2];
-			b3 += lr * clr.c8[3];
-
-			b.c8[0] = b0 >> 16;
-			b.c8[1] = b1 >> 16;
-			b.c8[2] = b2 >> 16;
-			b.c8[3] = b3 >> 16;
-
-			*dest_pixel++ = b.c32;
+			switch (i % 3) {
+				case 0: pixel->r = c; break;
+				case 1: pixel->g = c; break;
+				case 2: pixel->b = c; break;
+			}
+		} else {
+			dest[i] = c < 0 ? 0 : c > 255 ? 255 : c;
 		}
+	}
+}
+
+static inline void scale_filter (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end, const int bpp)
+{
+	const int channels = bpp == 2 ? 3 : bpp;
+	int stride = plan->dest_width * channels;
+	int taps = plan->ytaps;
+	int32_t *cache = visual_mem_malloc (taps * stride * sizeof (int32_t));
+	int32_t **rows = visual_mem_malloc (taps * sizeof (int32_t *));
+	int *cached = visual_mem_malloc (taps * sizeof (int));
+	int y, t;
+
+	for (t = 0; t < taps; t++)
+		cached[t] = -1;
+
+	for (y = y_begin; y < y_end; y++) {
+		const int *yindex = plan->yindex + y * taps;
+
+		/* The rows of one destination row lie within taps rows of each other, so
+		 * they never share a cache slot */
+		for (t = 0; t < taps; t++) {
+			int slot = yindex[t] % taps;
+
+			if (cached[slot] != yindex[t]) {
+				scale_filter_row (cache + slot * stride, src->pixel_rows[yindex[t]], plan, bpp);
+
+				cached[slot] = yindex[t];
+			}
 
-		dest_pixel += (dest->pitch / dest->bpp) - ((dest->width - 1));
+			rows[t] = cache + slot * stride;
+		}
 
+		scale_filter_column (dest->pixel_rows[y], rows, plan->yweight + y * taps, taps, plan->dest_width, bpp);
 	}
+
+	visual_mem_free (cached);
+	visual_mem_free (rows);
+	visual_mem_free (cache);
+}
+
+void visual_video_scale_filter_color8 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	scale_filter (dest, src, plan, y_begin, y_end, 1);
+}
+
+void visual_video_scale_filter_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	scale_filter (dest, src, plan, y_begin, y_end, 2);
+}
+
+void visual_video_scale_filter_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	scale_filter (dest, src, plan, y_begin, y_end, 3);
+}
+
+void visual_video_scale_filter_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end)
+{
+	scale_filter (dest, src, plan, y_begin, y_end, 4);
 }
@@ -8,14 +8,25 @@ void visual_video_zoom_color16 (VisVideo *dest, VisVideo *src);
 void visual_video_zoom_color24 (VisVideo *dest, VisVideo *src);
 void visual_video_zoom_color32 (VisVideo *dest, VisVideo *src);
 
-void visual_video_scale_nearest_color8  (VisVideo *dest, VisVideo *src);
-void visual_video_scale_nearest_color16 (VisVideo *dest, VisVideo *src);
-void visual_video_scale_nearest_color24 (VisVideo *dest, VisVideo *src);
-void visual_video_scale_nearest_color32 (VisVideo *dest, VisVideo *src);
+/* Fills in the tables of a plan, from its method and dimensions */
+int visual_video_scale_plan_compute (VisVideoScalePlan *plan);
 
-void visual_video_scale_bilinear_color8  (VisVideo *dest, VisVideo *src);
-void visual_video_scale_bilinear_color16 (VisVideo *dest, VisVideo *src);
-void visual_video_scale_bilinear_color24 (VisVideo *dest, VisVideo *src);
-void visual_video_scale_bilinear_color32 (VisVideo *dest, VisVideo *src);
+/* The scalers fill the destination rows [y_begin, y_end), with a plan made for the
+ * dimensions of dest and src */
+void visual_video_scale_nearest_color8  (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_nearest_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_nearest_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_nearest_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+
+void visual_video_scale_bilinear_color8  (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_bilinear_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_bilinear_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_bilinear_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+
+/* Bicubic and lanczos, the plan tells which */
+void visual_video_scale_filter_color8  (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_filter_color16 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_filter_color24 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
+void visual_video_scale_filter_color32 (VisVideo *dest, VisVideo *src, VisVideoScalePlan *plan, int y_begin, int y_end);
 
 #endif /* _LV_VIDEO_SCALE_H */
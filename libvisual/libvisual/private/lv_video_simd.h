@@ -0,0 +1,131 @@
+#ifndef _LV_VIDEO_SIMD_H
+#define _LV_VIDEO_SIMD_H
+
+#include "config.h"
+#include "lv_video.h"
+#include "lv_warp.h"
+
+/* SIMD kernels for the VisVideo routines and the alpha blenders, selected at
+ * runtime by _lv_video_simd_initialize(). Every kernel gives exactly the same
+ * result as the C code it stands in for. Kernels that are NULL in
+ * _lv_video_simd have no accelerated version, the caller uses its C code.
+ *
+ * Unless noted otherwise the kernels work on n pixels of a single row.
+ *
+ * blit_alphasrc_32:        dest = dest + ((a * (src - dest)) >> 8), a being the
+ *                          source alpha, for the first three channels
+ * blit_surfacealpha_bytes: the same with a constant alpha for n bytes
+ * blit_surfacealpha_32:    the same for the first three channels of n pixels
+ * blit_surfacealpha_rgb16: the same for the channels of n rgb16 pixels
+ * blit_colorkey_N:         dest = src wherever src is not the key
+ * scale_bilinear_N:        n pixels of a bilinear row, from the rows above and
+ *                          below, with u starting at 0 and stepping du
+ * convert:                 depth conversions of n pixels, as in lv_video_convert.c
+ * warp_N:                  n pixels of a VisWarpField row, interpolated from
+ *                          src with rows pitch bytes apart, see lv_warp.c
+ */
+
+typedef void (*LVBlitAlphaFunc) (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+typedef void (*LVBlitColorkeyFunc) (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+typedef void (*LVScaleRowFunc) (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+typedef void (*LVConvertRowFunc) (uint8_t *dest, const uint8_t *src, int n);
+typedef void (*LVWarpRowFunc) (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+
+typedef struct {
+	void			(*blit_alphasrc_32) (uint8_t *dest, const uint8_t *src, int n);
+	LVBlitAlphaFunc		 blit_surfacealpha_bytes;
+	LVBlitAlphaFunc		 blit_surfacealpha_32;
+	LVBlitAlphaFunc		 blit_surfacealpha_rgb16;
+
+	LVBlitColorkeyFunc	 blit_colorkey_8;
+	LVBlitColorkeyFunc	 blit_colorkey_16;
+	LVBlitColorkeyFunc	 blit_colorkey_32;
+
+	LVScaleRowFunc		 scale_bilinear_16;
+	LVScaleRowFunc		 scale_bilinear_24;
+	LVScaleRowFunc		 scale_bilinear_32;
+
+	LVConvertRowFunc	 rgb16_to_rgb24;
+	LVConvertRowFunc	 rgb16_to_argb32;
+	LVConvertRowFunc	 rgb24_to_rgb16;
+	LVConvertRowFunc	 rgb24_to_argb32;
+	LVConvertRowFunc	 argb32_to_rgb16;
+	LVConvertRowFunc	 argb32_to_rgb24;
+
+	LVWarpRowFunc		 warp_8;
+	LVWarpRowFunc		 warp_32;
+} LVVideoSimd;
+
+extern LVVideoSimd _lv_video_simd;
+
+void _lv_video_simd_initialize (void);
+
+/* The alpha blenders, see lv_alpha_blend.h. The bytes version covers the 8, 24
+ * and 32 bits blenders, which blend every byte alike. */
+
+#if defined(HAVE_SSE2)
+void _lv_alpha_blend_bytes_sse2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha);
+void _lv_alpha_blend_16_sse2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha);
+
+void _lv_blit_alphasrc_32_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_blit_surfacealpha_bytes_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_surfacealpha_32_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_surfacealpha_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_colorkey_8_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+void _lv_blit_colorkey_16_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+void _lv_blit_colorkey_32_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+
+void _lv_scale_bilinear_16_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+void _lv_scale_bilinear_24_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+void _lv_scale_bilinear_32_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+
+void _lv_rgb16_to_rgb24_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb16_to_argb32_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb24_to_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb24_to_argb32_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_argb32_to_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_argb32_to_rgb24_sse2 (uint8_t *dest, const uint8_t *src, int n);
+
+void _lv_warp_8_sse2 (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+void _lv_warp_32_sse2 (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+#endif
+
+#if defined(HAVE_AVX2)
+void _lv_alpha_blend_bytes_avx2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha);
+
+void _lv_blit_alphasrc_32_avx2 (uint8_t *dest, const uint8_t *src, int n);
+void _lv_blit_surfacealpha_bytes_avx2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_surfacealpha_32_avx2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_colorkey_32_avx2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+
+void _lv_argb32_to_rgb16_avx2 (uint8_t *dest, const uint8_t *src, int n);
+#endif
+
+#if defined(HAVE_NEON)
+void _lv_alpha_blend_bytes_neon (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha);
+void _lv_alpha_blend_16_neon (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha);
+
+void _lv_blit_alphasrc_32_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_blit_surfacealpha_bytes_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_surfacealpha_32_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_surfacealpha_rgb16_neon (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha);
+void _lv_blit_colorkey_8_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+void _lv_blit_colorkey_16_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+void _lv_blit_colorkey_32_neon (uint8_t *dest, const uint8_t *src, int n, uint32_t key);
+
+void _lv_scale_bilinear_16_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+void _lv_scale_bilinear_24_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+void _lv_scale_bilinear_32_neon (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n);
+
+void _lv_rgb16_to_rgb24_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb16_to_argb32_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb24_to_rgb16_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_rgb24_to_argb32_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_argb32_to_rgb16_neon (uint8_t *dest, const uint8_t *src, int n);
+void _lv_argb32_to_rgb24_neon (uint8_t *dest, const uint8_t *src, int n);
+
+void _lv_warp_8_neon (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+void _lv_warp_32_neon (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n);
+#endif
+
+#endif /* _LV_VIDEO_SIMD_H */
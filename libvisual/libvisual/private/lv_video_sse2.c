@@ -0,0 +1,636 @@
+#include "lv_video_simd.h"
+#include "lv_common.h"
+
+#include <string.h>
+#include <emmintrin.h>
+
+/* d + ((a * (s - d)) >> 8) on 16 bit lanes, for a, s and d in [0, 255] */
+static inline __m128i blend_shift8 (__m128i d, __m128i s, __m128i a)
+{
+	__m128i diff = _mm_sub_epi16 (s, d);
+	__m128i lo = _mm_mullo_epi16 (diff, a);
+	__m128i hi = _mm_mulhi_epi16 (diff, a);
+
+	/* Bits 8 to 23 of the 32 bits products */
+	return _mm_add_epi16 (d, _mm_or_si128 (_mm_srli_epi16 (lo, 8), _mm_slli_epi16 (hi, 8)));
+}
+
+/* s1 + (a * (s2 - s1)) / 255 on 16 bit lanes, rounding towards zero like C */
+static inline __m128i blend_div255 (__m128i s1, __m128i s2, __m128i a)
+{
+	__m128i sign = _mm_cmpgt_epi16 (s1, s2);
+	__m128i diff = _mm_sub_epi16 (_mm_xor_si128 (_mm_sub_epi16 (s2, s1), sign), sign);
+	__m128i p = _mm_mullo_epi16 (diff, a);
+
+	/* x / 255 == (x + 1 + (x >> 8)) >> 8 for x below 65535 */
+	p = _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (p, _mm_set1_epi16 (1)), _mm_srli_epi16 (p, 8)), 8);
+
+	return _mm_add_epi16 (s1, _mm_sub_epi16 (_mm_xor_si128 (p, sign), sign));
+}
+
+static inline uint16_t alpha_blend_rgb16_pixel (uint16_t x, uint16_t y, int alpha)
+{
+	int r = (alpha * ((y >> 11) - (x >> 11))) / 255 + (x >> 11);
+	int g = (alpha * (((y >> 5) & 0x3f) - ((x >> 5) & 0x3f))) / 255 + ((x >> 5) & 0x3f);
+	int b = (alpha * ((y & 0x1f) - (x & 0x1f))) / 255 + (x & 0x1f);
+
+	return (r << 11) | (g << 5) | b;
+}
+
+void _lv_alpha_blend_bytes_sse2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i a = _mm_set1_epi16 (alpha);
+	visual_size_t i;
+
+	for (i = 0; i + 16 <= size; i += 16) {
+		__m128i x = _mm_loadu_si128 ((const __m128i *) (src1 + i));
+		__m128i y = _mm_loadu_si128 ((const __m128i *) (src2 + i));
+		__m128i lo = blend_div255 (_mm_unpacklo_epi8 (x, zero), _mm_unpacklo_epi8 (y, zero), a);
+		__m128i hi = blend_div255 (_mm_unpackhi_epi8 (x, zero), _mm_unpackhi_epi8 (y, zero), a);
+
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+	}
+
+	for (; i < size; i++)
+		dest[i] = (alpha * (src2[i] - src1[i])) / 255 + src1[i];
+}
+
+void _lv_alpha_blend_16_sse2 (uint8_t *dest, uint8_t *src1, uint8_t *src2, visual_size_t size, uint8_t alpha)
+{
+	uint16_t *destr = (uint16_t *) dest;
+	uint16_t *src1r = (uint16_t *) src1;
+	uint16_t *src2r = (uint16_t *) src2;
+	__m128i a = _mm_set1_epi16 (alpha);
+	__m128i mask5 = _mm_set1_epi16 (0x1f);
+	__m128i mask6 = _mm_set1_epi16 (0x3f);
+	visual_size_t n = size / 2;
+	visual_size_t i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128 ((const __m128i *) (src1r + i));
+		__m128i y = _mm_loadu_si128 ((const __m128i *) (src2r + i));
+		__m128i r = blend_div255 (_mm_srli_epi16 (x, 11), _mm_srli_epi16 (y, 11), a);
+		__m128i g = blend_div255 (_mm_and_si128 (_mm_srli_epi16 (x, 5), mask6),
+				_mm_and_si128 (_mm_srli_epi16 (y, 5), mask6), a);
+		__m128i b = blend_div255 (_mm_and_si128 (x, mask5), _mm_and_si128 (y, mask5), a);
+
+		_mm_storeu_si128 ((__m128i *) (destr + i),
+				_mm_or_si128 (_mm_or_si128 (_mm_slli_epi16 (r, 11), _mm_slli_epi16 (g, 5)), b));
+	}
+
+	for (; i < n; i++)
+		destr[i] = alpha_blend_rgb16_pixel (src1r[i], src2r[i], alpha);
+}
+
+void _lv_blit_alphasrc_32_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i mask = _mm_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1);
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (src + i * 4));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i * 4));
+		__m128i slo = _mm_unpacklo_epi8 (s, zero);
+		__m128i shi = _mm_unpackhi_epi8 (s, zero);
+
+		/* Every pixel its alpha on the colors, zero on the alpha itself */
+		__m128i alo = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (slo, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+		__m128i ahi = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (shi, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+
+		__m128i lo = blend_shift8 (_mm_unpacklo_epi8 (d, zero), slo, _mm_and_si128 (alo, mask));
+		__m128i hi = blend_shift8 (_mm_unpackhi_epi8 (d, zero), shi, _mm_and_si128 (ahi, mask));
+
+		_mm_storeu_si128 ((__m128i *) (dest + i * 4), _mm_packus_epi16 (lo, hi));
+	}
+
+	for (; i < n; i++) {
+		uint8_t *d = dest + i * 4;
+		const uint8_t *s = src + i * 4;
+		uint8_t alpha = s[3];
+
+		d[0] = ((alpha * (s[0] - d[0]) >> 8) + d[0]);
+		d[1] = ((alpha * (s[1] - d[1]) >> 8) + d[1]);
+		d[2] = ((alpha * (s[2] - d[2]) >> 8) + d[2]);
+	}
+}
+
+void _lv_blit_surfacealpha_bytes_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i a = _mm_set1_epi16 (alpha);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (src + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i));
+		__m128i lo = blend_shift8 (_mm_unpacklo_epi8 (d, zero), _mm_unpacklo_epi8 (s, zero), a);
+		__m128i hi = blend_shift8 (_mm_unpackhi_epi8 (d, zero), _mm_unpackhi_epi8 (s, zero), a);
+
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+	}
+
+	for (; i < n; i++)
+		dest[i] = ((alpha * (src[i] - dest[i]) >> 8) + dest[i]);
+}
+
+void _lv_blit_surfacealpha_32_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i a = _mm_set_epi16 (0, alpha, alpha, alpha, 0, alpha, alpha, alpha);
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (src + i * 4));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i * 4));
+		__m128i lo = blend_shift8 (_mm_unpacklo_epi8 (d, zero), _mm_unpacklo_epi8 (s, zero), a);
+		__m128i hi = blend_shift8 (_mm_unpackhi_epi8 (d, zero), _mm_unpackhi_epi8 (s, zero), a);
+
+		_mm_storeu_si128 ((__m128i *) (dest + i * 4), _mm_packus_epi16 (lo, hi));
+	}
+
+	for (; i < n; i++) {
+		uint8_t *d = dest + i * 4;
+		const uint8_t *s = src + i * 4;
+
+		d[0] = ((alpha * (s[0] - d[0]) >> 8) + d[0]);
+		d[1] = ((alpha * (s[1] - d[1]) >> 8) + d[1]);
+		d[2] = ((alpha * (s[2] - d[2]) >> 8) + d[2]);
+	}
+}
+
+void _lv_blit_surfacealpha_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n, uint8_t alpha)
+{
+	uint16_t *destr = (uint16_t *) dest;
+	const uint16_t *srcr = (const uint16_t *) src;
+	__m128i a = _mm_set1_epi16 (alpha);
+	__m128i mask5 = _mm_set1_epi16 (0x1f);
+	__m128i mask6 = _mm_set1_epi16 (0x3f);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (srcr + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (destr + i));
+		__m128i r = blend_shift8 (_mm_srli_epi16 (d, 11), _mm_srli_epi16 (s, 11), a);
+		__m128i g = blend_shift8 (_mm_and_si128 (_mm_srli_epi16 (d, 5), mask6),
+				_mm_and_si128 (_mm_srli_epi16 (s, 5), mask6), a);
+		__m128i b = blend_shift8 (_mm_and_si128 (d, mask5), _mm_and_si128 (s, mask5), a);
+
+		_mm_storeu_si128 ((__m128i *) (destr + i),
+				_mm_or_si128 (_mm_or_si128 (_mm_slli_epi16 (r, 11), _mm_slli_epi16 (g, 5)), b));
+	}
+
+	for (; i < n; i++) {
+		int d = destr[i];
+		int s = srcr[i];
+		int r = ((alpha * ((s >> 11) - (d >> 11)) >> 8) + (d >> 11));
+		int g = ((alpha * (((s >> 5) & 0x3f) - ((d >> 5) & 0x3f)) >> 8) + ((d >> 5) & 0x3f));
+		int b = ((alpha * ((s & 0x1f) - (d & 0x1f)) >> 8) + (d & 0x1f));
+
+		destr[i] = (r << 11) | (g << 5) | b;
+	}
+}
+
+void _lv_blit_colorkey_8_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	__m128i k = _mm_set1_epi8 (key);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (src + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i));
+		__m128i m = _mm_cmpeq_epi8 (s, k);
+
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_or_si128 (_mm_and_si128 (m, d), _mm_andnot_si128 (m, s)));
+	}
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dest[i] = src[i];
+	}
+}
+
+void _lv_blit_colorkey_16_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	uint16_t *destbuf = (uint16_t *) dest;
+	const uint16_t *srcbuf = (const uint16_t *) src;
+	__m128i k = _mm_set1_epi16 (key);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (srcbuf + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (destbuf + i));
+		__m128i m = _mm_cmpeq_epi16 (s, k);
+
+		_mm_storeu_si128 ((__m128i *) (destbuf + i), _mm_or_si128 (_mm_and_si128 (m, d), _mm_andnot_si128 (m, s)));
+	}
+
+	for (; i < n; i++) {
+		if (srcbuf[i] != key)
+			destbuf[i] = srcbuf[i];
+	}
+}
+
+void _lv_blit_colorkey_32_sse2 (uint8_t *dest, const uint8_t *src, int n, uint32_t key)
+{
+	uint32_t *destbuf = (uint32_t *) dest;
+	const uint32_t *srcbuf = (const uint32_t *) src;
+	__m128i k = _mm_set1_epi32 (key);
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (srcbuf + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (destbuf + i));
+		__m128i m = _mm_cmpeq_epi32 (s, k);
+
+		_mm_storeu_si128 ((__m128i *) (destbuf + i), _mm_or_si128 (_mm_and_si128 (m, d), _mm_andnot_si128 (m, s)));
+	}
+
+	for (; i < n; i++) {
+		if (srcbuf[i] != key)
+			destbuf[i] = srcbuf[i];
+	}
+}
+
+/* One bilinear pixel, from the channels of the upper and lower pixel pairs in
+ * 16 bit lanes, the left pixel in the low half. Returns the four channels in
+ * 32 bit lanes. Splitting the weights of the C scalers this way is exact:
+ *
+ *   ul * cul + ll * cll + ur * cur + lr * clr =
+ *     (0x100 - fracU) * ((0x100 - fracV) * cul + fracV * cll) +
+ *      fracU          * ((0x100 - fracV) * cur + fracV * clr)
+ *
+ * and the inner sums stay below 0x10000. */
+static inline __m128i bilinear_pixel (__m128i cu, __m128i cl, __m128i fv, __m128i fv1, uint32_t fracu)
+{
+	__m128i w = _mm_set_epi16 (fracu, fracu, fracu, fracu,
+			0x100 - fracu, 0x100 - fracu, 0x100 - fracu, 0x100 - fracu);
+	__m128i col = _mm_add_epi16 (_mm_mullo_epi16 (cu, fv1), _mm_mullo_epi16 (cl, fv));
+	__m128i lo = _mm_mullo_epi16 (col, w);
+	__m128i hi = _mm_mulhi_epu16 (col, w);
+
+	return _mm_srli_epi32 (_mm_add_epi32 (_mm_unpacklo_epi16 (lo, hi), _mm_unpackhi_epi16 (lo, hi)), 16);
+}
+
+static inline __m128i load_pair_16 (const uint16_t *p)
+{
+	return _mm_set_epi16 (0, p[1] >> 11, (p[1] >> 5) & 0x3f, p[1] & 0x1f,
+			0, p[0] >> 11, (p[0] >> 5) & 0x3f, p[0] & 0x1f);
+}
+
+static inline __m128i load_pair_24 (const uint8_t *p)
+{
+	return _mm_set_epi16 (0, p[5], p[4], p[3], 0, p[2], p[1], p[0]);
+}
+
+void _lv_scale_bilinear_16_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	uint16_t *dest_pixel = (uint16_t *) dest;
+	const uint16_t *su = (const uint16_t *) rowu;
+	const uint16_t *sl = (const uint16_t *) rowl;
+	__m128i fv = _mm_set1_epi16 (fracv);
+	__m128i fv1 = _mm_set1_epi16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		__m128i c = bilinear_pixel (load_pair_16 (su + (u >> 16)), load_pair_16 (sl + (u >> 16)),
+				fv, fv1, (u & 0xffff) >> 8);
+
+		c = _mm_packs_epi32 (c, c);
+
+		dest_pixel[x] = _mm_extract_epi16 (c, 0) | (_mm_extract_epi16 (c, 1) << 5) |
+			(_mm_extract_epi16 (c, 2) << 11);
+	}
+}
+
+void _lv_scale_bilinear_24_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	__m128i fv = _mm_set1_epi16 (fracv);
+	__m128i fv1 = _mm_set1_epi16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		__m128i c = bilinear_pixel (load_pair_24 (rowu + (u >> 16) * 3), load_pair_24 (rowl + (u >> 16) * 3),
+				fv, fv1, (u & 0xffff) >> 8);
+		uint32_t pixel;
+
+		c = _mm_packs_epi32 (c, c);
+		pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (c, c));
+
+		dest[0] = pixel;
+		dest[1] = pixel >> 8;
+		dest[2] = pixel >> 16;
+		dest += 3;
+	}
+}
+
+void _lv_scale_bilinear_32_sse2 (uint8_t *dest, const uint8_t *rowu, const uint8_t *rowl, uint32_t du, uint32_t fracv, int n)
+{
+	uint32_t *dest_pixel = (uint32_t *) dest;
+	const uint32_t *su = (const uint32_t *) rowu;
+	const uint32_t *sl = (const uint32_t *) rowl;
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i fv = _mm_set1_epi16 (fracv);
+	__m128i fv1 = _mm_set1_epi16 (0x100 - fracv);
+	uint32_t u = 0;
+	int x;
+
+	for (x = 0; x < n; x++, u += du) {
+		__m128i cu = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (su + (u >> 16))), zero);
+		__m128i cl = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (sl + (u >> 16))), zero);
+		__m128i c = bilinear_pixel (cu, cl, fv, fv1, (u & 0xffff) >> 8);
+
+		c = _mm_packs_epi32 (c, c);
+		dest_pixel[x] = _mm_cvtsi128_si32 (_mm_packus_epi16 (c, c));
+	}
+}
+
+/* Eight rgb16 pixels to eight 32 bits pixels, in two registers */
+static inline void rgb16_unpack (__m128i p, __m128i alpha, __m128i *lo, __m128i *hi)
+{
+	__m128i b = _mm_slli_epi16 (_mm_and_si128 (p, _mm_set1_epi16 (0x1f)), 3);
+	__m128i g = _mm_slli_epi16 (_mm_and_si128 (_mm_srli_epi16 (p, 5), _mm_set1_epi16 (0x3f)), 2);
+	__m128i r = _mm_slli_epi16 (_mm_srli_epi16 (p, 11), 3);
+	__m128i bg = _mm_or_si128 (b, _mm_slli_epi16 (g, 8));
+	__m128i ra = _mm_or_si128 (r, alpha);
+
+	*lo = _mm_unpacklo_epi16 (bg, ra);
+	*hi = _mm_unpackhi_epi16 (bg, ra);
+}
+
+/* Four 32 bits pixels to rgb16, in the low halves of the 32 bit lanes */
+static inline __m128i argb32_to_rgb16 (__m128i p)
+{
+	__m128i b = _mm_and_si128 (_mm_srli_epi32 (p, 3), _mm_set1_epi32 (0x001f));
+	__m128i g = _mm_and_si128 (_mm_srli_epi32 (p, 5), _mm_set1_epi32 (0x07e0));
+	__m128i r = _mm_and_si128 (_mm_srli_epi32 (p, 8), _mm_set1_epi32 (0xf800));
+
+	return _mm_or_si128 (_mm_or_si128 (b, g), r);
+}
+
+/* Packs the low halves of the 32 bit lanes, without saturating */
+static inline __m128i pack_low16 (__m128i a, __m128i b)
+{
+	a = _mm_srai_epi32 (_mm_slli_epi32 (a, 16), 16);
+	b = _mm_srai_epi32 (_mm_slli_epi32 (b, 16), 16);
+
+	return _mm_packs_epi32 (a, b);
+}
+
+/* Four packed 24 bits pixels, in the low twelve bytes, to 32 bits pixels */
+static inline __m128i rgb24_expand (__m128i p)
+{
+	__m128i q = _mm_unpacklo_epi64 (p, _mm_srli_si128 (p, 6));
+	__m128i lo = _mm_and_si128 (q, _mm_set_epi32 (0, 0xffffff, 0, 0xffffff));
+	__m128i hi = _mm_and_si128 (_mm_slli_epi64 (q, 8), _mm_set_epi32 (0xffffff, 0, 0xffffff, 0));
+
+	return _mm_or_si128 (lo, hi);
+}
+
+/* Four 32 bits pixels to packed 24 bits pixels, in the low twelve bytes */
+static inline __m128i argb32_compact (__m128i p)
+{
+	__m128i lo = _mm_and_si128 (p, _mm_set_epi32 (0, 0xffffff, 0, 0xffffff));
+	__m128i hi = _mm_and_si128 (_mm_srli_epi64 (p, 8), _mm_set_epi32 (0xffff, 0xff000000, 0xffff, 0xff000000));
+	__m128i q = _mm_or_si128 (lo, hi);
+
+	return _mm_or_si128 (_mm_move_epi64 (q), _mm_slli_si128 (_mm_srli_si128 (q, 8), 6));
+}
+
+static inline __m128i load_rgb24 (const uint8_t *src)
+{
+	uint32_t last;
+
+	memcpy (&last, src + 8, 4);
+
+	return _mm_unpacklo_epi64 (_mm_loadl_epi64 ((const __m128i *) src), _mm_cvtsi32_si128 (last));
+}
+
+static inline void store_rgb24 (uint8_t *dest, __m128i p)
+{
+	uint32_t last = _mm_cvtsi128_si32 (_mm_srli_si128 (p, 8));
+
+	_mm_storel_epi64 ((__m128i *) dest, p);
+	memcpy (dest + 8, &last, 4);
+}
+
+void _lv_rgb16_to_rgb24_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	const uint16_t *sbuf = (const uint16_t *) src;
+	__m128i zero = _mm_setzero_si128 ();
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i lo, hi;
+
+		rgb16_unpack (_mm_loadu_si128 ((const __m128i *) (sbuf + i)), zero, &lo, &hi);
+
+		store_rgb24 (dest + i * 3, argb32_compact (lo));
+		store_rgb24 (dest + i * 3 + 12, argb32_compact (hi));
+	}
+
+	for (; i < n; i++) {
+		dest[i * 3] = (sbuf[i] & 0x1f) << 3;
+		dest[i * 3 + 1] = ((sbuf[i] >> 5) & 0x3f) << 2;
+		dest[i * 3 + 2] = (sbuf[i] >> 11) << 3;
+	}
+}
+
+void _lv_rgb16_to_argb32_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	const uint16_t *sbuf = (const uint16_t *) src;
+	__m128i alpha = _mm_set1_epi16 ((short) 0xff00);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i lo, hi;
+
+		rgb16_unpack (_mm_loadu_si128 ((const __m128i *) (sbuf + i)), alpha, &lo, &hi);
+
+		_mm_storeu_si128 ((__m128i *) (dest + i * 4), lo);
+		_mm_storeu_si128 ((__m128i *) (dest + i * 4 + 16), hi);
+	}
+
+	for (; i < n; i++) {
+		dest[i * 4] = (sbuf[i] & 0x1f) << 3;
+		dest[i * 4 + 1] = ((sbuf[i] >> 5) & 0x3f) << 2;
+		dest[i * 4 + 2] = (sbuf[i] >> 11) << 3;
+		dest[i * 4 + 3] = 255;
+	}
+}
+
+void _lv_rgb24_to_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	uint16_t *dbuf = (uint16_t *) dest;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i lo = argb32_to_rgb16 (rgb24_expand (load_rgb24 (src + i * 3)));
+		__m128i hi = argb32_to_rgb16 (rgb24_expand (load_rgb24 (src + i * 3 + 12)));
+
+		_mm_storeu_si128 ((__m128i *) (dbuf + i), pack_low16 (lo, hi));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *s = src + i * 3;
+
+		dbuf[i] = ((s[2] >> 3) << 11) | ((s[1] >> 2) << 5) | (s[0] >> 3);
+	}
+}
+
+void _lv_rgb24_to_argb32_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	__m128i alpha = _mm_set1_epi32 (0xff000000);
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+		_mm_storeu_si128 ((__m128i *) (dest + i * 4), _mm_or_si128 (rgb24_expand (load_rgb24 (src + i * 3)), alpha));
+
+	for (; i < n; i++) {
+		dest[i * 4] = src[i * 3];
+		dest[i * 4 + 1] = src[i * 3 + 1];
+		dest[i * 4 + 2] = src[i * 3 + 2];
+		dest[i * 4 + 3] = 255;
+	}
+}
+
+void _lv_argb32_to_rgb16_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	uint16_t *dbuf = (uint16_t *) dest;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i lo = argb32_to_rgb16 (_mm_loadu_si128 ((const __m128i *) (src + i * 4)));
+		__m128i hi = argb32_to_rgb16 (_mm_loadu_si128 ((const __m128i *) (src + i * 4 + 16)));
+
+		_mm_storeu_si128 ((__m128i *) (dbuf + i), pack_low16 (lo, hi));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *s = src + i * 4;
+
+		dbuf[i] = ((s[2] >> 3) << 11) | ((s[1] >> 2) << 5) | (s[0] >> 3);
+	}
+}
+
+void _lv_argb32_to_rgb24_sse2 (uint8_t *dest, const uint8_t *src, int n)
+{
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+		store_rgb24 (dest + i * 3, argb32_compact (_mm_loadu_si128 ((const __m128i *) (src + i * 4))));
+
+	for (; i < n; i++) {
+		dest[i * 3] = src[i * 4];
+		dest[i * 3 + 1] = src[i * 4 + 1];
+		dest[i * 3 + 2] = src[i * 4 + 2];
+	}
+}
+
+/* Two pixels a step, the weights are spread over the four channels of the
+ * top and bottom pixel pairs. The sums of the products stay below 65536. */
+static inline __m128i warp_32_pixel (const uint8_t *p, int pitch, uint32_t weights, __m128i zero)
+{
+	__m128i top = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) p), zero);
+	__m128i bottom = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (p + pitch)), zero);
+	__m128i w = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (weights), zero);
+
+	w = _mm_unpacklo_epi16 (w, w);
+
+	return _mm_add_epi16 (_mm_mullo_epi16 (top, _mm_unpacklo_epi32 (w, w)),
+			_mm_mullo_epi16 (bottom, _mm_unpackhi_epi32 (w, w)));
+}
+
+void _lv_warp_32_sse2 (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	int i;
+
+	for (i = 0; i + 2 <= n; i += 2) {
+		const VisWarpFieldEntry *e = &entries[i];
+		__m128i s0 = warp_32_pixel (src + e[0].y * pitch + e[0].x * 4, pitch, e[0].weights, zero);
+		__m128i s1 = warp_32_pixel (src + e[1].y * pitch + e[1].x * 4, pitch, e[1].weights, zero);
+		__m128i sum = _mm_add_epi16 (_mm_unpacklo_epi64 (s0, s1), _mm_unpackhi_epi64 (s0, s1));
+
+		sum = _mm_srli_epi16 (sum, 8);
+
+		_mm_storel_epi64 ((__m128i *) (dest + i * 4), _mm_packus_epi16 (sum, sum));
+	}
+
+	for (; i < n; i++) {
+		__m128i s = warp_32_pixel (src + entries[i].y * pitch + entries[i].x * 4, pitch, entries[i].weights, zero);
+		uint32_t pixel;
+
+		s = _mm_srli_epi16 (_mm_add_epi16 (s, _mm_srli_si128 (s, 8)), 8);
+		pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (s, s));
+
+		memcpy (dest + i * 4, &pixel, 4);
+	}
+}
+
+/* The byte pair at p, as one 16 bits lane */
+static inline int warp_8_pair (const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+/* Eight pixels a step. The pixel pairs are gathered into 16 bits lanes, the
+ * weights are picked from the entries four at a time. */
+void _lv_warp_8_sse2 (uint8_t *dest, const uint8_t *src, int pitch, const VisWarpFieldEntry *entries, int n)
+{
+	__m128i mask = _mm_set1_epi16 (0xff);
+	__m128i mask32 = _mm_set1_epi32 (0xff);
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		const VisWarpFieldEntry *e = &entries[i];
+		const uint8_t *p0 = src + e[0].y * pitch + e[0].x;
+		const uint8_t *p1 = src + e[1].y * pitch + e[1].x;
+		const uint8_t *p2 = src + e[2].y * pitch + e[2].x;
+		const uint8_t *p3 = src + e[3].y * pitch + e[3].x;
+		const uint8_t *p4 = src + e[4].y * pitch + e[4].x;
+		const uint8_t *p5 = src + e[5].y * pitch + e[5].x;
+		const uint8_t *p6 = src + e[6].y * pitch + e[6].x;
+		const uint8_t *p7 = src + e[7].y * pitch + e[7].x;
+		__m128i top = _mm_setr_epi16 (warp_8_pair (p0), warp_8_pair (p1), warp_8_pair (p2), warp_8_pair (p3),
+				warp_8_pair (p4), warp_8_pair (p5), warp_8_pair (p6), warp_8_pair (p7));
+		__m128i bottom = _mm_setr_epi16 (warp_8_pair (p0 + pitch), warp_8_pair (p1 + pitch),
+				warp_8_pair (p2 + pitch), warp_8_pair (p3 + pitch), warp_8_pair (p4 + pitch),
+				warp_8_pair (p5 + pitch), warp_8_pair (p6 + pitch), warp_8_pair (p7 + pitch));
+		__m128i wlo, whi, sum;
+
+		/* An entry is 8 bytes, the weights are its second dword */
+		wlo = _mm_unpacklo_epi64 (
+				_mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) &e[0]), _MM_SHUFFLE (3, 1, 3, 1)),
+				_mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) &e[2]), _MM_SHUFFLE (3, 1, 3, 1)));
+		whi = _mm_unpacklo_epi64 (
+				_mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) &e[4]), _MM_SHUFFLE (3, 1, 3, 1)),
+				_mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) &e[6]), _MM_SHUFFLE (3, 1, 3, 1)));
+
+		sum = _mm_mullo_epi16 (_mm_and_si128 (top, mask),
+				_mm_packs_epi32 (_mm_and_si128 (wlo, mask32), _mm_and_si128 (whi, mask32)));
+		sum = _mm_add_epi16 (sum, _mm_mullo_epi16 (_mm_srli_epi16 (top, 8),
+				_mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (wlo, 8), mask32),
+					_mm_and_si128 (_mm_srli_epi32 (whi, 8), mask32))));
+		sum = _mm_add_epi16 (sum, _mm_mullo_epi16 (_mm_and_si128 (bottom, mask),
+				_mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (wlo, 16), mask32),
+					_mm_and_si128 (_mm_srli_epi32 (whi, 16), mask32))));
+		sum = _mm_add_epi16 (sum, _mm_mullo_epi16 (_mm_srli_epi16 (bottom, 8),
+				_mm_packs_epi32 (_mm_srli_epi32 (wlo, 24), _mm_srli_epi32 (whi, 24))));
+
+		sum = _mm_srli_epi16 (sum, 8);
+
+		_mm_storel_epi64 ((__m128i *) (dest + i), _mm_packus_epi16 (sum, sum));
+	}
+
+	for (; i < n; i++) {
+		const uint8_t *p = src + entries[i].y * pitch + entries[i].x;
+		uint32_t w = entries[i].weights;
+
+		dest[i] = (p[0] * (w & 0xff) + p[1] * ((w >> 8) & 0xff) +
+				p[pitch] * ((w >> 16) & 0xff) + p[pitch + 1] * (w >> 24)) >> 8;
+	}
+}
@@ -344,10 +344,10 @@ int main (int argc, char *argv[])
 							break;
 
 						case SDLK_i:
-							if (interpol == VISUAL_VIDEO_SCALE_NEAREST)
-								interpol = VISUAL_VIDEO_SCALE_BILINEAR;
-							else
+							if (interpol == VISUAL_VIDEO_SCALE_LANCZOS2)
 								interpol = VISUAL_VIDEO_SCALE_NEAREST;
+							else
+								interpol++;
 							
 							break;
 
@@ -179,7 +179,12 @@ int main (int argc, char *argv[])
 	int sysize = 700;
 	int interpol = VISUAL_VIDEO_SCALE_NEAREST;
         int frames = 0;
+	int parallel = TRUE;
+	int threshold;
+	int modeframes[2] = { 0, 0 };
+	int modemsecs[2] = { 0, 0 };
 	VisTime start, end;
+	VisTimer modetimer;
 
 	bpp = 4;
 	sdl_init (width, height);
@@ -234,6 +239,12 @@ int main (int argc, char *argv[])
 
 	SDL_EnableKeyRepeat (SDL_DEFAULT_REPEAT_DELAY, SDL_DEFAULT_REPEAT_INTERVAL);
 
+	/* 't' toggles splitting the VisVideo work over the worker threads */
+	threshold = visual_video_get_parallel_threshold ();
+
+	visual_timer_init (&modetimer);
+	visual_timer_start (&modetimer);
+
 	visual_time_get (&start);
 
 	while (1) {
@@ -271,6 +282,7 @@ int main (int argc, char *argv[])
 
 		sdl_draw_buf ();
 		frames++;
+		modeframes[parallel]++;
 
 		while (SDL_PollEvent (&event)) {
 			switch (event.type) {
@@ -321,10 +333,10 @@ int main (int argc, char *argv[])
 							break;
 
 						case SDLK_i:
-							if (interpol == VISUAL_VIDEO_SCALE_NEAREST)
-								interpol = VISUAL_VIDEO_SCALE_BILINEAR;
-							else
+							if (interpol == VISUAL_VIDEO_SCALE_LANCZOS2)
 								interpol = VISUAL_VIDEO_SCALE_NEAREST;
+							else
+								interpol++;
 
 							break;
 
@@ -342,6 +354,15 @@ int main (int argc, char *argv[])
 
 							break;
 
+						case SDLK_t:
+							modemsecs[parallel] += visual_timer_elapsed_msecs (&modetimer);
+							visual_timer_start (&modetimer);
+
+							parallel = !parallel;
+							visual_video_set_parallel_threshold (parallel ? threshold : -1);
+
+							break;
+
 						case SDLK_ESCAPE:
 							goto out;
 							break;
@@ -361,6 +382,8 @@ int main (int argc, char *argv[])
 out:
 	visual_time_get (&end);
 
+	modemsecs[parallel] += visual_timer_elapsed_msecs (&modetimer);
+
 	VisTime diff;
 
 	visual_time_difference (&diff, &start, &end);
@@ -369,6 +392,11 @@ out:
 	printf ("Ran: %d:%d, drawn %d frames\n",
 			diff.tv_sec, diff.tv_usec, frames);
 
+	printf ("Serial: %d frames, %.1f fps\n", modeframes[FALSE],
+			modemsecs[FALSE] > 0 ? modeframes[FALSE] * 1000.0 / modemsecs[FALSE] : 0.0);
+	printf ("Parallel (threshold %d pixels): %d frames, %.1f fps\n", threshold, modeframes[TRUE],
+			modemsecs[TRUE] > 0 ? modeframes[TRUE] * 1000.0 / modemsecs[TRUE] : 0.0);
+
 	SDL_Quit ();
 }
 
@@ -0,0 +1,317 @@
+#include <libvisual/libvisual.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEYS		200000
+#define TABLESIZE	1024
+#define CHECK_KEYS	10000
+
+/* The VisHashmap as it was before it stored its entries in the table: one
+ * VisList of chain entries per bucket, in a table that never grows. */
+typedef struct {
+	VisList		*buckets;
+	int		 tablesize;
+} ChainMap;
+
+typedef struct {
+	char		*key;
+	void		*data;
+} ChainEntry;
+
+static int chain_entry_destroyer (void *data)
+{
+	ChainEntry *entry = data;
+
+	visual_mem_free (entry->key);
+
+	return visual_mem_free (entry);
+}
+
+static int chain_hash (ChainMap *map, const char *key)
+{
+	const char *p;
+	int hash = 0;
+
+	for (p = key; *p != '\0'; p++)
+		hash = (hash << 5) - hash + *p;
+
+	return (unsigned int) hash % map->tablesize;
+}
+
+static void chain_init (ChainMap *map, int tablesize)
+{
+	int i;
+
+	map->tablesize = tablesize;
+	map->buckets = visual_mem_new0 (VisList, tablesize);
+
+	for (i = 0; i < tablesize; i++)
+		visual_list_init (&map->buckets[i], chain_entry_destroyer);
+}
+
+static void chain_free (ChainMap *map)
+{
+	int i;
+
+	for (i = 0; i < map->tablesize; i++)
+		visual_collection_destroy (VISUAL_COLLECTION (&map->buckets[i]));
+
+	visual_mem_free (map->buckets);
+}
+
+static ChainEntry *chain_find (ChainMap *map, const char *key, VisList **bucket, VisListEntry **le)
+{
+	ChainEntry *entry;
+
+	*bucket = &map->buckets[chain_hash (map, key)];
+	*le = NULL;
+
+	while ((entry = visual_list_next (*bucket, le)) != NULL) {
+		if (strcmp (entry->key, key) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void chain_put (ChainMap *map, const char *key, void *data)
+{
+	ChainEntry *entry;
+	VisListEntry *le;
+	VisList *bucket;
+
+	entry = chain_find (map, key, &bucket, &le);
+	if (entry != NULL) {
+		entry->data = data;
+
+		return;
+	}
+
+	entry = visual_mem_new0 (ChainEntry, 1);
+	entry->key = visual_strdup (key);
+	entry->data = data;
+
+	visual_list_add (bucket, entry);
+}
+
+static void *chain_get (ChainMap *map, const char *key)
+{
+	ChainEntry *entry;
+	VisListEntry *le;
+	VisList *bucket;
+
+	entry = chain_find (map, key, &bucket, &le);
+
+	return entry != NULL ? entry->data : NULL;
+}
+
+static void chain_remove (ChainMap *map, const char *key)
+{
+	VisListEntry *le;
+	VisList *bucket;
+
+	if (chain_find (map, key, &bucket, &le) != NULL)
+		visual_list_destroy (bucket, &le);
+}
+
+typedef struct {
+	int		 put;
+	int		 put_max;	/* Slowest single put, in usecs */
+	int		 hit;
+	int		 miss;
+	int		 remove;
+} Result;
+
+static void print_result (const char *name, Result *result)
+{
+	printf ("%-10s put %5d ms (slowest %6d us), hit %5d ms, miss %5d ms, remove %5d ms\n", name,
+			result->put, result->put_max, result->hit, result->miss, result->remove);
+}
+
+static void chain_bench (char **keys, char **missing, int count, int tablesize, Result *result)
+{
+	ChainMap map;
+	VisTimer timer, single;
+	int i;
+
+	chain_init (&map, tablesize);
+
+	visual_timer_init (&timer);
+	visual_timer_init (&single);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++) {
+		int usecs;
+
+		visual_timer_start (&single);
+		chain_put (&map, keys[i], keys[i]);
+
+		usecs = visual_timer_elapsed_usecs (&single);
+		if (usecs > result->put_max)
+			result->put_max = usecs;
+	}
+	result->put = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++) {
+		if (chain_get (&map, keys[i]) != keys[i])
+			printf ("chain: lost %s\n", keys[i]);
+	}
+	result->hit = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++)
+		chain_get (&map, missing[i]);
+	result->miss = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++)
+		chain_remove (&map, keys[i]);
+	result->remove = visual_timer_elapsed_msecs (&timer);
+
+	chain_free (&map);
+}
+
+static void hashmap_bench (char **keys, char **missing, int count, int reserve, Result *result)
+{
+	VisHashmap *hashmap;
+	VisTimer timer, single;
+	int i;
+
+	hashmap = visual_hashmap_new (NULL);
+
+	if (reserve != FALSE)
+		visual_hashmap_reserve (hashmap, count);
+
+	visual_timer_init (&timer);
+	visual_timer_init (&single);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++) {
+		int usecs;
+
+		visual_timer_start (&single);
+		visual_hashmap_put_string (hashmap, keys[i], keys[i]);
+
+		usecs = visual_timer_elapsed_usecs (&single);
+		if (usecs > result->put_max)
+			result->put_max = usecs;
+	}
+	result->put = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++) {
+		if (visual_hashmap_get_string (hashmap, keys[i]) != keys[i])
+			printf ("hashmap: lost %s\n", keys[i]);
+	}
+	result->hit = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++)
+		visual_hashmap_get_string (hashmap, missing[i]);
+	result->miss = visual_timer_elapsed_msecs (&timer);
+
+	visual_timer_start (&timer);
+	for (i = 0; i < count; i++)
+		visual_hashmap_remove_string (hashmap, keys[i], FALSE);
+	result->remove = visual_timer_elapsed_msecs (&timer);
+
+	visual_object_unref (VISUAL_OBJECT (hashmap));
+}
+
+/* Puts keys one by one and, after every put made while the table is growing,
+ * looks up every key put so far. Returns the number of lookups that missed. */
+static int hashmap_check (char **keys, int count)
+{
+	VisHashmap *hashmap;
+	int lost = 0;
+	int i, j;
+
+	hashmap = visual_hashmap_new (NULL);
+
+	for (i = 0; i < count; i++) {
+		visual_hashmap_put_string (hashmap, keys[i], keys[i]);
+
+		if (hashmap->oldtable == NULL)
+			continue;
+
+		for (j = 0; j <= i; j++) {
+			if (visual_hashmap_get_string (hashmap, keys[j]) != keys[j])
+				lost++;
+		}
+	}
+
+	if (visual_collection_size (VISUAL_COLLECTION (hashmap)) != count)
+		lost++;
+
+	visual_object_unref (VISUAL_OBJECT (hashmap));
+
+	return lost;
+}
+
+/* Compares VisHashmap with the separate chaining it used before, putting,
+ * finding and removing string keys like the ones VisCache and VisHashlist use.
+ * The chained map gets the fixed table size those used to set. First checks
+ * that no key goes missing while the VisHashmap grows.
+ *
+ * usage: hashmap_bench [keys] [tablesize] */
+int main (int argc, char **argv)
+{
+	Result result;
+	char **keys;
+	char **missing;
+	int count = KEYS;
+	int tablesize = TABLESIZE;
+	int i;
+
+	visual_init (&argc, &argv);
+
+	if (argc > 1)
+		count = atoi (argv[1]);
+
+	if (argc > 2)
+		tablesize = atoi (argv[2]);
+
+	keys = visual_mem_new0 (char *, count);
+	missing = visual_mem_new0 (char *, count);
+
+	for (i = 0; i < count; i++) {
+		char buf[64];
+
+		snprintf (buf, sizeof (buf), "plugin-%d-%08x", i, (unsigned int) i * 2654435761U);
+		keys[i] = visual_strdup (buf);
+
+		snprintf (buf, sizeof (buf), "missing-%d-%08x", i, (unsigned int) i * 2246822519U);
+		missing[i] = visual_strdup (buf);
+	}
+
+	printf ("Hashmap bench %d string keys, chained table size %d\n", count, tablesize);
+
+	printf ("growing check, %d lookups missed\n", hashmap_check (keys, count < CHECK_KEYS ? count : CHECK_KEYS));
+
+	memset (&result, 0, sizeof (result));
+	chain_bench (keys, missing, count, tablesize, &result);
+	print_result ("chained", &result);
+
+	memset (&result, 0, sizeof (result));
+	hashmap_bench (keys, missing, count, FALSE, &result);
+	print_result ("growing", &result);
+
+	memset (&result, 0, sizeof (result));
+	hashmap_bench (keys, missing, count, TRUE, &result);
+	print_result ("reserved", &result);
+
+	for (i = 0; i < count; i++) {
+		visual_mem_free (keys[i]);
+		visual_mem_free (missing[i]);
+	}
+
+	visual_mem_free (keys);
+	visual_mem_free (missing);
+
+	visual_quit ();
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include <libvisual/libvisual.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEPTH		VISUAL_VIDEO_DEPTH_32BIT
+#define TIMES		500
+#define STEPS		25
+
+/* Frames per second of a VisBin that keeps switching between two actors,
+ * so nearly every frame renders both actors and a morph.
+ *
+ * usage: morph_switch_throughput_bench [actor1] [actor2] [morph] [parallel] */
+int main (int argc, char **argv)
+{
+	VisBin *bin;
+	VisVideo *video;
+	VisTimer timer;
+	const char *actors[2] = { "lv_analyzer", "lv_scope" };
+	const char *morph = "alphablend";
+	int parallel = TRUE;
+	int morphframes = 0;
+	int switches = 0;
+	int current = 0;
+	int msecs;
+	int i;
+
+	visual_init (&argc, &argv);
+
+	if (argc > 1)
+		actors[0] = argv[1];
+
+	if (argc > 2)
+		actors[1] = argv[2];
+
+	if (argc > 3)
+		morph = argv[3];
+
+	if (argc > 4)
+		parallel = atoi (argv[4]);
+
+	bin = visual_bin_new ();
+
+	visual_bin_set_supported_depth (bin, VISUAL_VIDEO_DEPTH_ALL);
+	visual_bin_set_preferred_depth (bin, VISUAL_BIN_DEPTH_HIGHEST);
+
+	visual_bin_switch_set_style (bin, VISUAL_SWITCH_STYLE_MORPH);
+	visual_bin_switch_set_automatic (bin, TRUE);
+	visual_bin_switch_set_mode (bin, VISUAL_MORPH_MODE_STEPS);
+	visual_bin_switch_set_steps (bin, STEPS);
+	visual_bin_switch_set_parallel (bin, parallel);
+
+	video = visual_video_new ();
+
+	visual_video_set_depth (video, DEPTH);
+	visual_video_set_dimension (video, 640, 400);
+	visual_video_allocate_buffer (video);
+
+	visual_bin_set_video (bin, video);
+	visual_bin_connect_by_names (bin, (char *) actors[current], "debug");
+	visual_bin_realize (bin);
+	visual_bin_sync (bin, FALSE);
+	visual_bin_depth_changed (bin);
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < TIMES; i++) {
+		if (bin->morphing == FALSE) {
+			current = !current;
+
+			visual_bin_set_morph_by_name (bin, (char *) morph);
+			visual_bin_switch_actor_by_name (bin, (char *) actors[current]);
+
+			switches++;
+		}
+
+		if (visual_bin_depth_changed (bin) == TRUE) {
+			visual_video_free_buffer (video);
+			visual_video_set_depth (video, visual_bin_get_depth (bin));
+			visual_video_set_dimension (video, 640, 400);
+			visual_video_allocate_buffer (video);
+
+			visual_bin_set_video (bin, video);
+			visual_bin_sync (bin, TRUE);
+		}
+
+		if (bin->morphing == TRUE)
+			morphframes++;
+
+		visual_bin_run (bin);
+	}
+
+	msecs = visual_timer_elapsed_msecs (&timer);
+
+	printf ("Morph switch throughput bench %d times depthBPP %d morph: %s actors: %s %s parallel: %d\n",
+			TIMES, video->bpp, morph, actors[0], actors[1], parallel);
+	printf ("%d switches, %d morphing frames, %.1f frames per second\n",
+			switches, morphframes, msecs > 0 ? TIMES * 1000.0 / msecs : 0.0);
+
+	visual_object_unref (VISUAL_OBJECT (bin));
+	visual_object_unref (VISUAL_OBJECT (video));
+
+	visual_quit ();
+
+	return EXIT_SUCCESS;
+}
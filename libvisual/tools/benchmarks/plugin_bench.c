@@ -0,0 +1,576 @@
+#include <libvisual/libvisual.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+
+#define DEFAULT_FRAMES		100
+#define DEFAULT_WARMUP		10
+#define DEFAULT_SIZES		"320x200,640x400,1280x720"
+#define DEFAULT_THRESHOLD	10.0
+
+#define AUDIO_RATE		44100
+#define AUDIO_SAMPLES		1024
+
+#define SEED			1
+
+#define MAX_SIZES		16
+#define MAX_BASELINE		4096
+
+typedef enum {
+	BENCH_ACTOR,
+	BENCH_MORPH,
+	BENCH_TRANSFORM
+} BenchType;
+
+typedef struct {
+	BenchType	 type;
+	const char	*plugin;
+	int		 width;
+	int		 height;
+	int		 depth;	/* in bits */
+
+	int		 frames;
+	int		 min;	/* frame times in microseconds */
+	int		 median;
+	int		 p99;
+	double		 ns_per_pixel;
+} BenchResult;
+
+typedef struct {
+	char		 key[192];
+	int		 median;
+} BaselineEntry;
+
+static const char *type_names[] = { "actor", "morph", "transform" };
+
+static int opt_types = (1 << BENCH_ACTOR) | (1 << BENCH_MORPH) | (1 << BENCH_TRANSFORM);
+static const char *opt_plugin = NULL;
+static int opt_sizes[MAX_SIZES][2];
+static int opt_nsizes = 0;
+static int opt_depths = 0;
+static int opt_frames = DEFAULT_FRAMES;
+static int opt_warmup = DEFAULT_WARMUP;
+static int opt_json = FALSE;
+static double opt_threshold = DEFAULT_THRESHOLD;
+
+static BaselineEntry *baseline = NULL;
+static int baseline_count = 0;
+static int regressions = 0;
+static int results = 0;
+
+static VisAudio *audio;
+static VisPalette *palette;
+
+/* Two sweeping sines over a bit of noise, a function of the frame number only
+ * so every run and every plugin sees the same signal */
+static void audio_feed (int frame)
+{
+	static float samples[AUDIO_SAMPLES * 2];
+	VisRandomContext rcontext;
+	VisBuffer buffer;
+	int i;
+
+	visual_random_context_init (&rcontext, SEED + frame);
+
+	for (i = 0; i < AUDIO_SAMPLES; i++) {
+		double t = (double) (frame * AUDIO_SAMPLES + i) / AUDIO_RATE;
+		float noise = visual_random_context_float (&rcontext) * 0.1 - 0.05;
+
+		samples[i * 2] = 0.5 * sin (2 * VISUAL_MATH_PI * (110 + 20 * sin (t)) * t) + noise;
+		samples[i * 2 + 1] = 0.4 * sin (2 * VISUAL_MATH_PI * (440 + 80 * cos (t / 3)) * t) + noise;
+	}
+
+	visual_buffer_init (&buffer, samples, sizeof (samples), NULL);
+
+	visual_audio_samplepool_input (audio->samplepool, &buffer, VISUAL_AUDIO_SAMPLE_RATE_44100,
+			VISUAL_AUDIO_SAMPLE_FORMAT_FLOAT, VISUAL_AUDIO_SAMPLE_CHANNEL_STEREO);
+
+	visual_audio_analyze (audio);
+}
+
+/* A fixed pattern for morph and transform sources */
+static VisVideo *video_new (int width, int height, VisVideoDepth depth, int pattern)
+{
+	VisVideo *video = visual_video_new ();
+	uint8_t *pixels;
+	int x, y;
+
+	visual_video_set_depth (video, depth);
+	visual_video_set_dimension (video, width, height);
+	visual_video_set_palette (video, palette);
+	visual_video_allocate_buffer (video);
+
+	pixels = visual_video_get_pixels (video);
+
+	for (y = 0; y < height; y++) {
+		uint8_t *row = pixels + y * video->pitch;
+
+		for (x = 0; x < width * video->bpp; x++)
+			row[x] = (x * (pattern + 1) + y * (pattern + 3)) ^ (pattern * 0x55);
+	}
+
+	return video;
+}
+
+static int compare_int (const void *a, const void *b)
+{
+	return *(const int *) a - *(const int *) b;
+}
+
+static void baseline_key (char *key, int size, BenchType type, const char *plugin, int width, int height, int depth)
+{
+	snprintf (key, size, "%s,%s,%d,%d,%d", type_names[type], plugin, width, height, depth);
+}
+
+/* Reads a CSV report of an earlier run */
+static int baseline_load (const char *filename)
+{
+	FILE *f;
+	char line[512];
+
+	if ((f = fopen (filename, "r")) == NULL) {
+		perror (filename);
+
+		return -1;
+	}
+
+	baseline = visual_mem_new0 (BaselineEntry, MAX_BASELINE);
+
+	while (fgets (line, sizeof (line), f) != NULL && baseline_count < MAX_BASELINE) {
+		char type[32], plugin[128];
+		int width, height, depth, frames, min, median;
+
+		if (sscanf (line, "%31[^,],%127[^,],%d,%d,%d,%d,%d,%d", type, plugin, &width, &height, &depth,
+					&frames, &min, &median) != 8)
+			continue;
+
+		snprintf (baseline[baseline_count].key, sizeof (baseline[0].key), "%s,%s,%d,%d,%d", type, plugin,
+				width, height, depth);
+		baseline[baseline_count].median = median;
+		baseline_count++;
+	}
+
+	fclose (f);
+
+	return 0;
+}
+
+static void baseline_compare (BenchResult *result)
+{
+	char key[192];
+	int i;
+
+	baseline_key (key, sizeof (key), result->type, result->plugin, result->width, result->height, result->depth);
+
+	for (i = 0; i < baseline_count; i++) {
+		double change;
+
+		if (strcmp (baseline[i].key, key) != 0)
+			continue;
+
+		/* Below a microsecond the timer can't tell */
+		if (baseline[i].median < 1)
+			return;
+
+		change = (result->median - baseline[i].median) * 100.0 / baseline[i].median;
+
+		if (change > opt_threshold) {
+			fprintf (stderr, "REGRESSION %s: median %d us, baseline %d us (%+.1f%%)\n", key,
+					result->median, baseline[i].median, change);
+
+			regressions++;
+		}
+
+		return;
+	}
+}
+
+static void result_print (BenchResult *result)
+{
+	if (opt_json) {
+		printf ("%s\n  { \"type\": \"%s\", \"plugin\": \"%s\", \"width\": %d, \"height\": %d, \"depth\": %d, "
+				"\"frames\": %d, \"min_us\": %d, \"median_us\": %d, \"p99_us\": %d, \"ns_per_pixel\": %.3f }",
+				results > 0 ? "," : "[", type_names[result->type], result->plugin, result->width,
+				result->height, result->depth, result->frames, result->min, result->median, result->p99,
+				result->ns_per_pixel);
+	} else {
+		if (results == 0)
+			printf ("type,plugin,width,height,depth,frames,min_us,median_us,p99_us,ns_per_pixel\n");
+
+		printf ("%s,%s,%d,%d,%d,%d,%d,%d,%d,%.3f\n", type_names[result->type], result->plugin,
+				result->width, result->height, result->depth, result->frames, result->min,
+				result->median, result->p99, result->ns_per_pixel);
+	}
+
+	fflush (stdout);
+
+	results++;
+}
+
+static void result_finish (BenchResult *result, int *times)
+{
+	qsort (times, result->frames, sizeof (int), compare_int);
+
+	result->min = times[0];
+	result->median = times[result->frames / 2];
+	result->p99 = times[(result->frames * 99) / 100 < result->frames ? (result->frames * 99) / 100 : result->frames - 1];
+	result->ns_per_pixel = result->median * 1000.0 / ((double) result->width * result->height);
+
+	result_print (result);
+
+	if (baseline != NULL)
+		baseline_compare (result);
+}
+
+/* Runs one configuration, the plugin is created anew each time so its state
+ * and random context start out the same */
+static int bench_run (BenchType type, const char *name, int width, int height, VisVideoDepth depth)
+{
+	VisActor *actor = NULL;
+	VisMorph *morph = NULL;
+	VisTransform *transform = NULL;
+	VisVideo *video, *src1 = NULL, *src2 = NULL;
+	VisPluginData *plugin;
+	BenchResult result;
+	VisTimer timer;
+	int *times;
+	int i;
+
+	video = video_new (width, height, depth, 0);
+
+	switch (type) {
+		case BENCH_ACTOR:
+			actor = visual_actor_new (name);
+			visual_actor_realize (actor);
+			plugin = visual_actor_get_plugin (actor);
+
+			visual_actor_set_video (actor, video);
+			visual_actor_video_negotiate (actor, 0, FALSE, FALSE);
+			break;
+
+		case BENCH_MORPH:
+			morph = visual_morph_new (name);
+			visual_morph_realize (morph);
+			plugin = visual_morph_get_plugin (morph);
+
+			visual_morph_set_mode (morph, VISUAL_MORPH_MODE_SET);
+			visual_morph_set_video (morph, video);
+
+			src1 = video_new (width, height, depth, 1);
+			src2 = video_new (width, height, depth, 2);
+			break;
+
+		case BENCH_TRANSFORM:
+			transform = visual_transform_new (name);
+			visual_transform_realize (transform);
+			plugin = visual_transform_get_plugin (transform);
+
+			visual_transform_set_video (transform, video);
+			visual_transform_set_palette (transform, palette);
+			visual_transform_video_negotiate (transform);
+			break;
+
+		default:
+			return -1;
+	}
+
+	visual_random_context_set_seed (visual_plugin_get_random_context (plugin), SEED);
+
+	times = visual_mem_new0 (int, opt_frames);
+
+	visual_timer_init (&timer);
+
+	for (i = -opt_warmup; i < opt_frames; i++) {
+		int frame = i + opt_warmup;
+
+		/* Feeding the audio isn't part of the frame time */
+		audio_feed (frame);
+
+		visual_timer_start (&timer);
+
+		switch (type) {
+			case BENCH_ACTOR:
+				visual_actor_run (actor, audio);
+				break;
+
+			case BENCH_MORPH:
+				visual_morph_set_rate (morph, (frame % 20) / 19.0);
+				visual_morph_run (morph, audio, src1, src2);
+				break;
+
+			case BENCH_TRANSFORM:
+				visual_transform_run (transform, audio);
+				break;
+		}
+
+		if (i >= 0)
+			times[i] = visual_timer_elapsed_usecs (&timer);
+	}
+
+	result.type = type;
+	result.plugin = name;
+	result.width = width;
+	result.height = height;
+	result.depth = visual_video_depth_value_from_enum (depth);
+	result.frames = opt_frames;
+
+	result_finish (&result, times);
+
+	visual_mem_free (times);
+
+	if (actor != NULL)
+		visual_object_unref (VISUAL_OBJECT (actor));
+
+	if (morph != NULL)
+		visual_object_unref (VISUAL_OBJECT (morph));
+
+	if (transform != NULL)
+		visual_object_unref (VISUAL_OBJECT (transform));
+
+	if (src1 != NULL)
+		visual_object_unref (VISUAL_OBJECT (src1));
+
+	if (src2 != NULL)
+		visual_object_unref (VISUAL_OBJECT (src2));
+
+	visual_object_unref (VISUAL_OBJECT (video));
+
+	return 0;
+}
+
+static int plugin_depths (BenchType type, const char *name)
+{
+	int depthflag = 0;
+
+	switch (type) {
+		case BENCH_ACTOR: {
+			VisActor *actor = visual_actor_new (name);
+
+			depthflag = visual_actor_get_supported_depth (actor);
+			visual_object_unref (VISUAL_OBJECT (actor));
+			break;
+		}
+
+		case BENCH_MORPH: {
+			VisMorph *morph = visual_morph_new (name);
+
+			depthflag = visual_morph_get_supported_depth (morph);
+			visual_object_unref (VISUAL_OBJECT (morph));
+			break;
+		}
+
+		case BENCH_TRANSFORM: {
+			VisTransform *transform = visual_transform_new (name);
+
+			depthflag = visual_transform_get_supported_depth (transform);
+			visual_object_unref (VISUAL_OBJECT (transform));
+			break;
+		}
+	}
+
+	/* There's no GL context here */
+	return depthflag & ~VISUAL_VIDEO_DEPTH_GL;
+}
+
+static const char *plugin_next (BenchType type, const char *name)
+{
+	switch (type) {
+		case BENCH_ACTOR:
+			return visual_actor_get_next_by_name (name);
+
+		case BENCH_MORPH:
+			return visual_morph_get_next_by_name (name);
+
+		case BENCH_TRANSFORM:
+			return visual_transform_get_next_by_name (name);
+	}
+
+	return NULL;
+}
+
+static void bench_type (BenchType type)
+{
+	const char *name = NULL;
+
+	while ((name = plugin_next (type, name)) != NULL) {
+		int depthflag;
+		int depth;
+		int i;
+
+		if (opt_plugin != NULL && strcmp (opt_plugin, name) != 0)
+			continue;
+
+		depthflag = plugin_depths (type, name);
+
+		if (opt_depths != 0)
+			depthflag &= opt_depths;
+
+		for (i = 0; i < opt_nsizes; i++) {
+			for (depth = VISUAL_VIDEO_DEPTH_8BIT; depth <= VISUAL_VIDEO_DEPTH_32BIT; depth <<= 1) {
+				if ((depthflag & depth) == 0)
+					continue;
+
+				bench_run (type, name, opt_sizes[i][0], opt_sizes[i][1], depth);
+			}
+		}
+	}
+}
+
+static int parse_sizes (const char *sizes)
+{
+	const char *p = sizes;
+
+	opt_nsizes = 0;
+
+	while (*p != '\0' && opt_nsizes < MAX_SIZES) {
+		int n = 0;
+
+		if (sscanf (p, "%dx%d%n", &opt_sizes[opt_nsizes][0], &opt_sizes[opt_nsizes][1], &n) != 2 ||
+				opt_sizes[opt_nsizes][0] <= 0 || opt_sizes[opt_nsizes][1] <= 0)
+			return -1;
+
+		opt_nsizes++;
+		p += n;
+
+		if (*p == ',')
+			p++;
+	}
+
+	return opt_nsizes > 0 ? 0 : -1;
+}
+
+static int parse_depths (const char *depths)
+{
+	char *copy = visual_strdup (depths);
+	char *bits;
+	int ret = 0;
+
+	opt_depths = 0;
+
+	for (bits = strtok (copy, ","); bits != NULL; bits = strtok (NULL, ",")) {
+		int depth = visual_video_depth_enum_from_value (atoi (bits));
+
+		if (depth == VISUAL_VIDEO_DEPTH_ERROR)
+			ret = -1;
+		else
+			opt_depths |= depth;
+	}
+
+	visual_mem_free (copy);
+
+	return opt_depths != 0 ? ret : -1;
+}
+
+static int parse_types (const char *types)
+{
+	char *copy = visual_strdup (types);
+	char *type;
+	int i;
+
+	opt_types = 0;
+
+	for (type = strtok (copy, ","); type != NULL; type = strtok (NULL, ",")) {
+		for (i = 0; i < VISUAL_TABLESIZE (type_names); i++) {
+			if (strcmp (type, type_names[i]) == 0)
+				opt_types |= 1 << i;
+		}
+	}
+
+	visual_mem_free (copy);
+
+	return opt_types != 0 ? 0 : -1;
+}
+
+static void usage (const char *name)
+{
+	fprintf (stderr,
+			"usage: %s [options]\n"
+			"\t-t <types>\tactor,morph,transform [all]\n"
+			"\t-p <plugin>\tOnly this plugin\n"
+			"\t-s <sizes>\tWxH,... [" DEFAULT_SIZES "]\n"
+			"\t-d <depths>\t8,16,24,32 [all the plugin supports]\n"
+			"\t-n <frames>\tTimed frames per run [%d]\n"
+			"\t-w <frames>\tUntimed frames before [%d]\n"
+			"\t-j\t\tJSON instead of CSV\n"
+			"\t-b <file>\tCompare the medians with a CSV report of an earlier run\n"
+			"\t-r <percent>\tA median this much over the baseline is a regression [%.0f]\n",
+			name, DEFAULT_FRAMES, DEFAULT_WARMUP, DEFAULT_THRESHOLD);
+}
+
+/* Runs every actor, morph and transform in the registry over a set of sizes and
+ * depths, with the same synthetic audio, and reports frame times. With a
+ * baseline it exits with 1 when any configuration got slower.
+ *
+ * usage: plugin_bench [-t types] [-p plugin] [-s sizes] [-d depths] [-n frames]
+ *                     [-w frames] [-j] [-b baseline.csv] [-r percent] */
+int main (int argc, char **argv)
+{
+	const char *baseline_file = NULL;
+	int opt;
+	int i;
+
+	visual_log_set_verbosity (VISUAL_LOG_WARNING);
+	visual_init (&argc, &argv);
+
+	parse_sizes (DEFAULT_SIZES);
+
+	while ((opt = getopt (argc, argv, "t:p:s:d:n:w:jb:r:")) != -1) {
+		int ret = 0;
+
+		switch (opt) {
+			case 't': ret = parse_types (optarg); break;
+			case 'p': opt_plugin = optarg; break;
+			case 's': ret = parse_sizes (optarg); break;
+			case 'd': ret = parse_depths (optarg); break;
+			case 'n': ret = (opt_frames = atoi (optarg)) > 0 ? 0 : -1; break;
+			case 'w': ret = (opt_warmup = atoi (optarg)) >= 0 ? 0 : -1; break;
+			case 'j': opt_json = TRUE; break;
+			case 'b': baseline_file = optarg; break;
+			case 'r': opt_threshold = atof (optarg); break;
+			default: ret = -1; break;
+		}
+
+		if (ret < 0) {
+			usage (argv[0]);
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (baseline_file != NULL && baseline_load (baseline_file) < 0)
+		return EXIT_FAILURE;
+
+	audio = visual_audio_new ();
+
+	palette = visual_palette_new (256);
+
+	for (i = 0; i < 256; i++) {
+		palette->colors[i].r = i;
+		palette->colors[i].g = (i * 3) & 0xff;
+		palette->colors[i].b = 255 - i;
+	}
+
+	for (i = BENCH_ACTOR; i <= BENCH_TRANSFORM; i++) {
+		if (opt_types & (1 << i))
+			bench_type (i);
+	}
+
+	if (opt_json)
+		printf ("%s]\n", results > 0 ? "\n" : "[");
+
+	if (baseline != NULL) {
+		fprintf (stderr, "%d regressions over %.0f%%\n", regressions, opt_threshold);
+
+		visual_mem_free (baseline);
+	}
+
+	visual_object_unref (VISUAL_OBJECT (palette));
+	visual_object_unref (VISUAL_OBJECT (audio));
+
+	visual_quit ();
+
+	return regressions > 0 ? 1 : EXIT_SUCCESS;
+}
@@ -5,30 +5,76 @@
 
 #define TIMES		500
 #define DEPTH		VISUAL_VIDEO_DEPTH_32BIT
-#define INTERPOL	VISUAL_VIDEO_SCALE_BILINEAR
 
+static int scale_bench (VisVideo *dest, VisVideo *src, VisVideoScaleMethod interpol, int threshold)
+{
+	VisTimer timer;
+	int i;
+
+	visual_video_set_parallel_threshold (threshold);
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < TIMES; i++)
+		visual_video_scale (dest, src, interpol);
+
+	return visual_timer_elapsed_msecs (&timer);
+}
+
+/* Scales up to a few common output sizes, on one thread and split over the
+ * VisVideo worker threads. The method is one of the VisVideoScaleMethod
+ * values, bilinear by default.
+ *
+ * usage: scale_bench [width] [height] [method] */
 int main (int argc, char **argv)
 {
 	VisVideo *dest, *src;
+	int sizes[][2] = { { 640, 400 }, { 1920, 1080 }, { 2560, 1440 }, { 0, 0 } };
+	VisVideoScaleMethod interpol = VISUAL_VIDEO_SCALE_BILINEAR;
+	int threshold;
+	int serial, parallel;
 	int i;
 
 	visual_init (&argc, &argv);
 
-	dest = visual_video_new ();
-	visual_video_set_depth (dest, DEPTH);
-	visual_video_set_dimension (dest, 640, 400);
-	visual_video_allocate_buffer (dest);
+	if (argc > 2) {
+		sizes[0][0] = atoi (argv[1]);
+		sizes[0][1] = atoi (argv[2]);
+		sizes[1][0] = 0;
+	}
+
+	if (argc > 3)
+		interpol = atoi (argv[3]);
+
+	threshold = visual_video_get_parallel_threshold ();
 
 	src = visual_video_new ();
 	visual_video_set_depth (src, DEPTH);
 	visual_video_set_dimension (src, 320, 200);
 	visual_video_allocate_buffer (src);
 
-	for (i = 0; i < TIMES; i++)
-		visual_video_scale (dest, src, INTERPOL);
+	printf ("Scale bench overlay %d times, depth %d, interpol %d, parallel threshold %d\n", TIMES,
+			DEPTH, interpol, threshold);
+
+	for (i = 0; sizes[i][0] > 0; i++) {
+		dest = visual_video_new ();
+		visual_video_set_depth (dest, DEPTH);
+		visual_video_set_dimension (dest, sizes[i][0], sizes[i][1]);
+		visual_video_allocate_buffer (dest);
+
+		serial = scale_bench (dest, src, interpol, -1);
+		parallel = scale_bench (dest, src, interpol, threshold);
+
+		printf ("%dx%d: serial %d ms, parallel %d ms, speedup %.2f\n", sizes[i][0], sizes[i][1],
+				serial, parallel, parallel > 0 ? (double) serial / parallel : 0.0);
+
+		visual_object_unref (VISUAL_OBJECT (dest));
+	}
+
+	visual_object_unref (VISUAL_OBJECT (src));
 
-	printf ("Scale bench overlay %d times, depth %d, interpol %d\n", TIMES,
-			DEPTH, INTERPOL);
+	visual_quit ();
 
 	return EXIT_SUCCESS;
 }
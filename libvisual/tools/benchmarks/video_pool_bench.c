@@ -0,0 +1,87 @@
+#include <libvisual/libvisual.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TIMES		2000
+#define DEPTH		VISUAL_VIDEO_DEPTH_32BIT
+
+/* Reallocates a few intermediate VisVideos the way a bin does on every sync,
+ * while the output window is being dragged between two sizes. */
+static int pool_bench (int width, int height)
+{
+	VisVideo *videos[4];
+	VisTimer timer;
+	int i, j;
+
+	for (j = 0; j < 4; j++)
+		videos[j] = visual_video_new ();
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < TIMES; i++) {
+		for (j = 0; j < 4; j++) {
+			visual_video_set_depth (videos[j], DEPTH);
+			visual_video_set_dimension (videos[j], width + (i & 1) * 8, height);
+			visual_video_allocate_buffer (videos[j]);
+		}
+	}
+
+	for (j = 0; j < 4; j++)
+		visual_object_unref (VISUAL_OBJECT (videos[j]));
+
+	return visual_timer_elapsed_msecs (&timer);
+}
+
+static void print_stats (const char *name, int msecs)
+{
+	VisVideoPoolStats stats;
+
+	visual_video_pool_get_stats (visual_video_pool_get_default (), &stats);
+
+	printf ("%s: %d ms, %lu hits, %lu misses, %lu evictions, %lu bytes idle\n", name, msecs,
+			(unsigned long) stats.hits, (unsigned long) stats.misses,
+			(unsigned long) stats.evictions, (unsigned long) stats.idle_bytes);
+}
+
+/* Compares VisVideo reallocation with and without keeping the released buffers
+ * in the default VisVideoPool.
+ *
+ * usage: video_pool_bench [width] [height] [hugepages] */
+int main (int argc, char **argv)
+{
+	VisVideoPool *pool;
+	int width = 1920;
+	int height = 1080;
+	int msecs;
+
+	visual_init (&argc, &argv);
+
+	if (argc > 2) {
+		width = atoi (argv[1]);
+		height = atoi (argv[2]);
+	}
+
+	pool = visual_video_pool_get_default ();
+
+	if (argc > 3)
+		visual_video_pool_set_hugepages (pool, atoi (argv[3]));
+
+	printf ("Video pool bench %d reallocations of 4 videos, %dx%d depth %d\n", TIMES, width, height,
+			visual_video_depth_value_from_enum (DEPTH));
+
+	visual_video_pool_set_idle_limit (pool, 0);
+	visual_video_pool_reset_stats (pool);
+	msecs = pool_bench (width, height);
+	print_stats ("without reuse", msecs);
+
+	visual_video_pool_set_idle_limit (pool, VISUAL_VIDEO_POOL_IDLE_LIMIT);
+	visual_video_pool_reset_stats (pool);
+	msecs = pool_bench (width, height);
+	print_stats ("with reuse", msecs);
+
+	visual_quit ();
+
+	return EXIT_SUCCESS;
+}
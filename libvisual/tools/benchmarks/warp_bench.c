@@ -0,0 +1,126 @@
+#include <libvisual/libvisual.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define TIMES		200
+
+/* A slow zoom with a swirl, as the feedback actors use */
+static int swirl (void *priv, int x, int y, float *sx, float *sy)
+{
+	VisWarpField *field = priv;
+	float cx = field->width / 2.0f;
+	float cy = field->height / 2.0f;
+	float dx = x - cx;
+	float dy = y - cy;
+	float angle = 0.02f * cosf (sqrtf (dx * dx + dy * dy) / 40.0f);
+
+	*sx = cx + 0.97f * (dx * cosf (angle) - dy * sinf (angle));
+	*sy = cy + 0.97f * (dx * sinf (angle) + dy * cosf (angle));
+
+	return TRUE;
+}
+
+/* The same remap without a table, every pixel its own interpolation, like the
+ * actors do now */
+static void remap_plain (VisWarpField *field, uint8_t *dest, const uint8_t *src, int pitch, int bpp)
+{
+	int x, y, c;
+
+	for (y = 0; y < field->height; y++) {
+		for (x = 0; x < field->width; x++) {
+			const VisWarpFieldEntry *e = &field->entries[y * field->width + x];
+			const uint8_t *p = src + e->y * pitch + e->x * bpp;
+			uint32_t w = e->weights;
+
+			for (c = 0; c < bpp; c++) {
+				dest[y * pitch + x * bpp + c] = (p[c] * (w & 0xff) + p[bpp + c] * ((w >> 8) & 0xff) +
+						p[pitch + c] * ((w >> 16) & 0xff) + p[pitch + bpp + c] * (w >> 24)) >> 8;
+			}
+		}
+	}
+}
+
+static int warp_bench (VisWarpField *field, VisVideo *dest, VisVideo *src, int threshold, int plain)
+{
+	VisTimer timer;
+	int i;
+
+	visual_video_set_parallel_threshold (threshold);
+
+	visual_timer_init (&timer);
+	visual_timer_start (&timer);
+
+	for (i = 0; i < TIMES; i++) {
+		if (plain != FALSE)
+			remap_plain (field, visual_video_get_pixels (dest), visual_video_get_pixels (src), src->pitch, src->bpp);
+		else
+			visual_warp_field_apply (field, dest, src);
+	}
+
+	return visual_timer_elapsed_msecs (&timer);
+}
+
+/* Applies a warp field to 8 and 32 bits VisVideos of a few common sizes,
+ * with a plain C loop, and with visual_warp_field_apply() on one thread and
+ * split over the worker threads. Also times building the field.
+ *
+ * usage: warp_bench [width] [height] */
+int main (int argc, char **argv)
+{
+	VisWarpField *field;
+	VisVideo *dest, *src;
+	VisVideoDepth depths[] = { VISUAL_VIDEO_DEPTH_8BIT, VISUAL_VIDEO_DEPTH_32BIT };
+	int sizes[][2] = { { 640, 400 }, { 1280, 720 }, { 1920, 1080 }, { 0, 0 } };
+	VisTimer timer;
+	int threshold;
+	int plain, serial, parallel, build;
+	int i, j;
+
+	visual_init (&argc, &argv);
+
+	if (argc > 2) {
+		sizes[0][0] = atoi (argv[1]);
+		sizes[0][1] = atoi (argv[2]);
+		sizes[1][0] = 0;
+	}
+
+	threshold = visual_video_get_parallel_threshold ();
+
+	printf ("Warp bench %d times, parallel threshold %d\n", TIMES, threshold);
+
+	for (i = 0; sizes[i][0] > 0; i++) {
+		field = visual_warp_field_new (sizes[i][0], sizes[i][1]);
+
+		visual_timer_init (&timer);
+		visual_timer_start (&timer);
+
+		visual_warp_field_build (field, swirl, field, 250);
+
+		build = visual_timer_elapsed_usecs (&timer);
+
+		for (j = 0; j < 2; j++) {
+			dest = visual_video_new_with_buffer (sizes[i][0], sizes[i][1], depths[j]);
+			src = visual_video_new_with_buffer (sizes[i][0], sizes[i][1], depths[j]);
+
+			plain = warp_bench (field, dest, src, -1, TRUE);
+			serial = warp_bench (field, dest, src, -1, FALSE);
+			parallel = warp_bench (field, dest, src, threshold, FALSE);
+
+			printf ("%dx%d %2d bits: plain %d ms, serial %d ms, parallel %d ms, build %d us\n",
+					sizes[i][0], sizes[i][1], visual_video_depth_value_from_enum (depths[j]), plain, serial, parallel, build);
+
+			visual_object_unref (VISUAL_OBJECT (dest));
+			visual_object_unref (VISUAL_OBJECT (src));
+		}
+
+		visual_object_unref (VISUAL_OBJECT (field));
+	}
+
+	visual_video_set_parallel_threshold (threshold);
+
+	visual_quit ();
+
+	return EXIT_SUCCESS;
+}
@@ -100,6 +100,14 @@ int display_drain_events (SADisplay *display, VisEventQueue *eventqueue)
 	return display->driver->drainevents (display, eventqueue);
 }
 
+int display_set_fps (SADisplay *display, int fps)
+{
+	/* Drivers writing a stream put this in its header */
+	display->fps = fps;
+
+	return 0;
+}
+
 int display_fps_limit (SADisplay *display, int fps)
 {
 	return 0;
@@ -64,6 +64,8 @@ struct _SADisplay {
 
 	int		 frames_drawn;
 	VisTimer	 timer;
+
+	int		 fps;
 };
 
 
@@ -93,6 +95,8 @@ int display_set_fullscreen (SADisplay *display, int fullscreen, int autoscale);
 
 int display_drain_events (SADisplay *display, VisEventQueue *eventqueue);
 
+int display_set_fps (SADisplay *display, int fps);
+
 int display_fps_limit (SADisplay *display, int fps);
 int display_fps_total (SADisplay *display);
 float display_fps_average (SADisplay *display);
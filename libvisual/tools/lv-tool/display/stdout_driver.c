@@ -25,6 +25,9 @@
 #include "display.h"
 
 #include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
 
 /* MinGW unistd.h doesn't have *_FILENO or SEEK_* defined */
 #ifdef VISUAL_WITH_MINGW
@@ -34,6 +37,16 @@
 
 #define STDOUT_NATIVE(obj)  (VISUAL_CHECK_CAST ((obj), StdoutNative))
 
+/** number of rendered frames that can wait for the writer thread */
+#define STDOUT_SLOTS    3
+
+/** output stream formats */
+typedef enum
+{
+    STDOUT_FORMAT_RAW,      /**< packed 24 bit pixels */
+    STDOUT_FORMAT_Y4M       /**< YUV4MPEG2 stream, 4:4:4 planes */
+} StdoutFormat;
+
 /** our main driver object */
 typedef struct _StdoutNative StdoutNative;
 
@@ -44,38 +57,247 @@ struct _StdoutNative
     int             width,height;
     VisVideoDepth   depth;
 	void *          area;
+
+    StdoutFormat    format;
+    int             header_written;
+
+    /* frames are handed to the writer thread through a small ring */
+    uint8_t *       slots[STDOUT_SLOTS];
+    uint8_t *       out;
+    int             head, count;
+    int             quit;
+    VisMutex *      lock;
+    VisCond *       cond;
+    VisThread *     writer;
 };
 
+/** write all of buf, retrying short and interrupted writes */
+static int write_all(const void *buf, size_t size)
+{
+    const uint8_t *p = buf;
+
+    while(size > 0)
+    {
+        ssize_t done = write(STDOUT_FILENO, p, size);
+
+        if(done < 0 && errno == EINTR)
+            continue;
+
+        if(done <= 0)
+            return -1;
+
+        p += done;
+        size -= done;
+    }
+
+    return 0;
+}
+
+/** size of one frame of 24 bit pixels */
+static int frame_size(StdoutNative *native)
+{
+    return native->width * native->height *
+        (visual_video_depth_value_from_enum(VISUAL_VIDEO_DEPTH_24BIT) / 8);
+}
+
+/** convert a 24 bit frame to 4:4:4 BT.601 planes */
+static void frame_to_yuv(StdoutNative *native, uint8_t *dest, const uint8_t *src)
+{
+    int size = native->width * native->height;
+    uint8_t *y = dest;
+    uint8_t *u = dest + size;
+    uint8_t *v = dest + size * 2;
+    int i;
+
+    for(i = 0; i < size; i++)
+    {
+#ifdef VISUAL_LITTLE_ENDIAN
+        int r = src[2], g = src[1], b = src[0];
+#else
+        int r = src[0], g = src[1], b = src[2];
+#endif
+        y[i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+        u[i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+        v[i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+
+        src += 3;
+    }
+}
+
+/** write one frame in the output format */
+static int write_frame(SADisplay *display, StdoutNative *native, const uint8_t *frame)
+{
+    if(native->format == STDOUT_FORMAT_RAW)
+        return write_all(frame, frame_size(native));
+
+    if(!native->header_written)
+    {
+        char header[128];
+
+        snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+                 native->width, native->height, display->fps > 0 ? display->fps : 30);
+
+        if(write_all(header, strlen(header)) < 0)
+            return -1;
+
+        native->header_written = TRUE;
+    }
+
+    frame_to_yuv(native, native->out + 6, frame);
+
+    return write_all(native->out, 6 + frame_size(native));
+}
+
+/** writes the queued frames, so rendering and writing overlap */
+static void *writer_thread(void *data)
+{
+    SADisplay *display = data;
+    StdoutNative *native = STDOUT_NATIVE(display->native);
+
+    visual_mutex_lock(native->lock);
+
+    for(;;)
+    {
+        uint8_t *frame;
+
+        while(native->count == 0 && !native->quit)
+            visual_cond_wait(native->cond, native->lock);
+
+        /* only stop once everything queued is out */
+        if(native->count == 0)
+            break;
+
+        frame = native->slots[native->head];
+
+        visual_mutex_unlock(native->lock);
+        write_frame(display, native, frame);
+        visual_mutex_lock(native->lock);
+
+        native->head = (native->head + 1) % STDOUT_SLOTS;
+        native->count--;
+
+        visual_cond_broadcast(native->cond);
+    }
+
+    visual_mutex_unlock(native->lock);
+
+    return NULL;
+}
+
+/** stop the writer thread after it wrote the queued frames */
+static void writer_stop(StdoutNative *native)
+{
+    if(!native->writer)
+        return;
+
+    visual_mutex_lock(native->lock);
+    native->quit = TRUE;
+    visual_cond_broadcast(native->cond);
+    visual_mutex_unlock(native->lock);
+
+    visual_thread_join(native->writer);
+    visual_thread_free(native->writer);
+
+    native->writer = NULL;
+    native->quit = FALSE;
+}
+
+/** free the frame buffers */
+static void frames_free(StdoutNative *native)
+{
+    int i;
+
+    for(i = 0; i < STDOUT_SLOTS; i++)
+    {
+        if(native->slots[i] != NULL)
+            visual_mem_free(native->slots[i]);
+
+        native->slots[i] = NULL;
+    }
+
+    if(native->out != NULL)
+        visual_mem_free(native->out);
+    native->out = NULL;
+
+    if(native->area != NULL)
+        visual_mem_free(native->area);
+    native->area = NULL;
+}
+
 /** create display */
 static int native_create(SADisplay *display,
+                         StdoutFormat format,
                          VisVideoDepth depth,
                          VisVideoAttributeOptions *vidoptions,
                          int width, int height, int resizable)
 {
 	StdoutNative *native;
+    int i;
 
     /* allocate new private descriptor */
 	if(!(native = STDOUT_NATIVE (display->native)))
     {
 		native = visual_mem_new0(StdoutNative, 1);
 		visual_object_initialize(VISUAL_OBJECT (native), TRUE, NULL);
-	}
 
-    /* create buffer */
-    if(native->area != NULL)
-        visual_mem_free(native->area);
-    native->area = visual_mem_malloc0(width * height * (visual_video_depth_value_from_enum(VISUAL_VIDEO_DEPTH_24BIT) / 8));
+        native->format = format;
+
+        if(visual_thread_is_supported() && visual_thread_is_enabled())
+        {
+            native->lock = visual_mutex_new();
+            native->cond = visual_cond_new();
+        }
+    }
+
+    /* frames that are still queued have the old dimensions */
+    writer_stop(native);
+
+    if(native->header_written && (width != native->width || height != native->height))
+        visual_log(VISUAL_LOG_WARNING, "A YUV4MPEG2 stream can't change its dimensions");
+
+    /* create buffers */
+    frames_free(native);
 
-    /* save dimensions */
     native->width = width;
     native->height = height;
     native->depth = depth;
 
+    native->area = visual_mem_malloc0(frame_size(native));
+
+    if(format == STDOUT_FORMAT_Y4M)
+    {
+        native->out = visual_mem_malloc(6 + frame_size(native));
+        memcpy(native->out, "FRAME\n", 6);
+    }
+
 	display->native = VISUAL_OBJECT(native);
 
+    /* without threads frames are written as they come in */
+    if(native->lock && native->cond)
+    {
+        for(i = 0; i < STDOUT_SLOTS; i++)
+            native->slots[i] = visual_mem_malloc(frame_size(native));
+
+        native->head = 0;
+        native->count = 0;
+        native->writer = visual_thread_create(writer_thread, display, TRUE);
+    }
+
 	return 0;
 }
 
+static int native_create_raw(SADisplay *display, VisVideoDepth depth, VisVideoAttributeOptions *vidoptions,
+                             int width, int height, int resizable)
+{
+    return native_create(display, STDOUT_FORMAT_RAW, depth, vidoptions, width, height, resizable);
+}
+
+static int native_create_y4m(SADisplay *display, VisVideoDepth depth, VisVideoAttributeOptions *vidoptions,
+                             int width, int height, int resizable)
+{
+    return native_create(display, STDOUT_FORMAT_Y4M, depth, vidoptions, width, height, resizable);
+}
+
 /** close display */
 static int native_close (SADisplay *display)
 {
@@ -84,8 +306,15 @@ static int native_close (SADisplay *display)
 	if(!native)
 		return 0;
 
-	visual_mem_free (native->area);
-	visual_object_unref (VISUAL_OBJECT(native));
+    writer_stop(native);
+    frames_free(native);
+
+    if(native->lock)
+        visual_mutex_free(native->lock);
+    if(native->cond)
+        visual_cond_free(native->cond);
+
+    visual_object_unref (VISUAL_OBJECT(native));
 	display->native = NULL;
 
 	return 0;
@@ -125,13 +354,29 @@ static int native_getvideo (SADisplay *display, VisVideo *screen)
 static int native_updaterect(SADisplay *display, VisRectangle *rect)
 {
 	StdoutNative *native = STDOUT_NATIVE(display->native);
+    uint8_t *slot;
+
+    if(!native->writer)
+        return write_frame(display, native, native->area);
+
+    /* wait for a free slot, this is where a slow consumer holds up rendering */
+    visual_mutex_lock(native->lock);
+
+    while(native->count == STDOUT_SLOTS)
+        visual_cond_wait(native->cond, native->lock);
+
+    slot = native->slots[(native->head + native->count) % STDOUT_SLOTS];
+
+    visual_mutex_unlock(native->lock);
+
+    /* the writer doesn't touch slots past the queued ones */
+    memcpy(slot, native->area, frame_size(native));
+
+    visual_mutex_lock(native->lock);
+    native->count++;
+    visual_cond_broadcast(native->cond);
+    visual_mutex_unlock(native->lock);
 
-    /* write data */
-	write(STDOUT_FILENO,
-          native->area,
-          native->width *
-            native->height *
-            (visual_video_depth_value_from_enum(VISUAL_VIDEO_DEPTH_24BIT) / 8));
 	return 0;
 }
 
@@ -143,8 +388,8 @@ static int native_drainevents (SADisplay *display, VisEventQueue *eventqueue)
 
 
 
-/** creator */
-SADisplayDriver *stdout_driver_new ()
+/** create a driver with the methods shared by the output formats */
+static SADisplayDriver *driver_new(SADisplayDriverCreateFunc create)
 {
 	SADisplayDriver *driver;
 
@@ -155,7 +400,7 @@ SADisplayDriver *stdout_driver_new ()
 	visual_object_initialize (VISUAL_OBJECT (driver), TRUE, NULL);
 
         /* register methods */
-	driver->create = native_create;
+	driver->create = create;
 	driver->close = native_close;
 	driver->lock = native_lock;
 	driver->unlock = native_unlock;
@@ -167,5 +412,17 @@ SADisplayDriver *stdout_driver_new ()
 	return driver;
 }
 
+/** creator */
+SADisplayDriver *stdout_driver_new ()
+{
+	return driver_new (native_create_raw);
+}
+
+/** creator of the YUV4MPEG2 variant */
+SADisplayDriver *y4m_driver_new ()
+{
+	return driver_new (native_create_y4m);
+}
+
 
 
@@ -29,6 +29,7 @@
 
 
 SADisplayDriver *       stdout_driver_new(void);
+SADisplayDriver *       y4m_driver_new(void);
 
 
 
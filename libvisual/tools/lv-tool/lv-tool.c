@@ -36,6 +36,8 @@
 #define DEFAULT_WIDTH   320
 #define DEFAULT_HEIGHT  200
 #define DEFAULT_FPS     30
+#define OFFLINE_INPUT   "file"
+#define OFFLINE_DRIVER  "stdout"
 
 
 /* local variables */
@@ -47,7 +49,14 @@ static int  height;
 static int  framerate;
 static int  driver;
 static int  have_seed;
+static int  threaded;
 static uint32_t seed;
+static char offline_file[1024];
+static char raw_format[16];
+static int  raw_rate;
+static int  raw_channels;
+static char trace_file[1024];
+static VisTiming *timing;
 
 /* list of available driver-creators - register new drivers here */
 typedef struct
@@ -65,6 +74,7 @@ SADisplayDriverDescription all_display_drivers[] =
         { .name = "glx",      .creator = &glx_driver_new      },
 #endif
         { .name = "stdout",   .creator = &stdout_driver_new   },
+        { .name = "y4m",      .creator = &y4m_driver_new      },
 };
 
 
@@ -117,6 +127,23 @@ static void _print_plugin_help()
     /* print morphs */
 }
 
+/** find a display driver by name, -1 if there is none */
+static int _find_driver(const char *name)
+{
+    int n;
+
+    for(n = 0;
+        n < sizeof(all_display_drivers)/sizeof(SADisplayDriverDescription);
+        n++)
+    {
+        /* is this our driver? */
+        if(strcmp(name, all_display_drivers[n].name) == 0)
+            return n;
+    }
+
+    return -1;
+}
+
 /** print commandline help */
 static void _print_help(char *name)
 {
@@ -131,6 +158,10 @@ static void _print_help(char *name)
            "\t--actor <actor>\t\t-a <actor>\tUse this actor plugin [%s]\n"
            "\t--morph <morph>\t\t-m <morph>\tUse this morph plugin [%s]\n"
 		   "\t--seed <seed>\t\t-s <seed>\tSet random seed\n"
+           "\t--threaded\t\t-t\t\tCapture and render on their own threads\n"
+           "\t--offline <file>\t-O <file>\tRender a WAV or raw PCM file as fast as possible, to the %s driver unless told otherwise\n"
+           "\t--raw <fmt:rate:ch>\t-r <fmt:rate:ch>\tThe offline file is raw s16 or f32 PCM (e.g. s16:44100:2)\n"
+           "\t--trace <file>\t\t-T <file>\tTime the stages of every frame, print them and write a Chrome trace on exit\n"
            "\t--fps <n>\t\t-f <n>\t\tLimit output to n frames per second (if display driver supports it) [%d]\n\n",
            "http://github.com/StarVisuals/libvisual",
            name,
@@ -139,6 +170,7 @@ static void _print_help(char *name)
            input_name,
            actor_name,
            morph_name,
+           OFFLINE_DRIVER,
            framerate);
 }
 
@@ -159,10 +191,14 @@ static int _parse_args(int argc, char *argv[])
         {"morph",       required_argument, 0, 'm'},
         {"fps",         required_argument, 0, 'f'},
         {"seed",        required_argument, 0, 's'},
+        {"threaded",    no_argument,       0, 't'},
+        {"offline",     required_argument, 0, 'O'},
+        {"raw",         required_argument, 0, 'r'},
+        {"trace",       required_argument, 0, 'T'},
         {0,             0,                 0,  0 }
     };
 
-    while((argument = getopt_long(argc, argv, "hpD:d:i:a:m:f:s:", loptions, &index)) >= 0)
+    while((argument = getopt_long(argc, argv, "hpD:d:i:a:m:f:s:tO:r:T:", loptions, &index)) >= 0)
     {
 
         switch(argument)
@@ -196,25 +232,9 @@ static int _parse_args(int argc, char *argv[])
             /* --driver */
             case 'd':
             {
-                int n;
-                for(n = 0;
-                    n < sizeof(all_display_drivers)/sizeof(SADisplayDriverDescription);
-                    n++)
-                {
-                    /* is this our driver? */
-                    if(strcmp(optarg, all_display_drivers[n].name) == 0)
-                    {
-                        /* stop search */
-                        break;
-                    }
-                }
-
                 /* found something? */
-                if(n < sizeof(all_display_drivers)/sizeof(SADisplayDriverDescription))
-                {
-                    driver = n;
+                if((driver = _find_driver(optarg)) >= 0)
                     break;
-                }
 
                 fprintf(stderr, "Unsupported display driver: %s\n", optarg);
                 return EXIT_FAILURE;
@@ -260,6 +280,45 @@ static int _parse_args(int argc, char *argv[])
 				 break;
             }
 
+            /* --threaded */
+            case 't':
+            {
+                threaded = 1;
+                break;
+            }
+
+            /* --offline */
+            case 'O':
+            {
+                /* save filename for later */
+                strncpy(offline_file, optarg, sizeof(offline_file)-1);
+                break;
+            }
+
+            /* --raw */
+            case 'r':
+            {
+                raw_rate = 44100;
+                raw_channels = 2;
+
+                if(sscanf(optarg, "%15[^:]:%d:%d", raw_format, &raw_rate, &raw_channels) < 1 ||
+                   (strcmp(raw_format, "s16") != 0 && strcmp(raw_format, "f32") != 0))
+                {
+                    fprintf(stderr,
+                            "Invalid raw format: \"%s\". Use <s16|f32>[:rate[:channels]] (e.g. s16:44100:2)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+
+            /* --trace */
+            case 'T':
+            {
+                /* save filename for later */
+                strncpy(trace_file, optarg, sizeof(trace_file)-1);
+                break;
+            }
+
             /* invalid argument */
             case '?':
             {
@@ -305,6 +364,130 @@ static void v_cycleMorph ()
     memcpy(morph_name, name, strlen(name));
 }
 
+/** print where the time of the recent frames went and write the trace */
+static void _report_timing(void)
+{
+    VisTimingHistogram histogram;
+    int stage;
+
+    fprintf(stderr, "Frame timing over the last %d events:\n", timing->size);
+
+    for(stage = 0; stage < VISUAL_TIMING_STAGE_LAST; stage++)
+    {
+        visual_timing_get_histogram(timing, stage, &histogram);
+
+        if(histogram.count == 0)
+            continue;
+
+        fprintf(stderr, "\t%-10s %6d x  p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n",
+                visual_timing_stage_name(stage), histogram.count,
+                histogram.p50 / 1e6, histogram.p99 / 1e6, histogram.max / 1e6);
+    }
+
+    if(visual_timing_dump_trace(timing, trace_file) == VISUAL_OK)
+        fprintf(stderr, "Wrote trace to \"%s\"\n", trace_file);
+}
+
+/** render the offline file as fast as the plugins go and report where the time went */
+static int _render_offline(VisBin *bin, SADisplay *display)
+{
+    VisPluginData *plugin = visual_input_get_plugin(bin->input);
+    VisParamContainer *params = visual_plugin_get_params(plugin);
+    VisParamEntry *upload = visual_param_container_get(params, "upload samples");
+    VisParamEntry *eof = visual_param_container_get(params, "end of file");
+    VisTimer timer, stage;
+    VisTime elapsed;
+    double input_usecs = 0, render_usecs = 0, output_usecs = 0, secs;
+    uint64_t frame = 0, rate, begin;
+
+    if(!upload || !eof)
+    {
+        fprintf(stderr, "Input \"%s\" can't read files\n", input_name);
+        display_close(display);
+        return -1;
+    }
+
+    if(raw_format[0])
+    {
+        visual_param_entry_set_string(visual_param_container_get(params, "format"), raw_format);
+        visual_param_entry_set_integer(visual_param_container_get(params, "rate"), raw_rate);
+        visual_param_entry_set_integer(visual_param_container_get(params, "channels"), raw_channels);
+    }
+
+    /* opens the file, after which the rate is the one of the file */
+    visual_param_entry_set_string(visual_param_container_get(params, "filename"), offline_file);
+    visual_plugin_events_pump(plugin);
+
+    rate = visual_param_entry_get_integer(visual_param_container_get(params, "rate"));
+
+    visual_timer_init(&timer);
+    visual_timer_init(&stage);
+    visual_timer_start(&timer);
+
+    /* visual_bin_run isn't used, so time the stages of the actor directly */
+    if(timing)
+        visual_actor_set_timing(bin->actor, timing, VISUAL_TIMING_TRACK_ACTOR);
+
+    /* nothing switches or morphs here, so the stages run one by one to be timed apart */
+    while(!visual_param_entry_get_integer(eof))
+    {
+        /* spread the samples so that audio and video stay in step over any length */
+        visual_param_entry_set_integer(upload, (frame + 1) * rate / framerate - frame * rate / framerate);
+        visual_plugin_events_pump(plugin);
+
+        if(timing)
+            visual_timing_next_frame(timing);
+
+        begin = visual_timing_now();
+        visual_timer_start(&stage);
+        visual_input_run(bin->input);
+        input_usecs += visual_timer_elapsed_usecs(&stage);
+
+        if(timing)
+            visual_timing_record(timing, VISUAL_TIMING_STAGE_INPUT, VISUAL_TIMING_TRACK_INPUT,
+                                 begin, visual_timing_now());
+
+        visual_timer_start(&stage);
+        display_lock(display);
+        visual_actor_run(bin->actor, bin->input->audio);
+        display_unlock(display);
+        render_usecs += visual_timer_elapsed_usecs(&stage);
+
+        visual_timer_start(&stage);
+        display_update_all(display);
+        output_usecs += visual_timer_elapsed_usecs(&stage);
+
+        frame++;
+    }
+
+    /* wait for the queued frames to be written */
+    visual_timer_start(&stage);
+    display_close(display);
+    output_usecs += visual_timer_elapsed_usecs(&stage);
+
+    visual_time_init(&elapsed);
+    visual_timer_elapsed(&timer, &elapsed);
+    secs = elapsed.sec + elapsed.usec / (double) VISUAL_USEC_PER_SEC;
+
+    if(frame == 0)
+    {
+        fprintf(stderr, "Nothing rendered from \"%s\"\n", offline_file);
+        return -1;
+    }
+
+    fprintf(stderr,
+            "Rendered %lu frames in %.2f s, %.1f fps, %.1fx real time\n"
+            "\tinput\t%.3f ms/frame\n"
+            "\trender\t%.3f ms/frame\n"
+            "\toutput\t%.3f ms/frame\n",
+            (unsigned long) frame, secs, frame / secs, frame / (double) framerate / secs,
+            input_usecs / frame / 1000,
+            render_usecs / frame / 1000,
+            output_usecs / frame / 1000);
+
+    return 0;
+}
+
 /******************************************************************************
  ******************************************************************************
  ******************************************************************************/
@@ -316,7 +499,7 @@ int main (int argc, char **argv)
         /* set defaults */
         width = DEFAULT_WIDTH;
         height = DEFAULT_HEIGHT;
-        driver = 0;
+        driver = -1;
         strncpy(actor_name, DEFAULT_ACTOR, sizeof(actor_name)-1);
         strncpy(input_name, DEFAULT_INPUT, sizeof(input_name)-1);
         strncpy(morph_name, DEFAULT_MORPH, sizeof(morph_name)-1);
@@ -336,12 +519,37 @@ int main (int argc, char **argv)
         if(_parse_args(argc, argv) != EXIT_SUCCESS)
                 goto _m_exit;
 
+        /* offline rendering reads the file through the file input, on this thread */
+        if(offline_file[0])
+        {
+                strncpy(input_name, OFFLINE_INPUT, sizeof(input_name)-1);
+                threaded = 0;
+        }
+
+        if(driver < 0)
+                driver = offline_file[0] ? _find_driver(OFFLINE_DRIVER) : 0;
+
         /* create new VisBin for video output */
         VisBin *bin;
         bin = visual_bin_new();
         visual_bin_set_supported_depth(bin, VISUAL_VIDEO_DEPTH_ALL);
         visual_bin_switch_set_style(bin, VISUAL_SWITCH_STYLE_MORPH);
 
+        if(threaded && visual_bin_set_threaded(bin, TRUE) != VISUAL_OK)
+                fprintf(stderr, "Threads not available, rendering serially\n");
+
+        if(trace_file[0])
+        {
+                timing = visual_timing_new(VISUAL_TIMING_DEFAULT_SIZE);
+
+                if(visual_bin_set_timing(bin, timing) != VISUAL_OK)
+                {
+                        fprintf(stderr, "Frame timing not available in this libvisual\n");
+                        visual_object_unref(VISUAL_OBJECT(timing));
+                        timing = NULL;
+                }
+        }
+
         /* initialize actor plugin */
         fprintf(stderr, "Loading actor \"%s\"...\n", actor_name);
         VisActor *actor;
@@ -406,6 +614,7 @@ int main (int argc, char **argv)
         }
 
         /* create display */
+        display_set_fps(display, framerate);
         display_create(display, depth, vidoptions, width, height, TRUE);
         VisVideo *video;
         if(!(video = display_get_video(display)))
@@ -421,6 +630,12 @@ int main (int argc, char **argv)
         visual_bin_sync(bin, FALSE);
         visual_bin_depth_changed(bin);
 
+        if(offline_file[0])
+        {
+                _render_offline(bin, display);
+                goto _m_exit;
+        }
+
         /* get a queue to handle events */
         VisEventQueue *localqueue;
         localqueue = visual_event_queue_new ();
@@ -433,10 +648,15 @@ int main (int argc, char **argv)
         {
                 VisEventQueue *pluginqueue;
                 VisEvent *ev;
+                int locked;
 
                 /* Handle all events */
                 display_drain_events(display, localqueue);
 
+                /* keep the render thread away from the actor while we poke it */
+                if((locked = localqueue->eventcount > 0))
+                        visual_bin_lock(bin);
+
                 pluginqueue = visual_plugin_get_eventqueue(visual_actor_get_plugin (bin->actor));
                 while(visual_event_queue_poll_by_reference(localqueue, &ev))
                 {
@@ -553,6 +773,9 @@ int main (int argc, char **argv)
                         }
                 }
 
+                if(locked)
+                        visual_bin_unlock(bin);
+
                 if(visual_bin_depth_changed(bin))
                 {
                     display_lock(display);
@@ -582,6 +805,9 @@ _m_exit_display:
                 display_close(display);
 
 _m_exit:
+                if(timing)
+                        _report_timing();
+
                 /* cleanup resources allocated by visual_init() */
                 visual_quit ();
 